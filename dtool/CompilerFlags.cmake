@@ -213,10 +213,14 @@ else()
 
 endif()
 
+# These options only apply to C++, and would make the compiler warn about the
+# C sources of the libraries that are compiled in, such as zstd.
+set(is_cxx "$<COMPILE_LANGUAGE:CXX>")
+
 set(cxx_exceptions_property "$<BOOL:$<TARGET_PROPERTY:CXX_EXCEPTIONS>>")
 add_compile_options(
-  "$<${cxx_exceptions_property}:${cxx_exceptions_on}>"
-  "$<$<NOT:${cxx_exceptions_property}>:${cxx_exceptions_off}>")
+  "$<$<AND:${is_cxx},${cxx_exceptions_property}>:${cxx_exceptions_on}>"
+  "$<$<AND:${is_cxx},$<NOT:${cxx_exceptions_property}>>:${cxx_exceptions_off}>")
 
 set(cxx_rtti_property "$<BOOL:$<TARGET_PROPERTY:CXX_RTTI>>")
 if(NOT ANDROID)
@@ -226,8 +230,8 @@ if(NOT ANDROID)
   set(cxx_rtti_property "$<OR:$<CONFIG:Debug>,${cxx_rtti_property}>")
 endif()
 add_compile_options(
-  "$<${cxx_rtti_property}:${cxx_rtti_on}>"
-  "$<$<NOT:${cxx_rtti_property}>:${cxx_rtti_off}>")
+  "$<$<AND:${is_cxx},${cxx_rtti_property}>:${cxx_rtti_on}>"
+  "$<$<AND:${is_cxx},$<NOT:${cxx_rtti_property}>>:${cxx_rtti_off}>")
 set_property(DIRECTORY "${PROJECT_SOURCE_DIR}" APPEND PROPERTY
   COMPILE_DEFINITIONS "$<${cxx_rtti_property}:HAVE_RTTI>")
 
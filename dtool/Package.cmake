@@ -72,6 +72,7 @@ if(THIRDPARTY_DIRECTORY)
     HarfBuzz
     JPEG
     LibSquish
+    LZ4
     ODE
     Ogg
     OpenAL
@@ -340,6 +341,14 @@ package_option(ZLIB
 
 package_status(ZLIB "zlib")
 
+# LZ4
+find_package(LZ4 QUIET)
+
+package_option(LZ4
+  "Enables the LZ4 compression codec for multifiles and the model cache.")
+
+package_status(LZ4 "LZ4")
+
 
 #
 # ------------ Image formats ------------
@@ -45,6 +45,7 @@ COMPILER=0
 INSTALLER=0
 WHEEL=0
 RUNTESTS=0
+BENCHMARKS=0
 GENMAN=0
 COMPRESSOR="zlib"
 THREADCOUNT=0
@@ -80,6 +81,7 @@ PkgListSet(["PYTHON", "DIRECT",                        # Python support
   "ODE", "BULLET", "PANDAPHYSICS",                     # Physics
   "SPEEDTREE",                                         # SpeedTree
   "ZLIB", "PNG", "JPEG", "TIFF", "OPENEXR", "SQUISH",  # 2D Formats support
+  "LZ4",                                               # Multifile compression
   ] + MAYAVERSIONS + MAXVERSIONS + [ "FCOLLADA", "ASSIMP", "EGG", # 3D Formats support
   "FREETYPE", "HARFBUZZ",                              # Text rendering
   "VRPN", "OPENSSL",                                   # Transport
@@ -124,6 +126,7 @@ def usage(problem):
     print("  --help            (print the help message you're reading now)")
     print("  --verbose         (print out more information)")
     print("  --tests           (run the test suite)")
+    print("  --benchmarks      (build the panda_benchmarks microbenchmark suite)")
     print("  --installer       (build an installer)")
     print("  --wheel           (build a pip-installable .whl)")
     print("  --optimize X      (optimization level can be 1,2,3,4)")
@@ -159,7 +162,7 @@ def usage(problem):
     os._exit(1)
 
 def parseopts(args):
-    global INSTALLER,WHEEL,RUNTESTS,GENMAN,DISTRIBUTOR,VERSION
+    global INSTALLER,WHEEL,RUNTESTS,BENCHMARKS,GENMAN,DISTRIBUTOR,VERSION
     global COMPRESSOR,THREADCOUNT,OSXTARGET
     global DEBVERSION,WHLVERSION,RPMRELEASE,GIT_COMMIT
     global STRDXSDKVERSION, WINDOWS_SDK, MSVC_VERSION, BOOUSEINTELCOMPILER
@@ -173,7 +176,7 @@ def parseopts(args):
 
     # All recognized options.
     longopts = [
-        "help","distributor=","verbose","osxtarget=","tests",
+        "help","distributor=","verbose","osxtarget=","tests","benchmarks",
         "optimize=","everything","nothing","installer","wheel","rtdist","nocolor",
         "version=","lzma","no-python","threads=","outputdir=","override=",
         "static","debversion=","rpmrelease=","p3dsuffix=","rtdist-version=",
@@ -200,6 +203,7 @@ def parseopts(args):
             elif (option=="--optimize"): optimize=value
             elif (option=="--installer"): INSTALLER=1
             elif (option=="--tests"): RUNTESTS=1
+            elif (option=="--benchmarks"): BENCHMARKS=1
             elif (option=="--wheel"): WHEEL=1
             elif (option=="--verbose"): SetVerbose(True)
             elif (option=="--distributor"): DISTRIBUTOR=value
@@ -638,6 +642,7 @@ if (COMPILER == "MSVC"):
         IncDirectory("OPENEXR", GetThirdpartyDir() + "openexr/include/OpenEXR")
     if (PkgSkip("JPEG")==0):     LibName("JPEG",     GetThirdpartyDir() + "jpeg/lib/jpeg-static.lib")
     if (PkgSkip("ZLIB")==0):     LibName("ZLIB",     GetThirdpartyDir() + "zlib/lib/zlibstatic.lib")
+    if (PkgSkip("LZ4")==0):      LibName("LZ4",      GetThirdpartyDir() + "lz4/lib/liblz4_static.lib")
     if (PkgSkip("VRPN")==0):     LibName("VRPN",     GetThirdpartyDir() + "vrpn/lib/vrpn.lib")
     if (PkgSkip("VRPN")==0):     LibName("VRPN",     GetThirdpartyDir() + "vrpn/lib/quat.lib")
     if (PkgSkip("NVIDIACG")==0): LibName("CGGL",     GetThirdpartyDir() + "nvidiacg/lib/cgGL.lib")
@@ -907,6 +912,7 @@ if (COMPILER=="GCC"):
 
     SmartPkgEnable("OPENSSL",   "openssl",   ("ssl", "crypto"), ("openssl/ssl.h", "openssl/crypto.h"))
     SmartPkgEnable("ZLIB",      "zlib",      ("z"), "zlib.h")
+    SmartPkgEnable("LZ4",       "liblz4",    ("lz4"), "lz4frame.h")
     SmartPkgEnable("GTK2",      "gtk+-2.0")
 
     if not PkgSkip("OPENSSL") and GetTarget() != "darwin":
@@ -2264,6 +2270,7 @@ DTOOL_CONFIG=[
     ("HAVE_EIGEN",                     'UNDEF',                  'UNDEF'),
     ("LINMATH_ALIGN",                  '1',                      '1'),
     ("HAVE_ZLIB",                      'UNDEF',                  'UNDEF'),
+    ("HAVE_LZ4",                       'UNDEF',                  'UNDEF'),
     ("HAVE_PNG",                       'UNDEF',                  'UNDEF'),
     ("HAVE_JPEG",                      'UNDEF',                  'UNDEF'),
     ("HAVE_VIDEO4LINUX",               'UNDEF',                  '1'),
@@ -3419,10 +3426,47 @@ TargetAdd('p3pandabase_pandabase.obj', opts=OPTS, input='pandabase.cxx')
 # DIRECTORY: panda/src/express/
 #
 
-OPTS=['DIR:panda/src/express', 'BUILDING:PANDAEXPRESS', 'OPENSSL', 'ZLIB']
+DefSymbol("ZSTD", "ZSTD_DISABLE_ASM", "")
+DefSymbol("ZSTD", "ZSTDLIB_VISIBLE", "")
+DefSymbol("ZSTD", "ZSTDERRORLIB_VISIBLE", "")
+
+OPTS=['DIR:panda/src/express', 'BUILDING:PANDAEXPRESS', 'OPENSSL', 'ZLIB', 'LZ4', 'ZSTD']
 TargetAdd('p3express_composite1.obj', opts=OPTS, input='p3express_composite1.cxx')
 TargetAdd('p3express_composite2.obj', opts=OPTS, input='p3express_composite2.cxx')
 
+# The copy of the reference Zstandard library in panda/src/express/zstd.
+ZSTD_SOURCES=[
+  'zstd/common/debug.c',
+  'zstd/common/entropy_common.c',
+  'zstd/common/error_private.c',
+  'zstd/common/fse_decompress.c',
+  'zstd/common/pool.c',
+  'zstd/common/threading.c',
+  'zstd/common/xxhash.c',
+  'zstd/common/zstd_common.c',
+  'zstd/compress/fse_compress.c',
+  'zstd/compress/hist.c',
+  'zstd/compress/huf_compress.c',
+  'zstd/compress/zstd_compress.c',
+  'zstd/compress/zstd_compress_literals.c',
+  'zstd/compress/zstd_compress_sequences.c',
+  'zstd/compress/zstd_compress_superblock.c',
+  'zstd/compress/zstd_double_fast.c',
+  'zstd/compress/zstd_fast.c',
+  'zstd/compress/zstd_lazy.c',
+  'zstd/compress/zstd_ldm.c',
+  'zstd/compress/zstd_opt.c',
+  'zstd/compress/zstd_preSplit.c',
+  'zstd/compress/zstdmt_compress.c',
+  'zstd/decompress/huf_decompress.c',
+  'zstd/decompress/zstd_ddict.c',
+  'zstd/decompress/zstd_decompress.c',
+  'zstd/decompress/zstd_decompress_block.c',
+]
+for source in ZSTD_SOURCES:
+  obj = 'p3express_zstd_' + os.path.basename(source)[:-2] + '.obj'
+  TargetAdd(obj, opts=OPTS, input=source)
+
 OPTS=['DIR:panda/src/express', 'OPENSSL', 'ZLIB']
 IGATEFILES=GetDirectoryContents('panda/src/express', ["*.h", "*_composite*.cxx"])
 TargetAdd('libp3express.in', opts=OPTS, input=IGATEFILES)
@@ -3453,9 +3497,11 @@ TargetAdd('libpandaexpress.dll', input='p3downloader_composite1.obj')
 TargetAdd('libpandaexpress.dll', input='p3downloader_composite2.obj')
 TargetAdd('libpandaexpress.dll', input='p3express_composite1.obj')
 TargetAdd('libpandaexpress.dll', input='p3express_composite2.obj')
+for source in ZSTD_SOURCES:
+  TargetAdd('libpandaexpress.dll', input='p3express_zstd_' + os.path.basename(source)[:-2] + '.obj')
 TargetAdd('libpandaexpress.dll', input='p3pandabase_pandabase.obj')
 TargetAdd('libpandaexpress.dll', input=COMMON_DTOOL_LIBS)
-TargetAdd('libpandaexpress.dll', opts=['ADVAPI', 'WINSOCK2', 'OPENSSL', 'ZLIB', 'WINGDI', 'WINUSER', 'ANDROID'])
+TargetAdd('libpandaexpress.dll', opts=['ADVAPI', 'WINSOCK2', 'OPENSSL', 'ZLIB', 'LZ4', 'WINGDI', 'WINUSER', 'ANDROID'])
 
 #
 # DIRECTORY: panda/src/pipeline/
@@ -4739,6 +4785,29 @@ if (PkgSkip("PVIEW")==0):
   if GetLinkAllStatic() and not PkgSkip("GL"):
     TargetAdd('pview.exe', input='libpandagl.dll')
 
+#
+# DIRECTORY: panda/src/benchmarks/
+#
+
+if BENCHMARKS:
+  OPTS=['DIR:panda/src/benchmarks']
+  TargetAdd('panda_benchmarks_bench_bam.obj', opts=OPTS, input='bench_bam.cxx')
+  TargetAdd('panda_benchmarks_bench_collide.obj', opts=OPTS, input='bench_collide.cxx')
+  TargetAdd('panda_benchmarks_bench_display.obj', opts=OPTS, input='bench_display.cxx')
+  TargetAdd('panda_benchmarks_bench_gobj.obj', opts=OPTS, input='bench_gobj.cxx')
+  TargetAdd('panda_benchmarks_bench_pgraph.obj', opts=OPTS, input='bench_pgraph.cxx')
+  TargetAdd('panda_benchmarks_benchmarkScenes.obj', opts=OPTS, input='benchmarkScenes.cxx')
+  TargetAdd('panda_benchmarks_pandaBenchmark.obj', opts=OPTS, input='pandaBenchmark.cxx')
+  TargetAdd('panda_benchmarks.exe', input='panda_benchmarks_bench_bam.obj')
+  TargetAdd('panda_benchmarks.exe', input='panda_benchmarks_bench_collide.obj')
+  TargetAdd('panda_benchmarks.exe', input='panda_benchmarks_bench_display.obj')
+  TargetAdd('panda_benchmarks.exe', input='panda_benchmarks_bench_gobj.obj')
+  TargetAdd('panda_benchmarks.exe', input='panda_benchmarks_bench_pgraph.obj')
+  TargetAdd('panda_benchmarks.exe', input='panda_benchmarks_benchmarkScenes.obj')
+  TargetAdd('panda_benchmarks.exe', input='panda_benchmarks_pandaBenchmark.obj')
+  TargetAdd('panda_benchmarks.exe', input=COMMON_PANDA_LIBS)
+  TargetAdd('panda_benchmarks.exe', opts=['ADVAPI', 'WINSOCK2', 'WINSHELL'])
+
 #
 # DIRECTORY: panda/src/android/
 #
@@ -0,0 +1,44 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file bench_bam.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "pandaBenchmark.h"
+#include "benchmarkScenes.h"
+#include "bamReader.h"
+
+/**
+ * Reads a generated scene back from an in-memory bam stream, which measures
+ * the BamReader itself without any disk I/O.
+ */
+static void
+bm_bam_read(BenchmarkState &state) {
+  int depth = (int)state.get_arg();
+  NodePath scene = make_tree_scene(depth, 4, 8);
+
+  vector_uchar data;
+  if (!scene.encode_to_bam_stream(data)) {
+    state.skip_with_error("could not encode scene");
+    return;
+  }
+
+  while (state.keep_running()) {
+    NodePath result = NodePath::decode_from_bam_stream(data);
+    if (result.is_empty()) {
+      state.skip_with_error("could not decode scene");
+      break;
+    }
+    benchmark_do_not_optimize(result);
+  }
+  state.set_items_processed(state.get_iterations() * (int64_t)data.size());
+  state.set_label(format_string(data.size()) + " bytes");
+}
+PANDA_BENCHMARK(bm_bam_read)->arg(3)->arg(4);
@@ -0,0 +1,71 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file bench_collide.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "pandaBenchmark.h"
+#include "benchmarkScenes.h"
+#include "collisionTraverser.h"
+#include "collisionHandlerQueue.h"
+#include "collisionNode.h"
+#include "collisionSphere.h"
+#include "collisionRay.h"
+#include "string_utils.h"
+
+/**
+ * Traverses a grid of collision spheres and visible geometry with a number of
+ * downward-pointing rays and moving spheres, as a typical game would each
+ * frame.
+ */
+static void
+bm_collision_traverse(BenchmarkState &state) {
+  int num_colliders = (int)state.get_arg();
+  const int grid = 16;
+
+  NodePath root("root");
+  NodePath world = root.attach_new_node("world");
+  for (int y = 0; y < grid; ++y) {
+    for (int x = 0; x < grid; ++x) {
+      PT(CollisionNode) cnode = new CollisionNode("into_" + format_string(y * grid + x));
+      cnode->add_solid(new CollisionSphere(0, 0, 0, 1.5f));
+      cnode->set_from_collide_mask(CollideMask::all_off());
+      NodePath np = world.attach_new_node(cnode);
+      np.set_pos(x * 4.0f, y * 4.0f, 0);
+    }
+  }
+  NodePath ground = world.attach_new_node(make_grid_geom_node("ground", 16));
+  ground.set_scale(grid * 4.0f);
+
+  PT(CollisionHandlerQueue) queue = new CollisionHandlerQueue;
+  CollisionTraverser trav("bench");
+  for (int i = 0; i < num_colliders; ++i) {
+    PN_stdfloat x = (PN_stdfloat)((i * 7) % (grid * 4));
+    PN_stdfloat y = (PN_stdfloat)((i * 13) % (grid * 4));
+
+    PT(CollisionNode) cnode = new CollisionNode("from_" + format_string(i));
+    if (i % 2 == 0) {
+      cnode->add_solid(new CollisionRay(0, 0, 10, 0, 0, -1));
+    } else {
+      cnode->add_solid(new CollisionSphere(0, 0, 0, 1.0f));
+    }
+    cnode->set_into_collide_mask(CollideMask::all_off());
+    NodePath np = root.attach_new_node(cnode);
+    np.set_pos(x, y, 0.5f);
+    trav.add_collider(np, queue);
+  }
+
+  while (state.keep_running()) {
+    trav.traverse(root);
+    benchmark_do_not_optimize(queue->get_num_entries());
+  }
+  state.set_items_processed(state.get_iterations() * num_colliders);
+}
+PANDA_BENCHMARK(bm_collision_traverse)->arg(16)->arg(128);
@@ -0,0 +1,77 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file bench_display.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "pandaBenchmark.h"
+#include "benchmarkScenes.h"
+#include "graphicsEngine.h"
+#include "graphicsPipeSelection.h"
+#include "graphicsOutput.h"
+#include "displayRegion.h"
+#include "frameBufferProperties.h"
+#include "windowProperties.h"
+#include "camera.h"
+#include "perspectiveLens.h"
+
+/**
+ * Renders a full frame of a generated scene into an offscreen buffer of the
+ * software renderer, so that the cull and draw traversals are measured
+ * without depending on a GPU or a display.  The tinydisplay module is loaded
+ * at runtime; if it is not available, the benchmark is skipped.
+ */
+static void
+bm_render_frame_tinydisplay(BenchmarkState &state) {
+  int size = (int)state.get_arg();
+
+  GraphicsPipeSelection *selection = GraphicsPipeSelection::get_global_ptr();
+  PT(GraphicsPipe) pipe = selection->make_pipe("TinyOffscreenGraphicsPipe", "p3tinydisplay");
+  if (pipe == nullptr) {
+    state.skip_with_message("TinyOffscreenGraphicsPipe is not available");
+    return;
+  }
+
+  GraphicsEngine *engine = GraphicsEngine::get_global_ptr();
+  FrameBufferProperties fb_prop;
+  fb_prop.set_rgb_color(true);
+  fb_prop.set_depth_bits(16);
+  GraphicsOutput *buffer = engine->make_output
+    (pipe, "benchmark", 0, fb_prop, WindowProperties::size(size, size),
+     GraphicsPipe::BF_refuse_window);
+  if (buffer == nullptr) {
+    state.skip_with_error("could not open an offscreen buffer");
+    return;
+  }
+
+  NodePath render("render");
+  NodePath scene = make_tree_scene(3, 4, 8);
+  scene.reparent_to(render);
+
+  PT(Camera) camera = new Camera("camera", new PerspectiveLens);
+  NodePath camera_np = render.attach_new_node(camera);
+  camera_np.set_pos(4, -20, 6);
+  camera_np.look_at(LPoint3(4, 8, 0));
+
+  DisplayRegion *dr = buffer->make_display_region();
+  dr->set_camera(camera_np);
+
+  // Render one frame first, to prepare the textures and vertex buffers.
+  engine->render_frame();
+
+  while (state.keep_running()) {
+    engine->render_frame();
+  }
+  engine->sync_frame();
+  state.set_items_processed(state.get_iterations() * size * size);
+
+  engine->remove_window(buffer);
+}
+PANDA_BENCHMARK(bm_render_frame_tinydisplay)->arg(256)->arg(640);
@@ -0,0 +1,47 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file bench_gobj.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "pandaBenchmark.h"
+#include "benchmarkScenes.h"
+#include "geomVertexFormat.h"
+
+/**
+ * Converts a vertex table from an interleaved v3n3c4t2 format to a format
+ * with one array per column and a packed color, which exercises the generic
+ * column copy as well as the color packing.
+ */
+static void
+bm_vertex_data_convert_to(BenchmarkState &state) {
+  int size = (int)state.get_arg();
+  PT(GeomVertexData) vdata =
+    make_grid_vertex_data(size, GeomVertexFormat::get_v3n3c4t2());
+
+  PT(GeomVertexFormat) format = new GeomVertexFormat;
+  format->add_array(GeomVertexArrayFormat::register_format(new GeomVertexArrayFormat(
+    InternalName::get_vertex(), 3, GeomEnums::NT_float32, GeomEnums::C_point)));
+  format->add_array(GeomVertexArrayFormat::register_format(new GeomVertexArrayFormat(
+    InternalName::get_normal(), 3, GeomEnums::NT_float32, GeomEnums::C_normal)));
+  format->add_array(GeomVertexArrayFormat::register_format(new GeomVertexArrayFormat(
+    InternalName::get_color(), 1, GeomEnums::NT_packed_dabc, GeomEnums::C_color,
+    InternalName::get_texcoord(), 2, GeomEnums::NT_float32, GeomEnums::C_texcoord)));
+  CPT(GeomVertexFormat) new_format = GeomVertexFormat::register_format(format);
+
+  while (state.keep_running()) {
+    // Otherwise, the result of the previous iteration would be returned.
+    vdata->clear_cache();
+    CPT(GeomVertexData) result = vdata->convert_to(new_format);
+    benchmark_do_not_optimize(result);
+  }
+  state.set_items_processed(state.get_iterations() * size * size);
+}
+PANDA_BENCHMARK(bm_vertex_data_convert_to)->arg(64)->arg(256);
@@ -0,0 +1,147 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file bench_pgraph.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "pandaBenchmark.h"
+#include "benchmarkScenes.h"
+#include "transformState.h"
+#include "renderState.h"
+#include "colorAttrib.h"
+#include "colorScaleAttrib.h"
+#include "cullFaceAttrib.h"
+#include "depthWriteAttrib.h"
+#include "transparencyAttrib.h"
+#include "string_utils.h"
+
+/**
+ * Composes a chain of transforms that have already been composed once, so
+ * that every compose is answered from the composition cache.
+ */
+static void
+bm_transform_compose_cached(BenchmarkState &state) {
+  int count = (int)state.get_arg();
+  pvector<CPT(TransformState)> transforms;
+  for (int i = 0; i < count; ++i) {
+    transforms.push_back(TransformState::make_pos_hpr_scale(
+      LVecBase3(i, i * 0.5f, 1), LVecBase3(i * 10.0f, 0, 0), LVecBase3(1)));
+  }
+
+  while (state.keep_running()) {
+    CPT(TransformState) net = TransformState::make_identity();
+    for (const CPT(TransformState) &transform : transforms) {
+      net = net->compose(transform);
+    }
+    benchmark_do_not_optimize(net);
+  }
+  state.set_items_processed(state.get_iterations() * count);
+}
+PANDA_BENCHMARK(bm_transform_compose_cached)->arg(8)->arg(64);
+
+/**
+ * Composes transforms that have not been seen before, so that every compose
+ * computes a new matrix and looks up the result in the global state set.
+ */
+static void
+bm_transform_compose_fresh(BenchmarkState &state) {
+  int count = (int)state.get_arg();
+  int serial = 0;
+
+  while (state.keep_running()) {
+    CPT(TransformState) net = TransformState::make_identity();
+    for (int i = 0; i < count; ++i) {
+      ++serial;
+      net = net->compose(TransformState::make_pos_hpr(
+        LVecBase3(serial * 0.001f, i, 0), LVecBase3(serial * 0.01f, 0, 0)));
+    }
+    benchmark_do_not_optimize(net);
+  }
+  state.set_items_processed(state.get_iterations() * count);
+}
+PANDA_BENCHMARK(bm_transform_compose_fresh)->arg(8)->arg(64);
+
+/**
+ * Composes a set of RenderStates with each other, as the cull traversal does
+ * for each node it visits.
+ */
+static void
+bm_render_state_compose(BenchmarkState &state) {
+  pvector<CPT(RenderState)> states;
+  states.push_back(RenderState::make(ColorAttrib::make_flat(LColor(1, 0, 0, 1))));
+  states.push_back(RenderState::make(ColorScaleAttrib::make(LVecBase4(0.5f, 0.5f, 0.5f, 1))));
+  states.push_back(RenderState::make(CullFaceAttrib::make_reverse()));
+  states.push_back(RenderState::make(DepthWriteAttrib::make(DepthWriteAttrib::M_off)));
+  states.push_back(RenderState::make(TransparencyAttrib::make(TransparencyAttrib::M_alpha)));
+  states.push_back(RenderState::make(ColorAttrib::make_flat(LColor(0, 1, 0, 1)), 1));
+
+  size_t count = 0;
+  while (state.keep_running()) {
+    CPT(RenderState) net = RenderState::make_empty();
+    for (const CPT(RenderState) &other : states) {
+      net = net->compose(other);
+      ++count;
+    }
+    benchmark_do_not_optimize(net);
+  }
+  state.set_items_processed(count);
+}
+PANDA_BENCHMARK(bm_render_state_compose);
+
+/**
+ * Searches a generated tree for a node by name, with a ** wildcard.
+ */
+static void
+bm_node_path_find(BenchmarkState &state) {
+  int depth = (int)state.get_arg();
+  NodePath root = make_tree_scene(depth, 4, 2);
+
+  // Look for the last leaf, so that the whole tree is searched.
+  int num_nodes = 0;
+  for (int i = 1, level = 4; i <= depth; ++i, level *= 4) {
+    num_nodes += level;
+  }
+  std::string path = "**/leaf_" + format_string(num_nodes - 1);
+
+  while (state.keep_running()) {
+    NodePath found = root.find(path);
+    if (found.is_empty()) {
+      state.skip_with_error("did not find " + path);
+      break;
+    }
+    benchmark_do_not_optimize(found);
+  }
+  state.set_items_processed(state.get_iterations() * num_nodes);
+}
+PANDA_BENCHMARK(bm_node_path_find)->arg(3)->arg(5);
+
+/**
+ * Runs flatten_strong() on a fresh copy of a generated tree.  Only the
+ * flatten itself is timed, not the copy.
+ */
+static void
+bm_flatten_strong(BenchmarkState &state) {
+  int depth = (int)state.get_arg();
+  NodePath scene = make_tree_scene(depth, 4, 4);
+
+  while (state.keep_running()) {
+    state.pause_timing();
+    NodePath copy = scene.copy_to(NodePath());
+    state.resume_timing();
+
+    int num_removed = copy.flatten_strong();
+    benchmark_do_not_optimize(num_removed);
+
+    state.pause_timing();
+    copy.remove_node();
+    state.resume_timing();
+  }
+}
+PANDA_BENCHMARK(bm_flatten_strong)->arg(3)->arg(4);
@@ -0,0 +1,115 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file benchmarkScenes.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "benchmarkScenes.h"
+#include "geom.h"
+#include "geomTriangles.h"
+#include "geomVertexWriter.h"
+#include "colorAttrib.h"
+#include "string_utils.h"
+#include "cmath.h"
+
+/**
+ * Returns a square grid of size * size vertices in the indicated format.  Only
+ * the vertex, normal, color and texcoord columns are filled in, to the extent
+ * that the format has them.
+ */
+PT(GeomVertexData)
+make_grid_vertex_data(int size, const GeomVertexFormat *format) {
+  PT(GeomVertexData) vdata = new GeomVertexData("grid", format, Geom::UH_static);
+  vdata->unclean_set_num_rows(size * size);
+
+  GeomVertexWriter vertex(vdata, InternalName::get_vertex());
+  GeomVertexWriter normal(vdata, InternalName::get_normal());
+  GeomVertexWriter color(vdata, InternalName::get_color());
+  GeomVertexWriter texcoord(vdata, InternalName::get_texcoord());
+
+  PN_stdfloat scale = 1.0f / (PN_stdfloat)std::max(size - 1, 1);
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      PN_stdfloat u = x * scale;
+      PN_stdfloat v = y * scale;
+      vertex.set_data3(u, v, 0.1f * csin(u * 6.0f) * ccos(v * 6.0f));
+      if (normal.has_column()) {
+        normal.set_data3(0, 0, 1);
+      }
+      if (color.has_column()) {
+        color.set_data4(u, v, 1.0f - u, 1.0f);
+      }
+      if (texcoord.has_column()) {
+        texcoord.set_data2(u, v);
+      }
+    }
+  }
+  return vdata;
+}
+
+/**
+ * Returns a GeomNode with a single triangulated grid of size * size vertices.
+ */
+PT(GeomNode)
+make_grid_geom_node(const std::string &name, int size) {
+  PT(GeomVertexData) vdata =
+    make_grid_vertex_data(size, GeomVertexFormat::get_v3n3c4t2());
+
+  PT(GeomTriangles) tris = new GeomTriangles(Geom::UH_static);
+  for (int y = 0; y + 1 < size; ++y) {
+    for (int x = 0; x + 1 < size; ++x) {
+      int i = y * size + x;
+      tris->add_vertices(i, i + 1, i + size + 1);
+      tris->add_vertices(i, i + size + 1, i + size);
+    }
+  }
+
+  PT(Geom) geom = new Geom(vdata);
+  geom->add_primitive(tris);
+
+  PT(GeomNode) node = new GeomNode(name);
+  node->add_geom(geom);
+  return node;
+}
+
+/**
+ * Recursively builds one level of make_tree_scene().
+ */
+static void
+r_make_tree(NodePath parent, int depth, int fanout, int grid_size, int &counter) {
+  for (int i = 0; i < fanout; ++i) {
+    int n = counter++;
+    if (depth <= 1) {
+      NodePath leaf = parent.attach_new_node(
+        make_grid_geom_node("leaf_" + format_string(n), grid_size));
+      leaf.set_pos(i * 1.5f, 0, 0);
+      if ((n % 3) == 0) {
+        leaf.set_color(LColor(1, n % 2, 0, 1));
+      }
+    } else {
+      NodePath branch = parent.attach_new_node("branch_" + format_string(n));
+      branch.set_pos_hpr(0, i * 2.0f, 0.5f, i * 15.0f, 0, 0);
+      r_make_tree(branch, depth - 1, fanout, grid_size, counter);
+    }
+  }
+}
+
+/**
+ * Returns a tree of transformed nodes, depth levels deep, each node having
+ * fanout children, with a small grid GeomNode at each leaf.  The nodes are
+ * named "branch_<n>" and "leaf_<n>", numbered in depth-first order.
+ */
+NodePath
+make_tree_scene(int depth, int fanout, int grid_size) {
+  NodePath root("root");
+  int counter = 0;
+  r_make_tree(root, depth, fanout, grid_size, counter);
+  return root;
+}
@@ -0,0 +1,29 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file benchmarkScenes.h
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#ifndef BENCHMARKSCENES_H
+#define BENCHMARKSCENES_H
+
+#include "pandabase.h"
+#include "geomNode.h"
+#include "geomVertexData.h"
+#include "nodePath.h"
+
+// Procedurally generated content shared by the benchmarks, so that they don't
+// depend on any model files being present.
+
+PT(GeomVertexData) make_grid_vertex_data(int size, const GeomVertexFormat *format);
+PT(GeomNode) make_grid_geom_node(const std::string &name, int size);
+NodePath make_tree_scene(int depth, int fanout, int grid_size);
+
+#endif
@@ -0,0 +1,483 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pandaBenchmark.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "pandaBenchmark.h"
+#include "trueClock.h"
+#include "globPattern.h"
+#include "executionEnvironment.h"
+#include "pnotify.h"
+#include "string_utils.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <stdlib.h>
+#include <time.h>
+#include <thread>
+
+using std::string;
+
+namespace {
+  typedef pvector<Benchmark *> Benchmarks;
+
+  Benchmarks &get_benchmarks() {
+    static Benchmarks *benchmarks = new Benchmarks;
+    return *benchmarks;
+  }
+
+  double get_cpu_time() {
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+  }
+
+  // The results of one benchmark, at one argument.
+  class BenchmarkResult {
+  public:
+    string _name;
+    int64_t _iterations;
+    double _real_time;
+    double _cpu_time;
+    double _items_per_second;
+    string _label;
+    string _error;
+    bool _skipped;
+  };
+
+  string json_escape(const string &str) {
+    string result;
+    for (char c : str) {
+      switch (c) {
+      case '"':
+        result += "\\\"";
+        break;
+      case '\\':
+        result += "\\\\";
+        break;
+      case '\n':
+        result += "\\n";
+        break;
+      default:
+        if ((unsigned char)c < 0x20) {
+          char buffer[8];
+          snprintf(buffer, sizeof(buffer), "\\u%04x", (unsigned char)c);
+          result += buffer;
+        } else {
+          result += c;
+        }
+      }
+    }
+    return result;
+  }
+
+  void write_json(std::ostream &out, const string &executable,
+                  const pvector<BenchmarkResult> &results) {
+    char date[64];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    out << "{\n"
+        << "  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+        << "    \"executable\": \"" << json_escape(executable) << "\",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+        << "    \"library_build_type\": \"release\"\n"
+#else
+        << "    \"library_build_type\": \"debug\"\n"
+#endif
+        << "  },\n"
+        << "  \"benchmarks\": [";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+      const BenchmarkResult &result = results[i];
+      out << (i == 0 ? "\n" : ",\n")
+          << "    {\n"
+          << "      \"name\": \"" << json_escape(result._name) << "\",\n"
+          << "      \"run_name\": \"" << json_escape(result._name) << "\",\n"
+          << "      \"run_type\": \"iteration\",\n";
+      if (result._skipped) {
+        out << "      \"skipped\": true,\n"
+            << "      \"skip_message\": \"" << json_escape(result._error) << "\",\n";
+      } else if (!result._error.empty()) {
+        out << "      \"error_occurred\": true,\n"
+            << "      \"error_message\": \"" << json_escape(result._error) << "\",\n";
+      }
+      out << "      \"iterations\": " << result._iterations << ",\n"
+          << "      \"real_time\": " << result._real_time << ",\n"
+          << "      \"cpu_time\": " << result._cpu_time << ",\n"
+          << "      \"time_unit\": \"ns\"";
+      if (result._items_per_second > 0.0) {
+        out << ",\n      \"items_per_second\": " << result._items_per_second;
+      }
+      if (!result._label.empty()) {
+        out << ",\n      \"label\": \"" << json_escape(result._label) << "\"";
+      }
+      out << "\n    }";
+    }
+    out << "\n  ]\n}\n";
+  }
+
+  void write_console_header(std::ostream &out) {
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::left << std::setw(40) << "Benchmark" << std::right
+        << " " << std::setw(15) << "Time (ns)"
+        << " " << std::setw(15) << "CPU (ns)"
+        << " " << std::setw(12) << "Iterations" << "\n"
+        << string(40 + 1 + 15 + 1 + 15 + 1 + 12, '-') << "\n";
+    out.flags(flags);
+  }
+
+  void write_console_result(std::ostream &out, const BenchmarkResult &result) {
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::left << std::setw(40) << result._name << std::right;
+    if (result._skipped) {
+      out << " SKIPPED: " << result._error << "\n";
+    } else if (!result._error.empty()) {
+      out << " ERROR: " << result._error << "\n";
+    } else {
+      out << std::fixed << std::setprecision(0)
+          << " " << std::setw(15) << result._real_time
+          << " " << std::setw(15) << result._cpu_time
+          << " " << std::setw(12) << result._iterations;
+      if (result._items_per_second > 0.0) {
+        out.unsetf(std::ios_base::floatfield);
+        out << std::setprecision(4)
+            << " " << std::setw(12) << result._items_per_second << " items/s";
+      }
+      if (!result._label.empty()) {
+        out << " " << result._label;
+      }
+      out << "\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+  }
+
+  // Runs the function with more and more iterations until it takes at least
+  // min_time seconds, and returns the results of the last run.
+  BenchmarkResult run_benchmark(const string &name, BenchmarkFunc *func,
+                                int64_t arg, double min_time) {
+    int64_t iterations = 1;
+    BenchmarkState state(iterations, arg);
+    func(state);
+    while (state._error.empty() && state._real_time < min_time &&
+           iterations < (int64_t)1000000000) {
+      // Estimate how many iterations are needed to reach the minimum time,
+      // with a bit of margin, but don't grow too quickly from a single
+      // sample that may have been too short to measure.
+      double multiplier = (state._real_time > 0.0)
+        ? (min_time * 1.4 / state._real_time) : 10.0;
+      multiplier = std::min(std::max(multiplier, 2.0), 10.0);
+      iterations = (int64_t)((double)iterations * multiplier);
+
+      state = BenchmarkState(iterations, arg);
+      func(state);
+    }
+
+    BenchmarkResult result;
+    result._name = name;
+    result._iterations = state._iterations;
+    result._error = state._error;
+    result._skipped = state._skipped;
+    result._label = state._label;
+    double n = (double)std::max(state._iterations, (int64_t)1);
+    result._real_time = state._real_time * 1.0e9 / n;
+    result._cpu_time = state._cpu_time * 1.0e9 / n;
+    result._items_per_second = 0.0;
+    if (state._items_processed > 0 && state._real_time > 0.0) {
+      result._items_per_second = (double)state._items_processed / state._real_time;
+    }
+    return result;
+  }
+}
+
+/**
+ *
+ */
+BenchmarkState::
+BenchmarkState(int64_t max_iterations, int64_t arg) :
+  _max_iterations(max_iterations),
+  _iterations(0),
+  _arg(arg),
+  _items_processed(0),
+  _skipped(false),
+  _started(false),
+  _finished(false),
+  _running(false),
+  _real_start(0.0),
+  _cpu_start(0.0),
+  _real_time(0.0),
+  _cpu_time(0.0)
+{
+}
+
+/**
+ * Stops the clock, so that whatever follows is not counted towards the
+ * measured time.  This has some overhead of its own; avoid calling it for
+ * very short iterations.
+ */
+void BenchmarkState::
+pause_timing() {
+  if (_running) {
+    _real_time += TrueClock::get_global_ptr()->get_short_time() - _real_start;
+    _cpu_time += get_cpu_time() - _cpu_start;
+    _running = false;
+  }
+}
+
+/**
+ * Restarts the clock after a call to pause_timing().
+ */
+void BenchmarkState::
+resume_timing() {
+  if (!_running && _started && !_finished) {
+    _real_start = TrueClock::get_global_ptr()->get_short_time();
+    _cpu_start = get_cpu_time();
+    _running = true;
+  }
+}
+
+/**
+ * Reports that the benchmark failed.  The next call to keep_running() will
+ * return false, and run_all() will return a failure status.
+ */
+void BenchmarkState::
+skip_with_error(const string &message) {
+  _error = message;
+  _skipped = false;
+}
+
+/**
+ * Reports that the benchmark cannot be run in this build, for instance
+ * because a required module is not available.  The next call to
+ * keep_running() will return false.  Unlike skip_with_error(), this does not
+ * count as a failure.
+ */
+void BenchmarkState::
+skip_with_message(const string &message) {
+  _error = message;
+  _skipped = true;
+}
+
+/**
+ * Handles the first and last calls to keep_running().
+ */
+bool BenchmarkState::
+start_or_stop() {
+  if (!_started && !_finished && _error.empty() && _max_iterations > 0) {
+    _started = true;
+    _iterations = 1;
+    resume_timing();
+    return true;
+  }
+
+  pause_timing();
+  _finished = true;
+  return false;
+}
+
+/**
+ *
+ */
+Benchmark::
+Benchmark(const string &name, BenchmarkFunc *func) :
+  _name(name),
+  _func(func)
+{
+}
+
+/**
+ * Adds an argument that the benchmark should be run with.  The benchmark is
+ * run once for each argument.
+ */
+Benchmark *Benchmark::
+arg(int64_t arg) {
+  _args.push_back(arg);
+  return this;
+}
+
+/**
+ * Adds the arguments begin, begin * multiplier, and so on, up to and
+ * including end.
+ */
+Benchmark *Benchmark::
+range(int64_t begin, int64_t end, int multiplier) {
+  nassertr(begin > 0 && multiplier > 1, this);
+  for (int64_t arg = begin; arg < end; arg *= multiplier) {
+    _args.push_back(arg);
+  }
+  _args.push_back(end);
+  return this;
+}
+
+/**
+ * Called by the PANDA_BENCHMARK macro at static init time.
+ */
+Benchmark *Benchmark::
+register_benchmark(const char *name, BenchmarkFunc *func) {
+  Benchmark *benchmark = new Benchmark(name, func);
+  get_benchmarks().push_back(benchmark);
+  return benchmark;
+}
+
+/**
+ * Parses the command line, and runs the benchmarks it selects.  Returns the
+ * exit status for main().
+ *
+ * The recognized options are a subset of those of Google Benchmark:
+ * --benchmark_filter=<glob>, --benchmark_min_time=<seconds>,
+ * --benchmark_format=<console|json>, --benchmark_out=<filename>,
+ * --benchmark_out_format=<console|json> and --benchmark_list_tests.
+ */
+int Benchmark::
+run_all(int argc, char *argv[]) {
+  string filter = "*";
+  double min_time = 0.5;
+  string format = "console";
+  string out_filename;
+  string out_format = "json";
+  bool list_tests = false;
+
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    size_t eq = arg.find('=');
+    string key = arg.substr(0, eq);
+    string value = (eq != string::npos) ? arg.substr(eq + 1) : string();
+
+    if (key == "--benchmark_filter") {
+      filter = value;
+    } else if (key == "--benchmark_min_time") {
+      // Google Benchmark also accepts a trailing "s".
+      min_time = atof(value.c_str());
+    } else if (key == "--benchmark_format") {
+      format = value;
+    } else if (key == "--benchmark_out") {
+      out_filename = value;
+    } else if (key == "--benchmark_out_format") {
+      out_format = value;
+    } else if (key == "--benchmark_list_tests") {
+      list_tests = (value.empty() || value == "true" || value == "1");
+    } else {
+      std::cerr
+        << "Unknown option: " << arg << "\n\n"
+        << "Usage: " << argv[0] << " [options]\n"
+        << "  --benchmark_filter=<glob>\n"
+        << "  --benchmark_min_time=<seconds>\n"
+        << "  --benchmark_format=<console|json>\n"
+        << "  --benchmark_out=<filename>\n"
+        << "  --benchmark_out_format=<console|json>\n"
+        << "  --benchmark_list_tests\n";
+      return 1;
+    }
+  }
+
+  if ((format != "console" && format != "json") ||
+      (out_format != "console" && out_format != "json")) {
+    std::cerr << "Output format must be console or json.\n";
+    return 1;
+  }
+
+  GlobPattern pattern(filter);
+
+  // Build the list of runs.
+  pvector<std::pair<Benchmark *, int64_t> > runs;
+  pvector<string> names;
+  for (Benchmark *benchmark : get_benchmarks()) {
+    if (benchmark->_args.empty()) {
+      if (pattern.matches(benchmark->_name)) {
+        runs.push_back(std::make_pair(benchmark, (int64_t)0));
+        names.push_back(benchmark->_name);
+      }
+    } else {
+      for (int64_t arg : benchmark->_args) {
+        string name = benchmark->_name + "/" + format_string(arg);
+        if (pattern.matches(name) || pattern.matches(benchmark->_name)) {
+          runs.push_back(std::make_pair(benchmark, arg));
+          names.push_back(name);
+        }
+      }
+    }
+  }
+
+  if (list_tests) {
+    for (const string &name : names) {
+      std::cout << name << "\n";
+    }
+    return 0;
+  }
+
+  if (runs.empty()) {
+    std::cerr << "No benchmarks match " << filter << "\n";
+    return 1;
+  }
+
+  if (format == "console") {
+    write_console_header(std::cout);
+  }
+
+  pvector<BenchmarkResult> results;
+  int num_failed = 0;
+  int num_skipped = 0;
+  for (size_t i = 0; i < runs.size(); ++i) {
+    results.push_back(run_benchmark(names[i], runs[i].first->_func,
+                                    runs[i].second, min_time));
+    if (results.back()._skipped) {
+      ++num_skipped;
+    } else if (!results.back()._error.empty()) {
+      ++num_failed;
+    }
+    if (format == "console") {
+      write_console_result(std::cout, results.back());
+      std::cout.flush();
+    }
+  }
+
+  string executable = ExecutionEnvironment::get_binary_name();
+  if (format == "json") {
+    write_json(std::cout, executable, results);
+  }
+
+  if (!out_filename.empty()) {
+    pofstream out(out_filename.c_str());
+    if (!out) {
+      std::cerr << "Unable to write " << out_filename << "\n";
+      return 1;
+    }
+    if (out_format == "json") {
+      write_json(out, executable, results);
+    } else {
+      write_console_header(out);
+      for (const BenchmarkResult &result : results) {
+        write_console_result(out, result);
+      }
+    }
+  }
+
+  // Benchmarks that skip themselves because of a missing module don't count
+  // as failures, but they are reported.
+  if (num_skipped != 0) {
+    std::cerr << num_skipped << " benchmark(s) were skipped.\n";
+  }
+  if (num_failed != 0) {
+    std::cerr << num_failed << " benchmark(s) failed.\n";
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ *
+ */
+int
+main(int argc, char *argv[]) {
+  return Benchmark::run_all(argc, argv);
+}
@@ -0,0 +1,118 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pandaBenchmark.h
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#ifndef PANDABENCHMARK_H
+#define PANDABENCHMARK_H
+
+#include "pandabase.h"
+#include "pvector.h"
+
+#include <stdint.h>
+
+/**
+ * The state passed to each benchmark function.  A benchmark function runs
+ * its setup code, and then repeats the code being measured for as long as
+ * keep_running() returns true:
+ *
+ *   static void bm_something(BenchmarkState &state) {
+ *     setup();
+ *     while (state.keep_running()) {
+ *       measure_me();
+ *     }
+ *   }
+ *   PANDA_BENCHMARK(bm_something)->arg(16)->arg(1024);
+ *
+ * This follows the model of Google Benchmark, and the JSON output uses the
+ * same layout, so that the results can be fed to the same comparison tools.
+ */
+class BenchmarkState {
+public:
+  BenchmarkState(int64_t max_iterations, int64_t arg);
+
+  INLINE bool keep_running();
+
+  void pause_timing();
+  void resume_timing();
+
+  INLINE int64_t get_arg() const;
+  INLINE int64_t get_iterations() const;
+
+  INLINE void set_items_processed(int64_t items);
+  INLINE void set_label(const std::string &label);
+  void skip_with_error(const std::string &message);
+  void skip_with_message(const std::string &message);
+
+private:
+  bool start_or_stop();
+
+public:
+  int64_t _max_iterations;
+  int64_t _iterations;
+  int64_t _arg;
+  int64_t _items_processed;
+  std::string _label;
+  std::string _error;
+  bool _skipped;
+  bool _started;
+  bool _finished;
+
+  bool _running;
+  double _real_start;
+  double _cpu_start;
+  double _real_time;
+  double _cpu_time;
+};
+
+typedef void BenchmarkFunc(BenchmarkState &state);
+
+/**
+ * A registered benchmark function, along with the list of arguments it should
+ * be run with.
+ */
+class Benchmark {
+public:
+  Benchmark(const std::string &name, BenchmarkFunc *func);
+
+  Benchmark *arg(int64_t arg);
+  Benchmark *range(int64_t begin, int64_t end, int multiplier = 8);
+
+  static Benchmark *register_benchmark(const char *name, BenchmarkFunc *func);
+  static int run_all(int argc, char *argv[]);
+
+public:
+  std::string _name;
+  BenchmarkFunc *_func;
+  pvector<int64_t> _args;
+};
+
+// Registers the indicated function as a benchmark.  The result may be used to
+// add arguments.
+#define PANDA_BENCHMARK(func) \
+  static Benchmark *_benchmark_ ## func = \
+    Benchmark::register_benchmark(#func, func)
+
+// Use this to keep the compiler from optimizing away a result that is
+// otherwise unused.
+template<class Type>
+INLINE void benchmark_do_not_optimize(const Type &value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void *sink;
+  sink = &value;
+#endif
+}
+
+#include "pandaBenchmark.I"
+
+#endif
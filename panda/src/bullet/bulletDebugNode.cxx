@@ -257,7 +257,7 @@ add_for_draw(CullTraverser *trav, CullTraverserData &data) {
   }
 
   // Record them without any state or transform.
-  trav->_geoms_pcollector.add_level(2);
+  trav->count_level(trav->_geoms_pcollector, 2);
   {
     CullableObject *object =
       new CullableObject(std::move(debug_lines), RenderState::make_empty(), trav->get_scene()->get_cs_world_transform());
@@ -410,9 +410,16 @@ fillin(DatagramIterator &scan, BamReader *manager) {
 
     for (int i = 0; i < num_matrix_components; i++) {
       int size = scan.get_uint16();
-      PTA_stdfloat ind_table(get_class_type());
-      for (int j = 0; j < size; j++) {
-        ind_table.push_back(scan.get_stdfloat());
+      PTA_stdfloat ind_table = PTA_stdfloat::empty_array(size, get_class_type());
+      if (size > 0) {
+        if (new_hpr) {
+          manager->extract_stdfloats(scan, &ind_table[0], size);
+        } else {
+          // We need the values right away to convert them below.
+          for (int j = 0; j < size; j++) {
+            ind_table[j] = scan.get_stdfloat();
+          }
+        }
       }
       _tables[i] = ind_table;
     }
@@ -62,6 +62,8 @@ PUBLISHED:
   MAKE_MAP_PROPERTY(tables, has_table, get_table, set_table, clear_table);
 
 public:
+  INLINE const CPTA_stdfloat &get_table_by_index(int table_index) const;
+
   virtual void write(std::ostream &out, int indent_level) const;
 
 protected:
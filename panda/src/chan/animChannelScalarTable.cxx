@@ -267,8 +267,9 @@ fillin(DatagramIterator& scan, BamReader* manager) {
   if (!wrote_compressed) {
     // Regular floats.
     int size = scan.get_uint16();
-    for(int i = 0; i < size; i++) {
-      temp_table.push_back(scan.get_stdfloat());
+    temp_table = PTA_stdfloat::empty_array(size, get_class_type());
+    if (size > 0) {
+      manager->extract_stdfloats(scan, &temp_table[0], size);
     }
 
   } else {
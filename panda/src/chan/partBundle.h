@@ -236,6 +236,7 @@ private:
 
   friend class PartBundleNode;
   friend class Character;
+  friend class CharacterJointBundle;
   friend class MovingPartBase;
   friend class MovingPartMatrix;
   friend class MovingPartScalar;
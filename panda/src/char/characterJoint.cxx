@@ -132,6 +132,16 @@ update_internals(PartBundle *root, PartGroup *parent, bool self_changed,
     }
   }
 
+  update_dependents(self_changed, net_changed, current_thread);
+  return self_changed || net_changed;
+}
+
+/**
+ * Called after the joint's value and/or net transform have changed, to pass
+ * the change on to the nodes and vertex transforms that depend on them.
+ */
+void CharacterJoint::
+update_dependents(bool self_changed, bool net_changed, Thread *current_thread) {
   if (net_changed) {
     if (!_net_transform_nodes.empty()) {
       CPT(TransformState) t = TransformState::make_mat(_net_transform);
@@ -167,8 +177,6 @@ update_internals(PartBundle *root, PartGroup *parent, bool self_changed,
       node->set_transform(t, current_thread);
     }
   }
-
-  return self_changed || net_changed;
 }
 
 /**
@@ -72,6 +72,8 @@ PUBLISHED:
 
 private:
   void set_character(Character *character);
+  void update_dependents(bool self_changed, bool net_changed,
+                         Thread *current_thread);
 
 private:
   // Not a reference-counted pointer.
@@ -132,6 +134,7 @@ private:
   static TypeHandle _type_handle;
 
   friend class Character;
+  friend class CharacterJointArrays;
   friend class CharacterJointBundle;
   friend class JointVertexTransform;
 };
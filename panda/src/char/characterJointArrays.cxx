@@ -0,0 +1,426 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file characterJointArrays.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "characterJointArrays.h"
+#include "characterJoint.h"
+#include "animChannelMatrixXfmTable.h"
+#include "animControl.h"
+#include "config_chan.h"
+
+/**
+ * Flattens the joint hierarchy below the indicated root.  The hierarchy is
+ * not expected to change afterwards.
+ */
+CharacterJointArrays::
+CharacterJointArrays(PartGroup *root) {
+  r_build(root, -1, -1);
+
+  size_t num_joints = _joints.size();
+  _mode.resize(num_joints);
+  _components.resize(num_joints * num_matrix_components);
+  _net_effect.resize(num_joints);
+  _values.resize(num_joints);
+  _nets.resize(num_joints);
+  _self_changed.resize(num_joints);
+  _changed.resize(num_joints);
+  _net_changed.resize(num_joints);
+}
+
+/**
+ * Updates all of the parts of the hierarchy to reflect the current frame of
+ * the indicated blend of AnimControls.  This is the flattened equivalent of
+ * PartGroup::do_update(), and returns true if any part has changed.
+ */
+bool CharacterJointArrays::
+update(PartBundle *root, const CycleData *root_cdata,
+       const PartBundle::ChannelBlend &blend, PartBundle::BlendType blend_type,
+       bool frame_blend_flag, bool anim_changed, Thread *current_thread) {
+  int num_joints = (int)_joints.size();
+  bool can_blend = (blend_type == PartBundle::BT_linear ||
+                    blend_type == PartBundle::BT_componentwise);
+
+  // First decide, for each joint, how its value is to be computed.  As in
+  // MovingPartMatrix::get_blend_value(), the joints are sampled directly if
+  // there is only one AnimControl in the blend.
+  _num_channels.assign(num_joints, 0);
+  std::fill(_mode.begin(), _mode.end(), (unsigned char)JM_blend);
+
+  // The tables need only be sampled again if some AnimControl has moved on
+  // since the last time, in the same way that MovingPartBase::do_update()
+  // asks each channel whether it has changed since the marked frame.
+  bool needs_sample = anim_changed;
+
+  PartBundle::ChannelBlend::const_iterator cbi;
+  for (cbi = blend.begin(); cbi != blend.end(); ++cbi) {
+    AnimControl *control = (*cbi).first;
+    if (control->get_channel_index() < 0) {
+      continue;
+    }
+    const BoundAnim &bound = get_bound_anim(control);
+    double frac = frame_blend_flag ? control->get_frac() : 0.0;
+    if (bound._last_frame != control->get_frame() || bound._last_frac != frac) {
+      needs_sample = true;
+    }
+    for (int j = 0; j < num_joints; ++j) {
+      if (bound._state[j] == CS_table) {
+        ++_num_channels[j];
+      } else if (bound._state[j] == CS_other) {
+        _mode[j] = JM_fallback;
+      }
+    }
+  }
+
+  bool direct = (blend.size() == 1 && !frame_blend_flag);
+  bool any_blend = false;
+  for (int j = 0; j < num_joints; ++j) {
+    if (_mode[j] == JM_fallback || _num_channels[j] == 0 || blend.empty() ||
+        _joints[j]._joint->_forced_channel != nullptr) {
+      _mode[j] = JM_fallback;
+    } else if (direct) {
+      _mode[j] = JM_direct;
+    } else if (can_blend) {
+      any_blend = true;
+    } else {
+      _mode[j] = JM_fallback;
+    }
+  }
+
+  if (any_blend && needs_sample) {
+    if (blend_type == PartBundle::BT_componentwise) {
+      _accum.assign(num_joints * num_matrix_components, 0.0f);
+    }
+    for (int j = 0; j < num_joints; ++j) {
+      _values[j] = LMatrix4::zeros_mat();
+      _net_effect[j] = 0.0f;
+    }
+  }
+
+  // Now sample the channels of each AnimControl in turn, and either store or
+  // accumulate the results.  The bound tables were validated above.  If
+  // nothing has moved on, the joints keep the values they already have.
+  for (cbi = blend.begin(); needs_sample && cbi != blend.end(); ++cbi) {
+    AnimControl *control = (*cbi).first;
+    PN_stdfloat effect = (*cbi).second;
+    int channel_index = control->get_channel_index();
+    if (channel_index < 0) {
+      continue;
+    }
+    BoundAnim &bound = _bound_anims[channel_index];
+
+    PN_stdfloat e0 = effect;
+    PN_stdfloat e1 = 0.0f;
+    double frac = 0.0;
+    if (frame_blend_flag) {
+      frac = control->get_frac();
+      e0 = effect * (1.0f - (PN_stdfloat)frac);
+      e1 = effect * (PN_stdfloat)frac;
+    }
+    bound._last_frame = control->get_frame();
+    bound._last_frac = frac;
+
+    for (int pass = 0; pass < (frame_blend_flag && any_blend ? 2 : 1); ++pass) {
+      sample(bound, pass == 0 ? control->get_frame() : control->get_next_frame());
+      PN_stdfloat e = (pass == 0) ? e0 : e1;
+
+      for (int j = 0; j < num_joints; ++j) {
+        if (bound._state[j] != CS_table) {
+          continue;
+        }
+
+        if (_mode[j] == JM_direct) {
+          compose_joint(j, _values[j]);
+
+        } else if (_mode[j] == JM_blend) {
+          if (blend_type == PartBundle::BT_componentwise) {
+            for (int k = 0; k < num_matrix_components; ++k) {
+              _accum[k * num_joints + j] += _components[k * num_joints + j] * e;
+            }
+          } else {
+            LMatrix4 v;
+            compose_joint(j, v);
+            _values[j] += v * e;
+          }
+          if (pass == 0) {
+            _net_effect[j] += effect;
+          }
+        }
+      }
+    }
+  }
+
+  // Finish off the blends, and evaluate the joints we couldn't handle.
+  for (int j = 0; j < num_joints; ++j) {
+    CharacterJoint *joint = _joints[j]._joint;
+    switch ((JointMode)_mode[j]) {
+    case JM_direct:
+      if (!needs_sample) {
+        _values[j] = joint->_value;
+      }
+      break;
+
+    case JM_blend:
+      if (!needs_sample) {
+        _values[j] = joint->_value;
+      } else if (blend_type == PartBundle::BT_componentwise) {
+        PN_stdfloat components[num_matrix_components];
+        for (int k = 0; k < num_matrix_components; ++k) {
+          components[k] = _accum[k * num_joints + j] / _net_effect[j];
+        }
+        compose_matrix(_values[j], components);
+      } else {
+        _values[j] /= _net_effect[j];
+      }
+      break;
+
+    case JM_fallback:
+      {
+        LMatrix4 orig_value = joint->_value;
+        joint->get_blend_value(root);
+        _values[j] = joint->_value;
+        joint->_value = orig_value;
+      }
+      break;
+    }
+  }
+
+  // Compose the net transforms.  Each joint follows its parent, so the
+  // parent's net transform is always ready by the time we need it.
+  const LMatrix4 &root_xform = root->get_root_xform();
+  for (int j = 0; j < num_joints; ++j) {
+    const Joint &entry = _joints[j];
+    CharacterJoint *joint = entry._joint;
+
+    bool self_changed = anim_changed || _values[j] != joint->_value;
+    bool parent_changed = (entry._changed_parent >= 0 &&
+                           _changed[entry._changed_parent] != 0);
+    bool net_changed = false;
+
+    if (entry._parent >= 0) {
+      if (parent_changed || self_changed) {
+        _nets[j] = _values[j] * _nets[entry._parent];
+        net_changed = true;
+      } else {
+        _nets[j] = joint->_net_transform;
+      }
+    } else {
+      if (self_changed) {
+        _nets[j] = _values[j] * root_xform;
+        net_changed = true;
+      } else {
+        _nets[j] = joint->_net_transform;
+      }
+    }
+
+    _self_changed[j] = self_changed;
+    _changed[j] = (self_changed || parent_changed);
+    _net_changed[j] = net_changed;
+  }
+
+  // Finally, store the results in the joints, and let them notify whatever
+  // depends on them.
+  bool any_changed = false;
+  for (int j = 0; j < num_joints; ++j) {
+    bool self_changed = (_self_changed[j] != 0);
+    bool net_changed = (_net_changed[j] != 0);
+    if (self_changed || net_changed) {
+      CharacterJoint *joint = _joints[j]._joint;
+      joint->_value = _values[j];
+      joint->_net_transform = _nets[j];
+      joint->update_dependents(self_changed, net_changed, current_thread);
+      any_changed = true;
+    }
+  }
+
+  // The sliders and anything else that isn't a joint are updated in the
+  // usual way.
+  Others::const_iterator oi;
+  for (oi = _others.begin(); oi != _others.end(); ++oi) {
+    const Other &other = (*oi);
+    bool parent_changed = (other._changed_parent >= 0 &&
+                           _changed[other._changed_parent] != 0);
+    if (other._group->do_update(root, root_cdata, other._parent_group,
+                                parent_changed, anim_changed, current_thread)) {
+      any_changed = true;
+    }
+  }
+
+  return any_changed;
+}
+
+/**
+ * Recursively adds the joints below the indicated group.  parent is the
+ * index of the group if it is itself a joint, or -1 otherwise;
+ * changed_parent is the index of the nearest joint above the group.
+ */
+void CharacterJointArrays::
+r_build(PartGroup *group, int parent, int changed_parent) {
+  int num_children = group->get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    PartGroup *child = group->get_child(i);
+
+    if (child->is_character_joint()) {
+      Joint entry;
+      entry._joint = DCAST(CharacterJoint, child);
+      entry._parent_group = group;
+      entry._parent = parent;
+      entry._changed_parent = changed_parent;
+      int index = (int)_joints.size();
+      _joints.push_back(entry);
+      r_build(child, index, index);
+
+    } else if (child->is_of_type(MovingPartBase::get_class_type())) {
+      Other other;
+      other._group = child;
+      other._parent_group = group;
+      other._changed_parent = changed_parent;
+      _others.push_back(other);
+
+    } else {
+      r_build(child, -1, changed_parent);
+    }
+  }
+}
+
+/**
+ * Returns the channel tables bound to the indicated AnimControl, gathering
+ * them up from the joints if this is the first time the control's animation
+ * has been seen, or if any of its channels or tables have been replaced since
+ * then.
+ */
+CharacterJointArrays::BoundAnim &CharacterJointArrays::
+get_bound_anim(AnimControl *control) {
+  int channel_index = control->get_channel_index();
+  if (channel_index >= (int)_bound_anims.size()) {
+    _bound_anims.resize(channel_index + 1);
+  }
+
+  BoundAnim &bound = _bound_anims[channel_index];
+  if (bound._anim == control->get_anim() &&
+      bound._state.size() == _joints.size() &&
+      is_bound_current(bound, channel_index)) {
+    return bound;
+  }
+
+  // The channel index has been (re)assigned to a different animation since
+  // we last looked, or the animation has been modified.
+  size_t num_joints = _joints.size();
+  bound._anim = control->get_anim();
+  bound._channels.assign(num_joints, nullptr);
+  bound._state.assign(num_joints, CS_none);
+  bound._keep.clear();
+  bound._last_frame = -1;
+  bound._last_frac = 0.0;
+  for (int k = 0; k < num_matrix_components; ++k) {
+    bound._tables[k]._data.assign(num_joints, nullptr);
+    bound._tables[k]._size.assign(num_joints, 0);
+  }
+
+  for (size_t j = 0; j < num_joints; ++j) {
+    CharacterJoint *joint = _joints[j]._joint;
+    AnimChannelBase *channel = nullptr;
+    if (channel_index < (int)joint->_channels.size()) {
+      channel = joint->_channels[channel_index];
+    }
+    bound._channels[j] = channel;
+    if (channel == nullptr) {
+      continue;
+    }
+
+    if (!channel->is_exact_type(AnimChannelMatrixXfmTable::get_class_type())) {
+      bound._state[j] = CS_other;
+      continue;
+    }
+
+    AnimChannelMatrixXfmTable *xfm = DCAST(AnimChannelMatrixXfmTable, channel);
+    bound._state[j] = CS_table;
+    for (int k = 0; k < num_matrix_components; ++k) {
+      const CPTA_stdfloat &table = xfm->get_table_by_index(k);
+      if (!table.empty()) {
+        bound._tables[k]._data[j] = table.p();
+        bound._tables[k]._size[j] = (unsigned int)table.size();
+        bound._keep.push_back(table);
+      }
+    }
+  }
+
+  return bound;
+}
+
+/**
+ * Returns true if the joints are still bound to the same channels that the
+ * indicated BoundAnim was built from, and those channels still have the same
+ * tables, or false if it must be built again.
+ */
+bool CharacterJointArrays::
+is_bound_current(const BoundAnim &bound, int channel_index) const {
+  size_t num_joints = _joints.size();
+  for (size_t j = 0; j < num_joints; ++j) {
+    CharacterJoint *joint = _joints[j]._joint;
+    AnimChannelBase *channel = nullptr;
+    if (channel_index < (int)joint->_channels.size()) {
+      channel = joint->_channels[channel_index];
+    }
+    if (channel != bound._channels[j]) {
+      return false;
+    }
+
+    if (bound._state[j] == CS_table) {
+      const AnimChannelMatrixXfmTable *xfm = (const AnimChannelMatrixXfmTable *)channel;
+      for (int k = 0; k < num_matrix_components; ++k) {
+        const CPTA_stdfloat &table = xfm->get_table_by_index(k);
+        if (table.p() != bound._tables[k]._data[j] ||
+            table.size() != bound._tables[k]._size[j]) {
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Fills _components with the value of each matrix component of each joint at
+ * the indicated frame of the indicated animation.
+ */
+void CharacterJointArrays::
+sample(const BoundAnim &bound, int frame) {
+  size_t num_joints = _joints.size();
+  unsigned int uframe = (unsigned int)std::max(frame, 0);
+
+  for (int k = 0; k < num_matrix_components; ++k) {
+    const ComponentTables &tables = bound._tables[k];
+    const PN_stdfloat *const *data = tables._data.data();
+    const unsigned int *size = tables._size.data();
+    PN_stdfloat def = (PN_stdfloat)matrix_component_defaults[k];
+    PN_stdfloat *out = &_components[k * num_joints];
+
+    for (size_t j = 0; j < num_joints; ++j) {
+      out[j] = (size[j] != 0) ? data[j][uframe % size[j]] : def;
+    }
+  }
+}
+
+/**
+ * Composes the matrix of the nth joint from the components most recently
+ * stored by sample().
+ */
+void CharacterJointArrays::
+compose_joint(int n, LMatrix4 &mat) const {
+  size_t num_joints = _joints.size();
+  PN_stdfloat components[num_matrix_components];
+  for (int k = 0; k < num_matrix_components; ++k) {
+    components[k] = _components[k * num_joints + n];
+  }
+  compose_matrix(mat, components);
+}
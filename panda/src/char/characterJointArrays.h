@@ -0,0 +1,143 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file characterJointArrays.h
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#ifndef CHARACTERJOINTARRAYS_H
+#define CHARACTERJOINTARRAYS_H
+
+#include "pandabase.h"
+
+#include "partBundle.h"
+#include "referenceCount.h"
+#include "animBundle.h"
+#include "pta_stdfloat.h"
+#include "compose_matrix.h"
+#include "pvector.h"
+
+class CharacterJoint;
+
+/**
+ * A flattened, structure-of-arrays form of the joint hierarchy of a
+ * CharacterJointBundle, used when the bundle's flat_update flag is set.
+ *
+ * The joints are listed in parent-before-child order along with the index of
+ * each joint's parent, and the AnimChannelMatrixXfmTable channels that each
+ * bound AnimControl supplies are gathered into one array per matrix
+ * component.  The whole skeleton can then be sampled, blended and composed
+ * in a few tight loops, rather than by recursing through the PartGroup
+ * hierarchy and evaluating each channel through a chain of virtual calls.
+ *
+ * Joints that this cannot handle (for instance because they have a forced
+ * channel, or are bound to some other kind of channel) fall back to
+ * MovingPartMatrix::get_blend_value(), and parts other than joints are
+ * updated in the usual way.
+ */
+class EXPCL_PANDA_CHAR CharacterJointArrays : public ReferenceCount {
+public:
+  explicit CharacterJointArrays(PartGroup *root);
+
+  INLINE int get_num_joints() const;
+  INLINE CharacterJoint *get_joint(int n) const;
+  INLINE int get_parent(int n) const;
+
+  bool update(PartBundle *root, const CycleData *root_cdata,
+              const PartBundle::ChannelBlend &blend,
+              PartBundle::BlendType blend_type, bool frame_blend_flag,
+              bool anim_changed, Thread *current_thread);
+
+private:
+  void r_build(PartGroup *group, int parent, int changed_parent);
+
+  // The tables of one component of the XfmTable channels of one AnimControl,
+  // one entry per joint.  A size of zero means that the table is empty, and
+  // the component takes its default value.
+  class ComponentTables {
+  public:
+    pvector<const PN_stdfloat *> _data;
+    pvector<unsigned int> _size;
+  };
+
+  enum ChannelState {
+    CS_none,
+    CS_table,
+    CS_other,
+  };
+
+  // Everything that is needed to sample the channels of one AnimControl.
+  // The channel of each joint is recorded as well, so that we can tell when
+  // the channels or their tables have been replaced.  _last_frame and
+  // _last_frac are the point at which the tables were most recently sampled.
+  class BoundAnim {
+  public:
+    INLINE BoundAnim();
+
+    PT(AnimBundle) _anim;
+    pvector<AnimChannelBase *> _channels;
+    pvector<unsigned char> _state;
+    ComponentTables _tables[num_matrix_components];
+    pvector<CPTA_stdfloat> _keep;
+    int _last_frame;
+    double _last_frac;
+  };
+
+  BoundAnim &get_bound_anim(AnimControl *control);
+  bool is_bound_current(const BoundAnim &bound, int channel_index) const;
+  void sample(const BoundAnim &bound, int frame);
+  void compose_joint(int n, LMatrix4 &mat) const;
+
+  enum JointMode {
+    JM_direct,
+    JM_blend,
+    JM_fallback,
+  };
+
+  class Joint {
+  public:
+    CharacterJoint *_joint;
+    PartGroup *_parent_group;
+    int _parent;
+    int _changed_parent;
+  };
+  typedef pvector<Joint> Joints;
+  Joints _joints;
+
+  // The subtrees that are not joints, and which are updated with do_update().
+  class Other {
+  public:
+    PartGroup *_group;
+    PartGroup *_parent_group;
+    int _changed_parent;
+  };
+  typedef pvector<Other> Others;
+  Others _others;
+
+  // The bound channels, indexed by AnimControl::get_channel_index().
+  typedef pvector<BoundAnim> BoundAnims;
+  BoundAnims _bound_anims;
+
+  // Scratch arrays, one entry per joint (or one entry per joint for each
+  // matrix component, for _components and _accum).
+  pvector<unsigned char> _mode;
+  pvector<int> _num_channels;
+  pvector<PN_stdfloat> _components;
+  pvector<PN_stdfloat> _accum;
+  pvector<PN_stdfloat> _net_effect;
+  pvector<LMatrix4> _values;
+  pvector<LMatrix4> _nets;
+  pvector<unsigned char> _self_changed;
+  pvector<unsigned char> _changed;
+  pvector<unsigned char> _net_changed;
+};
+
+#include "characterJointArrays.I"
+
+#endif
@@ -16,6 +16,7 @@
 #include "datagramIterator.h"
 #include "bamReader.h"
 #include "bamWriter.h"
+#include "config_char.h"
 
 TypeHandle CharacterJointBundle::_type_handle;
 
@@ -24,7 +25,10 @@ TypeHandle CharacterJointBundle::_type_handle;
  * Character node will automatically create one for itself.
  */
 CharacterJointBundle::
-CharacterJointBundle(const std::string &name) : PartBundle(name) {
+CharacterJointBundle(const std::string &name) :
+  PartBundle(name),
+  _flat_update(flat_joint_update)
+{
 }
 
 /**
@@ -34,6 +38,28 @@ CharacterJointBundle::
 ~CharacterJointBundle() {
 }
 
+/**
+ * Updates the joints of the bundle, either recursively or, if flat_update
+ * has been enabled, through the flattened CharacterJointArrays.
+ */
+bool CharacterJointBundle::
+do_update(PartBundle *root, const CycleData *root_cdata, PartGroup *parent,
+          bool parent_changed, bool anim_changed, Thread *current_thread) {
+  if (!_flat_update || root != this) {
+    return PartBundle::do_update(root, root_cdata, parent, parent_changed,
+                                 anim_changed, current_thread);
+  }
+
+  if (_joint_arrays == nullptr) {
+    _joint_arrays = new CharacterJointArrays(this);
+  }
+
+  const CData *cdata = (const CData *)root_cdata;
+  return _joint_arrays->update(this, root_cdata, cdata->_blend,
+                               cdata->_blend_type, cdata->_frame_blend_flag,
+                               anim_changed, current_thread);
+}
+
 /**
  * Allocates and returns a new copy of the node.  Children are not copied, but
  * see copy_subgraph().
@@ -19,6 +19,7 @@
 #include "partBundle.h"
 #include "partGroup.h"
 #include "animControl.h"
+#include "characterJointArrays.h"
 
 class Character;
 
@@ -36,6 +37,15 @@ PUBLISHED:
 PUBLISHED:
   INLINE Character *get_node(int n) const;
 
+  INLINE void set_flat_update(bool flat_update);
+  INLINE bool get_flat_update() const;
+  MAKE_PROPERTY(flat_update, get_flat_update, set_flat_update);
+
+public:
+  virtual bool do_update(PartBundle *root, const CycleData *root_cdata,
+                         PartGroup *parent, bool parent_changed,
+                         bool anim_changed, Thread *current_thread);
+
 protected:
   virtual PartGroup *make_copy() const;
   virtual void add_node(PartBundleNode *node);
@@ -44,6 +54,9 @@ protected:
 private:
   void r_set_character(PartGroup *group, Character *character);
 
+  bool _flat_update;
+  PT(CharacterJointArrays) _joint_arrays;
+
 public:
   static void register_with_read_factory();
 
@@ -40,6 +40,15 @@ ConfigVariableBool even_animation
           "The default is to compute vertices only when they need to be "
           "computed, which can lead to an uneven frame rate."));
 
+ConfigVariableBool flat_joint_update
+("flat-joint-update", false,
+ PRC_DESC("Set this true to update the joints of each character through a "
+          "flattened copy of its joint hierarchy, which evaluates all of "
+          "the joints' animation tables and net transforms in a few tight "
+          "loops.  This is faster for large skeletons and large numbers of "
+          "characters.  It may also be enabled per character with "
+          "CharacterJointBundle::set_flat_update()."));
+
 
 /**
  * Initializes the library.  This must be called at least once before any of
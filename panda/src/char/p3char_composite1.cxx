@@ -1,5 +1,6 @@
 #include "config_char.cxx"
 #include "character.cxx"
 #include "characterJoint.cxx"
+#include "characterJointArrays.cxx"
 #include "characterJointBundle.cxx"
 
@@ -0,0 +1,264 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file collisionBVH.cxx
+ * @author jmarsh
+ * @date 2026-10-15
+ */
+
+#include "collisionBVH.h"
+#include "boundingVolume.h"
+#include "finiteBoundingVolume.h"
+#include "boundingLine.h"
+
+#include <algorithm>
+
+// The maximum number of items stored in a single leaf.
+static const int max_leaf_items = 4;
+
+namespace {
+  // Orders item indices by the center of their boxes along one axis.
+  class CompareCenter {
+  public:
+    CompareCenter(const pvector<LPoint3> &centers, int axis) :
+      _centers(centers), _axis(axis) {}
+
+    bool operator () (int a, int b) const {
+      return _centers[a][_axis] < _centers[b][_axis];
+    }
+
+    const pvector<LPoint3> &_centers;
+    int _axis;
+  };
+}
+
+/**
+ *
+ */
+CollisionBVH::
+CollisionBVH() : _built(false) {
+}
+
+/**
+ * Adds a new item whose extents are given by the indicated bounding volume.
+ * The box is padded very slightly, so that the hierarchy never rejects
+ * something that the volume itself would have accepted.
+ */
+void CollisionBVH::
+add_item(const BoundingVolume *volume) {
+  if (volume == nullptr || volume->is_infinite()) {
+    add_unbounded_item();
+    return;
+  }
+  if (volume->is_empty()) {
+    add_empty_item();
+    return;
+  }
+
+  const FiniteBoundingVolume *fbv = volume->as_finite_bounding_volume();
+  if (fbv == nullptr) {
+    // Lines, planes and the like extend indefinitely.
+    add_unbounded_item();
+    return;
+  }
+
+  LPoint3 min_point = fbv->get_min();
+  LPoint3 max_point = fbv->get_max();
+  LVector3 pad = (max_point - min_point) * 0.0001f;
+  pad += LVector3(0.0001f);
+  add_item(min_point - pad, max_point + pad);
+}
+
+/**
+ * Builds the hierarchy from the items that have been added.  No more items
+ * may be added after this call.
+ */
+void CollisionBVH::
+build() {
+  nassertv(!_built);
+  _built = true;
+
+  _order.clear();
+  _unbounded.clear();
+  _nodes.clear();
+
+  int num_items = (int)_items.size();
+  for (int i = 0; i < num_items; ++i) {
+    switch (_items[i]._type) {
+    case IT_bounded:
+      _order.push_back(i);
+      break;
+
+    case IT_unbounded:
+      _unbounded.push_back(i);
+      break;
+
+    case IT_empty:
+      break;
+    }
+  }
+
+  if (!_order.empty()) {
+    _nodes.reserve(_order.size() * 2 / max_leaf_items + 1);
+    pvector<LPoint3> centers(_items.size());
+    for (int i : _order) {
+      centers[i] = (_items[i]._min + _items[i]._max) * 0.5f;
+    }
+    _nodes.push_back(Node());
+    r_build(0, 0, (int)_order.size(), centers);
+  }
+}
+
+/**
+ * Fills result with the indices of all the items whose box might intersect
+ * the indicated volume, in ascending order.  Returns false if the volume is
+ * of a type that cannot be tested against the hierarchy, in which case the
+ * caller should fall back to testing all items.
+ */
+bool CollisionBVH::
+find_overlaps(const GeometricBoundingVolume *volume,
+              pvector<int> &result) const {
+  nassertr(_built, false);
+  result.clear();
+
+  if (volume == nullptr || volume->is_infinite()) {
+    return false;
+  }
+  if (volume->is_empty()) {
+    return true;
+  }
+
+  LPoint3 qmin, qmax, origin;
+  LVector3 dir;
+  bool is_line = false;
+
+  const FiniteBoundingVolume *fbv = volume->as_finite_bounding_volume();
+  if (fbv != nullptr) {
+    qmin = fbv->get_min();
+    qmax = fbv->get_max();
+  } else if (volume->is_of_type(BoundingLine::get_class_type())) {
+    const BoundingLine *line = (const BoundingLine *)volume;
+    origin = line->get_point_a();
+    dir = line->get_point_b() - origin;
+    is_line = true;
+  } else {
+    return false;
+  }
+
+  if (!_nodes.empty()) {
+    int stack[64];
+    int sp = 0;
+    stack[sp++] = 0;
+
+    while (sp > 0) {
+      const Node &node = _nodes[stack[--sp]];
+      bool hit = is_line
+        ? overlaps_line(node._min, node._max, origin, dir)
+        : overlaps_box(node._min, node._max, qmin, qmax);
+      if (!hit) {
+        continue;
+      }
+
+      if (node._count > 0) {
+        for (int i = node._first; i < node._first + node._count; ++i) {
+          const Item &item = _items[_order[i]];
+          bool item_hit = is_line
+            ? overlaps_line(item._min, item._max, origin, dir)
+            : overlaps_box(item._min, item._max, qmin, qmax);
+          if (item_hit) {
+            result.push_back(_order[i]);
+          }
+        }
+      } else {
+        nassertr(sp + 2 <= 64, false);
+        int index = (int)(&node - &_nodes[0]);
+        stack[sp++] = node._second;
+        stack[sp++] = index + 1;
+      }
+    }
+  }
+
+  result.insert(result.end(), _unbounded.begin(), _unbounded.end());
+  std::sort(result.begin(), result.end());
+  return true;
+}
+
+/**
+ *
+ */
+void CollisionBVH::
+output(std::ostream &out) const {
+  out << "CollisionBVH, " << _items.size() << " items, "
+      << _nodes.size() << " nodes";
+  if (!_unbounded.empty()) {
+    out << ", " << _unbounded.size() << " unbounded";
+  }
+}
+
+/**
+ * Recursively fills in the node with the indicated index to contain the
+ * items in the range [begin, end) of _order.  centers contains the center of
+ * each item's box.
+ */
+void CollisionBVH::
+r_build(int node_index, int begin, int end, const pvector<LPoint3> &centers) {
+  LPoint3 min_point = _items[_order[begin]]._min;
+  LPoint3 max_point = _items[_order[begin]]._max;
+  LPoint3 cmin = centers[_order[begin]];
+  LPoint3 cmax = cmin;
+  for (int i = begin + 1; i < end; ++i) {
+    const Item &item = _items[_order[i]];
+    const LPoint3 &center = centers[_order[i]];
+    for (int j = 0; j < 3; ++j) {
+      min_point[j] = std::min(min_point[j], item._min[j]);
+      max_point[j] = std::max(max_point[j], item._max[j]);
+      cmin[j] = std::min(cmin[j], center[j]);
+      cmax[j] = std::max(cmax[j], center[j]);
+    }
+  }
+
+  _nodes[node_index]._min = min_point;
+  _nodes[node_index]._max = max_point;
+
+  LVector3 extent = cmax - cmin;
+  int axis = 0;
+  if (extent[1] > extent[axis]) {
+    axis = 1;
+  }
+  if (extent[2] > extent[axis]) {
+    axis = 2;
+  }
+
+  // Stop splitting if there are few enough items, or if they all share the
+  // same center, in which case splitting them gains nothing.
+  if (end - begin <= max_leaf_items || extent[axis] <= 0.0f) {
+    _nodes[node_index]._first = begin;
+    _nodes[node_index]._count = end - begin;
+    _nodes[node_index]._second = 0;
+    return;
+  }
+
+  // Split at the median along the longest axis, which keeps the tree
+  // balanced so that its depth stays logarithmic.
+  int mid = begin + (end - begin) / 2;
+  std::nth_element(_order.begin() + begin, _order.begin() + mid,
+                   _order.begin() + end, CompareCenter(centers, axis));
+
+  _nodes[node_index]._first = 0;
+  _nodes[node_index]._count = 0;
+
+  int first_child = (int)_nodes.size();
+  nassertv(first_child == node_index + 1);
+  _nodes.push_back(Node());
+  r_build(first_child, begin, mid, centers);
+
+  int second_child = (int)_nodes.size();
+  _nodes[node_index]._second = second_child;
+  _nodes.push_back(Node());
+  r_build(second_child, mid, end, centers);
+}
@@ -0,0 +1,103 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file collisionBVH.h
+ * @author jmarsh
+ * @date 2026-10-15
+ */
+
+#ifndef COLLISIONBVH_H
+#define COLLISIONBVH_H
+
+#include "pandabase.h"
+#include "referenceCount.h"
+#include "luse.h"
+#include "pvector.h"
+
+#include <float.h>
+
+class BoundingVolume;
+class GeometricBoundingVolume;
+
+/**
+ * A static bounding volume hierarchy of axis-aligned boxes, used by the
+ * CollisionTraverser to quickly find the collision solids of a large
+ * CollisionNode (or the triangles of a large Geom) that might intersect a
+ * particular collider, without having to test each one individually.
+ *
+ * Items are identified by the order in which they were added.  Items with an
+ * infinite bounding volume are always reported as candidates; items with an
+ * empty bounding volume are never reported.
+ */
+class EXPCL_PANDA_COLLIDE CollisionBVH : public ReferenceCount {
+public:
+  CollisionBVH();
+
+  INLINE void add_item(const LPoint3 &min_point, const LPoint3 &max_point);
+  void add_item(const BoundingVolume *volume);
+  INLINE void add_unbounded_item();
+  INLINE void add_empty_item();
+  INLINE int get_num_items() const;
+
+  void build();
+
+  bool find_overlaps(const GeometricBoundingVolume *volume,
+                     pvector<int> &result) const;
+
+  void output(std::ostream &out) const;
+
+private:
+  void r_build(int node_index, int begin, int end,
+               const pvector<LPoint3> &centers);
+  INLINE bool overlaps_box(const LPoint3 &min_point, const LPoint3 &max_point,
+                           const LPoint3 &qmin, const LPoint3 &qmax) const;
+  INLINE bool overlaps_line(const LPoint3 &min_point, const LPoint3 &max_point,
+                            const LPoint3 &origin, const LVector3 &dir) const;
+
+  enum ItemType {
+    IT_bounded,
+    IT_unbounded,
+    IT_empty,
+  };
+
+  class Item {
+  public:
+    LPoint3 _min;
+    LPoint3 _max;
+    ItemType _type;
+  };
+  typedef pvector<Item> Items;
+  Items _items;
+
+  // Internal nodes have _count == 0, their first child immediately follows
+  // them and the second child is at index _second.  Leaves reference _count
+  // entries of _order starting at _first.
+  class Node {
+  public:
+    LPoint3 _min;
+    LPoint3 _max;
+    int _first;
+    int _count;
+    int _second;
+  };
+  typedef pvector<Node> Nodes;
+  Nodes _nodes;
+
+  pvector<int> _order;
+  pvector<int> _unbounded;
+  bool _built;
+};
+
+INLINE std::ostream &operator << (std::ostream &out, const CollisionBVH &bvh) {
+  bvh.output(out);
+  return out;
+}
+
+#include "collisionBVH.I"
+
+#endif
@@ -117,7 +117,8 @@ public:
 
 private:
   INLINE void test_intersection(CollisionHandler *record,
-                                const CollisionTraverser *trav) const;
+                                const CollisionTraverser *trav,
+                                CollisionLevelCounts *counts) const;
   void check_clip_planes();
 
   CPT(CollisionSolid) _from;
@@ -21,6 +21,19 @@ PStatCollector CollisionLevelStateBase::_node_volume_pcollector("Collision Volum
 
 TypeHandle CollisionLevelStateBase::_type_handle;
 
+/**
+ * Adds the counted levels to their collectors, and resets the counts.  This
+ * must be called by the thread that started the traversal.
+ */
+void CollisionLevelCounts::
+apply() {
+  Levels::const_iterator li;
+  for (li = _levels.begin(); li != _levels.end(); ++li) {
+    (*li).first->add_level((*li).second);
+  }
+  _levels.clear();
+}
+
 /**
  *
  */
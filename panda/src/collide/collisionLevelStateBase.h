@@ -23,6 +23,7 @@
 #include "workingNodePath.h"
 #include "pointerTo.h"
 #include "plist.h"
+#include "pvector.h"
 #include "pStatCollector.h"
 #include "bitMask.h"
 #include "lvector3.h"
@@ -33,6 +34,23 @@
 class CollisionSolid;
 class CollisionNode;
 
+/**
+ * Counts the PStat levels for one group of colliders while the
+ * CollisionTraverser is traversing several groups in parallel.  The counts
+ * are added to the collectors afterwards, by the thread that started the
+ * traversal, since the collectors may not be modified from several threads.
+ */
+class CollisionLevelCounts {
+public:
+  INLINE static void add_level(CollisionLevelCounts *counts,
+                               PStatCollector &collector, int increment);
+  void apply();
+
+private:
+  typedef pvector<std::pair<PStatCollector *, int> > Levels;
+  Levels _levels;
+};
+
 /**
  * This is the state information the CollisionTraverser retains for each level
  * during traversal.
@@ -73,6 +91,9 @@ public:
   INLINE void set_include_mask(CollideMask include_mask);
   INLINE CollideMask get_include_mask() const;
 
+  INLINE void set_counts(CollisionLevelCounts *counts);
+  INLINE CollisionLevelCounts *get_counts() const;
+
 protected:
   WorkingNodePath _node_path;
 
@@ -84,6 +105,8 @@ protected:
   BoundingVolumes _local_bounds;
   BoundingVolumes _parent_bounds;
 
+  CollisionLevelCounts *_counts;
+
   static PStatCollector _node_volume_pcollector;
 
 public:
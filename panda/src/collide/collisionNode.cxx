@@ -29,6 +29,7 @@
 #include "boundingSphere.h"
 #include "boundingBox.h"
 #include "config_mathutil.h"
+#include "lightMutexHolder.h"
 
 TypeHandle CollisionNode::_type_handle;
 
@@ -323,6 +324,46 @@ compute_internal_bounds(CPT(BoundingVolume) &internal_bounds,
   internal_vertices = 0;
 }
 
+/**
+ * Returns a bounding volume hierarchy over the solids of this node, for use
+ * by the CollisionTraverser, or NULL if the node does not have enough solids
+ * to make this worthwhile (see collision-bvh-min-solids).  The hierarchy is
+ * built the first time it is requested, and rebuilt after the set of solids
+ * has been modified.
+ */
+CPT(CollisionBVH) CollisionNode::
+get_solid_bvh(Thread *current_thread) const {
+  if (collision_bvh_min_solids <= 0 ||
+      _solids.size() < (size_t)collision_bvh_min_solids) {
+    return nullptr;
+  }
+
+  // Any change to the solids marks the internal bounds stale, so we can use
+  // the identity of the internal bounds to tell whether we are out of date.
+  CPT(BoundingVolume) bounds = get_internal_bounds(current_thread);
+
+  LightMutexHolder holder(_bvh_lock);
+  if (_bvh == nullptr || _bvh_bounds != bounds ||
+      _bvh->get_num_items() != (int)_solids.size()) {
+    PT(CollisionBVH) bvh = new CollisionBVH;
+    Solids::const_iterator si;
+    for (si = _solids.begin(); si != _solids.end(); ++si) {
+      CPT(CollisionSolid) solid = (*si).get_read_pointer(current_thread);
+      CPT(BoundingVolume) volume = solid->get_bounds();
+      bvh->add_item(volume);
+    }
+    bvh->build();
+
+    if (collide_cat.is_debug()) {
+      collide_cat.debug()
+        << "Built " << *bvh << " for " << *this << "\n";
+    }
+    _bvh = bvh;
+    _bvh_bounds = bounds;
+  }
+  return _bvh;
+}
+
 /**
  * Returns a RenderState for rendering the ghosted collision solid that
  * represents the previous frame's position, for those collision nodes that
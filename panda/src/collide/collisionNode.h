@@ -17,9 +17,11 @@
 #include "pandabase.h"
 
 #include "collisionSolid.h"
+#include "collisionBVH.h"
 
 #include "collideMask.h"
 #include "pandaNode.h"
+#include "lightMutex.h"
 
 /**
  * A node in the scene graph that can hold any number of CollisionSolids.
@@ -78,6 +80,9 @@ PUBLISHED:
   INLINE static CollideMask get_default_collide_mask();
   MAKE_PROPERTY(default_collide_mask, get_default_collide_mask);
 
+public:
+  CPT(CollisionBVH) get_solid_bvh(Thread *current_thread = Thread::get_current_thread()) const;
+
 protected:
   virtual void compute_internal_bounds(CPT(BoundingVolume) &internal_bounds,
                                        int &internal_vertices,
@@ -95,6 +100,12 @@ private:
   typedef pvector< COWPT(CollisionSolid) > Solids;
   Solids _solids;
 
+  // The hierarchy over _solids, built on demand.  It is rebuilt whenever the
+  // internal bounds it was built for have been recomputed.
+  mutable LightMutex _bvh_lock;
+  mutable CPT(CollisionBVH) _bvh;
+  mutable CPT(BoundingVolume) _bvh_bounds;
+
   friend class CollisionTraverser;
 
 public:
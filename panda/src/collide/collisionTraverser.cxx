@@ -35,6 +35,7 @@
 #include "nodePath.h"
 #include "pStatTimer.h"
 #include "indent.h"
+#include "lightMutexHolder.h"
 
 #include <algorithm>
 
@@ -45,9 +46,107 @@ PStatCollector CollisionTraverser::_collisions_pcollector("App:Collisions");
 PStatCollector CollisionTraverser::_cnode_volume_pcollector("Collision Volumes:CollisionNode");
 PStatCollector CollisionTraverser::_gnode_volume_pcollector("Collision Volumes:GeomNode");
 PStatCollector CollisionTraverser::_geom_volume_pcollector("Collision Volumes:Geom");
+PStatCollector CollisionTraverser::_bvh_pcollector("Collision Volumes:BVH skipped");
+
+PStatCollector CollisionTraverser::_parallel_pcollector("App:Collisions:Parallel");
 
 TypeHandle CollisionTraverser::_type_handle;
 
+/**
+ * Stands in for a collider's handler while the colliders are being traversed
+ * in parallel.  It stores each entry, along with the real handler, in the
+ * list of entries for the collider's pass.
+ */
+class DeferredCollisionHandler : public CollisionHandler {
+public:
+  class Entry {
+  public:
+    CollisionHandler *_target;
+    PT(CollisionEntry) _entry;
+
+    // The position of the from solid among all of the colliders.
+    int _solid;
+
+    // These are filled in after the traversal, to put the entries back in
+    // the order in which the serial traversal finds them.
+    int _serial_pass;
+    const pvector<int> *_visit_order;
+  };
+  typedef pvector<Entry> Entries;
+
+  DeferredCollisionHandler(CollisionHandler *target, Entries &entries) :
+    _target(target),
+    _entries(entries)
+  {
+    _wants_all_potential_collidees = target->wants_all_potential_collidees();
+  }
+
+  void add_solid(const CollisionSolid *solid, int index) {
+    _solids.push_back(Solids::value_type(solid, index));
+  }
+
+  virtual void add_entry(CollisionEntry *entry) {
+    Entry def;
+    def._target = _target;
+    def._entry = entry;
+    def._solid = 0;
+    def._serial_pass = 0;
+    def._visit_order = nullptr;
+
+    Solids::const_iterator si;
+    for (si = _solids.begin(); si != _solids.end(); ++si) {
+      if ((*si).first == entry->get_from()) {
+        def._solid = (*si).second;
+        break;
+      }
+    }
+    _entries.push_back(def);
+  }
+
+private:
+  CollisionHandler *_target;
+  Entries &_entries;
+
+  typedef pvector<std::pair<const CollisionSolid *, int> > Solids;
+  Solids _solids;
+};
+
+// This function object class is used in traverse_parallel(), below.  It
+// sorts the entries into the order in which the serial traversal finds them:
+// by pass, then by the node in depth-first order, then by the from solid.
+class SortByTraversalOrder {
+public:
+  inline bool operator () (const DeferredCollisionHandler::Entry &a,
+                           const DeferredCollisionHandler::Entry &b) const {
+    if (a._serial_pass != b._serial_pass) {
+      return a._serial_pass < b._serial_pass;
+    }
+    if (a._visit_order != b._visit_order) {
+      // A node is visited before its children, so a shorter path that is a
+      // prefix of the other one comes first.
+      return std::lexicographical_compare(
+        a._visit_order->begin(), a._visit_order->end(),
+        b._visit_order->begin(), b._visit_order->end());
+    }
+    return a._solid < b._solid;
+  }
+};
+
+/**
+ * Fills in the indicated vector with the index of each node on the path among
+ * its parent's children, from the top down.  The traversal visits the
+ * children of each node in order, so sorting these gives the order in which
+ * the nodes are visited.
+ */
+static void
+get_visit_order(const NodePath &path, pvector<int> &order) {
+  NodePath parent = path.get_parent();
+  if (!parent.is_empty()) {
+    get_visit_order(parent, order);
+    order.push_back(parent.node()->find_child(path.node()));
+  }
+}
+
 // This function object class is used in prepare_colliders(), below.
 class SortByColliderSort {
 public:
@@ -71,9 +170,11 @@ public:
 CollisionTraverser::
 CollisionTraverser(const std::string &name) :
   Namable(name),
+  _job_runner("collide-worker", collide_num_threads),
   _this_pcollector(_collisions_pcollector, name)
 {
   _respect_prev_transform = respect_prev_transform;
+  _geom_bvhs_purge_size = 0;
   #ifdef DO_COLLISION_RECORDING
   _recorder = nullptr;
   #endif
@@ -271,9 +372,21 @@ traverse(const NodePath &root) {
     (*hi).first->begin_group();
   }
 
+  // A CollisionRecorder can only be used from one thread at a time.
+#ifdef DO_COLLISION_RECORDING
+  bool allow_parallel = !has_recorder();
+#else
+  bool allow_parallel = true;
+#endif
+
   bool traversal_done = false;
-  if ((int)_colliders.size() <= CollisionLevelStateSingle::get_max_colliders() ||
-      !allow_collider_multiple) {
+  if (allow_parallel && _job_runner.is_parallel()) {
+    traversal_done = traverse_parallel(root);
+  }
+
+  if (!traversal_done &&
+      ((int)_colliders.size() <= CollisionLevelStateSingle::get_max_colliders() ||
+       !allow_collider_multiple)) {
     // Use the single-word-at-a-time traverser, which might need to make lots
     // of passes.
     LevelStatesSingle level_states;
@@ -346,6 +459,7 @@ traverse(const NodePath &root) {
   _cnode_volume_pcollector.flush_level();
   _gnode_volume_pcollector.flush_level();
   _geom_volume_pcollector.flush_level();
+  _bvh_pcollector.flush_level();
 
   CollisionSphere::flush_level();
   CollisionCapsule::flush_level();
@@ -487,12 +601,18 @@ write(std::ostream &out, int indent_level) const {
  *
  * This flavor uses a CollisionLevelStateSingle, which is limited to a certain
  * number of colliders per pass (typically 32).
+ *
+ * If max_colliders is nonzero, it further limits the number of colliders per
+ * pass, and the solids of each collider node are kept together in the same
+ * pass where possible.  In this case, the return value is false if a collider
+ * node had to be split across passes anyway.
  */
-void CollisionTraverser::
+bool CollisionTraverser::
 prepare_colliders_single(CollisionTraverser::LevelStatesSingle &level_states,
-                         const NodePath &root) {
+                         const NodePath &root, int max_per_pass) {
   int num_colliders = _colliders.size();
   int max_colliders = CollisionLevelStateSingle::get_max_colliders();
+  bool kept_together = true;
 
   CollisionLevelStateSingle level_state(root);
   // This reserve() call is only correct if there is exactly one solid per
@@ -533,6 +653,14 @@ prepare_colliders_single(CollisionTraverser::LevelStatesSingle &level_states,
       def._node_path = cnode_path;
 
       int num_solids = cnode->get_num_solids();
+      if (max_per_pass > 0 && level_state.get_num_colliders() != 0 &&
+          level_state.get_num_colliders() + num_solids > max_per_pass) {
+        // This node doesn't fit in the current pass; start a new one.
+        level_states.push_back(level_state);
+        level_state.clear();
+        level_state.reserve(min(num_remaining_colliders, max_colliders));
+      }
+
       for (int s = 0; s < num_solids; ++s) {
         CPT(CollisionSolid) collider = cnode->get_solid(s);
         def._collider = collider;
@@ -543,18 +671,132 @@ prepare_colliders_single(CollisionTraverser::LevelStatesSingle &level_states,
           level_states.push_back(level_state);
           level_state.clear();
           level_state.reserve(min(num_remaining_colliders, max_colliders));
+          if (s + 1 < num_solids) {
+            kept_together = false;
+          }
         }
       }
     }
 
     --num_remaining_colliders;
-    nassertv(num_remaining_colliders >= 0);
+    nassertr(num_remaining_colliders >= 0, false);
   }
 
   if (level_state.get_num_colliders() != 0) {
     level_states.push_back(level_state);
   }
-  nassertv(num_remaining_colliders == 0);
+  nassertr(num_remaining_colliders == 0, false);
+  return kept_together;
+}
+
+/**
+ * Performs the traversal with the colliders divided into small groups, which
+ * are traversed by the worker threads.  The detected collisions are handed to
+ * the handlers afterwards, in the order of the groups.  Returns false if the
+ * colliders could not be divided up, in which case nothing has been done.
+ */
+bool CollisionTraverser::
+traverse_parallel(const NodePath &root) {
+  LevelStatesSingle level_states;
+  int max_per_pass = std::max((int)collide_parallel_pass_size, 1);
+  if (!prepare_colliders_single(level_states, root, max_per_pass)) {
+    return false;
+  }
+
+  int num_passes = (int)level_states.size();
+  if (num_passes <= 1) {
+    for (int pass = 0; pass < num_passes; ++pass) {
+#ifdef DO_PSTATS
+      PStatTimer pass_timer(get_pass_collector(pass));
+#endif
+      r_traverse_single(level_states[pass], pass);
+    }
+    return true;
+  }
+
+  // Redirect every collider to a handler that stores the entries for its
+  // pass.  A collider node never spans more than one pass here.  The PStat
+  // levels are counted separately for each pass as well.
+  pvector<DeferredCollisionHandler::Entries> results(num_passes);
+  pvector<CollisionLevelCounts> counts(num_passes);
+  int num_solids = 0;
+  for (int pass = 0; pass < num_passes; ++pass) {
+    CollisionLevelStateSingle &level_state = level_states[pass];
+    level_state.set_counts(&counts[pass]);
+
+    int num_colliders = level_state.get_num_colliders();
+    for (int c = 0; c < num_colliders; ++c) {
+      NodePath collider = level_state.get_collider_node_path(c);
+      DeferredCollisionHandler *handler;
+      Colliders::const_iterator di = _deferred_colliders.find(collider);
+      if (di != _deferred_colliders.end()) {
+        handler = (DeferredCollisionHandler *)(*di).second.p();
+      } else {
+        Colliders::const_iterator ci = _colliders.find(collider);
+        nassertd(ci != _colliders.end()) continue;
+        handler = new DeferredCollisionHandler((*ci).second, results[pass]);
+        _deferred_colliders[collider] = handler;
+      }
+      handler->add_solid(level_state.get_collider(c), num_solids + c);
+    }
+    num_solids += num_colliders;
+
+    // Make sure the collectors exist before the workers need them.
+    get_pass_collector(pass);
+  }
+
+  {
+    PStatTimer timer(_parallel_pcollector);
+    _job_runner.run(num_passes, [&] (int pass, Thread *current_thread) {
+#ifdef DO_PSTATS
+      PStatTimer pass_timer(_pass_collectors[pass], current_thread);
+#endif
+      r_traverse_single(level_states[pass], pass);
+    });
+  }
+  _deferred_colliders.clear();
+
+  for (int pass = 0; pass < num_passes; ++pass) {
+    counts[pass].apply();
+  }
+
+  // The serial traversal makes one pass for each group of this many solids;
+  // see traverse().
+  int serial_pass_size = CollisionLevelStateSingle::get_max_colliders();
+  if (allow_collider_multiple && num_solids > serial_pass_size) {
+    if ((int)_colliders.size() <= CollisionLevelStateDouble::get_max_colliders() &&
+        num_solids <= CollisionLevelStateDouble::get_max_colliders()) {
+      serial_pass_size = num_solids;
+    } else {
+      serial_pass_size = CollisionLevelStateQuad::get_max_colliders();
+    }
+  }
+
+  // Hand the entries to the handlers in the order in which the serial
+  // traversal would have found them.
+  DeferredCollisionHandler::Entries entries;
+  for (int pass = 0; pass < num_passes; ++pass) {
+    entries.insert(entries.end(), results[pass].begin(), results[pass].end());
+  }
+
+  pmap<NodePath, pvector<int> > visit_orders;
+  DeferredCollisionHandler::Entries::iterator ei;
+  for (ei = entries.begin(); ei != entries.end(); ++ei) {
+    NodePath into_node_path = (*ei)._entry->get_into_node_path();
+    std::pair<pmap<NodePath, pvector<int> >::iterator, bool> result =
+      visit_orders.insert(pmap<NodePath, pvector<int> >::value_type(into_node_path, pvector<int>()));
+    if (result.second) {
+      get_visit_order(into_node_path, (*result.first).second);
+    }
+    (*ei)._visit_order = &(*result.first).second;
+    (*ei)._serial_pass = (*ei)._solid / serial_pass_size;
+  }
+  std::stable_sort(entries.begin(), entries.end(), SortByTraversalOrder());
+
+  for (ei = entries.begin(); ei != entries.end(); ++ei) {
+    (*ei)._target->add_entry((*ei)._entry);
+  }
+  return true;
 }
 
 /**
@@ -603,7 +845,8 @@ r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass) {
               entry,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
-              node_gbv);
+              node_gbv,
+              level_state.get_counts());
         }
       }
     }
@@ -648,7 +891,8 @@ r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass) {
               entry,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
-              node_gbv);
+              node_gbv,
+              level_state.get_counts());
         }
       }
     }
@@ -814,7 +1058,8 @@ r_traverse_double(CollisionLevelStateDouble &level_state, size_t pass) {
               entry,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
-              node_gbv);
+              node_gbv,
+              level_state.get_counts());
         }
       }
     }
@@ -859,7 +1104,8 @@ r_traverse_double(CollisionLevelStateDouble &level_state, size_t pass) {
               entry,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
-              node_gbv);
+              node_gbv,
+              level_state.get_counts());
         }
       }
     }
@@ -1025,7 +1271,8 @@ r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass) {
               entry,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
-              node_gbv);
+              node_gbv,
+              level_state.get_counts());
         }
       }
     }
@@ -1070,7 +1317,8 @@ r_traverse_quad(CollisionLevelStateQuad &level_state, size_t pass) {
               entry,
               level_state.get_parent_bound(c),
               level_state.get_local_bound(c),
-              node_gbv);
+              node_gbv,
+              level_state.get_counts());
         }
       }
     }
@@ -1121,12 +1369,13 @@ void CollisionTraverser::
 compare_collider_to_node(CollisionEntry &entry,
                          const GeometricBoundingVolume *from_parent_gbv,
                          const GeometricBoundingVolume *from_node_gbv,
-                         const GeometricBoundingVolume *into_node_gbv) {
+                         const GeometricBoundingVolume *into_node_gbv,
+                         CollisionLevelCounts *counts) {
   bool within_node_bounds = true;
   if (from_parent_gbv != nullptr &&
       into_node_gbv != nullptr) {
     within_node_bounds = (into_node_gbv->contains(from_parent_gbv) != 0);
-    _cnode_volume_pcollector.add_level(1);
+    CollisionLevelCounts::add_level(counts, _cnode_volume_pcollector, 1);
   }
 
   if (within_node_bounds) {
@@ -1148,26 +1397,36 @@ compare_collider_to_node(CollisionEntry &entry,
     // we just tested, is the same as the solid's bounding volume.)
     if (num_solids == 1) {
       entry._into = cnode->_solids[0].get_read_pointer(current_thread);
-      Colliders::const_iterator ci;
-      ci = _colliders.find(entry.get_from_node_path());
-      nassertv(ci != _colliders.end());
-      entry.test_intersection((*ci).second, this);
+      CollisionHandler *handler = get_collider_handler(entry.get_from_node_path());
+      nassertv(handler != nullptr);
+      entry.test_intersection(handler, this, counts);
+      return;
+    }
+
+    // If the node has many solids, ask its bounding volume hierarchy which
+    // of them could be near the collider.  These are still visited in the
+    // original order, so the results are the same as testing them all.
+    CPT(CollisionBVH) bvh;
+    pvector<int> candidates;
+    if (from_node_gbv != nullptr) {
+      bvh = cnode->get_solid_bvh(current_thread);
+    }
+    if (bvh != nullptr && bvh->find_overlaps(from_node_gbv, candidates)) {
+      CollisionLevelCounts::add_level(
+        counts, _bvh_pcollector, num_solids - (int)candidates.size());
+      pvector<int>::const_iterator ii;
+      for (ii = candidates.begin(); ii != candidates.end(); ++ii) {
+        nassertv(*ii < num_solids);
+        compare_collider_to_solid(
+          entry, cnode->_solids[*ii].get_read_pointer(current_thread),
+          from_node_gbv, counts);
+      }
     } else {
       CollisionNode::Solids::const_iterator si;
       for (si = cnode->_solids.begin(); si != cnode->_solids.end(); ++si) {
-        entry._into = (*si).get_read_pointer(current_thread);
-
-        // We should allow a collision test for solid into itself, because the
-        // solid might be simply instanced into multiple different
-        // CollisionNodes.  We are already filtering out tests for a
-        // CollisionNode into itself.
-        CPT(BoundingVolume) solid_bv = entry._into->get_bounds();
-        const GeometricBoundingVolume *solid_gbv = nullptr;
-        if (solid_bv->is_of_type(GeometricBoundingVolume::get_class_type())) {
-          solid_gbv = (const GeometricBoundingVolume *)solid_bv.p();
-        }
-
-        compare_collider_to_solid(entry, from_node_gbv, solid_gbv);
+        compare_collider_to_solid(
+          entry, (*si).get_read_pointer(current_thread),
+          from_node_gbv, counts);
       }
     }
   }
@@ -1180,12 +1439,13 @@ void CollisionTraverser::
 compare_collider_to_geom_node(CollisionEntry &entry,
                               const GeometricBoundingVolume *from_parent_gbv,
                               const GeometricBoundingVolume *from_node_gbv,
-                              const GeometricBoundingVolume *into_node_gbv) {
+                              const GeometricBoundingVolume *into_node_gbv,
+                              CollisionLevelCounts *counts) {
   bool within_node_bounds = true;
   if (from_parent_gbv != nullptr &&
       into_node_gbv != nullptr) {
     within_node_bounds = (into_node_gbv->contains(from_parent_gbv) != 0);
-    _gnode_volume_pcollector.add_level(1);
+    CollisionLevelCounts::add_level(counts, _gnode_volume_pcollector, 1);
   }
 
   if (within_node_bounds) {
@@ -1208,25 +1468,38 @@ compare_collider_to_geom_node(CollisionEntry &entry,
           DCAST_INTO_V(geom_gbv, geom_bv);
         }
 
-        compare_collider_to_geom(entry, geom, from_node_gbv, geom_gbv);
+        compare_collider_to_geom(entry, geom, from_node_gbv, geom_gbv, counts);
       }
     }
   }
 }
 
 /**
- *
+ * Tests the collider against the indicated solid of the CollisionNode in the
+ * entry, if it is within the solid's bounding volume.
  */
 void CollisionTraverser::
-compare_collider_to_solid(CollisionEntry &entry,
+compare_collider_to_solid(CollisionEntry &entry, const CollisionSolid *solid,
                           const GeometricBoundingVolume *from_node_gbv,
-                          const GeometricBoundingVolume *solid_gbv) {
+                          CollisionLevelCounts *counts) {
+  // We should allow a collision test for solid into itself, because the solid
+  // might be simply instanced into multiple different CollisionNodes.  We are
+  // already filtering out tests for a CollisionNode into itself.
+  entry._into = solid;
+
+  CPT(BoundingVolume) solid_bv = solid->get_bounds();
+  const GeometricBoundingVolume *solid_gbv = nullptr;
+  if (solid_bv->is_of_type(GeometricBoundingVolume::get_class_type())) {
+    solid_gbv = (const GeometricBoundingVolume *)solid_bv.p();
+  }
+
   bool within_solid_bounds = true;
   if (from_node_gbv != nullptr &&
       solid_gbv != nullptr) {
     within_solid_bounds = (solid_gbv->contains(from_node_gbv) != 0);
     #ifdef DO_PSTATS
-    ((CollisionSolid *)entry.get_into())->get_volume_pcollector().add_level(1);
+    CollisionLevelCounts::add_level(
+      counts, ((CollisionSolid *)entry.get_into())->get_volume_pcollector(), 1);
     #endif  // DO_PSTATS
 #ifndef NDEBUG
     if (collide_cat.is_spam()) {
@@ -1238,10 +1511,9 @@ compare_collider_to_solid(CollisionEntry &entry,
 #endif  // NDEBUG
   }
   if (within_solid_bounds) {
-    Colliders::const_iterator ci;
-    ci = _colliders.find(entry.get_from_node_path());
-    nassertv(ci != _colliders.end());
-    entry.test_intersection((*ci).second, this);
+    CollisionHandler *handler = get_collider_handler(entry.get_from_node_path());
+    nassertv(handler != nullptr);
+    entry.test_intersection(handler, this, counts);
   }
 }
 
@@ -1251,21 +1523,52 @@ compare_collider_to_solid(CollisionEntry &entry,
 void CollisionTraverser::
 compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
                          const GeometricBoundingVolume *from_node_gbv,
-                         const GeometricBoundingVolume *geom_gbv) {
+                         const GeometricBoundingVolume *geom_gbv,
+                         CollisionLevelCounts *counts) {
   bool within_geom_bounds = true;
   if (from_node_gbv != nullptr &&
       geom_gbv != nullptr) {
     within_geom_bounds = (geom_gbv->contains(from_node_gbv) != 0);
-    _geom_volume_pcollector.add_level(1);
+    CollisionLevelCounts::add_level(counts, _geom_volume_pcollector, 1);
   }
   if (within_geom_bounds) {
-    Colliders::const_iterator ci;
-    ci = _colliders.find(entry.get_from_node_path());
-    nassertv(ci != _colliders.end());
+    CollisionHandler *handler = get_collider_handler(entry.get_from_node_path());
+    nassertv(handler != nullptr);
 
     if (geom->get_primitive_type() == Geom::PT_polygons) {
       Thread *current_thread = Thread::get_current_thread();
       CPT(GeomVertexData) data = geom->get_animated_vertex_data(true, current_thread);
+
+      // For a large Geom, use the cached hierarchy over its triangles to
+      // find the ones near the collider.
+      if (from_node_gbv != nullptr) {
+        CPT(GeomBVH) geom_bvh = get_geom_bvh(geom, data, current_thread);
+        pvector<int> candidates;
+        if (geom_bvh != nullptr &&
+            geom_bvh->_bvh->find_overlaps(from_node_gbv, candidates)) {
+          CollisionLevelCounts::add_level(
+            counts, _bvh_pcollector,
+            geom_bvh->_bvh->get_num_items() - (int)candidates.size());
+          pvector<int>::const_iterator ii;
+          for (ii = candidates.begin(); ii != candidates.end(); ++ii) {
+            const LPoint3 *v = &geom_bvh->_vertices[(*ii) * 3];
+
+            BoundingSphere sphere;
+            sphere.around(v, v + 3);
+#ifdef DO_PSTATS
+            CollisionLevelCounts::add_level(
+              counts, CollisionGeom::_volume_pcollector, 1);
+#endif  // DO_PSTATS
+            if (sphere.contains(from_node_gbv) != 0) {
+              PT(CollisionGeom) cgeom = new CollisionGeom(v[0], v[1], v[2]);
+              entry._into = cgeom;
+              entry.test_intersection(handler, this, counts);
+            }
+          }
+          return;
+        }
+      }
+
       GeomVertexReader vertex(data, InternalName::get_vertex());
 
       int num_primitives = geom->get_num_primitives();
@@ -1296,13 +1599,14 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
                 sphere.around(v, v + 3);
                 within_solid_bounds = (sphere.contains(from_node_gbv) != 0);
 #ifdef DO_PSTATS
-                CollisionGeom::_volume_pcollector.add_level(1);
+                CollisionLevelCounts::add_level(
+                  counts, CollisionGeom::_volume_pcollector, 1);
 #endif  // DO_PSTATS
               }
               if (within_solid_bounds) {
                 PT(CollisionGeom) cgeom = new CollisionGeom(v[0], v[1], v[2]);
                 entry._into = cgeom;
-                entry.test_intersection((*ci).second, this);
+                entry.test_intersection(handler, this, counts);
               }
             }
           }
@@ -1326,13 +1630,14 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
                 sphere.around(v, v + 3);
                 within_solid_bounds = (sphere.contains(from_node_gbv) != 0);
 #ifdef DO_PSTATS
-                CollisionGeom::_volume_pcollector.add_level(1);
+                CollisionLevelCounts::add_level(
+                  counts, CollisionGeom::_volume_pcollector, 1);
 #endif  // DO_PSTATS
               }
               if (within_solid_bounds) {
                 PT(CollisionGeom) cgeom = new CollisionGeom(v[0], v[1], v[2]);
                 entry._into = cgeom;
-                entry.test_intersection((*ci).second, this);
+                entry.test_intersection(handler, this, counts);
               }
             }
           }
@@ -1342,6 +1647,114 @@ compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
   }
 }
 
+/**
+ * Returns the cached triangles of the indicated Geom, with a bounding volume
+ * hierarchy over them, building them if necessary.  Returns NULL if the Geom
+ * is too small to be worth it, or if its vertices are animated.
+ */
+CPT(CollisionTraverser::GeomBVH) CollisionTraverser::
+get_geom_bvh(const Geom *geom, const GeomVertexData *data,
+             Thread *current_thread) {
+  if (collision_bvh_min_solids <= 0 ||
+      data != geom->get_vertex_data(current_thread).p()) {
+    return nullptr;
+  }
+
+  UpdateSeq geom_modified = geom->get_modified(current_thread);
+  UpdateSeq data_modified = data->get_modified(current_thread);
+
+  LightMutexHolder holder(_geom_bvhs_lock);
+  GeomBVHs::iterator gi = _geom_bvhs.find(geom);
+  if (gi != _geom_bvhs.end()) {
+    GeomBVH *geom_bvh = (*gi).second;
+    if (!geom_bvh->_geom.was_deleted() && !geom_bvh->_data.was_deleted() &&
+        geom_bvh->_data == data &&
+        geom_bvh->_geom_modified == geom_modified &&
+        geom_bvh->_data_modified == data_modified) {
+      return geom_bvh->_bvh != nullptr ? geom_bvh : nullptr;
+    }
+  }
+
+  // Every so often, forget about Geoms that have since been deleted.
+  if (_geom_bvhs.size() >= _geom_bvhs_purge_size * 2 + 16) {
+    GeomBVHs::iterator pi = _geom_bvhs.begin();
+    while (pi != _geom_bvhs.end()) {
+      if ((*pi).second->_geom.was_deleted()) {
+        pi = _geom_bvhs.erase(pi);
+      } else {
+        ++pi;
+      }
+    }
+    _geom_bvhs_purge_size = _geom_bvhs.size();
+  }
+
+  PT(GeomBVH) geom_bvh = new GeomBVH;
+  geom_bvh->_geom = geom;
+  geom_bvh->_data = data;
+  geom_bvh->_geom_modified = geom_modified;
+  geom_bvh->_data_modified = data_modified;
+  _geom_bvhs[geom] = geom_bvh;
+
+  // Collect the triangles in the same order in which compare_collider_to_geom
+  // would visit them.
+  GeomVertexReader vertex(data, InternalName::get_vertex(), current_thread);
+  pvector<LPoint3> &verts = geom_bvh->_vertices;
+  int num_primitives = geom->get_num_primitives();
+  for (int i = 0; i < num_primitives; ++i) {
+    const GeomPrimitive *primitive = geom->get_primitive(i);
+    CPT(GeomPrimitive) tris = primitive->decompose();
+    nassertr(tris->is_of_type(GeomTriangles::get_class_type()), nullptr);
+
+    LPoint3 v[3];
+    if (tris->is_indexed()) {
+      GeomVertexReader index(tris->get_vertices(), 0, current_thread);
+      while (!index.is_at_end()) {
+        for (int j = 0; j < 3; ++j) {
+          vertex.set_row_unsafe(index.get_data1i());
+          v[j] = vertex.get_data3();
+        }
+        if (CollisionPolygon::verify_points(v[0], v[1], v[2])) {
+          verts.insert(verts.end(), v, v + 3);
+        }
+      }
+    } else {
+      vertex.set_row_unsafe(primitive->get_first_vertex());
+      int num_vertices = primitive->get_num_vertices();
+      for (int j = 0; j < num_vertices; j += 3) {
+        v[0] = vertex.get_data3();
+        v[1] = vertex.get_data3();
+        v[2] = vertex.get_data3();
+        if (CollisionPolygon::verify_points(v[0], v[1], v[2])) {
+          verts.insert(verts.end(), v, v + 3);
+        }
+      }
+    }
+  }
+
+  int num_triangles = (int)(verts.size() / 3);
+  if (num_triangles < collision_bvh_min_solids) {
+    // Remember that this one is not worth it, but don't hold on to the
+    // vertices.
+    pvector<LPoint3>().swap(verts);
+    return nullptr;
+  }
+
+  PT(CollisionBVH) bvh = new CollisionBVH;
+  for (int t = 0; t < num_triangles; ++t) {
+    BoundingSphere sphere;
+    sphere.around(&verts[t * 3], &verts[t * 3] + 3);
+    bvh->add_item(&sphere);
+  }
+  bvh->build();
+  geom_bvh->_bvh = bvh;
+
+  if (collide_cat.is_debug()) {
+    collide_cat.debug()
+      << "Built " << *bvh << " for " << *geom << "\n";
+  }
+  return geom_bvh;
+}
+
 /**
  * Removes the indicated CollisionHandler from the list of handlers to be
  * processed, and returns the iterator to the next handler in the list.  This
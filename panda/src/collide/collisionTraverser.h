@@ -18,9 +18,14 @@
 
 #include "collisionHandler.h"
 #include "collisionLevelState.h"
+#include "collisionBVH.h"
 
 #include "pointerTo.h"
+#include "weakPointerTo.h"
 #include "pStatCollector.h"
+#include "lightMutex.h"
+#include "updateSeq.h"
+#include "parallelJobRunner.h"
 
 #include "pset.h"
 #include "register_type.h"
@@ -29,6 +34,7 @@ class CollisionNode;
 class CollisionRecorder;
 class CollisionVisualizer;
 class Geom;
+class GeomVertexData;
 class NodePath;
 class CollisionEntry;
 
@@ -52,6 +58,10 @@ PUBLISHED:
   MAKE_PROPERTY(respect_prev_transform, get_respect_prev_transform,
                                         set_respect_prev_transform);
 
+  INLINE void set_num_threads(int num_threads);
+  INLINE int get_num_threads() const;
+  MAKE_PROPERTY(num_threads, get_num_threads, set_num_threads);
+
   void add_collider(const NodePath &collider, CollisionHandler *handler);
   bool remove_collider(const NodePath &collider);
   bool has_collider(const NodePath &collider) const;
@@ -81,7 +91,9 @@ PUBLISHED:
 
 private:
   typedef pvector<CollisionLevelStateSingle> LevelStatesSingle;
-  void prepare_colliders_single(LevelStatesSingle &level_states, const NodePath &root);
+  bool prepare_colliders_single(LevelStatesSingle &level_states, const NodePath &root,
+                                int max_per_pass = 0);
+  bool traverse_parallel(const NodePath &root);
   void r_traverse_single(CollisionLevelStateSingle &level_state, size_t pass);
 
   typedef pvector<CollisionLevelStateDouble> LevelStatesDouble;
@@ -95,19 +107,24 @@ private:
   void compare_collider_to_node(CollisionEntry &entry,
                                 const GeometricBoundingVolume *from_parent_gbv,
                                 const GeometricBoundingVolume *from_node_gbv,
-                                const GeometricBoundingVolume *into_node_gbv);
+                                const GeometricBoundingVolume *into_node_gbv,
+                                CollisionLevelCounts *counts);
   void compare_collider_to_geom_node(CollisionEntry &entry,
                                      const GeometricBoundingVolume *from_parent_gbv,
                                      const GeometricBoundingVolume *from_node_gbv,
-                                     const GeometricBoundingVolume *into_node_gbv);
+                                     const GeometricBoundingVolume *into_node_gbv,
+                                     CollisionLevelCounts *counts);
   void compare_collider_to_solid(CollisionEntry &entry,
+                                 const CollisionSolid *solid,
                                  const GeometricBoundingVolume *from_node_gbv,
-                                 const GeometricBoundingVolume *solid_gbv);
+                                 CollisionLevelCounts *counts);
   void compare_collider_to_geom(CollisionEntry &entry, const Geom *geom,
                                 const GeometricBoundingVolume *from_node_gbv,
-                                const GeometricBoundingVolume *solid_gbv);
+                                const GeometricBoundingVolume *solid_gbv,
+                                CollisionLevelCounts *counts);
 
   PStatCollector &get_pass_collector(int pass);
+  INLINE CollisionHandler *get_collider_handler(const NodePath &collider) const;
 
 private:
   PT(CollisionHandler) _default_handler;
@@ -126,8 +143,33 @@ private:
   typedef pmap<PT(CollisionHandler), int> Handlers;
   Handlers _handlers;
 
+  // During a parallel traversal, this replaces _colliders with handlers that
+  // store the detected collisions until all of the workers are done.
+  Colliders _deferred_colliders;
+  ParallelJobRunner _job_runner;
+
   Handlers::iterator remove_handler(Handlers::iterator hi);
 
+  // The triangles of a Geom that is collided into as visible geometry,
+  // along with a hierarchy over them.  These are cached per Geom, and
+  // rebuilt if the Geom or its vertices are modified.
+  class GeomBVH : public ReferenceCount {
+  public:
+    WCPT(Geom) _geom;
+    WCPT(GeomVertexData) _data;
+    UpdateSeq _geom_modified;
+    UpdateSeq _data_modified;
+    pvector<LPoint3> _vertices;
+    PT(CollisionBVH) _bvh;
+  };
+  CPT(GeomBVH) get_geom_bvh(const Geom *geom, const GeomVertexData *data,
+                            Thread *current_thread);
+
+  typedef pmap<const Geom *, PT(GeomBVH)> GeomBVHs;
+  GeomBVHs _geom_bvhs;
+  size_t _geom_bvhs_purge_size;
+  LightMutex _geom_bvhs_lock;
+
   bool _respect_prev_transform;
 #ifdef DO_COLLISION_RECORDING
   CollisionRecorder *_recorder;
@@ -143,6 +185,8 @@ private:
   static PStatCollector _cnode_volume_pcollector;
   static PStatCollector _gnode_volume_pcollector;
   static PStatCollector _geom_volume_pcollector;
+  static PStatCollector _bvh_pcollector;
+  static PStatCollector _parallel_pcollector;
 
   PStatCollector _this_pcollector;
   typedef pvector<PStatCollector> PassCollectors;
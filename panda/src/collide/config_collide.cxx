@@ -111,6 +111,31 @@ ConfigVariableBool pushers_horizontal
           "set_horizontal() flag by default, false to let the move "
           "in three dimensions by default."));
 
+ConfigVariableInt collision_bvh_min_solids
+("collision-bvh-min-solids", 16,
+ PRC_DESC("CollisionNodes with at least this many solids, and Geoms with "
+          "at least this many triangles that are collided into as visible "
+          "geometry, are automatically given a bounding volume hierarchy "
+          "so that the CollisionTraverser only needs to test the solids "
+          "near each collider.  The hierarchy is rebuilt when the solids "
+          "change.  Set this to 0 to disable it."));
+
+ConfigVariableInt collide_num_threads
+("collide-num-threads", 0,
+ PRC_DESC("Set this to a number greater than zero to have each "
+          "CollisionTraverser divide its colliders into small groups, "
+          "which are traversed concurrently by up to this many additional "
+          "worker threads.  The detected collisions are handed to the "
+          "handlers on the calling thread afterwards, in a fixed order.  "
+          "This may be overridden per traverser with set_num_threads()."));
+
+ConfigVariableInt collide_parallel_pass_size
+("collide-parallel-pass-size", 8,
+ PRC_DESC("The number of collision solids in each group of colliders "
+          "when the CollisionTraverser runs in parallel; see "
+          "collide-num-threads.  The order of the collision entries depends "
+          "on this value, but not on the number of threads."));
+
 /**
  * Initializes the library.  This must be called at least once before any of
  * the functions or classes in this library can be used.  Normally it will be
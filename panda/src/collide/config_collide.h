@@ -30,6 +30,9 @@ extern EXPCL_PANDA_COLLIDE ConfigVariableDouble collision_parabola_bounds_thresh
 extern EXPCL_PANDA_COLLIDE ConfigVariableInt collision_parabola_bounds_sample;
 extern EXPCL_PANDA_COLLIDE ConfigVariableInt fluid_cap_amount;
 extern EXPCL_PANDA_COLLIDE ConfigVariableBool pushers_horizontal;
+extern EXPCL_PANDA_COLLIDE ConfigVariableInt collision_bvh_min_solids;
+extern EXPCL_PANDA_COLLIDE ConfigVariableInt collide_num_threads;
+extern EXPCL_PANDA_COLLIDE ConfigVariableInt collide_parallel_pass_size;
 
 extern EXPCL_PANDA_COLLIDE void init_libcollide();
 
@@ -17,6 +17,7 @@
 #include "cullableObject.h"
 #include "cullHandler.h"
 #include "pStatTimer.h"
+#include "radixSort.h"
 
 #include <algorithm>
 
@@ -61,7 +62,20 @@ add_object(CullableObject *object, Thread *current_thread) {
 void CullBinFixed::
 finish_cull(SceneSetup *, Thread *current_thread) {
   PStatTimer timer(_cull_this_pcollector, current_thread);
-  std::stable_sort(_objects.begin(), _objects.end());
+  size_t num_objects = _objects.size();
+  RadixSortEntries entries(num_objects);
+  for (size_t i = 0; i < num_objects; ++i) {
+    entries[i]._key = radix_sort_key(_objects[i]._draw_order);
+    entries[i]._index = (uint32_t)i;
+  }
+  radix_sort(entries);
+
+  Objects sorted;
+  sorted.reserve(num_objects);
+  for (const RadixSortEntry &entry : entries) {
+    sorted.push_back(_objects[entry._index]);
+  }
+  _objects.swap(sorted);
 }
 
 /**
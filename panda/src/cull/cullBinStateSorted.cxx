@@ -16,12 +16,52 @@
 #include "cullableObject.h"
 #include "cullHandler.h"
 #include "pStatTimer.h"
+#include "radixSort.h"
+#include "simpleHashMap.h"
+#include "pbitops.h"
 
 #include <algorithm>
 
 
 TypeHandle CullBinStateSorted::_type_handle;
 
+namespace {
+  // Orders RenderStates for CullBinStateSorted::finish_cull().
+  class CompareStateSort {
+  public:
+    bool operator () (const RenderState *a, const RenderState *b) const {
+      return a->compare_sort(*b) < 0;
+    }
+  };
+
+  // Assigns a small integer to each distinct pointer, in order of first
+  // appearance.
+  class PointerRanks {
+  public:
+    int get_rank(const void *ptr) {
+      int index = _ranks.find(ptr);
+      if (index != -1) {
+        return _ranks.get_data(index);
+      }
+      int rank = (int)_ranks.get_num_entries();
+      _ranks.store(ptr, rank);
+      return rank;
+    }
+
+    int get_num_ranks() const {
+      return (int)_ranks.get_num_entries();
+    }
+
+  private:
+    SimpleHashMap<const void *, int, pointer_hash> _ranks;
+  };
+
+  // Returns the number of bits needed to store any value below num_values.
+  int get_rank_bits(int num_values) {
+    return (num_values <= 1) ? 0 : get_next_higher_bit((unsigned int)(num_values - 1));
+  }
+}
+
 /**
  *
  */
@@ -59,7 +99,78 @@ add_object(CullableObject *object, Thread *current_thread) {
 void CullBinStateSorted::
 finish_cull(SceneSetup *, Thread *current_thread) {
   PStatTimer timer(_cull_this_pcollector, current_thread);
-  sort(_objects.begin(), _objects.end());
+
+  size_t num_objects = _objects.size();
+  if (num_objects < 2) {
+    return;
+  }
+
+  // Rather than comparing the states of each pair of objects, which is
+  // expensive, we rank the distinct states (of which there are usually far
+  // fewer than objects), and likewise the vertex formats, vertex data and
+  // transforms.  The order of the last three is arbitrary anyway; it only
+  // matters that equal ones end up together.  The ranks are then packed
+  // into one 64-bit key per object, which are radix sorted.
+  PointerRanks state_ranks, format_ranks, data_ranks, transform_ranks;
+  pvector<int> ranks(num_objects * 4);
+  for (size_t i = 0; i < num_objects; ++i) {
+    const ObjectData &data = _objects[i];
+    ranks[i * 4] = state_ranks.get_rank(data._object->_state);
+    ranks[i * 4 + 1] = format_ranks.get_rank(data._format);
+    ranks[i * 4 + 2] = data_ranks.get_rank(data._object->_munged_data);
+    ranks[i * 4 + 3] = transform_ranks.get_rank(data._object->_internal_transform);
+  }
+
+  int num_states = state_ranks.get_num_ranks();
+  int state_bits = get_rank_bits(num_states);
+  int format_bits = get_rank_bits(format_ranks.get_num_ranks());
+  int data_bits = get_rank_bits(data_ranks.get_num_ranks());
+  int transform_bits = get_rank_bits(transform_ranks.get_num_ranks());
+  if (state_bits + format_bits + data_bits + transform_bits > 64) {
+    // This many distinct objects won't fit in the key.
+    sort(_objects.begin(), _objects.end());
+    return;
+  }
+
+  // Now put the states in order.  Each state's rank so far is its index in
+  // order of appearance; replace it by its place in the sorted order.
+  pvector<const RenderState *> states(num_states);
+  for (size_t i = 0; i < num_objects; ++i) {
+    states[ranks[i * 4]] = _objects[i]._object->_state;
+  }
+  pvector<const RenderState *> sorted_states(states);
+  std::sort(sorted_states.begin(), sorted_states.end(), CompareStateSort());
+
+  SimpleHashMap<const RenderState *, int, pointer_hash> sorted_ranks;
+  int rank = 0;
+  for (int si = 0; si < num_states; ++si) {
+    if (si > 0 && sorted_states[si - 1]->compare_sort(*sorted_states[si]) != 0) {
+      ++rank;
+    }
+    sorted_ranks.store(sorted_states[si], rank);
+  }
+  pvector<int> state_order(num_states);
+  for (int si = 0; si < num_states; ++si) {
+    state_order[si] = sorted_ranks.get_data(sorted_ranks.find(states[si]));
+  }
+
+  RadixSortEntries entries(num_objects);
+  for (size_t i = 0; i < num_objects; ++i) {
+    uint64_t key = (uint64_t)state_order[ranks[i * 4]];
+    key = (key << format_bits) | (uint64_t)ranks[i * 4 + 1];
+    key = (key << data_bits) | (uint64_t)ranks[i * 4 + 2];
+    key = (key << transform_bits) | (uint64_t)ranks[i * 4 + 3];
+    entries[i]._key = key;
+    entries[i]._index = (uint32_t)i;
+  }
+  radix_sort(entries);
+
+  Objects sorted(get_class_type());
+  sorted.reserve(num_objects);
+  for (const RadixSortEntry &entry : entries) {
+    sorted.push_back(_objects[entry._index]);
+  }
+  _objects.swap(sorted);
 }
 
 
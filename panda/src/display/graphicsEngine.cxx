@@ -1319,6 +1319,7 @@ do_cull(CullHandler *cull_handler, SceneSetup *scene_setup,
   CullTraverser *trav = dr->get_cull_traverser();
   trav->set_cull_handler(cull_handler);
   trav->set_scene(scene_setup, gsg, dr->get_incomplete_render());
+  trav->set_num_threads(gsg->get_threading_model().get_cull_num_threads());
   trav->traverse(scene_setup->get_scene_root());
   trav->end_traverse();
 }
@@ -12,6 +12,7 @@
  */
 
 #include "graphicsThreadingModel.h"
+#include "config_pgraph.h"
 
 using std::string;
 
@@ -36,10 +37,14 @@ using std::string;
  * draw are run simultaneously, in the same thread, with no binning or state
  * sorting.  It simplifies the cull process but it forces the scene to render
  * in scene graph order; state sorting and alpha sorting is lost.
+ *
+ * The number of worker threads used to parallelize the cull traversal itself
+ * is not part of the string; see set_cull_num_threads().
  */
 GraphicsThreadingModel::
 GraphicsThreadingModel(const string &model) {
   _cull_sorting = true;
+  _cull_num_threads = std::max((int)cull_num_threads, 0);
   size_t start = 0;
   if (!model.empty() && model[0] == '-') {
     start = 1;
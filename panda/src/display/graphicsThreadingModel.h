@@ -38,6 +38,9 @@ PUBLISHED:
   INLINE bool get_cull_sorting() const;
   INLINE void set_cull_sorting(bool cull_sorting);
 
+  INLINE int get_cull_num_threads() const;
+  INLINE void set_cull_num_threads(int cull_num_threads);
+
   INLINE bool is_single_threaded() const;
   INLINE bool is_default() const;
   INLINE void output(std::ostream &out) const;
@@ -51,6 +54,7 @@ private:
   std::string _draw_name;
   int _draw_stage;
   bool _cull_sorting;
+  int _cull_num_threads;
 };
 
 INLINE std::ostream &operator << (std::ostream &out, const GraphicsThreadingModel &threading_model);
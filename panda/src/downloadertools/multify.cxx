@@ -20,6 +20,7 @@
 #include "virtualFileSystem.h"
 #include <stdio.h>
 #include <time.h>
+#include <sstream>
 
 using std::cerr;
 using std::cout;
@@ -36,6 +37,8 @@ bool kill_cmd = false;         // -k
 bool verbose = false;          // -v
 bool compress_flag = false;    // -z
 int default_compression_level = 6;
+CompressionCodec compression_codec = CC_zlib;  // -L
+bool got_compression_codec = false;
 Filename multifile_name;       // -f
 bool got_multifile_name = false;
 bool to_stdout = false;        // -O
@@ -230,6 +233,12 @@ help() {
     "      generate slightly smaller files, but compression takes longer.  The\n"
     "      default is -" << default_compression_level << ".\n\n"
 
+    "  -L <codec>\n"
+    "      Specify the codec used to compress subfiles when -z is in effect.\n"
+    "      This may be zlib, the default, lz4 or zstd.  Subfiles compressed with\n"
+    "      lz4 decompress several times faster, but are somewhat larger.  Those\n"
+    "      compressed with zstd are usually smaller, and decompress faster too.\n\n"
+
     "  -S file.crt[,chain.crt[,file.key[,\"password\"]]]\n"
     "      Sign the multifile.  The signing certificate should be in PEM form in\n"
     "      file.crt, with its private key in PEM form in file.key.  If the key\n"
@@ -394,6 +403,10 @@ add_files(const vector_string &params) {
     multifile->set_record_timestamp(record_timestamp_flag);
   }
 
+  if (got_compression_codec) {
+    multifile->set_compression_codec(compression_codec);
+  }
+
   if (encryption_flag) {
     multifile->set_encryption_flag(true);
     multifile->set_encryption_password(get_password());
@@ -781,7 +794,7 @@ main(int argc, char **argv) {
 
   extern char *optarg;
   extern int optind;
-  static const char *optflags = "crutxkvz123456789Z:T:X:S:f:OC:ep:P:F:h";
+  static const char *optflags = "crutxkvz123456789Z:L:T:X:S:f:OC:ep:P:F:h";
   int flag = getopt(argc, argv, optflags);
   Filename rel_path;
   while (flag != EOF) {
@@ -852,6 +865,18 @@ main(int argc, char **argv) {
     case 'X':
       text_ext_str = optarg;
       break;
+    case 'L':
+      {
+        std::istringstream strm(optarg);
+        strm >> compression_codec;
+        if (compression_codec == CC_none) {
+          cerr << "Invalid compression codec: " << optarg << "\n";
+          usage();
+          return 1;
+        }
+        got_compression_codec = true;
+      }
+      break;
     case 'S':
       sign_params.push_back(optarg);
       break;
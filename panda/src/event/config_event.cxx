@@ -23,7 +23,9 @@
 #include "eventHandler.h"
 #include "eventParameter.h"
 #include "genericAsyncTask.h"
+#include "parallelJobRunner.h"
 #include "pointerEventList.h"
+#include "bamReader.h"
 
 #include "dconfig.h"
 
@@ -35,6 +37,9 @@ Configure(config_event);
 NotifyCategoryDef(event, "");
 NotifyCategoryDef(task, "");
 
+static void run_bam_decode_jobs(int num_jobs, int num_threads,
+                                BamReader::DecodeJobFunc *func, void *data);
+
 ConfigureFn(config_event) {
   AsyncFuture::init_type();
   AsyncGatheringFuture::init_type();
@@ -54,4 +59,21 @@ ConfigureFn(config_event) {
   ButtonEventList::register_with_read_factory();
   EventStoreInt::register_with_read_factory();
   EventStoreDouble::register_with_read_factory();
+
+  BamReader::set_decode_runner(&run_bam_decode_jobs);
+}
+
+/**
+ * Runs the decode jobs of a BamReader on the threads of the "bam-decode" task
+ * chain, using a runner that is shared by all readers.  The BamReader lives
+ * in a lower library, so it can't use a ParallelJobRunner directly.
+ */
+static void
+run_bam_decode_jobs(int num_jobs, int num_threads,
+                    BamReader::DecodeJobFunc *func, void *data) {
+  static ParallelJobRunner job_runner("bam-decode");
+  job_runner.set_num_threads(num_threads);
+  job_runner.run(num_jobs, [=] (int job, Thread *) {
+    (*func)(job, data);
+  });
 }
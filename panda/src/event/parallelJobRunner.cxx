@@ -0,0 +1,169 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file parallelJobRunner.cxx
+ * @author jmarsh
+ * @date 2026-10-15
+ */
+
+#include "parallelJobRunner.h"
+#include "asyncTaskManager.h"
+#include "asyncTaskChain.h"
+#include "mutexHolder.h"
+#include "lightMutexHolder.h"
+
+/**
+ * Creates a runner that will use the threads of the named task chain on the
+ * global AsyncTaskManager.  The task chain is created on first use.
+ */
+ParallelJobRunner::
+ParallelJobRunner(const std::string &chain_name, int num_threads) :
+  _chain_name(chain_name),
+  _num_threads(std::max(num_threads, 0)),
+  _chain(nullptr)
+{
+}
+
+/**
+ * Creates a runner that uses the same task chain and number of threads as
+ * the other one.
+ */
+ParallelJobRunner::
+ParallelJobRunner(const ParallelJobRunner &copy) :
+  _chain_name(copy._chain_name),
+  _num_threads(AtomicAdjust::get(copy._num_threads)),
+  _chain(nullptr)
+{
+  LightMutexHolder holder(((ParallelJobRunner &)copy)._lock);
+  _chain = copy._chain;
+}
+
+/**
+ * Hands out the jobs of the indicated batch to the task chain, and then
+ * helps out with the work until all of the jobs have been completed.
+ */
+void ParallelJobRunner::
+do_run(Batch *batch, int num_jobs, Thread *current_thread) {
+  AsyncTaskChain *chain = get_chain();
+
+  // There is no point in waking up more threads than there are jobs left
+  // over after the calling thread takes its share.
+  int num_tasks = std::min(chain->get_num_threads(), num_jobs - 1);
+  if (num_tasks > 0) {
+    AsyncTaskManager *task_mgr = AsyncTaskManager::get_global_ptr();
+    for (int i = 0; i < num_tasks; ++i) {
+      PT(GenericAsyncTask) task = new GenericAsyncTask(_chain_name, &task_func, batch);
+      task->set_upon_death(&death_func);
+      task->set_task_chain(_chain_name);
+
+      // The task holds a reference to the batch until it dies, since it may
+      // only get around to running after all of the jobs are done.
+      batch->ref();
+      task_mgr->add(task);
+    }
+  }
+
+  batch->run_jobs(current_thread);
+  batch->wait_done();
+}
+
+/**
+ * Returns the task chain, creating it if necessary, after making sure that it
+ * has at least the requested number of threads.
+ */
+AsyncTaskChain *ParallelJobRunner::
+get_chain() {
+  int num_threads = get_num_threads();
+
+  LightMutexHolder holder(_lock);
+  if (_chain == nullptr) {
+    AsyncTaskManager *task_mgr = AsyncTaskManager::get_global_ptr();
+    _chain = task_mgr->make_task_chain(_chain_name);
+  }
+  if (_chain->get_num_threads() < num_threads) {
+    _chain->set_num_threads(num_threads);
+  }
+  return _chain;
+}
+
+/**
+ * The function assigned to each of the GenericAsyncTasks.
+ */
+AsyncTask::DoneStatus ParallelJobRunner::
+task_func(GenericAsyncTask *task, void *user_data) {
+  Batch *batch = (Batch *)user_data;
+  batch->run_jobs(Thread::get_current_thread());
+  return AsyncTask::DS_done;
+}
+
+/**
+ * Releases the reference held by a task on its batch.
+ */
+void ParallelJobRunner::
+death_func(GenericAsyncTask *task, bool clean_exit, void *user_data) {
+  Batch *batch = (Batch *)user_data;
+  unref_delete(batch);
+}
+
+/**
+ *
+ */
+ParallelJobRunner::Batch::
+Batch(int num_jobs, int pipeline_stage) :
+  _num_jobs(num_jobs),
+  _pipeline_stage(pipeline_stage),
+  _next_job(0),
+  _num_remaining(num_jobs),
+  _cvar(_lock)
+{
+}
+
+/**
+ *
+ */
+ParallelJobRunner::Batch::
+~Batch() {
+}
+
+/**
+ * Claims and runs jobs until there are none left to claim.
+ */
+void ParallelJobRunner::Batch::
+run_jobs(Thread *current_thread) {
+  int prev_stage = current_thread->get_pipeline_stage();
+  if (prev_stage != _pipeline_stage) {
+    current_thread->set_pipeline_stage(_pipeline_stage);
+  }
+
+  AtomicAdjust::Integer job = AtomicAdjust::add(_next_job, 1) - 1;
+  while (job < _num_jobs) {
+    do_job((int)job, current_thread);
+
+    if (!AtomicAdjust::dec(_num_remaining)) {
+      // That was the last job; wake up the thread waiting in wait_done().
+      MutexHolder holder(_lock);
+      _cvar.notify_all();
+    }
+    job = AtomicAdjust::add(_next_job, 1) - 1;
+  }
+
+  if (prev_stage != _pipeline_stage) {
+    current_thread->set_pipeline_stage(prev_stage);
+  }
+}
+
+/**
+ * Blocks until all of the jobs in the batch have been completed.
+ */
+void ParallelJobRunner::Batch::
+wait_done() {
+  MutexHolder holder(_lock);
+  while (AtomicAdjust::get(_num_remaining) != 0) {
+    _cvar.wait();
+  }
+}
@@ -0,0 +1,114 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file parallelJobRunner.h
+ * @author jmarsh
+ * @date 2026-10-15
+ */
+
+#ifndef PARALLELJOBRUNNER_H
+#define PARALLELJOBRUNNER_H
+
+#include "pandabase.h"
+
+#include "referenceCount.h"
+#include "pointerTo.h"
+#include "pmutex.h"
+#include "lightMutex.h"
+#include "conditionVar.h"
+#include "atomicAdjust.h"
+#include "thread.h"
+#include "genericAsyncTask.h"
+
+class AsyncTaskChain;
+
+/**
+ * This is a helper for splitting a data-parallel loop into a number of
+ * independent jobs, which are then run concurrently by the threads of a
+ * named AsyncTaskChain on the global AsyncTaskManager.  The calling thread
+ * participates in the work as well, and run() does not return until every
+ * job has been completed.
+ *
+ * Jobs are handed out in increasing order, but may complete in any order;
+ * the caller is responsible for writing the results of each job into a
+ * separate slot and combining them afterwards if a deterministic result is
+ * required.
+ *
+ * If threading is not available, or the number of threads is zero, all of
+ * the jobs are simply run in sequence on the calling thread.
+ *
+ * A single runner may be shared between threads: run() may be called from
+ * several threads at once, and set_num_threads() may be called at any time.
+ */
+class EXPCL_PANDA_EVENT ParallelJobRunner {
+public:
+  explicit ParallelJobRunner(const std::string &chain_name, int num_threads = 0);
+  ParallelJobRunner(const ParallelJobRunner &copy);
+  ParallelJobRunner &operator = (const ParallelJobRunner &copy) = delete;
+
+  INLINE const std::string &get_chain_name() const;
+
+  INLINE void set_num_threads(int num_threads);
+  INLINE int get_num_threads() const;
+  INLINE bool is_parallel() const;
+
+  template<class Callable>
+  INLINE void run(int num_jobs, Callable func,
+                  Thread *current_thread = Thread::get_current_thread());
+  template<class Callable>
+  INLINE void run_bands(int num_items, int min_items_per_job, Callable func,
+                        Thread *current_thread = Thread::get_current_thread());
+
+private:
+  class Batch : public ReferenceCount {
+  public:
+    Batch(int num_jobs, int pipeline_stage);
+    virtual ~Batch();
+
+    virtual void do_job(int job, Thread *current_thread)=0;
+
+    void run_jobs(Thread *current_thread);
+    void wait_done();
+
+  private:
+    int _num_jobs;
+    int _pipeline_stage;
+    TVOLATILE AtomicAdjust::Integer _next_job;
+    TVOLATILE AtomicAdjust::Integer _num_remaining;
+    Mutex _lock;
+    ConditionVar _cvar;
+  };
+
+  template<class Callable>
+  class CallableBatch final : public Batch {
+  public:
+    INLINE CallableBatch(int num_jobs, int pipeline_stage, Callable &func);
+    virtual void do_job(int job, Thread *current_thread);
+
+  private:
+    Callable &_func;
+  };
+
+  void do_run(Batch *batch, int num_jobs, Thread *current_thread);
+  AsyncTaskChain *get_chain();
+
+  static AsyncTask::DoneStatus task_func(GenericAsyncTask *task, void *user_data);
+  static void death_func(GenericAsyncTask *task, bool clean_exit, void *user_data);
+
+private:
+  std::string _chain_name;
+  TVOLATILE AtomicAdjust::Integer _num_threads;
+
+  // Protects _chain, which is created on first use.
+  LightMutex _lock;
+  AsyncTaskChain *_chain;
+};
+
+#include "parallelJobRunner.I"
+
+#endif
@@ -12,11 +12,14 @@
  */
 
 #include "compress_string.h"
+#include "lz4Stream.h"
+#include "zstdStream.h"
+#include "virtualFileSystem.h"
+#include "config_express.h"
 
 #ifdef HAVE_ZLIB
 #include "zStream.h"
-#include "virtualFileSystem.h"
-#include "config_express.h"
+#endif
 
 using std::istream;
 using std::istringstream;
@@ -26,28 +29,24 @@ using std::string;
 
 /**
  * Compress the indicated source string at the given compression level (1
- * through 9).  Returns the compressed string.
+ * through 9), using the indicated codec.  Returns the compressed string.
  */
 string
-compress_string(const string &source, int compression_level) {
-  ostringstream dest;
-
-  {
-    OCompressStream compress;
-    compress.open(&dest, false, compression_level);
-    compress.write(source.data(), source.length());
+compress_string(const string &source, int compression_level,
+                CompressionCodec codec) {
+  istringstream source_stream(source);
+  ostringstream dest_stream;
 
-    if (compress.fail()) {
-      return string();
-    }
+  if (!compress_stream(source_stream, dest_stream, compression_level, codec)) {
+    return string();
   }
 
-  return dest.str();
+  return dest_stream.str();
 }
 
 /**
  * Decompresss the previously-compressed string()).  The return value is the
- * decompressed string.
+ * decompressed string.  The codec is determined from the data.
  *
  * Note that a decompression error cannot easily be detected, and the return
  * value may simply be a garbage or truncated string.
@@ -71,7 +70,8 @@ decompress_string(const string &source) {
  * value is bool on success, or false on failure.
  */
 EXPCL_PANDA_EXPRESS bool
-compress_file(const Filename &source, const Filename &dest, int compression_level) {
+compress_file(const Filename &source, const Filename &dest, int compression_level,
+              CompressionCodec codec) {
   VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
   Filename source_filename = source;
   if (!source_filename.is_binary_or_text()) {
@@ -92,7 +92,7 @@ compress_file(const Filename &source, const Filename &dest, int compression_leve
     return false;
   }
 
-  bool result = compress_stream(*source_stream, *dest_stream, compression_level);
+  bool result = compress_stream(*source_stream, *dest_stream, compression_level, codec);
   vfs->close_read_file(source_stream);
   vfs->close_write_file(dest_stream);
   return result;
@@ -137,14 +137,49 @@ decompress_file(const Filename &source, const Filename &dest) {
 
 /**
  * Compresss the data from the source stream at the given compression level (1
- * through 9).  The source stream is read from its current position to the
- * end-of-file, and the compressed results are written to the dest stream.
- * The return value is bool on success, or false on failure.
+ * through 9), using the indicated codec.  The source stream is read from its
+ * current position to the end-of-file, and the compressed results are written
+ * to the dest stream.  The return value is bool on success, or false on
+ * failure.
  */
 bool
-compress_stream(istream &source, ostream &dest, int compression_level) {
-  OCompressStream compress;
-  compress.open(&dest, false, compression_level);
+compress_stream(istream &source, ostream &dest, int compression_level,
+                CompressionCodec codec) {
+  ostream *compress;
+  switch (codec) {
+  case CC_none:
+    compress = &dest;
+    break;
+
+  case CC_zlib:
+#ifdef HAVE_ZLIB
+    compress = new OCompressStream(&dest, false, compression_level);
+    break;
+#else
+    express_cat.error()
+      << "zlib not compiled in; cannot compress with zlib.\n";
+    return false;
+#endif  // HAVE_ZLIB
+
+  case CC_lz4:
+#ifdef HAVE_LZ4
+    compress = new OLZ4CompressStream(&dest, false, compression_level);
+    break;
+#else
+    express_cat.error()
+      << "LZ4 not compiled in; cannot compress with LZ4.\n";
+    return false;
+#endif  // HAVE_LZ4
+
+  case CC_zstd:
+    compress = new OZstdCompressStream(&dest, false, compression_level);
+    break;
+
+  default:
+    express_cat.error()
+      << "Invalid compression codec " << (int)codec << "\n";
+    return false;
+  }
 
   static const size_t buffer_size = 4096;
   char buffer[buffer_size];
@@ -152,40 +187,67 @@ compress_stream(istream &source, ostream &dest, int compression_level) {
   source.read(buffer, buffer_size);
   size_t count = source.gcount();
   while (count != 0) {
-    compress.write(buffer, count);
+    compress->write(buffer, count);
     source.read(buffer, buffer_size);
     count = source.gcount();
   }
-  compress.close();
+  compress->flush();
+  bool success = (!source.fail() || source.eof()) && (!compress->fail());
 
-  return (!source.fail() || source.eof()) && (!compress.fail());
+  if (compress != &dest) {
+    // Deleting the compression stream writes the end of the stream.
+    delete compress;
+  }
+  return success && !dest.fail();
 }
 
 /**
  * Decompresss the data from the previously-compressed source stream.  The
  * source stream is read from its current position to the end-of-file, and the
  * decompressed results are written to the dest stream.  The return value is
- * bool on success, or false on failure.
+ * bool on success, or false on failure.  The codec is determined from the
+ * data.
  *
- * Note that a decompression error cannot easily be detected, and the output
- * may simply be a garbage or truncated string.
+ * Note that a zlib decompression error cannot easily be detected, and the
+ * output may simply be a garbage or truncated string.
  */
 bool
 decompress_stream(istream &source, ostream &dest) {
-  IDecompressStream decompress(&source, false);
+  istream *decompress;
+  if (source.peek() == 0x04) {
+    // An LZ4 frame starts with a byte that can't begin a zlib stream.
+#ifdef HAVE_LZ4
+    decompress = new ILZ4DecompressStream(&source, false);
+#else
+    express_cat.error()
+      << "LZ4 not compiled in; cannot decompress LZ4 stream.\n";
+    return false;
+#endif  // HAVE_LZ4
+  } else if (source.peek() == (int)(ZstdStreamBuf::frame_magic & 0xff)) {
+    // Nor can a zstd frame; the zlib streams we write always begin with 0x78.
+    decompress = new IZstdDecompressStream(&source, false);
+  } else {
+#ifdef HAVE_ZLIB
+    decompress = new IDecompressStream(&source, false);
+#else
+    express_cat.error()
+      << "zlib not compiled in; cannot decompress zlib stream.\n";
+    return false;
+#endif  // HAVE_ZLIB
+  }
 
   static const size_t buffer_size = 4096;
   char buffer[buffer_size];
 
-  decompress.read(buffer, buffer_size);
-  size_t count = decompress.gcount();
+  decompress->read(buffer, buffer_size);
+  size_t count = decompress->gcount();
   while (count != 0) {
     dest.write(buffer, count);
-    decompress.read(buffer, buffer_size);
-    count = decompress.gcount();
+    decompress->read(buffer, buffer_size);
+    count = decompress->gcount();
   }
 
-  return (!decompress.fail() || decompress.eof()) && (!dest.fail());
+  bool success = (!decompress->fail() || decompress->eof()) && (!dest.fail());
+  delete decompress;
+  return success;
 }
-
-#endif // HAVE_ZLIB
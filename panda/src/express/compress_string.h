@@ -15,31 +15,30 @@
 #define COMPRESS_STRING_H
 
 #include "pandabase.h"
-
-#ifdef HAVE_ZLIB
-
+#include "compressionCodec.h"
 #include "filename.h"
 
 BEGIN_PUBLISH
 
 EXPCL_PANDA_EXPRESS std::string
-compress_string(const std::string &source, int compression_level);
+compress_string(const std::string &source, int compression_level,
+                CompressionCodec codec = CC_zlib);
 
 EXPCL_PANDA_EXPRESS std::string
 decompress_string(const std::string &source);
 
 EXPCL_PANDA_EXPRESS bool
-compress_file(const Filename &source, const Filename &dest, int compression_level);
+compress_file(const Filename &source, const Filename &dest, int compression_level,
+              CompressionCodec codec = CC_zlib);
 EXPCL_PANDA_EXPRESS bool
 decompress_file(const Filename &source, const Filename &dest);
 
 EXPCL_PANDA_EXPRESS bool
-compress_stream(std::istream &source, std::ostream &dest, int compression_level);
+compress_stream(std::istream &source, std::ostream &dest, int compression_level,
+                CompressionCodec codec = CC_zlib);
 EXPCL_PANDA_EXPRESS bool
 decompress_stream(std::istream &source, std::ostream &dest);
 
 END_PUBLISH
 
-#endif  // HAVE_ZLIB
-
 #endif
@@ -0,0 +1,65 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file compressionCodec.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "compressionCodec.h"
+#include "config_express.h"
+#include "string_utils.h"
+
+using std::istream;
+using std::ostream;
+using std::string;
+
+ostream &
+operator << (ostream &out, CompressionCodec codec) {
+  switch (codec) {
+  case CC_none:
+    return out << "none";
+
+  case CC_zlib:
+    return out << "zlib";
+
+  case CC_lz4:
+    return out << "lz4";
+
+  case CC_zstd:
+    return out << "zstd";
+  }
+
+  return out << "**invalid CompressionCodec (" << (int)codec << ")**";
+}
+
+istream &
+operator >> (istream &in, CompressionCodec &codec) {
+  string word;
+  in >> word;
+
+  if (cmp_nocase(word, "none") == 0 || word == "0") {
+    codec = CC_none;
+
+  } else if (cmp_nocase(word, "zlib") == 0) {
+    codec = CC_zlib;
+
+  } else if (cmp_nocase(word, "lz4") == 0) {
+    codec = CC_lz4;
+
+  } else if (cmp_nocase(word, "zstd") == 0) {
+    codec = CC_zstd;
+
+  } else {
+    express_cat->error()
+      << "Invalid CompressionCodec value: " << word << "\n";
+    codec = CC_none;
+  }
+
+  return in;
+}
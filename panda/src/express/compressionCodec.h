@@ -0,0 +1,48 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file compressionCodec.h
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#ifndef COMPRESSIONCODEC_H
+#define COMPRESSIONCODEC_H
+
+#include "pandabase.h"
+
+BEGIN_PUBLISH
+
+enum CompressionCodec {
+  // No compression at all.
+  CC_none,
+
+  // zlib's deflate.  This gives a good compression ratio, and is the
+  // historical default, but it is relatively slow to decompress.  It is only
+  // available if Panda was compiled with zlib.
+  CC_zlib,
+
+  // The LZ4 frame format.  This decompresses several times faster than zlib,
+  // at a somewhat lower ratio.  Compression levels 1 and 2 favor compression
+  // speed; higher levels search harder for matches, which improves the ratio
+  // without affecting the decompression speed.  It is only available if
+  // Panda was compiled with the LZ4 library.
+  CC_lz4,
+
+  // The Zstandard frame format.  This usually compresses better than zlib,
+  // and decompresses faster, though not as fast as LZ4.  Levels range from 1
+  // to 19.  This is always available.
+  CC_zstd,
+};
+
+END_PUBLISH
+
+EXPCL_PANDA_EXPRESS std::ostream &operator << (std::ostream &out, CompressionCodec codec);
+EXPCL_PANDA_EXPRESS std::istream &operator >> (std::istream &in, CompressionCodec &codec);
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file lz4Stream.h
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#ifndef LZ4STREAM_H
+#define LZ4STREAM_H
+
+#include "pandabase.h"
+
+// This module is not compiled if the LZ4 library is not available.
+#ifdef HAVE_LZ4
+
+#include "lz4StreamBuf.h"
+
+/**
+ * An input stream object that decompresses LZ4-compressed input from another
+ * source stream on-the-fly.  This is the LZ4 counterpart of
+ * IDecompressStream; it decompresses considerably faster, at the cost of a
+ * lower compression ratio.  It is only available if Panda was compiled with
+ * the LZ4 library.
+ *
+ * Seeking is not supported, other than back to the beginning.
+ */
+class EXPCL_PANDA_EXPRESS ILZ4DecompressStream : public std::istream {
+PUBLISHED:
+  INLINE ILZ4DecompressStream();
+  INLINE explicit ILZ4DecompressStream(std::istream *source, bool owns_source);
+
+#if _MSC_VER >= 1800
+  INLINE ILZ4DecompressStream(const ILZ4DecompressStream &copy) = delete;
+#endif
+
+  INLINE ILZ4DecompressStream &open(std::istream *source, bool owns_source);
+  INLINE ILZ4DecompressStream &close();
+
+private:
+  LZ4StreamBuf _buf;
+};
+
+/**
+ * An output stream object that compresses data with LZ4 to another
+ * destination stream on-the-fly.  This is the LZ4 counterpart of
+ * OCompressStream.
+ *
+ * Seeking is not supported.
+ */
+class EXPCL_PANDA_EXPRESS OLZ4CompressStream : public std::ostream {
+PUBLISHED:
+  INLINE OLZ4CompressStream();
+  INLINE explicit OLZ4CompressStream(std::ostream *dest, bool owns_dest,
+                                     int compression_level = 1);
+
+#if _MSC_VER >= 1800
+  INLINE OLZ4CompressStream(const OLZ4CompressStream &copy) = delete;
+#endif
+
+  INLINE OLZ4CompressStream &open(std::ostream *dest, bool owns_dest,
+                                  int compression_level = 1);
+  INLINE OLZ4CompressStream &close();
+
+private:
+  LZ4StreamBuf _buf;
+};
+
+#include "lz4Stream.I"
+
+#endif  // HAVE_LZ4
+
+#endif
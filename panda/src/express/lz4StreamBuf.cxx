@@ -0,0 +1,458 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file lz4StreamBuf.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "lz4StreamBuf.h"
+
+#ifdef HAVE_LZ4
+
+#include "pnotify.h"
+#include "config_express.h"
+
+#include <lz4frame.h>
+
+using std::ios;
+using std::streamoff;
+using std::streampos;
+
+// The data is compressed in blocks of up to 64 KB, which is also the size of
+// the buffer in which we collect the data to compress.
+static const size_t lz4_block_size = 0x10000;
+
+// The values of end_op accepted by write_chars().
+enum LZ4EndOp {
+  LEO_continue,
+  LEO_flush,
+  LEO_end,
+};
+
+/**
+ * Fills in the frame preferences for the indicated compression level.  We
+ * write independent blocks of up to 64 KB, followed by a checksum of the
+ * whole content.
+ */
+static void
+lz4_get_preferences(LZ4F_preferences_t &prefs, int compression_level) {
+  memset(&prefs, 0, sizeof(prefs));
+  prefs.frameInfo.blockSizeID = LZ4F_max64KB;
+  prefs.frameInfo.blockMode = LZ4F_blockIndependent;
+  prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+  prefs.compressionLevel = compression_level;
+}
+
+/**
+ *
+ */
+LZ4StreamBuf::
+LZ4StreamBuf() {
+  _source = nullptr;
+  _owns_source = false;
+  _dest = nullptr;
+  _owns_dest = false;
+  _dctx = nullptr;
+  _cctx = nullptr;
+
+  _read_error = false;
+  _frame_complete = true;
+  _output_pending = false;
+  _total_out = 0;
+  _in_buffer = nullptr;
+  _in_buffer_size = 0;
+  _in_pos = 0;
+  _in_end = 0;
+  _read_buffer = nullptr;
+  _read_buffer_size = 0;
+
+  _compression_level = 0;
+  _write_buffer = nullptr;
+  _write_buffer_size = 0;
+  _out_buffer = nullptr;
+  _out_buffer_size = 0;
+
+  setg(nullptr, nullptr, nullptr);
+  setp(nullptr, nullptr);
+}
+
+/**
+ *
+ */
+LZ4StreamBuf::
+~LZ4StreamBuf() {
+  close_read();
+  close_write();
+}
+
+/**
+ *
+ */
+void LZ4StreamBuf::
+open_read(std::istream *source, bool owns_source) {
+  close_read();
+
+  _source = source;
+  _owns_source = owns_source;
+
+  LZ4F_dctx *dctx = nullptr;
+  LZ4F_errorCode_t result = LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION);
+  if (LZ4F_isError(result)) {
+    express_cat.error()
+      << "Could not create LZ4 decompression context: "
+      << LZ4F_getErrorName(result) << "\n";
+    _read_error = true;
+    return;
+  }
+  _dctx = dctx;
+
+  _in_buffer_size = lz4_block_size;
+  _in_buffer = (char *)PANDA_MALLOC_ARRAY(_in_buffer_size);
+  _read_buffer_size = lz4_block_size;
+  _read_buffer = (char *)PANDA_MALLOC_ARRAY(_read_buffer_size);
+
+  _read_error = false;
+  _frame_complete = true;
+  _output_pending = false;
+  _total_out = 0;
+  _in_pos = 0;
+  _in_end = 0;
+  setg(_read_buffer, _read_buffer, _read_buffer);
+}
+
+/**
+ *
+ */
+void LZ4StreamBuf::
+close_read() {
+  if (_source != nullptr) {
+    if (_owns_source) {
+      delete _source;
+      _owns_source = false;
+    }
+    _source = nullptr;
+  }
+
+  if (_dctx != nullptr) {
+    LZ4F_freeDecompressionContext(_dctx);
+    _dctx = nullptr;
+  }
+  if (_in_buffer != nullptr) {
+    PANDA_FREE_ARRAY(_in_buffer);
+    _in_buffer = nullptr;
+    _in_buffer_size = 0;
+  }
+  if (_read_buffer != nullptr) {
+    PANDA_FREE_ARRAY(_read_buffer);
+    _read_buffer = nullptr;
+    _read_buffer_size = 0;
+  }
+  setg(nullptr, nullptr, nullptr);
+}
+
+/**
+ *
+ */
+void LZ4StreamBuf::
+open_write(std::ostream *dest, bool owns_dest, int compression_level) {
+  close_write();
+
+  _dest = dest;
+  _owns_dest = owns_dest;
+  _compression_level = compression_level;
+
+  LZ4F_cctx *cctx = nullptr;
+  LZ4F_errorCode_t result = LZ4F_createCompressionContext(&cctx, LZ4F_VERSION);
+  if (LZ4F_isError(result)) {
+    express_cat.error()
+      << "Could not create LZ4 compression context: "
+      << LZ4F_getErrorName(result) << "\n";
+    return;
+  }
+  _cctx = cctx;
+
+  // The out buffer must be able to hold the result of compressing a full
+  // write buffer, along with the end of the frame.
+  LZ4F_preferences_t prefs;
+  lz4_get_preferences(prefs, _compression_level);
+  _write_buffer_size = lz4_block_size;
+  _write_buffer = (char *)PANDA_MALLOC_ARRAY(_write_buffer_size);
+  _out_buffer_size = LZ4F_compressBound(_write_buffer_size, &prefs);
+  if (_out_buffer_size < LZ4F_HEADER_SIZE_MAX) {
+    _out_buffer_size = LZ4F_HEADER_SIZE_MAX;
+  }
+  _out_buffer = (char *)PANDA_MALLOC_ARRAY(_out_buffer_size);
+  setp(_write_buffer, _write_buffer + _write_buffer_size);
+
+  // Write the frame header.
+  size_t header_size = LZ4F_compressBegin(_cctx, _out_buffer, _out_buffer_size, &prefs);
+  if (LZ4F_isError(header_size)) {
+    express_cat.error()
+      << "LZ4 compression failed: " << LZ4F_getErrorName(header_size) << "\n";
+    return;
+  }
+  _dest->write(_out_buffer, header_size);
+}
+
+/**
+ *
+ */
+void LZ4StreamBuf::
+close_write() {
+  if (_dest != nullptr) {
+    if (_cctx != nullptr) {
+      // Compress whatever is left, and end the frame.
+      size_t n = pptr() - pbase();
+      write_chars(pbase(), n, LEO_end);
+      pbump(-(int)n);
+    }
+
+    if (_owns_dest) {
+      delete _dest;
+      _owns_dest = false;
+    }
+    _dest = nullptr;
+  }
+
+  if (_cctx != nullptr) {
+    LZ4F_freeCompressionContext(_cctx);
+    _cctx = nullptr;
+  }
+  if (_write_buffer != nullptr) {
+    PANDA_FREE_ARRAY(_write_buffer);
+    _write_buffer = nullptr;
+    _write_buffer_size = 0;
+  }
+  if (_out_buffer != nullptr) {
+    PANDA_FREE_ARRAY(_out_buffer);
+    _out_buffer = nullptr;
+    _out_buffer_size = 0;
+  }
+  setp(nullptr, nullptr);
+}
+
+/**
+ * Implements seeking within the stream.  LZ4StreamBuf only allows seeking
+ * back to the beginning of the stream.
+ */
+streampos LZ4StreamBuf::
+seekoff(streamoff off, ios_seekdir dir, ios_openmode which) {
+  if (which != ios::in || _source == nullptr || _dctx == nullptr) {
+    // We can only do this with the input stream.
+    return -1;
+  }
+
+  // Determine the current position.
+  size_t n = egptr() - gptr();
+  streampos gpos = _total_out - (streamoff)n;
+
+  // Implement tellg() and seeks to current position.
+  if ((dir == ios::cur && off == 0) ||
+      (dir == ios::beg && off == gpos)) {
+    return gpos;
+  }
+
+  if (off != 0 || dir != ios::beg) {
+    // We only know how to reposition to the beginning.
+    return -1;
+  }
+
+  if (_source->rdbuf()->pubseekpos(0, ios::in) == (streampos)0) {
+    _source->clear();
+    LZ4F_resetDecompressionContext(_dctx);
+    _read_error = false;
+    _frame_complete = true;
+    _output_pending = false;
+    _total_out = 0;
+    _in_pos = 0;
+    _in_end = 0;
+    setg(_read_buffer, _read_buffer, _read_buffer);
+    return 0;
+  }
+
+  return -1;
+}
+
+/**
+ * Implements seeking within the stream.  LZ4StreamBuf only allows seeking
+ * back to the beginning of the stream.
+ */
+streampos LZ4StreamBuf::
+seekpos(streampos pos, ios_openmode which) {
+  return seekoff(pos, ios::beg, which);
+}
+
+/**
+ * Called by the system ostream implementation when its internal buffer is
+ * filled, plus one character.
+ */
+int LZ4StreamBuf::
+overflow(int ch) {
+  if (_dest == nullptr || _cctx == nullptr) {
+    return EOF;
+  }
+
+  size_t n = pptr() - pbase();
+  if (n != 0) {
+    bool okflag = write_chars(pbase(), n, LEO_continue);
+    pbump(-(int)n);
+    if (!okflag) {
+      return EOF;
+    }
+  }
+
+  if (ch != EOF) {
+    // Write one more character.
+    *pptr() = (char)ch;
+    pbump(1);
+  }
+
+  return 0;
+}
+
+/**
+ * Called by the system iostream implementation to implement a flush
+ * operation.  This flushes all of the data written so far to the dest
+ * stream, without ending the frame.
+ */
+int LZ4StreamBuf::
+sync() {
+  if (_dest != nullptr && _cctx != nullptr) {
+    size_t n = pptr() - pbase();
+    bool okflag = write_chars(pbase(), n, LEO_flush);
+    pbump(-(int)n);
+    _dest->flush();
+    if (!okflag) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Called by the system istream implementation when its internal buffer needs
+ * more characters.
+ */
+int LZ4StreamBuf::
+underflow() {
+  // Sometimes underflow() is called even if the buffer is not empty.
+  if (gptr() >= egptr()) {
+    if (_source == nullptr || _dctx == nullptr) {
+      return EOF;
+    }
+
+    size_t read_count = read_chars(_read_buffer, _read_buffer_size);
+    if (read_count == 0) {
+      return EOF;
+    }
+    _total_out += read_count;
+    setg(_read_buffer, _read_buffer, _read_buffer + read_count);
+  }
+
+  return (unsigned char)*gptr();
+}
+
+/**
+ * Decompresses up to length bytes from the source stream into the indicated
+ * buffer.  Returns the number of bytes produced, which is 0 only at the end
+ * of the stream or on error.
+ */
+size_t LZ4StreamBuf::
+read_chars(char *start, size_t length) {
+  if (_read_error) {
+    return 0;
+  }
+
+  size_t produced = 0;
+  while (produced == 0) {
+    // If the last call filled up the output buffer, the library may still be
+    // holding more output, which we must collect before reading any more.
+    if (_in_pos == _in_end && !_output_pending) {
+      _source->read(_in_buffer, _in_buffer_size);
+      _in_end = (size_t)_source->gcount();
+      _in_pos = 0;
+      if (_in_end == 0) {
+        if (!_frame_complete) {
+          express_cat.error()
+            << "Truncated LZ4 stream.\n";
+          _read_error = true;
+        }
+        return 0;
+      }
+    }
+
+    size_t out_size = length;
+    size_t in_size = _in_end - _in_pos;
+    size_t result = LZ4F_decompress(_dctx, start, &out_size,
+                                    _in_buffer + _in_pos, &in_size, nullptr);
+    _in_pos += in_size;
+    thread_consider_yield();
+
+    if (LZ4F_isError(result)) {
+      express_cat.error()
+        << "LZ4 stream is corrupt: " << LZ4F_getErrorName(result) << "\n";
+      _read_error = true;
+      return 0;
+    }
+
+    // A return value of 0 means that a frame was completely decoded and its
+    // checksum verified.  Any further input begins a new frame.
+    _frame_complete = (result == 0);
+    _output_pending = (out_size == length);
+    produced = out_size;
+  }
+
+  return produced;
+}
+
+/**
+ * Compresses the indicated data and writes the compressed output to the dest
+ * stream.  end_op is one of LEO_continue, LEO_flush or LEO_end.  Returns true
+ * on success, false on error.
+ */
+bool LZ4StreamBuf::
+write_chars(const char *start, size_t length, int end_op) {
+  // The write buffer is never larger than the size that the out buffer was
+  // allocated for, so each call fits in the out buffer.
+  nassertr(length <= _write_buffer_size, false);
+
+  size_t out_size = 0;
+  if (length != 0) {
+    out_size = LZ4F_compressUpdate(_cctx, _out_buffer, _out_buffer_size,
+                                   start, length, nullptr);
+    thread_consider_yield();
+    if (LZ4F_isError(out_size)) {
+      express_cat.error()
+        << "LZ4 compression failed: " << LZ4F_getErrorName(out_size) << "\n";
+      return false;
+    }
+  }
+
+  if (end_op != LEO_continue) {
+    size_t result;
+    if (end_op == LEO_end) {
+      result = LZ4F_compressEnd(_cctx, _out_buffer + out_size,
+                                _out_buffer_size - out_size, nullptr);
+    } else {
+      result = LZ4F_flush(_cctx, _out_buffer + out_size,
+                          _out_buffer_size - out_size, nullptr);
+    }
+    if (LZ4F_isError(result)) {
+      express_cat.error()
+        << "LZ4 compression failed: " << LZ4F_getErrorName(result) << "\n";
+      return false;
+    }
+    out_size += result;
+  }
+
+  _dest->write(_out_buffer, out_size);
+  return true;
+}
+
+#endif  // HAVE_LZ4
@@ -0,0 +1,94 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file lz4StreamBuf.h
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#ifndef LZ4STREAMBUF_H
+#define LZ4STREAMBUF_H
+
+#include "pandabase.h"
+
+// This module is not compiled if the LZ4 library is not available.
+#ifdef HAVE_LZ4
+
+#include "numeric_types.h"
+
+struct LZ4F_dctx_s;
+struct LZ4F_cctx_s;
+
+/**
+ * The streambuf object that implements ILZ4DecompressStream and
+ * OLZ4CompressStream.
+ *
+ * This reads and writes the LZ4 frame format using the reference LZ4
+ * library, so the data is interchangeable with the lz4 command-line tool.
+ */
+class EXPCL_PANDA_EXPRESS LZ4StreamBuf : public std::streambuf {
+public:
+  LZ4StreamBuf();
+  virtual ~LZ4StreamBuf();
+
+  void open_read(std::istream *source, bool owns_source);
+  void close_read();
+
+  void open_write(std::ostream *dest, bool owns_dest, int compression_level);
+  void close_write();
+
+  virtual std::streampos seekoff(std::streamoff off, ios_seekdir dir, ios_openmode which);
+  virtual std::streampos seekpos(std::streampos pos, ios_openmode which);
+
+  static const uint32_t frame_magic = 0x184D2204;
+
+protected:
+  virtual int overflow(int c);
+  virtual int sync();
+  virtual int underflow();
+
+private:
+  size_t read_chars(char *start, size_t length);
+  bool write_chars(const char *start, size_t length, int end_op);
+
+private:
+  std::istream *_source;
+  bool _owns_source;
+
+  std::ostream *_dest;
+  bool _owns_dest;
+
+  LZ4F_dctx_s *_dctx;
+  LZ4F_cctx_s *_cctx;
+
+  // The state of the stream being read.  The LZ4 library might not consume
+  // all of the input at each call, so the unconsumed input is kept here.
+  bool _read_error;
+  bool _frame_complete;
+  bool _output_pending;
+  std::streamoff _total_out;
+  char *_in_buffer;
+  size_t _in_buffer_size;
+  size_t _in_pos;
+  size_t _in_end;
+
+  char *_read_buffer;
+  size_t _read_buffer_size;
+
+  // The uncompressed data is collected in the write buffer, and compressed a
+  // block at a time into the out buffer.
+  int _compression_level;
+  char *_write_buffer;
+  size_t _write_buffer_size;
+  char *_out_buffer;
+  size_t _out_buffer_size;
+};
+
+#endif  // HAVE_LZ4
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedFile.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "mappedFile.h"
+#include "config_express.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Unmaps the file.
+ */
+MappedFile::
+~MappedFile() {
+  if (_data == nullptr) {
+    return;
+  }
+#ifdef _WIN32
+  UnmapViewOfFile((LPCVOID)_data);
+  CloseHandle((HANDLE)_handle);
+#else
+  munmap((void *)_data, _size);
+#endif
+}
+
+/**
+ * Maps the indicated file, which must be a file on the actual OS filesystem,
+ * not in the virtual file system.  Returns NULL if the file cannot be mapped,
+ * for instance because it does not exist or is empty.
+ */
+PT(MappedFile) MappedFile::
+open(const Filename &filename) {
+  PT(MappedFile) mapping = new MappedFile(filename);
+
+#ifdef _WIN32
+  std::wstring os_filename = filename.to_os_specific_w();
+  HANDLE file = CreateFileW(os_filename.c_str(), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return nullptr;
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return nullptr;
+  }
+
+  HANDLE handle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (handle == nullptr) {
+    return nullptr;
+  }
+
+  void *data = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr) {
+    CloseHandle(handle);
+    return nullptr;
+  }
+
+  mapping->_data = (const unsigned char *)data;
+  mapping->_size = (size_t)size.QuadPart;
+  mapping->_handle = (void *)handle;
+
+#else
+  std::string os_filename = filename.to_os_specific();
+  int fd = ::open(os_filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  void *data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+
+  mapping->_data = (const unsigned char *)data;
+  mapping->_size = (size_t)st.st_size;
+#endif
+
+  if (express_cat.is_debug()) {
+    express_cat.debug()
+      << "Mapped " << mapping->_size << " bytes of " << filename << "\n";
+  }
+  return mapping;
+}
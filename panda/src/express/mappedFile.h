@@ -0,0 +1,61 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mappedFile.h
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include "pandabase.h"
+
+#include "referenceCount.h"
+#include "filename.h"
+
+/**
+ * A read-only memory mapping of an entire file on disk.  The mapping remains
+ * valid for as long as the MappedFile object exists, so anything that keeps a
+ * pointer into it should also keep a reference to the MappedFile.
+ *
+ * The pages are mapped privately and read-only, which means that several
+ * processes mapping the same file share the same physical memory.  Nothing
+ * may write through the pointer; a client that wants to modify the data must
+ * copy it out first.
+ *
+ * Note that the file must not be truncated or rewritten in place while it is
+ * mapped.  Panda's own tools replace files by renaming a new file over the
+ * old one, which is safe.
+ */
+class EXPCL_PANDA_EXPRESS MappedFile : public ReferenceCount {
+private:
+  INLINE MappedFile(const Filename &filename);
+
+public:
+  ~MappedFile();
+
+  static PT(MappedFile) open(const Filename &filename);
+
+  INLINE const Filename &get_filename() const;
+  INLINE const unsigned char *get_data() const;
+  INLINE size_t get_size() const;
+
+private:
+  Filename _filename;
+  const unsigned char *_data;
+  size_t _size;
+
+#ifdef _WIN32
+  void *_handle;
+#endif
+};
+
+#include "mappedFile.I"
+
+#endif
@@ -18,6 +18,9 @@
 #include "streamReader.h"
 #include "datagram.h"
 #include "zStream.h"
+#include "lz4Stream.h"
+#include "zstdStream.h"
+#include "configVariableEnum.h"
 #include "encryptStream.h"
 #include "virtualFileSystem.h"
 #include "virtualFile.h"
@@ -50,8 +53,11 @@ const size_t Multifile::_header_size = 6;
 // version may still be read.
 const int Multifile::_current_major_ver = 1;
 
-const int Multifile::_current_minor_ver = 1;
+const int Multifile::_current_minor_ver = 2;
 // Bumped to version 1.1 on 6806 to add timestamps.
+// Bumped to version 1.2 to add the LZ4 and zstd compression flags.  Files
+// that don't use these are still written as version 1.1, so that older
+// readers can read them.
 
 // To confirm that the supplied password matches, we write the Mutifile magic
 // header at the beginning of the encrypted stream.  I suppose this does
@@ -115,6 +121,22 @@ Multifile() :
               "be loaded quickly, without paying the cost of an expensive hash on "
               "each subfile in order to decrypt it."));
 
+  // Without zlib, zstd is the default codec instead, since it is always
+  // compiled in.
+#ifdef HAVE_ZLIB
+  static const CompressionCodec default_compression_codec = CC_zlib;
+#else
+  static const CompressionCodec default_compression_codec = CC_zstd;
+#endif
+
+  ConfigVariableEnum<CompressionCodec> multifile_compression_codec
+    ("multifile-compression-codec", default_compression_codec,
+     PRC_DESC("The codec used to compress subfiles that are added to a multifile "
+              "with a nonzero compression level.  Set this to lz4 for subfiles "
+              "that decompress much faster than zlib, at a lower compression "
+              "ratio, or to zstd for a better ratio than zlib that still "
+              "decompresses faster."));
+
   _read = nullptr;
   _write = nullptr;
   _offset = 0;
@@ -130,6 +152,8 @@ Multifile() :
   _new_scale_factor = 1;
   _encryption_flag = false;
   _encryption_iteration_count = multifile_encryption_iteration_count;
+  _compression_codec = CC_none;
+  set_compression_codec(multifile_compression_codec);
   _file_major_ver = 0;
   _file_minor_ver = 0;
 
@@ -1138,7 +1162,7 @@ flush() {
     }
 
   } else {
-    if (_file_minor_ver != _current_minor_ver) {
+    if (_file_minor_ver < get_required_minor_ver()) {
       // If we *do* have an index already, but this is an old version
       // multifile, we have to completely rewrite it anyway.
       return repack();
@@ -1519,6 +1543,26 @@ is_subfile_compressed(int index) const {
   return (_subfiles[index]->_flags & SF_compressed) != 0;
 }
 
+/**
+ * Returns the codec with which the indicated subfile has been compressed, or
+ * CC_none if it is not compressed.
+ */
+CompressionCodec Multifile::
+get_subfile_compression_codec(int index) const {
+  nassertr(index >= 0 && index < (int)_subfiles.size(), CC_none);
+  int flags = _subfiles[index]->_flags;
+  if ((flags & SF_compressed) == 0) {
+    return CC_none;
+  }
+  if ((flags & SF_lz4) != 0) {
+    return CC_lz4;
+  }
+  if ((flags & SF_zstd) != 0) {
+    return CC_zstd;
+  }
+  return CC_zlib;
+}
+
 /**
  * Returns true if the indicated subfile has been encrypted when stored within
  * the archive, false otherwise.
@@ -1990,14 +2034,24 @@ pad_to_streampos(streampos fpos) {
 void Multifile::
 add_new_subfile(Subfile *subfile, int compression_level) {
   if (compression_level != 0) {
+    if (_compression_codec == CC_lz4) {
+      subfile->_flags |= SF_compressed | SF_lz4;
+      subfile->_compression_level = compression_level;
+
+    } else if (_compression_codec == CC_zstd) {
+      subfile->_flags |= SF_compressed | SF_zstd;
+      subfile->_compression_level = compression_level;
+
+    } else if (_compression_codec == CC_zlib) {
 #ifndef HAVE_ZLIB
-    express_cat.warning()
-      << "zlib not compiled in; cannot generated compressed multifiles.\n";
-    compression_level = 0;
+      express_cat.warning()
+        << "zlib not compiled in; cannot generated compressed multifiles.\n";
+      compression_level = 0;
 #else  // HAVE_ZLIB
-    subfile->_flags |= SF_compressed;
-    subfile->_compression_level = compression_level;
+      subfile->_flags |= SF_compressed;
+      subfile->_compression_level = compression_level;
 #endif  // HAVE_ZLIB
+    }
   }
 
 #ifdef HAVE_OPENSSL
@@ -2077,7 +2131,24 @@ open_read_subfile(Subfile *subfile) {
 #endif  // HAVE_OPENSSL
   }
 
-  if ((subfile->_flags & SF_compressed) != 0) {
+  if ((subfile->_flags & SF_lz4) != 0) {
+#ifndef HAVE_LZ4
+    express_cat.error()
+      << "LZ4 not compiled in; cannot read LZ4-compressed subfiles.\n";
+    delete stream;
+    return nullptr;
+#else  // HAVE_LZ4
+    // The subfile is compressed with LZ4.
+    ILZ4DecompressStream *wrapper = new ILZ4DecompressStream(stream, true);
+    stream = wrapper;
+#endif  // HAVE_LZ4
+
+  } else if ((subfile->_flags & SF_zstd) != 0) {
+    // The subfile is compressed with zstd.
+    IZstdDecompressStream *wrapper = new IZstdDecompressStream(stream, true);
+    stream = wrapper;
+
+  } else if ((subfile->_flags & SF_compressed) != 0) {
 #ifndef HAVE_ZLIB
     express_cat.error()
       << "zlib not compiled in; cannot read compressed multifiles.\n";
@@ -2335,21 +2406,41 @@ read_index() {
   return true;
 }
 
+/**
+ * Returns the lowest minor version that can describe all of the subfiles.
+ * This is the current version if any subfile is compressed with LZ4 or zstd,
+ * which older readers would otherwise mistake for zlib.
+ */
+int Multifile::
+get_required_minor_ver() const {
+  for (const Subfile *subfile : _subfiles) {
+    if ((subfile->_flags & (SF_lz4 | SF_zstd)) != 0) {
+      return _current_minor_ver;
+    }
+  }
+  for (const Subfile *subfile : _new_subfiles) {
+    if ((subfile->_flags & (SF_lz4 | SF_zstd)) != 0) {
+      return _current_minor_ver;
+    }
+  }
+  return 1;
+}
+
 /**
  * Writes just the header part of the Multifile, not the index.
  */
 bool Multifile::
 write_header() {
   _file_major_ver = _current_major_ver;
-  _file_minor_ver = _current_minor_ver;
+  _file_minor_ver = get_required_minor_ver();
 
   nassertr(_write != nullptr, false);
   nassertr(_write->tellp() == (streampos)0, false);
   _write->write(_header_prefix.data(), _header_prefix.size());
   _write->write(_header, _header_size);
   StreamWriter writer(_write, false);
-  writer.add_int16(_current_major_ver);
-  writer.add_int16(_current_minor_ver);
+  writer.add_int16(_file_major_ver);
+  writer.add_int16(_file_minor_ver);
   writer.add_uint32(_scale_factor);
 
   if (_record_timestamp) {
@@ -2683,17 +2774,32 @@ write_data(ostream &write, istream *read, streampos fpos,
     }
 #endif  // HAVE_OPENSSL
 
+    if ((_flags & SF_lz4) != 0) {
+#ifndef HAVE_LZ4
+      // Without LZ4, the flag had better not be set.
+      nassertr(false, fpos);
+#else  // HAVE_LZ4
+      // Write it compressed with LZ4.
+      putter = new OLZ4CompressStream(putter, delete_putter, _compression_level);
+      delete_putter = true;
+#endif  // HAVE_LZ4
+
+    } else if ((_flags & SF_zstd) != 0) {
+      // Write it compressed with zstd.
+      putter = new OZstdCompressStream(putter, delete_putter, _compression_level);
+      delete_putter = true;
+
+    } else if ((_flags & SF_compressed) != 0) {
 #ifndef HAVE_ZLIB
-    // Without ZLIB, we can't support compression.  The flag had better not be
-    // set.
-    nassertr((_flags & SF_compressed) == 0, fpos);
+      // Without ZLIB, we can't support zlib compression.  The flag had better
+      // not be set.
+      nassertr(false, fpos);
 #else  // HAVE_ZLIB
-    if ((_flags & SF_compressed) != 0) {
       // Write it compressed.
       putter = new OCompressStream(putter, delete_putter, _compression_level);
       delete_putter = true;
-    }
 #endif  // HAVE_ZLIB
+    }
 
     streampos write_start = fpos;
     _uncompressed_length = 0;
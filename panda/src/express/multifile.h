@@ -20,6 +20,7 @@
 #include "streamWrapper.h"
 #include "subStream.h"
 #include "filename.h"
+#include "compressionCodec.h"
 #include "ordered_vector.h"
 #include "indirectLess.h"
 #include "referenceCount.h"
@@ -78,6 +79,9 @@ PUBLISHED:
   INLINE void set_encryption_iteration_count(int encryption_iteration_count);
   INLINE int get_encryption_iteration_count() const;
 
+  INLINE void set_compression_codec(CompressionCodec codec);
+  INLINE CompressionCodec get_compression_codec() const;
+
   std::string add_subfile(const std::string &subfile_name, const Filename &filename,
                      int compression_level);
   std::string add_subfile(const std::string &subfile_name, std::istream *subfile_data,
@@ -118,6 +122,7 @@ PUBLISHED:
   size_t get_subfile_length(int index) const;
   time_t get_subfile_timestamp(int index) const;
   bool is_subfile_compressed(int index) const;
+  CompressionCodec get_subfile_compression_codec(int index) const;
   bool is_subfile_encrypted(int index) const;
   bool is_subfile_text(int index) const;
 
@@ -170,6 +175,8 @@ private:
     SF_encrypted      = 0x0010,
     SF_signature      = 0x0020,
     SF_text           = 0x0040,
+    SF_lz4            = 0x0080,  // With SF_compressed: LZ4 rather than zlib.
+    SF_zstd           = 0x0100,  // With SF_compressed: zstd rather than zlib.
   };
 
   class Subfile {
@@ -218,6 +225,7 @@ private:
   void clear_subfiles();
   bool read_index();
   bool write_header();
+  int get_required_minor_ver() const;
 
   void check_signatures();
 
@@ -256,6 +264,8 @@ private:
   int _encryption_key_length;
   int _encryption_iteration_count;
 
+  CompressionCodec _compression_codec;
+
   pifstream _read_file;
   IStreamWrapper _read_filew;
   pofstream _write_file;
@@ -2,6 +2,7 @@
 #include "checksumHashGenerator.cxx"
 #include "config_express.cxx"
 #include "compress_string.cxx"
+#include "compressionCodec.cxx"
 #include "copy_stream.cxx"
 #include "datagram.cxx"
 #include "datagramGenerator.cxx"
@@ -13,6 +14,9 @@
 #include "fileReference.cxx"
 #include "hashGeneratorBase.cxx"
 #include "hashVal.cxx"
+#include "lz4Stream.cxx"
+#include "lz4StreamBuf.cxx"
+#include "mappedFile.cxx"
 #include "memoryInfo.cxx"
 #include "memoryUsage.cxx"
 #include "memoryUsagePointerCounts.cxx"
@@ -31,4 +31,6 @@
 #include "windowsRegistry.cxx"
 #include "zStream.cxx"
 #include "zStreamBuf.cxx"
+#include "zstdStream.cxx"
+#include "zstdStreamBuf.cxx"
 #include "zipArchive.cxx"
@@ -16,6 +16,8 @@
 #include "virtualFileSystem.h"
 #include "zStream.h"
 
+#include <algorithm>
+
 using std::iostream;
 using std::istream;
 using std::ostream;
@@ -328,6 +330,56 @@ atomic_read_contents(const Filename &file, string &contents) const {
   return false;
 }
 
+/**
+ * Returns false if the indicated file is known not to exist within this
+ * mount, according to a cached listing of its directory, or true if it might
+ * exist.  The listing is read the first time the directory is consulted, and
+ * read again once it is more than max_age seconds old (unless max_age is
+ * negative), or, if check_timestamp is true, whenever the directory's
+ * timestamp changes.
+ *
+ * This is used by the VirtualFileSystem to avoid probing the underlying
+ * storage for files that aren't there.  Assumes the VirtualFileSystem's lock
+ * is held.
+ */
+bool VirtualFileMount::
+might_have_file(const Filename &file, double now, double max_age,
+                bool check_timestamp) {
+  string dirname = file.get_dirname();
+  DirectoryListing &listing = _directory_index[dirname];
+
+  bool stale = (listing._time < 0.0 ||
+                (max_age >= 0.0 && now - listing._time > max_age));
+  time_t timestamp = 0;
+  if (check_timestamp) {
+    timestamp = get_timestamp(dirname);
+    stale = stale || (timestamp != listing._timestamp);
+  }
+
+  if (stale) {
+    listing._time = now;
+    listing._timestamp = timestamp;
+    listing._names.clear();
+    listing._valid = scan_directory(listing._names, dirname);
+    std::sort(listing._names.begin(), listing._names.end());
+  }
+
+  if (!listing._valid) {
+    // We couldn't list the directory, so we don't know.
+    return true;
+  }
+  return std::binary_search(listing._names.begin(), listing._names.end(),
+                            file.get_basename());
+}
+
+/**
+ * Discards the cached directory listings used by might_have_file().
+ */
+void VirtualFileMount::
+clear_directory_index() {
+  _directory_index.clear();
+}
+
 /**
  *
  */
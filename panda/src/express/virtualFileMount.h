@@ -20,6 +20,8 @@
 #include "filename.h"
 #include "pointerTo.h"
 #include "typedReferenceCount.h"
+#include "pmap.h"
+#include "vector_string.h"
 
 class VirtualFileSystem;
 
@@ -82,6 +84,10 @@ public:
   virtual bool atomic_compare_and_exchange_contents(const Filename &file, std::string &orig_contents, const std::string &old_contents, const std::string &new_contents);
   virtual bool atomic_read_contents(const Filename &file, std::string &contents) const;
 
+  bool might_have_file(const Filename &file, double now, double max_age,
+                       bool check_timestamp);
+  void clear_directory_index();
+
 PUBLISHED:
   virtual void output(std::ostream &out) const;
   virtual void write(std::ostream &out) const;
@@ -91,6 +97,21 @@ protected:
   Filename _mount_point;
   int _mount_flags;
 
+private:
+  // The cached directory listings consulted by might_have_file().  These are
+  // maintained by the VirtualFileSystem, under its lock, when
+  // vfs-lookup-cache-time is set.
+  class DirectoryListing {
+  public:
+    INLINE DirectoryListing();
+
+    double _time;
+    time_t _timestamp;
+    bool _valid;
+    vector_string _names;
+  };
+  typedef pmap<std::string, DirectoryListing> DirectoryIndex;
+  DirectoryIndex _directory_index;
 
 public:
   virtual TypeHandle get_type() const {
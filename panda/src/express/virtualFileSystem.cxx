@@ -27,6 +27,7 @@
 #include "configVariableString.h"
 #include "executionEnvironment.h"
 #include "pset.h"
+#include "trueClock.h"
 
 using std::iostream;
 using std::istream;
@@ -34,6 +35,8 @@ using std::ostream;
 using std::string;
 
 VirtualFileSystem *VirtualFileSystem::_global_ptr = nullptr;
+PT(PStatCollectorForwardBase) VirtualFileSystem::_lookup_hits_pcollector;
+PT(PStatCollectorForwardBase) VirtualFileSystem::_lookup_misses_pcollector;
 
 
 /**
@@ -70,10 +73,31 @@ VirtualFileSystem() :
             "will implicitly retrieve a file named 'dirname/mytex.jpg' "
             "within the multifile /c/files/foo.mf, even if the multifile "
             "has not already been mounted.  This makes all of your multifiles "
-            "act like directories."))
+            "act like directories.")),
+  vfs_lookup_cache_time
+  ("vfs-lookup-cache-time", 0.0,
+   PRC_DESC("Set this nonzero to have the VirtualFileSystem remember which "
+            "files it failed to find, and keep a listing of each directory "
+            "it looks in on each mount, so that it needn't probe every "
+            "mount for a file that isn't there.  This is the number of "
+            "seconds for which this information is trusted, or -1 to trust "
+            "it until a mount is added or removed.  In either case, it is "
+            "discarded whenever a file is created through the "
+            "VirtualFileSystem.  This is 0 by default, which disables the "
+            "cache, since files created by other means may not be noticed "
+            "until it expires.")),
+  vfs_lookup_cache_check_mtime
+  ("vfs-lookup-cache-check-mtime", false,
+   PRC_DESC("When vfs-lookup-cache-time is set, setting this true causes the "
+            "cached directory listings to be checked against the "
+            "modification time of the directory each time they are "
+            "consulted.  This notices new files sooner, at the cost of "
+            "checking the directory."))
 {
   _cwd = "/";
   _mount_seq = 0;
+  _missing_files_seq = 0;
+  _has_lookup_cache = false;
 }
 
 /**
@@ -1204,6 +1228,19 @@ parse_option(const string &option, int &flags, string &password) {
   }
 }
 
+/**
+ * Specifies the PStats collectors that count the lookups answered by the
+ * lookup cache (see vfs-lookup-cache-time), and the lookups that had to
+ * search the mounts.  This is called by the pstatclient module, which is not
+ * otherwise accessible here.
+ */
+void VirtualFileSystem::
+set_lookup_cache_collectors(PStatCollectorForwardBase *hits,
+                            PStatCollectorForwardBase *misses) {
+  _lookup_hits_pcollector = hits;
+  _lookup_misses_pcollector = misses;
+}
+
 /**
  * Converts the mount point string supplied by the user to standard form
  * (relative to the current directory, with no double slashes, and not
@@ -1231,6 +1268,7 @@ do_mount(VirtualFileMount *mount, const Filename &mount_point, int flags) {
   mount->_file_system = this;
   mount->_mount_point = normalize_mount_point(mount_point);
   mount->_mount_flags = flags;
+  mount->clear_directory_index();
   _mounts.push_back(mount);
   ++_mount_seq;
   return true;
@@ -1258,6 +1296,40 @@ do_get_file(const Filename &filename, int open_flags) const {
   // Also transparently look for a regular file suffixed .pz.
   Filename strpath_pz = strpath + ".pz";
 
+  double cache_time = vfs_lookup_cache_time;
+  if ((open_flags & (OF_create_file | OF_make_directory | OF_allow_nonexist)) != 0) {
+    // We may be about to create a file, which would make the cache wrong.
+    clear_lookup_cache();
+    cache_time = 0.0;
+  }
+
+  double now = 0.0;
+  bool check_mtime = false;
+  if (cache_time != 0.0) {
+    now = TrueClock::get_global_ptr()->get_short_time();
+    check_mtime = vfs_lookup_cache_check_mtime;
+
+    if (_missing_files_seq != _mount_seq) {
+      // The mounts have changed since we last looked.
+      clear_lookup_cache();
+      _missing_files_seq = _mount_seq;
+    }
+    _has_lookup_cache = true;
+
+    MissingFiles::const_iterator mi = _missing_files.find(strpath);
+    if (mi != _missing_files.end() &&
+        (cache_time < 0.0 || now - (*mi).second <= cache_time)) {
+      // We already know this file doesn't exist.
+      if (_lookup_hits_pcollector != nullptr) {
+        _lookup_hits_pcollector->add_level(1);
+      }
+      return nullptr;
+    }
+    if (_lookup_misses_pcollector != nullptr) {
+      _lookup_misses_pcollector->add_level(1);
+    }
+  }
+
   // Now scan all the mount points, from the back (since later mounts override
   // more recent ones), until a match is found.
   PT(VirtualFile) found_file = nullptr;
@@ -1272,6 +1344,7 @@ do_get_file(const Filename &filename, int open_flags) const {
     --i;
     VirtualFileMount *mount = _mounts[i];
     Filename mount_point = mount->get_mount_point();
+    bool use_index = (cache_time != 0.0 && can_index_mount(mount));
     if (strpath == mount_point) {
       // Here's an exact match on the mount point.  This filename is the root
       // directory of this mount object.
@@ -1281,12 +1354,14 @@ do_get_file(const Filename &filename, int open_flags) const {
       }
     } else if (mount_point.empty()) {
       // This is the root mount point; all files are in here.
-      if (consider_match(found_file, composite_file, mount, strpath,
+      if ((!use_index || mount->might_have_file(strpath, now, cache_time, check_mtime)) &&
+          consider_match(found_file, composite_file, mount, strpath,
                          pathname, false, open_flags)) {
         return found_file;
       }
 #ifdef HAVE_ZLIB
-      if (vfs_implicit_pz) {
+      if (vfs_implicit_pz &&
+          (!use_index || mount->might_have_file(strpath_pz, now, cache_time, check_mtime))) {
         if (consider_match(found_file, composite_file, mount, strpath_pz,
                            pathname, true, open_flags)) {
           return found_file;
@@ -1300,12 +1375,14 @@ do_get_file(const Filename &filename, int open_flags) const {
       // This pathname falls within this mount system.
       Filename local_filename = strpath.substr(mount_point.length() + 1);
       Filename local_filename_pz = strpath_pz.substr(mount_point.length() + 1);
-      if (consider_match(found_file, composite_file, mount, local_filename,
+      if ((!use_index || mount->might_have_file(local_filename, now, cache_time, check_mtime)) &&
+          consider_match(found_file, composite_file, mount, local_filename,
                          pathname, false, open_flags)) {
         return found_file;
       }
 #ifdef HAVE_ZLIB
-      if (vfs_implicit_pz) {
+      if (vfs_implicit_pz &&
+          (!use_index || mount->might_have_file(local_filename_pz, now, cache_time, check_mtime))) {
         // Bingo!
         if (consider_match(found_file, composite_file, mount, local_filename_pz,
                            pathname, true, open_flags)) {
@@ -1335,6 +1412,16 @@ do_get_file(const Filename &filename, int open_flags) const {
     }
   }
 
+  if (found_file == nullptr && cache_time != 0.0 &&
+      _missing_files_seq == _mount_seq) {
+    // Remember that this file doesn't exist.  Don't let this grow without
+    // bound if the application looks up many different files.
+    if (_missing_files.size() >= 65536) {
+      _missing_files.clear();
+    }
+    _missing_files[strpath] = now;
+  }
+
 #if defined(_WIN32) && !defined(NDEBUG)
   if (!found_file) {
     // The file could not be found.  Perhaps this is because the user passed
@@ -1356,6 +1443,37 @@ do_get_file(const Filename &filename, int open_flags) const {
   return found_file;
 }
 
+/**
+ * Returns true if the cached directory listings of the indicated mount may be
+ * used to rule out a filename.  This isn't the case for the OS filesystem if
+ * it is case-insensitive, since the listings are compared case-sensitively.
+ */
+bool VirtualFileSystem::
+can_index_mount(VirtualFileMount *mount) const {
+#if defined(_WIN32) || defined(__APPLE__)
+  if (!vfs_case_sensitive &&
+      mount->is_of_type(VirtualFileMountSystem::get_class_type())) {
+    return false;
+  }
+#endif
+  return true;
+}
+
+/**
+ * Discards everything remembered by the lookup cache.  Assumes the lock is
+ * already held.
+ */
+void VirtualFileSystem::
+clear_lookup_cache() const {
+  if (_has_lookup_cache) {
+    _missing_files.clear();
+    for (VirtualFileMount *mount : _mounts) {
+      mount->clear_directory_index();
+    }
+    _has_lookup_cache = false;
+  }
+}
+
 /**
  * Evaluates one possible filename match found during a get_file() operation.
  * There may be multiple matches for a particular filename due to the
@@ -23,9 +23,12 @@
 #include "dSearchPath.h"
 #include "pointerTo.h"
 #include "config_express.h"
+#include "configVariableDouble.h"
 #include "mutexImpl.h"
 #include "pvector.h"
 #include "zipArchive.h"
+#include "pStatCollectorForwardBase.h"
+#include "pmap.h"
 
 class Multifile;
 class VirtualFileComposite;
@@ -131,6 +134,9 @@ public:
   static void parse_option(const std::string &option,
                           int &flags, std::string &password);
 
+  static void set_lookup_cache_collectors(PStatCollectorForwardBase *hits,
+                                          PStatCollectorForwardBase *misses);
+
 public:
   // These flags are passed to do_get_file() and
   // VirtualFileMount::make_virtual_file() to quality the kind of VirtualFile
@@ -148,6 +154,8 @@ public:
   ConfigVariableBool vfs_case_sensitive;
   ConfigVariableBool vfs_implicit_pz;
   ConfigVariableBool vfs_implicit_mf;
+  ConfigVariableDouble vfs_lookup_cache_time;
+  ConfigVariableBool vfs_lookup_cache_check_mtime;
 
 private:
   Filename normalize_mount_point(const Filename &mount_point) const;
@@ -159,12 +167,26 @@ private:
                       const Filename &original_filename, bool implicit_pz_file,
                       int open_flags) const;
   bool consider_mount_mf(const Filename &filename);
+  bool can_index_mount(VirtualFileMount *mount) const;
+  void clear_lookup_cache() const;
 
   mutable MutexImpl _lock;
   typedef pvector<PT(VirtualFileMount) > Mounts;
   Mounts _mounts;
   unsigned int _mount_seq;
 
+  // The filenames that were recently looked up and not found, with the time
+  // at which each was looked up.  This is only used when
+  // vfs-lookup-cache-time is set, and is cleared whenever the set of mounts
+  // changes, or a file is created.
+  typedef pmap<std::string, double> MissingFiles;
+  mutable MissingFiles _missing_files;
+  mutable unsigned int _missing_files_seq;
+  mutable bool _has_lookup_cache;
+
+  static PT(PStatCollectorForwardBase) _lookup_hits_pcollector;
+  static PT(PStatCollectorForwardBase) _lookup_misses_pcollector;
+
   Filename _cwd;
 
   static VirtualFileSystem *_global_ptr;
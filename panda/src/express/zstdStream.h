@@ -0,0 +1,72 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file zstdStream.h
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#ifndef ZSTDSTREAM_H
+#define ZSTDSTREAM_H
+
+#include "pandabase.h"
+#include "zstdStreamBuf.h"
+
+/**
+ * An input stream object that decompresses Zstandard-compressed input from
+ * another source stream on-the-fly.  This is the zstd counterpart of
+ * IDecompressStream; it decompresses faster than zlib, and usually achieves a
+ * better compression ratio as well.
+ *
+ * Seeking is not supported, other than back to the beginning.
+ */
+class EXPCL_PANDA_EXPRESS IZstdDecompressStream : public std::istream {
+PUBLISHED:
+  INLINE IZstdDecompressStream();
+  INLINE explicit IZstdDecompressStream(std::istream *source, bool owns_source);
+
+#if _MSC_VER >= 1800
+  INLINE IZstdDecompressStream(const IZstdDecompressStream &copy) = delete;
+#endif
+
+  INLINE IZstdDecompressStream &open(std::istream *source, bool owns_source);
+  INLINE IZstdDecompressStream &close();
+
+private:
+  ZstdStreamBuf _buf;
+};
+
+/**
+ * An output stream object that compresses data with Zstandard to another
+ * destination stream on-the-fly.  This is the zstd counterpart of
+ * OCompressStream.  The compression level ranges from 1 to 19, as with the
+ * zstd command-line tool.
+ *
+ * Seeking is not supported.
+ */
+class EXPCL_PANDA_EXPRESS OZstdCompressStream : public std::ostream {
+PUBLISHED:
+  INLINE OZstdCompressStream();
+  INLINE explicit OZstdCompressStream(std::ostream *dest, bool owns_dest,
+                                     int compression_level = 3);
+
+#if _MSC_VER >= 1800
+  INLINE OZstdCompressStream(const OZstdCompressStream &copy) = delete;
+#endif
+
+  INLINE OZstdCompressStream &open(std::ostream *dest, bool owns_dest,
+                                  int compression_level = 3);
+  INLINE OZstdCompressStream &close();
+
+private:
+  ZstdStreamBuf _buf;
+};
+
+#include "zstdStream.I"
+
+#endif
@@ -0,0 +1,388 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file zstdStreamBuf.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "zstdStreamBuf.h"
+#include "pnotify.h"
+#include "config_express.h"
+
+#include "zstd/zstd.h"
+
+using std::ios;
+using std::streamoff;
+using std::streampos;
+
+/**
+ *
+ */
+ZstdStreamBuf::
+ZstdStreamBuf() {
+  _source = nullptr;
+  _owns_source = false;
+  _dest = nullptr;
+  _owns_dest = false;
+  _dctx = nullptr;
+  _cctx = nullptr;
+
+  _read_error = false;
+  _frame_complete = true;
+  _output_pending = false;
+  _total_out = 0;
+  _in_buffer = nullptr;
+  _in_buffer_size = 0;
+  _in_pos = 0;
+  _in_end = 0;
+  _read_buffer = nullptr;
+  _read_buffer_size = 0;
+
+  _write_buffer = nullptr;
+  _write_buffer_size = 0;
+  _out_buffer = nullptr;
+  _out_buffer_size = 0;
+
+  setg(nullptr, nullptr, nullptr);
+  setp(nullptr, nullptr);
+}
+
+/**
+ *
+ */
+ZstdStreamBuf::
+~ZstdStreamBuf() {
+  close_read();
+  close_write();
+}
+
+/**
+ *
+ */
+void ZstdStreamBuf::
+open_read(std::istream *source, bool owns_source) {
+  close_read();
+
+  _source = source;
+  _owns_source = owns_source;
+
+  _dctx = ZSTD_createDCtx();
+  nassertv(_dctx != nullptr);
+
+  // These are the buffer sizes recommended by the library.
+  _in_buffer_size = ZSTD_DStreamInSize();
+  _in_buffer = (char *)PANDA_MALLOC_ARRAY(_in_buffer_size);
+  _read_buffer_size = ZSTD_DStreamOutSize();
+  _read_buffer = (char *)PANDA_MALLOC_ARRAY(_read_buffer_size);
+
+  _read_error = false;
+  _frame_complete = true;
+  _output_pending = false;
+  _total_out = 0;
+  _in_pos = 0;
+  _in_end = 0;
+  setg(_read_buffer, _read_buffer, _read_buffer);
+}
+
+/**
+ *
+ */
+void ZstdStreamBuf::
+close_read() {
+  if (_source != nullptr) {
+    if (_owns_source) {
+      delete _source;
+      _owns_source = false;
+    }
+    _source = nullptr;
+  }
+
+  if (_dctx != nullptr) {
+    ZSTD_freeDCtx(_dctx);
+    _dctx = nullptr;
+  }
+  if (_in_buffer != nullptr) {
+    PANDA_FREE_ARRAY(_in_buffer);
+    _in_buffer = nullptr;
+    _in_buffer_size = 0;
+  }
+  if (_read_buffer != nullptr) {
+    PANDA_FREE_ARRAY(_read_buffer);
+    _read_buffer = nullptr;
+    _read_buffer_size = 0;
+  }
+  setg(nullptr, nullptr, nullptr);
+}
+
+/**
+ *
+ */
+void ZstdStreamBuf::
+open_write(std::ostream *dest, bool owns_dest, int compression_level) {
+  close_write();
+
+  _dest = dest;
+  _owns_dest = owns_dest;
+
+  _cctx = ZSTD_createCCtx();
+  nassertv(_cctx != nullptr);
+
+  // We always write a content checksum, so that corruption is detected when
+  // the stream is read back.
+  ZSTD_CCtx_setParameter(_cctx, ZSTD_c_compressionLevel, compression_level);
+  ZSTD_CCtx_setParameter(_cctx, ZSTD_c_checksumFlag, 1);
+
+  _write_buffer_size = ZSTD_CStreamInSize();
+  _write_buffer = (char *)PANDA_MALLOC_ARRAY(_write_buffer_size);
+  _out_buffer_size = ZSTD_CStreamOutSize();
+  _out_buffer = (char *)PANDA_MALLOC_ARRAY(_out_buffer_size);
+  setp(_write_buffer, _write_buffer + _write_buffer_size);
+}
+
+/**
+ *
+ */
+void ZstdStreamBuf::
+close_write() {
+  if (_dest != nullptr) {
+    if (_cctx != nullptr) {
+      // Compress whatever is left, and end the frame.
+      size_t n = pptr() - pbase();
+      write_chars(pbase(), n, ZSTD_e_end);
+      pbump(-(int)n);
+    }
+
+    if (_owns_dest) {
+      delete _dest;
+      _owns_dest = false;
+    }
+    _dest = nullptr;
+  }
+
+  if (_cctx != nullptr) {
+    ZSTD_freeCCtx(_cctx);
+    _cctx = nullptr;
+  }
+  if (_write_buffer != nullptr) {
+    PANDA_FREE_ARRAY(_write_buffer);
+    _write_buffer = nullptr;
+    _write_buffer_size = 0;
+  }
+  if (_out_buffer != nullptr) {
+    PANDA_FREE_ARRAY(_out_buffer);
+    _out_buffer = nullptr;
+    _out_buffer_size = 0;
+  }
+  setp(nullptr, nullptr);
+}
+
+/**
+ * Implements seeking within the stream.  ZstdStreamBuf only allows seeking
+ * back to the beginning of the stream.
+ */
+streampos ZstdStreamBuf::
+seekoff(streamoff off, ios_seekdir dir, ios_openmode which) {
+  if (which != ios::in || _source == nullptr || _dctx == nullptr) {
+    // We can only do this with the input stream.
+    return -1;
+  }
+
+  // Determine the current position.
+  size_t n = egptr() - gptr();
+  streampos gpos = _total_out - (streamoff)n;
+
+  // Implement tellg() and seeks to current position.
+  if ((dir == ios::cur && off == 0) ||
+      (dir == ios::beg && off == gpos)) {
+    return gpos;
+  }
+
+  if (off != 0 || dir != ios::beg) {
+    // We only know how to reposition to the beginning.
+    return -1;
+  }
+
+  if (_source->rdbuf()->pubseekpos(0, ios::in) == (streampos)0) {
+    _source->clear();
+    ZSTD_DCtx_reset(_dctx, ZSTD_reset_session_only);
+    _read_error = false;
+    _frame_complete = true;
+    _output_pending = false;
+    _total_out = 0;
+    _in_pos = 0;
+    _in_end = 0;
+    setg(_read_buffer, _read_buffer, _read_buffer);
+    return 0;
+  }
+
+  return -1;
+}
+
+/**
+ * Implements seeking within the stream.  ZstdStreamBuf only allows seeking
+ * back to the beginning of the stream.
+ */
+streampos ZstdStreamBuf::
+seekpos(streampos pos, ios_openmode which) {
+  return seekoff(pos, ios::beg, which);
+}
+
+/**
+ * Called by the system ostream implementation when its internal buffer is
+ * filled, plus one character.
+ */
+int ZstdStreamBuf::
+overflow(int ch) {
+  if (_dest == nullptr || _cctx == nullptr) {
+    return EOF;
+  }
+
+  size_t n = pptr() - pbase();
+  if (n != 0) {
+    bool okflag = write_chars(pbase(), n, ZSTD_e_continue);
+    pbump(-(int)n);
+    if (!okflag) {
+      return EOF;
+    }
+  }
+
+  if (ch != EOF) {
+    // Write one more character.
+    *pptr() = (char)ch;
+    pbump(1);
+  }
+
+  return 0;
+}
+
+/**
+ * Called by the system iostream implementation to implement a flush
+ * operation.  This flushes all of the data written so far to the dest
+ * stream, without ending the frame.
+ */
+int ZstdStreamBuf::
+sync() {
+  if (_dest != nullptr && _cctx != nullptr) {
+    size_t n = pptr() - pbase();
+    bool okflag = write_chars(pbase(), n, ZSTD_e_flush);
+    pbump(-(int)n);
+    _dest->flush();
+    if (!okflag) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Called by the system istream implementation when its internal buffer needs
+ * more characters.
+ */
+int ZstdStreamBuf::
+underflow() {
+  // Sometimes underflow() is called even if the buffer is not empty.
+  if (gptr() >= egptr()) {
+    if (_source == nullptr || _dctx == nullptr) {
+      return EOF;
+    }
+
+    size_t read_count = read_chars(_read_buffer, _read_buffer_size);
+    if (read_count == 0) {
+      return EOF;
+    }
+    _total_out += read_count;
+    setg(_read_buffer, _read_buffer, _read_buffer + read_count);
+  }
+
+  return (unsigned char)*gptr();
+}
+
+/**
+ * Decompresses up to length bytes from the source stream into the indicated
+ * buffer.  Returns the number of bytes produced, which is 0 only at the end
+ * of the stream or on error.
+ */
+size_t ZstdStreamBuf::
+read_chars(char *start, size_t length) {
+  if (_read_error) {
+    return 0;
+  }
+
+  ZSTD_outBuffer out = { start, length, 0 };
+  while (out.pos == 0) {
+    // If the last call filled up the output buffer, the library may still be
+    // holding more output, which we must collect before reading any more.
+    if (_in_pos == _in_end && !_output_pending) {
+      _source->read(_in_buffer, _in_buffer_size);
+      _in_end = (size_t)_source->gcount();
+      _in_pos = 0;
+      if (_in_end == 0) {
+        if (!_frame_complete) {
+          express_cat.error()
+            << "Truncated zstd stream.\n";
+          _read_error = true;
+        }
+        return 0;
+      }
+    }
+
+    ZSTD_inBuffer in = { _in_buffer, _in_end, _in_pos };
+    size_t result = ZSTD_decompressStream(_dctx, &out, &in);
+    _in_pos = in.pos;
+    thread_consider_yield();
+
+    if (ZSTD_isError(result)) {
+      express_cat.error()
+        << "zstd stream is corrupt: " << ZSTD_getErrorName(result) << "\n";
+      _read_error = true;
+      return 0;
+    }
+
+    // A return value of 0 means that a frame was completely decoded and its
+    // checksum verified.  Any further input begins a new frame.
+    _frame_complete = (result == 0);
+    _output_pending = (out.pos == out.size);
+  }
+
+  return out.pos;
+}
+
+/**
+ * Compresses the indicated data and writes the compressed output to the dest
+ * stream.  end_op is one of ZSTD_e_continue, ZSTD_e_flush or ZSTD_e_end.
+ * Returns true on success, false on error.
+ */
+bool ZstdStreamBuf::
+write_chars(const char *start, size_t length, int end_op) {
+  ZSTD_inBuffer in = { start, length, 0 };
+
+  bool finished;
+  do {
+    ZSTD_outBuffer out = { _out_buffer, _out_buffer_size, 0 };
+    size_t remaining = ZSTD_compressStream2(_cctx, &out, &in, (ZSTD_EndDirective)end_op);
+    thread_consider_yield();
+
+    if (ZSTD_isError(remaining)) {
+      express_cat.error()
+        << "zstd compression failed: " << ZSTD_getErrorName(remaining) << "\n";
+      return false;
+    }
+    _dest->write(_out_buffer, out.pos);
+
+    // When flushing or ending the frame, we have to keep calling until the
+    // library reports that it has nothing more to write.
+    if (end_op == ZSTD_e_continue) {
+      finished = (in.pos == in.size);
+    } else {
+      finished = (remaining == 0);
+    }
+  } while (!finished);
+
+  return true;
+}
@@ -0,0 +1,86 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file zstdStreamBuf.h
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#ifndef ZSTDSTREAMBUF_H
+#define ZSTDSTREAMBUF_H
+
+#include "pandabase.h"
+#include "numeric_types.h"
+
+struct ZSTD_DCtx_s;
+struct ZSTD_CCtx_s;
+
+/**
+ * The streambuf object that implements IZstdDecompressStream and
+ * OZstdCompressStream.
+ *
+ * This reads and writes the Zstandard frame format, using the copy of the
+ * reference zstd library in the zstd subdirectory, so the data is
+ * interchangeable with the zstd command-line tool.
+ */
+class EXPCL_PANDA_EXPRESS ZstdStreamBuf : public std::streambuf {
+public:
+  ZstdStreamBuf();
+  virtual ~ZstdStreamBuf();
+
+  void open_read(std::istream *source, bool owns_source);
+  void close_read();
+
+  void open_write(std::ostream *dest, bool owns_dest, int compression_level);
+  void close_write();
+
+  virtual std::streampos seekoff(std::streamoff off, ios_seekdir dir, ios_openmode which);
+  virtual std::streampos seekpos(std::streampos pos, ios_openmode which);
+
+  static const uint32_t frame_magic = 0xFD2FB528;
+
+protected:
+  virtual int overflow(int c);
+  virtual int sync();
+  virtual int underflow();
+
+private:
+  size_t read_chars(char *start, size_t length);
+  bool write_chars(const char *start, size_t length, int end_op);
+
+private:
+  std::istream *_source;
+  bool _owns_source;
+
+  std::ostream *_dest;
+  bool _owns_dest;
+
+  ZSTD_DCtx_s *_dctx;
+  ZSTD_CCtx_s *_cctx;
+
+  // The state of the stream being read.  The zstd library might not consume
+  // all of the input at each call, so the unconsumed input is kept here.
+  bool _read_error;
+  bool _frame_complete;
+  bool _output_pending;
+  std::streamoff _total_out;
+  char *_in_buffer;
+  size_t _in_buffer_size;
+  size_t _in_pos;
+  size_t _in_end;
+
+  char *_read_buffer;
+  size_t _read_buffer_size;
+
+  char *_write_buffer;
+  size_t _write_buffer_size;
+  char *_out_buffer;
+  size_t _out_buffer_size;
+};
+
+#endif
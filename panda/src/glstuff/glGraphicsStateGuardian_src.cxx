@@ -12812,8 +12812,20 @@ upload_texture(CLP(TextureContext) *gtc, bool force, bool uses_mipmaps) {
     }
   }
 
+  // If the larger mipmap levels are still being streamed in, upload only the
+  // levels that are resident; the texture will be marked modified again when
+  // the next level arrives.  Asking for the whole ram image would force them
+  // all to be read synchronously.
+  int stream_base_level = tex->get_stream_base_level();
+  if (stream_base_level > 0 &&
+      !get_supports_compressed_texture_format(tex->get_ram_image_compression())) {
+    stream_base_level = 0;
+  }
+
   CPTA_uchar image;
-  if (_supports_compressed_texture) {
+  if (stream_base_level > 0) {
+    image = tex->get_ram_mipmap_image(stream_base_level);
+  } else if (_supports_compressed_texture) {
     image = tex->get_ram_image();
   } else {
     image = tex->get_uncompressed_ram_image();
@@ -12835,11 +12847,11 @@ upload_texture(CLP(TextureContext) *gtc, bool force, bool uses_mipmaps) {
     nassertr(!image.is_null(), false);
   }
 
-  int mipmap_bias = 0;
+  int mipmap_bias = stream_base_level;
 
-  int width = tex->get_x_size();
-  int height = tex->get_y_size();
-  int depth = tex->get_z_size();
+  int width = tex->get_expected_mipmap_x_size(mipmap_bias);
+  int height = tex->get_expected_mipmap_y_size(mipmap_bias);
+  int depth = tex->get_expected_mipmap_z_size(mipmap_bias);
 
   // If we'll use immutable texture storage, we have to pick a sized image
   // format.
@@ -12948,7 +12960,7 @@ upload_texture(CLP(TextureContext) *gtc, bool force, bool uses_mipmaps) {
     height = tex->get_expected_mipmap_y_size(mipmap_bias);
     depth = tex->get_expected_mipmap_z_size(mipmap_bias);
 
-    if (mipmap_bias != 0) {
+    if (mipmap_bias != stream_base_level) {
       GLCAT.info()
         << "Reducing image " << tex->get_name()
         << " from " << tex->get_x_size() << " x " << tex->get_y_size()
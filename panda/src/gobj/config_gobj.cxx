@@ -46,6 +46,7 @@
 #include "texture.h"
 #include "texturePoolFilter.h"
 #include "textureReloadRequest.h"
+#include "textureStreamRequest.h"
 #include "textureStage.h"
 #include "textureContext.h"
 #include "timerQueryContext.h"
@@ -232,6 +233,27 @@ ConfigVariableBool display_list_animation
           "but it should be perfectly doable in principle, and might get "
           "you a small performance boost."));
 
+ConfigVariableBool fast_skinning
+("fast-skinning", true,
+ PRC_DESC("When this is true, soft-skinned vertices that are animated on "
+          "the CPU, and whose points and vectors are all stored as 3- or "
+          "4-component float32 columns, are transformed by a specialized "
+          "routine that computes each blend matrix only once per frame.  "
+          "Set this false to always use the general-purpose code."));
+
+ConfigVariableInt animate_num_threads
+("animate-num-threads", 0,
+ PRC_DESC("The number of worker threads that may help to animate the "
+          "vertices of a single large GeomVertexData on the CPU.  This only "
+          "applies when fast-skinning is in effect.  Set this to 0 to "
+          "animate all vertices on the thread that requests them."));
+
+ConfigVariableInt animate_parallel_min_rows
+("animate-parallel-min-rows", 2048,
+ PRC_DESC("When animate-num-threads is nonzero, this is the minimum number "
+          "of vertices handed to each thread.  A GeomVertexData with fewer "
+          "than twice this many animated vertices is not split up."));
+
 ConfigVariableBool connect_triangle_strips
 ("connect-triangle-strips", true,
  PRC_DESC("Set this true to send a batch of triangle strips to the graphics "
@@ -350,6 +372,77 @@ ConfigVariableDouble simple_image_threshold
           "simple images.  Generally the value should be considerably "
           "less than 1."));
 
+ConfigVariableBool texture_streaming
+("texture-streaming", false,
+ PRC_DESC("Set this true to stream in the larger mipmap levels of textures "
+          "on demand.  This only applies to textures read from bam or txo "
+          "files that were written with bam-aligned-data, and that can be "
+          "memory-mapped.  Only the smallest mipmap levels (see "
+          "texture-stream-tail-size) are loaded up front, so that the "
+          "texture can be rendered immediately; the larger levels are "
+          "loaded in a background thread as they are needed, according to "
+          "the size of the texture on screen."));
+
+ConfigVariableInt texture_stream_tail_size
+("texture-stream-tail-size", 64,
+ PRC_DESC("When texture-streaming is enabled, this is the largest mipmap "
+          "level, in texels along the longest side, that is loaded "
+          "immediately when the texture is read.  Larger levels are "
+          "streamed in later."));
+
+ConfigVariableInt64 texture_stream_memory_limit
+("texture-stream-memory-limit", 0,
+ PRC_DESC("This limits the total number of bytes of texture memory that "
+          "may be held by mipmap levels that were streamed in.  When the "
+          "limit is reached, levels of textures that are smaller on screen "
+          "are dropped to make room for textures that are larger on screen.  "
+          "Set this to 0 for no limit."));
+
+ConfigVariableInt texture_stream_num_threads
+("texture-stream-num-threads", 1,
+ PRC_DESC("The number of threads that will be started to stream in texture "
+          "mipmap levels, when texture-streaming is enabled."));
+
+ConfigVariableInt texture_compress_num_threads
+("texture-compress-num-threads", 0,
+ PRC_DESC("The number of additional threads that will be used to compress "
+          "texture images in RAM, for instance by Texture::compress_ram_image() "
+          "or when compressed-textures is set.  The image is divided into "
+          "chunks of block rows, across all of the pages and mipmap levels, "
+          "and the chunks are compressed in parallel.  Set this to 0 to do "
+          "all of the compression in the calling thread."));
+
+ConfigVariableBool texture_fast_dxt_encoder
+("texture-fast-dxt-encoder", false,
+ PRC_DESC("Set this true to use Panda's own DXT encoder instead of squish "
+          "when Texture::compress_ram_image() is asked for DXT1, DXT3 or "
+          "DXT5 at QL_fastest.  It is many times faster than squish, which "
+          "makes it suitable for compressing dynamically generated textures "
+          "at runtime, but the quality is somewhat lower.  It is also "
+          "available when Panda is built without squish."));
+
+ConfigVariableInt vertex_cache_size
+("vertex-cache-size", 16,
+ PRC_DESC("The number of vertices that the post-transform vertex cache of "
+          "the graphics hardware is assumed to hold.  This is used when "
+          "reordering triangles with GeomPrimitive::optimize_vertex_cache(), "
+          "and when estimating the cache miss ratio with calc_acmr()."));
+
+ConfigVariableDouble overdraw_threshold
+("overdraw-threshold", 1.05,
+ PRC_DESC("When optimize_vertex_cache() is also asked to reduce overdraw, "
+          "this is the factor by which the number of vertex cache misses is "
+          "allowed to increase in order to draw the outward-facing triangles "
+          "first.  Set this to 0 to optimize only for the vertex cache."));
+
+ConfigVariableDouble simplify_attribute_weight
+("simplify-attribute-weight", 0.5,
+ PRC_DESC("When simplifying meshes with Geom::simplify(), this controls how "
+          "strongly differences in normals, colors and texture coordinates "
+          "between two vertices count against merging them, relative to "
+          "the distance by which the surface would move.  Set this to 0 to "
+          "consider only the shape of the mesh."));
+
 ConfigVariableInt geom_cache_size
 ("geom-cache-size", 5000,
  PRC_DESC("Specifies the maximum number of entries in the cache "
@@ -592,6 +685,7 @@ ConfigureFn(config_gobj) {
   TextureContext::init_type();
   TexturePoolFilter::init_type();
   TextureReloadRequest::init_type();
+  TextureStreamRequest::init_type();
   TextureStage::init_type();
   TimerQueryContext::init_type();
   TransformBlend::init_type();
@@ -18,6 +18,7 @@
 #include "notifyCategoryProxy.h"
 #include "configVariableBool.h"
 #include "configVariableInt.h"
+#include "configVariableInt64.h"
 #include "configVariableEnum.h"
 #include "configVariableDouble.h"
 #include "configVariableFilename.h"
@@ -47,6 +48,9 @@ extern EXPCL_PANDA_GOBJ ConfigVariableBool hardware_points;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool singular_points;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool matrix_palette;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool display_list_animation;
+extern EXPCL_PANDA_GOBJ ConfigVariableBool fast_skinning;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt animate_num_threads;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt animate_parallel_min_rows;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool connect_triangle_strips;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool preserve_triangle_strips;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool dump_generated_shaders;
@@ -61,6 +65,16 @@ extern EXPCL_PANDA_GOBJ ConfigVariableBool textures_auto_power_2;
 extern EXPCL_PANDA_GOBJ ConfigVariableBool textures_header_only;
 extern EXPCL_PANDA_GOBJ ConfigVariableInt simple_image_size;
 extern EXPCL_PANDA_GOBJ ConfigVariableDouble simple_image_threshold;
+extern EXPCL_PANDA_GOBJ ConfigVariableBool texture_streaming;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_stream_tail_size;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt64 texture_stream_memory_limit;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_stream_num_threads;
+extern EXPCL_PANDA_GOBJ ConfigVariableInt texture_compress_num_threads;
+extern EXPCL_PANDA_GOBJ ConfigVariableBool texture_fast_dxt_encoder;
+
+extern EXPCL_PANDA_GOBJ ConfigVariableInt vertex_cache_size;
+extern EXPCL_PANDA_GOBJ ConfigVariableDouble overdraw_threshold;
+extern EXPCL_PANDA_GOBJ ConfigVariableDouble simplify_attribute_weight;
 
 extern EXPCL_PANDA_GOBJ ConfigVariableInt geom_cache_size;
 extern EXPCL_PANDA_GOBJ ConfigVariableInt geom_cache_min_frames;
@@ -13,6 +13,8 @@
 
 #include "geom.h"
 #include "geomPoints.h"
+#include "geomTriangles.h"
+#include "meshSimplifier.h"
 #include "geomVertexReader.h"
 #include "geomVertexRewriter.h"
 #include "graphicsStateGuardianBase.h"
@@ -927,6 +929,160 @@ make_adjacency_in_place() {
   nassertv(all_is_valid);
 }
 
+/**
+ * Reorders the triangles of each primitive within this Geom for better use of
+ * the vertex cache, leaving the results in place.  If reduce_overdraw is
+ * true, the vertex positions are also used to reduce overdraw.  See
+ * GeomPrimitive::optimize_vertex_cache().
+ *
+ * Don't call this in a downstream thread unless you don't mind it blowing
+ * away other changes you might have recently made in an upstream thread.
+ */
+void Geom::
+optimize_vertex_cache_in_place(bool reduce_overdraw) {
+  Thread *current_thread = Thread::get_current_thread();
+  CDWriter cdata(_cycler, true, current_thread);
+
+  CPT(GeomVertexData) vertex_data;
+  if (reduce_overdraw) {
+    vertex_data = cdata->_data.get_read_pointer(current_thread);
+  }
+
+#ifndef NDEBUG
+  GeomVertexDataPipelineReader data_reader(cdata->_data.get_read_pointer(current_thread), current_thread);
+  data_reader.check_array_readers();
+
+  bool all_is_valid = true;
+#endif
+  Primitives::iterator pi;
+  for (pi = cdata->_primitives.begin(); pi != cdata->_primitives.end(); ++pi) {
+    CPT(GeomPrimitive) new_prim = (*pi).get_read_pointer(current_thread)->optimize_vertex_cache(vertex_data);
+    (*pi) = (GeomPrimitive *)new_prim.p();
+
+#ifndef NDEBUG
+    if (!new_prim->check_valid(&data_reader)) {
+      all_is_valid = false;
+    }
+#endif
+  }
+
+  cdata->_modified = Geom::get_next_modified();
+  reset_geom_rendering(cdata);
+  clear_cache_stage(current_thread);
+
+  nassertv(all_is_valid);
+}
+
+/**
+ * Reduces the number of triangles in this Geom to approximately target_ratio
+ * times the original number, by collapsing the edges whose removal changes
+ * the shape of the surface the least.  If max_error is not negative, no edge
+ * is collapsed that would move the surface by more than this distance, so
+ * that fewer triangles may be removed.  See MeshSimplifier.
+ *
+ * All of the triangle primitives are decomposed and combined into a single
+ * GeomTriangles; other kinds of primitives are left alone.  The vertex data
+ * is not modified, so some of its vertices may no longer be used afterwards;
+ * SceneGraphReducer::simplify() also removes these.
+ *
+ * Returns an estimate of the greatest distance by which the surface has
+ * moved, or 0 if the Geom was not changed.
+ *
+ * Don't call this in a downstream thread unless you don't mind it blowing
+ * away other changes you might have recently made in an upstream thread.
+ */
+PN_stdfloat Geom::
+simplify_in_place(PN_stdfloat target_ratio, PN_stdfloat max_error) {
+  Thread *current_thread = Thread::get_current_thread();
+  CDWriter cdata(_cycler, true, current_thread);
+
+  // Gather up the triangles from all of the primitives.
+  pvector<int> indices;
+  Primitives new_prims;
+  CPT(GeomPrimitive) first_tris;
+  size_t tris_index = 0;
+
+  Primitives::const_iterator pi;
+  for (pi = cdata->_primitives.begin(); pi != cdata->_primitives.end(); ++pi) {
+    CPT(GeomPrimitive) prim = (*pi).get_read_pointer(current_thread);
+    if (prim->get_primitive_type() == PT_polygons) {
+      prim = prim->decompose();
+    }
+    if (prim->get_primitive_type() != PT_polygons ||
+        prim->get_num_vertices_per_primitive() != 3) {
+      new_prims.push_back((GeomPrimitive *)prim.p());
+      continue;
+    }
+
+    if (first_tris == nullptr) {
+      first_tris = prim;
+      tris_index = new_prims.size();
+    }
+    GeomPrimitivePipelineReader reader(prim, current_thread);
+    int num_vertices = reader.get_num_vertices();
+    for (int i = 0; i < num_vertices; ++i) {
+      indices.push_back(reader.get_vertex(i));
+    }
+  }
+
+  if (indices.empty()) {
+    return 0;
+  }
+
+  MeshSimplifier simplifier(cdata->_data.get_read_pointer(current_thread), current_thread);
+  if (!simplifier.is_valid()) {
+    return 0;
+  }
+
+  size_t num_triangles = indices.size() / 3;
+  size_t target_triangles = (size_t)(num_triangles * std::max(target_ratio, (PN_stdfloat)0));
+  PN_stdfloat error = simplifier.simplify(indices, target_triangles, max_error);
+  if (indices.size() == num_triangles * 3) {
+    // Nothing could be collapsed.
+    return 0;
+  }
+
+  if (gobj_cat.is_debug()) {
+    gobj_cat.debug()
+      << "Simplified " << num_triangles << " triangles to "
+      << indices.size() / 3 << ", error " << error << "\n";
+  }
+
+  int max_index = 0;
+  for (int index : indices) {
+    max_index = std::max(max_index, index);
+  }
+
+  PT(GeomPrimitive) tris = new GeomTriangles(first_tris->get_usage_hint());
+  tris->set_shade_model(first_tris->get_shade_model());
+  tris->set_index_type(max_index < 0xffff ? NT_uint16 : NT_uint32);
+
+  PT(GeomVertexArrayData) new_vertices = tris->make_index_data();
+  new_vertices->unclean_set_num_rows(indices.size());
+  {
+    GeomVertexWriter to(new_vertices, 0, current_thread);
+    for (int index : indices) {
+      to.set_data1i(index);
+    }
+  }
+  tris->set_vertices(new_vertices, (int)indices.size());
+
+  new_prims.insert(new_prims.begin() + tris_index, tris.p());
+  cdata->_primitives.swap(new_prims);
+
+#ifndef NDEBUG
+  GeomVertexDataPipelineReader data_reader(cdata->_data.get_read_pointer(current_thread), current_thread);
+  data_reader.check_array_readers();
+  nassertr(tris->check_valid(&data_reader), error);
+#endif
+
+  cdata->_modified = Geom::get_next_modified();
+  reset_geom_rendering(cdata);
+  clear_cache_stage(current_thread);
+
+  return error;
+}
+
 /**
  * Copies the primitives from the indicated Geom into this one.  This does
  * require that both Geoms contain the same fundamental type primitives, both
@@ -109,6 +109,8 @@ PUBLISHED:
   INLINE PT(Geom) make_lines() const;
   INLINE PT(Geom) make_patches() const;
   INLINE PT(Geom) make_adjacency() const;
+  INLINE PT(Geom) optimize_vertex_cache(bool reduce_overdraw = true) const;
+  INLINE PT(Geom) simplify(PN_stdfloat target_ratio, PN_stdfloat max_error = -1) const;
 
   void decompose_in_place();
   void doubleside_in_place();
@@ -119,6 +121,8 @@ PUBLISHED:
   void make_lines_in_place();
   void make_patches_in_place();
   void make_adjacency_in_place();
+  void optimize_vertex_cache_in_place(bool reduce_overdraw = true);
+  PN_stdfloat simplify_in_place(PN_stdfloat target_ratio, PN_stdfloat max_error = -1);
 
   virtual bool copy_primitives_from(const Geom *other);
 
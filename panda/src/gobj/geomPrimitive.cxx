@@ -30,6 +30,7 @@
 #include "ioPtaDatagramInt.h"
 #include "indent.h"
 #include "pStatTimer.h"
+#include "vertexCacheOptimizer.h"
 
 using std::max;
 using std::min;
@@ -42,6 +43,7 @@ PStatCollector GeomPrimitive::_decompose_pcollector("*:Munge:Decompose");
 PStatCollector GeomPrimitive::_doubleside_pcollector("*:Munge:Doubleside");
 PStatCollector GeomPrimitive::_reverse_pcollector("*:Munge:Reverse");
 PStatCollector GeomPrimitive::_rotate_pcollector("*:Munge:Rotate");
+PStatCollector GeomPrimitive::_optimize_vertex_cache_pcollector("*:Munge:Optimize vertex cache");
 
 /**
  * Constructs an invalid object.  Only used when reading from bam.
@@ -1049,6 +1051,73 @@ make_adjacency() const {
   return nullptr;
 }
 
+/**
+ * Returns a new primitive with the same triangles, reordered so that the
+ * post-transform vertex cache of the graphics hardware is used more
+ * effectively.  Triangle strips and fans are decomposed into individual
+ * triangles first.  If the primitive does not consist of indexed triangles,
+ * the original primitive is returned.
+ *
+ * If vertex_data is given, the positions of the vertices are used to group
+ * the triangles into clusters, which are ordered so that the ones facing away
+ * from the center of the mesh are drawn first.  This reduces overdraw at a
+ * small cost in cache efficiency, controlled by overdraw-threshold.
+ *
+ * Only the order of the triangles is changed; see also
+ * SceneGraphReducer::optimize_vertex_cache(), which reorders the vertices as
+ * well.
+ */
+CPT(GeomPrimitive) GeomPrimitive::
+optimize_vertex_cache(const GeomVertexData *vertex_data) const {
+  if (gobj_cat.is_debug()) {
+    gobj_cat.debug()
+      << "Optimizing vertex cache for " << get_type() << ": " << (void *)this << "\n";
+  }
+
+  PStatTimer timer(_optimize_vertex_cache_pcollector);
+  if (get_geom_rendering() & (GR_triangle_strip | GR_triangle_fan)) {
+    return decompose()->optimize_vertex_cache_impl(vertex_data);
+  }
+  return optimize_vertex_cache_impl(vertex_data);
+}
+
+/**
+ * Returns the average number of vertices per triangle that would need to be
+ * processed by the vertex shader, given a vertex cache of the size indicated
+ * by vertex-cache-size.  This is known as the average cache miss ratio, and
+ * ranges from 3 (no vertex reuse) down to about 0.5 for a regular grid.
+ *
+ * Returns 0 if this primitive does not consist of triangles.
+ */
+PN_stdfloat GeomPrimitive::
+calc_acmr() const {
+  CPT(GeomPrimitive) prim = this;
+  if (get_geom_rendering() & (GR_triangle_strip | GR_triangle_fan)) {
+    prim = decompose();
+  }
+  if (prim->get_primitive_type() != PT_polygons ||
+      prim->get_num_vertices_per_primitive() != 3) {
+    return 0;
+  }
+
+  GeomPrimitivePipelineReader reader(prim, Thread::get_current_thread());
+  int num_triangles = reader.get_num_vertices() / 3;
+  if (num_triangles == 0) {
+    return 0;
+  }
+
+  pvector<int> indices(num_triangles * 3);
+  int max_vertex = 0;
+  for (int i = 0; i < num_triangles * 3; ++i) {
+    indices[i] = reader.get_vertex(i);
+    max_vertex = std::max(max_vertex, indices[i]);
+  }
+
+  VertexCacheOptimizer optimizer(vertex_cache_size);
+  size_t misses = optimizer.count_cache_misses(indices.data(), indices.size(), max_vertex + 1);
+  return (PN_stdfloat)misses / (PN_stdfloat)num_triangles;
+}
+
 /**
  * Returns the number of bytes consumed by the primitive and its index
  * table(s).
@@ -1844,6 +1913,14 @@ reverse_impl() const {
   return this;
 }
 
+/**
+ * The virtual implementation of optimize_vertex_cache().
+ */
+CPT(GeomPrimitive) GeomPrimitive::
+optimize_vertex_cache_impl(const GeomVertexData *vertex_data) const {
+  return this;
+}
+
 /**
  * Should be redefined to return true in any primitive that implements
  * append_unused_vertices().
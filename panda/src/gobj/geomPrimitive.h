@@ -136,6 +136,9 @@ PUBLISHED:
   CPT(GeomPrimitive) make_patches() const;
   virtual CPT(GeomPrimitive) make_adjacency() const;
 
+  CPT(GeomPrimitive) optimize_vertex_cache(const GeomVertexData *vertex_data = nullptr) const;
+  PN_stdfloat calc_acmr() const;
+
   int get_num_bytes() const;
   INLINE int get_data_size_bytes() const;
   INLINE UpdateSeq get_modified() const;
@@ -237,6 +240,7 @@ protected:
   virtual CPT(GeomVertexArrayData) rotate_impl() const;
   virtual CPT(GeomPrimitive) doubleside_impl() const;
   virtual CPT(GeomPrimitive) reverse_impl() const;
+  virtual CPT(GeomPrimitive) optimize_vertex_cache_impl(const GeomVertexData *vertex_data) const;
   virtual bool requires_unused_vertices() const;
   virtual void append_unused_vertices(GeomVertexArrayData *vertices,
                                       int vertex);
@@ -313,6 +317,7 @@ private:
   static PStatCollector _doubleside_pcollector;
   static PStatCollector _reverse_pcollector;
   static PStatCollector _rotate_pcollector;
+  static PStatCollector _optimize_vertex_cache_pcollector;
 
 public:
   virtual void write_datagram(BamWriter *manager, Datagram &dg);
@@ -18,6 +18,8 @@
 #include "bamWriter.h"
 #include "graphicsStateGuardianBase.h"
 #include "geomTrianglesAdjacency.h"
+#include "geomVertexData.h"
+#include "vertexCacheOptimizer.h"
 
 using std::map;
 
@@ -235,6 +237,70 @@ reverse_impl() const {
   return reversed;
 }
 
+/**
+ * The virtual implementation of optimize_vertex_cache().
+ */
+CPT(GeomPrimitive) GeomTriangles::
+optimize_vertex_cache_impl(const GeomVertexData *vertex_data) const {
+  Thread *current_thread = Thread::get_current_thread();
+  GeomPrimitivePipelineReader from(this, current_thread);
+  if (!from.is_indexed()) {
+    // Without indices, there is no vertex reuse to speak of.
+    return this;
+  }
+
+  int num_triangles = from.get_num_vertices() / 3;
+  if (num_triangles < 2) {
+    return this;
+  }
+
+  pvector<int> indices(num_triangles * 3);
+  int max_vertex = 0;
+  for (int i = 0; i < num_triangles * 3; ++i) {
+    indices[i] = from.get_vertex(i);
+    max_vertex = std::max(max_vertex, indices[i]);
+  }
+  int num_vertices = max_vertex + 1;
+
+  VertexCacheOptimizer optimizer(vertex_cache_size);
+  size_t orig_misses = optimizer.count_cache_misses(indices.data(), indices.size(), num_vertices);
+  optimizer.optimize(indices.data(), num_triangles, num_vertices);
+
+  bool reduce_overdraw = false;
+  if (vertex_data != nullptr && overdraw_threshold > 0.0 &&
+      vertex_data->has_column(InternalName::get_vertex()) &&
+      vertex_data->get_num_rows() >= num_vertices) {
+    pvector<LPoint3> positions(num_vertices);
+    GeomVertexReader reader(vertex_data, InternalName::get_vertex(), current_thread);
+    for (int v = 0; v < num_vertices; ++v) {
+      positions[v] = reader.get_data3();
+    }
+    optimizer.optimize_overdraw(indices.data(), num_triangles,
+                                positions.data(), num_vertices,
+                                (PN_stdfloat)overdraw_threshold);
+    reduce_overdraw = true;
+  }
+
+  if (!reduce_overdraw &&
+      optimizer.count_cache_misses(indices.data(), indices.size(), num_vertices) >= orig_misses) {
+    // No improvement; keep the original order.
+    return this;
+  }
+
+  PT(GeomVertexArrayData) new_vertices = make_index_data();
+  new_vertices->unclean_set_num_rows(num_triangles * 3);
+  {
+    GeomVertexWriter to(new_vertices, 0, current_thread);
+    for (int index : indices) {
+      to.set_data1i(index);
+    }
+  }
+
+  PT(GeomTriangles) optimized = new GeomTriangles(*this);
+  optimized->set_vertices(new_vertices, num_triangles * 3);
+  return optimized;
+}
+
 /**
  * The virtual implementation of rotate().
  */
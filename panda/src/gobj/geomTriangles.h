@@ -44,6 +44,7 @@ protected:
   virtual CPT(GeomPrimitive) doubleside_impl() const;
   virtual CPT(GeomPrimitive) reverse_impl() const;
   virtual CPT(GeomVertexArrayData) rotate_impl() const;
+  virtual CPT(GeomPrimitive) optimize_vertex_cache_impl(const GeomVertexData *vertex_data) const;
 
 public:
   static void register_with_read_factory();
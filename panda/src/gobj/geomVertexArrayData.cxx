@@ -530,13 +530,13 @@ write_datagram(BamWriter *manager, Datagram &dg, void *extra_data) const {
 
   if (manager->get_file_endian() == BamWriter::BE_native) {
     // For native endianness, we only have to write the data directly.
-    dg.append_data(_buffer.get_read_pointer(true), _buffer.get_size());
+    manager->write_aligned_data(dg, _buffer.get_read_pointer(true), _buffer.get_size());
 
   } else {
     // Otherwise, we have to convert it.
     unsigned char *new_data = (unsigned char *)alloca(_buffer.get_size());
     array_data->reverse_data_endianness(new_data, _buffer.get_read_pointer(true), _buffer.get_size());
-    dg.append_data(new_data, _buffer.get_size());
+    manager->write_aligned_data(dg, new_data, _buffer.get_size());
   }
 }
 
@@ -558,15 +558,26 @@ fillin(DatagramIterator &scan, BamReader *manager, void *extra_data) {
     memcpy(_buffer.get_write_pointer(), &new_data[0], new_data.size());
 
   } else {
-    // Now, the array data is just stored directly.
+    // Now, the array data is just stored directly.  If it was stored in an
+    // aligned block, we may be able to use it straight from the file.
     size_t size = scan.get_uint32();
-    _buffer.unclean_realloc(size);
-    _buffer.set_size(size);
+    PT(MappedFile) mapping;
+    const unsigned char *mapped_data =
+      manager->map_aligned_data(scan, size, mapping);
 
-    const unsigned char *source_data =
-      (const unsigned char *)scan.get_datagram().get_data();
-    memcpy(_buffer.get_write_pointer(), source_data + scan.get_current_index(), size);
-    scan.skip_bytes(size);
+    if (mapped_data != nullptr) {
+      _buffer.set_mapped_data(mapped_data, size, mapping);
+
+    } else if (manager->check_aligned_data(scan, size)) {
+      _buffer.unclean_realloc(size);
+      _buffer.set_size(size);
+      manager->read_aligned_data(scan, _buffer.get_write_pointer(), size);
+
+    } else {
+      gobj_cat.error()
+        << "Vertex array data extends past end of bam stream.\n";
+      _buffer.clear();
+    }
   }
 
   bool endian_reversed = false;
@@ -593,7 +604,9 @@ fillin(DatagramIterator &scan, BamReader *manager, void *extra_data) {
     manager->set_aux_data(array_data, "", aux_data);
   }
 
-  array_data->set_lru_size(_buffer.get_size());
+  // We don't put the array on the LRU yet; that waits for finalize().  The
+  // BamReader may still be copying the data into the buffer on another
+  // thread, and it mustn't be paged out from under it in the meantime.
 
   _modified = Geom::get_next_modified();
 }
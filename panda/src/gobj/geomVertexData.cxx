@@ -21,6 +21,44 @@
 #include "bamWriter.h"
 #include "pset.h"
 #include "indent.h"
+#include "config_gobj.h"
+#include "parallelJobRunner.h"
+
+// The fast skinning routine transforms each vertex with SSE2 when it is
+// guaranteed to be available at compile time.
+#if defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64) || defined(_M_AMD64)
+#define GVD_SKINNING_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+  // The matrices with which the vertices influenced by one TransformBlend
+  // are transformed, computed once per call to update_animated_vertices().
+  class SkinMatrix {
+  public:
+    LMatrix4f _point;
+    LMatrix4f _normal;
+    bool _normalize;
+  };
+  typedef pvector<SkinMatrix> SkinMatrices;
+
+  // One float32 column of the animated vertex data that must be transformed.
+  class SkinColumn {
+  public:
+    unsigned char *_data;
+    size_t _stride;
+    int _num_values;
+    bool _is_point;
+    bool _is_normal;
+  };
+  typedef pvector<SkinColumn> SkinColumns;
+}
+
+static ParallelJobRunner &get_animate_job_runner();
+static void skin_column_rows(const SkinColumn &column,
+                             const SkinMatrix *matrices, int num_blends,
+                             const unsigned short *blendt,
+                             int begin_row, int end_row);
 
 using std::ostream;
 
@@ -1588,9 +1626,41 @@ update_animated_vertices(GeomVertexData::CData *cdata, Thread *current_thread) {
     }
 
     CPT(GeomVertexArrayFormat) blend_array_format = orig_format->get_array(blend_array_index);
+    bool ushort_blends = (blend_array_format->get_stride() == 2 &&
+                          blend_array_format->get_column(0)->get_component_bytes() == 2);
+
+    if (fast_skinning && is_fast_skinning_format(new_format) &&
+        (ushort_blends || tb_table->get_num_blends() <= 0x10000)) {
+      // All of the columns we have to transform are plain float32 tables, so
+      // we can use the specialized routine.  It wants the blend indices as a
+      // table of ushorts; unpack them first if they aren't stored that way.
+      CPT(GeomVertexArrayDataHandle) blend_array_handle;
+      const unsigned short *blendt;
+      pvector<unsigned short> blend_indices;
+      if (ushort_blends) {
+        blend_array_handle =
+          new GeomVertexArrayDataHandle(cdata->_arrays[blend_array_index].get_read_pointer(current_thread), current_thread);
+        blendt = (const unsigned short *)blend_array_handle->get_read_pointer(true);
+      } else {
+        GeomVertexReader blendi(this, InternalName::get_transform_blend());
+        nassertv(blendi.has_column());
+        blend_indices.resize(num_rows, 0);
+        for (int i = 0; i < num_subranges; ++i) {
+          int begin = rows.get_subrange_begin(i);
+          int end = std::min(rows.get_subrange_end(i), num_rows);
+          blendi.set_row_unsafe(begin);
+          for (int j = begin; j < end; ++j) {
+            blend_indices[j] = (unsigned short)blendi.get_data1i();
+          }
+        }
+        blendt = blend_indices.data();
+      }
 
-    if (blend_array_format->get_stride() == 2 &&
-        blend_array_format->get_column(0)->get_component_bytes() == 2) {
+      do_fast_skinning(new_data, new_format, tb_table, blendt, current_thread);
+      return;
+    }
+
+    if (ushort_blends) {
       // The blend indices are a table of ushorts.  Optimize this common case.
       CPT(GeomVertexArrayDataHandle) blend_array_handle =
         new GeomVertexArrayDataHandle(cdata->_arrays[blend_array_index].get_read_pointer(current_thread), current_thread);
@@ -1829,30 +1899,7 @@ do_transform_vector_column(const GeomVertexFormat *format, GeomVertexRewriter &d
   LMatrix4 xform;
   bool normalize = false;
   if (data_column->get_contents() == C_normal) {
-    // This is to preserve perpendicularity to the surface.
-    LVecBase3 scale_sq(mat.get_row3(0).length_squared(),
-                       mat.get_row3(1).length_squared(),
-                       mat.get_row3(2).length_squared());
-    if (IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[1], 2.0e-3f) &&
-        IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[2], 2.0e-3f)) {
-      // There is a uniform scale.
-      LVecBase3 scale, shear, hpr;
-      if (IS_THRESHOLD_EQUAL(scale_sq[0], 1, 2.0e-3f)) {
-        // No scale to worry about.
-        xform = mat;
-      } else if (decompose_matrix(mat.get_upper_3(), scale, shear, hpr)) {
-        // Make a new matrix with scale/translate taken out of the equation.
-        compose_matrix(xform, LVecBase3(1, 1, 1), shear, hpr, LVecBase3::zero());
-      } else {
-        normalize = true;
-      }
-    } else {
-      // There is a non-uniform scale, so we need to do all this to preserve
-      // orthogonality to the surface.
-      xform.invert_from(mat);
-      xform.transpose_in_place();
-      normalize = true;
-    }
+    normalize = get_normal_xform(xform, mat);
   } else {
     xform = mat;
   }
@@ -1897,6 +1944,261 @@ do_transform_vector_column(const GeomVertexFormat *format, GeomVertexRewriter &d
   }
 }
 
+/**
+ * Computes the matrix with which normals should be transformed to remain
+ * perpendicular to a surface that is transformed by the indicated matrix.
+ * Returns true if the transformed normals must be renormalized afterwards.
+ */
+bool GeomVertexData::
+get_normal_xform(LMatrix4 &xform, const LMatrix4 &mat) {
+  LVecBase3 scale_sq(mat.get_row3(0).length_squared(),
+                     mat.get_row3(1).length_squared(),
+                     mat.get_row3(2).length_squared());
+  if (IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[1], 2.0e-3f) &&
+      IS_THRESHOLD_EQUAL(scale_sq[0], scale_sq[2], 2.0e-3f)) {
+    // There is a uniform scale.
+    LVecBase3 scale, shear, hpr;
+    if (IS_THRESHOLD_EQUAL(scale_sq[0], 1, 2.0e-3f)) {
+      // No scale to worry about.
+      xform = mat;
+    } else if (decompose_matrix(mat.get_upper_3(), scale, shear, hpr)) {
+      // Make a new matrix with scale/translate taken out of the equation.
+      compose_matrix(xform, LVecBase3(1, 1, 1), shear, hpr, LVecBase3::zero());
+    } else {
+      xform = mat;
+      return true;
+    }
+    return false;
+  }
+
+  // There is a non-uniform scale, so we need to do all this to preserve
+  // orthogonality to the surface.
+  xform.invert_from(mat);
+  xform.transpose_in_place();
+  return true;
+}
+
+/**
+ * Returns true if all of the points and vectors of the indicated format are
+ * stored in a way that do_fast_skinning() can handle.
+ */
+bool GeomVertexData::
+is_fast_skinning_format(const GeomVertexFormat *format) {
+  size_t num_points = format->get_num_points();
+  for (size_t ci = 0; ci < num_points; ++ci) {
+    const GeomVertexColumn *column = format->get_column(format->get_point(ci));
+    if (column == nullptr ||
+        column->get_numeric_type() != NT_float32 ||
+        (column->get_num_values() != 3 && column->get_num_values() != 4)) {
+      return false;
+    }
+  }
+  size_t num_vectors = format->get_num_vectors();
+  for (size_t ci = 0; ci < num_vectors; ++ci) {
+    const GeomVertexColumn *column = format->get_column(format->get_vector(ci));
+    if (column == nullptr ||
+        column->get_numeric_type() != NT_float32 ||
+        (column->get_num_values() != 3 && column->get_num_values() != 4)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Applies the transform blends to all of the points and vectors of new_data,
+ * which must be in a format accepted by is_fast_skinning_format().  blendt
+ * gives the blend index of each row.
+ *
+ * Unlike the general-purpose code, which computes a blend matrix for each run
+ * of vertices sharing the same blend, this computes each matrix (and its
+ * normal matrix) only once, and then transforms each column in a single pass.
+ * Large tables may be split over several threads; see animate-num-threads.
+ */
+void GeomVertexData::
+do_fast_skinning(GeomVertexData *new_data, const GeomVertexFormat *new_format,
+                 const TransformBlendTable *tb_table,
+                 const unsigned short *blendt, Thread *current_thread) {
+  int num_rows = new_data->get_num_rows();
+  size_t num_points = new_format->get_num_points();
+  size_t num_vectors = new_format->get_num_vectors();
+
+  // Gather up the columns, and get a write pointer to each of their arrays
+  // up front, while we're still on the calling thread.
+  pvector<PT(GeomVertexArrayDataHandle)> handles(new_format->get_num_arrays());
+  SkinColumns columns;
+  columns.reserve(num_points + num_vectors);
+  bool any_normals = false;
+
+  for (size_t ci = 0; ci < num_points + num_vectors; ++ci) {
+    bool is_point = (ci < num_points);
+    const InternalName *name = is_point
+      ? new_format->get_point(ci)
+      : new_format->get_vector(ci - num_points);
+
+    int array_index = new_format->get_array_with(name);
+    nassertv(array_index >= 0);
+    const GeomVertexColumn *data_column = new_format->get_column(name);
+
+    PT(GeomVertexArrayDataHandle) &handle = handles[array_index];
+    if (handle == nullptr) {
+      handle = new_data->modify_array_handle(array_index);
+    }
+
+    SkinColumn column;
+    column._data = handle->get_write_pointer() + data_column->get_start();
+    column._stride = new_format->get_array(array_index)->get_stride();
+    column._num_values = data_column->get_num_values();
+    column._is_point = is_point;
+    column._is_normal = !is_point && data_column->get_contents() == C_normal;
+    any_normals = any_normals || column._is_normal;
+    columns.push_back(column);
+  }
+
+  // Now compute the matrices of all of the blends.
+  int num_blends = (int)tb_table->get_num_blends();
+  SkinMatrices matrices;
+  matrices.reserve(num_blends);
+  for (int bi = 0; bi < num_blends; ++bi) {
+    LMatrix4 mat;
+    tb_table->get_blend(bi).get_blend(mat, current_thread);
+
+    SkinMatrix matrix;
+    matrix._point = LCAST(float, mat);
+    matrix._normal = LMatrix4f::ident_mat();
+    matrix._normalize = false;
+    if (any_normals) {
+      LMatrix4 xform;
+      matrix._normalize = get_normal_xform(xform, mat);
+      matrix._normal = LCAST(float, xform);
+    }
+    matrices.push_back(matrix);
+  }
+
+  const SparseArray &rows = tb_table->get_rows();
+  int num_subranges = rows.get_num_subranges();
+
+  // Each job processes the rows within a contiguous slice of the table.
+  ParallelJobRunner &job_runner = get_animate_job_runner();
+
+  int min_rows = std::max((int)animate_parallel_min_rows, 1);
+  int num_jobs = 1;
+  if (job_runner.is_parallel()) {
+    num_jobs = std::min(job_runner.get_num_threads() + 1, num_rows / min_rows);
+    num_jobs = std::max(num_jobs, 1);
+  }
+
+  auto skin_job = [&](int job, Thread *) {
+    int job_begin = (int)((int64_t)num_rows * job / num_jobs);
+    int job_end = (int)((int64_t)num_rows * (job + 1) / num_jobs);
+
+    for (const SkinColumn &column : columns) {
+      for (int i = 0; i < num_subranges; ++i) {
+        int begin = std::max(rows.get_subrange_begin(i), job_begin);
+        int end = std::min(rows.get_subrange_end(i), job_end);
+        if (begin < end) {
+          skin_column_rows(column, matrices.data(), num_blends, blendt, begin, end);
+        }
+      }
+    }
+  };
+
+  if (num_jobs > 1) {
+    job_runner.run(num_jobs, skin_job, current_thread);
+  } else {
+    skin_job(0, current_thread);
+  }
+}
+
+/**
+ * Returns the runner shared by all threads that animate vertices.  Its number
+ * of threads follows animate-num-threads, which may be changed at runtime.
+ */
+static ParallelJobRunner &
+get_animate_job_runner() {
+  static ParallelJobRunner job_runner("animate", animate_num_threads);
+  job_runner.set_num_threads(animate_num_threads);
+  return job_runner;
+}
+
+/**
+ * Transforms the rows [begin_row, end_row) of the indicated column, each by
+ * the matrix of the blend given by its entry in blendt.
+ */
+static void
+skin_column_rows(const SkinColumn &column, const SkinMatrix *matrices,
+                 int num_blends, const unsigned short *blendt,
+                 int begin_row, int end_row) {
+  unsigned char *datat = column._data + begin_row * column._stride;
+  size_t stride = column._stride;
+  bool full = (column._num_values == 4);
+
+#ifdef GVD_SKINNING_SSE2
+  int last_bi = -1;
+  __m128 row0 = _mm_setzero_ps();
+  __m128 row1 = row0, row2 = row0, row3 = row0;
+  bool normalize = false;
+  for (int j = begin_row; j < end_row; ++j, datat += stride) {
+    int bi = blendt[j];
+    if (bi != last_bi) {
+      nassertv(bi < num_blends);
+      const SkinMatrix &matrix = matrices[bi];
+      const float *m = column._is_normal ? matrix._normal.get_data() : matrix._point.get_data();
+      row0 = _mm_loadu_ps(m);
+      row1 = _mm_loadu_ps(m + 4);
+      row2 = _mm_loadu_ps(m + 8);
+      row3 = _mm_loadu_ps(m + 12);
+      normalize = column._is_normal && matrix._normalize;
+      last_bi = bi;
+    }
+
+    float *v = (float *)datat;
+    __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v[0]), row0),
+                                     _mm_mul_ps(_mm_set1_ps(v[1]), row1)),
+                          _mm_mul_ps(_mm_set1_ps(v[2]), row2));
+    if (normalize) {
+      // Normals that need to be renormalized are treated as 3-component.
+      _mm_storel_pi((__m64 *)v, r);
+      _mm_store_ss(v + 2, _mm_movehl_ps(r, r));
+      ((LVector3f *)v)->normalize();
+    } else if (full) {
+      r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v[3]), row3));
+      _mm_storeu_ps(v, r);
+    } else {
+      if (column._is_point) {
+        r = _mm_add_ps(r, row3);
+      }
+      _mm_storel_pi((__m64 *)v, r);
+      _mm_store_ss(v + 2, _mm_movehl_ps(r, r));
+    }
+  }
+
+#else
+  for (int j = begin_row; j < end_row; ++j, datat += stride) {
+    int bi = blendt[j];
+    nassertv(bi < num_blends);
+    const SkinMatrix &matrix = matrices[bi];
+    if (column._is_normal && matrix._normalize) {
+      LVector3f &vertex = *(LVector3f *)datat;
+      vertex *= matrix._normal;
+      vertex.normalize();
+    } else {
+      const LMatrix4f &mat = column._is_normal ? matrix._normal : matrix._point;
+      if (full) {
+        LVecBase4f &vertex = *(LVecBase4f *)datat;
+        vertex *= mat;
+      } else if (column._is_point) {
+        LPoint3f &vertex = *(LPoint3f *)datat;
+        vertex *= mat;
+      } else {
+        LVector3f &vertex = *(LVector3f *)datat;
+        vertex *= mat;
+      }
+    }
+  }
+#endif  // GVD_SKINNING_SSE2
+}
+
 /**
  * Transforms each of the LPoint3f objects in the indicated table by the
  * indicated matrix.
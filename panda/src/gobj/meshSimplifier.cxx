@@ -0,0 +1,537 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file meshSimplifier.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "meshSimplifier.h"
+#include "geomVertexReader.h"
+#include "config_gobj.h"
+#include "pmap.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+  /**
+   * One edge of one triangle, as it appears in the triangle.  These are
+   * sorted so that the occurrences of the same edge are adjacent.
+   */
+  struct EdgeRef {
+    int _a, _b;
+    int _lo, _hi;
+    size_t _triangle;
+
+    bool operator < (const EdgeRef &other) const {
+      if (_lo != other._lo) {
+        return _lo < other._lo;
+      }
+      if (_hi != other._hi) {
+        return _hi < other._hi;
+      }
+      return _triangle < other._triangle;
+    }
+  };
+
+  typedef std::pair<int, int> UndirectedEdge;
+}
+
+/**
+ * Reads the vertex positions and the other columns of the indicated vertex
+ * data.  If the vertex data has no vertex column, is_valid() will return
+ * false.
+ */
+MeshSimplifier::
+MeshSimplifier(const GeomVertexData *vertex_data, Thread *current_thread) :
+  _valid(false),
+  _num_vertices(0),
+  _num_attributes(0),
+  _attribute_weight((PN_stdfloat)simplify_attribute_weight),
+  _scale(1.0)
+{
+  const GeomVertexFormat *format = vertex_data->get_format();
+  if (!format->has_column(InternalName::get_vertex())) {
+    return;
+  }
+
+  _num_vertices = vertex_data->get_num_rows();
+
+  // Read the positions, and group the vertices with identical positions.
+  _positions.resize(_num_vertices);
+  _groups.resize(_num_vertices);
+  {
+    GeomVertexReader vertex(vertex_data, InternalName::get_vertex(), current_thread);
+    pmap<LPoint3d, int> group_map;
+    LPoint3d min_point(0), max_point(0);
+    for (int v = 0; v < _num_vertices; ++v) {
+      LPoint3d p = vertex.get_data3d();
+      _positions[v] = p;
+      if (v == 0) {
+        min_point = p;
+        max_point = p;
+      } else {
+        min_point = min_point.fmin(p);
+        max_point = max_point.fmax(p);
+      }
+      std::pair<pmap<LPoint3d, int>::iterator, bool> result =
+        group_map.insert(pmap<LPoint3d, int>::value_type(p, (int)group_map.size()));
+      _groups[v] = (*result.first).second;
+    }
+
+    double diagonal = (max_point - min_point).length();
+    if (diagonal > 0.0) {
+      _scale = diagonal * 0.5;
+    }
+
+    int num_groups = (int)group_map.size();
+    _group_offsets.assign(num_groups + 1, 0);
+    for (int v = 0; v < _num_vertices; ++v) {
+      ++_group_offsets[_groups[v] + 1];
+    }
+    for (int g = 0; g < num_groups; ++g) {
+      _group_offsets[g + 1] += _group_offsets[g];
+    }
+    _group_members.resize(_num_vertices);
+    pvector<int> fill(_group_offsets);
+    for (int v = 0; v < _num_vertices; ++v) {
+      _group_members[fill[_groups[v]]++] = v;
+    }
+  }
+
+  // Sort the remaining columns into the skinning columns, which must match
+  // exactly, and the other attributes, which may differ at a cost.
+  pvector<const GeomVertexColumn *> attrib_columns;
+  pvector<const GeomVertexColumn *> skin_columns;
+  size_t num_columns = format->get_num_columns();
+  for (size_t ci = 0; ci < num_columns; ++ci) {
+    const GeomVertexColumn *column = format->get_column(ci);
+    const InternalName *name = column->get_name();
+    if (name == InternalName::get_vertex()) {
+      continue;
+    }
+    if (name == InternalName::get_transform_blend() ||
+        name == InternalName::get_transform_index() ||
+        name == InternalName::get_transform_weight() ||
+        column->get_contents() == GeomEnums::C_index) {
+      skin_columns.push_back(column);
+    } else if (column->get_num_elements() == 1 &&
+               column->get_contents() != GeomEnums::C_matrix) {
+      attrib_columns.push_back(column);
+      _num_attributes += std::min(column->get_num_components(), 4);
+    }
+  }
+
+  _attributes.resize((size_t)_num_vertices * _num_attributes);
+  int offset = 0;
+  for (const GeomVertexColumn *column : attrib_columns) {
+    int num_components = std::min(column->get_num_components(), 4);
+    GeomVertexReader reader(vertex_data, column->get_name(), current_thread);
+    for (int v = 0; v < _num_vertices; ++v) {
+      LVecBase4f value = reader.get_data4f();
+      float *dest = &_attributes[(size_t)v * _num_attributes + offset];
+      for (int c = 0; c < num_components; ++c) {
+        dest[c] = value[c];
+      }
+    }
+    offset += num_components;
+  }
+
+  _skin_keys.assign(_num_vertices, 0);
+  if (!skin_columns.empty()) {
+    typedef pvector<float> SkinValues;
+    pvector<SkinValues> values(_num_vertices);
+    for (const GeomVertexColumn *column : skin_columns) {
+      GeomVertexReader reader(vertex_data, column->get_name(), current_thread);
+      for (int v = 0; v < _num_vertices; ++v) {
+        LVecBase4f value = reader.get_data4f();
+        values[v].insert(values[v].end(), value.begin(), value.end());
+      }
+    }
+
+    pmap<SkinValues, int> key_map;
+    for (int v = 0; v < _num_vertices; ++v) {
+      std::pair<pmap<SkinValues, int>::iterator, bool> result =
+        key_map.insert(pmap<SkinValues, int>::value_type(values[v], (int)key_map.size()));
+      _skin_keys[v] = (*result.first).second;
+    }
+  }
+
+  _valid = true;
+}
+
+/**
+ * Collapses edges of the indicated list of triangles, consisting of three
+ * vertex indices each, until no more than target_triangles remain, or until
+ * no edge can be collapsed without moving the surface by more than
+ * max_error (in the units of the vertex data).  A negative max_error means
+ * there is no limit.
+ *
+ * The indices are replaced with the simplified triangles, which refer to a
+ * subset of the original vertices.  Returns an estimate of the greatest
+ * distance by which the surface has moved.
+ */
+PN_stdfloat MeshSimplifier::
+simplify(pvector<int> &indices, size_t target_triangles,
+         PN_stdfloat max_error) const {
+  nassertr(_valid, 0);
+  nassertr(indices.size() % 3 == 0, 0);
+
+  int num_groups = (int)_group_offsets.size() - 1;
+  double max_error2 = (max_error < 0) ? std::numeric_limits<double>::max()
+                                      : (double)max_error * (double)max_error;
+
+  // Remove any triangles that have no area to begin with, and build the
+  // quadric of each vertex position from the planes of its triangles.
+  pvector<Quadric> quadrics(num_groups);
+  {
+    pvector<int> new_indices;
+    new_indices.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); i += 3) {
+      int a = indices[i];
+      int b = indices[i + 1];
+      int c = indices[i + 2];
+      nassertr(a >= 0 && a < _num_vertices && b >= 0 && b < _num_vertices &&
+               c >= 0 && c < _num_vertices, 0);
+      int ga = _groups[a];
+      int gb = _groups[b];
+      int gc = _groups[c];
+      if (ga == gb || gb == gc || ga == gc) {
+        continue;
+      }
+      new_indices.push_back(a);
+      new_indices.push_back(b);
+      new_indices.push_back(c);
+
+      LVector3d normal = (_positions[b] - _positions[a]).cross(_positions[c] - _positions[a]);
+      if (normal.normalize()) {
+        double d = -normal.dot(_positions[a]);
+        quadrics[ga].add_plane(normal, d, 1.0);
+        quadrics[gb].add_plane(normal, d, 1.0);
+        quadrics[gc].add_plane(normal, d, 1.0);
+      }
+    }
+    indices.swap(new_indices);
+  }
+
+  size_t num_triangles = indices.size() / 3;
+  double result_error2 = 0.0;
+  bool first_pass = true;
+
+  pvector<int> tri_offsets;
+  pvector<size_t> vertex_tris;
+  pvector<EdgeRef> edge_refs;
+  pvector<UndirectedEdge> edges;
+  pvector<unsigned char> edge_border;
+  pvector<int> border_count;
+  pvector<unsigned char> locked;
+  pvector<unsigned char> group_locked;
+  pvector<Collapse> collapses;
+  pvector<int> remap;
+  pvector<unsigned char> touched;
+  pvector<unsigned char> tri_removed;
+  pvector<std::pair<int, int> > pairs;
+
+  while (num_triangles > target_triangles) {
+    // Build, for each vertex, the list of triangles that use it.
+    tri_offsets.assign(_num_vertices + 1, 0);
+    for (int v : indices) {
+      ++tri_offsets[v + 1];
+    }
+    for (int v = 0; v < _num_vertices; ++v) {
+      tri_offsets[v + 1] += tri_offsets[v];
+    }
+    vertex_tris.resize(indices.size());
+    {
+      pvector<int> fill(tri_offsets);
+      for (size_t i = 0; i < indices.size(); ++i) {
+        vertex_tris[fill[indices[i]]++] = i / 3;
+      }
+    }
+
+    // Find the edges that are used by only one triangle.  These are the
+    // borders of the mesh, but also the seams, where vertices with the same
+    // position but different attributes meet.
+    edge_refs.clear();
+    for (size_t t = 0; t < num_triangles; ++t) {
+      for (int k = 0; k < 3; ++k) {
+        EdgeRef ref;
+        ref._a = indices[t * 3 + k];
+        ref._b = indices[t * 3 + (k + 1) % 3];
+        ref._lo = std::min(ref._a, ref._b);
+        ref._hi = std::max(ref._a, ref._b);
+        ref._triangle = t;
+        edge_refs.push_back(ref);
+      }
+    }
+    std::sort(edge_refs.begin(), edge_refs.end());
+
+    edges.clear();
+    edge_border.clear();
+    border_count.assign(_num_vertices, 0);
+    locked.assign(_num_vertices, 0);
+    for (size_t i = 0; i < edge_refs.size();) {
+      size_t j = i + 1;
+      while (j < edge_refs.size() && edge_refs[j]._lo == edge_refs[i]._lo &&
+             edge_refs[j]._hi == edge_refs[i]._hi) {
+        ++j;
+      }
+      const EdgeRef &ref = edge_refs[i];
+      size_t count = j - i;
+      if (count == 1) {
+        ++border_count[ref._a];
+        ++border_count[ref._b];
+
+        if (first_pass) {
+          // Add a plane perpendicular to the triangle through this edge, so
+          // that moving the vertices away from the border counts as error.
+          const int *tri = &indices[ref._triangle * 3];
+          const LPoint3d &p0 = _positions[tri[0]];
+          LVector3d normal = (_positions[tri[1]] - p0).cross(_positions[tri[2]] - p0);
+          LVector3d edge = _positions[ref._b] - _positions[ref._a];
+          LVector3d border_normal = edge.cross(normal);
+          if (border_normal.normalize()) {
+            double d = -border_normal.dot(_positions[ref._a]);
+            quadrics[_groups[ref._a]].add_plane(border_normal, d, 1.0);
+            quadrics[_groups[ref._b]].add_plane(border_normal, d, 1.0);
+          }
+        }
+
+      } else if (count != 2 || edge_refs[i]._a == edge_refs[i + 1]._a) {
+        // A non-manifold edge, or one between triangles of opposite winding.
+        // Leave these alone.
+        locked[ref._lo] = 1;
+        locked[ref._hi] = 1;
+      }
+      edges.push_back(UndirectedEdge(ref._lo, ref._hi));
+      edge_border.push_back(count == 1);
+      i = j;
+    }
+
+    for (int v = 0; v < _num_vertices; ++v) {
+      if (border_count[v] != 0 && border_count[v] != 2) {
+        // This vertex is where several borders meet.
+        locked[v] = 1;
+      }
+    }
+
+    // A position can only be moved if all of its vertices can.  It may not
+    // be both on a border and in the interior of another part of the mesh.
+    group_locked.assign(num_groups, 0);
+    for (int g = 0; g < num_groups; ++g) {
+      bool any_border = false;
+      bool any_interior = false;
+      for (int mi = _group_offsets[g]; mi < _group_offsets[g + 1]; ++mi) {
+        int m = _group_members[mi];
+        if (tri_offsets[m] == tri_offsets[m + 1]) {
+          continue;
+        }
+        if (locked[m]) {
+          group_locked[g] = 1;
+        }
+        if (border_count[m] != 0) {
+          any_border = true;
+        } else {
+          any_interior = true;
+        }
+      }
+      if (any_border && any_interior) {
+        group_locked[g] = 1;
+      }
+    }
+
+    // Consider collapsing each edge in either direction.
+    collapses.clear();
+    for (size_t ei = 0; ei < edges.size(); ++ei) {
+      for (int dir = 0; dir < 2; ++dir) {
+        int from = dir ? edges[ei].second : edges[ei].first;
+        int to = dir ? edges[ei].first : edges[ei].second;
+        int gf = _groups[from];
+        if (gf == _groups[to] || group_locked[gf]) {
+          continue;
+        }
+        if (border_count[from] != 0 && !edge_border[ei]) {
+          // A border vertex may only move along the border.
+          continue;
+        }
+        if (_skin_keys[from] != _skin_keys[to]) {
+          continue;
+        }
+
+        Collapse collapse;
+        collapse._error = quadrics[gf].evaluate(_positions[to]);
+        collapse._cost = collapse._error + calc_attribute_error(from, to);
+        collapse._from = from;
+        collapse._to = to;
+        collapses.push_back(collapse);
+      }
+    }
+    std::sort(collapses.begin(), collapses.end());
+
+    // Now perform the cheapest collapses, as long as they don't involve a
+    // position that has been affected by an earlier collapse in this pass.
+    remap.resize(_num_vertices);
+    for (int v = 0; v < _num_vertices; ++v) {
+      remap[v] = v;
+    }
+    touched.assign(num_groups, 0);
+    tri_removed.assign(num_triangles, 0);
+
+    size_t remaining = num_triangles;
+    int num_collapsed = 0;
+
+    for (const Collapse &collapse : collapses) {
+      if (remaining <= target_triangles) {
+        break;
+      }
+      if (collapse._error > max_error2) {
+        continue;
+      }
+      int gf = _groups[collapse._from];
+      int gt = _groups[collapse._to];
+      if (touched[gf] || touched[gt]) {
+        continue;
+      }
+
+      // Each vertex at this position must be moved onto a vertex at the new
+      // position with which it shares an edge, so that the attributes on
+      // either side of a seam stay consistent.
+      bool ok = true;
+      pairs.clear();
+      for (int mi = _group_offsets[gf]; mi < _group_offsets[gf + 1] && ok; ++mi) {
+        int m = _group_members[mi];
+        if (tri_offsets[m] == tri_offsets[m + 1]) {
+          continue;
+        }
+        int partner = -1;
+        for (int ti = tri_offsets[m]; ti < tri_offsets[m + 1] && partner < 0; ++ti) {
+          const int *tri = &indices[vertex_tris[ti] * 3];
+          for (int k = 0; k < 3; ++k) {
+            int w = tri[k];
+            if (_groups[w] != gt || _skin_keys[w] != _skin_keys[m]) {
+              continue;
+            }
+            if (border_count[m] != 0) {
+              UndirectedEdge edge(std::min(m, w), std::max(m, w));
+              pvector<UndirectedEdge>::const_iterator ei =
+                std::lower_bound(edges.begin(), edges.end(), edge);
+              if (ei == edges.end() || *ei != edge || !edge_border[ei - edges.begin()]) {
+                continue;
+              }
+            }
+            partner = w;
+            break;
+          }
+        }
+        if (partner < 0) {
+          ok = false;
+        } else {
+          pairs.push_back(std::pair<int, int>(m, partner));
+        }
+      }
+      if (!ok || pairs.empty()) {
+        continue;
+      }
+
+      // Make sure none of the remaining triangles would be flipped over.
+      const LPoint3d &new_pos = _positions[collapse._to];
+      for (size_t pi = 0; pi < pairs.size() && ok; ++pi) {
+        int m = pairs[pi].first;
+        for (int ti = tri_offsets[m]; ti < tri_offsets[m + 1]; ++ti) {
+          const int *tri = &indices[vertex_tris[ti] * 3];
+          if (_groups[tri[0]] == gt || _groups[tri[1]] == gt || _groups[tri[2]] == gt) {
+            // This triangle will disappear.
+            continue;
+          }
+          LPoint3d p[3], q[3];
+          for (int k = 0; k < 3; ++k) {
+            p[k] = _positions[tri[k]];
+            q[k] = (tri[k] == m) ? new_pos : p[k];
+          }
+          LVector3d old_normal = (p[1] - p[0]).cross(p[2] - p[0]);
+          LVector3d new_normal = (q[1] - q[0]).cross(q[2] - q[0]);
+          if (old_normal.dot(new_normal) <= 0.0) {
+            ok = false;
+            break;
+          }
+        }
+      }
+      if (!ok) {
+        continue;
+      }
+
+      for (const std::pair<int, int> &pair : pairs) {
+        int m = pair.first;
+        remap[m] = pair.second;
+        for (int ti = tri_offsets[m]; ti < tri_offsets[m + 1]; ++ti) {
+          size_t t = vertex_tris[ti];
+          const int *tri = &indices[t * 3];
+          if (!tri_removed[t] &&
+              (_groups[tri[0]] == gt || _groups[tri[1]] == gt || _groups[tri[2]] == gt)) {
+            tri_removed[t] = 1;
+            --remaining;
+          }
+          touched[_groups[tri[0]]] = 1;
+          touched[_groups[tri[1]]] = 1;
+          touched[_groups[tri[2]]] = 1;
+        }
+      }
+      touched[gf] = 1;
+      touched[gt] = 1;
+      quadrics[gt] += quadrics[gf];
+      result_error2 = std::max(result_error2, collapse._error);
+      ++num_collapsed;
+    }
+
+    if (num_collapsed == 0) {
+      break;
+    }
+
+    // Apply the collapses to the triangles.
+    size_t out = 0;
+    for (size_t t = 0; t < num_triangles; ++t) {
+      if (tri_removed[t]) {
+        continue;
+      }
+      int a = remap[indices[t * 3]];
+      int b = remap[indices[t * 3 + 1]];
+      int c = remap[indices[t * 3 + 2]];
+      if (_groups[a] == _groups[b] || _groups[b] == _groups[c] || _groups[a] == _groups[c]) {
+        continue;
+      }
+      indices[out++] = a;
+      indices[out++] = b;
+      indices[out++] = c;
+    }
+    indices.resize(out);
+    num_triangles = out / 3;
+    first_pass = false;
+  }
+
+  return (PN_stdfloat)sqrt(result_error2);
+}
+
+/**
+ * Returns the cost of replacing the attributes of vertex a with those of
+ * vertex b, scaled to be comparable to the squared geometric error.
+ */
+double MeshSimplifier::
+calc_attribute_error(int a, int b) const {
+  if (_num_attributes == 0 || _attribute_weight <= 0) {
+    return 0.0;
+  }
+  const float *pa = &_attributes[(size_t)a * _num_attributes];
+  const float *pb = &_attributes[(size_t)b * _num_attributes];
+  double sum = 0.0;
+  for (int i = 0; i < _num_attributes; ++i) {
+    double diff = (double)pa[i] - (double)pb[i];
+    sum += diff * diff;
+  }
+  return sum * _attribute_weight * _scale * _scale;
+}
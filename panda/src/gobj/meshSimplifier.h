@@ -0,0 +1,107 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file meshSimplifier.h
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include "pandabase.h"
+#include "geomVertexData.h"
+#include "luse.h"
+#include "pvector.h"
+
+/**
+ * Reduces the number of triangles in an indexed triangle list by repeatedly
+ * collapsing edges, choosing the collapses that move the surface the least
+ * according to the quadric error metric of Garland and Heckbert.
+ *
+ * Each collapse moves a vertex onto one of its neighbors, so no new vertices
+ * are created and the normals, colors, texture coordinates and skinning
+ * weights of the remaining vertices are kept as they are.  Vertices that
+ * share a position but differ in their other columns (for instance, along a
+ * UV seam) are collapsed together, along the seam, so that no cracks appear.
+ * Vertices with different skinning weights are never merged.
+ *
+ * This is used by Geom::simplify(); it is not normally necessary to use this
+ * class directly.
+ */
+class EXPCL_PANDA_GOBJ MeshSimplifier {
+public:
+  explicit MeshSimplifier(const GeomVertexData *vertex_data,
+                          Thread *current_thread = Thread::get_current_thread());
+
+  INLINE bool is_valid() const;
+  INLINE int get_num_vertices() const;
+
+  INLINE void set_attribute_weight(PN_stdfloat weight);
+  INLINE PN_stdfloat get_attribute_weight() const;
+
+  PN_stdfloat simplify(pvector<int> &indices, size_t target_triangles,
+                       PN_stdfloat max_error) const;
+
+private:
+  /**
+   * A symmetric 4x4 matrix that measures the sum of the squared distances of
+   * a point to a set of planes.
+   */
+  class Quadric {
+  public:
+    INLINE Quadric();
+    INLINE void add_plane(const LVector3d &normal, double d, double weight);
+    INLINE void operator += (const Quadric &other);
+    INLINE double evaluate(const LPoint3d &point) const;
+
+  private:
+    double _a2, _ab, _ac, _ad;
+    double _b2, _bc, _bd;
+    double _c2, _cd;
+    double _d2;
+  };
+
+  class Collapse {
+  public:
+    INLINE bool operator < (const Collapse &other) const;
+
+    double _cost;
+    double _error;
+    int _from;
+    int _to;
+  };
+
+  double calc_attribute_error(int a, int b) const;
+
+private:
+  bool _valid;
+  int _num_vertices;
+  pvector<LPoint3d> _positions;
+
+  // Vertices with the same position are in the same group.  The members of
+  // each group are stored back-to-back in _group_members.
+  pvector<int> _groups;
+  pvector<int> _group_offsets;
+  pvector<int> _group_members;
+
+  // All of the remaining numeric columns, except the skinning columns, are
+  // stored here, _num_attributes values per vertex.
+  pvector<float> _attributes;
+  int _num_attributes;
+
+  // Vertices may only be merged if their skinning columns are identical.
+  pvector<int> _skin_keys;
+
+  PN_stdfloat _attribute_weight;
+  double _scale;
+};
+
+#include "meshSimplifier.I"
+
+#endif
@@ -18,6 +18,7 @@
 #include "texturePool.cxx"
 #include "texturePoolFilter.cxx"
 #include "textureReloadRequest.cxx"
+#include "textureStreamRequest.cxx"
 #include "textureStage.cxx"
 #include "textureStagePool.cxx"
 #include "timerQueryContext.cxx"
@@ -27,6 +28,7 @@
 #include "userVertexSlider.cxx"
 #include "userVertexTransform.cxx"
 #include "vertexBufferContext.cxx"
+#include "vertexCacheOptimizer.cxx"
 #include "vertexDataBlock.cxx"
 #include "vertexDataBook.cxx"
 #include "vertexDataPage.cxx"
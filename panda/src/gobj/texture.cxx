@@ -42,12 +42,17 @@
 #include "streamReader.h"
 #include "texturePeeker.h"
 #include "convert_srgb.h"
+#include "textureStreamRequest.h"
+#include "clockObject.h"
+#include "lightMutexHolder.h"
+#include "parallelJobRunner.h"
 
 #ifdef HAVE_SQUISH
 #include <squish.h>
 #endif  // HAVE_SQUISH
 
 #include <stddef.h>
+#include <algorithm>
 
 using std::endl;
 using std::istream;
@@ -71,6 +76,8 @@ PStatCollector Texture::_texture_read_pcollector("*:Texture:Read");
 TypeHandle Texture::_type_handle;
 TypeHandle Texture::CData::_type_handle;
 AutoTextureScale Texture::_textures_power_2 = ATS_unspecified;
+Texture::StreamedTextures *Texture::_streamed_textures = nullptr;
+LightMutex Texture::_streamed_textures_lock("Texture::_streamed_textures_lock");
 
 // Stuff to read and write DDS files.
 
@@ -377,6 +384,11 @@ Texture(const string &name) :
   _cvar(_lock)
 {
   _reloading = false;
+  _stream_screen_size = 0;
+  _stream_frame = -1;
+  _stream_wanted_level = 0;
+  _stream_pending = false;
+  _stream_registered = false;
 
   CDWriter cdata(_cycler, true);
   do_set_format(cdata, F_rgb);
@@ -394,6 +406,11 @@ Texture(const Texture &copy) :
   _cvar(_lock)
 {
   _reloading = false;
+  _stream_screen_size = 0;
+  _stream_frame = -1;
+  _stream_wanted_level = 0;
+  _stream_pending = false;
+  _stream_registered = false;
 }
 
 /**
@@ -412,6 +429,11 @@ Texture::
 ~Texture() {
   release_all();
   nassertv(!_reloading);
+
+  if (_stream_registered) {
+    LightMutexHolder holder(_streamed_textures_lock);
+    _streamed_textures->erase(this);
+  }
 }
 
 /**
@@ -1175,7 +1197,7 @@ is_cacheable() const {
 int Texture::
 get_num_loadable_ram_mipmap_images() const {
   CDReader cdata(_cycler);
-  if (cdata->_ram_images.empty() || cdata->_ram_images[0]._image.empty()) {
+  if (!do_has_ram_image(cdata) && cdata->_stream_sources.empty()) {
     // If we don't even have a base image, the answer is none.
     return 0;
   }
@@ -1191,7 +1213,12 @@ get_num_loadable_ram_mipmap_images() const {
   while (x < size) {
     x = (x << 1);
     ++n;
-    if (n >= (int)cdata->_ram_images.size() || cdata->_ram_images[n]._image.empty()) {
+    if (n >= (int)cdata->_ram_images.size()) {
+      return n;
+    }
+    if (cdata->_ram_images[n]._image.empty() &&
+        (n >= (int)cdata->_stream_sources.size() ||
+         cdata->_stream_sources[n]._mapping == nullptr)) {
       return n;
     }
   }
@@ -1278,6 +1305,227 @@ clear_ram_mipmap_image(int n) {
   cdata->_ram_images[n]._pointer_image = nullptr;
 }
 
+/**
+ * If the texture was read with texture-streaming enabled, returns the largest
+ * mipmap level that is currently available in RAM; all of the smaller levels
+ * are also available.  The levels below this one may be loaded with
+ * stream_mipmap_level().  Returns 0 if the whole mipmap chain is available,
+ * or if the texture is not being streamed.
+ */
+int Texture::
+get_stream_base_level() const {
+  CDReader cdata(_cycler);
+  return do_get_stream_base_level(cdata);
+}
+
+/**
+ * Returns true if the texture was read with texture-streaming enabled, and
+ * some of its mipmap levels may therefore be streamed in (or dropped again)
+ * on demand.
+ */
+bool Texture::
+has_streamed_mipmaps() const {
+  CDReader cdata(_cycler);
+  return !cdata->_stream_sources.empty();
+}
+
+/**
+ * Loads the next larger mipmap level of a texture that is being streamed,
+ * that is, the level just below get_stream_base_level().  Returns true if a
+ * level was loaded, or false if there is no level left to load, or if the
+ * level would not fit within texture-stream-memory-limit.  In the latter
+ * case, the levels of textures with a lower get_stream_priority() will have
+ * been dropped first to make room, if possible.
+ *
+ * This is normally called by a TextureStreamRequest in a sub-thread, but it
+ * may be called directly.  Note that get_ram_image() will implicitly load all
+ * of the remaining levels, regardless of the limit.
+ */
+bool Texture::
+stream_mipmap_level() {
+  int n;
+  StreamSource source;
+  {
+    CDReader cdata(_cycler);
+    n = do_get_stream_base_level(cdata) - 1;
+    if (n < 0) {
+      return false;
+    }
+    source = cdata->_stream_sources[n];
+  }
+
+  if (source._mapping == nullptr ||
+      !make_stream_room(this, source._size, get_stream_priority())) {
+    return false;
+  }
+
+  // Copy the data without holding the lock, since this is where the data
+  // will actually be read from disk.
+  PTA_uchar image = PTA_uchar::empty_array(source._size, get_class_type());
+  memcpy(image.p(), source._data, source._size);
+
+  {
+    CDWriter cdata(_cycler, true);
+    if (do_get_stream_base_level(cdata) != n + 1 ||
+        cdata->_stream_sources[n]._data != source._data) {
+      // The texture was modified in the meantime.
+      return false;
+    }
+    cdata->_ram_images[n]._image = image;
+    cdata->_ram_images[n]._pointer_image = nullptr;
+    cdata->inc_image_modified();
+  }
+
+  if (gobj_cat.is_debug()) {
+    gobj_cat.debug()
+      << "Streamed in mipmap level " << n << " of " << get_name() << "\n";
+  }
+
+  register_streamed();
+  return true;
+}
+
+/**
+ * Drops the streamed-in mipmap levels of the texture below the indicated
+ * level, so that they will need to be streamed in again when they are next
+ * needed.  Returns the number of bytes that were freed.  Levels that were not
+ * streamed in are not affected.
+ */
+size_t Texture::
+evict_streamed_mipmaps(int base_level) {
+  CDWriter cdata(_cycler, false);
+  size_t freed = 0;
+
+  int num_levels = min(base_level, (int)cdata->_stream_sources.size());
+  for (int n = 0; n < num_levels; ++n) {
+    RamImage &ram_image = cdata->_ram_images[n];
+    if (cdata->_stream_sources[n]._mapping != nullptr &&
+        !ram_image._image.empty()) {
+      freed += ram_image._image.size();
+      ram_image._image.clear();
+    }
+  }
+
+  if (freed != 0) {
+    cdata->inc_image_modified();
+
+    if (gobj_cat.is_debug()) {
+      gobj_cat.debug()
+        << "Dropped " << freed << " bytes of mipmap levels below "
+        << base_level << " of " << get_name() << "\n";
+    }
+  }
+  return freed;
+}
+
+/**
+ * Indicates that the texture is being rendered on an object that covers
+ * approximately the indicated number of pixels along its longest side.  This
+ * is called during the cull traversal when texture-streaming is enabled;
+ * the largest size seen in a frame determines the mipmap level that should be
+ * streamed in, as well as the priority with which it is loaded.
+ *
+ * If the texture needs a larger mipmap level than it has, this queues up a
+ * TextureStreamRequest to load it.
+ */
+void Texture::
+request_stream_screen_size(PN_stdfloat screen_size) {
+  int base_level;
+  int size;
+  {
+    CDReader cdata(_cycler);
+    if (cdata->_stream_sources.empty()) {
+      return;
+    }
+    base_level = do_get_stream_base_level(cdata);
+    size = max(cdata->_x_size, cdata->_y_size);
+  }
+
+  // Find the smallest level that still has at least one texel per pixel.
+  int wanted_level = 0;
+  while (wanted_level < base_level && (size >> (wanted_level + 1)) >= screen_size) {
+    ++wanted_level;
+  }
+
+  int frame = ClockObject::get_global_clock()->get_frame_count();
+
+  PT(TextureStreamRequest) request;
+  {
+    MutexHolder holder(_lock);
+    if (_stream_frame != frame) {
+      _stream_frame = frame;
+      _stream_screen_size = screen_size;
+      _stream_wanted_level = wanted_level;
+    } else {
+      _stream_screen_size = max(_stream_screen_size, screen_size);
+      _stream_wanted_level = min(_stream_wanted_level, wanted_level);
+    }
+
+    if (_stream_pending || _stream_wanted_level >= base_level) {
+      return;
+    }
+    _stream_pending = true;
+    request = new TextureStreamRequest(this);
+  }
+
+  request->set_priority((int)screen_size);
+  TextureStreamRequest::get_task_manager()->add(request);
+}
+
+/**
+ * Returns the largest size on screen that was passed to
+ * request_stream_screen_size() in the current or previous frame, or 0 if the
+ * texture has not been rendered recently.  Textures with a higher priority
+ * have their mipmap levels streamed in first, and dropped last.
+ */
+PN_stdfloat Texture::
+get_stream_priority() const {
+  int frame = ClockObject::get_global_clock()->get_frame_count();
+
+  MutexHolder holder(_lock);
+  if (_stream_frame < 0 || _stream_frame < frame - 1) {
+    return 0;
+  }
+  return _stream_screen_size;
+}
+
+/**
+ * Returns the mipmap level that the texture should have streamed in,
+ * according to the sizes passed to request_stream_screen_size() in the
+ * current or previous frame, or -1 if the texture has not been rendered
+ * recently.
+ */
+int Texture::
+get_stream_wanted_level() const {
+  int frame = ClockObject::get_global_clock()->get_frame_count();
+
+  MutexHolder holder(_lock);
+  if (_stream_frame < 0 || _stream_frame < frame - 1) {
+    return -1;
+  }
+  return _stream_wanted_level;
+}
+
+/**
+ * Returns the total number of bytes held by mipmap levels that have been
+ * streamed in, across all textures.  This is the amount that is limited by
+ * texture-stream-memory-limit.
+ */
+size_t Texture::
+get_streamed_ram_size() {
+  pvector<Texture *> textures;
+  collect_streamed_textures(textures);
+
+  size_t total = 0;
+  for (Texture *tex : textures) {
+    CDReader cdata(tex->_cycler);
+    total += tex->do_get_streamed_size(cdata);
+  }
+
+  release_streamed_textures(textures);
+  return total;
+}
+
 /**
  * Returns a modifiable pointer to the internal "simple" texture image.  See
  * set_simple_ram_image().
@@ -2492,10 +2740,13 @@ void Texture::
 texture_uploaded() {
   CDLockedReader cdata(_cycler);
 
-  if (!keep_texture_ram && !cdata->_keep_ram_image) {
+  if (!keep_texture_ram && !cdata->_keep_ram_image &&
+      do_get_stream_base_level(cdata) == 0) {
     // Once we have prepared the texture, we can generally safely remove the
     // pixels from main RAM.  The GSG is now responsible for remembering what
-    // it looks like.
+    // it looks like.  We don't do this while mipmap levels are still being
+    // streamed in, since the GSG will need the levels it already has again
+    // when the next one arrives.
 
     CDWriter cdataw(_cycler, cdata, false);
     if (gobj_cat.is_debug()) {
@@ -5294,6 +5545,7 @@ unlocked_ensure_ram_image(bool allow_compression) {
   cdataw->_keep_ram_image = cdata_tex->_keep_ram_image;
   cdataw->_ram_image_compression = cdata_tex->_ram_image_compression;
   cdataw->_ram_images = cdata_tex->_ram_images;
+  cdataw->_stream_sources = cdata_tex->_stream_sources;
 
   nassertr(_reloading, nullptr);
   _reloading = false;
@@ -5373,6 +5625,7 @@ do_reload_ram_image(CData *cdata, bool allow_compression) {
           cdata->_compression = cdata_tex->_compression;
           cdata->_ram_image_compression = cdata_tex->_ram_image_compression;
           cdata->_ram_images = cdata_tex->_ram_images;
+          cdata->_stream_sources = cdata_tex->_stream_sources;
           cdata->_loaded_from_image = true;
 
           bool was_compressed = (cdata->_ram_image_compression != CM_off);
@@ -5422,6 +5675,10 @@ do_reload_ram_image(CData *cdata, bool allow_compression) {
           cdata->_primary_file_num_channels, cdata->_alpha_file_channel,
           z, n, cdata->_has_read_pages, cdata->_has_read_mipmaps, options, nullptr);
 
+  // If the file was read with texture-streaming enabled, we still need the
+  // rest of the mipmap levels now.
+  do_stream_all_mipmaps(cdata);
+
   if (orig_num_components == cdata->_num_components) {
     // Restore the original format, in case it was needlessly changed during
     // the reload operation.
@@ -5446,6 +5703,7 @@ do_reload_ram_image(CData *cdata, bool allow_compression) {
  */
 PTA_uchar Texture::
 do_modify_ram_image(CData *cdata) {
+  do_stream_all_mipmaps(cdata);
   if (cdata->_ram_images.empty() || cdata->_ram_images[0]._image.empty() ||
       cdata->_ram_image_compression != CM_off) {
     do_make_ram_image(cdata);
@@ -5463,6 +5721,7 @@ PTA_uchar Texture::
 do_make_ram_image(CData *cdata) {
   int image_size = do_get_expected_ram_image_size(cdata);
   cdata->_ram_images.clear();
+  cdata->_stream_sources.clear();
   cdata->_ram_images.push_back(RamImage());
   cdata->_ram_images[0]._page_size = do_get_expected_ram_page_size(cdata);
   cdata->_ram_images[0]._image = PTA_uchar::empty_array(image_size, get_class_type());
@@ -5526,6 +5785,8 @@ do_modify_ram_mipmap_image(CData *cdata, int n) {
   if (n >= (int)cdata->_ram_images.size() ||
       cdata->_ram_images[n]._image.empty()) {
     do_make_ram_mipmap_image(cdata, n);
+  } else if (n < (int)cdata->_stream_sources.size()) {
+    cdata->_stream_sources[n] = StreamSource();
   }
   return cdata->_ram_images[n]._image;
 }
@@ -5541,6 +5802,10 @@ do_make_ram_mipmap_image(CData *cdata, int n) {
     cdata->_ram_images.push_back(RamImage());
   }
 
+  if (n < (int)cdata->_stream_sources.size()) {
+    cdata->_stream_sources[n] = StreamSource();
+  }
+
   size_t image_size = do_get_expected_ram_mipmap_image_size(cdata, n);
   cdata->_ram_images[n]._image = PTA_uchar::empty_array(image_size, get_class_type());
   cdata->_ram_images[n]._pointer_image = nullptr;
@@ -5582,6 +5847,11 @@ do_set_ram_mipmap_image(CData *cdata, int n, CPTA_uchar image, size_t page_size)
     cdata->_ram_images[n]._page_size = page_size;
     cdata->inc_image_modified();
   }
+
+  // This level should no longer be replaced by the data it was read with.
+  if (n < (int)cdata->_stream_sources.size()) {
+    cdata->_stream_sources[n] = StreamSource();
+  }
 }
 
 /**
@@ -5765,6 +6035,7 @@ do_compress_ram_image(CData *cdata, Texture::CompressionMode compression,
                       GraphicsStateGuardianBase *gsg) {
   nassertr(compression != CM_off, false);
 
+  do_stream_all_mipmaps(cdata);
   if (cdata->_ram_images.empty() || cdata->_ram_image_compression != CM_off) {
     return false;
   }
@@ -5907,9 +6178,23 @@ do_compress_ram_image(CData *cdata, Texture::CompressionMode compression,
 
     cdata->_ram_images.swap(compressed_ram_images);
     cdata->_ram_image_compression = CM_rgtc;
+    cdata->_stream_sources.clear();
     return true;
   }
 
+  if (quality_level == QL_fastest && texture_fast_dxt_encoder &&
+      (compression == CM_dxt1 || compression == CM_dxt3 || compression == CM_dxt5) &&
+      cdata->_texture_type != TT_3d_texture &&
+      cdata->_texture_type != TT_2d_texture_array &&
+      cdata->_component_type == T_unsigned_byte) {
+    // If requested, we use our own encoder in preview quality, which chooses
+    // the endpoints of each block in a single pass.  It is many times faster
+    // than squish, at the cost of some quality.
+    size_t block_size = (compression == CM_dxt1) ? 8 : 16;
+    return do_compress_blocks(cdata, compression, block_size,
+                              &compress_block_dxt_fast, (int)compression);
+  }
+
 #ifdef HAVE_SQUISH
   if (cdata->_texture_type != TT_3d_texture &&
       cdata->_texture_type != TT_2d_texture_array &&
@@ -5969,6 +6254,7 @@ do_compress_ram_image(CData *cdata, Texture::CompressionMode compression,
 bool Texture::
 do_uncompress_ram_image(CData *cdata) {
   nassertr(!cdata->_ram_images.empty(), false);
+  do_stream_all_mipmaps(cdata);
 
   if (cdata->_ram_image_compression == CM_rgtc) {
     // We should decompress RGTC ourselves, as squish doesn't support it.
@@ -5999,6 +6285,7 @@ do_uncompress_ram_image(CData *cdata) {
     }
     cdata->_ram_images.swap(uncompressed_ram_images);
     cdata->_ram_image_compression = CM_off;
+    cdata->_stream_sources.clear();
     return true;
   }
 
@@ -6031,6 +6318,19 @@ do_uncompress_ram_image(CData *cdata) {
       }
     }
   }
+
+#else  // HAVE_SQUISH
+  if ((cdata->_ram_image_compression == CM_dxt1 ||
+       cdata->_ram_image_compression == CM_dxt3 ||
+       cdata->_ram_image_compression == CM_dxt5) &&
+      cdata->_texture_type != TT_3d_texture &&
+      cdata->_texture_type != TT_2d_texture_array &&
+      cdata->_component_type == T_unsigned_byte) {
+    // Without squish, we can still decode DXT images ourselves.
+    size_t block_size = (cdata->_ram_image_compression == CM_dxt1) ? 8 : 16;
+    return do_uncompress_blocks(cdata, block_size, &decompress_block_dxt,
+                                (int)cdata->_ram_image_compression);
+  }
 #endif  // HAVE_SQUISH
   return false;
 }
@@ -6467,7 +6767,7 @@ do_uncompress_ram_image_bc5(const RamImage &compressed_image,
  */
 bool Texture::
 do_has_all_ram_mipmap_images(const CData *cdata) const {
-  if (cdata->_ram_images.empty() || cdata->_ram_images[0]._image.empty()) {
+  if (!do_has_ram_image(cdata) && cdata->_stream_sources.empty()) {
     // If we don't even have a base image, the answer is no.
     return false;
   }
@@ -6484,7 +6784,12 @@ do_has_all_ram_mipmap_images(const CData *cdata) const {
   while (x < size) {
     x = (x << 1);
     ++n;
-    if (n >= (int)cdata->_ram_images.size() || cdata->_ram_images[n]._image.empty()) {
+    if (n >= (int)cdata->_ram_images.size()) {
+      return false;
+    }
+    if (cdata->_ram_images[n]._image.empty() &&
+        (n >= (int)cdata->_stream_sources.size() ||
+         cdata->_stream_sources[n]._mapping == nullptr)) {
       return false;
     }
   }
@@ -7144,6 +7449,8 @@ do_has_uncompressed_ram_image(const CData *cdata) const {
  */
 CPTA_uchar Texture::
 do_get_ram_image(CData *cdata) {
+  do_stream_all_mipmaps(cdata);
+
   if (!do_has_ram_image(cdata) && do_can_reload(cdata)) {
     do_reload_ram_image(cdata, true);
 
@@ -7168,6 +7475,8 @@ do_get_ram_image(CData *cdata) {
  */
 CPTA_uchar Texture::
 do_get_uncompressed_ram_image(CData *cdata) {
+  do_stream_all_mipmaps(cdata);
+
   if (!cdata->_ram_images.empty() && cdata->_ram_image_compression != CM_off) {
     // We have an image in-ram, but it's compressed.  Try to uncompress it
     // first.
@@ -7548,6 +7857,7 @@ do_clear_ram_mipmap_images(CData *cdata) {
   if (!cdata->_ram_images.empty()) {
     cdata->_ram_images.erase(cdata->_ram_images.begin() + 1, cdata->_ram_images.end());
   }
+  cdata->_stream_sources.clear();
 }
 
 /**
@@ -7714,7 +8024,8 @@ do_reload(CData *cdata) {
  */
 bool Texture::
 do_has_bam_rawdata(const CData *cdata) const {
-  return do_has_ram_image(cdata);
+  // The levels that haven't been streamed in are written from their source.
+  return do_has_ram_image(cdata) || !cdata->_stream_sources.empty();
 }
 
 /**
@@ -7726,6 +8037,63 @@ do_get_bam_rawdata(CData *cdata) {
   do_get_ram_image(cdata);
 }
 
+/**
+ * The protected implementation of get_stream_base_level().  Assumes the lock
+ * is already held.
+ */
+int Texture::
+do_get_stream_base_level(const CData *cdata) const {
+  if (cdata->_stream_sources.empty()) {
+    return 0;
+  }
+  int n = (int)cdata->_ram_images.size();
+  while (n > 0 && !cdata->_ram_images[n - 1]._image.empty()) {
+    --n;
+  }
+  return n;
+}
+
+/**
+ * Synchronously loads all of the mipmap levels that have not yet been
+ * streamed in.  Returns true if any were loaded.  Assumes the lock is already
+ * held.
+ */
+bool Texture::
+do_stream_all_mipmaps(CData *cdata) {
+  int base_level = do_get_stream_base_level(cdata);
+  int n = base_level - 1;
+  while (n >= 0 && cdata->_stream_sources[n]._mapping != nullptr) {
+    const StreamSource &source = cdata->_stream_sources[n];
+    PTA_uchar image = PTA_uchar::empty_array(source._size, get_class_type());
+    memcpy(image.p(), source._data, source._size);
+    cdata->_ram_images[n]._image = image;
+    cdata->_ram_images[n]._pointer_image = nullptr;
+    --n;
+  }
+
+  if (n + 1 == base_level) {
+    return false;
+  }
+  cdata->inc_image_modified();
+  register_streamed();
+  return true;
+}
+
+/**
+ * Returns the number of bytes held by the mipmap levels that were streamed
+ * in.  Assumes the lock is already held.
+ */
+size_t Texture::
+do_get_streamed_size(const CData *cdata) const {
+  size_t size = 0;
+  for (size_t n = 0; n < cdata->_stream_sources.size(); ++n) {
+    if (cdata->_stream_sources[n]._mapping != nullptr) {
+      size += cdata->_ram_images[n]._image.size();
+    }
+  }
+  return size;
+}
+
 /**
  * Internal method to convert pixel data from the indicated PNMImage into the
  * given ram_image.
@@ -9655,167 +10023,298 @@ filter_3d_float(unsigned char *&p, const unsigned char *&q,
 }
 
 /**
- * Invokes the squish library to compress the RAM image(s).
+ * Describes a range of block rows within one page of one mipmap level, which
+ * is the unit of work handed out by do_compress_blocks() and
+ * do_uncompress_blocks().
+ */
+struct TextureBlockChunk {
+  int _n;
+  int _z;
+  int _x_size;
+  int _y_size;
+  int _begin;
+  int _end;
+};
+
+/**
+ * Divides the indicated mipmap level into chunks of block rows, large enough
+ * that the overhead of handing out each chunk is negligible.
+ */
+static void
+add_block_chunks(pvector<TextureBlockChunk> &chunks, int n,
+                 int x_size, int y_size, int num_pages) {
+  static const int min_blocks_per_chunk = 256;
+
+  int x_blocks = (x_size + 3) >> 2;
+  int y_blocks = (y_size + 3) >> 2;
+  int rows_per_chunk = max(min_blocks_per_chunk / x_blocks, 1);
+
+  for (int z = 0; z < num_pages; ++z) {
+    for (int y = 0; y < y_blocks; y += rows_per_chunk) {
+      TextureBlockChunk chunk;
+      chunk._n = n;
+      chunk._z = z;
+      chunk._x_size = x_size;
+      chunk._y_size = y_size;
+      chunk._begin = y;
+      chunk._end = min(y + rows_per_chunk, y_blocks);
+      chunks.push_back(chunk);
+    }
+  }
+}
+
+/**
+ * Returns the job runner that divides the work of compressing and
+ * uncompressing textures.  It is shared by all threads; its number of threads
+ * follows texture-compress-num-threads, which may be changed at runtime.
+ */
+static ParallelJobRunner &
+get_compress_job_runner() {
+  static ParallelJobRunner job_runner("texture_compress", texture_compress_num_threads);
+  job_runner.set_num_threads(texture_compress_num_threads);
+  return job_runner;
+}
+
+/**
+ * Compresses the RAM image(s) one 4 x 4 block at a time, using the indicated
+ * function to encode each block.  The func receives the block as 16 RGBA
+ * pixels, along with a mask of the pixels that are actually within the image.
+ *
+ * The images are divided into chunks of block rows, across all of the pages
+ * and mipmap levels, and the chunks are compressed in parallel according to
+ * texture-compress-num-threads.
  */
 bool Texture::
-do_squish(CData *cdata, Texture::CompressionMode compression, int squish_flags) {
-#ifdef HAVE_SQUISH
+do_compress_blocks(CData *cdata, Texture::CompressionMode compression,
+                   size_t block_size, CompressBlockFunc *func, int flags) {
   if (!do_has_all_ram_mipmap_images(cdata)) {
     // If we're about to compress the RAM image, we should ensure that we have
     // all of the mipmap levels first.
     do_generate_ram_mipmap_images(cdata, false);
   }
 
-  RamImages compressed_ram_images;
-  compressed_ram_images.reserve(cdata->_ram_images.size());
+  RamImages compressed_ram_images(cdata->_ram_images.size());
+  pvector<TextureBlockChunk> chunks;
   for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
-    RamImage compressed_image;
     int x_size = do_get_expected_mipmap_x_size(cdata, n);
     int y_size = do_get_expected_mipmap_y_size(cdata, n);
     int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
-    int page_size = squish::GetStorageRequirements(x_size, y_size, squish_flags);
-    int cell_size = squish::GetStorageRequirements(4, 4, squish_flags);
-
-    compressed_image._page_size = page_size;
-    compressed_image._image = PTA_uchar::empty_array(page_size * num_pages);
-    for (int z = 0; z < num_pages; ++z) {
-      unsigned char *dest_page = compressed_image._image.p() + z * page_size;
-      unsigned const char *source_page = cdata->_ram_images[n]._image.p() + z * cdata->_ram_images[n]._page_size;
-      unsigned const char *source_page_end = source_page + cdata->_ram_images[n]._page_size;
-      // Convert one 4 x 4 cell at a time.
-      unsigned char *d = dest_page;
-      for (int y = 0; y < y_size; y += 4) {
-        for (int x = 0; x < x_size; x += 4) {
-          unsigned char tb[16 * 4];
-          int mask = 0;
-          unsigned char *t = tb;
-          for (int i = 0; i < 16; ++i) {
-            int xi = x + i % 4;
-            int yi = y + i / 4;
-            unsigned const char *s = source_page + (yi * x_size + xi) * cdata->_num_components;
-            if (s < source_page_end) {
-              switch (cdata->_num_components) {
-              case 1:
-                t[0] = s[0];   // r
-                t[1] = s[0];   // g
-                t[2] = s[0];   // b
-                t[3] = 255;    // a
-                break;
-
-              case 2:
-                t[0] = s[0];   // r
-                t[1] = s[0];   // g
-                t[2] = s[0];   // b
-                t[3] = s[1];   // a
-                break;
-
-              case 3:
-                t[0] = s[2];   // r
-                t[1] = s[1];   // g
-                t[2] = s[0];   // b
-                t[3] = 255;    // a
-                break;
-
-              case 4:
-                t[0] = s[2];   // r
-                t[1] = s[1];   // g
-                t[2] = s[0];   // b
-                t[3] = s[3];   // a
-                break;
-              }
-              mask |= (1 << i);
-            }
+
+    RamImage &compressed_image = compressed_ram_images[n];
+    compressed_image._page_size = (size_t)((x_size + 3) >> 2) * (size_t)((y_size + 3) >> 2) * block_size;
+    compressed_image._image = PTA_uchar::empty_array(compressed_image._page_size * num_pages);
+
+    add_block_chunks(chunks, (int)n, x_size, y_size, num_pages);
+  }
+
+  int num_components = cdata->_num_components;
+  const RamImages &ram_images = cdata->_ram_images;
+
+  auto compress_job = [&] (int job, Thread *current_thread) {
+    const TextureBlockChunk &chunk = chunks[job];
+    int x_size = chunk._x_size;
+    int y_size = chunk._y_size;
+    int x_blocks = (x_size + 3) >> 2;
+    size_t page_pixels = (size_t)x_size * (size_t)y_size;
+
+    const RamImage &source_image = ram_images[chunk._n];
+    unsigned const char *source_page = source_image._image.p() + chunk._z * source_image._page_size;
+
+    RamImage &dest_image = compressed_ram_images[chunk._n];
+    unsigned char *d = dest_image._image.p() + chunk._z * dest_image._page_size +
+      (size_t)chunk._begin * x_blocks * block_size;
+
+    for (int y = chunk._begin * 4; y < chunk._end * 4; y += 4) {
+      for (int x = 0; x < x_size; x += 4) {
+        unsigned char tb[16 * 4];
+        int mask = 0;
+        unsigned char *t = tb;
+        for (int i = 0; i < 16; ++i) {
+          // A block that hangs over the right edge of the image picks up the
+          // first pixels of the next row; only the pixels past the end of the
+          // page are masked out.
+          size_t pi = (size_t)(y + (i >> 2)) * x_size + (x + (i & 3));
+          if (pi >= page_pixels) {
+            t[0] = t[1] = t[2] = t[3] = 0;
             t += 4;
+            continue;
           }
-          squish::CompressMasked(tb, mask, d, squish_flags);
-          d += cell_size;
-          Thread::consider_yield();
+          mask |= (1 << i);
+          unsigned const char *s = source_page + pi * num_components;
+          switch (num_components) {
+          case 1:
+            t[0] = s[0];   // r
+            t[1] = s[0];   // g
+            t[2] = s[0];   // b
+            t[3] = 255;    // a
+            break;
+
+          case 2:
+            t[0] = s[0];   // r
+            t[1] = s[0];   // g
+            t[2] = s[0];   // b
+            t[3] = s[1];   // a
+            break;
+
+          case 3:
+            t[0] = s[2];   // r
+            t[1] = s[1];   // g
+            t[2] = s[0];   // b
+            t[3] = 255;    // a
+            break;
+
+          case 4:
+            t[0] = s[2];   // r
+            t[1] = s[1];   // g
+            t[2] = s[0];   // b
+            t[3] = s[3];   // a
+            break;
+          }
+          t += 4;
         }
+        (*func)(d, tb, mask, flags);
+        d += block_size;
       }
+      Thread::consider_yield();
     }
-    compressed_ram_images.push_back(compressed_image);
-  }
+  };
+
+  get_compress_job_runner().run((int)chunks.size(), compress_job);
+
   cdata->_ram_images.swap(compressed_ram_images);
   cdata->_ram_image_compression = compression;
+  cdata->_stream_sources.clear();
   return true;
-
-#else  // HAVE_SQUISH
-  return false;
-
-#endif  // HAVE_SQUISH
 }
 
 /**
- * Invokes the squish library to uncompress the RAM image(s).
+ * The reverse of do_compress_blocks(), this uncompresses the RAM image(s) one
+ * 4 x 4 block at a time, using the indicated function to decode each block
+ * into 16 RGBA pixels.
  */
 bool Texture::
-do_unsquish(CData *cdata, int squish_flags) {
-#ifdef HAVE_SQUISH
-  RamImages uncompressed_ram_images;
-  uncompressed_ram_images.reserve(cdata->_ram_images.size());
+do_uncompress_blocks(CData *cdata, size_t block_size,
+                     DecompressBlockFunc *func, int flags) {
+  RamImages uncompressed_ram_images(cdata->_ram_images.size());
+  pvector<TextureBlockChunk> chunks;
   for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
-    RamImage uncompressed_image;
     int x_size = do_get_expected_mipmap_x_size(cdata, n);
     int y_size = do_get_expected_mipmap_y_size(cdata, n);
     int num_pages = do_get_expected_mipmap_num_pages(cdata, n);
-    int page_size = squish::GetStorageRequirements(x_size, y_size, squish_flags);
-    int cell_size = squish::GetStorageRequirements(4, 4, squish_flags);
 
+    size_t compressed_page_size = (size_t)((x_size + 3) >> 2) * (size_t)((y_size + 3) >> 2) * block_size;
+    if (cdata->_ram_images[n]._page_size < compressed_page_size ||
+        cdata->_ram_images[n]._image.size() < compressed_page_size * num_pages) {
+      gobj_cat.error()
+        << "Compressed RAM image for level " << n << " of " << get_name()
+        << " is too small.\n";
+      return false;
+    }
+
+    RamImage &uncompressed_image = uncompressed_ram_images[n];
     uncompressed_image._page_size = do_get_expected_ram_mipmap_page_size(cdata, n);
     uncompressed_image._image = PTA_uchar::empty_array(uncompressed_image._page_size * num_pages);
-    for (int z = 0; z < num_pages; ++z) {
-      unsigned char *dest_page = uncompressed_image._image.p() + z * uncompressed_image._page_size;
-      unsigned char *dest_page_end = dest_page + uncompressed_image._page_size;
-      unsigned const char *source_page = cdata->_ram_images[n]._image.p() + z * page_size;
-      // Unconvert one 4 x 4 cell at a time.
-      unsigned const char *s = source_page;
-      for (int y = 0; y < y_size; y += 4) {
-        for (int x = 0; x < x_size; x += 4) {
-          unsigned char tb[16 * 4];
-          squish::Decompress(tb, s, squish_flags);
-          s += cell_size;
-
-          unsigned char *t = tb;
-          for (int i = 0; i < 16; ++i) {
-            int xi = x + i % 4;
-            int yi = y + i / 4;
-            unsigned char *d = dest_page + (yi * x_size + xi) * cdata->_num_components;
-            if (d < dest_page_end) {
-              switch (cdata->_num_components) {
-              case 1:
-                d[0] = t[1];   // g
-                break;
-
-              case 2:
-                d[0] = t[1];   // g
-                d[1] = t[3];   // a
-                break;
-
-              case 3:
-                d[2] = t[0];   // r
-                d[1] = t[1];   // g
-                d[0] = t[2];   // b
-                break;
-
-              case 4:
-                d[2] = t[0];   // r
-                d[1] = t[1];   // g
-                d[0] = t[2];   // b
-                d[3] = t[3];   // a
-                break;
-              }
+
+    add_block_chunks(chunks, (int)n, x_size, y_size, num_pages);
+  }
+
+  int num_components = cdata->_num_components;
+  const RamImages &ram_images = cdata->_ram_images;
+
+  auto uncompress_job = [&] (int job, Thread *current_thread) {
+    const TextureBlockChunk &chunk = chunks[job];
+    int x_size = chunk._x_size;
+    int y_size = chunk._y_size;
+    int x_blocks = (x_size + 3) >> 2;
+
+    const RamImage &source_image = ram_images[chunk._n];
+    unsigned const char *s = source_image._image.p() + chunk._z * source_image._page_size +
+      (size_t)chunk._begin * x_blocks * block_size;
+
+    RamImage &dest_image = uncompressed_ram_images[chunk._n];
+    unsigned char *dest_page = dest_image._image.p() + chunk._z * dest_image._page_size;
+
+    for (int y = chunk._begin * 4; y < chunk._end * 4; y += 4) {
+      for (int x = 0; x < x_size; x += 4) {
+        unsigned char tb[16 * 4];
+        (*func)(tb, s, flags);
+        s += block_size;
+
+        unsigned char *t = tb;
+        for (int i = 0; i < 16; ++i) {
+          int xi = x + (i & 3);
+          int yi = y + (i >> 2);
+          if (xi < x_size && yi < y_size) {
+            unsigned char *d = dest_page + ((size_t)yi * x_size + xi) * num_components;
+            switch (num_components) {
+            case 1:
+              d[0] = t[1];   // g
+              break;
+
+            case 2:
+              d[0] = t[1];   // g
+              d[1] = t[3];   // a
+              break;
+
+            case 3:
+              d[2] = t[0];   // r
+              d[1] = t[1];   // g
+              d[0] = t[2];   // b
+              break;
+
+            case 4:
+              d[2] = t[0];   // r
+              d[1] = t[1];   // g
+              d[0] = t[2];   // b
+              d[3] = t[3];   // a
+              break;
             }
-            t += 4;
           }
+          t += 4;
         }
-        Thread::consider_yield();
       }
+      Thread::consider_yield();
     }
-    uncompressed_ram_images.push_back(uncompressed_image);
-  }
+  };
+
+  get_compress_job_runner().run((int)chunks.size(), uncompress_job);
+
   cdata->_ram_images.swap(uncompressed_ram_images);
   cdata->_ram_image_compression = CM_off;
+  cdata->_stream_sources.clear();
   return true;
+}
+
+#ifdef HAVE_SQUISH
+/**
+ * Compresses a single block with squish, for passing to do_compress_blocks().
+ */
+static void
+squish_compress_block(unsigned char *dest, const unsigned char *rgba,
+                      int mask, int squish_flags) {
+  squish::CompressMasked(rgba, mask, dest, squish_flags);
+}
+
+/**
+ * Uncompresses a single block with squish, for passing to
+ * do_uncompress_blocks().
+ */
+static void
+squish_decompress_block(unsigned char *rgba, const unsigned char *source,
+                        int squish_flags) {
+  squish::Decompress(rgba, source, squish_flags);
+}
+#endif  // HAVE_SQUISH
+
+/**
+ * Invokes the squish library to compress the RAM image(s).
+ */
+bool Texture::
+do_squish(CData *cdata, Texture::CompressionMode compression, int squish_flags) {
+#ifdef HAVE_SQUISH
+  size_t cell_size = squish::GetStorageRequirements(4, 4, squish_flags);
+  return do_compress_blocks(cdata, compression, cell_size,
+                            &squish_compress_block, squish_flags);
 
 #else  // HAVE_SQUISH
   return false;
@@ -9823,6 +10322,447 @@ do_unsquish(CData *cdata, int squish_flags) {
 #endif  // HAVE_SQUISH
 }
 
+/**
+ * Invokes the squish library to uncompress the RAM image(s).
+ */
+bool Texture::
+do_unsquish(CData *cdata, int squish_flags) {
+#ifdef HAVE_SQUISH
+  size_t cell_size = squish::GetStorageRequirements(4, 4, squish_flags);
+  return do_uncompress_blocks(cdata, cell_size,
+                              &squish_decompress_block, squish_flags);
+
+#else  // HAVE_SQUISH
+  return false;
+
+#endif  // HAVE_SQUISH
+}
+
+/**
+ * Packs an 8-bit RGB color into the 5:6:5 representation used by the DXT
+ * color endpoints.
+ */
+static inline unsigned int
+pack_565(const int *rgb) {
+  return (((rgb[0] * 31 + 127) / 255) << 11) |
+         (((rgb[1] * 63 + 127) / 255) << 5) |
+          ((rgb[2] * 31 + 127) / 255);
+}
+
+/**
+ * Expands a 5:6:5 DXT color endpoint back to 8 bits per channel.
+ */
+static inline void
+unpack_565(unsigned int color, int *rgb) {
+  int r = (color >> 11) & 0x1f;
+  int g = (color >> 5) & 0x3f;
+  int b = color & 0x1f;
+  rgb[0] = (r << 3) | (r >> 2);
+  rgb[1] = (g << 2) | (g >> 4);
+  rgb[2] = (b << 3) | (b >> 2);
+}
+
+/**
+ * Encodes the color part of a DXT block.  If dxt1 is true, pixels with an
+ * alpha below 128 are encoded as transparent, using the three-color mode.
+ */
+static void
+encode_dxt_color_block(unsigned char *dest, const unsigned char *rgba,
+                       int mask, bool dxt1) {
+  int color_mask = mask;
+  if (dxt1) {
+    for (int i = 0; i < 16; ++i) {
+      if (rgba[i * 4 + 3] < 128) {
+        color_mask &= ~(1 << i);
+      }
+    }
+  }
+  bool transparent = (color_mask != mask);
+
+  // Find the bounding box of the colors in the block.
+  int min_rgb[3] = {255, 255, 255};
+  int max_rgb[3] = {0, 0, 0};
+  int sum[3] = {0, 0, 0};
+  int count = 0;
+  for (int i = 0; i < 16; ++i) {
+    if (color_mask & (1 << i)) {
+      const unsigned char *p = rgba + i * 4;
+      for (int c = 0; c < 3; ++c) {
+        min_rgb[c] = min(min_rgb[c], (int)p[c]);
+        max_rgb[c] = max(max_rgb[c], (int)p[c]);
+        sum[c] += p[c];
+      }
+      ++count;
+    }
+  }
+
+  unsigned int color0 = 0;
+  unsigned int color1 = 0;
+  int palette[4][3];
+  int num_colors = 0;
+
+  if (count > 0) {
+    // The endpoints lie on a diagonal of the bounding box.  Take the channel
+    // with the largest range as the principal axis, and flip the channels
+    // that decrease as it increases.
+    int axis = 0;
+    for (int c = 1; c < 3; ++c) {
+      if (max_rgb[c] - min_rgb[c] > max_rgb[axis] - min_rgb[axis]) {
+        axis = c;
+      }
+    }
+    int cov[3] = {0, 0, 0};
+    for (int i = 0; i < 16; ++i) {
+      if (color_mask & (1 << i)) {
+        const unsigned char *p = rgba + i * 4;
+        int da = p[axis] * count - sum[axis];
+        for (int c = 0; c < 3; ++c) {
+          cov[c] += da * (p[c] * count - sum[c]);
+        }
+      }
+    }
+
+    int hi[3], lo[3];
+    for (int c = 0; c < 3; ++c) {
+      if (cov[c] < 0) {
+        hi[c] = min_rgb[c];
+        lo[c] = max_rgb[c];
+      } else {
+        hi[c] = max_rgb[c];
+        lo[c] = min_rgb[c];
+      }
+
+      // Inset the endpoints by 1/16th of the range, which reduces the error
+      // for the colors in the interior of the box.
+      int inset = (hi[c] - lo[c]) / 16;
+      hi[c] -= inset;
+      lo[c] += inset;
+    }
+
+    color0 = pack_565(hi);
+    color1 = pack_565(lo);
+
+    // The order of the endpoints selects the mode: color0 > color1 for four
+    // colors, or color0 <= color1 for three colors plus transparent.
+    if (transparent ? (color0 > color1) : (color0 < color1)) {
+      swap(color0, color1);
+    }
+
+    unpack_565(color0, palette[0]);
+    unpack_565(color1, palette[1]);
+    if (color0 > color1) {
+      for (int c = 0; c < 3; ++c) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+      }
+      num_colors = 4;
+    } else {
+      for (int c = 0; c < 3; ++c) {
+        palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+      }
+      num_colors = 3;
+    }
+  }
+
+  // Now assign each pixel to the nearest color in the palette.
+  uint32_t indices = 0;
+  for (int i = 0; i < 16; ++i) {
+    int index = 0;
+    if (color_mask & (1 << i)) {
+      const unsigned char *p = rgba + i * 4;
+      int best_dist = 0x7fffffff;
+      for (int j = 0; j < num_colors; ++j) {
+        int dr = p[0] - palette[j][0];
+        int dg = p[1] - palette[j][1];
+        int db = p[2] - palette[j][2];
+        int dist = dr * dr + dg * dg + db * db;
+        if (dist < best_dist) {
+          best_dist = dist;
+          index = j;
+        }
+      }
+    } else if (mask & (1 << i)) {
+      // A transparent pixel.
+      index = 3;
+    }
+    indices |= (uint32_t)index << (i * 2);
+  }
+
+  dest[0] = color0 & 0xff;
+  dest[1] = color0 >> 8;
+  dest[2] = color1 & 0xff;
+  dest[3] = color1 >> 8;
+  dest[4] = indices & 0xff;
+  dest[5] = (indices >> 8) & 0xff;
+  dest[6] = (indices >> 16) & 0xff;
+  dest[7] = indices >> 24;
+}
+
+/**
+ * Encodes the explicit alpha part of a DXT3 block.
+ */
+static void
+encode_dxt3_alpha_block(unsigned char *dest, const unsigned char *rgba) {
+  for (int i = 0; i < 8; ++i) {
+    int a0 = (rgba[i * 8 + 3] * 15 + 127) / 255;
+    int a1 = (rgba[i * 8 + 7] * 15 + 127) / 255;
+    dest[i] = a0 | (a1 << 4);
+  }
+}
+
+/**
+ * Encodes the interpolated alpha part of a DXT5 block, using the eight-value
+ * mode between the minimum and maximum alpha in the block.
+ */
+static void
+encode_dxt5_alpha_block(unsigned char *dest, const unsigned char *rgba,
+                        int mask) {
+  static const int remap[] = {1, 7, 6, 5, 4, 3, 2, 0};
+
+  int min_a = 255;
+  int max_a = 0;
+  for (int i = 0; i < 16; ++i) {
+    if (mask & (1 << i)) {
+      min_a = min(min_a, (int)rgba[i * 4 + 3]);
+      max_a = max(max_a, (int)rgba[i * 4 + 3]);
+    }
+  }
+
+  uint64_t indices = 0;
+  if (max_a > min_a) {
+    int range = max_a - min_a;
+    for (int i = 0; i < 16; ++i) {
+      int a = min(max((int)rgba[i * 4 + 3], min_a), max_a);
+      int t = ((a - min_a) * 7 + range / 2) / range;
+      indices |= (uint64_t)remap[t] << (i * 3);
+    }
+  } else {
+    max_a = min_a;
+  }
+
+  dest[0] = max_a;
+  dest[1] = min_a;
+  for (int i = 0; i < 6; ++i) {
+    dest[i + 2] = (indices >> (i * 8)) & 0xff;
+  }
+}
+
+/**
+ * Compresses a single 4 x 4 block to DXT1, DXT3 or DXT5, for passing to
+ * do_compress_blocks().  This is the encoder used for QL_fastest when
+ * texture-fast-dxt-encoder is set: rather than searching for the best
+ * endpoints, it takes them from the bounding box of the colors in the block,
+ * which is several times faster than squish's range fit and many times faster
+ * than its cluster fit.
+ */
+void Texture::
+compress_block_dxt_fast(unsigned char *dest, const unsigned char *rgba,
+                        int mask, int compression) {
+  switch ((CompressionMode)compression) {
+  case CM_dxt1:
+    encode_dxt_color_block(dest, rgba, mask, true);
+    break;
+
+  case CM_dxt3:
+    encode_dxt3_alpha_block(dest, rgba);
+    encode_dxt_color_block(dest + 8, rgba, mask, false);
+    break;
+
+  case CM_dxt5:
+    encode_dxt5_alpha_block(dest, rgba, mask);
+    encode_dxt_color_block(dest + 8, rgba, mask, false);
+    break;
+
+  default:
+    break;
+  }
+}
+
+/**
+ * Uncompresses a single DXT1, DXT3 or DXT5 block into 16 RGBA pixels, for
+ * passing to do_uncompress_blocks().  This is used when squish is not
+ * available.
+ */
+void Texture::
+decompress_block_dxt(unsigned char *rgba, const unsigned char *source,
+                     int compression) {
+  bool dxt1 = (compression == CM_dxt1);
+  const unsigned char *color_block = dxt1 ? source : source + 8;
+
+  unsigned int color0 = color_block[0] | (color_block[1] << 8);
+  unsigned int color1 = color_block[2] | (color_block[3] << 8);
+
+  int palette[4][4];
+  unpack_565(color0, palette[0]);
+  unpack_565(color1, palette[1]);
+  palette[0][3] = 255;
+  palette[1][3] = 255;
+  palette[2][3] = 255;
+  palette[3][3] = 255;
+  if (!dxt1 || color0 > color1) {
+    for (int c = 0; c < 3; ++c) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+  } else {
+    for (int c = 0; c < 3; ++c) {
+      palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+      palette[3][c] = 0;
+    }
+    palette[3][3] = 0;
+  }
+
+  for (int i = 0; i < 16; ++i) {
+    int index = (color_block[4 + (i >> 2)] >> ((i & 3) * 2)) & 0x3;
+    rgba[i * 4 + 0] = palette[index][0];
+    rgba[i * 4 + 1] = palette[index][1];
+    rgba[i * 4 + 2] = palette[index][2];
+    rgba[i * 4 + 3] = palette[index][3];
+  }
+
+  if (compression == CM_dxt3) {
+    for (int i = 0; i < 16; ++i) {
+      int a = (source[i >> 1] >> ((i & 1) * 4)) & 0xf;
+      rgba[i * 4 + 3] = a * 17;
+    }
+
+  } else if (compression == CM_dxt5) {
+    int alpha[8];
+    alpha[0] = source[0];
+    alpha[1] = source[1];
+    if (alpha[0] > alpha[1]) {
+      for (int i = 2; i < 8; ++i) {
+        alpha[i] = ((8 - i) * alpha[0] + (i - 1) * alpha[1]) / 7;
+      }
+    } else {
+      for (int i = 2; i < 6; ++i) {
+        alpha[i] = ((6 - i) * alpha[0] + (i - 1) * alpha[1]) / 5;
+      }
+      alpha[6] = 0;
+      alpha[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i) {
+      indices |= (uint64_t)source[i + 2] << (i * 8);
+    }
+    for (int i = 0; i < 16; ++i) {
+      rgba[i * 4 + 3] = alpha[(indices >> (i * 3)) & 0x7];
+    }
+  }
+}
+
+/**
+ * Adds the texture to the set of textures that have streamed in some mipmap
+ * levels, so that they can be considered by make_stream_room().
+ */
+void Texture::
+register_streamed() {
+  LightMutexHolder holder(_streamed_textures_lock);
+  if (!_stream_registered) {
+    if (_streamed_textures == nullptr) {
+      _streamed_textures = new StreamedTextures;
+    }
+    _streamed_textures->insert(this);
+    _stream_registered = true;
+  }
+}
+
+/**
+ * Fills the vector with the textures that have streamed in some mipmap
+ * levels.  Each one is given an extra reference, which must be released with
+ * release_streamed_textures().  This is done so that we don't need to hold
+ * _streamed_textures_lock while locking the individual textures.
+ */
+void Texture::
+collect_streamed_textures(pvector<Texture *> &textures) {
+  LightMutexHolder holder(_streamed_textures_lock);
+  if (_streamed_textures == nullptr) {
+    return;
+  }
+  textures.reserve(_streamed_textures->size());
+  for (Texture *tex : *_streamed_textures) {
+    // Skip a texture that is in the process of being destructed.
+    if (tex->ref_if_nonzero()) {
+      textures.push_back(tex);
+    }
+  }
+}
+
+/**
+ * Releases the references that were added by collect_streamed_textures().
+ */
+void Texture::
+release_streamed_textures(pvector<Texture *> &textures) {
+  for (Texture *tex : textures) {
+    unref_delete(tex);
+  }
+  textures.clear();
+}
+
+/**
+ * Called by stream_mipmap_level() to ensure that the indicated number of
+ * additional bytes fits within texture-stream-memory-limit.  If it does not,
+ * drops streamed-in mipmap levels from textures with a lower priority than
+ * the indicated one, starting with the largest levels of the textures with
+ * the lowest priority.  Returns true if there is room, false otherwise.
+ */
+bool Texture::
+make_stream_room(Texture *requester, size_t size, PN_stdfloat priority) {
+  int64_t limit = texture_stream_memory_limit;
+  if (limit <= 0) {
+    return true;
+  }
+
+  pvector<Texture *> textures;
+  collect_streamed_textures(textures);
+
+  // Get the current usage, and sort the textures we may take memory from by
+  // ascending priority.
+  typedef pvector<std::pair<PN_stdfloat, Texture *> > Candidates;
+  Candidates candidates;
+  int64_t total = 0;
+  for (Texture *tex : textures) {
+    {
+      CDReader cdata(tex->_cycler);
+      total += (int64_t)tex->do_get_streamed_size(cdata);
+    }
+    if (tex != requester) {
+      PN_stdfloat tex_priority = tex->get_stream_priority();
+      if (tex_priority < priority) {
+        candidates.push_back(std::make_pair(tex_priority, tex));
+      }
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+
+  Candidates::const_iterator ci = candidates.begin();
+  while (total + (int64_t)size > limit && ci != candidates.end()) {
+    Texture *tex = (*ci).second;
+    int base_level = tex->get_stream_base_level();
+    size_t freed = tex->evict_streamed_mipmaps(base_level + 1);
+    if (freed == 0) {
+      // Nothing more to drop from this one.
+      ++ci;
+    } else {
+      total -= (int64_t)freed;
+    }
+  }
+
+  release_streamed_textures(textures);
+  return total + (int64_t)size <= limit;
+}
+
+/**
+ * Called by a TextureStreamRequest when it finishes, so that a new request
+ * may be queued up when needed.
+ */
+void Texture::
+stream_request_done() {
+  MutexHolder holder(_lock);
+  _stream_pending = false;
+}
+
 /**
  * Factory method to generate a Texture object
  */
@@ -10077,8 +11017,17 @@ do_write_datagram_rawdata(CData *cdata, BamWriter *manager, Datagram &me) {
     me.add_uint8(cdata->_ram_images.size());
     for (size_t n = 0; n < cdata->_ram_images.size(); ++n) {
       me.add_uint32(cdata->_ram_images[n]._page_size);
+      if (cdata->_ram_images[n]._image.empty() &&
+          n < cdata->_stream_sources.size() &&
+          cdata->_stream_sources[n]._mapping != nullptr) {
+        // This level hasn't been streamed in; copy it from the source file.
+        const StreamSource &source = cdata->_stream_sources[n];
+        me.add_uint32(source._size);
+        manager->write_aligned_data(me, source._data, source._size);
+        continue;
+      }
       me.add_uint32(cdata->_ram_images[n]._image.size());
-      me.append_data(cdata->_ram_images[n]._image, cdata->_ram_images[n]._image.size());
+      manager->write_aligned_data(me, cdata->_ram_images[n]._image, cdata->_ram_images[n]._image.size());
     }
   }
 }
@@ -10342,6 +11291,13 @@ do_fillin_rawdata(CData *cdata, DatagramIterator &scan, BamReader *manager) {
 
   cdata->_ram_images.clear();
   cdata->_ram_images.reserve(num_ram_images);
+  cdata->_stream_sources.clear();
+
+  // With texture-streaming, the larger mipmap levels are left in the file for
+  // now, if they can be mapped from it; they will be streamed in when they
+  // are needed.  The smallest level is always read.
+  bool stream = texture_streaming && num_ram_images > 1;
+
   for (int n = 0; n < num_ram_images; ++n) {
     cdata->_ram_images.push_back(RamImage());
     cdata->_ram_images[n]._page_size = get_expected_ram_page_size();
@@ -10353,14 +11309,32 @@ do_fillin_rawdata(CData *cdata, DatagramIterator &scan, BamReader *manager) {
     size_t u_size = scan.get_uint32();
 
     // Protect against large allocation.
-    if (u_size > scan.get_remaining_size()) {
+    if (!manager->check_aligned_data(scan, u_size)) {
       gobj_cat.error()
         << "RAM image " << n << " extends past end of datagram, is texture corrupt?\n";
       return;
     }
 
+    if (stream && n + 1 < num_ram_images &&
+        max(do_get_expected_mipmap_x_size(cdata, n),
+            do_get_expected_mipmap_y_size(cdata, n)) > texture_stream_tail_size) {
+      StreamSource source;
+      source._data = manager->map_aligned_data(scan, u_size, source._mapping);
+      if (source._data != nullptr) {
+        source._size = u_size;
+        cdata->_stream_sources.resize(num_ram_images);
+        cdata->_stream_sources[n] = std::move(source);
+        continue;
+      }
+    }
+    stream = false;
+
+    // The image is read straight from the file, if it was written as an
+    // aligned block, rather than being copied out of the datagram.
     PTA_uchar image = PTA_uchar::empty_array(u_size, get_class_type());
-    scan.extract_bytes(image.p(), u_size);
+    if (!manager->read_aligned_data(scan, image.p(), u_size)) {
+      return;
+    }
 
     cdata->_ram_images[n]._image = image;
   }
@@ -10542,6 +11516,7 @@ do_assign(const Texture::CData *copy) {
   _auto_texture_scale = copy->_auto_texture_scale;
   _ram_image_compression = copy->_ram_image_compression;
   _ram_images = copy->_ram_images;
+  _stream_sources = copy->_stream_sources;
   _simple_x_size = copy->_simple_x_size;
   _simple_y_size = copy->_simple_y_size;
   _simple_ram_image = copy->_simple_ram_image;
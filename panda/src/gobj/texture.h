@@ -46,6 +46,9 @@
 #include "pnmImage.h"
 #include "pfmFile.h"
 #include "asyncFuture.h"
+#include "mappedFile.h"
+#include "lightMutex.h"
+#include "pset.h"
 
 class TextureContext;
 class FactoryParams;
@@ -493,6 +496,19 @@ PUBLISHED:
   MAKE_PROPERTY(num_ram_mipmap_images, get_num_ram_mipmap_images);
   MAKE_PROPERTY(num_loadable_ram_mipmap_images, get_num_loadable_ram_mipmap_images);
 
+  int get_stream_base_level() const;
+  bool has_streamed_mipmaps() const;
+  BLOCKING bool stream_mipmap_level();
+  size_t evict_streamed_mipmaps(int base_level);
+  void request_stream_screen_size(PN_stdfloat screen_size);
+  PN_stdfloat get_stream_priority() const;
+  int get_stream_wanted_level() const;
+  static size_t get_streamed_ram_size();
+
+  MAKE_PROPERTY(stream_base_level, get_stream_base_level);
+  MAKE_PROPERTY(stream_priority, get_stream_priority);
+  MAKE_PROPERTY(stream_wanted_level, get_stream_wanted_level);
+
   INLINE int get_simple_x_size() const;
   INLINE int get_simple_y_size() const;
   INLINE bool has_simple_ram_image() const;
@@ -779,6 +795,10 @@ protected:
   virtual bool do_has_bam_rawdata(const CData *cdata) const;
   virtual void do_get_bam_rawdata(CData *cdata);
 
+  int do_get_stream_base_level(const CData *cdata) const;
+  bool do_stream_all_mipmaps(CData *cdata);
+  size_t do_get_streamed_size(const CData *cdata) const;
+
   // This nested class declaration is used below.
   class RamImage {
   public:
@@ -792,6 +812,17 @@ protected:
     void *_pointer_image;
   };
 
+  // A mipmap level that may be streamed in on demand.  It points into a
+  // memory-mapped bam file; see do_fillin_rawdata().
+  class StreamSource {
+  public:
+    INLINE StreamSource();
+
+    PT(MappedFile) _mapping;
+    const unsigned char *_data;
+    size_t _size;
+  };
+
 private:
   static void convert_from_pnmimage(PTA_uchar &image, size_t page_size,
                                     int row_stride, int x, int y, int z,
@@ -917,11 +948,33 @@ private:
   static void filter_3d_float(unsigned char *&p, const unsigned char *&q,
                               size_t pixel_size, size_t row_size, size_t page_size);
 
+  typedef void CompressBlockFunc(unsigned char *dest, const unsigned char *rgba,
+                                 int mask, int flags);
+  typedef void DecompressBlockFunc(unsigned char *rgba, const unsigned char *source,
+                                   int flags);
+
+  bool do_compress_blocks(CData *cdata, CompressionMode compression,
+                          size_t block_size, CompressBlockFunc *func, int flags);
+  bool do_uncompress_blocks(CData *cdata, size_t block_size,
+                            DecompressBlockFunc *func, int flags);
   bool do_squish(CData *cdata, CompressionMode compression, int squish_flags);
   bool do_unsquish(CData *cdata, int squish_flags);
 
+  static void compress_block_dxt_fast(unsigned char *dest, const unsigned char *rgba,
+                                      int mask, int compression);
+  static void decompress_block_dxt(unsigned char *rgba, const unsigned char *source,
+                                   int compression);
+
+  void register_streamed();
+  static void collect_streamed_textures(pvector<Texture *> &textures);
+  static void release_streamed_textures(pvector<Texture *> &textures);
+  static bool make_stream_room(Texture *requester, size_t size,
+                               PN_stdfloat priority);
+  void stream_request_done();
+
 protected:
   typedef pvector<RamImage> RamImages;
+  typedef pvector<StreamSource> StreamSources;
 
   // This is the data that must be cycled between pipeline stages.
   class EXPCL_PANDA_GOBJ CData : public CycleData {
@@ -996,6 +1049,11 @@ protected:
     // mipmap levels.
     RamImages _ram_images;
 
+    // If the texture was read with texture-streaming enabled, this has one
+    // entry for each of the above mipmap levels.  The levels that can be
+    // streamed in have a non-NULL _mapping.
+    StreamSources _stream_sources;
+
     // This is the simple image, which may be loaded before the texture is
     // loaded from disk.  It exists only for 2-d textures.
     RamImage _simple_ram_image;
@@ -1057,12 +1115,27 @@ protected:
   // The TexturePool finds this useful.
   Filename _texture_pool_key;
 
+  // These are used to decide which mipmap levels should be streamed in; see
+  // request_stream_screen_size().  They are also protected by _lock.
+  PN_stdfloat _stream_screen_size;
+  int _stream_frame;
+  int _stream_wanted_level;
+  bool _stream_pending;
+  bool _stream_registered;
+
 private:
   // The auxiliary data is not recorded to a bam file.
   typedef pmap<std::string, PT(TypedReferenceCount) > AuxData;
   AuxData _aux_data;
 
   static AutoTextureScale _textures_power_2;
+
+  // The textures that have streamed in some of their mipmap levels, so that
+  // texture-stream-memory-limit can be enforced.
+  typedef pset<Texture *> StreamedTextures;
+  static StreamedTextures *_streamed_textures;
+  static LightMutex _streamed_textures_lock;
+
   static PStatCollector _texture_read_pcollector;
 
   // Datagram stuff
@@ -1105,6 +1178,7 @@ private:
   friend class PreparedGraphicsObjects;
   friend class TexturePool;
   friend class TexturePeeker;
+  friend class TextureStreamRequest;
 };
 
 extern EXPCL_PANDA_GOBJ ConfigVariableEnum<Texture::QualityLevel> texture_quality_level;
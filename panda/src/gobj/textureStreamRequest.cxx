@@ -0,0 +1,61 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file textureStreamRequest.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "textureStreamRequest.h"
+#include "config_gobj.h"
+
+TypeHandle TextureStreamRequest::_type_handle;
+
+const char *const TextureStreamRequest::_task_chain_name = "texture_stream";
+
+/**
+ * Returns the task manager that TextureStreamRequests should be added to,
+ * after setting up the task chain they run on, if necessary.
+ */
+AsyncTaskManager *TextureStreamRequest::
+get_task_manager() {
+  AsyncTaskManager *task_mgr = AsyncTaskManager::get_global_ptr();
+  if (task_mgr->find_task_chain(_task_chain_name) == nullptr) {
+    AsyncTaskChain *chain = task_mgr->make_task_chain(_task_chain_name);
+    chain->set_num_threads(texture_stream_num_threads);
+    chain->set_thread_priority(TP_low);
+  }
+  return task_mgr;
+}
+
+/**
+ * Performs the task: that is, streams in the next mipmap level, if the
+ * texture still needs it.
+ */
+AsyncTask::DoneStatus TextureStreamRequest::
+do_task() {
+  int wanted_level = _texture->get_stream_wanted_level();
+  if (wanted_level >= 0 && wanted_level < _texture->get_stream_base_level()) {
+    if (_texture->stream_mipmap_level()) {
+      // Come back for the next level after the other textures have had a
+      // turn, since the priorities may have changed in the meantime.
+      set_priority((int)_texture->get_stream_priority());
+      return DS_cont;
+    }
+
+    if (wanted_level < _texture->get_stream_base_level()) {
+      // There was no room for it.  Try again in a little while, when some
+      // of the other textures may no longer be visible.
+      set_delay(0.1);
+      return DS_again;
+    }
+  }
+
+  _texture->stream_request_done();
+  return DS_done;
+}
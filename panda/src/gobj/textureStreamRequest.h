@@ -0,0 +1,70 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file textureStreamRequest.h
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#ifndef TEXTURESTREAMREQUEST_H
+#define TEXTURESTREAMREQUEST_H
+
+#include "pandabase.h"
+
+#include "asyncTask.h"
+#include "asyncTaskManager.h"
+#include "texture.h"
+#include "pointerTo.h"
+
+/**
+ * This task streams in the larger mipmap levels of a texture that was read
+ * with texture-streaming enabled, one level at a time, until the texture has
+ * the level asked for by Texture::request_stream_screen_size().  It runs on
+ * its own task chain, so that it does not hold up model loads.
+ */
+class EXPCL_PANDA_GOBJ TextureStreamRequest : public AsyncTask {
+public:
+  ALLOC_DELETED_CHAIN(TextureStreamRequest);
+
+PUBLISHED:
+  INLINE explicit TextureStreamRequest(Texture *texture);
+
+  INLINE Texture *get_texture() const;
+  MAKE_PROPERTY(texture, get_texture);
+
+  static AsyncTaskManager *get_task_manager();
+
+protected:
+  virtual DoneStatus do_task();
+
+private:
+  PT(Texture) _texture;
+
+  static const char *const _task_chain_name;
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    AsyncTask::init_type();
+    register_type(_type_handle, "TextureStreamRequest",
+                  AsyncTask::get_class_type());
+    }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+#include "textureStreamRequest.I"
+
+#endif
@@ -0,0 +1,357 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file vertexCacheOptimizer.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "vertexCacheOptimizer.h"
+
+#include <algorithm>
+
+// These are the parameters suggested by Forsyth.
+static const float vertex_cache_decay_power = 1.5f;
+static const float vertex_cache_last_triangle_score = 0.75f;
+static const float vertex_cache_valence_boost_scale = 2.0f;
+static const float vertex_cache_valence_boost_power = 0.5f;
+static const int vertex_cache_max_valence = 32;
+
+namespace {
+  /**
+   * Simulates a FIFO vertex cache, which is how most hardware implements it.
+   * Instead of storing the cache contents, we store for each vertex the
+   * "time" it was last loaded into the cache; the time is only incremented on
+   * a cache miss.
+   */
+  class FifoCache {
+  public:
+    FifoCache(int cache_size, int num_vertices) :
+      _timestamps(num_vertices, 0),
+      _time((size_t)cache_size + 1),
+      _cache_size((size_t)cache_size) {}
+
+    // Returns true if this was a cache miss.
+    bool access(int vertex) {
+      if (_time - _timestamps[vertex] > _cache_size) {
+        _timestamps[vertex] = _time++;
+        return true;
+      }
+      return false;
+    }
+
+    void flush() {
+      _time += _cache_size + 1;
+    }
+
+  private:
+    pvector<size_t> _timestamps;
+    size_t _time;
+    size_t _cache_size;
+  };
+
+  /**
+   * A cluster of triangles, for the purpose of sorting them to reduce
+   * overdraw.
+   */
+  struct TriangleCluster {
+    size_t _begin;
+    size_t _end;
+    PN_stdfloat _sort;
+
+    bool operator < (const TriangleCluster &other) const {
+      return _sort > other._sort;
+    }
+  };
+}
+
+/**
+ * Creates an optimizer for a vertex cache of the indicated number of
+ * vertices.
+ */
+VertexCacheOptimizer::
+VertexCacheOptimizer(int cache_size) :
+  _cache_size(std::max(cache_size, 4))
+{
+  _cache_scores.resize(_cache_size);
+  for (int i = 0; i < _cache_size; ++i) {
+    if (i < 3) {
+      // The vertices of the last triangle get a fixed score, so that we
+      // don't favor emitting the same triangle (or a very thin strip) again.
+      _cache_scores[i] = vertex_cache_last_triangle_score;
+    } else {
+      float scaler = 1.0f - (float)(i - 3) / (float)(_cache_size - 3);
+      _cache_scores[i] = powf(scaler, vertex_cache_decay_power);
+    }
+  }
+
+  _valence_scores.resize(vertex_cache_max_valence + 1);
+  _valence_scores[0] = 0.0f;
+  for (int i = 1; i <= vertex_cache_max_valence; ++i) {
+    _valence_scores[i] = vertex_cache_valence_boost_scale *
+      powf((float)i, -vertex_cache_valence_boost_power);
+  }
+}
+
+/**
+ * Reorders the indicated list of triangles, consisting of three vertex
+ * indices each, for better vertex cache utilization.  All indices must be
+ * less than num_vertices.  The order of the vertices within each triangle is
+ * not changed.
+ */
+void VertexCacheOptimizer::
+optimize(int *indices, size_t num_triangles, int num_vertices) const {
+  if (num_triangles < 2) {
+    return;
+  }
+  size_t num_indices = num_triangles * 3;
+
+  // Build, for each vertex, the list of triangles that use it.  The lists
+  // are stored back-to-back; the first num_remaining entries of a vertex'
+  // list are the triangles that have not yet been emitted.
+  pvector<int> num_remaining(num_vertices, 0);
+  for (size_t i = 0; i < num_indices; ++i) {
+    nassertv(indices[i] >= 0 && indices[i] < num_vertices);
+    ++num_remaining[indices[i]];
+  }
+
+  pvector<size_t> offsets(num_vertices + 1);
+  offsets[0] = 0;
+  for (int v = 0; v < num_vertices; ++v) {
+    offsets[v + 1] = offsets[v] + num_remaining[v];
+  }
+
+  pvector<size_t> vertex_triangles(num_indices);
+  {
+    pvector<size_t> fill(offsets);
+    for (size_t i = 0; i < num_indices; ++i) {
+      vertex_triangles[fill[indices[i]]++] = i / 3;
+    }
+  }
+
+  pvector<int> cache_pos(num_vertices, -1);
+  pvector<float> vertex_scores(num_vertices);
+  for (int v = 0; v < num_vertices; ++v) {
+    vertex_scores[v] = calc_vertex_score(-1, num_remaining[v]);
+  }
+
+  pvector<float> triangle_scores(num_triangles);
+  for (size_t t = 0; t < num_triangles; ++t) {
+    const int *tri = indices + t * 3;
+    triangle_scores[t] = vertex_scores[tri[0]] + vertex_scores[tri[1]] + vertex_scores[tri[2]];
+  }
+
+  pvector<unsigned char> emitted(num_triangles, 0);
+  pvector<int> output;
+  output.reserve(num_indices);
+
+  pvector<int> cache, new_cache;
+  cache.reserve(_cache_size + 3);
+  new_cache.reserve(_cache_size + 3);
+
+  static const size_t no_triangle = (size_t)-1;
+  size_t best_triangle = no_triangle;
+  size_t next_unemitted = 0;
+
+  for (size_t n = 0; n < num_triangles; ++n) {
+    if (best_triangle == no_triangle) {
+      // None of the triangles using the cached vertices are left.  Continue
+      // with the next triangle in the original order.
+      while (emitted[next_unemitted]) {
+        ++next_unemitted;
+      }
+      best_triangle = next_unemitted;
+    }
+
+    const int *tri = indices + best_triangle * 3;
+    emitted[best_triangle] = 1;
+    output.insert(output.end(), tri, tri + 3);
+
+    // Remove the triangle from the lists of its vertices, and put the
+    // vertices at the front of the cache.
+    new_cache.clear();
+    for (int k = 0; k < 3; ++k) {
+      int v = tri[k];
+      size_t *begin = &vertex_triangles[offsets[v]];
+      size_t *end = begin + num_remaining[v];
+      size_t *it = std::find(begin, end, best_triangle);
+      nassertv(it != end);
+      std::swap(*it, *(end - 1));
+      --num_remaining[v];
+
+      if (std::find(new_cache.begin(), new_cache.end(), v) == new_cache.end()) {
+        new_cache.push_back(v);
+      }
+    }
+    for (int v : cache) {
+      if (v != tri[0] && v != tri[1] && v != tri[2]) {
+        new_cache.push_back(v);
+      }
+    }
+
+    // Update the scores of all of the vertices that were in the cache,
+    // including the ones that just fell out of it.
+    for (size_t i = 0; i < new_cache.size(); ++i) {
+      int v = new_cache[i];
+      cache_pos[v] = (i < (size_t)_cache_size) ? (int)i : -1;
+
+      float score = calc_vertex_score(cache_pos[v], num_remaining[v]);
+      float delta = score - vertex_scores[v];
+      vertex_scores[v] = score;
+
+      const size_t *vt = &vertex_triangles[offsets[v]];
+      for (int j = 0; j < num_remaining[v]; ++j) {
+        triangle_scores[vt[j]] += delta;
+      }
+    }
+
+    // The next triangle is the best one using any of the cached vertices.
+    best_triangle = no_triangle;
+    float best_score = -1.0f;
+    if (new_cache.size() > (size_t)_cache_size) {
+      new_cache.resize(_cache_size);
+    }
+    for (int v : new_cache) {
+      const size_t *vt = &vertex_triangles[offsets[v]];
+      for (int j = 0; j < num_remaining[v]; ++j) {
+        if (triangle_scores[vt[j]] > best_score) {
+          best_score = triangle_scores[vt[j]];
+          best_triangle = vt[j];
+        }
+      }
+    }
+    cache.swap(new_cache);
+  }
+
+  std::copy(output.begin(), output.end(), indices);
+}
+
+/**
+ * Reorders clusters of the indicated triangles, which should already have
+ * been ordered by optimize(), so that the clusters facing outward from the
+ * center of the mesh are drawn first.  The clusters are chosen such that the
+ * number of vertex cache misses doesn't increase by more than the given
+ * factor, which should be a number slightly larger than 1.
+ *
+ * positions contains the position of each of the num_vertices vertices.
+ */
+void VertexCacheOptimizer::
+optimize_overdraw(int *indices, size_t num_triangles,
+                  const LPoint3 *positions, int num_vertices,
+                  PN_stdfloat threshold) const {
+  if (num_triangles < 2) {
+    return;
+  }
+  size_t num_indices = num_triangles * 3;
+
+  // The cache is flushed wherever a triangle misses on all of its vertices;
+  // we can freely move the triangles between these points.
+  pvector<size_t> hard_begins;
+  FifoCache fifo(_cache_size, num_vertices);
+  for (size_t t = 0; t < num_triangles; ++t) {
+    const int *tri = indices + t * 3;
+    int misses = fifo.access(tri[0]) + fifo.access(tri[1]) + fifo.access(tri[2]);
+    if (misses == 3) {
+      hard_begins.push_back(t);
+    }
+  }
+  hard_begins.push_back(num_triangles);
+
+  // Split these further, wherever starting over with an empty cache doesn't
+  // increase the number of cache misses too much.
+  pvector<TriangleCluster> clusters;
+  for (size_t hi = 0; hi + 1 < hard_begins.size(); ++hi) {
+    size_t begin = hard_begins[hi];
+    size_t end = hard_begins[hi + 1];
+
+    fifo.flush();
+    size_t cluster_misses = 0;
+    for (size_t i = begin * 3; i < end * 3; ++i) {
+      cluster_misses += fifo.access(indices[i]);
+    }
+    PN_stdfloat max_acmr = threshold * (PN_stdfloat)cluster_misses / (PN_stdfloat)(end - begin);
+
+    fifo.flush();
+    size_t start = begin;
+    size_t misses = 0;
+    for (size_t t = begin; t < end; ++t) {
+      const int *tri = indices + t * 3;
+      misses += fifo.access(tri[0]) + fifo.access(tri[1]) + fifo.access(tri[2]);
+
+      if (t + 1 < end && (PN_stdfloat)misses <= max_acmr * (PN_stdfloat)(t + 1 - start)) {
+        TriangleCluster cluster;
+        cluster._begin = start;
+        cluster._end = t + 1;
+        clusters.push_back(cluster);
+
+        fifo.flush();
+        start = t + 1;
+        misses = 0;
+      }
+    }
+    TriangleCluster cluster;
+    cluster._begin = start;
+    cluster._end = end;
+    clusters.push_back(cluster);
+  }
+
+  if (clusters.size() < 2) {
+    return;
+  }
+
+  // Determine how much each cluster faces away from the center of the mesh.
+  LPoint3 mesh_center(0);
+  for (size_t i = 0; i < num_indices; ++i) {
+    nassertv(indices[i] >= 0 && indices[i] < num_vertices);
+    mesh_center += positions[indices[i]];
+  }
+  mesh_center /= (PN_stdfloat)num_indices;
+
+  for (TriangleCluster &cluster : clusters) {
+    LPoint3 center(0);
+    LVector3 normal(0);
+    for (size_t t = cluster._begin; t < cluster._end; ++t) {
+      const LPoint3 &p0 = positions[indices[t * 3]];
+      const LPoint3 &p1 = positions[indices[t * 3 + 1]];
+      const LPoint3 &p2 = positions[indices[t * 3 + 2]];
+      center += p0 + p1 + p2;
+
+      // The length of the cross product weighs the normal by the area.
+      normal += (p1 - p0).cross(p2 - p0);
+    }
+    center /= (PN_stdfloat)((cluster._end - cluster._begin) * 3);
+    normal.normalize();
+    cluster._sort = (center - mesh_center).dot(normal);
+  }
+
+  std::stable_sort(clusters.begin(), clusters.end());
+
+  pvector<int> output;
+  output.reserve(num_indices);
+  for (const TriangleCluster &cluster : clusters) {
+    output.insert(output.end(), indices + cluster._begin * 3, indices + cluster._end * 3);
+  }
+  std::copy(output.begin(), output.end(), indices);
+}
+
+/**
+ * Returns the number of times the indicated vertex indices would miss a FIFO
+ * vertex cache of this optimizer's size.  Dividing this by the number of
+ * triangles gives the average cache miss ratio (ACMR).
+ */
+size_t VertexCacheOptimizer::
+count_cache_misses(const int *indices, size_t num_indices,
+                   int num_vertices) const {
+  FifoCache fifo(_cache_size, num_vertices);
+  size_t misses = 0;
+  for (size_t i = 0; i < num_indices; ++i) {
+    nassertr(indices[i] >= 0 && indices[i] < num_vertices, misses);
+    misses += fifo.access(indices[i]);
+  }
+  return misses;
+}
@@ -0,0 +1,62 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file vertexCacheOptimizer.h
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#ifndef VERTEXCACHEOPTIMIZER_H
+#define VERTEXCACHEOPTIMIZER_H
+
+#include "pandabase.h"
+#include "luse.h"
+#include "pvector.h"
+
+/**
+ * Reorders a list of indexed triangles to make better use of the post-
+ * transform vertex cache of the graphics hardware, so that fewer vertices
+ * need to be run through the vertex shader more than once.  This uses the
+ * greedy algorithm described in Tom Forsyth's "Linear-Speed Vertex Cache
+ * Optimisation".
+ *
+ * Afterwards, the triangles may also be grouped into clusters that are
+ * ordered such that the outward-facing clusters are drawn first, which
+ * reduces overdraw regardless of the viewing angle, as described by Sander,
+ * Nehab and Barczak in "Fast Triangle Reordering for Vertex Locality and
+ * Reduced Overdraw".
+ *
+ * This is used by GeomPrimitive::optimize_vertex_cache(); it is not normally
+ * necessary to use this class directly.
+ */
+class EXPCL_PANDA_GOBJ VertexCacheOptimizer {
+public:
+  explicit VertexCacheOptimizer(int cache_size);
+
+  INLINE int get_cache_size() const;
+
+  void optimize(int *indices, size_t num_triangles, int num_vertices) const;
+  void optimize_overdraw(int *indices, size_t num_triangles,
+                         const LPoint3 *positions, int num_vertices,
+                         PN_stdfloat threshold) const;
+
+  size_t count_cache_misses(const int *indices, size_t num_indices,
+                            int num_vertices) const;
+
+private:
+  INLINE float calc_vertex_score(int cache_pos, int num_remaining) const;
+
+private:
+  int _cache_size;
+  pvector<float> _cache_scores;
+  pvector<float> _valence_scores;
+};
+
+#include "vertexCacheOptimizer.I"
+
+#endif
@@ -39,6 +39,8 @@ operator = (const VertexDataBuffer &copy) {
   _size = copy._size;
   _reserved_size = copy._size;
   _block = copy._block;
+  _mapped_data = copy._mapped_data;
+  _mapping = copy._mapping;
   nassertv(_reserved_size >= _size);
 }
 
@@ -55,6 +57,8 @@ swap(VertexDataBuffer &other) {
   size_t reserved_size = _reserved_size;
 
   _block.swap(other._block);
+  _mapping.swap(other._mapping);
+  std::swap(_mapped_data, other._mapped_data);
 
   _resident_data = other._resident_data;
   _size = other._size;
@@ -66,6 +70,27 @@ swap(VertexDataBuffer &other) {
   nassertv(_reserved_size >= _size);
 }
 
+/**
+ * Replaces the contents of the buffer with size bytes of read-only memory at
+ * the indicated address, which must be within the indicated mapping.  The
+ * buffer keeps a reference to the mapping, and reads the data directly from
+ * it, until the buffer is modified, at which point the data is copied into
+ * independent memory.
+ */
+void VertexDataBuffer::
+set_mapped_data(const unsigned char *data, size_t size, MappedFile *mapping) {
+  LightMutexHolder holder(_lock);
+  nassertv(mapping != nullptr && size != 0);
+  nassertv(data >= mapping->get_data() &&
+           data + size <= mapping->get_data() + mapping->get_size());
+
+  do_unclean_realloc(0);
+  _mapped_data = data;
+  _mapping = mapping;
+  _size = size;
+  _reserved_size = size;
+}
+
 /**
  * Changes the reserved size of the buffer, preserving its data (except for
  * any data beyond the new end of the buffer, if the buffer is being reduced).
@@ -119,8 +144,10 @@ do_unclean_realloc(size_t reserved_size) {
         << this << ".unclean_realloc(" << reserved_size << ")\n";
     }
 
-    // If we're paged out, discard the page.
+    // If we're paged out or mapped, discard the page or mapping.
     _block = nullptr;
+    _mapped_data = nullptr;
+    _mapping = nullptr;
 
     if (_resident_data != nullptr) {
       nassertv(_reserved_size != 0);
@@ -151,8 +178,9 @@ do_unclean_realloc(size_t reserved_size) {
  */
 void VertexDataBuffer::
 do_page_out(VertexDataBook &book) {
-  if (_block != nullptr || _reserved_size == 0) {
-    // We're already paged out.
+  if (_block != nullptr || _mapped_data != nullptr || _reserved_size == 0) {
+    // We're already paged out, or we're mapped from a file, which is just as
+    // good.
     return;
   }
   nassertv(_resident_data != nullptr);
@@ -194,11 +222,19 @@ do_page_in() {
     return;
   }
 
-  nassertv(_block != nullptr);
+  nassertv(_block != nullptr || _mapped_data != nullptr);
   nassertv(_reserved_size == _size);
 
   _resident_data = (unsigned char *)get_class_type().allocate_array(_size);
   nassertv(_resident_data != nullptr);
 
+  if (_mapped_data != nullptr) {
+    // This is the copy-on-write of a mapped buffer.
+    memcpy(_resident_data, _mapped_data, _size);
+    _mapped_data = nullptr;
+    _mapping = nullptr;
+    return;
+  }
+
   memcpy(_resident_data, _block->get_pointer(true), _size);
 }
@@ -57,6 +57,7 @@
 #include "modelFlattenRequest.h"
 #include "modelLoadRequest.h"
 #include "modelSaveRequest.h"
+#include "modelStreamRequest.h"
 #include "modelNode.h"
 #include "modelRoot.h"
 #include "nodePath.h"
@@ -132,6 +133,23 @@ ConfigVariableBool debug_portal_cull
           "(You first need to enable portal culling, using the allow-portal-cull"
           "variable.)"));
 
+ConfigVariableInt cull_num_threads
+("cull-num-threads", 0,
+ PRC_DESC("Set this to a number greater than zero to split the cull traversal "
+          "of each DisplayRegion across that many additional worker threads.  "
+          "The work is divided at nodes with many children; the Geoms found "
+          "by each worker are collected separately and handed to the bins "
+          "in scene graph order, so the result is the same as a serial "
+          "traversal.  Any cull callbacks in the scene graph must be safe to "
+          "call from multiple threads when this is enabled.  This may also "
+          "be set per window via GraphicsThreadingModel."));
+
+ConfigVariableInt cull_parallel_min_children
+("cull-parallel-min-children", 32,
+ PRC_DESC("When cull-num-threads is nonzero, this is the minimum number of "
+          "children a node must have before the cull traversal of its "
+          "children is divided among the worker threads."));
+
 ConfigVariableBool show_occluder_volumes
 ("show-occluder-volumes", false,
  PRC_DESC("Set this true to enable debug visualization of the volumes used "
@@ -306,6 +324,24 @@ ConfigVariableBool flatten_geoms
           "only the NodePath interfaces; you may still make the lower-level "
           "SceneGraphReducer calls directly."));
 
+ConfigVariableInt flatten_num_threads
+("flatten-num-threads", 0,
+ PRC_DESC("Set this to a number greater than zero to let the "
+          "SceneGraphReducer use that many additional worker threads.  "
+          "flatten() processes the subgraphs below a node concurrently, "
+          "apply_attribs() transforms vertex data concurrently, and "
+          "collect_vertex_data() builds the combined vertex datas "
+          "concurrently.  Subgraphs containing instanced nodes are always "
+          "handled on the calling thread.  The result is the same as with "
+          "no worker threads.  This is the default for new "
+          "SceneGraphReducers; see SceneGraphReducer::set_num_threads()."));
+
+ConfigVariableInt flatten_parallel_min_children
+("flatten-parallel-min-children", 8,
+ PRC_DESC("When flatten-num-threads is nonzero, this is the minimum number "
+          "of children a node must have before the flattening of the "
+          "subgraphs below it is divided among the worker threads."));
+
 ConfigVariableInt max_lenses
 ("max-lenses", 100,
  PRC_DESC("Specifies an upper limit on the maximum number of lenses "
@@ -432,6 +468,7 @@ init_libpgraph() {
   ModelFlattenRequest::init_type();
   ModelLoadRequest::init_type();
   ModelSaveRequest::init_type();
+  ModelStreamRequest::init_type();
   ModelNode::init_type();
   ModelRoot::init_type();
   NodePath::init_type();
@@ -34,6 +34,8 @@ extern ConfigVariableBool fake_view_frustum_cull;
 extern ConfigVariableBool clip_plane_cull;
 extern ConfigVariableBool allow_portal_cull;
 extern ConfigVariableBool debug_portal_cull;
+extern EXPCL_PANDA_PGRAPH ConfigVariableInt cull_num_threads;
+extern ConfigVariableInt cull_parallel_min_children;
 extern ConfigVariableBool show_occluder_volumes;
 extern ConfigVariableBool unambiguous_graph;
 extern ConfigVariableBool detect_graph_cycles;
@@ -57,6 +59,8 @@ extern ConfigVariableInt max_collect_indices;
 extern EXPCL_PANDA_PGRAPH ConfigVariableBool premunge_data;
 extern ConfigVariableBool preserve_geom_nodes;
 extern ConfigVariableBool flatten_geoms;
+extern EXPCL_PANDA_PGRAPH ConfigVariableInt flatten_num_threads;
+extern ConfigVariableInt flatten_parallel_min_children;
 extern EXPCL_PANDA_PGRAPH ConfigVariableInt max_lenses;
 
 extern ConfigVariableBool polylight_info;
@@ -27,6 +27,8 @@
 #include "boundingSphere.h"
 #include "boundingBox.h"
 #include "boundingHexahedron.h"
+#include "textureAttrib.h"
+#include "texture.h"
 #include "portalClipper.h"
 #include "geom.h"
 #include "geomTristrips.h"
@@ -34,21 +36,45 @@
 #include "geomLinestrips.h"
 #include "geomLines.h"
 #include "geomVertexWriter.h"
+#include "pStatTimer.h"
 
 PStatCollector CullTraverser::_nodes_pcollector("Nodes");
 PStatCollector CullTraverser::_geom_nodes_pcollector("Nodes:GeomNodes");
 PStatCollector CullTraverser::_geoms_pcollector("Geoms");
 PStatCollector CullTraverser::_geoms_occluded_pcollector("Geoms:Occluded");
+PStatCollector CullTraverser::_parallel_pcollector("Cull:Parallel");
 
 TypeHandle CullTraverser::_type_handle;
 
+/**
+ * This is the CullHandler used by each worker thread during a parallel cull
+ * traversal.  It simply saves up the objects it is given, so that they can be
+ * passed on to the real CullHandler on the original thread afterwards, in
+ * the same order in which a serial traversal would have encountered them.
+ */
+class DeferredCullHandler final : public CullHandler {
+public:
+  DeferredCullHandler(pvector<CullableObject *> &objects) :
+    _objects(objects) {}
+
+  virtual void record_object(CullableObject *object,
+                             const CullTraverser *traverser) {
+    _objects.push_back(object);
+  }
+
+private:
+  pvector<CullableObject *> &_objects;
+};
+
 /**
  *
  */
 CullTraverser::
 CullTraverser() :
   _gsg(nullptr),
-  _current_thread(Thread::get_current_thread())
+  _current_thread(Thread::get_current_thread()),
+  _job_runner("cull-worker", cull_num_threads),
+  _level_counts(nullptr)
 {
   _camera_mask = DrawMask::all_on();
   _has_tag_state_key = false;
@@ -73,7 +99,9 @@ CullTraverser(const CullTraverser &copy) :
   _view_frustum(copy._view_frustum),
   _cull_handler(copy._cull_handler),
   _portal_clipper(copy._portal_clipper),
-  _effective_incomplete_render(copy._effective_incomplete_render)
+  _effective_incomplete_render(copy._effective_incomplete_render),
+  _job_runner(copy._job_runner),
+  _level_counts(nullptr)
 {
 }
 
@@ -172,7 +200,7 @@ traverse(CullTraverserData &data) {
  */
 void CullTraverser::
 traverse_below(CullTraverserData &data) {
-  _nodes_pcollector.add_level(1);
+  count_level(_nodes_pcollector, 1);
   PandaNodePipelineReader *node_reader = data.node_reader();
   PandaNode *node = data.node();
 
@@ -200,6 +228,11 @@ traverse_below(CullTraverserData &data) {
   node_reader->release();
   int num_children = children.get_num_children();
   if (!node->has_selective_visibility()) {
+    if (num_children >= cull_parallel_min_children &&
+        can_traverse_parallel()) {
+      traverse_children_parallel(data, children);
+      return;
+    }
     for (int i = 0; i < num_children; ++i) {
       CullTraverserData next_data(data, children.get_child(i));
       do_traverse(next_data);
@@ -232,7 +265,7 @@ draw_bounding_volume(const BoundingVolume *vol,
   PT(Geom) bounds_viz = make_bounds_viz(vol);
 
   if (bounds_viz != nullptr) {
-    _geoms_pcollector.add_level(2);
+    count_level(_geoms_pcollector, 2);
     CullableObject *outer_viz =
       new CullableObject(bounds_viz, get_bounds_outer_viz_state(),
                          internal_transform);
@@ -245,6 +278,78 @@ draw_bounding_volume(const BoundingVolume *vol,
   }
 }
 
+/**
+ * Returns a rough estimate of the height in pixels that the node's bounding
+ * volume occupies on the screen.  This is used to decide how much of a
+ * streamed texture is needed.  Returns the full viewport height if the camera
+ * is inside the bounding volume, or 0 if the node has no bounds.
+ */
+PN_stdfloat CullTraverser::
+estimate_screen_size(CullTraverserData &data) const {
+  const Lens *lens = _scene_setup->get_lens();
+  PN_stdfloat viewport_height = (PN_stdfloat)_scene_setup->get_viewport_height();
+  const BoundingVolume *bounds = data.node_reader()->get_bounds();
+  if (lens == nullptr || bounds == nullptr || bounds->is_empty()) {
+    return 0;
+  }
+
+  const FiniteBoundingVolume *fbv = bounds->as_finite_bounding_volume();
+  if (fbv == nullptr) {
+    return viewport_height;
+  }
+
+  LPoint3 center;
+  PN_stdfloat radius;
+  const BoundingSphere *sphere = bounds->as_bounding_sphere();
+  if (sphere != nullptr) {
+    center = sphere->get_center();
+    radius = sphere->get_radius();
+  } else {
+    LPoint3 min_point = fbv->get_min();
+    LPoint3 max_point = fbv->get_max();
+    center = (min_point + max_point) * 0.5f;
+    radius = (max_point - min_point).length() * 0.5f;
+  }
+
+  CPT(TransformState) modelview = data.get_modelview_transform(this);
+  const LMatrix4 &mat = modelview->get_mat();
+  center = center * mat;
+  radius *= std::max(mat.get_row3(0).length(),
+                     std::max(mat.get_row3(1).length(), mat.get_row3(2).length()));
+
+  if (lens->is_orthographic()) {
+    return radius * 2.0f / lens->get_film_size()[1] * viewport_height;
+  }
+
+  PN_stdfloat distance = center.length();
+  if (distance <= radius) {
+    return viewport_height;
+  }
+  PN_stdfloat half_fov = deg_2_rad(lens->get_fov()[1] * 0.5f);
+  return radius / (distance * ctan(half_fov)) * viewport_height;
+}
+
+/**
+ * Tells each streamed texture applied by the indicated state that it is
+ * about to be drawn at (roughly) the indicated size in pixels, so that the
+ * mipmap levels it needs will be streamed in.
+ */
+void CullTraverser::
+request_texture_streaming(const RenderState *state, PN_stdfloat screen_size) {
+  const TextureAttrib *ta;
+  if (!state->get_attrib(ta)) {
+    return;
+  }
+
+  int num_stages = ta->get_num_on_stages();
+  for (int i = 0; i < num_stages; ++i) {
+    Texture *tex = ta->get_on_texture(ta->get_on_stage(i));
+    if (tex != nullptr && tex->has_streamed_mipmaps()) {
+      tex->request_stream_screen_size(screen_size);
+    }
+  }
+}
+
 /**
  * Returns true if the current node is fully or partially within the viewing
  * area and should be drawn, or false if it (and all of its children) should
@@ -255,6 +360,71 @@ is_in_view(CullTraverserData &data) {
   return data.is_in_view(_camera_mask);
 }
 
+/**
+ * Returns true if it is appropriate for this traverser to divide the
+ * traversal of a node's children among worker threads.
+ */
+bool CullTraverser::
+can_traverse_parallel() const {
+  // Derived traversers may keep state that is not safe to share between
+  // threads, and the portal clipper maintains a stack of portals, so we only
+  // go parallel in the simple case.
+  return _job_runner.is_parallel() &&
+    _portal_clipper == nullptr &&
+    get_type() == CullTraverser::get_class_type();
+}
+
+/**
+ * Traverses the children of the indicated node by dividing them into
+ * contiguous ranges and traversing each range with a copy of this traverser
+ * on a worker thread.  The objects found by the workers are then handed to
+ * our CullHandler in order, so that the result is identical to that of
+ * a serial traversal.
+ */
+void CullTraverser::
+traverse_children_parallel(CullTraverserData &data,
+                           const PandaNode::Children &children) {
+  PStatTimer timer(_parallel_pcollector, _current_thread);
+
+  int num_children = children.get_num_children();
+
+  // Create a few more jobs than there are threads, to even out the load,
+  // since some subtrees are much larger than others.
+  int num_jobs = std::min(num_children, (_job_runner.get_num_threads() + 1) * 4);
+  typedef pvector<CullableObject *> Objects;
+  pvector<Objects> results(num_jobs);
+  pvector<LevelCounts> level_counts(num_jobs);
+
+  _job_runner.run(num_jobs, [&] (int job, Thread *current_thread) {
+    DeferredCullHandler cull_handler(results[job]);
+
+    CullTraverser trav(*this);
+    trav._current_thread = current_thread;
+    trav._cull_handler = &cull_handler;
+    trav._job_runner.set_num_threads(0);
+    trav._level_counts = &level_counts[job];
+
+    int begin = (int)(((int64_t)num_children * job) / num_jobs);
+    int end = (int)(((int64_t)num_children * (job + 1)) / num_jobs);
+    for (int i = begin; i < end; ++i) {
+      CullTraverserData next_data(data, children.get_child(i), current_thread);
+      trav.do_traverse(next_data);
+    }
+  }, _current_thread);
+
+  for (const LevelCounts &counts : level_counts) {
+    for (const LevelCounts::value_type &count : counts) {
+      count_level(*count.first, count.second);
+    }
+  }
+
+  for (const Objects &objects : results) {
+    for (CullableObject *object : objects) {
+      _cull_handler->record_object(object, this);
+    }
+  }
+}
+
 /**
  * Draws an appropriate visualization of the node's external bounding volume.
  */
@@ -267,7 +437,7 @@ show_bounds(CullTraverserData &data, bool tight) {
     PT(Geom) bounds_viz = make_tight_bounds_viz(node);
 
     if (bounds_viz != nullptr) {
-      _geoms_pcollector.add_level(1);
+      count_level(_geoms_pcollector, 1);
       CullableObject *outer_viz =
         new CullableObject(std::move(bounds_viz), get_bounds_outer_viz_state(),
                            internal_transform);
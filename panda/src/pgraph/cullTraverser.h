@@ -27,6 +27,7 @@
 #include "typedReferenceCount.h"
 #include "pStatCollector.h"
 #include "fogAttrib.h"
+#include "parallelJobRunner.h"
 
 class GraphicsStateGuardian;
 class PandaNode;
@@ -77,6 +78,9 @@ PUBLISHED:
 
   INLINE bool get_effective_incomplete_render() const;
 
+  INLINE void set_num_threads(int num_threads);
+  INLINE int get_num_threads() const;
+
   void traverse(const NodePath &root);
   void traverse(CullTraverserData &data);
   virtual void traverse_below(CullTraverserData &data);
@@ -88,6 +92,13 @@ PUBLISHED:
   void draw_bounding_volume(const BoundingVolume *vol,
                             const TransformState *internal_transform) const;
 
+public:
+  INLINE void count_level(PStatCollector &collector, int increment) const;
+
+  PN_stdfloat estimate_screen_size(CullTraverserData &data) const;
+  static void request_texture_streaming(const RenderState *state,
+                                        PN_stdfloat screen_size);
+
 protected:
   INLINE void do_traverse(CullTraverserData &data);
 
@@ -99,8 +110,13 @@ public:
   static PStatCollector _geom_nodes_pcollector;
   static PStatCollector _geoms_pcollector;
   static PStatCollector _geoms_occluded_pcollector;
+  static PStatCollector _parallel_pcollector;
 
 private:
+  bool can_traverse_parallel() const;
+  void traverse_children_parallel(CullTraverserData &data,
+                                  const PandaNode::Children &children);
+
   void show_bounds(CullTraverserData &data, bool tight);
   static PT(Geom) make_bounds_viz(const BoundingVolume *vol);
   PT(Geom) make_tight_bounds_viz(PandaNode *node) const;
@@ -121,6 +137,12 @@ private:
   CullHandler *_cull_handler;
   PortalClipper *_portal_clipper;
   bool _effective_incomplete_render;
+  ParallelJobRunner _job_runner;
+
+  // The PStat levels counted by a traverser on a worker thread, which are
+  // added to the collectors by the calling thread afterwards.
+  typedef pvector<std::pair<PStatCollector *, int> > LevelCounts;
+  LevelCounts *_level_counts;
 
 public:
   static TypeHandle get_class_type() {
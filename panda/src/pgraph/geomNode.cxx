@@ -34,6 +34,7 @@
 #include "indent.h"
 #include "pset.h"
 #include "config_pgraph.h"
+#include "config_gobj.h"
 #include "graphicsStateGuardianBase.h"
 #include "boundingBox.h"
 #include "boundingSphere.h"
@@ -500,7 +501,7 @@ is_renderable() const {
  */
 void GeomNode::
 add_for_draw(CullTraverser *trav, CullTraverserData &data) {
-  trav->_geom_nodes_pcollector.add_level(1);
+  trav->count_level(trav->_geom_nodes_pcollector, 1);
 
   if (pgraph_cat.is_spam()) {
     pgraph_cat.spam()
@@ -513,9 +514,12 @@ add_for_draw(CullTraverser *trav, CullTraverserData &data) {
   // Get all the Geoms, with no decalling.
   Geoms geoms = get_geoms(current_thread);
   int num_geoms = geoms.get_num_geoms();
-  trav->_geoms_pcollector.add_level(num_geoms);
+  trav->count_level(trav->_geoms_pcollector, num_geoms);
   CPT(TransformState) internal_transform = data.get_internal_transform(trav);
 
+  // The size on screen is only computed when a streamed texture needs it.
+  PN_stdfloat screen_size = -1.0f;
+
   for (int i = 0; i < num_geoms; i++) {
     CPT(Geom) geom = geoms.get_geom(i);
     if (geom->is_empty()) {
@@ -528,6 +532,13 @@ add_for_draw(CullTraverser *trav, CullTraverserData &data) {
       continue;
     }
 
+    if (texture_streaming) {
+      if (screen_size < 0.0f) {
+        screen_size = trav->estimate_screen_size(data);
+      }
+      CullTraverser::request_texture_streaming(state, screen_size);
+    }
+
     if (data._instances != nullptr) {
       // Draw each individual instance.  We don't bother culling each
       // individual Geom for each instance; that is probably way too slow.
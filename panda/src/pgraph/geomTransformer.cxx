@@ -37,6 +37,8 @@ PStatCollector GeomTransformer::_apply_set_color_collector("*:Flatten:apply:set
 PStatCollector GeomTransformer::_apply_scale_color_collector("*:Flatten:apply:scale color");
 PStatCollector GeomTransformer::_apply_texture_color_collector("*:Flatten:apply:texture color");
 PStatCollector GeomTransformer::_apply_set_format_collector("*:Flatten:apply:set format");
+PStatCollector GeomTransformer::_finish_apply_collector("*:Flatten:apply:finish");
+PStatCollector GeomTransformer::_finish_collect_collector("*:Flatten:collect:finish");
 
 TypeHandle GeomTransformer::NewCollectedData::_type_handle;
 
@@ -46,7 +48,8 @@ TypeHandle GeomTransformer::NewCollectedData::_type_handle;
 GeomTransformer::
 GeomTransformer() :
   // The default value here comes from the Config file.
-  _max_collect_vertices(max_collect_vertices)
+  _max_collect_vertices(max_collect_vertices),
+  _job_runner(nullptr)
 {
 }
 
@@ -55,7 +58,8 @@ GeomTransformer() :
  */
 GeomTransformer::
 GeomTransformer(const GeomTransformer &copy) :
-  _max_collect_vertices(copy._max_collect_vertices)
+  _max_collect_vertices(copy._max_collect_vertices),
+  _job_runner(copy._job_runner)
 {
 }
 
@@ -64,6 +68,7 @@ GeomTransformer(const GeomTransformer &copy) :
  */
 GeomTransformer::
 ~GeomTransformer() {
+  finish_deferred();
   finish_collect(false);
 }
 
@@ -109,15 +114,24 @@ transform_vertices(Geom *geom, const LMatrix4 &mat) {
   PStatTimer timer(_apply_vertex_collector);
 
   nassertr(geom != nullptr, false);
+  complete_deferred(geom->get_vertex_data());
+
   SourceVertices sv;
   sv._mat = mat;
   sv._vertex_data = geom->get_vertex_data();
 
   NewVertexData &new_data = _vertices[sv];
   if (new_data._vdata.is_null()) {
-    // We have not yet converted these vertices.  Do so now.
+    // We have not yet converted these vertices.  Do so now, or leave it for
+    // finish_deferred() if we have worker threads to do it concurrently.
     PT(GeomVertexData) new_vdata = new GeomVertexData(*sv._vertex_data);
-    new_vdata->transform_vertices(mat);
+    if (_job_runner != nullptr && _job_runner->is_parallel()) {
+      DeferredVertices &deferred = _deferred_vertices[new_vdata];
+      deferred._vdata = new_vdata;
+      deferred._mat = mat;
+    } else {
+      new_vdata->transform_vertices(mat);
+    }
     new_data._vdata = new_vdata;
   }
 
@@ -176,6 +190,7 @@ transform_texcoords(Geom *geom, const InternalName *from_name,
   PStatTimer timer(_apply_texcoord_collector);
 
   nassertr(geom != nullptr, false);
+  complete_deferred(geom->get_vertex_data());
 
   SourceTexCoords st;
   st._mat = mat;
@@ -262,6 +277,8 @@ bool GeomTransformer::
 set_color(Geom *geom, const LColor &color) {
   PStatTimer timer(_apply_set_color_collector);
 
+  complete_deferred(geom->get_vertex_data());
+
   SourceColors sc;
   sc._color = color;
   sc._vertex_data = geom->get_vertex_data();
@@ -320,6 +337,7 @@ transform_colors(Geom *geom, const LVecBase4 &scale) {
   PStatTimer timer(_apply_scale_color_collector);
 
   nassertr(geom != nullptr, false);
+  complete_deferred(geom->get_vertex_data());
 
   SourceColors sc;
   sc._color = scale;
@@ -385,6 +403,7 @@ apply_texture_colors(Geom *geom, TextureStage *ts, Texture *tex,
   PStatTimer timer(_apply_texture_color_collector);
 
   nassertr(geom != nullptr, false);
+  complete_deferred(geom->get_vertex_data());
 
   PT(TexturePeeker) peeker = tex->peek();
   if (peeker == nullptr) {
@@ -660,6 +679,7 @@ set_format(Geom *geom, const GeomVertexFormat *new_format) {
   PStatTimer timer(_apply_set_format_collector);
 
   nassertr(geom != nullptr, false);
+  complete_deferred(geom->get_vertex_data());
 
   SourceFormat sf;
   sf._format = new_format;
@@ -693,6 +713,8 @@ set_format(Geom *geom, const GeomVertexFormat *new_format) {
  */
 bool GeomTransformer::
 remove_column(Geom *geom, const InternalName *column) {
+  complete_deferred(geom->get_vertex_data());
+
   CPT(GeomVertexFormat) format = geom->get_vertex_data()->get_format();
   if (!format->has_column(column)) {
     return false;
@@ -741,6 +763,8 @@ make_compatible_state(GeomNode *node) {
     return false;
   }
 
+  finish_deferred();
+
   GeomNode::CDWriter cdata(node->_cycler);
   PT(GeomNode::GeomList) geoms = cdata->modify_geoms();
 
@@ -819,6 +843,7 @@ make_compatible_state(GeomNode *node) {
 bool GeomTransformer::
 reverse_normals(Geom *geom) {
   nassertr(geom != nullptr, false);
+  complete_deferred(geom->get_vertex_data());
   CPT(GeomVertexData) orig_data = geom->get_vertex_data();
   NewVertexData &new_data = _reversed_normals[orig_data];
   if (new_data._vdata.is_null()) {
@@ -858,6 +883,7 @@ doubleside(GeomNode *node) {
   int num_geoms = node->get_num_geoms();
   for (int i = 0; i < num_geoms; ++i) {
     CPT(Geom) orig_geom = node->get_geom(i);
+    complete_deferred(orig_geom->get_vertex_data());
     bool has_normals = (orig_geom->get_vertex_data()->has_column(InternalName::get_normal()));
     if (has_normals) {
       // If the geometry has normals, we have to duplicate it to reverse the
@@ -902,6 +928,59 @@ reverse(GeomNode *node) {
   return (num_geoms != 0);
 }
 
+/**
+ * Reorders the triangles of the Geoms in this GeomNode for better use of the
+ * vertex cache, optionally also reducing overdraw; see
+ * Geom::optimize_vertex_cache_in_place().  The vertices are then reordered in
+ * the order they are first used, for better locality when they are fetched;
+ * this happens in finish_apply(), since other Geoms may share the same
+ * vertices.
+ *
+ * Returns true if any Geoms are modified, false otherwise.
+ */
+bool GeomTransformer::
+optimize_vertex_cache(GeomNode *node, bool reduce_overdraw) {
+  finish_deferred();
+
+  int num_geoms = node->get_num_geoms();
+  for (int i = 0; i < num_geoms; ++i) {
+    PT(Geom) geom = node->modify_geom(i);
+    geom->optimize_vertex_cache_in_place(reduce_overdraw);
+
+    VertexDataAssoc &assoc = _vdata_assoc[geom->get_vertex_data()];
+    assoc._geoms.push_back(geom);
+    assoc._reorder = true;
+  }
+
+  return (num_geoms != 0);
+}
+
+/**
+ * Reduces the number of triangles of the Geoms in this GeomNode; see
+ * Geom::simplify_in_place().  The vertices that are no longer used are
+ * removed in finish_apply().
+ *
+ * Returns the greatest error of any of the Geoms, or 0 if none of them were
+ * simplified.
+ */
+PN_stdfloat GeomTransformer::
+simplify(GeomNode *node, PN_stdfloat target_ratio, PN_stdfloat max_error) {
+  finish_deferred();
+
+  PN_stdfloat result = 0;
+  int num_geoms = node->get_num_geoms();
+  for (int i = 0; i < num_geoms; ++i) {
+    PT(Geom) geom = node->modify_geom(i);
+    result = std::max(result, geom->simplify_in_place(target_ratio, max_error));
+
+    VertexDataAssoc &assoc = _vdata_assoc[geom->get_vertex_data()];
+    assoc._geoms.push_back(geom);
+    assoc._might_have_unused = true;
+  }
+
+  return result;
+}
+
 /**
  * Should be called after performing any operations--particularly
  * PandaNode::apply_attribs_to_vertices()--that might result in new
@@ -911,11 +990,16 @@ reverse(GeomNode *node) {
  */
 void GeomTransformer::
 finish_apply() {
+  finish_deferred();
+
+  PStatTimer timer(_finish_apply_collector);
   VertexDataAssocMap::iterator vi;
   for (vi = _vdata_assoc.begin(); vi != _vdata_assoc.end(); ++vi) {
     const GeomVertexData *vdata = (*vi).first;
     VertexDataAssoc &assoc = (*vi).second;
-    if (assoc._might_have_unused) {
+    if (assoc._reorder) {
+      assoc.reorder_vertices(vdata);
+    } else if (assoc._might_have_unused) {
       assoc.remove_unused_vertices(vdata);
     }
   }
@@ -928,6 +1012,59 @@ finish_apply() {
   _reversed_normals.clear();
 }
 
+/**
+ * Performs any vertex transforms that transform_vertices() put off, dividing
+ * them among the threads of the job runner.  This is called automatically by
+ * finish_apply(), and before any operation that needs to read the
+ * transformed vertices.
+ */
+void GeomTransformer::
+finish_deferred() {
+  if (_deferred_vertices.empty()) {
+    return;
+  }
+
+  PStatTimer timer(_apply_vertex_collector);
+
+  // Each entry refers to a different GeomVertexData, so they may safely be
+  // transformed concurrently.
+  pvector<DeferredVertices *> jobs;
+  jobs.reserve(_deferred_vertices.size());
+  DeferredVerticesMap::iterator di;
+  for (di = _deferred_vertices.begin(); di != _deferred_vertices.end(); ++di) {
+    jobs.push_back(&(*di).second);
+  }
+
+  auto transform_job = [&] (int job, Thread *current_thread) {
+    DeferredVertices *deferred = jobs[job];
+    deferred->_vdata->transform_vertices(deferred->_mat);
+  };
+  if (_job_runner != nullptr) {
+    _job_runner->run((int)jobs.size(), transform_job);
+  } else {
+    Thread *current_thread = Thread::get_current_thread();
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      transform_job((int)i, current_thread);
+    }
+  }
+
+  _deferred_vertices.clear();
+}
+
+/**
+ * Performs the vertex transform that was put off for the indicated vertex
+ * data right away, if there is one.
+ */
+void GeomTransformer::
+do_complete_deferred(const GeomVertexData *vdata) {
+  DeferredVerticesMap::iterator di = _deferred_vertices.find(vdata);
+  if (di != _deferred_vertices.end()) {
+    DeferredVertices &deferred = (*di).second;
+    deferred._vdata->transform_vertices(deferred._mat);
+    _deferred_vertices.erase(di);
+  }
+}
+
 /**
  * Collects together GeomVertexDatas from different geoms into one big (or
  * several big) GeomVertexDatas.  Returns the number of unique GeomVertexDatas
@@ -942,6 +1079,8 @@ finish_apply() {
  */
 int GeomTransformer::
 collect_vertex_data(Geom *geom, int collect_bits, bool format_only) {
+  complete_deferred(geom->get_vertex_data());
+
   CPT(GeomVertexData) vdata = geom->get_vertex_data();
   if (vdata->get_num_rows() > _max_collect_vertices) {
     // Don't even bother.
@@ -1089,19 +1228,48 @@ collect_vertex_data(GeomNode *node, int collect_bits, bool format_only) {
  */
 int GeomTransformer::
 finish_collect(bool format_only) {
-  int num_adjusted = 0;
+  PStatTimer timer(_finish_collect_collector);
+
+  // Each NewCollectedData has its own source vertex datas and Geoms, so they
+  // may be combined concurrently.  The exception is those that carry a
+  // TransformTable or SliderTable: combining these registers new tables and
+  // releases old ones, which modifies a global set of tables without a lock.
+  // Those are combined on this thread, after the others.  The counts are
+  // summed afterwards.
+  int num_collected = (int)_new_collected_list.size();
+  vector_int adjusted(num_collected, 0);
+  vector_int parallel_jobs, serial_jobs;
+  for (int i = 0; i < num_collected; ++i) {
+    if (_job_runner != nullptr &&
+        !_new_collected_list[i]->has_registered_tables()) {
+      parallel_jobs.push_back(i);
+    } else {
+      serial_jobs.push_back(i);
+    }
+  }
 
-  NewCollectedList::iterator nci;
-  for (nci = _new_collected_list.begin();
-       nci != _new_collected_list.end();
-       ++nci) {
-    NewCollectedData *ncd = (*nci);
+  auto collect_job = [&] (int job, Thread *current_thread) {
+    NewCollectedData *ncd = _new_collected_list[job];
     if (format_only) {
-      num_adjusted += ncd->apply_format_only_changes();
+      adjusted[job] = ncd->apply_format_only_changes();
     } else {
-      num_adjusted += ncd->apply_collect_changes();
+      adjusted[job] = ncd->apply_collect_changes();
     }
-    delete ncd;
+  };
+  if (!parallel_jobs.empty()) {
+    _job_runner->run((int)parallel_jobs.size(), [&] (int job, Thread *current_thread) {
+      collect_job(parallel_jobs[job], current_thread);
+    });
+  }
+  Thread *current_thread = Thread::get_current_thread();
+  for (int job : serial_jobs) {
+    collect_job(job, current_thread);
+  }
+
+  int num_adjusted = 0;
+  for (int i = 0; i < num_collected; ++i) {
+    num_adjusted += adjusted[i];
+    delete _new_collected_list[i];
   }
 
   _new_collected_list.clear();
@@ -1124,6 +1292,8 @@ premunge_geom(const Geom *geom, GeomMunger *munger) {
   // caching, and there's no danger of that cache filling up during the span
   // of one frame.
 
+  complete_deferred(geom->get_vertex_data());
+
   CPT(GeomVertexData) vdata = geom->get_vertex_data();
   vdata = munger->premunge_data(vdata);
   CPT(Geom) pgeom = geom;
@@ -1235,6 +1405,21 @@ apply_collect_changes() {
   return 1;
 }
 
+/**
+ * Returns true if any of the source vertex datas has a TransformTable or a
+ * SliderTable, which will have to be registered when the datas are combined.
+ */
+bool GeomTransformer::NewCollectedData::
+has_registered_tables() const {
+  for (const SourceData &sd : _source_datas) {
+    if (sd._vdata->get_transform_table() != nullptr ||
+        sd._vdata->get_slider_table() != nullptr) {
+      return true;
+    }
+  }
+  return false;
+}
+
 /**
  * Appends the vertices from the indicated source GeomVertexData to the end of
  * the working data.
@@ -1549,3 +1734,125 @@ remove_unused_vertices(const GeomVertexData *vdata) {
     geom->set_vertex_data(new_vdata);
   }
 }
+
+/**
+ * Renumbers the vertices in the order in which they are first referenced by
+ * the Geoms, so that the vertices that are drawn together are also close
+ * together in memory.  Vertices that are not referenced at all are moved to
+ * the end, or removed if _might_have_unused is set.
+ */
+void GeomTransformer::VertexDataAssoc::
+reorder_vertices(const GeomVertexData *vdata) {
+  if (vdata->get_transform_blend_table() != nullptr ||
+      vdata->get_slider_table() != nullptr) {
+    // These refer to ranges of vertices, which we would have to break up.
+    if (_might_have_unused) {
+      remove_unused_vertices(vdata);
+    }
+    return;
+  }
+
+  PT(Thread) current_thread = Thread::get_current_thread();
+
+  int num_vertices = vdata->get_num_rows();
+  pvector<int> remap_array(num_vertices, -1);
+  int new_num_vertices = 0;
+
+  GeomList::iterator gi;
+  for (gi = _geoms.begin(); gi != _geoms.end(); ++gi) {
+    Geom *geom = (*gi);
+    if (geom->get_vertex_data() != vdata) {
+      continue;
+    }
+
+    int num_primitives = geom->get_num_primitives();
+    for (int i = 0; i < num_primitives; ++i) {
+      GeomPrimitivePipelineReader reader(geom->get_primitive(i), current_thread);
+      int num_prim_vertices = reader.get_num_vertices();
+      for (int vi = 0; vi < num_prim_vertices; ++vi) {
+        int index = reader.get_vertex(vi);
+        nassertv(index >= 0 && index < num_vertices);
+        if (remap_array[index] < 0) {
+          remap_array[index] = new_num_vertices++;
+        }
+      }
+    }
+  }
+
+  if (new_num_vertices == 0) {
+    return;
+  }
+
+  // Decide what to do with the vertices that aren't used.
+  int num_used = new_num_vertices;
+  if (!_might_have_unused) {
+    for (int index = 0; index < num_vertices; ++index) {
+      if (remap_array[index] < 0) {
+        remap_array[index] = new_num_vertices++;
+      }
+    }
+  }
+
+  bool any_changed = (new_num_vertices != num_vertices);
+  for (int index = 0; index < num_vertices && !any_changed; ++index) {
+    any_changed = (remap_array[index] != index);
+  }
+  if (!any_changed) {
+    return;
+  }
+
+  // Now recopy the actual vertex data, one array at a time.
+  PT(GeomVertexData) new_vdata = new GeomVertexData(*vdata);
+  new_vdata->unclean_set_num_rows(new_num_vertices);
+
+  size_t num_arrays = vdata->get_num_arrays();
+  nassertv(num_arrays == new_vdata->get_num_arrays());
+
+  GeomVertexDataPipelineReader reader(vdata, current_thread);
+  reader.check_array_readers();
+  GeomVertexDataPipelineWriter writer(new_vdata, true, current_thread);
+  writer.check_array_writers();
+
+  for (size_t a = 0; a < num_arrays; ++a) {
+    const GeomVertexArrayDataHandle *array_reader = reader.get_array_reader(a);
+    GeomVertexArrayDataHandle *array_writer = writer.get_array_writer(a);
+
+    int stride = array_reader->get_array_format()->get_stride();
+    nassertv(stride == array_writer->get_array_format()->get_stride());
+
+    for (int index = 0; index < num_vertices; ++index) {
+      int new_index = remap_array[index];
+      if (new_index >= 0) {
+        array_writer->copy_subdata_from(new_index * stride, stride,
+                                        array_reader,
+                                        index * stride, stride);
+      }
+    }
+  }
+
+  // Finally, reindex the Geoms.
+  for (gi = _geoms.begin(); gi != _geoms.end(); ++gi) {
+    Geom *geom = (*gi);
+    if (geom->get_vertex_data() != vdata) {
+      continue;
+    }
+
+    int num_primitives = geom->get_num_primitives();
+    for (int i = 0; i < num_primitives; ++i) {
+      PT(GeomPrimitive) prim = geom->modify_primitive(i);
+      prim->make_indexed();
+      PT(GeomVertexArrayData) vertices = prim->modify_vertices();
+      GeomVertexRewriter rewriter(vertices, 0, current_thread);
+
+      while (!rewriter.is_at_end()) {
+        int index = rewriter.get_data1i();
+        nassertv(index >= 0 && index < num_vertices);
+        int new_index = remap_array[index];
+        nassertv(new_index >= 0 && new_index < num_used);
+        rewriter.set_data1i(new_index);
+      }
+    }
+
+    geom->set_vertex_data(new_vdata);
+  }
+}
@@ -20,6 +20,7 @@
 #include "geom.h"
 #include "geomVertexData.h"
 #include "texMatrixAttrib.h"
+#include "parallelJobRunner.h"
 
 class GeomNode;
 class RenderState;
@@ -48,6 +49,9 @@ public:
   INLINE int get_max_collect_vertices() const;
   INLINE void set_max_collect_vertices(int max_collect_vertices);
 
+  INLINE void set_job_runner(ParallelJobRunner *job_runner);
+  INLINE ParallelJobRunner *get_job_runner() const;
+
   void register_vertices(Geom *geom, bool might_have_unused);
   void register_vertices(GeomNode *node, bool might_have_unused);
 
@@ -82,7 +86,12 @@ public:
   bool doubleside(GeomNode *node);
   bool reverse(GeomNode *node);
 
+  bool optimize_vertex_cache(GeomNode *node, bool reduce_overdraw);
+  PN_stdfloat simplify(GeomNode *node, PN_stdfloat target_ratio,
+                       PN_stdfloat max_error);
+
   void finish_apply();
+  void finish_deferred();
 
   int collect_vertex_data(Geom *geom, int collect_bits, bool format_only);
   int collect_vertex_data(GeomNode *node, int collect_bits, bool format_only);
@@ -90,8 +99,13 @@ public:
 
   PT(Geom) premunge_geom(const Geom *geom, GeomMunger *munger);
 
+private:
+  INLINE void complete_deferred(const GeomVertexData *vdata);
+  void do_complete_deferred(const GeomVertexData *vdata);
+
 private:
   int _max_collect_vertices;
+  ParallelJobRunner *_job_runner;
 
   typedef pvector<PT(Geom) > GeomList;
 
@@ -102,8 +116,10 @@ private:
   public:
     INLINE VertexDataAssoc();
     bool _might_have_unused;
+    bool _reorder;
     GeomList _geoms;
     void remove_unused_vertices(const GeomVertexData *vdata);
+    void reorder_vertices(const GeomVertexData *vdata);
   };
   typedef pmap<CPT(GeomVertexData), VertexDataAssoc> VertexDataAssocMap;
   VertexDataAssocMap _vdata_assoc;
@@ -127,6 +143,17 @@ private:
   typedef pmap<SourceVertices, NewVertexData> NewVertices;
   NewVertices _vertices;
 
+  // The vertex transforms that transform_vertices() has put off, so that
+  // finish_deferred() can perform them concurrently.  These are keyed on the
+  // new GeomVertexData, which already stands in for the transformed data.
+  class DeferredVertices {
+  public:
+    PT(GeomVertexData) _vdata;
+    LMatrix4 _mat;
+  };
+  typedef pmap<const GeomVertexData *, DeferredVertices> DeferredVerticesMap;
+  DeferredVerticesMap _deferred_vertices;
+
   // The table of GeomVertexData objects whose texture coordinates have been
   // transformed by a particular matrix.
   class SourceTexCoords {
@@ -220,6 +247,7 @@ private:
     void add_source_data(const GeomVertexData *source_data);
     int apply_format_only_changes();
     int apply_collect_changes();
+    bool has_registered_tables() const;
 
     CPT(GeomVertexFormat) _new_format;
     std::string _vdata_name;
@@ -270,6 +298,8 @@ private:
   static PStatCollector _apply_scale_color_collector;
   static PStatCollector _apply_texture_color_collector;
   static PStatCollector _apply_set_format_collector;
+  static PStatCollector _finish_apply_collector;
+  static PStatCollector _finish_collect_collector;
 
 public:
   static void init_type() {
@@ -17,9 +17,17 @@
 #include "bamWriter.h"
 #include "bitArray.h"
 #include "geomVertexWriter.h"
+#include "boundingHexahedron.h"
+#include "boundingSphere.h"
+
+#include <algorithm>
 
 TypeHandle InstanceList::_type_handle;
 
+// The maximum number of instances that are grouped into a single cluster by
+// make_cull_tree().
+static const size_t instance_cluster_size = 64;
+
 /**
  * Required to implement CopyOnWriteObject.
  */
@@ -91,6 +99,305 @@ without(const BitArray &mask) const {
   return new_list;
 }
 
+/**
+ * Returns a list containing only the instances that are visible, given the
+ * bounding sphere of the instanced geometry (in the coordinate space of each
+ * instance), the view frustum and the position of the camera (in the
+ * coordinate space of the list).  The view frustum may be NULL, in which case
+ * only the distance ranges of the instances are taken into account.
+ *
+ * The visible instances retain their relative order.  If all of the
+ * instances are visible, the list itself is returned.
+ */
+CPT(InstanceList) InstanceList::
+cull(const LPoint3 &center, PN_stdfloat radius,
+     const GeometricBoundingVolume *view_frustum,
+     const LPoint3 &camera_pos) const {
+  size_t num_instances = size();
+  if (num_instances == 0) {
+    return this;
+  }
+
+  CPT(CullTree) tree;
+  {
+    LightMutexHolder holder(_cull_tree_lock);
+    tree = _cull_tree;
+  }
+  if (tree == nullptr || tree->_center != center || tree->_radius != radius) {
+    // Build the tree without holding the lock.  If another thread does the
+    // same thing at the same time, one of the two trees simply wins.
+    tree = make_cull_tree(center, radius);
+
+    LightMutexHolder holder(_cull_tree_lock);
+    _cull_tree = tree;
+  }
+
+  if (view_frustum == nullptr && !tree->_has_distance_range) {
+    return this;
+  }
+
+  // Most lenses produce a hexahedron, whose planes we can test against
+  // directly.  Otherwise, we fall back to the generic containment tests.
+  const BoundingHexahedron *hexahedron = nullptr;
+  int num_planes = 0;
+  LPlane planes[6];
+  if (view_frustum != nullptr) {
+    hexahedron = view_frustum->as_bounding_hexahedron();
+    if (hexahedron != nullptr) {
+      num_planes = hexahedron->get_num_planes();
+      nassertr(num_planes <= 6, this);
+      for (int pi = 0; pi < num_planes; ++pi) {
+        planes[pi] = hexahedron->get_plane(pi);
+      }
+    }
+  }
+
+  // One flag per instance, in cluster order.
+  pvector<unsigned char> visible(num_instances, 0);
+  size_t num_visible = 0;
+
+  for (const CullTree::Cluster &cluster : tree->_clusters) {
+    // First, test the cluster as a whole.  We keep track of which planes
+    // intersect it; the instances only need to be tested against those.
+    int num_cluster_planes = 0;
+    int cluster_planes[6];
+    bool all_inside = true;
+
+    if (hexahedron != nullptr) {
+      bool outside = false;
+      for (int pi = 0; pi < num_planes; ++pi) {
+        PN_stdfloat dist = planes[pi].dist_to_plane(cluster._center);
+        if (dist > cluster._radius) {
+          outside = true;
+          break;
+        } else if (dist > -cluster._radius) {
+          cluster_planes[num_cluster_planes++] = pi;
+        }
+      }
+      if (outside) {
+        continue;
+      }
+    } else if (view_frustum != nullptr) {
+      BoundingSphere sphere(cluster._center, cluster._radius);
+      int result = view_frustum->contains(&sphere);
+      if (result == BoundingVolume::IF_no_intersection) {
+        continue;
+      }
+      all_inside = (result & BoundingVolume::IF_all) != 0;
+    }
+
+    bool check_distance = false;
+    if (tree->_has_distance_range) {
+      PN_stdfloat dist = (cluster._center - camera_pos).length();
+      if (dist - cluster._radius > cluster._max_distance ||
+          dist + cluster._radius < cluster._min_distance) {
+        continue;
+      }
+      check_distance = true;
+    }
+
+    size_t begin = cluster._begin;
+    size_t count = cluster._end - begin;
+    unsigned char *flags = &visible[begin];
+    const PN_stdfloat *xs = &tree->_x[begin];
+    const PN_stdfloat *ys = &tree->_y[begin];
+    const PN_stdfloat *zs = &tree->_z[begin];
+    const PN_stdfloat *rs = &tree->_r[begin];
+    std::fill(flags, flags + count, (unsigned char)1);
+
+    // Now test the individual instances.  These loops are kept simple, so
+    // that the compiler can test several instances at once.
+    for (int cpi = 0; cpi < num_cluster_planes; ++cpi) {
+      const LPlane &plane = planes[cluster_planes[cpi]];
+      PN_stdfloat a = plane[0];
+      PN_stdfloat b = plane[1];
+      PN_stdfloat c = plane[2];
+      PN_stdfloat d = plane[3];
+      for (size_t i = 0; i < count; ++i) {
+        flags[i] &= (a * xs[i] + b * ys[i] + c * zs[i] + d <= rs[i]);
+      }
+    }
+
+    if (!all_inside) {
+      for (size_t i = 0; i < count; ++i) {
+        BoundingSphere sphere(LPoint3(xs[i], ys[i], zs[i]), rs[i]);
+        flags[i] = (view_frustum->contains(&sphere) != BoundingVolume::IF_no_intersection);
+      }
+    }
+
+    if (check_distance) {
+      const PN_stdfloat *min2 = &tree->_min_distance2[begin];
+      const PN_stdfloat *max2 = &tree->_max_distance2[begin];
+      PN_stdfloat px = camera_pos[0];
+      PN_stdfloat py = camera_pos[1];
+      PN_stdfloat pz = camera_pos[2];
+      for (size_t i = 0; i < count; ++i) {
+        PN_stdfloat dx = xs[i] - px;
+        PN_stdfloat dy = ys[i] - py;
+        PN_stdfloat dz = zs[i] - pz;
+        PN_stdfloat dist2 = dx * dx + dy * dy + dz * dz;
+        flags[i] &= (dist2 >= min2[i]) & (dist2 <= max2[i]);
+      }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      num_visible += flags[i];
+    }
+  }
+
+  if (num_visible == num_instances) {
+    return this;
+  }
+
+  // Put the flags back in the original order, so that the visible instances
+  // retain their order.
+  pvector<unsigned char> original(num_instances);
+  for (size_t i = 0; i < num_instances; ++i) {
+    original[tree->_index[i]] = visible[i];
+  }
+
+  InstanceList *new_list = new InstanceList;
+  new_list->_instances.reserve(num_visible);
+  for (size_t i = 0; i < num_instances; ++i) {
+    if (original[i]) {
+      new_list->_instances.push_back(_instances[i]);
+    }
+  }
+  return new_list;
+}
+
+/**
+ * Computes the bounding sphere of each instance, given the bounding sphere of
+ * the instanced geometry, and sorts the instances into clusters.
+ */
+CPT(InstanceList::CullTree) InstanceList::
+make_cull_tree(const LPoint3 &center, PN_stdfloat radius) const {
+  size_t num_instances = size();
+
+  PT(CullTree) tree = new CullTree;
+  tree->_center = center;
+  tree->_radius = radius;
+  tree->_has_distance_range = false;
+
+  pvector<LPoint3> centers;
+  centers.reserve(num_instances);
+  pvector<PN_stdfloat> radii(num_instances);
+  for (size_t i = 0; i < num_instances; ++i) {
+    const Instance &instance = _instances[i];
+    const LMatrix4 &mat = instance.get_mat();
+    centers.push_back(mat.xform_point(center));
+
+    // The largest scale factor along any axis determines the radius.
+    PN_stdfloat scale2 = std::max(mat.get_row3(0).length_squared(),
+                         std::max(mat.get_row3(1).length_squared(),
+                                  mat.get_row3(2).length_squared()));
+    radii[i] = radius * csqrt(scale2);
+
+    if (instance.has_distance_range()) {
+      tree->_has_distance_range = true;
+    }
+  }
+
+  tree->_index.resize(num_instances);
+  for (size_t i = 0; i < num_instances; ++i) {
+    tree->_index[i] = i;
+  }
+  if (num_instances > 0) {
+    size_t *indices = tree->_index.data();
+    r_make_clusters(tree, indices, indices + num_instances, centers.data());
+  }
+
+  // Now store the spheres in cluster order.
+  tree->_x.resize(num_instances);
+  tree->_y.resize(num_instances);
+  tree->_z.resize(num_instances);
+  tree->_r.resize(num_instances);
+  for (size_t i = 0; i < num_instances; ++i) {
+    size_t n = tree->_index[i];
+    tree->_x[i] = centers[n][0];
+    tree->_y[i] = centers[n][1];
+    tree->_z[i] = centers[n][2];
+    tree->_r[i] = radii[n];
+  }
+
+  if (tree->_has_distance_range) {
+    tree->_min_distance2.resize(num_instances);
+    tree->_max_distance2.resize(num_instances);
+    for (size_t i = 0; i < num_instances; ++i) {
+      const Instance &instance = _instances[tree->_index[i]];
+      tree->_min_distance2[i] = instance._min_distance * instance._min_distance;
+      tree->_max_distance2[i] = instance._max_distance * instance._max_distance;
+    }
+  }
+
+  // Finally, compute the bounds of each cluster.
+  for (CullTree::Cluster &cluster : tree->_clusters) {
+    LPoint3 min_point(tree->_x[cluster._begin], tree->_y[cluster._begin], tree->_z[cluster._begin]);
+    LPoint3 max_point(min_point);
+    for (size_t i = cluster._begin; i < cluster._end; ++i) {
+      LPoint3 point(tree->_x[i], tree->_y[i], tree->_z[i]);
+      min_point = min_point.fmin(point);
+      max_point = max_point.fmax(point);
+    }
+    cluster._center = (min_point + max_point) * 0.5f;
+    cluster._radius = 0;
+    cluster._min_distance = make_inf((PN_stdfloat)0);
+    cluster._max_distance = 0;
+    for (size_t i = cluster._begin; i < cluster._end; ++i) {
+      LPoint3 point(tree->_x[i], tree->_y[i], tree->_z[i]);
+      cluster._radius = std::max(cluster._radius, (point - cluster._center).length() + tree->_r[i]);
+
+      const Instance &instance = _instances[tree->_index[i]];
+      cluster._min_distance = std::min(cluster._min_distance, instance._min_distance);
+      cluster._max_distance = std::max(cluster._max_distance, instance._max_distance);
+    }
+  }
+
+  return tree;
+}
+
+/**
+ * Recursively splits the indicated range of instance indices in half along
+ * the longest axis of their bounds, until each part is small enough to form
+ * a cluster.
+ */
+void InstanceList::
+r_make_clusters(CullTree *tree, size_t *begin, size_t *end,
+                const LPoint3 *centers) const {
+  size_t count = (size_t)(end - begin);
+  if (count <= instance_cluster_size) {
+    CullTree::Cluster cluster;
+    cluster._begin = (size_t)(begin - tree->_index.data());
+    cluster._end = cluster._begin + count;
+    tree->_clusters.push_back(cluster);
+    return;
+  }
+
+  LPoint3 min_point = centers[*begin];
+  LPoint3 max_point = min_point;
+  for (size_t *ip = begin; ip != end; ++ip) {
+    min_point = min_point.fmin(centers[*ip]);
+    max_point = max_point.fmax(centers[*ip]);
+  }
+
+  LVector3 extent = max_point - min_point;
+  int axis = 0;
+  if (extent[1] > extent[axis]) {
+    axis = 1;
+  }
+  if (extent[2] > extent[axis]) {
+    axis = 2;
+  }
+
+  size_t *middle = begin + count / 2;
+  std::nth_element(begin, middle, end, [=] (size_t a, size_t b) {
+    return centers[a][axis] < centers[b][axis];
+  });
+
+  r_make_clusters(tree, begin, middle, centers);
+  r_make_clusters(tree, middle, end, centers);
+}
+
 /**
  * Returns a GeomVertexArrayData containing the matrices.
  */
@@ -156,9 +463,23 @@ void InstanceList::
 write_datagram(BamWriter *manager, Datagram &dg) {
   CopyOnWriteObject::write_datagram(manager, dg);
 
+  if (manager->get_file_minor_ver() >= 47) {
+    dg.add_uint32((uint32_t)_instances.size());
+  } else {
+    nassertv(_instances.size() <= 0xffff);
+    dg.add_uint16((uint16_t)_instances.size());
+  }
+
   for (const Instance &instance : *(const InstanceList *)this) {
     manager->write_pointer(dg, instance.get_transform());
   }
+
+  if (manager->get_file_minor_ver() >= 47) {
+    for (const Instance &instance : *(const InstanceList *)this) {
+      dg.add_stdfloat(instance._min_distance);
+      dg.add_stdfloat(instance._max_distance);
+    }
+  }
 }
 
 /**
@@ -170,7 +491,7 @@ complete_pointers(TypedWritable **p_list, BamReader *manager) {
   int pi = CopyOnWriteObject::complete_pointers(p_list, manager);
 
   for (Instance &instance : *this) {
-    instance = Instance(DCAST(TransformState, p_list[pi++]));
+    instance._transform = DCAST(TransformState, p_list[pi++]);
   }
 
   return pi;
@@ -201,7 +522,12 @@ void InstanceList::
 fillin(DatagramIterator &scan, BamReader *manager) {
   CopyOnWriteObject::fillin(scan, manager);
 
-  size_t num_instances = scan.get_uint16();
+  size_t num_instances;
+  if (manager->get_file_minor_ver() >= 47) {
+    num_instances = scan.get_uint32();
+  } else {
+    num_instances = scan.get_uint16();
+  }
   _instances.clear();
   _instances.resize(num_instances);
 
@@ -209,5 +535,12 @@ fillin(DatagramIterator &scan, BamReader *manager) {
     manager->read_pointer(scan);
   }
 
-  _cached_array.clear();
+  if (manager->get_file_minor_ver() >= 47) {
+    for (Instance &instance : _instances) {
+      instance._min_distance = scan.get_stdfloat();
+      instance._max_distance = scan.get_stdfloat();
+    }
+  }
+
+  mark_modified();
 }
@@ -19,9 +19,13 @@
 #include "transformState.h"
 #include "pvector.h"
 #include "geomVertexArrayData.h"
+#include "referenceCount.h"
+#include "lightMutex.h"
+#include "lightMutexHolder.h"
 
 class BitArray;
 class FactoryParams;
+class GeometricBoundingVolume;
 
 /**
  * This structure stores a list of per-instance data, used by InstancedNode.
@@ -71,8 +75,20 @@ PUBLISHED:
     INLINE void set_transform(CPT(TransformState));
     MAKE_PROPERTY(transform, get_transform);
 
+    INLINE PN_stdfloat get_min_distance() const;
+    INLINE PN_stdfloat get_max_distance() const;
+    INLINE void set_distance_range(PN_stdfloat min_distance, PN_stdfloat max_distance);
+    INLINE void clear_distance_range();
+    INLINE bool has_distance_range() const;
+    MAKE_PROPERTY(min_distance, get_min_distance);
+    MAKE_PROPERTY(max_distance, get_max_distance);
+
   private:
     CPT(TransformState) _transform;
+    PN_stdfloat _min_distance;
+    PN_stdfloat _max_distance;
+
+    friend class InstanceList;
   };
 
   void append(Instance instance);
@@ -108,6 +124,9 @@ public:
   INLINE const_iterator cend() const;
 
   CPT(InstanceList) without(const BitArray &mask) const;
+  CPT(InstanceList) cull(const LPoint3 &center, PN_stdfloat radius,
+                         const GeometricBoundingVolume *view_frustum,
+                         const LPoint3 &camera_pos) const;
 
   CPT(GeomVertexArrayData) get_array_data(const GeomVertexArrayFormat *format) const;
 
@@ -115,10 +134,49 @@ public:
   virtual void write(std::ostream &out, int indent_level) const;
 
 private:
+  INLINE void mark_modified();
+
+  // This is built by cull() to quickly find the visible instances.  The
+  // instances are grouped into spatially coherent clusters, which are tested
+  // against the frustum first.  The bounding sphere of each instance is
+  // stored in separate arrays, so that the tests can be vectorized.
+  class CullTree : public ReferenceCount {
+  public:
+    struct Cluster {
+      LPoint3 _center = LPoint3::zero();
+      PN_stdfloat _radius = 0;
+      PN_stdfloat _min_distance = 0;
+      PN_stdfloat _max_distance = 0;
+      size_t _begin = 0;
+      size_t _end = 0;
+    };
+
+    // The bounding sphere of the instanced geometry that this was built for.
+    LPoint3 _center;
+    PN_stdfloat _radius;
+    bool _has_distance_range;
+
+    // These are indexed in cluster order.
+    pvector<PN_stdfloat> _x, _y, _z, _r;
+    pvector<PN_stdfloat> _min_distance2, _max_distance2;
+    pvector<size_t> _index;
+
+    pvector<Cluster> _clusters;
+  };
+
+  CPT(CullTree) make_cull_tree(const LPoint3 &center, PN_stdfloat radius) const;
+  void r_make_clusters(CullTree *tree, size_t *begin, size_t *end,
+                       const LPoint3 *centers) const;
+
   Instances _instances;
 
   mutable CPT(GeomVertexArrayData) _cached_array;
 
+  // cull() may be called from several cull threads at once, so the cached
+  // tree is only replaced while this lock is held.
+  mutable LightMutex _cull_tree_lock;
+  mutable CPT(CullTree) _cull_tree;
+
 public:
   static void register_with_read_factory();
   virtual void write_datagram(BamWriter *manager, Datagram &dg) override;
@@ -211,18 +211,25 @@ cull_callback(CullTraverser *trav, CullTraverserData &data) {
     new_list->reserve(data._instances->size() * instances->size());
     for (const InstanceList::Instance &parent_instance : *data._instances) {
       for (const InstanceList::Instance &this_instance : *instances) {
-        new_list->append(parent_instance.get_transform()->compose(this_instance.get_transform()));
+        InstanceList::Instance instance(parent_instance.get_transform()->compose(this_instance.get_transform()));
+        if (this_instance.has_distance_range()) {
+          instance.set_distance_range(this_instance.get_min_distance(),
+                                      this_instance.get_max_distance());
+        }
+        new_list->append(std::move(instance));
       }
     }
     instances = new_list;
   }
 
-  if (data._view_frustum != nullptr || !data._cull_planes->is_empty()) {
-    // Culling is on, so we need to figure out which instances are visible.
-    Children children = data.node_reader()->get_children();
-    data.node_reader()->release();
+  Children children = data.node_reader()->get_children();
+  data.node_reader()->release();
+
+  const GeometricBoundingVolume *view_frustum = data._view_frustum;
 
-    // Keep track of which instances should be culled away.
+  if (!data._cull_planes->is_empty()) {
+    // There are clip planes or occluders, which we can only test for each
+    // instance individually.
     BitArray culled_instances;
     culled_instances.set_range(0, instances->size());
 
@@ -241,8 +248,38 @@ cull_callback(CullTraverser *trav, CullTraverserData &data) {
     }
 
     instances = instances->without(culled_instances);
-  } else {
-    data.node_reader()->release();
+
+    // That took care of the view frustum too.
+    view_frustum = nullptr;
+  }
+
+  // The instance list tests the bounding sphere of the children against the
+  // view frustum and the distance ranges, for many instances at once.
+  size_t num_children = children.size();
+  if (num_children > 0 && !instances->empty()) {
+    pvector<CPT(BoundingVolume)> child_bounds;
+    pvector<const BoundingVolume *> child_volumes;
+    child_bounds.reserve(num_children);
+    child_volumes.reserve(num_children);
+    for (size_t ci = 0; ci < num_children; ++ci) {
+      child_bounds.push_back(children.get_child(ci)->get_bounds(current_thread));
+      child_volumes.push_back(child_bounds.back());
+    }
+
+    BoundingSphere bounds;
+    const BoundingVolume **volumes = child_volumes.data();
+    ((BoundingVolume &)bounds).around(volumes, volumes + num_children);
+
+    if (bounds.is_empty()) {
+      if (view_frustum != nullptr) {
+        // There is nothing to see.
+        return false;
+      }
+    } else if (!bounds.is_infinite()) {
+      LPoint3 camera_pos = data.get_net_transform(trav)->invert_compose(trav->get_camera_transform())->get_pos();
+      instances = instances->cull(bounds.get_center(), bounds.get_radius(),
+                                  view_frustum, camera_pos);
+    }
   }
 
   if (instances->empty()) {
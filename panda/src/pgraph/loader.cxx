@@ -277,27 +277,54 @@ load_file(const Filename &filename, const LoaderOptions &options) const {
 PT(PandaNode) Loader::
 try_load_file(const Filename &pathname, const LoaderOptions &options,
               LoaderFileType *requested_type) const {
-  BamCache *cache = BamCache::get_global_ptr();
-
   bool allow_ram_cache =
     ((options.get_flags() & LoaderOptions::LF_no_ram_cache) == 0);
 
-  if (allow_ram_cache) {
-    // If we're allowing a RAM cache, use the ModelPool to load the file.
-    PT(PandaNode) node = ModelPool::get_model(pathname, true);
-    if (node != nullptr) {
-      if ((options.get_flags() & LoaderOptions::LF_allow_instance) == 0) {
-        if (loader_cat.is_debug()) {
-          loader_cat.debug()
-            << "Model " << pathname << " found in ModelPool.\n";
-        }
-        // But return a deep copy of the shared model.
-        node = node->copy_subgraph();
-      }
-      return node;
+  if (!allow_ram_cache) {
+    return try_load_uncached_file(pathname, options, requested_type);
+  }
+
+  // If we're allowing a RAM cache, use the ModelPool to load the file.  If
+  // another thread is already loading the same file, this waits for it to
+  // finish rather than loading it a second time.
+  PT(ModelRoot) model_root = ModelPool::begin_load_model(pathname);
+  if (model_root != nullptr) {
+    if (loader_cat.is_debug()) {
+      loader_cat.debug()
+        << "Model " << pathname << " found in ModelPool.\n";
+    }
+  } else {
+    PT(PandaNode) result = try_load_uncached_file(pathname, options, requested_type);
+    if (result != nullptr && result->is_of_type(ModelRoot::get_class_type())) {
+      model_root = DCAST(ModelRoot, result.p());
+    }
+
+    // Store the loaded model in the RAM cache.  If another thread got there
+    // first, we use its model instead.
+    if (model_root == nullptr) {
+      ModelPool::end_load_model(pathname, nullptr);
+      return result;
     }
+    model_root = ModelPool::end_load_model(pathname, model_root);
   }
 
+  if ((options.get_flags() & LoaderOptions::LF_allow_instance) == 0) {
+    // Return a copy so that this node can be modified independently from the
+    // RAM cached version.
+    return model_root->copy_subgraph();
+  }
+  return model_root;
+}
+
+/**
+ * The part of try_load_file() that doesn't involve the ModelPool: this checks
+ * the on-disk cache, and failing that, reads the file itself.
+ */
+PT(PandaNode) Loader::
+try_load_uncached_file(const Filename &pathname, const LoaderOptions &options,
+                       LoaderFileType *requested_type) const {
+  BamCache *cache = BamCache::get_global_ptr();
+
   bool report_errors = ((options.get_flags() & LoaderOptions::LF_report_errors) != 0 || loader_cat.is_debug());
 
   PT(BamCacheRecord) record;
@@ -322,16 +349,6 @@ try_load_file(const Filename &pathname, const LoaderOptions &options,
           ModelRoot *model_root = DCAST(ModelRoot, result.p());
           model_root->set_fullpath(pathname);
           model_root->set_timestamp(record->get_source_timestamp());
-
-          if (allow_ram_cache) {
-            // Store the loaded model in the RAM cache, and make sure we
-            // return a copy so that this node can be modified independently
-            // from the RAM cached version.
-            ModelPool::add_model(pathname, model_root);
-            if ((options.get_flags() & LoaderOptions::LF_allow_instance) == 0) {
-              return model_root->copy_subgraph();
-            }
-          }
         }
         return result;
       }
@@ -392,16 +409,6 @@ try_load_file(const Filename &pathname, const LoaderOptions &options,
     sgr.premunge(result, RenderState::make_empty());
   }
 
-  if (allow_ram_cache && result->is_of_type(ModelRoot::get_class_type())) {
-    // Store the loaded model in the RAM cache, and make sure we return a
-    // copy so that this node can be modified independently from the RAM
-    // cached version.
-    ModelPool::add_model(pathname, DCAST(ModelRoot, result.p()));
-    if ((options.get_flags() & LoaderOptions::LF_allow_instance) == 0) {
-      result = result->copy_subgraph();
-    }
-  }
-
   return result;
 }
 
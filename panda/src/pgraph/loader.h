@@ -104,6 +104,9 @@ private:
   PT(PandaNode) load_file(const Filename &filename, const LoaderOptions &options) const;
   PT(PandaNode) try_load_file(const Filename &pathname, const LoaderOptions &options,
                               LoaderFileType *requested_type) const;
+  PT(PandaNode) try_load_uncached_file(const Filename &pathname,
+                                       const LoaderOptions &options,
+                                       LoaderFileType *requested_type) const;
 
   bool save_file(const Filename &filename, const LoaderOptions &options,
                  PandaNode *node) const;
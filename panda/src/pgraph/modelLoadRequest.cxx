@@ -28,10 +28,32 @@ ModelLoadRequest(const std::string &name,
   AsyncTask(name),
   _filename(filename),
   _options(options),
-  _loader(loader)
+  _loader(loader),
+  _stream_cancelled(false)
 {
 }
 
+/**
+ * Cancels the request, along with the loading of its textures if the request
+ * was made with the LF_streaming flag and the model has already been
+ * returned.  Returns true if anything was cancelled.
+ */
+bool ModelLoadRequest::
+cancel() {
+  PT(AsyncFuture) stream_request;
+  {
+    LightMutexHolder holder(_lock);
+    _stream_cancelled = true;
+    stream_request = _stream_request;
+  }
+
+  bool any_cancelled = AsyncTask::cancel();
+  if (stream_request != nullptr && stream_request->cancel()) {
+    any_cancelled = true;
+  }
+  return any_cancelled;
+}
+
 /**
  * Performs the task: that is, loads the one model.
  */
@@ -42,7 +64,29 @@ do_task() {
     Thread::sleep(delay);
   }
 
-  PT(PandaNode) model = _loader->load_sync(_filename, _options);
+  if ((_options.get_flags() & LoaderOptions::LF_streaming) == 0) {
+    PT(PandaNode) model = _loader->load_sync(_filename, _options);
+    set_result(model);
+    return DS_done;
+  }
+
+  // In streaming mode, we only read the texture headers for now, so that the
+  // model can be returned as soon as possible.  The images are then read by
+  // a separate request, which may be interleaved with other requests.
+  LoaderOptions options(_options);
+  options.set_texture_flags(options.get_texture_flags() &
+    ~(LoaderOptions::TF_preload | LoaderOptions::TF_preload_simple));
+
+  PT(PandaNode) model = _loader->load_sync(_filename, options);
+  if (model != nullptr) {
+    LightMutexHolder holder(_lock);
+    if (!_stream_cancelled) {
+      _stream_request = new ModelStreamRequest
+        (std::string("model_stream:") + _filename.get_basename(), model, _loader);
+      _stream_request->set_priority(get_priority());
+      _loader->load_async(_stream_request);
+    }
+  }
   set_result(model);
 
   // Don't continue the task; we're done.
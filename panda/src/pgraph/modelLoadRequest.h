@@ -23,11 +23,18 @@
 #include "pointerTo.h"
 #include "loader.h"
 #include "nodePath.h"
+#include "modelStreamRequest.h"
+#include "lightMutex.h"
+#include "lightMutexHolder.h"
 
 /**
  * A class object that manages a single asynchronous model load request.
  * Create a new ModelLoadRequest, and add it to the loader via load_async(),
  * to begin an asynchronous load.
+ *
+ * If the LF_streaming flag is given in the LoaderOptions, the model is
+ * returned without its texture images, which are loaded afterwards by a
+ * ModelStreamRequest; see get_stream_request().
  */
 class EXPCL_PANDA_PGRAPH ModelLoadRequest : public AsyncTask {
 public:
@@ -46,11 +53,15 @@ PUBLISHED:
   INLINE bool is_ready() const;
   INLINE PandaNode *get_model() const;
 
+  INLINE ModelStreamRequest *get_stream_request() const;
+
   MAKE_PROPERTY(filename, get_filename);
   MAKE_PROPERTY(options, get_options);
   MAKE_PROPERTY(loader, get_loader);
+  MAKE_PROPERTY(stream_request, get_stream_request);
 
 protected:
+  virtual bool cancel();
   virtual DoneStatus do_task();
 
 private:
@@ -58,6 +69,12 @@ private:
   LoaderOptions _options;
   PT(Loader) _loader;
 
+  // Protects the following members, which are only used when the
+  // LF_streaming flag is set.
+  mutable LightMutex _lock;
+  PT(ModelStreamRequest) _stream_request;
+  bool _stream_cancelled;
+
 public:
   static TypeHandle get_class_type() {
     return _type_handle;
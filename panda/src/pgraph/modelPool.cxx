@@ -14,7 +14,7 @@
 #include "modelPool.h"
 #include "loader.h"
 #include "config_pgraph.h"
-#include "lightMutexHolder.h"
+#include "mutexHolder.h"
 #include "virtualFileSystem.h"
 
 
@@ -34,7 +34,7 @@ write(std::ostream &out) {
  */
 bool ModelPool::
 ns_has_model(const Filename &filename) {
-  LightMutexHolder holder(_lock);
+  MutexHolder holder(_lock);
   Models::const_iterator ti;
   ti = _models.find(filename);
   if (ti != _models.end() && (*ti).second != nullptr) {
@@ -55,7 +55,7 @@ ns_get_model(const Filename &filename, bool verify) {
   bool got_cached_model = false;
 
   {
-    LightMutexHolder holder(_lock);
+    MutexHolder holder(_lock);
     Models::const_iterator ti;
     ti = _models.find(filename);
     if (ti != _models.end()) {
@@ -119,8 +119,9 @@ ns_get_model(const Filename &filename, bool verify) {
 ModelRoot *ModelPool::
 ns_load_model(const Filename &filename, const LoaderOptions &options) {
 
-  // First check if it has already been loaded and is still current.
-  PT(ModelRoot) cached_model = ns_get_model(filename, true);
+  // First check if it has already been loaded and is still current, or if
+  // another thread is already loading it.
+  PT(ModelRoot) cached_model = ns_begin_load_model(filename);
   if (cached_model != nullptr) {
     return cached_model;
   }
@@ -149,22 +150,142 @@ ns_load_model(const Filename &filename, const LoaderOptions &options) {
     node->set_fullpath(filename);
   }
 
-  {
-    LightMutexHolder holder(_lock);
+  if (node == nullptr) {
+    // Record the failure too, so that we don't keep trying to load it, unless
+    // another thread has stored something in the meantime.
+    MutexHolder holder(_lock);
+    _models.insert(Models::value_type(filename, nullptr));
+  }
 
-    // Look again, in case someone has just loaded the model in another
-    // thread.
-    Models::const_iterator ti;
-    ti = _models.find(filename);
-    if (ti != _models.end() && (*ti).second != cached_model) {
-      // This model was previously loaded.
+  // This returns the model that another thread stored while we were loading
+  // it, if any, so that all callers get the same one.
+  return ns_end_load_model(filename, node);
+}
+
+/**
+ * The nonstatic implementation of begin_load_model().
+ */
+PT(ModelRoot) ModelPool::
+ns_begin_load_model(const Filename &filename) {
+  // This may need to check the timestamp on disk, so we do it without
+  // holding the lock.
+  PT(ModelRoot) cached_model = ns_get_model(filename, true);
+  if (cached_model != nullptr) {
+    return cached_model;
+  }
+
+  Thread *current_thread = Thread::get_current_thread();
+
+  MutexHolder holder(_lock);
+  bool waited = false;
+  Loading::iterator li = _loading.find(filename);
+  while (li != _loading.end()) {
+    Thread *loading_thread = (*li).second._thread;
+    if (loading_thread == current_thread) {
+      // We are already loading this file further up the stack; don't wait on
+      // ourselves.  The outermost call still owns the entry.
+      ++(*li).second._depth;
+      return nullptr;
+    }
+    if (would_deadlock(loading_thread, current_thread)) {
+      // The other thread is (indirectly) waiting for a file that we are
+      // loading, so waiting for it would never return.  Load it ourselves
+      // instead; the other thread keeps its entry.
+      if (pgraph_cat.is_debug()) {
+        pgraph_cat.debug()
+          << "ModelPool not waiting for " << filename << " to be loaded by "
+          << *loading_thread << ", which is waiting for "
+          << *current_thread << "\n";
+      }
+      return nullptr;
+    }
+    if (pgraph_cat.is_debug()) {
+      pgraph_cat.debug()
+        << "ModelPool waiting for " << filename << " to be loaded by "
+        << *loading_thread << "\n";
+    }
+    _waiting[current_thread] = filename;
+    _cvar.wait();
+    _waiting.erase(current_thread);
+    waited = true;
+    li = _loading.find(filename);
+  }
+
+  if (waited) {
+    // Another thread has just finished loading it.  If it failed, we try
+    // again ourselves, since we may have been given different options.
+    Models::const_iterator ti = _models.find(filename);
+    if (ti != _models.end() && (*ti).second != nullptr) {
       return (*ti).second;
     }
+  }
+
+  LoadingEntry &entry = _loading[filename];
+  entry._thread = current_thread;
+  entry._depth = 1;
+  return nullptr;
+}
 
-    _models[filename] = node;
+/**
+ * The nonstatic implementation of end_load_model().
+ */
+PT(ModelRoot) ModelPool::
+ns_end_load_model(const Filename &filename, ModelRoot *model) {
+  MutexHolder holder(_lock);
+  PT(ModelRoot) result = model;
+  if (model != nullptr) {
+    // Look again, in case someone has just stored the model in another
+    // thread, which happens when we loaded it ourselves to avoid a deadlock.
+    // An older model is one that was found to be out of date.
+    Models::const_iterator ti = _models.find(filename);
+    if (ti != _models.end() && (*ti).second != nullptr &&
+        (*ti).second != model &&
+        (*ti).second->get_timestamp() >= model->get_timestamp()) {
+      result = (*ti).second;
+    } else {
+      _models[filename] = model;
+    }
+  }
+
+  // If another thread owns the entry, this call is ending a load that was
+  // begun to avoid a deadlock, and doesn't affect the entry.
+  Loading::iterator li = _loading.find(filename);
+  if (li != _loading.end() && (*li).second._thread == Thread::get_current_thread()) {
+    if (--(*li).second._depth == 0) {
+      _loading.erase(li);
+      _cvar.notify_all();
+    }
   }
 
-  return node;
+  return result;
+}
+
+/**
+ * Returns true if loading_thread is waiting, directly or through a chain of
+ * other waiting threads, for a file that current_thread is loading.  Assumes
+ * the lock is held.
+ */
+bool ModelPool::
+would_deadlock(Thread *loading_thread, Thread *current_thread) const {
+  // Each thread waits for at most one file, so we can simply follow the
+  // chain.  It can't be longer than the number of waiting threads, unless
+  // there is a cycle that doesn't involve us.
+  Thread *thread = loading_thread;
+  for (size_t i = 0; i <= _waiting.size(); ++i) {
+    Waiting::const_iterator wi = _waiting.find(thread);
+    if (wi == _waiting.end()) {
+      return false;
+    }
+    Loading::const_iterator li = _loading.find((*wi).second);
+    if (li == _loading.end()) {
+      return false;
+    }
+    thread = (*li).second._thread;
+    if (thread == current_thread) {
+      return true;
+    }
+  }
+  return false;
 }
 
 /**
@@ -172,7 +293,7 @@ ns_load_model(const Filename &filename, const LoaderOptions &options) {
  */
 void ModelPool::
 ns_add_model(const Filename &filename, ModelRoot *model) {
-  LightMutexHolder holder(_lock);
+  MutexHolder holder(_lock);
   if (pgraph_cat.is_debug()) {
     pgraph_cat.debug()
       << "ModelPool storing " << model << " for " << filename << "\n";
@@ -186,7 +307,7 @@ ns_add_model(const Filename &filename, ModelRoot *model) {
  */
 void ModelPool::
 ns_release_model(const Filename &filename) {
-  LightMutexHolder holder(_lock);
+  MutexHolder holder(_lock);
   Models::iterator ti;
   ti = _models.find(filename);
   if (ti != _models.end()) {
@@ -199,7 +320,7 @@ ns_release_model(const Filename &filename) {
  */
 void ModelPool::
 ns_add_model(ModelRoot *model) {
-  LightMutexHolder holder(_lock);
+  MutexHolder holder(_lock);
   // We blow away whatever model was there previously, if any.
   _models[model->get_fullpath()] = model;
 }
@@ -209,7 +330,7 @@ ns_add_model(ModelRoot *model) {
  */
 void ModelPool::
 ns_release_model(ModelRoot *model) {
-  LightMutexHolder holder(_lock);
+  MutexHolder holder(_lock);
   Models::iterator ti;
   ti = _models.find(model->get_fullpath());
   if (ti != _models.end()) {
@@ -222,7 +343,7 @@ ns_release_model(ModelRoot *model) {
  */
 void ModelPool::
 ns_release_all_models() {
-  LightMutexHolder holder(_lock);
+  MutexHolder holder(_lock);
   _models.clear();
 }
 
@@ -231,7 +352,7 @@ ns_release_all_models() {
  */
 int ModelPool::
 ns_garbage_collect() {
-  LightMutexHolder holder(_lock);
+  MutexHolder holder(_lock);
 
   int num_released = 0;
   Models new_set;
@@ -260,7 +381,7 @@ ns_garbage_collect() {
  */
 void ModelPool::
 ns_list_contents(std::ostream &out) const {
-  LightMutexHolder holder(_lock);
+  MutexHolder holder(_lock);
 
   out << "model pool contents:\n";
 
@@ -19,7 +19,8 @@
 #include "filename.h"
 #include "modelRoot.h"
 #include "pointerTo.h"
-#include "lightMutex.h"
+#include "pmutex.h"
+#include "conditionVar.h"
 #include "pmap.h"
 #include "loaderOptions.h"
 
@@ -61,6 +62,10 @@ PUBLISHED:
   INLINE static void list_contents();
   static void write(std::ostream &out);
 
+public:
+  INLINE static PT(ModelRoot) begin_load_model(const Filename &filename);
+  INLINE static PT(ModelRoot) end_load_model(const Filename &filename, ModelRoot *model);
+
 private:
   INLINE ModelPool();
 
@@ -74,6 +79,10 @@ private:
   void ns_add_model(ModelRoot *model);
   void ns_release_model(ModelRoot *model);
 
+  PT(ModelRoot) ns_begin_load_model(const Filename &filename);
+  PT(ModelRoot) ns_end_load_model(const Filename &filename, ModelRoot *model);
+  bool would_deadlock(Thread *loading_thread, Thread *current_thread) const;
+
   void ns_release_all_models();
   int ns_garbage_collect();
   void ns_list_contents(std::ostream &out) const;
@@ -82,9 +91,27 @@ private:
 
   static ModelPool *_global_ptr;
 
-  LightMutex _lock;
+  Mutex _lock;
+  ConditionVar _cvar;
   typedef pmap<Filename,  PT(ModelRoot) > Models;
   Models _models;
+
+  // The files that are currently being loaded, and the thread that is
+  // loading each one.  Other threads that want the same file wait on _cvar.
+  // The depth counts the nested begin_load_model() calls for the same file
+  // in the loading thread; the entry is removed when the outermost one ends.
+  class LoadingEntry {
+  public:
+    Thread *_thread;
+    int _depth;
+  };
+  typedef pmap<Filename, LoadingEntry> Loading;
+  Loading _loading;
+
+  // The file that each waiting thread is waiting for, so that we can tell
+  // when two threads would end up waiting for each other.
+  typedef pmap<Thread *, Filename> Waiting;
+  Waiting _waiting;
 };
 
 #include "modelPool.I"
@@ -0,0 +1,82 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file modelStreamRequest.cxx
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#include "modelStreamRequest.h"
+#include "nodePath.h"
+#include "textureCollection.h"
+#include "config_pgraph.h"
+
+#include <algorithm>
+
+TypeHandle ModelStreamRequest::_type_handle;
+
+/**
+ * Sorts textures so that the smallest images are loaded first.
+ */
+static bool
+compare_texture_size(const PT(Texture) &a, const PT(Texture) &b) {
+  return a->get_expected_ram_image_size() < b->get_expected_ram_image_size();
+}
+
+/**
+ * Collects the textures of the indicated model that don't have their images
+ * loaded yet.  The request must then be added to the loader via
+ * load_async().
+ */
+ModelStreamRequest::
+ModelStreamRequest(const std::string &name, PandaNode *model, Loader *loader) :
+  AsyncTask(name),
+  _model(model),
+  _loader(loader),
+  _num_loaded(0)
+{
+  TextureCollection textures = NodePath(model).find_all_textures();
+  int num_textures = textures.get_num_textures();
+  for (int i = 0; i < num_textures; ++i) {
+    Texture *tex = textures.get_texture(i);
+    if (!tex->has_ram_image() && tex->might_have_ram_image()) {
+      _textures.push_back(tex);
+    }
+  }
+  std::stable_sort(_textures.begin(), _textures.end(), compare_texture_size);
+}
+
+/**
+ * Performs the task: that is, loads the next texture.
+ */
+AsyncTask::DoneStatus ModelStreamRequest::
+do_task() {
+  size_t n = (size_t)AtomicAdjust::get(_num_loaded);
+  if (n < _textures.size()) {
+    Texture *tex = _textures[n];
+
+    // The renderer might have needed it in the meantime.
+    if (!tex->has_ram_image()) {
+      if (loader_cat.is_debug()) {
+        loader_cat.debug()
+          << "Streaming " << tex->get_name() << " for " << *_model << "\n";
+      }
+      tex->get_ram_image();
+    }
+    AtomicAdjust::inc(_num_loaded);
+    ++n;
+  }
+
+  if (n < _textures.size()) {
+    // Give the other requests on the chain a chance before the next one.
+    return DS_cont;
+  }
+
+  set_result(_model);
+  return DS_done;
+}
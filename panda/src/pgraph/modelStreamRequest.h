@@ -0,0 +1,89 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file modelStreamRequest.h
+ * @author jmarsh
+ * @date 2026-10-16
+ */
+
+#ifndef MODELSTREAMREQUEST_H
+#define MODELSTREAMREQUEST_H
+
+#include "pandabase.h"
+
+#include "asyncTask.h"
+#include "pandaNode.h"
+#include "pointerTo.h"
+#include "texture.h"
+#include "loader.h"
+#include "pvector.h"
+
+/**
+ * The second half of a streaming model load.  When a ModelLoadRequest is
+ * made with the LF_streaming flag, the model is returned as soon as its node
+ * hierarchy has been read, with only the headers of its textures.  The
+ * ModelLoadRequest then queues one of these, which reads the texture images
+ * in the background, one at a time, smallest first.  Each texture becomes
+ * available to the renderer as soon as its image has been read.
+ *
+ * This request runs on the same task chain and with the same priority as the
+ * ModelLoadRequest that created it.  Cancelling the ModelLoadRequest also
+ * cancels this request.
+ */
+class EXPCL_PANDA_PGRAPH ModelStreamRequest : public AsyncTask {
+public:
+  ALLOC_DELETED_CHAIN(ModelStreamRequest);
+
+PUBLISHED:
+  explicit ModelStreamRequest(const std::string &name, PandaNode *model,
+                              Loader *loader);
+
+  INLINE PandaNode *get_model() const;
+  INLINE Loader *get_loader() const;
+
+  INLINE int get_num_textures() const;
+  INLINE int get_num_loaded_textures() const;
+  INLINE bool is_ready() const;
+
+  MAKE_PROPERTY(model, get_model);
+  MAKE_PROPERTY(loader, get_loader);
+  MAKE_PROPERTY(num_textures, get_num_textures);
+  MAKE_PROPERTY(num_loaded_textures, get_num_loaded_textures);
+
+protected:
+  virtual DoneStatus do_task();
+
+private:
+  PT(PandaNode) _model;
+  PT(Loader) _loader;
+
+  typedef pvector<PT(Texture)> Textures;
+  Textures _textures;
+  AtomicAdjust::Integer _num_loaded;
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    AsyncTask::init_type();
+    register_type(_type_handle, "ModelStreamRequest",
+                  AsyncTask::get_class_type());
+    }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+#include "modelStreamRequest.I"
+
+#endif
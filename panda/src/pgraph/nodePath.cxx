@@ -5570,6 +5570,54 @@ flatten_strong() {
   return num_removed;
 }
 
+/**
+ * Reorders the triangles at this node and below for better use of the
+ * post-transform vertex cache of the graphics hardware, and renumbers the
+ * vertices in the order they are used.  If reduce_overdraw is true, the
+ * triangles are also ordered so that the outward-facing parts of each mesh
+ * are drawn first.  See SceneGraphReducer::optimize_vertex_cache().
+ *
+ * This is best done after any flattening, for instance when preparing models
+ * for distribution.  Returns the number of GeomNodes that were processed.
+ */
+int NodePath::
+optimize_vertex_cache(bool reduce_overdraw) {
+  nassertr_always(!is_empty(), 0);
+  SceneGraphReducer gr;
+  return gr.optimize_vertex_cache(node(), reduce_overdraw);
+}
+
+/**
+ * Returns the average cache miss ratio (ACMR) of the triangles at this node
+ * and below: the average number of vertices per triangle that miss the
+ * vertex cache, as simulated with vertex-cache-size entries.  Lower is
+ * better; 3 means that no vertices are reused at all.  Returns 0 if there
+ * are no triangles.
+ */
+PN_stdfloat NodePath::
+calc_acmr() const {
+  nassertr_always(!is_empty(), 0);
+  SceneGraphReducer gr;
+  return gr.calc_acmr(node());
+}
+
+/**
+ * Reduces the number of triangles at this node and below to approximately
+ * target_ratio times the original number, while preserving the shape as well
+ * as possible.  If max_error is not negative, no surface is moved by more
+ * than this distance, which may leave more triangles than requested.  See
+ * SceneGraphReducer::simplify().
+ *
+ * Returns an estimate of the greatest distance by which a surface has moved.
+ * See also LODNode::make_simplified_lod().
+ */
+PN_stdfloat NodePath::
+simplify(PN_stdfloat target_ratio, PN_stdfloat max_error) {
+  nassertr_always(!is_empty(), 0);
+  SceneGraphReducer gr;
+  return gr.simplify(node(), target_ratio, max_error);
+}
+
 /**
  * Removes textures from Geoms at this node and below by applying the texture
  * colors to the vertices.  This is primarily useful to simplify a low-LOD
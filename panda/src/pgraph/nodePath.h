@@ -907,6 +907,9 @@ PUBLISHED:
   int flatten_light();
   int flatten_medium();
   int flatten_strong();
+  int optimize_vertex_cache(bool reduce_overdraw = true);
+  PN_stdfloat calc_acmr() const;
+  PN_stdfloat simplify(PN_stdfloat target_ratio, PN_stdfloat max_error = -1);
   void apply_texture_colors();
   INLINE int clear_model_nodes();
 
@@ -13,6 +13,7 @@
 #include "modelFlattenRequest.cxx"
 #include "modelLoadRequest.cxx"
 #include "modelSaveRequest.cxx"
+#include "modelStreamRequest.cxx"
 #include "modelNode.cxx"
 #include "modelPool.cxx"
 #include "modelRoot.cxx"
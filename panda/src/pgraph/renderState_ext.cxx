@@ -120,22 +120,22 @@ get_states() {
   extern struct Dtool_PyTypedObject Dtool_RenderState;
   LightReMutexHolder holder(*RenderState::_states_lock);
 
-  size_t num_states = RenderState::_states.get_num_entries();
-  PyObject *list = PyList_New(num_states);
-  size_t i = 0;
+  PyObject *list = PyList_New(0);
+  for (size_t shi = 0; shi < RenderState::num_states_shards; ++shi) {
+    const RenderState::StatesShard &shard = RenderState::_states_shards[shi];
+    LightReMutexHolder shard_holder(shard._lock);
 
-  size_t size = RenderState::_states.get_num_entries();
-  for (size_t si = 0; si < size; ++si) {
-    const RenderState *state = RenderState::_states.get_key(si);
-    state->ref();
-    PyObject *a =
-      DTool_CreatePyInstanceTyped((void *)state, Dtool_RenderState,
-                                  true, true, state->get_type_index());
-    nassertr(i < num_states, list);
-    PyList_SET_ITEM(list, i, a);
-    ++i;
+    size_t size = shard._states.get_num_entries();
+    for (size_t si = 0; si < size; ++si) {
+      const RenderState *state = shard._states.get_key(si);
+      state->ref();
+      PyObject *a =
+        DTool_CreatePyInstanceTyped((void *)state, Dtool_RenderState,
+                                    true, true, state->get_type_index());
+      PyList_Append(list, a);
+      Py_DECREF(a);
+    }
   }
-  nassertr(i == num_states, list);
   return list;
 }
 
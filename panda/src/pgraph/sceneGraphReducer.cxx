@@ -22,8 +22,10 @@
 #include "geomNode.h"
 #include "config_gobj.h"
 #include "thread.h"
+#include "vector_int.h"
 
 PStatCollector SceneGraphReducer::_flatten_collector("*:Flatten:flatten");
+PStatCollector SceneGraphReducer::_flatten_parallel_collector("*:Flatten:flatten:parallel");
 PStatCollector SceneGraphReducer::_apply_collector("*:Flatten:apply");
 PStatCollector SceneGraphReducer::_remove_column_collector("*:Flatten:remove column");
 PStatCollector SceneGraphReducer::_compatible_state_collector("*:Flatten:compatible colors");
@@ -31,6 +33,8 @@ PStatCollector SceneGraphReducer::_collect_collector("*:Flatten:collect");
 PStatCollector SceneGraphReducer::_make_nonindexed_collector("*:Flatten:make nonindexed");
 PStatCollector SceneGraphReducer::_unify_collector("*:Flatten:unify");
 PStatCollector SceneGraphReducer::_remove_unused_collector("*:Flatten:remove unused vertices");
+PStatCollector SceneGraphReducer::_optimize_vertex_cache_collector("*:Flatten:optimize vertex cache");
+PStatCollector SceneGraphReducer::_simplify_collector("*:Flatten:simplify");
 PStatCollector SceneGraphReducer::_premunge_collector("*:Premunge");
 
 /**
@@ -91,17 +95,10 @@ flatten(PandaNode *root, int combine_siblings_bits) {
 
   do {
     num_pass_nodes = 0;
+    begin_progress("flatten", root);
+    add_progress();
 
-    // Get a copy of the children list, so we don't have to worry about self-
-    // modifications.
-    PandaNode::Children cr = root->get_children();
-
-    // Now visit each of the children in turn.
-    int num_children = cr.get_num_children();
-    for (int i = 0; i < num_children; i++) {
-      PT(PandaNode) child_node = cr.get_child(i);
-      num_pass_nodes += r_flatten(root, child_node, combine_siblings_bits);
-    }
+    num_pass_nodes += flatten_children(root, combine_siblings_bits);
 
     if (combine_siblings_bits != 0 &&
         root->get_num_children() >= 2 &&
@@ -116,6 +113,7 @@ flatten(PandaNode *root, int combine_siblings_bits) {
     // could convert cousins into siblings, which may get flattened next pass.
   } while ((combine_siblings_bits & CS_recurse) != 0 && num_pass_nodes != 0);
 
+  end_progress();
   return num_total_nodes;
 }
 
@@ -202,6 +200,72 @@ remove_unused_vertices(PandaNode *root) {
   Thread::consider_yield();
 }
 
+/**
+ * Reorders the triangles of all GeomNodes at this level and below, so that
+ * the post-transform vertex cache of the graphics hardware is used more
+ * effectively, and then renumbers the vertices in the order in which they
+ * are used, for better locality when they are fetched.  If reduce_overdraw
+ * is true, the triangles are also grouped into clusters that are ordered to
+ * reduce overdraw.  See GeomPrimitive::optimize_vertex_cache().
+ *
+ * Triangle strips and fans are decomposed into triangles in the process.  It
+ * is best to call this after flattening, since combining Geoms afterwards
+ * might undo the benefit.
+ *
+ * Returns the number of GeomNodes that were processed.  Use calc_acmr() to
+ * see the effect.
+ */
+int SceneGraphReducer::
+optimize_vertex_cache(PandaNode *root, bool reduce_overdraw) {
+  nassertr(check_live_flatten(root), 0);
+  PStatTimer timer(_optimize_vertex_cache_collector);
+
+  int num_changed = r_optimize_vertex_cache(root, reduce_overdraw, _transformer);
+  _transformer.finish_apply();
+  return num_changed;
+}
+
+/**
+ * Returns the average cache miss ratio (ACMR) of all of the triangles at this
+ * level and below, which is the average number of vertices per triangle that
+ * need to be processed by the vertex shader.  Returns 0 if there are no
+ * triangles.  See GeomPrimitive::calc_acmr().
+ */
+PN_stdfloat SceneGraphReducer::
+calc_acmr(PandaNode *root) {
+  PN_stdfloat num_misses = 0;
+  int num_triangles = 0;
+  r_calc_acmr(root, num_misses, num_triangles);
+  if (num_triangles == 0) {
+    return 0;
+  }
+  return num_misses / (PN_stdfloat)num_triangles;
+}
+
+/**
+ * Reduces the number of triangles of all GeomNodes at this level and below
+ * to approximately target_ratio times the original number, by collapsing
+ * the edges whose removal changes the shape the least.  If max_error is not
+ * negative, the surface is not allowed to move by more than this distance, so
+ * that fewer triangles may be removed.  See Geom::simplify_in_place().
+ *
+ * The error is measured in the coordinate space of each GeomNode; it may be
+ * useful to apply_attribs() the transforms first.  Vertices that are no
+ * longer used are removed from the vertex data afterwards.
+ *
+ * Returns an estimate of the greatest distance by which any surface has
+ * moved.
+ */
+PN_stdfloat SceneGraphReducer::
+simplify(PandaNode *root, PN_stdfloat target_ratio, PN_stdfloat max_error) {
+  nassertr(check_live_flatten(root), 0);
+  PStatTimer timer(_simplify_collector);
+
+  PN_stdfloat error = r_simplify(root, target_ratio, max_error, _transformer);
+  _transformer.finish_apply();
+  return error;
+}
+
 /**
  * In a non-release build, returns false if the node is correctly not in a
  * live scene graph.  (Calling flatten on a node that is part of a live scene
@@ -232,6 +296,8 @@ check_live_flatten(PandaNode *node) {
 void SceneGraphReducer::
 r_apply_attribs(PandaNode *node, const AccumulatedAttribs &attribs,
                 int attrib_types, GeomTransformer &transformer) {
+  add_progress();
+
   if (pgraph_cat.is_spam()) {
     pgraph_cat.spam()
       << "r_apply_attribs(" << *node << "), node's attribs are:\n";
@@ -368,12 +434,91 @@ r_apply_attribs(PandaNode *node, const AccumulatedAttribs &attribs,
 }
 
 
+/**
+ * Calls r_flatten() on each of the children of the indicated node, and
+ * returns the total number of nodes removed.
+ *
+ * If there are worker threads and enough children, the children whose
+ * subgraphs are not shared with the rest of the scene graph are flattened
+ * concurrently, and the remaining children are flattened afterwards on the
+ * calling thread.  Since each worker only modifies nodes within its own
+ * subgraph, and the children are replaced within parent_node in their
+ * original order, the result is the same as flattening them one at a time.
+ */
+int SceneGraphReducer::
+flatten_children(PandaNode *parent_node, int combine_siblings_bits) {
+  // Get a copy of the children list, so we don't have to worry about self-
+  // modifications.
+  PandaNode::Children cr = parent_node->get_children();
+  int num_children = cr.get_num_children();
+
+  int num_nodes = 0;
+
+  if (!_in_parallel && _job_runner.is_parallel() &&
+      num_children >= flatten_parallel_min_children) {
+    vector_int exclusive;
+    for (int i = 0; i < num_children; ++i) {
+      if (r_is_exclusive(cr.get_child(i))) {
+        exclusive.push_back(i);
+      }
+    }
+
+    int num_exclusive = (int)exclusive.size();
+    if (num_exclusive >= 2) {
+      PStatTimer timer(_flatten_parallel_collector);
+
+      // The workers leave it to us to replace a collapsed child within
+      // parent_node, so that parent_node is only modified by this thread.
+      vector_int job_nodes(num_exclusive, 0);
+      pvector<PT(PandaNode)> replacements(num_exclusive);
+
+      _in_parallel = true;
+      _job_runner.run(num_exclusive, [&] (int job, Thread *current_thread) {
+        PT(PandaNode) child_node = cr.get_child(exclusive[job]);
+        job_nodes[job] = r_flatten(parent_node, child_node,
+                                   combine_siblings_bits, &replacements[job]);
+      });
+      _in_parallel = false;
+
+      pvector<bool> done(num_children, false);
+      for (int j = 0; j < num_exclusive; ++j) {
+        num_nodes += job_nodes[j];
+        if (replacements[j] != nullptr) {
+          replacements[j]->replace_node(cr.get_child(exclusive[j]));
+        }
+        done[exclusive[j]] = true;
+      }
+
+      for (int i = 0; i < num_children; ++i) {
+        if (!done[i]) {
+          PT(PandaNode) child_node = cr.get_child(i);
+          num_nodes += r_flatten(parent_node, child_node, combine_siblings_bits);
+        }
+      }
+      return num_nodes;
+    }
+  }
+
+  // Visit each of the children in turn.
+  for (int i = 0; i < num_children; ++i) {
+    PT(PandaNode) child_node = cr.get_child(i);
+    num_nodes += r_flatten(parent_node, child_node, combine_siblings_bits);
+  }
+  return num_nodes;
+}
+
 /**
  * The recursive implementation of flatten().
+ *
+ * If deferred_replacement is not NULL and parent_node is collapsed with its
+ * only child, the resulting node is not put in place of parent_node, but
+ * stored there instead, for the caller to attach later.
  */
 int SceneGraphReducer::
 r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
-          int combine_siblings_bits) {
+          int combine_siblings_bits, PT(PandaNode) *deferred_replacement) {
+  add_progress();
+
   if (pgraph_cat.is_spam()) {
     pgraph_cat.spam()
       << "SceneGraphReducer::r_flatten(" << *grandparent_node << ", "
@@ -420,14 +565,7 @@ r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
     }
 
     // First, recurse on each of the children.
-    {
-      PandaNode::Children cr = parent_node->get_children();
-      int num_children = cr.get_num_children();
-      for (int i = 0; i < num_children; i++) {
-        PT(PandaNode) child_node = cr.get_child(i);
-        num_nodes += r_flatten(parent_node, child_node, combine_siblings_bits);
-      }
-    }
+    num_nodes += flatten_children(parent_node, combine_siblings_bits);
 
     // Now that the above loop has removed some children, the child list saved
     // above is no longer accurate, so hereafter we must ask the node for its
@@ -451,7 +589,8 @@ r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
         // Ok, do it.
         parent_node->remove_child(child_node);
 
-        if (do_flatten_child(grandparent_node, parent_node, child_node)) {
+        if (do_flatten_child(grandparent_node, parent_node, child_node,
+                             deferred_replacement)) {
           // Done!
           num_nodes++;
         } else {
@@ -646,10 +785,14 @@ consider_siblings(PandaNode *parent_node, PandaNode *child1,
  * Collapses together the indicated parent node and child node and leaves the
  * result attached to the grandparent.  The return value is true if the node
  * is successfully collapsed, false if we chickened out.
+ *
+ * If deferred_replacement is not NULL, the result is stored there rather than
+ * attached to the grandparent; the caller must then replace parent_node with
+ * it.
  */
 bool SceneGraphReducer::
 do_flatten_child(PandaNode *grandparent_node, PandaNode *parent_node,
-                 PandaNode *child_node) {
+                 PandaNode *child_node, PT(PandaNode) *deferred_replacement) {
   if (pgraph_cat.is_spam()) {
     pgraph_cat.spam()
       << "Collapsing " << *parent_node << " and " << *child_node << "\n";
@@ -668,7 +811,11 @@ do_flatten_child(PandaNode *grandparent_node, PandaNode *parent_node,
   choose_name(new_parent, parent_node, child_node);
 
   new_parent->replace_node(child_node);
-  new_parent->replace_node(parent_node);
+  if (deferred_replacement != nullptr) {
+    *deferred_replacement = new_parent;
+  } else {
+    new_parent->replace_node(parent_node);
+  }
 
   return true;
 }
@@ -800,6 +947,7 @@ r_make_compatible_state(PandaNode *node, GeomTransformer &transformer) {
 int SceneGraphReducer::
 r_collect_vertex_data(PandaNode *node, int collect_bits,
                       GeomTransformer &transformer, bool format_only) {
+  add_progress();
   int num_adjusted = 0;
 
   int this_node_bits = 0;
@@ -931,6 +1079,82 @@ r_register_vertices(PandaNode *node, GeomTransformer &transformer) {
   }
 }
 
+/**
+ * The recursive implementation of optimize_vertex_cache().
+ */
+int SceneGraphReducer::
+r_optimize_vertex_cache(PandaNode *node, bool reduce_overdraw,
+                        GeomTransformer &transformer) {
+  int num_changed = 0;
+  if (node->is_geom_node()) {
+    GeomNode *geom_node = DCAST(GeomNode, node);
+    if (transformer.optimize_vertex_cache(geom_node, reduce_overdraw)) {
+      ++num_changed;
+    }
+  }
+
+  PandaNode::Children children = node->get_children();
+  int num_children = children.get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    num_changed +=
+      r_optimize_vertex_cache(children.get_child(i), reduce_overdraw, transformer);
+  }
+  Thread::consider_yield();
+  return num_changed;
+}
+
+/**
+ * The recursive implementation of calc_acmr().
+ */
+void SceneGraphReducer::
+r_calc_acmr(PandaNode *node, PN_stdfloat &num_misses, int &num_triangles) {
+  if (node->is_geom_node()) {
+    GeomNode *geom_node = DCAST(GeomNode, node);
+    int num_geoms = geom_node->get_num_geoms();
+    for (int gi = 0; gi < num_geoms; ++gi) {
+      CPT(Geom) geom = geom_node->get_geom(gi);
+      int num_primitives = geom->get_num_primitives();
+      for (int pi = 0; pi < num_primitives; ++pi) {
+        CPT(GeomPrimitive) prim = geom->get_primitive(pi);
+        PN_stdfloat acmr = prim->calc_acmr();
+        if (acmr > 0) {
+          int num_faces = prim->get_num_faces();
+          num_misses += acmr * num_faces;
+          num_triangles += num_faces;
+        }
+      }
+    }
+  }
+
+  PandaNode::Children children = node->get_children();
+  int num_children = children.get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    r_calc_acmr(children.get_child(i), num_misses, num_triangles);
+  }
+}
+
+/**
+ * The recursive implementation of simplify().
+ */
+PN_stdfloat SceneGraphReducer::
+r_simplify(PandaNode *node, PN_stdfloat target_ratio, PN_stdfloat max_error,
+           GeomTransformer &transformer) {
+  PN_stdfloat error = 0;
+  if (node->is_geom_node()) {
+    GeomNode *geom_node = DCAST(GeomNode, node);
+    error = transformer.simplify(geom_node, target_ratio, max_error);
+  }
+
+  PandaNode::Children children = node->get_children();
+  int num_children = children.get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    error = std::max(error, r_simplify(children.get_child(i), target_ratio,
+                                       max_error, transformer));
+  }
+  Thread::consider_yield();
+  return error;
+}
+
 /**
  * The recursive implementation of decompose().
  */
@@ -973,3 +1197,54 @@ r_premunge(PandaNode *node, const RenderState *state) {
     r_premunge(stashed.get_stashed(i), next_state);
   }
 }
+
+/**
+ * Returns true if the indicated node and all of the nodes below it, including
+ * stashed nodes, have only one parent, so that the subgraph may be flattened
+ * without affecting any other part of the scene graph.
+ */
+bool SceneGraphReducer::
+r_is_exclusive(PandaNode *node) {
+  if (node->get_num_parents() != 1) {
+    return false;
+  }
+
+  PandaNode::Children children = node->get_children();
+  int num_children = children.get_num_children();
+  for (int i = 0; i < num_children; ++i) {
+    if (!r_is_exclusive(children.get_child(i))) {
+      return false;
+    }
+  }
+
+  PandaNode::Stashed stashed = node->get_stashed();
+  int num_stashed = stashed.get_num_stashed();
+  for (int i = 0; i < num_stashed; ++i) {
+    if (!r_is_exclusive(stashed.get_stashed(i))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Resets the progress counters for a new operation that will visit each of
+ * the nodes at the indicated root and below.
+ */
+void SceneGraphReducer::
+begin_progress(const char *phase, PandaNode *root) {
+  AtomicAdjust::set(_progress_done, 0);
+  AtomicAdjust::set(_progress_total, root->count_num_descendants() + 1);
+  AtomicAdjust::set_ptr(_progress_phase, (void *)phase);
+}
+
+/**
+ * Marks the current operation as finished.
+ */
+void SceneGraphReducer::
+end_progress() {
+  AtomicAdjust::set_ptr(_progress_phase, nullptr);
+  AtomicAdjust::set(_progress_total, 0);
+  AtomicAdjust::set(_progress_done, 0);
+}
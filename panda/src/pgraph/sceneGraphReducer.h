@@ -25,6 +25,9 @@
 #include "typedObject.h"
 #include "pointerTo.h"
 #include "graphicsStateGuardianBase.h"
+#include "parallelJobRunner.h"
+#include "atomicAdjust.h"
+#include "config_pgraph.h"
 
 class PandaNode;
 
@@ -120,23 +123,33 @@ PUBLISHED:
   INLINE void set_combine_radius(PN_stdfloat combine_radius);
   INLINE PN_stdfloat get_combine_radius() const;
 
-  INLINE void apply_attribs(PandaNode *node, int attrib_types = ~(TT_clip_plane | TT_cull_face | TT_apply_texture_color));
+  INLINE void set_num_threads(int num_threads);
+  INLINE int get_num_threads() const;
+
+  INLINE std::string get_progress_phase() const;
+  INLINE PN_stdfloat get_progress() const;
+
+  BLOCKING INLINE void apply_attribs(PandaNode *node, int attrib_types = ~(TT_clip_plane | TT_cull_face | TT_apply_texture_color));
   INLINE void apply_attribs(PandaNode *node, const AccumulatedAttribs &attribs,
                             int attrib_types, GeomTransformer &transformer);
 
-  int flatten(PandaNode *root, int combine_siblings_bits);
+  BLOCKING int flatten(PandaNode *root, int combine_siblings_bits);
 
   int remove_column(PandaNode *root, const InternalName *column);
 
   int make_compatible_state(PandaNode *root);
 
-  INLINE int make_compatible_format(PandaNode *root, int collect_bits = ~0);
+  BLOCKING INLINE int make_compatible_format(PandaNode *root, int collect_bits = ~0);
   void decompose(PandaNode *root);
 
-  INLINE int collect_vertex_data(PandaNode *root, int collect_bits = ~0);
+  BLOCKING INLINE int collect_vertex_data(PandaNode *root, int collect_bits = ~0);
   INLINE int make_nonindexed(PandaNode *root, int nonindexed_bits = ~0);
   void unify(PandaNode *root, bool preserve_order);
   void remove_unused_vertices(PandaNode *root);
+  int optimize_vertex_cache(PandaNode *root, bool reduce_overdraw = true);
+  PN_stdfloat calc_acmr(PandaNode *root);
+  PN_stdfloat simplify(PandaNode *root, PN_stdfloat target_ratio,
+                       PN_stdfloat max_error = -1);
 
   INLINE void premunge(PandaNode *root, const RenderState *initial_state);
   bool check_live_flatten(PandaNode *node);
@@ -145,8 +158,10 @@ protected:
   void r_apply_attribs(PandaNode *node, const AccumulatedAttribs &attribs,
                        int attrib_types, GeomTransformer &transformer);
 
+  int flatten_children(PandaNode *parent_node, int combine_siblings_bits);
   int r_flatten(PandaNode *grandparent_node, PandaNode *parent_node,
-                int combine_siblings_bits);
+                int combine_siblings_bits,
+                PT(PandaNode) *deferred_replacement = nullptr);
   int flatten_siblings(PandaNode *parent_node,
                        int combine_siblings_bits);
 
@@ -156,7 +171,8 @@ protected:
                          PandaNode *child2);
 
   bool do_flatten_child(PandaNode *grandparent_node,
-                        PandaNode *parent_node, PandaNode *child_node);
+                        PandaNode *parent_node, PandaNode *child_node,
+                        PT(PandaNode) *deferred_replacement = nullptr);
 
   PandaNode *do_flatten_siblings(PandaNode *parent_node,
                                  PandaNode *child1, PandaNode *child2);
@@ -176,16 +192,39 @@ protected:
   int r_make_nonindexed(PandaNode *node, int collect_bits);
   void r_unify(PandaNode *node, int max_indices, bool preserve_order);
   void r_register_vertices(PandaNode *node, GeomTransformer &transformer);
+  int r_optimize_vertex_cache(PandaNode *node, bool reduce_overdraw,
+                              GeomTransformer &transformer);
+  void r_calc_acmr(PandaNode *node, PN_stdfloat &num_misses,
+                   int &num_triangles);
+  PN_stdfloat r_simplify(PandaNode *node, PN_stdfloat target_ratio,
+                         PN_stdfloat max_error, GeomTransformer &transformer);
   void r_decompose(PandaNode *node);
 
   void r_premunge(PandaNode *node, const RenderState *state);
 
+  static bool r_is_exclusive(PandaNode *node);
+
+  void begin_progress(const char *phase, PandaNode *root);
+  INLINE void add_progress();
+  void end_progress();
+
 private:
   PT(GraphicsStateGuardianBase) _gsg;
   PN_stdfloat _combine_radius;
+
+  // This must be declared before _transformer, which refers to it.
+  ParallelJobRunner _job_runner;
+  bool _in_parallel;
   GeomTransformer _transformer;
 
+  // These describe the operation in progress.  They are updated atomically,
+  // so that they may be queried from another thread.
+  TVOLATILE AtomicAdjust::Pointer _progress_phase;
+  TVOLATILE AtomicAdjust::Integer _progress_done;
+  TVOLATILE AtomicAdjust::Integer _progress_total;
+
   static PStatCollector _flatten_collector;
+  static PStatCollector _flatten_parallel_collector;
   static PStatCollector _apply_collector;
   static PStatCollector _remove_column_collector;
   static PStatCollector _compatible_state_collector;
@@ -193,6 +232,8 @@ private:
   static PStatCollector _make_nonindexed_collector;
   static PStatCollector _unify_collector;
   static PStatCollector _remove_unused_collector;
+  static PStatCollector _optimize_vertex_cache_collector;
+  static PStatCollector _simplify_collector;
   static PStatCollector _premunge_collector;
 };
 
@@ -0,0 +1,43 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file stateLockHolder.h
+ * @author jmarsh
+ * @date 2026-10-15
+ */
+
+#ifndef STATELOCKHOLDER_H
+#define STATELOCKHOLDER_H
+
+#include "pandabase.h"
+#include "lightReMutex.h"
+#include "pStatCollector.h"
+
+/**
+ * Similar to LightReMutexHolder, but if the mutex is already held by another
+ * thread, the time spent waiting for it is charged to the indicated
+ * PStatCollector.  This is used by the TransformState and RenderState caches
+ * to measure the contention on their locks.
+ */
+class EXPCL_PANDA_PGRAPH StateLockHolder {
+public:
+  INLINE StateLockHolder(const LightReMutex &mutex, PStatCollector &wait_pcollector);
+  StateLockHolder(const StateLockHolder &copy) = delete;
+  INLINE ~StateLockHolder();
+
+  StateLockHolder &operator = (const StateLockHolder &copy) = delete;
+
+private:
+#if defined(HAVE_THREADS) || defined(DEBUG_THREADS)
+  LightReMutex *_mutex;
+#endif
+};
+
+#include "stateLockHolder.I"
+
+#endif
@@ -22,20 +22,22 @@
 #include "config_pgraph.h"
 #include "lightReMutexHolder.h"
 #include "lightMutexHolder.h"
+#include "stateLockHolder.h"
 #include "thread.h"
 
 using std::ostream;
 
 LightReMutex *TransformState::_states_lock = nullptr;
-TransformState::States TransformState::_states;
+TransformState::StatesShard *TransformState::_states_shards = nullptr;
 CPT(TransformState) TransformState::_identity_state;
 CPT(TransformState) TransformState::_invalid_state;
 UpdateSeq TransformState::_last_cycle_detect;
-size_t TransformState::_garbage_index = 0;
 bool TransformState::_uniquify_matrix = true;
 
 PStatCollector TransformState::_cache_update_pcollector("*:State Cache:Update");
 PStatCollector TransformState::_garbage_collect_pcollector("*:State Cache:Garbage Collect");
+PStatCollector TransformState::_cache_lock_wait_pcollector("*:State Cache:Lock Wait:Cache");
+PStatCollector TransformState::_shard_lock_wait_pcollector("*:State Cache:Lock Wait:States");
 PStatCollector TransformState::_transform_compose_pcollector("*:State Cache:Compose Transform");
 PStatCollector TransformState::_transform_invert_pcollector("*:State Cache:Invert Transform");
 PStatCollector TransformState::_transform_calc_pcollector("*:State Cache:Calc Components");
@@ -600,7 +602,7 @@ compose(const TransformState *other) const {
     return do_compose(other);
   }
 
-  LightReMutexHolder holder(*_states_lock);
+  StateLockHolder holder(*_states_lock, _cache_lock_wait_pcollector);
 
   // Is this composition already cached?
   int index = _composition_cache.find(other);
@@ -707,7 +709,7 @@ invert_compose(const TransformState *other) const {
     return do_invert_compose(other);
   }
 
-  LightReMutexHolder holder(*_states_lock);
+  StateLockHolder holder(*_states_lock, _cache_lock_wait_pcollector);
 
   int index = _invert_composition_cache.find(other);
   if (index != -1) {
@@ -795,8 +797,11 @@ unref() const {
   // We always have to grab the lock, since we will definitely need to be
   // holding it if we happen to drop the reference count to 0. Having to grab
   // the lock at every call to unref() is a big limiting factor on
-  // parallelization.
-  LightReMutexHolder holder(*_states_lock);
+  // parallelization.  We also need our shard, so that no other thread can
+  // find us in the state set while we are being released from it.
+  StateLockHolder holder(*_states_lock, _cache_lock_wait_pcollector);
+  StateLockHolder shard_holder(get_states_shard(this)._lock,
+                               _shard_lock_wait_pcollector);
 
   if (auto_break_cycles && uniquify_transforms) {
     if (get_cache_ref_count() > 0 &&
@@ -986,8 +991,13 @@ write_composition_cache(ostream &out, int indent_level) const {
  */
 int TransformState::
 get_num_states() {
-  LightReMutexHolder holder(*_states_lock);
-  return _states.get_num_entries();
+  size_t num_states = 0;
+  for (size_t shi = 0; shi < num_states_shards; ++shi) {
+    const StatesShard &shard = _states_shards[shi];
+    LightReMutexHolder shard_holder(shard._lock);
+    num_states += shard._states.get_num_entries();
+  }
+  return (int)num_states;
 }
 
 /**
@@ -1013,33 +1023,38 @@ get_num_unused_states() {
   typedef pmap<const TransformState *, int> StateCount;
   StateCount state_count;
 
-  size_t size = _states.get_num_entries();
-  for (size_t si = 0; si < size; ++si) {
-    const TransformState *state = _states.get_key(si);
-
-    size_t i;
-    size_t cache_size = state->_composition_cache.get_num_entries();
-    for (i = 0; i < cache_size; ++i) {
-      const TransformState *result = state->_composition_cache.get_data(i)._result;
-      if (result != nullptr && result != state) {
-        // Here's a TransformState that's recorded in the cache.  Count it.
-        std::pair<StateCount::iterator, bool> ir =
-          state_count.insert(StateCount::value_type(result, 1));
-        if (!ir.second) {
-          // If the above insert operation fails, then it's already in the
-          // cache; increment its value.
-          (*(ir.first)).second++;
+  for (size_t shi = 0; shi < num_states_shards; ++shi) {
+    const StatesShard &shard = _states_shards[shi];
+    LightReMutexHolder shard_holder(shard._lock);
+
+    size_t size = shard._states.get_num_entries();
+    for (size_t si = 0; si < size; ++si) {
+      const TransformState *state = shard._states.get_key(si);
+
+      size_t i;
+      size_t cache_size = state->_composition_cache.get_num_entries();
+      for (i = 0; i < cache_size; ++i) {
+        const TransformState *result = state->_composition_cache.get_data(i)._result;
+        if (result != nullptr && result != state) {
+          // Here's a TransformState that's recorded in the cache.  Count it.
+          std::pair<StateCount::iterator, bool> ir =
+            state_count.insert(StateCount::value_type(result, 1));
+          if (!ir.second) {
+            // If the above insert operation fails, then it's already in the
+            // cache; increment its value.
+            (*(ir.first)).second++;
+          }
         }
       }
-    }
-    cache_size = state->_invert_composition_cache.get_num_entries();
-    for (i = 0; i < cache_size; ++i) {
-      const TransformState *result = state->_invert_composition_cache.get_data(i)._result;
-      if (result != nullptr && result != state) {
-        std::pair<StateCount::iterator, bool> ir =
-          state_count.insert(StateCount::value_type(result, 1));
-        if (!ir.second) {
-          (*(ir.first)).second++;
+      cache_size = state->_invert_composition_cache.get_num_entries();
+      for (i = 0; i < cache_size; ++i) {
+        const TransformState *result = state->_invert_composition_cache.get_data(i)._result;
+        if (result != nullptr && result != state) {
+          std::pair<StateCount::iterator, bool> ir =
+            state_count.insert(StateCount::value_type(result, 1));
+          if (!ir.second) {
+            (*(ir.first)).second++;
+          }
         }
       }
     }
@@ -1090,7 +1105,7 @@ clear_cache() {
   LightReMutexHolder holder(*_states_lock);
 
   PStatTimer timer(_cache_update_pcollector);
-  int orig_size = _states.get_num_entries();
+  int orig_size = get_num_states();
 
   // First, we need to copy the entire set of states to a temporary vector,
   // reference-counting each object.  That way we can walk through the copy,
@@ -1101,10 +1116,15 @@ clear_cache() {
     TempStates temp_states;
     temp_states.reserve(orig_size);
 
-    size_t size = _states.get_num_entries();
-    for (size_t si = 0; si < size; ++si) {
-      const TransformState *state = _states.get_key(si);
-      temp_states.push_back(state);
+    for (size_t shi = 0; shi < num_states_shards; ++shi) {
+      const StatesShard &shard = _states_shards[shi];
+      LightReMutexHolder shard_holder(shard._lock);
+
+      size_t size = shard._states.get_num_entries();
+      for (size_t si = 0; si < size; ++si) {
+        const TransformState *state = shard._states.get_key(si);
+        temp_states.push_back(state);
+      }
     }
 
     // Now it's safe to walk through the list, destroying the cache within
@@ -1142,7 +1162,7 @@ clear_cache() {
     // the various objects' caches will go away.
   }
 
-  int new_size = _states.get_num_entries();
+  int new_size = get_num_states();
   return orig_size - new_size;
 }
 
@@ -1161,18 +1181,46 @@ garbage_collect() {
   LightReMutexHolder holder(*_states_lock);
 
   PStatTimer timer(_garbage_collect_pcollector);
-  size_t orig_size = _states.get_num_entries();
+  size_t orig_size = get_num_states();
 
   // How many elements to process this pass?
-  size_t size = orig_size;
-  size_t num_this_pass = std::max(0, int(size * garbage_collect_states_rate));
+  size_t num_this_pass = std::max(0, int(orig_size * garbage_collect_states_rate));
   if (num_this_pass <= 0) {
     return 0;
   }
 
+  // Each shard is collected in turn, visiting its share of this pass.  Only
+  // one shard is locked at a time, so that the other shards remain available
+  // to other threads in the meantime.
+  size_t num_freed = 0;
+  for (size_t shi = 0; shi < num_states_shards; ++shi) {
+    StatesShard &shard = _states_shards[shi];
+    StateLockHolder shard_holder(shard._lock, _shard_lock_wait_pcollector);
+
+    size_t size = shard._states.get_num_entries();
+    size_t shard_this_pass = (size * num_this_pass + orig_size - 1) / orig_size;
+    num_freed += garbage_collect_shard(shard, shard_this_pass);
+  }
+
+  return (int)num_freed;
+}
+
+/**
+ * Performs the garbage collection of garbage_collect() on the indicated
+ * shard, visiting at most num_this_pass states.  Returns the number of states
+ * freed.  Both _states_lock and the shard's lock must already be held.
+ */
+size_t TransformState::
+garbage_collect_shard(StatesShard &shard, size_t num_this_pass) {
+  size_t orig_size = shard._states.get_num_entries();
+  size_t size = orig_size;
+  if (num_this_pass <= 0 || size == 0) {
+    return 0;
+  }
+
   bool break_and_uniquify = (auto_break_cycles && uniquify_transforms);
 
-  size_t si = _garbage_index;
+  size_t si = shard._garbage_index;
   if (si >= size) {
     si = 0;
   }
@@ -1181,7 +1229,7 @@ garbage_collect() {
   size_t stop_at_element = (si + num_this_pass) % size;
 
   do {
-    TransformState *state = (TransformState *)_states.get_key(si);
+    TransformState *state = (TransformState *)shard._states.get_key(si);
     if (break_and_uniquify) {
       if (state->get_cache_ref_count() > 0 &&
           state->get_ref_count() == state->get_cache_ref_count()) {
@@ -1196,7 +1244,7 @@ garbage_collect() {
     if (!state->unref_if_one()) {
       // This state has recently been unreffed to 1 (the one we added when
       // we stored it in the cache).  Now it's time to delete it.  This is
-      // safe, because we're holding the _states_lock, so it's not possible
+      // safe, because we're holding the shard's lock, so it's not possible
       // for some other thread to find the state in the cache and ref it
       // while we're doing this.  Also, we've just made sure to unref it to 0,
       // to ensure that another thread can't get it via a weak pointer.
@@ -1213,23 +1261,26 @@ garbage_collect() {
       if (stop_at_element > 0) {
         --stop_at_element;
       }
+      if (size == 0) {
+        break;
+      }
     }
 
     si = (si + 1) % size;
   } while (si != stop_at_element);
-  _garbage_index = si;
+  shard._garbage_index = si;
 
-  nassertr(_states.get_num_entries() == size, 0);
+  nassertr(shard._states.get_num_entries() == size, 0);
 
 #ifdef _DEBUG
-  nassertr(_states.validate(), 0);
+  nassertr(shard._states.validate(), 0);
 #endif
 
   // If we just cleaned up a lot of states, see if we can reduce the table in
   // size.  This will help reduce iteration overhead in the future.
-  _states.consider_shrink_table();
+  shard._states.consider_shrink_table();
 
-  return (int)orig_size - (int)size;
+  return orig_size - size;
 }
 
 /**
@@ -1253,60 +1304,65 @@ list_cycles(ostream &out) {
   VisitedStates visited;
   CompositionCycleDesc cycle_desc;
 
-  size_t size = _states.get_num_entries();
-  for (size_t si = 0; si < size; ++si) {
-    const TransformState *state = _states.get_key(si);
-
-    bool inserted = visited.insert(state).second;
-    if (inserted) {
-      ++_last_cycle_detect;
-      if (r_detect_cycles(state, state, 1, _last_cycle_detect, &cycle_desc)) {
-        // This state begins a cycle.
-        CompositionCycleDesc::reverse_iterator csi;
-
-        out << "\nCycle detected of length " << cycle_desc.size() + 1 << ":\n"
-            << "state " << (void *)state << ":" << state->get_ref_count()
-            << " =\n";
-        state->write(out, 2);
-        for (csi = cycle_desc.rbegin(); csi != cycle_desc.rend(); ++csi) {
-          const CompositionCycleDescEntry &entry = (*csi);
-          if (entry._inverted) {
-            out << "invert composed with ";
-          } else {
-            out << "composed with ";
-          }
-          out << (const void *)entry._obj << ":" << entry._obj->get_ref_count()
-              << " " << *entry._obj << "\n"
-              << "produces " << (const void *)entry._result << ":"
-              << entry._result->get_ref_count() << " =\n";
-          entry._result->write(out, 2);
-          visited.insert(entry._result);
-        }
+  for (size_t shi = 0; shi < num_states_shards; ++shi) {
+    const StatesShard &shard = _states_shards[shi];
+    LightReMutexHolder shard_holder(shard._lock);
 
-        cycle_desc.clear();
-      } else {
+    size_t size = shard._states.get_num_entries();
+    for (size_t si = 0; si < size; ++si) {
+      const TransformState *state = shard._states.get_key(si);
+
+      bool inserted = visited.insert(state).second;
+      if (inserted) {
         ++_last_cycle_detect;
-        if (r_detect_reverse_cycles(state, state, 1, _last_cycle_detect, &cycle_desc)) {
+        if (r_detect_cycles(state, state, 1, _last_cycle_detect, &cycle_desc)) {
           // This state begins a cycle.
-          CompositionCycleDesc::iterator csi;
+          CompositionCycleDesc::reverse_iterator csi;
 
-          out << "\nReverse cycle detected of length " << cycle_desc.size() + 1 << ":\n"
-              << "state ";
-          for (csi = cycle_desc.begin(); csi != cycle_desc.end(); ++csi) {
+          out << "\nCycle detected of length " << cycle_desc.size() + 1 << ":\n"
+              << "state " << (void *)state << ":" << state->get_ref_count()
+              << " =\n";
+          state->write(out, 2);
+          for (csi = cycle_desc.rbegin(); csi != cycle_desc.rend(); ++csi) {
             const CompositionCycleDescEntry &entry = (*csi);
-            out << (const void *)entry._result << ":"
+            if (entry._inverted) {
+              out << "invert composed with ";
+            } else {
+              out << "composed with ";
+            }
+            out << (const void *)entry._obj << ":" << entry._obj->get_ref_count()
+                << " " << *entry._obj << "\n"
+                << "produces " << (const void *)entry._result << ":"
                 << entry._result->get_ref_count() << " =\n";
             entry._result->write(out, 2);
-            out << (const void *)entry._obj << ":"
-                << entry._obj->get_ref_count() << " =\n";
-            entry._obj->write(out, 2);
             visited.insert(entry._result);
           }
-          out << (void *)state << ":"
-              << state->get_ref_count() << " =\n";
-          state->write(out, 2);
 
           cycle_desc.clear();
+        } else {
+          ++_last_cycle_detect;
+          if (r_detect_reverse_cycles(state, state, 1, _last_cycle_detect, &cycle_desc)) {
+            // This state begins a cycle.
+            CompositionCycleDesc::iterator csi;
+
+            out << "\nReverse cycle detected of length " << cycle_desc.size() + 1 << ":\n"
+                << "state ";
+            for (csi = cycle_desc.begin(); csi != cycle_desc.end(); ++csi) {
+              const CompositionCycleDescEntry &entry = (*csi);
+              out << (const void *)entry._result << ":"
+                  << entry._result->get_ref_count() << " =\n";
+              entry._result->write(out, 2);
+              out << (const void *)entry._obj << ":"
+                  << entry._obj->get_ref_count() << " =\n";
+              entry._obj->write(out, 2);
+              visited.insert(entry._result);
+            }
+            out << (void *)state << ":"
+                << state->get_ref_count() << " =\n";
+            state->write(out, 2);
+
+            cycle_desc.clear();
+          }
         }
       }
     }
@@ -1323,11 +1379,16 @@ void TransformState::
 list_states(ostream &out) {
   LightReMutexHolder holder(*_states_lock);
 
-  size_t size = _states.get_num_entries();
-  out << size << " states:\n";
-  for (size_t si = 0; si < size; ++si) {
-    const TransformState *state = _states.get_key(si);
-    state->write(out, 2);
+  out << get_num_states() << " states:\n";
+  for (size_t shi = 0; shi < num_states_shards; ++shi) {
+    const StatesShard &shard = _states_shards[shi];
+    LightReMutexHolder shard_holder(shard._lock);
+
+    size_t size = shard._states.get_num_entries();
+    for (size_t si = 0; si < size; ++si) {
+      const TransformState *state = shard._states.get_key(si);
+      state->write(out, 2);
+    }
   }
 }
 
@@ -1342,29 +1403,46 @@ validate_states() {
   PStatTimer timer(_transform_validate_pcollector);
 
   LightReMutexHolder holder(*_states_lock);
-  if (_states.is_empty()) {
+  for (size_t shi = 0; shi < num_states_shards; ++shi) {
+    const StatesShard &shard = _states_shards[shi];
+    LightReMutexHolder shard_holder(shard._lock);
+    if (!validate_states_shard(shard)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Performs the checks of validate_states() on the states in one shard of the
+ * global state set.  The shard's lock must already be held.
+ */
+bool TransformState::
+validate_states_shard(const StatesShard &shard) {
+  if (shard._states.is_empty()) {
     return true;
   }
 
-  if (!_states.validate()) {
+  if (!shard._states.validate()) {
     pgraph_cat.error()
       << "TransformState::_states cache is invalid!\n";
     return false;
   }
 
-  size_t size = _states.get_num_entries();
+  size_t size = shard._states.get_num_entries();
   size_t si = 0;
   nassertr(si < size, false);
-  nassertr(_states.get_key(si)->get_ref_count() >= 0, false);
+  nassertr(shard._states.get_key(si)->get_ref_count() >= 0, false);
   size_t snext = si;
   ++snext;
   while (snext < size) {
-    nassertr(_states.get_key(snext)->get_ref_count() >= 0, false);
-    const TransformState *ssi = _states.get_key(si);
+    nassertr(shard._states.get_key(snext)->get_ref_count() >= 0, false);
+    const TransformState *ssi = shard._states.get_key(si);
     if (!ssi->validate_composition_cache()) {
       return false;
     }
-    const TransformState *ssnext = _states.get_key(snext);
+    const TransformState *ssnext = shard._states.get_key(snext);
     bool c = (*ssi) == (*ssnext);
     bool ci = (*ssnext) == (*ssi);
     if (c != ci) {
@@ -1411,6 +1489,7 @@ init_states() {
   // OK because we guarantee that this method is called at static init time,
   // presumably when there is still only one thread in the world.
   _states_lock = new LightReMutex("TransformState::_states_lock");
+  _states_shards = new StatesShard[num_states_shards];
   _cache_stats.init();
   nassertv(Thread::get_current_thread() == Thread::get_main_thread());
 }
@@ -1457,22 +1536,26 @@ return_unique(TransformState *state) {
 
   PStatTimer timer(_transform_new_pcollector);
 
-  LightReMutexHolder holder(*_states_lock);
+  // Save the state in a local PointerTo so that it will be freed at the end
+  // of this function if no one else uses it.  This must be declared before
+  // the lock is acquired, so that it is not freed while we hold it.
+  CPT(TransformState) pt_state = state;
+
+  // Only the shard that this state would belong in needs to be locked, which
+  // lets threads making different states proceed at the same time.
+  StatesShard &shard = get_states_shard(state);
+  StateLockHolder shard_holder(shard._lock, _shard_lock_wait_pcollector);
 
   if (state->_saved_entry != -1) {
     // This state is already in the cache.  nassertr(_states.find(state) ==
     // state->_saved_entry, state);
-    return state;
+    return pt_state;
   }
 
-  // Save the state in a local PointerTo so that it will be freed at the end
-  // of this function if no one else uses it.
-  CPT(TransformState) pt_state = state;
-
-  int si = _states.find(state);
+  int si = shard._states.find(state);
   if (si != -1) {
     // There's an equivalent state already in the set.  Return it.
-    return _states.get_key(si);
+    return shard._states.get_key(si);
   }
 
   // Not already in the set; add it.
@@ -1482,7 +1565,7 @@ return_unique(TransformState *state) {
     // deleted while it's in it.
     state->cache_ref();
   }
-  si = _states.store(state, nullptr);
+  si = shard._states.store(state, nullptr);
 
   // Save the index and return the input state.
   state->_saved_entry = si;
@@ -1868,9 +1951,11 @@ void TransformState::
 release_new() {
   nassertv(_states_lock->debug_is_locked());
 
+  StatesShard &shard = get_states_shard(this);
+  LightReMutexHolder shard_holder(shard._lock);
   if (_saved_entry != -1) {
     _saved_entry = -1;
-    nassertv_always(_states.remove(this));
+    nassertv_always(shard._states.remove(this));
   }
 }
 
@@ -253,12 +253,32 @@ private:
   void remove_cache_pointers();
 
 private:
-  // This mutex protects _states.  It also protects any modification to the
-  // cache, which is encoded in _composition_cache and
-  // _invert_composition_cache.
+  // This mutex protects any modification to the cache, which is encoded in
+  // _composition_cache and _invert_composition_cache.  If it is needed
+  // together with the lock of one of the shards below, it must be acquired
+  // first.
   static LightReMutex *_states_lock;
   typedef SimpleHashMap<const TransformState *, std::nullptr_t, indirect_equals_hash<const TransformState *> > States;
-  static States _states;
+
+  // The global set of unique TransformStates is divided into several shards by
+  // hash value, each protected by its own mutex, so that threads making
+  // unrelated states don't have to wait for each other.
+  class StatesShard {
+  public:
+    INLINE StatesShard();
+
+    LightReMutex _lock;
+    States _states;
+
+    // This keeps track of our current position through the garbage
+    // collection cycle.
+    size_t _garbage_index;
+  };
+  static const size_t num_states_shards = 16;
+  static StatesShard *_states_shards;
+  INLINE static StatesShard &get_states_shard(const TransformState *state);
+  static size_t garbage_collect_shard(StatesShard &shard, size_t num_this_pass);
+  static bool validate_states_shard(const StatesShard &shard);
   static CPT(TransformState) _identity_state;
   static CPT(TransformState) _invalid_state;
 
@@ -295,14 +315,12 @@ private:
   UpdateSeq _cycle_detect;
   static UpdateSeq _last_cycle_detect;
 
-  // This keeps track of our current position through the garbage collection
-  // cycle.
-  static size_t _garbage_index;
-
   static bool _uniquify_matrix;
 
   static PStatCollector _cache_update_pcollector;
   static PStatCollector _garbage_collect_pcollector;
+  static PStatCollector _cache_lock_wait_pcollector;
+  static PStatCollector _shard_lock_wait_pcollector;
   static PStatCollector _transform_compose_pcollector;
   static PStatCollector _transform_invert_pcollector;
   static PStatCollector _transform_calc_pcollector;
@@ -134,22 +134,22 @@ get_states() {
   extern struct Dtool_PyTypedObject Dtool_TransformState;
   LightReMutexHolder holder(*TransformState::_states_lock);
 
-  size_t num_states = TransformState::_states.get_num_entries();
-  PyObject *list = PyList_New(num_states);
-  size_t i = 0;
+  PyObject *list = PyList_New(0);
+  for (size_t shi = 0; shi < TransformState::num_states_shards; ++shi) {
+    const TransformState::StatesShard &shard = TransformState::_states_shards[shi];
+    LightReMutexHolder shard_holder(shard._lock);
 
-  size_t size = TransformState::_states.get_num_entries();
-  for (size_t si = 0; si < size; ++si) {
-    const TransformState *state = TransformState::_states.get_key(si);
-    state->ref();
-    PyObject *a =
-      DTool_CreatePyInstanceTyped((void *)state, Dtool_TransformState,
-                                  true, true, state->get_type_index());
-    nassertr(i < num_states, list);
-    PyList_SET_ITEM(list, i, a);
-    ++i;
+    size_t size = shard._states.get_num_entries();
+    for (size_t si = 0; si < size; ++si) {
+      const TransformState *state = shard._states.get_key(si);
+      state->ref();
+      PyObject *a =
+        DTool_CreatePyInstanceTyped((void *)state, Dtool_TransformState,
+                                    true, true, state->get_type_index());
+      PyList_Append(list, a);
+      Py_DECREF(a);
+    }
   }
-  nassertr(i == num_states, list);
   return list;
 }
 
@@ -163,16 +163,21 @@ get_unused_states() {
   LightReMutexHolder holder(*TransformState::_states_lock);
 
   PyObject *list = PyList_New(0);
-  size_t size = TransformState::_states.get_num_entries();
-  for (size_t si = 0; si < size; ++si) {
-    const TransformState *state = TransformState::_states.get_key(si);
-    if (state->get_cache_ref_count() == state->get_ref_count()) {
-      state->ref();
-      PyObject *a =
-        DTool_CreatePyInstanceTyped((void *)state, Dtool_TransformState,
-                                    true, true, state->get_type_index());
-      PyList_Append(list, a);
-      Py_DECREF(a);
+  for (size_t shi = 0; shi < TransformState::num_states_shards; ++shi) {
+    const TransformState::StatesShard &shard = TransformState::_states_shards[shi];
+    LightReMutexHolder shard_holder(shard._lock);
+
+    size_t size = shard._states.get_num_entries();
+    for (size_t si = 0; si < size; ++si) {
+      const TransformState *state = shard._states.get_key(si);
+      if (state->get_cache_ref_count() == state->get_ref_count()) {
+        state->ref();
+        PyObject *a =
+          DTool_CreatePyInstanceTyped((void *)state, Dtool_TransformState,
+                                      true, true, state->get_type_index());
+        PyList_Append(list, a);
+        Py_DECREF(a);
+      }
     }
   }
   return list;
@@ -99,6 +99,14 @@ ConfigVariableDouble parallax_mapping_scale
           "how much influence the height values have on the texture "
           "coordinates."));
 
+ConfigVariableBool shader_generator_cache
+("shader-generator-cache", true,
+ PRC_DESC("Set this true to store the shaders synthesized by the "
+          "ShaderGenerator in the model cache (see model-cache-dir), so "
+          "that a later session that needs the same shader can load it "
+          "instead of generating it again.  This has no effect if the model "
+          "cache is not active."));
+
 /**
  * Initializes the library.  This must be called at least once before any of
  * the functions or classes in this library can be used.  Normally it will be
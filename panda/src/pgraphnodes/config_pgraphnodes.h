@@ -39,6 +39,7 @@ extern ConfigVariableBool verify_lods;
 
 extern ConfigVariableInt parallax_mapping_samples;
 extern ConfigVariableDouble parallax_mapping_scale;
+extern ConfigVariableBool shader_generator_cache;
 
 extern EXPCL_PANDA_PGRAPHNODES void init_libpgraphnodes();
 
@@ -37,6 +37,11 @@
 #include "shaderAttrib.h"
 #include "colorAttrib.h"
 #include "clipPlaneAttrib.h"
+#include "sceneGraphReducer.h"
+#include "sceneGraphAnalyzer.h"
+#include "deg_2_rad.h"
+
+#include <limits>
 
 TypeHandle LODNode::_type_handle;
 
@@ -60,6 +65,84 @@ make_default_lod(const std::string &name) {
   }
 }
 
+/**
+ * Creates a new LODNode of the type specified by default-lod-type, with up to
+ * num_levels children that are increasingly simplified copies of the source
+ * node.  Each level has about ratio_step times as many triangles as the one
+ * before it; see SceneGraphReducer::simplify().
+ *
+ * The switching distances are chosen such that each level is only shown once
+ * its simplification error, as seen on a screen that is screen_height pixels
+ * high with a vertical field of view of fov degrees, is no more than
+ * pixel_error pixels.  The last level remains visible at any distance.  Fewer
+ * levels are created if the source cannot be simplified any further.
+ *
+ * The transforms below the source node are applied to the vertices of the
+ * copies, so that the errors are measured in the space of the LODNode.
+ */
+PT(LODNode) LODNode::
+make_simplified_lod(const std::string &name, PandaNode *source,
+                    int num_levels, PN_stdfloat ratio_step,
+                    PN_stdfloat pixel_error, int screen_height,
+                    PN_stdfloat fov) {
+  PT(LODNode) lod = make_default_lod(name);
+  nassertr(source != nullptr, lod);
+  nassertr(ratio_step > 0 && ratio_step < 1, lod);
+  nassertr(pixel_error > 0 && screen_height > 0 && fov > 0 && fov < 180, lod);
+
+  // At this distance, an error of one unit covers pixel_error pixels.
+  PN_stdfloat distance_scale = (PN_stdfloat)screen_height /
+    ((PN_stdfloat)2 * std::tan(deg_2_rad(fov) * (PN_stdfloat)0.5) * pixel_error);
+
+  Thread *current_thread = Thread::get_current_thread();
+  SceneGraphReducer gr;
+  PT(PandaNode) base = source->copy_subgraph(current_thread);
+  gr.apply_attribs(base, SceneGraphReducer::TT_transform);
+
+  SceneGraphAnalyzer sga;
+  sga.add_node(base);
+  int num_tris = sga.get_num_tris();
+
+  PT(PandaNode) level = base;
+  PN_stdfloat out = 0;
+  PN_stdfloat ratio = 1;
+  for (int i = 1; i < num_levels && num_tris > 0; ++i) {
+    // Each level is simplified from the original, so that the error is
+    // measured against the original surface.
+    ratio *= ratio_step;
+    PT(PandaNode) next = base->copy_subgraph(current_thread);
+    PN_stdfloat error = gr.simplify(next, ratio);
+
+    sga.clear();
+    sga.add_node(next);
+    int next_tris = sga.get_num_tris();
+    if (next_tris >= num_tris) {
+      break;
+    }
+
+    PN_stdfloat distance = error * distance_scale;
+    if (distance > out) {
+      lod->add_child(level);
+      lod->add_switch(distance, out);
+      out = distance;
+    }
+    // Otherwise, the simpler level looks the same wherever the current level
+    // would be shown, so it takes its place.
+    level = next;
+    num_tris = next_tris;
+  }
+
+  lod->add_child(level);
+  lod->add_switch(std::numeric_limits<PN_stdfloat>::max(), out);
+
+  if (pgraph_cat.is_debug()) {
+    pgraph_cat.debug()
+      << "Created " << *lod << " with " << lod->get_num_switches()
+      << " levels from " << *source << "\n";
+  }
+  return lod;
+}
+
 /**
  * Returns a newly-allocated Node that is a shallow copy of this one.  It will
  * be a different Node pointer, but its internal data may or may not be shared
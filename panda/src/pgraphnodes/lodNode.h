@@ -30,6 +30,12 @@ PUBLISHED:
   INLINE explicit LODNode(const std::string &name);
 
   static PT(LODNode) make_default_lod(const std::string &name);
+  static PT(LODNode) make_simplified_lod(const std::string &name,
+                                         PandaNode *source, int num_levels,
+                                         PN_stdfloat ratio_step = 0.5,
+                                         PN_stdfloat pixel_error = 1.0,
+                                         int screen_height = 1080,
+                                         PN_stdfloat fov = 40.0);
 
 protected:
   INLINE LODNode(const LODNode &copy);
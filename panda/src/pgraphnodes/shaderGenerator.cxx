@@ -46,6 +46,13 @@
 #include "lvector4.h"
 #include "config_pgraphnodes.h"
 #include "pStatTimer.h"
+#include "bamCache.h"
+#include "bamCacheRecord.h"
+#include "datagramInputFile.h"
+#include "datagramOutputFile.h"
+#include "typeRegistry.h"
+
+#include <algorithm>
 
 using std::string;
 
@@ -71,6 +78,14 @@ pack_combine(TextureStage::CombineSource src0, TextureStage::CombineOperand op0,
 
 static PStatCollector lookup_collector("*:Munge:ShaderGen:Lookup");
 static PStatCollector synthesize_collector("*:Munge:ShaderGen:Synthesize");
+static PStatCollector cache_collector("*:Munge:ShaderGen:Cache");
+
+// Bump this when the generated source changes, so that shaders generated by
+// an older version are no longer picked up from the model cache.
+static const int shader_generator_version = 1;
+
+// The header at the start of a file written by write_recorded_states().
+static const std::string recorded_states_header = std::string("psk\0\n\r", 6);
 
 /**
  * Create a ShaderGenerator.  This has no state, except possibly to cache
@@ -91,6 +106,8 @@ ShaderGenerator(const GraphicsStateGuardianBase *gsg) {
   // Do we want to use the ARB_shadow extension?  This also allows us to use
   // hardware shadows PCF.
   _use_shadow_filter = gsg->get_supports_shadow_filter();
+
+  _record_states = false;
 }
 
 /**
@@ -582,25 +599,30 @@ rehash_generated_shaders() {
 
   // With uniquify-states turned on, we can actually go through all the states
   // and check whether their generated shader is still OK.
-  size_t size = RenderState::_states.get_num_entries();
-  for (size_t si = 0; si < size; ++si) {
-    const RenderState *state = RenderState::_states.get_key(si);
-
-    if (state->_generated_shader != nullptr) {
-      ShaderKey key;
-      analyze_renderstate(key, state);
-
-      GeneratedShaders::const_iterator si;
-      si = _generated_shaders.find(key);
-      if (si != _generated_shaders.end()) {
-        if (si->second != state->_generated_shader) {
-          state->_generated_shader = si->second;
+  for (size_t shi = 0; shi < RenderState::num_states_shards; ++shi) {
+    const RenderState::StatesShard &shard = RenderState::_states_shards[shi];
+    LightReMutexHolder shard_holder(shard._lock);
+
+    size_t size = shard._states.get_num_entries();
+    for (size_t si = 0; si < size; ++si) {
+      const RenderState *state = shard._states.get_key(si);
+
+      if (state->_generated_shader != nullptr) {
+        ShaderKey key;
+        analyze_renderstate(key, state);
+
+        GeneratedShaders::const_iterator si;
+        si = _generated_shaders.find(key);
+        if (si != _generated_shaders.end()) {
+          if (si->second != state->_generated_shader) {
+            state->_generated_shader = si->second;
+            state->_munged_states.clear();
+          }
+        } else {
+          // We have not yet generated a shader for this modified state.
+          state->_generated_shader.clear();
           state->_munged_states.clear();
         }
-      } else {
-        // We have not yet generated a shader for this modified state.
-        state->_generated_shader.clear();
-        state->_munged_states.clear();
       }
     }
   }
@@ -623,10 +645,15 @@ void ShaderGenerator::
 clear_generated_shaders() {
   LightReMutexHolder holder(*RenderState::_states_lock);
 
-  size_t size = RenderState::_states.get_num_entries();
-  for (size_t si = 0; si < size; ++si) {
-    const RenderState *state = RenderState::_states.get_key(si);
-    state->_generated_shader.clear();
+  for (size_t shi = 0; shi < RenderState::num_states_shards; ++shi) {
+    const RenderState::StatesShard &shard = RenderState::_states_shards[shi];
+    LightReMutexHolder shard_holder(shard._lock);
+
+    size_t size = shard._states.get_num_entries();
+    for (size_t si = 0; si < size; ++si) {
+      const RenderState *state = shard._states.get_key(si);
+      state->_generated_shader.clear();
+    }
   }
 
   _generated_shaders.clear();
@@ -638,6 +665,168 @@ clear_generated_shaders() {
   }
 }
 
+/**
+ * Enables or disables recording of the states for which a shader is
+ * generated.  While this is enabled, the generator keeps a list of each
+ * distinct state it synthesizes a shader for, which may later be saved with
+ * write_recorded_states() and passed to prewarm() in a future session, so
+ * that the shaders are ready before they are first needed.
+ */
+void ShaderGenerator::
+set_record_states(bool flag) {
+  _record_states = flag;
+}
+
+/**
+ * Returns true if the generator is recording states; see
+ * set_record_states().
+ */
+bool ShaderGenerator::
+get_record_states() const {
+  return _record_states;
+}
+
+/**
+ * Returns the number of distinct states recorded so far.
+ */
+size_t ShaderGenerator::
+get_num_recorded_states() const {
+  return _recorded_keys.size();
+}
+
+/**
+ * Empties the list of recorded states.  This does not change whether
+ * recording is enabled.
+ */
+void ShaderGenerator::
+clear_recorded_states() {
+  _recorded_keys.clear();
+}
+
+/**
+ * Writes the list of recorded states to the indicated file, which may later
+ * be passed to prewarm().  Only the parts of each state that affect the
+ * generated shader are written.  Returns true on success, false on failure.
+ */
+bool ShaderGenerator::
+write_recorded_states(const Filename &filename) const {
+  Filename fn = Filename::binary_filename(filename);
+  DatagramOutputFile dout;
+  if (!dout.open(fn)) {
+    pgraphnodes_cat.error()
+      << "Unable to open " << fn << " for writing.\n";
+    return false;
+  }
+
+  if (!dout.write_header(recorded_states_header)) {
+    pgraphnodes_cat.error()
+      << "Unable to write to " << fn << "\n";
+    return false;
+  }
+
+  for (const ShaderKey &key : _recorded_keys) {
+    Datagram dg;
+    key.write_datagram(dg);
+    if (!dout.put_datagram(dg)) {
+      pgraphnodes_cat.error()
+        << "Unable to write to " << fn << "\n";
+      return false;
+    }
+  }
+
+  if (pgraphnodes_cat.is_debug()) {
+    pgraphnodes_cat.debug()
+      << "Wrote " << _recorded_keys.size() << " shader generator states to "
+      << fn << "\n";
+  }
+  return true;
+}
+
+/**
+ * Reads a list of states written by write_recorded_states(), and makes sure
+ * a shader has been synthesized for each of them.  Shaders that are in the
+ * model cache are loaded from there; the others are generated, and stored in
+ * the cache if it is active.  Calling this at load time avoids generating
+ * the shaders the first time each state is rendered.
+ *
+ * Returns the number of new shaders that were made available, or -1 if the
+ * file could not be read.
+ */
+int ShaderGenerator::
+prewarm(const Filename &filename) {
+  Filename fn = Filename::binary_filename(filename);
+  DatagramInputFile din;
+  if (!din.open(fn)) {
+    pgraphnodes_cat.error()
+      << "Unable to open " << fn << " for reading.\n";
+    return -1;
+  }
+
+  std::string head;
+  if (!din.read_header(head, recorded_states_header.size()) ||
+      head != recorded_states_header) {
+    pgraphnodes_cat.error()
+      << fn << " is not a shader generator state file.\n";
+    return -1;
+  }
+
+  int num_made = 0;
+  Datagram dg;
+  while (din.get_datagram(dg)) {
+    DatagramIterator scan(dg);
+    ShaderKey key;
+    if (!key.read_datagram(scan)) {
+      pgraphnodes_cat.warning()
+        << "Skipping unrecognized state in " << fn << "\n";
+      continue;
+    }
+
+    if (_generated_shaders.find(key) == _generated_shaders.end()) {
+      if (make_generated_shader(key, nullptr) != nullptr) {
+        ++num_made;
+      }
+    }
+  }
+
+  if (!din.is_eof()) {
+    pgraphnodes_cat.error()
+      << "Error reading " << fn << "\n";
+  }
+
+  if (pgraphnodes_cat.is_debug()) {
+    pgraphnodes_cat.debug()
+      << "Prewarmed " << num_made << " shaders from " << fn << "\n";
+  }
+  return num_made;
+}
+
+/**
+ * Returns the name under which the shader for the indicated key is stored in
+ * the model cache.  This does not name a real file; it encodes the key along
+ * with the GSG capabilities and settings that the generated source depends
+ * on.
+ */
+Filename ShaderGenerator::
+get_cache_source_pathname(const ShaderKey &key) const {
+  Datagram dg;
+  dg.add_uint16(shader_generator_version);
+  dg.add_bool(_use_generic_attr);
+  dg.add_bool(_use_shadow_filter);
+  dg.add_int32(parallax_mapping_samples);
+  dg.add_float64(parallax_mapping_scale);
+  key.write_datagram(dg);
+
+  static const char hex_digits[] = "0123456789abcdef";
+  const unsigned char *data = (const unsigned char *)dg.get_data();
+  std::string name = "/$shader-generator/";
+  name.reserve(name.size() + dg.get_length() * 2);
+  for (size_t i = 0; i < dg.get_length(); ++i) {
+    name += hex_digits[data[i] >> 4];
+    name += hex_digits[data[i] & 0xf];
+  }
+  return Filename(name);
+}
+
 /**
  * This is the routine that implements the next-gen fixed function pipeline by
  * synthesizing a shader.  It also takes care of setting up any buffers needed
@@ -684,14 +873,92 @@ synthesize_shader(const RenderState *rs, const GeomVertexAnimationSpec &anim) {
     }
   }
 
+  return make_generated_shader(key, rs);
+}
+
+/**
+ * Makes the ShaderAttrib for the indicated key, which is not yet in the table
+ * of generated shaders, and adds it to the table.  If the model cache is
+ * active, the shader source is taken from the cache when a previous session
+ * already generated it, and stored there otherwise.
+ *
+ * The RenderState is only used to annotate the generated source, and may be
+ * NULL.  It is left out of source that is stored in the cache.
+ */
+CPT(ShaderAttrib) ShaderGenerator::
+make_generated_shader(const ShaderKey &key, const RenderState *rs) {
+  if (_record_states &&
+      std::find(_recorded_keys.begin(), _recorded_keys.end(), key) == _recorded_keys.end()) {
+    _recorded_keys.push_back(key);
+  }
+
+  std::string text;
+  PT(BamCacheRecord) record;
+  BamCache *cache = BamCache::get_global_ptr();
+  if (shader_generator_cache && cache->get_active()) {
+    PStatTimer timer(cache_collector);
+    record = cache->lookup(get_cache_source_pathname(key), "sho");
+    if (record != nullptr && record->has_data() &&
+        record->get_data()->is_of_type(Shader::get_class_type())) {
+      text = DCAST(Shader, record->get_data())->get_text();
+      if (pgraphnodes_cat.is_debug()) {
+        pgraphnodes_cat.debug()
+          << "Generated shader was found in disk cache.\n";
+      }
+    }
+  }
+
+  bool generated = false;
+  if (text.empty()) {
+    // The source that goes into the cache is shared by every state with the
+    // same key, so it isn't annotated with this particular state.
+    text = generate_shader_text(key, (record != nullptr) ? nullptr : rs);
+    generated = true;
+  }
+
+  // Insert the shader into the shader attrib.
+  PT(Shader) shader = Shader::make(std::move(text), Shader::SL_Cg);
+  nassertr(shader != nullptr, nullptr);
+
+  if (generated && record != nullptr) {
+    PStatTimer timer(cache_collector);
+    record->set_data(shader);
+    cache->store(record);
+  }
+
+  CPT(RenderAttrib) shattr = ShaderAttrib::make(shader);
+  if (key._alpha_test_mode != RenderAttrib::M_none) {
+    shattr = DCAST(ShaderAttrib, shattr)->set_flag(ShaderAttrib::F_subsume_alpha_test, true);
+  }
+  if (key._disable_alpha_write) {
+    shattr = DCAST(ShaderAttrib, shattr)->set_flag(ShaderAttrib::F_disable_alpha_write, true);
+  }
+
+  CPT(ShaderAttrib) attr = DCAST(ShaderAttrib, shattr);
+  _generated_shaders[key] = attr;
+  return attr;
+}
+
+/**
+ * Generates the Cg source of the shader for the indicated key.  The source
+ * depends only on the key and on the capabilities of the GSG, which is what
+ * allows it to be cached on disk.
+ */
+std::string ShaderGenerator::
+generate_shader_text(const ShaderKey &key, const RenderState *rs) {
   PStatTimer timer(synthesize_collector);
 
   reset_register_allocator();
 
   if (pgraphnodes_cat.is_debug()) {
-    pgraphnodes_cat.debug()
-      << "Generating shader for render state " << rs << ":\n";
-    rs->write(pgraphnodes_cat.debug(false), 2);
+    if (rs != nullptr) {
+      pgraphnodes_cat.debug()
+        << "Generating shader for render state " << rs << ":\n";
+      rs->write(pgraphnodes_cat.debug(false), 2);
+    } else {
+      pgraphnodes_cat.debug()
+        << "Generating shader for recorded state.\n";
+    }
   }
 
   // These variables will hold the results of register allocation.
@@ -737,9 +1004,11 @@ synthesize_shader(const RenderState *rs, const GeomVertexAnimationSpec &anim) {
 
   text << "//Cg\n";
 
-  text << "/* Generated shader for render state:\n";
-  rs->write(text, 2);
-  text << "*/\n";
+  if (rs != nullptr) {
+    text << "/* Generated shader for render state:\n";
+    rs->write(text, 2);
+    text << "*/\n";
+  }
 
   int map_index_glow = -1;
   int map_index_gloss = -1;
@@ -1199,7 +1468,7 @@ synthesize_shader(const RenderState *rs, const GeomVertexAnimationSpec &anim) {
     }
   }
   for (size_t i = 0; i < key._textures.size(); ++i) {
-    ShaderKey::TextureInfo &tex = key._textures[i];
+    const ShaderKey::TextureInfo &tex = key._textures[i];
     if (tex._mode == TextureStage::M_modulate && tex._flags == 0) {
       // Skip this stage.
       continue;
@@ -1704,23 +1973,8 @@ synthesize_shader(const RenderState *rs, const GeomVertexAnimationSpec &anim) {
       << text.str() << "\n";
   }
 
-  // Insert the shader into the shader attrib.
-  PT(Shader) shader = Shader::make(text.str(), Shader::SL_Cg);
-  nassertr(shader != nullptr, nullptr);
-
-  CPT(RenderAttrib) shattr = ShaderAttrib::make(shader);
-  if (key._alpha_test_mode != RenderAttrib::M_none) {
-    shattr = DCAST(ShaderAttrib, shattr)->set_flag(ShaderAttrib::F_subsume_alpha_test, true);
-  }
-  if (key._disable_alpha_write) {
-    shattr = DCAST(ShaderAttrib, shattr)->set_flag(ShaderAttrib::F_disable_alpha_write, true);
-  }
-
   reset_register_allocator();
-
-  CPT(ShaderAttrib) attr = DCAST(ShaderAttrib, shattr);
-  _generated_shaders[key] = attr;
-  return attr;
+  return text.str();
 }
 
 /**
@@ -1883,6 +2137,155 @@ ShaderKey() :
   _light_ramp(nullptr) {
 }
 
+/**
+ * Writes the key to the indicated datagram, in a form that can be read back
+ * by read_datagram() in a later session.  Types and names are written by
+ * name, since their indices may differ between sessions.
+ */
+void ShaderGenerator::ShaderKey::
+write_datagram(Datagram &dg) const {
+  GeomVertexAnimationSpec anim_spec(_anim_spec);
+  anim_spec.write_datagram(nullptr, dg);
+
+  dg.add_uint8(_color_type);
+  dg.add_int32(_material_flags);
+  dg.add_int32(_texture_flags);
+
+  dg.add_uint16(_textures.size());
+  for (const TextureInfo &info : _textures) {
+    dg.add_bool(info._texcoord_name != nullptr);
+    if (info._texcoord_name != nullptr) {
+      dg.add_string(info._texcoord_name->get_name());
+    }
+    dg.add_uint8(info._type);
+    dg.add_uint8(info._mode);
+    dg.add_uint8(info._gen_mode);
+    dg.add_int32(info._flags);
+    dg.add_uint16(info._combine_rgb);
+    dg.add_uint16(info._combine_alpha);
+  }
+
+  dg.add_uint16(_lights.size());
+  for (const LightInfo &info : _lights) {
+    dg.add_string(info._type.get_name());
+    dg.add_int32(info._flags);
+  }
+
+  dg.add_bool(_lighting);
+  dg.add_bool(_have_separate_ambient);
+  dg.add_int32(_fog_mode);
+  dg.add_int32(_outputs);
+  dg.add_bool(_calc_primary_alpha);
+  dg.add_bool(_disable_alpha_write);
+  dg.add_uint8(_alpha_test_mode);
+  dg.add_stdfloat(_alpha_test_ref);
+  dg.add_int32(_num_clip_planes);
+
+  dg.add_bool(_light_ramp != nullptr);
+  if (_light_ramp != nullptr) {
+    dg.add_uint8(_light_ramp->get_mode());
+    for (int i = 0; i < 2; ++i) {
+      dg.add_stdfloat(_light_ramp->get_level(i));
+      dg.add_stdfloat(_light_ramp->get_threshold(i));
+    }
+  }
+}
+
+/**
+ * Reads a key written by write_datagram().  Returns false if the key refers
+ * to a light type that is not known in this session, or if the data is
+ * malformed.
+ */
+bool ShaderGenerator::ShaderKey::
+read_datagram(DatagramIterator &scan) {
+  _anim_spec.fillin(scan, nullptr);
+
+  _color_type = (ColorAttrib::Type)scan.get_uint8();
+  _material_flags = scan.get_int32();
+  _texture_flags = scan.get_int32();
+
+  size_t num_textures = scan.get_uint16();
+  _textures.resize(num_textures);
+  for (TextureInfo &info : _textures) {
+    if (scan.get_bool()) {
+      info._texcoord_name = InternalName::make(scan.get_string());
+    } else {
+      info._texcoord_name = nullptr;
+    }
+    info._type = (Texture::TextureType)scan.get_uint8();
+    info._mode = (TextureStage::Mode)scan.get_uint8();
+    info._gen_mode = (TexGenAttrib::Mode)scan.get_uint8();
+    info._flags = scan.get_int32();
+    info._combine_rgb = scan.get_uint16();
+    info._combine_alpha = scan.get_uint16();
+  }
+
+  bool valid = true;
+  size_t num_lights = scan.get_uint16();
+  _lights.resize(num_lights);
+  for (LightInfo &info : _lights) {
+    info._type = TypeRegistry::ptr()->find_type(scan.get_string());
+    info._flags = scan.get_int32();
+    if (info._type == TypeHandle::none()) {
+      valid = false;
+    }
+  }
+
+  _lighting = scan.get_bool();
+  _have_separate_ambient = scan.get_bool();
+  _fog_mode = scan.get_int32();
+  _outputs = scan.get_int32();
+  _calc_primary_alpha = scan.get_bool();
+  _disable_alpha_write = scan.get_bool();
+  _alpha_test_mode = (RenderAttrib::PandaCompareFunc)scan.get_uint8();
+  _alpha_test_ref = scan.get_stdfloat();
+  _num_clip_planes = scan.get_int32();
+
+  _light_ramp = nullptr;
+  if (scan.get_bool()) {
+    LightRampAttrib::LightRampMode mode = (LightRampAttrib::LightRampMode)scan.get_uint8();
+    PN_stdfloat level[2], threshold[2];
+    for (int i = 0; i < 2; ++i) {
+      level[i] = scan.get_stdfloat();
+      threshold[i] = scan.get_stdfloat();
+    }
+
+    CPT(RenderAttrib) attrib;
+    switch (mode) {
+    case LightRampAttrib::LRT_default:
+      attrib = LightRampAttrib::make_default();
+      break;
+    case LightRampAttrib::LRT_identity:
+      attrib = LightRampAttrib::make_identity();
+      break;
+    case LightRampAttrib::LRT_single_threshold:
+      attrib = LightRampAttrib::make_single_threshold(threshold[0], level[0]);
+      break;
+    case LightRampAttrib::LRT_double_threshold:
+      attrib = LightRampAttrib::make_double_threshold(threshold[0], level[0],
+                                                      threshold[1], level[1]);
+      break;
+    case LightRampAttrib::LRT_hdr0:
+      attrib = LightRampAttrib::make_hdr0();
+      break;
+    case LightRampAttrib::LRT_hdr1:
+      attrib = LightRampAttrib::make_hdr1();
+      break;
+    case LightRampAttrib::LRT_hdr2:
+      attrib = LightRampAttrib::make_hdr2();
+      break;
+    default:
+      valid = false;
+      break;
+    }
+    if (attrib != nullptr) {
+      _light_ramp = DCAST(LightRampAttrib, attrib);
+    }
+  }
+
+  return valid && scan.get_remaining_size() == 0;
+}
+
 /**
  * Returns true if this ShaderKey sorts less than the other one.  This is an
  * arbitrary, but consistent ordering.
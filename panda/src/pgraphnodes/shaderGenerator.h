@@ -32,6 +32,10 @@
 #include "lightRampAttrib.h"
 #include "texGenAttrib.h"
 #include "textureAttrib.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+#include "filename.h"
+#include "pvector.h"
 
 class AmbientLight;
 class DirectionalLight;
@@ -73,6 +77,15 @@ PUBLISHED:
   void rehash_generated_shaders();
   void clear_generated_shaders();
 
+  void set_record_states(bool flag);
+  bool get_record_states() const;
+  size_t get_num_recorded_states() const;
+  void clear_recorded_states();
+  bool write_recorded_states(const Filename &filename) const;
+  int prewarm(const Filename &filename);
+
+  MAKE_PROPERTY(record_states, get_record_states, set_record_states);
+
 protected:
   // Shader register allocation:
 
@@ -96,6 +109,9 @@ protected:
     bool operator == (const ShaderKey &other) const;
     bool operator != (const ShaderKey &other) const { return !operator ==(other); }
 
+    void write_datagram(Datagram &dg) const;
+    bool read_datagram(DatagramIterator &scan);
+
     GeomVertexAnimationSpec _anim_spec;
     enum TextureFlags {
       TF_has_rgb      = 0x001,
@@ -166,7 +182,18 @@ protected:
   typedef phash_map<ShaderKey, CPT(ShaderAttrib)> GeneratedShaders;
   GeneratedShaders _generated_shaders;
 
+  // The keys of the shaders generated while recording is enabled, in the
+  // order in which they were first needed.
+  typedef pvector<ShaderKey> RecordedKeys;
+  RecordedKeys _recorded_keys;
+  bool _record_states;
+
   void analyze_renderstate(ShaderKey &key, const RenderState *rs);
+  CPT(ShaderAttrib) make_generated_shader(const ShaderKey &key,
+                                          const RenderState *rs);
+  std::string generate_shader_text(const ShaderKey &key,
+                                   const RenderState *rs);
+  Filename get_cache_source_pathname(const ShaderKey &key) const;
 
   static std::string combine_mode_as_string(const ShaderKey::TextureInfo &info,
                       TextureStage::CombineMode c_mode, bool alpha, short texindex);
@@ -62,6 +62,22 @@ ConfigVariableDouble pfm_resize_radius
           "always call box_filter() or gaussian_filter() explicitly with "
           "a specific radius."));
 
+ConfigVariableInt pfm_num_threads
+("pfm-num-threads", 0,
+ PRC_DESC("The number of worker threads that may help with the bulk "
+          "operations on a single large PfmFile, such as resize(), "
+          "box_filter_from(), xform(), forward_distort(), reverse_distort(), "
+          "calc_min_max() and compute_planar_bounds().  The table is split "
+          "into bands of rows.  Set this to 0 to do all of the work on the "
+          "calling thread."));
+
+ConfigVariableInt pnmimage_filter_num_threads
+("pnmimage-filter-num-threads", 0,
+ PRC_DESC("The number of worker threads that may help to filter a single "
+          "large image in PNMImage::box_filter_from(), gaussian_filter_from() "
+          "and quick_filter_from().  The image is split into bands of rows.  "
+          "Set this to 0 to filter images entirely on the calling thread."));
+
 /**
  * Initializes the library.  This must be called at least once before any of
  * the functions or classes in this library can be used.  Normally it will be
@@ -23,12 +23,94 @@
 #include "pnmWriter.h"
 #include "string_utils.h"
 #include "look_at.h"
+#include "parallelJobRunner.h"
+#include "lightMutex.h"
+#include "lightMutexHolder.h"
 
 using std::istream;
 using std::max;
 using std::min;
 using std::ostream;
 
+// Don't bother handing out fewer rows than this to a thread.
+static const int pfm_min_rows_per_job = 16;
+
+/**
+ * Computes the bounding box of the points in the rows [y_begin, y_end) of the
+ * file, after passing each point through func.  Returns true if there were
+ * any points.
+ */
+template<class Func>
+static bool
+calc_rows_min_max(const PfmFile &file, int y_begin, int y_end, Func func,
+                  LVecBase3f &min_point, LVecBase3f &max_point) {
+  bool any_points = false;
+  bool check = file.has_no_data_value();
+  int x_size = file.get_x_size();
+
+  for (int yi = y_begin; yi < y_end; ++yi) {
+    for (int xi = 0; xi < x_size; ++xi) {
+      if (check && !file.has_point(xi, yi)) {
+        continue;
+      }
+
+      LPoint3f p = func(file.get_point(xi, yi));
+      if (!any_points) {
+        min_point = p;
+        max_point = p;
+        any_points = true;
+      } else {
+        min_point[0] = min(min_point[0], p[0]);
+        min_point[1] = min(min_point[1], p[1]);
+        min_point[2] = min(min_point[2], p[2]);
+        max_point[0] = max(max_point[0], p[0]);
+        max_point[1] = max(max_point[1], p[1]);
+        max_point[2] = max(max_point[2], p[2]);
+      }
+    }
+  }
+
+  return any_points;
+}
+
+/**
+ * As above, for the whole file.  The rows are split into bands, which are
+ * handed out to the threads of the indicated runner, and the bounding boxes
+ * of the bands are combined at the end.
+ */
+template<class Func>
+static bool
+calc_table_min_max(const PfmFile &file, ParallelJobRunner &job_runner,
+                   Func func, LVecBase3f &min_point, LVecBase3f &max_point) {
+  bool any_points = false;
+  LightMutex lock;
+
+  job_runner.run_bands(file.get_y_size(), pfm_min_rows_per_job, [&] (int begin, int end) {
+    LVecBase3f band_min, band_max;
+    if (calc_rows_min_max(file, begin, end, func, band_min, band_max)) {
+      LightMutexHolder holder(lock);
+      if (!any_points) {
+        min_point = band_min;
+        max_point = band_max;
+        any_points = true;
+      } else {
+        min_point = min_point.fmin(band_min);
+        max_point = max_point.fmax(band_max);
+      }
+    }
+  });
+
+  return any_points;
+}
+
+/**
+ * Returns the point unchanged, for passing to calc_table_min_max().
+ */
+static const LPoint3f &
+pfm_identity(const LPoint3f &p) {
+  return p;
+}
+
 /**
  *
  */
@@ -735,34 +817,11 @@ calc_bilinear_point(LPoint3f &result, PN_float32 x, PN_float32 y) const {
  */
 bool PfmFile::
 calc_min_max(LVecBase3f &min_depth, LVecBase3f &max_depth) const {
-  bool any_points = false;
-
   min_depth = LVecBase3f::zero();
   max_depth = LVecBase3f::zero();
 
-  for (int yi = 0; yi < _y_size; ++yi) {
-    for (int xi = 0; xi < _x_size; ++xi) {
-      if (!has_point(xi, yi)) {
-        continue;
-      }
-
-      const LPoint3f &p = get_point(xi, yi);
-      if (!any_points) {
-        min_depth = p;
-        max_depth = p;
-        any_points = true;
-      } else {
-        min_depth[0] = min(min_depth[0], p[0]);
-        min_depth[1] = min(min_depth[1], p[1]);
-        min_depth[2] = min(min_depth[2], p[2]);
-        max_depth[0] = max(max_depth[0], p[0]);
-        max_depth[1] = max(max_depth[1], p[1]);
-        max_depth[2] = max(max_depth[2], p[2]);
-      }
-    }
-  }
-
-  return any_points;
+  return calc_table_min_max(*this, get_job_runner(), &pfm_identity,
+                            min_depth, max_depth);
 }
 
 /**
@@ -1000,10 +1059,10 @@ quick_filter_from(const PfmFile &from) {
     return;
   }
 
-  Table new_data;
-  new_data.reserve(_table.size());
+  int num_channels = _num_channels;
+  nassertv_always(num_channels >= 1 && num_channels <= 4);
 
-  PN_float32 from_x0, from_x1, from_y0, from_y1;
+  Table new_data(_table.size(), (PN_float32)0.0);
 
   int orig_x_size = from.get_x_size();
   int orig_y_size = from.get_y_size();
@@ -1018,124 +1077,49 @@ quick_filter_from(const PfmFile &from) {
     y_scale = (PN_float32)orig_y_size / (PN_float32)_y_size;
   }
 
-  switch (_num_channels) {
-  case 1:
-    {
-      from_y0 = 0.0;
-      for (int to_y = 0; to_y < _y_size; ++to_y) {
-        from_y1 = (to_y + 1.0) * y_scale;
-        from_y1 = min(from_y1, (PN_float32)orig_y_size);
-
-        from_x0 = 0.0;
-        for (int to_x = 0; to_x < _x_size; ++to_x) {
-          from_x1 = (to_x + 1.0) * x_scale;
-          from_x1 = min(from_x1, (PN_float32)orig_x_size);
-
-          // Now the box from (from_x0, from_y0) - (from_x1, from_y1) but not
-          // including (from_x1, from_y1) maps to the pixel (to_x, to_y).
-          PN_float32 result;
-          from.box_filter_region(result, from_x0, from_y0, from_x1, from_y1);
-          new_data.push_back(result);
-
-          from_x0 = from_x1;
-        }
-        from_y0 = from_y1;
-      }
-    }
-    break;
-
-  case 2:
-    {
-      from_y0 = 0.0;
-      for (int to_y = 0; to_y < _y_size; ++to_y) {
-        from_y1 = (to_y + 1.0) * y_scale;
-        from_y1 = min(from_y1, (PN_float32)orig_y_size);
-
-        from_x0 = 0.0;
-        for (int to_x = 0; to_x < _x_size; ++to_x) {
-          from_x1 = (to_x + 1.0) * x_scale;
-          from_x1 = min(from_x1, (PN_float32)orig_x_size);
-
-          // Now the box from (from_x0, from_y0) - (from_x1, from_y1) but not
-          // including (from_x1, from_y1) maps to the pixel (to_x, to_y).
-          LPoint2f result;
-          from.box_filter_region(result, from_x0, from_y0, from_x1, from_y1);
-          new_data.push_back(result[0]);
-          new_data.push_back(result[1]);
-
-          from_x0 = from_x1;
+  // Each row is independent of the others, so the rows may be split up among
+  // several threads.
+  get_job_runner().run_bands(_y_size, pfm_min_rows_per_job, [&] (int begin, int end) {
+    for (int to_y = begin; to_y < end; ++to_y) {
+      PN_float32 from_y0 = to_y * (double)y_scale;
+      from_y0 = min(from_y0, (PN_float32)orig_y_size);
+      PN_float32 from_y1 = (to_y + 1.0) * y_scale;
+      from_y1 = min(from_y1, (PN_float32)orig_y_size);
+
+      PN_float32 *dest = &new_data[(size_t)to_y * _x_size * num_channels];
+
+      PN_float32 from_x0 = 0.0;
+      for (int to_x = 0; to_x < _x_size; ++to_x) {
+        PN_float32 from_x1 = (to_x + 1.0) * x_scale;
+        from_x1 = min(from_x1, (PN_float32)orig_x_size);
+
+        // Now the box from (from_x0, from_y0) - (from_x1, from_y1) but not
+        // including (from_x1, from_y1) maps to the pixel (to_x, to_y).
+        switch (num_channels) {
+        case 1:
+          from.box_filter_region(dest[0], from_x0, from_y0, from_x1, from_y1);
+          break;
+
+        case 2:
+          from.box_filter_region(*(LPoint2f *)dest, from_x0, from_y0, from_x1, from_y1);
+          break;
+
+        case 3:
+          from.box_filter_region(*(LPoint3f *)dest, from_x0, from_y0, from_x1, from_y1);
+          break;
+
+        case 4:
+          from.box_filter_region(*(LPoint4f *)dest, from_x0, from_y0, from_x1, from_y1);
+          break;
         }
-        from_y0 = from_y1;
-      }
-    }
-    break;
+        dest += num_channels;
 
-  case 3:
-    {
-      from_y0 = 0.0;
-      for (int to_y = 0; to_y < _y_size; ++to_y) {
-        from_y1 = (to_y + 1.0) * y_scale;
-        from_y1 = min(from_y1, (PN_float32)orig_y_size);
-
-        from_x0 = 0.0;
-        for (int to_x = 0; to_x < _x_size; ++to_x) {
-          from_x1 = (to_x + 1.0) * x_scale;
-          from_x1 = min(from_x1, (PN_float32)orig_x_size);
-
-          // Now the box from (from_x0, from_y0) - (from_x1, from_y1) but not
-          // including (from_x1, from_y1) maps to the pixel (to_x, to_y).
-          LPoint3f result;
-          from.box_filter_region(result, from_x0, from_y0, from_x1, from_y1);
-          new_data.push_back(result[0]);
-          new_data.push_back(result[1]);
-          new_data.push_back(result[2]);
-
-          from_x0 = from_x1;
-        }
-        from_y0 = from_y1;
+        from_x0 = from_x1;
       }
+      Thread::consider_yield();
     }
-    break;
-
-  case 4:
-    {
-      from_y0 = 0.0;
-      for (int to_y = 0; to_y < _y_size; ++to_y) {
-        from_y1 = (to_y + 1.0) * y_scale;
-        from_y1 = min(from_y1, (PN_float32)orig_y_size);
-
-        from_x0 = 0.0;
-        for (int to_x = 0; to_x < _x_size; ++to_x) {
-          from_x1 = (to_x + 1.0) * x_scale;
-          from_x1 = min(from_x1, (PN_float32)orig_x_size);
-
-          // Now the box from (from_x0, from_y0) - (from_x1, from_y1) but not
-          // including (from_x1, from_y1) maps to the pixel (to_x, to_y).
-          LPoint4f result;
-          from.box_filter_region(result, from_x0, from_y0, from_x1, from_y1);
-          new_data.push_back(result[0]);
-          new_data.push_back(result[1]);
-          new_data.push_back(result[2]);
-          new_data.push_back(result[3]);
-
-          from_x0 = from_x1;
-        }
-        from_y0 = from_y1;
-      }
-    }
-    break;
-
-  default:
-    nassert_raise("unexpected channel count");
-    return;
-  }
-
-  new_data.push_back(0.0);
-  new_data.push_back(0.0);
-  new_data.push_back(0.0);
-  new_data.push_back(0.0);
+  });
 
-  nassertv(new_data.size() == _table.size());
   _table.swap(new_data);
 }
 
@@ -1223,65 +1207,63 @@ xform(const LMatrix4f &transform) {
   nassertv(is_valid());
 
   int num_channels = get_num_channels();
-  switch (num_channels) {
-  case 1:
-    {
-      for (int yi = 0; yi < _y_size; ++yi) {
+  bool check = _has_no_data_value;
+
+  // If there is no perspective component, we don't need to divide by w.
+  bool affine = (transform.get_col(3) == LVecBase4f(0.0f, 0.0f, 0.0f, 1.0f));
+
+  get_job_runner().run_bands(_y_size, pfm_min_rows_per_job, [&] (int begin, int end) {
+    for (int yi = begin; yi < end; ++yi) {
+      switch (num_channels) {
+      case 1:
         for (int xi = 0; xi < _x_size; ++xi) {
-          if (!has_point(xi, yi)) {
+          if (check && !has_point(xi, yi)) {
             continue;
           }
           PN_float32 pi = get_point1(xi, yi);
           LPoint3f po = transform.xform_point(LPoint3f(pi, 0.0, 0.0));
           set_point1(xi, yi, po[0]);
         }
-      }
-    }
-    break;
+        break;
 
-  case 2:
-    {
-      for (int yi = 0; yi < _y_size; ++yi) {
+      case 2:
         for (int xi = 0; xi < _x_size; ++xi) {
-          if (!has_point(xi, yi)) {
+          if (check && !has_point(xi, yi)) {
             continue;
           }
           LPoint2f pi = get_point2(xi, yi);
           LPoint3f po = transform.xform_point(LPoint3f(pi[0], pi[1], 0.0));
           set_point2(xi, yi, LPoint2f(po[0], po[1]));
         }
-      }
-    }
-    break;
+        break;
 
-  case 3:
-    {
-      for (int yi = 0; yi < _y_size; ++yi) {
+      case 3:
         for (int xi = 0; xi < _x_size; ++xi) {
-          if (!has_point(xi, yi)) {
+          if (check && !has_point(xi, yi)) {
             continue;
           }
           LPoint3f &p = modify_point3(xi, yi);
-          transform.xform_point_general_in_place(p);
+          if (affine) {
+            transform.xform_point_in_place(p);
+          } else {
+            transform.xform_point_general_in_place(p);
+          }
         }
-      }
-    }
-    break;
+        break;
 
-  case 4:
-    {
-      for (int yi = 0; yi < _y_size; ++yi) {
+      case 4:
         for (int xi = 0; xi < _x_size; ++xi) {
-          if (!has_point(xi, yi)) {
+          if (check && !has_point(xi, yi)) {
             continue;
           }
           LPoint4f &p = modify_point4(xi, yi);
           transform.xform_in_place(p);
         }
+        break;
       }
+      Thread::consider_yield();
     }
-    break;
-  }
+  });
 }
 
 /**
@@ -1335,20 +1317,26 @@ forward_distort(const PfmFile &dist, PN_float32 scale_factor) {
     result.fill(_no_data_value);
   }
 
-  for (int yi = 0; yi < working_y_size; ++yi) {
-    for (int xi = 0; xi < working_x_size; ++xi) {
-      if (!dist_p->has_point(xi, yi)) {
-        continue;
-      }
-      LPoint2f uv = dist_p->get_point2(xi, yi);
-      LPoint3f p;
-      if (!source_p->calc_bilinear_point(p, uv[0], 1.0 - uv[1])) {
-        continue;
+  // Each row of the result is independent of the others.
+  get_job_runner().run_bands(working_y_size, pfm_min_rows_per_job, [&] (int begin, int end) {
+    for (int yi = begin; yi < end; ++yi) {
+      for (int xi = 0; xi < working_x_size; ++xi) {
+        if (!dist_p->has_point(xi, yi)) {
+          continue;
+        }
+        LPoint2f uv = dist_p->get_point2(xi, yi);
+        LPoint3f p;
+        if (!source_p->calc_bilinear_point(p, uv[0], 1.0 - uv[1])) {
+          continue;
+        }
+        nassertd(!p.is_nan()) {
+          continue;
+        }
+        result.set_point(xi, working_y_size - 1 - yi, p);
       }
-      nassertv(!p.is_nan());
-      result.set_point(xi, working_y_size - 1 - yi, p);
+      Thread::consider_yield();
     }
-  }
+  });
 
   // Resize to the target size for completion.
   result.resize(_x_size, _y_size);
@@ -1408,19 +1396,23 @@ reverse_distort(const PfmFile &dist, PN_float32 scale_factor) {
     result.fill(_no_data_value);
   }
 
-  for (int yi = 0; yi < working_y_size; ++yi) {
-    for (int xi = 0; xi < working_x_size; ++xi) {
-      if (!source_p->has_point(xi, yi)) {
-        continue;
-      }
-      LPoint2f uv = source_p->get_point2(xi, yi);
-      LPoint3f p;
-      if (!dist_p->calc_bilinear_point(p, uv[0], 1.0 - uv[1])) {
-        continue;
+  // Each row of the result is independent of the others.
+  get_job_runner().run_bands(working_y_size, pfm_min_rows_per_job, [&] (int begin, int end) {
+    for (int yi = begin; yi < end; ++yi) {
+      for (int xi = 0; xi < working_x_size; ++xi) {
+        if (!source_p->has_point(xi, yi)) {
+          continue;
+        }
+        LPoint2f uv = source_p->get_point2(xi, yi);
+        LPoint3f p;
+        if (!dist_p->calc_bilinear_point(p, uv[0], 1.0 - uv[1])) {
+          continue;
+        }
+        result.set_point(xi, yi, LPoint3f(p[0], 1.0 - p[1], p[2]));
       }
-      result.set_point(xi, yi, LPoint3f(p[0], 1.0 - p[1], p[2]));
+      Thread::consider_yield();
     }
-  }
+  });
 
   // Resize to the target size for completion.
   result.resize(_x_size, _y_size);
@@ -1647,30 +1639,8 @@ calc_tight_bounds(LPoint3f &min_point, LPoint3f &max_point) const {
   min_point.set(0.0f, 0.0f, 0.0f);
   max_point.set(0.0f, 0.0f, 0.0f);
 
-  bool found_any = false;
-  for (int yi = 0; yi < _y_size; ++yi) {
-    for (int xi = 0; xi < _x_size; ++xi) {
-      if (!has_point(xi, yi)) {
-        continue;
-      }
-
-      const LPoint3f &point = get_point(xi, yi);
-      if (!found_any) {
-        min_point = point;
-        max_point = point;
-        found_any = true;
-      } else {
-        min_point.set(min(min_point[0], point[0]),
-                      min(min_point[1], point[1]),
-                      min(min_point[2], point[2]));
-        max_point.set(max(max_point[0], point[0]),
-                      max(max_point[1], point[1]),
-                      max(max_point[2], point[2]));
-      }
-    }
-  }
-
-  return found_any;
+  return calc_table_min_max(*this, get_job_runner(), &pfm_identity,
+                            min_point, max_point);
 }
 
 /**
@@ -1757,40 +1727,17 @@ compute_planar_bounds(const LPoint2f &center, PN_float32 point_dist, PN_float32
       max_z = max(max_z, point[2]);
     }
   } else {
-    bool got_point = false;
-    for (int yi = 0; yi < _y_size; ++yi) {
-      for (int xi = 0; xi < _x_size; ++xi) {
-        if (!has_point(xi, yi)) {
-          continue;
-        }
-
-        LPoint3f point = get_point(xi, yi) * rinv;
-        if (!got_point) {
-          min_x = point[0];
-          min_y = point[1];
-          min_z = point[2];
-          max_x = point[0];
-          max_y = point[1];
-          max_z = point[2];
-          got_point = true;
-        } else {
-          min_x = min(min_x, point[0]);
-          min_y = min(min_y, point[1]);
-          min_z = min(min_z, point[2]);
-          max_x = max(max_x, point[0]);
-          max_y = max(max_y, point[1]);
-          max_z = max(max_z, point[2]);
-        }
-      }
-    }
-    if (!got_point) {
-      min_x = 0.0f;
-      min_y = 0.0f;
-      min_z = 0.0f;
-      max_x = 0.0f;
-      max_y = 0.0f;
-      max_z = 0.0f;
-    }
+    LVecBase3f min_point = LVecBase3f::zero();
+    LVecBase3f max_point = LVecBase3f::zero();
+    calc_table_min_max(*this, get_job_runner(),
+                       [&] (const LPoint3f &p) { return p * rinv; },
+                       min_point, max_point);
+    min_x = min_point[0];
+    min_y = min_point[1];
+    min_z = min_point[2];
+    max_x = max_point[0];
+    max_y = max_point[1];
+    max_z = max_point[2];
   }
 
   PT(BoundingHexahedron) bounds;
@@ -2718,6 +2665,18 @@ fill_mini_grid(MiniGridCell *mini_grid, int x_size, int y_size,
   }
 }
 
+/**
+ * Returns the job runner that is used to split up the bulk operations on a
+ * large file into bands of rows.  It is shared by all threads; its number of
+ * threads follows pfm-num-threads, which may be changed at runtime.
+ */
+ParallelJobRunner &PfmFile::
+get_job_runner() {
+  static ParallelJobRunner job_runner("pfm", pfm_num_threads);
+  job_runner.set_num_threads(pfm_num_threads);
+  return job_runner;
+}
+
 /**
  * The implementation of has_point() for files without a no_data_value.
  */
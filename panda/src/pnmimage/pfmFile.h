@@ -23,6 +23,7 @@
 class PNMImage;
 class PNMReader;
 class PNMWriter;
+class ParallelJobRunner;
 
 /**
  * Defines a pfm file, a 2-d table of floating-point numbers, either
@@ -220,6 +221,8 @@ private:
   void fill_mini_grid(MiniGridCell *mini_grid, int x_size, int y_size,
                       int xi, int yi, int dist, int sxi, int syi) const;
 
+  static ParallelJobRunner &get_job_runner();
+
   static bool has_point_noop(const PfmFile *file, int x, int y);
   static bool has_point_1(const PfmFile *file, int x, int y);
   static bool has_point_2(const PfmFile *file, int x, int y);
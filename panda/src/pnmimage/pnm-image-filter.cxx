@@ -24,19 +24,23 @@
 // The image is filtered first along one axis, then along the other.  This
 // decreases the complexity of the convolution operation: it is faster to
 // convolve twice with a one-dimensional kernel than once with a two-
-// dimensional kernel.  In the interim, a temporary matrix of type StoreType
-// (a numeric type, described below) is built which contains the results from
-// the first convolution.  The entire process is then repeated for each
-// channel in the image.
+// dimensional kernel.  In the interim, a temporary matrix is built which
+// contains the results from the first convolution.  All of the channels of
+// the image are filtered at once, as described further below.
 
 #include "pandabase.h"
 #include <math.h>
 #include "cmath.h"
 #include "thread.h"
+#include "parallelJobRunner.h"
+#include "pvector.h"
+#include "config_pnmimage.h"
 
 #include "pnmImage.h"
 #include "pfmFile.h"
 
+#include <algorithm>
+
 using std::max;
 using std::min;
 
@@ -95,150 +99,16 @@ static const WorkType source_max = 255;
 static const WorkType filter_max = 255;
 */
 
-// filter_row() filters a single row by convolving with a one-dimensional
-// kernel filter.  The kernel is defined by an array of weights in filter[],
-// where the ith element of filter corresponds to abs(d * scale), if
-// scale>1.0, and abs(d), if scale<=1.0, where d is the offset from the center
-// and varies from -filter_width to filter_width.
+// Each axis is filtered by convolving with a one-dimensional kernel filter.
+// The kernel is defined by an array of weights in filter[], where the ith
+// element of filter corresponds to abs(d * scale), if scale>1.0, and abs(d),
+// if scale<=1.0, where d is the offset from the center and varies from
+// -filter_width to filter_width.
 
 // Note that filter_width is not necessarily the length of the array; it is
 // the radius of interest of the filter function.  The array may need to be
 // larger (by a factor of scale), to adequately cover all the values.
 
-static void
-filter_row(StoreType dest[], int dest_len,
-           const StoreType source[], int source_len,
-           float scale,                    //  == dest_len / source_len
-           const WorkType filter[],
-           float filter_width,
-           int actual_width) {
-  // If we are expanding the row (scale > 1.0), we need to look at a
-  // fractional granularity.  Hence, we scale our filter index by scale.  If
-  // we are compressing (scale < 1.0), we don't need to fiddle with the filter
-  // index, so we leave it at one.
-
-  float iscale;
-  if (scale < 1.0f) {
-    iscale = 1.0f;
-    filter_width /= scale;
-  } else {
-    iscale = scale;
-  }
-
-  for (int dest_x = 0; dest_x < dest_len; dest_x++) {
-    // The additional offset of 0.5 keeps the pixel centered.
-    float center = (dest_x + 0.5f) / scale - 0.5f;
-
-    // left and right are the starting and ending ranges of the radius of
-    // interest of the filter function.  We need to apply the filter to each
-    // value in this range.
-    int left = max((int)cfloor(center - filter_width), 0);
-    int right = min((int)cceil(center + filter_width), source_len - 1);
-
-    // right_center is the point just to the right of the center.  This allows
-    // us to flip the sign of the offset when we cross the center point.
-    int right_center = (int)cceil(center);
-
-    WorkType net_weight = 0;
-    WorkType net_value = 0;
-
-    int index, source_x;
-
-    // This loop is broken into two pieces--the left of center and the right
-    // of center--so we don't have to incur the overhead of calling fabs()
-    // each time through the loop.
-    for (source_x = left; source_x < right_center; source_x++) {
-      index = (int)cfloor(iscale * (center - source_x) + 0.5f);
-      nassertv(index >= 0 && index < actual_width);
-      net_value += filter[index] * source[source_x];
-      net_weight += filter[index];
-    }
-
-    for (; source_x <= right; source_x++) {
-      index = (int)cfloor(iscale * (source_x - center) + 0.5f);
-      nassertv(index >= 0 && index < actual_width);
-      net_value += filter[index] * source[source_x];
-      net_weight += filter[index];
-    }
-
-    if (net_weight > 0) {
-      dest[dest_x] = (StoreType)(net_value / net_weight);
-    } else {
-      dest[dest_x] = 0;
-    }
-  }
-  Thread::consider_yield();
-}
-
-// As above, but we also accept an array of weight values per element, to
-// support scaling a sparse array (as in a PfmFile).
-static void
-filter_sparse_row(StoreType dest[], StoreType dest_weight[], int dest_len,
-                  const StoreType source[], const StoreType source_weight[], int source_len,
-                  float scale,                    //  == dest_len / source_len
-                  const WorkType filter[],
-                  float filter_width,
-                  int actual_width) {
-  // If we are expanding the row (scale > 1.0), we need to look at a
-  // fractional granularity.  Hence, we scale our filter index by scale.  If
-  // we are compressing (scale < 1.0), we don't need to fiddle with the filter
-  // index, so we leave it at one.
-
-  float iscale;
-  if (scale < 1.0f) {
-    iscale = 1.0f;
-    filter_width /= scale;
-  } else {
-    iscale = scale;
-  }
-
-  for (int dest_x = 0; dest_x < dest_len; dest_x++) {
-    // The additional offset of 0.5 keeps the pixel centered.
-    float center = (dest_x + 0.5f) / scale - 0.5f;
-
-    // left and right are the starting and ending ranges of the radius of
-    // interest of the filter function.  We need to apply the filter to each
-    // value in this range.
-    int left = max((int)cfloor(center - filter_width), 0);
-    int right = min((int)cceil(center + filter_width), source_len - 1);
-
-    // right_center is the point just to the right of the center.  This allows
-    // us to flip the sign of the offset when we cross the center point.
-    int right_center = (int)cceil(center);
-
-    WorkType net_weight = 0;
-    WorkType net_value = 0;
-
-    int index, source_x;
-
-    // This loop is broken into two pieces--the left of center and the right
-    // of center--so we don't have to incur the overhead of calling fabs()
-    // each time through the loop.
-    for (source_x = left; source_x < right_center; source_x++) {
-      index = (int)cfloor(iscale * (center - source_x) + 0.5f);
-      nassertv(index >= 0 && index < actual_width);
-      net_value += filter[index] * source[source_x] * source_weight[source_x];
-      net_weight += filter[index] * source_weight[source_x];
-    }
-
-    for (; source_x <= right; source_x++) {
-      index = (int)cfloor(iscale * (source_x - center) + 0.5f);
-      nassertv(index >= 0 && index < actual_width);
-      net_value += filter[index] * source[source_x] * source_weight[source_x];
-      net_weight += filter[index] * source_weight[source_x];
-    }
-
-    if (net_weight > 0) {
-      dest[dest_x] = (StoreType)(net_value / net_weight);
-    } else {
-      dest[dest_x] = 0;
-    }
-    dest_weight[dest_x] = (StoreType)net_weight;
-  }
-  Thread::consider_yield();
-}
-
-
 // The various filter functions are called before each axis scaling to build
 // an kernel array suitable for the given scaling factor.  Given a scaling
 // ratio of the axis (dest_len  source_len), and a width parameter supplied by
@@ -328,216 +198,308 @@ gaussian_filter_impl(float scale, float width,
 }
 
 
-// We have a function, defined in pnm-image-filter-core.cxx, that will scale
-// an image in both X and Y directions for a particular channel, by setting up
-// the temporary matrix appropriately and calling the above functions.
-
-// What we really need is a series of such functions, one for each channel,
-// and also one to scale by X first, and one to scale by Y first.  This sounds
-// a lot like a C++ template: we want to compile the same function several
-// times to work on slightly different sorts of things each time.  However,
-// the things we want to vary are the particular member functions of PNMImage
-// that we call (e.g.  Red(), Green(), etc.), and we can't declare a template
-// of member functions, only of types.
-
-// It's doable using templates.  It would involve the declaration of lots of
-// silly little functor objects.  This is much more compact and no more
-// difficult to read.
-
-// The function in pnm-image-filter-core.cxx uses macros to access the member
-// functions of PNMImage.  Hence, we only need to redefine those macros with
-// each instance of the function to cause each instance to operate on the
-// correct member.
-
-
-// These instances scale by X first, then by Y.
-
-#define FUNCTION_NAME filter_red_xy
-#define IMAGETYPE PNMImage
-#define ASIZE get_x_size
-#define BSIZE get_y_size
-#define GETVAL(a, b, channel) get_red(a, b)
-#define SETVAL(a, b, channel, v) set_red(a, b, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
-
-#define FUNCTION_NAME filter_green_xy
-#define IMAGETYPE PNMImage
-#define ASIZE get_x_size
-#define BSIZE get_y_size
-#define GETVAL(a, b, channel) get_green(a, b)
-#define SETVAL(a, b, channel, v) set_green(a, b, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
-
-#define FUNCTION_NAME filter_blue_xy
-#define IMAGETYPE PNMImage
-#define ASIZE get_x_size
-#define BSIZE get_y_size
-#define GETVAL(a, b, channel) get_blue(a, b)
-#define SETVAL(a, b, channel, v) set_blue(a, b, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
-
-#define FUNCTION_NAME filter_gray_xy
-#define IMAGETYPE PNMImage
-#define ASIZE get_x_size
-#define BSIZE get_y_size
-#define GETVAL(a, b, channel) get_bright(a, b)
-#define SETVAL(a, b, channel, v) set_xel(a, b, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
-
-#define FUNCTION_NAME filter_alpha_xy
-#define IMAGETYPE PNMImage
-#define ASIZE get_x_size
-#define BSIZE get_y_size
-#define GETVAL(a, b, channel) get_alpha(a, b)
-#define SETVAL(a, b, channel, v) set_alpha(a, b, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
-
-
-// These instances scale by Y first, then by X.
-
-#define FUNCTION_NAME filter_red_yx
-#define IMAGETYPE PNMImage
-#define ASIZE get_y_size
-#define BSIZE get_x_size
-#define GETVAL(a, b, channel) get_red(b, a)
-#define SETVAL(a, b, channel, v) set_red(b, a, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
-
-#define FUNCTION_NAME filter_green_yx
-#define IMAGETYPE PNMImage
-#define ASIZE get_y_size
-#define BSIZE get_x_size
-#define GETVAL(a, b, channel) get_green(b, a)
-#define SETVAL(a, b, channel, v) set_green(b, a, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
-
-#define FUNCTION_NAME filter_blue_yx
-#define IMAGETYPE PNMImage
-#define ASIZE get_y_size
-#define BSIZE get_x_size
-#define GETVAL(a, b, channel) get_blue(b, a)
-#define SETVAL(a, b, channel, v) set_blue(b, a, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
-
-#define FUNCTION_NAME filter_gray_yx
-#define IMAGETYPE PNMImage
-#define ASIZE get_y_size
-#define BSIZE get_x_size
-#define GETVAL(a, b, channel) get_bright(b, a)
-#define SETVAL(a, b, channel, v) set_xel(b, a, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
-
-#define FUNCTION_NAME filter_alpha_yx
-#define IMAGETYPE PNMImage
-#define ASIZE get_y_size
-#define BSIZE get_x_size
-#define GETVAL(a, b, channel) get_alpha(b, a)
-#define SETVAL(a, b, channel, v) set_alpha(b, a, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
+// The weights that the kernel applies are computed just once for each
+// destination pixel along each axis, and normalized up front.  All of the
+// channels of the image are then filtered together, one row at a time, in
+// rows of floats in which the channels are interleaved.  The inner loops
+// therefore run over contiguous memory, with no per-pixel index arithmetic,
+// which allows the compiler to vectorize them.
 
+// The image is first filtered horizontally, row by row, into a temporary
+// matrix; then each row of the destination image is computed as a weighted
+// sum of rows of that matrix.  Each of these passes is split into bands of
+// rows, which may be handed to the threads of pnmimage-filter-num-threads
+// (or pfm-num-threads, for a PfmFile).
 
-// filter_image pulls everything together, and filters one image into another.
-// Both images can be the same with no ill effects.
-static void
-filter_image(PNMImage &dest, const PNMImage &source,
-             float width, FilterFunction *make_filter) {
+class PNMFilterWeights {
+public:
+  void compute(int dest_len, int source_len, float width,
+               FilterFunction *make_filter);
 
-  // We want to scale by the smallest destination axis first, for a slight
-  // performance gain.
+  INLINE const float *get_weights(int dest_x) const;
+  INLINE int get_num_weights(int dest_x) const;
 
-  // In the PNMImage case (unlike the PfmFile case), the channel parameter is
-  // not used.  We *could* use it to avoid the replication of quite so many
-  // functions, but we replicate them anyway, for another tiny performance
-  // gain.
+  // For each destination pixel, the first source pixel that contributes to
+  // it, and the start of its normalized weights within _weights.  These
+  // weights apply to consecutive source pixels.
+  pvector<int> _first;
+  pvector<int> _begin;
+  pvector<float> _weights;
+};
 
-  if (dest.get_x_size() <= dest.get_y_size()) {
-    if (dest.is_grayscale() || source.is_grayscale()) {
-      filter_gray_xy(dest, source, width, make_filter, 0);
-    } else {
-      filter_red_xy(dest, source, width, make_filter, 0);
-      filter_green_xy(dest, source, width, make_filter, 0);
-      filter_blue_xy(dest, source, width, make_filter, 0);
+/**
+ * Fills in the weights for scaling an axis of source_len pixels to dest_len
+ * pixels with the indicated filter.  The weights are the same as those
+ * applied by the kernel, but normalized.
+ */
+void PNMFilterWeights::
+compute(int dest_len, int source_len, float width,
+        FilterFunction *make_filter) {
+  float scale = (float)dest_len / (float)source_len;
+
+  WorkType *filter;
+  float filter_width;
+  int actual_width;
+  make_filter(scale, width, filter, filter_width, actual_width);
+
+  float iscale;
+  if (scale < 1.0f) {
+    iscale = 1.0f;
+    filter_width /= scale;
+  } else {
+    iscale = scale;
+  }
+
+  _first.resize(dest_len);
+  _begin.resize(dest_len + 1);
+  _weights.clear();
+  _begin[0] = 0;
+
+  for (int dest_x = 0; dest_x < dest_len; dest_x++) {
+    float center = (dest_x + 0.5f) / scale - 0.5f;
+    int left = max((int)cfloor(center - filter_width), 0);
+    int right = min((int)cceil(center + filter_width), source_len - 1);
+    int right_center = (int)cceil(center);
+
+    size_t begin = _weights.size();
+    int first = left;
+    WorkType net_weight = 0;
+
+    for (int source_x = left; source_x <= right; source_x++) {
+      float offset = (source_x < right_center) ? (center - source_x) : (source_x - center);
+      int index = (int)cfloor(iscale * offset + 0.5f);
+      nassertd(index >= 0 && index < actual_width) {
+        index = actual_width - 1;
+      }
+      WorkType weight = filter[index];
+
+      if (weight == 0 && _weights.size() == begin) {
+        // Skip the leading zeroes.
+        first = source_x + 1;
+        continue;
+      }
+      _weights.push_back((float)weight);
+      net_weight += weight;
     }
 
-    if (dest.has_alpha() && source.has_alpha()) {
-      filter_alpha_xy(dest, source, width, make_filter, 0);
+    // And the trailing ones.
+    while (_weights.size() > begin && _weights.back() == 0.0f) {
+      _weights.pop_back();
     }
 
-  } else {
-    if (dest.is_grayscale() || source.is_grayscale()) {
-      filter_gray_yx(dest, source, width, make_filter, 0);
+    if (net_weight > 0) {
+      for (size_t i = begin; i < _weights.size(); ++i) {
+        _weights[i] = (float)(_weights[i] / net_weight);
+      }
     } else {
-      filter_red_yx(dest, source, width, make_filter, 0);
-      filter_green_yx(dest, source, width, make_filter, 0);
-      filter_blue_yx(dest, source, width, make_filter, 0);
+      _weights.resize(begin);
     }
 
-    if (dest.has_alpha() && source.has_alpha()) {
-      filter_alpha_yx(dest, source, width, make_filter, 0);
+    _first[dest_x] = first;
+    _begin[dest_x + 1] = (int)_weights.size();
+  }
+
+  PANDA_FREE_ARRAY(filter);
+}
+
+/**
+ * Returns the normalized weights that contribute to the indicated destination
+ * pixel.
+ */
+INLINE const float *PNMFilterWeights::
+get_weights(int dest_x) const {
+  return _weights.data() + _begin[dest_x];
+}
+
+/**
+ * Returns the number of source pixels that contribute to the indicated
+ * destination pixel.
+ */
+INLINE int PNMFilterWeights::
+get_num_weights(int dest_x) const {
+  return _begin[dest_x + 1] - _begin[dest_x];
+}
+
+/**
+ * Filters one row of num_channels interleaved channels horizontally.
+ */
+template<int num_channels>
+static void
+filter_interleaved_row(float *dest, int dest_len, const float *source,
+                       const PNMFilterWeights &weights) {
+  for (int dest_x = 0; dest_x < dest_len; dest_x++) {
+    const float *weight = weights.get_weights(dest_x);
+    int num_weights = weights.get_num_weights(dest_x);
+    const float *value = source + weights._first[dest_x] * num_channels;
+
+    float sum[num_channels];
+    for (int c = 0; c < num_channels; ++c) {
+      sum[c] = 0.0f;
+    }
+    for (int i = 0; i < num_weights; ++i) {
+      for (int c = 0; c < num_channels; ++c) {
+        sum[c] += weight[i] * value[c];
+      }
+      value += num_channels;
+    }
+    for (int c = 0; c < num_channels; ++c) {
+      dest[c] = sum[c];
+    }
+    dest += num_channels;
+  }
+}
+
+/**
+ * Computes one row as the weighted sum of the consecutive rows of the matrix
+ * beginning at the indicated row.
+ */
+static void
+filter_matrix_rows(float *dest, const float *matrix, size_t row_length,
+                   int first_row, const float *weight, int num_weights) {
+  std::fill(dest, dest + row_length, 0.0f);
+
+  const float *source = matrix + first_row * row_length;
+  for (int i = 0; i < num_weights; ++i) {
+    float w = weight[i];
+    for (size_t j = 0; j < row_length; ++j) {
+      dest[j] += w * source[j];
     }
+    source += row_length;
   }
 }
 
+// Don't bother handing out fewer rows than this to a thread.
+static const int filter_min_rows_per_job = 16;
+
+/**
+ * Returns the job runner that is used to split up the filtering of a large
+ * image.  It is created once, and may be shared by any number of threads; its
+ * number of threads follows pnmimage-filter-num-threads.
+ */
+static ParallelJobRunner &
+get_filter_job_runner() {
+  static ParallelJobRunner job_runner("pnmimage_filter", pnmimage_filter_num_threads);
+  job_runner.set_num_threads(pnmimage_filter_num_threads);
+  return job_runner;
+}
+
+// filter_image pulls everything together, and filters one image into another.
+// Both images can be the same with no ill effects.
+static void
+filter_image(PNMImage &dest, const PNMImage &source,
+             float width, FilterFunction *make_filter) {
+  if (!dest.is_valid() || !source.is_valid()) {
+    return;
+  }
+
+  // A grayscale image is filtered by brightness only.  The alpha channel is
+  // interleaved after the color channels.
+  bool gray = (dest.is_grayscale() || source.is_grayscale());
+  bool alpha = (dest.has_alpha() && source.has_alpha());
+  int num_channels = (gray ? 1 : 3) + (alpha ? 1 : 0);
+
+  int source_x_size = source.get_x_size();
+  int source_y_size = source.get_y_size();
+  int dest_x_size = dest.get_x_size();
+  int dest_y_size = dest.get_y_size();
+
+  PNMFilterWeights x_weights, y_weights;
+  x_weights.compute(dest_x_size, source_x_size, width, make_filter);
+  y_weights.compute(dest_y_size, source_y_size, width, make_filter);
+
+  size_t row_length = (size_t)dest_x_size * num_channels;
+  pvector<float> matrix((size_t)source_y_size * row_length);
+
+  // These are the weights that get_bright() would use for the source image.
+  LVecBase3f bright_weights = source.is_grayscale()
+    ? LVecBase3f(0.0f, 0.0f, 1.0f)
+    : LVecBase3f(lumin_red, lumin_grn, lumin_blu);
+
+  const xel *source_array = source.get_array();
+  const xelval *source_alpha_array = source.get_alpha_array();
+
+  ParallelJobRunner &job_runner = get_filter_job_runner();
+
+  // First, scale each row of the source image in the X direction.  The pixels
+  // are read straight from the source arrays, rather than through the
+  // per-pixel accessors, which check their bounds on every call.
+  job_runner.run_bands(source_y_size, filter_min_rows_per_job, [&](int begin, int end) {
+    pvector<float> row((size_t)source_x_size * num_channels);
+
+    for (int y = begin; y < end; y++) {
+      const xel *source_row = source_array + (size_t)y * source_x_size;
+      const xelval *source_alpha_row = alpha ? source_alpha_array + (size_t)y * source_x_size : nullptr;
+
+      float *p = row.data();
+      for (int x = 0; x < source_x_size; x++) {
+        LRGBColorf color = source.from_val(source_row[x]);
+        if (gray) {
+          *p++ = color.dot(bright_weights);
+        } else {
+          *p++ = color[0];
+          *p++ = color[1];
+          *p++ = color[2];
+        }
+        if (alpha) {
+          *p++ = source.from_alpha_val(source_alpha_row[x]);
+        }
+      }
+
+      float *dest_row = matrix.data() + y * row_length;
+      switch (num_channels) {
+      case 1:
+        filter_interleaved_row<1>(dest_row, dest_x_size, row.data(), x_weights);
+        break;
+      case 2:
+        filter_interleaved_row<2>(dest_row, dest_x_size, row.data(), x_weights);
+        break;
+      case 3:
+        filter_interleaved_row<3>(dest_row, dest_x_size, row.data(), x_weights);
+        break;
+      case 4:
+        filter_interleaved_row<4>(dest_row, dest_x_size, row.data(), x_weights);
+        break;
+      }
+      Thread::consider_yield();
+    }
+  });
+
+  xel *dest_array = dest.get_array();
+  xelval *dest_alpha_array = dest.get_alpha_array();
+
+  // Now, scale the result in the Y direction, storing each row as it is
+  // computed.
+  job_runner.run_bands(dest_y_size, filter_min_rows_per_job, [&](int begin, int end) {
+    pvector<float> row(row_length);
+
+    for (int y = begin; y < end; y++) {
+      filter_matrix_rows(row.data(), matrix.data(), row_length,
+                         y_weights._first[y], y_weights.get_weights(y),
+                         y_weights.get_num_weights(y));
+
+      xel *dest_row = dest_array + (size_t)y * dest_x_size;
+      xelval *dest_alpha_row = alpha ? dest_alpha_array + (size_t)y * dest_x_size : nullptr;
+
+      const float *p = row.data();
+      for (int x = 0; x < dest_x_size; x++) {
+        if (gray) {
+          // As set_xel() does, store the gray level in all three channels.
+          xelval gray_val = dest.to_val(p[0]);
+          PPM_ASSIGN(dest_row[x], gray_val, gray_val, gray_val);
+          ++p;
+        } else {
+          dest_row[x] = dest.to_val(LRGBColorf(p[0], p[1], p[2]));
+          p += 3;
+        }
+        if (alpha) {
+          dest_alpha_row[x] = dest.to_alpha_val(*p++);
+        }
+      }
+      Thread::consider_yield();
+    }
+  });
+}
+
 /**
  * Makes a resized copy of the indicated image into this one using the
  * indicated filter.  The image to be copied is squashed and stretched to
@@ -560,104 +522,123 @@ gaussian_filter_from(float width, const PNMImage &copy) {
   filter_image(*this, copy, width, &gaussian_filter_impl);
 }
 
-// Now we do it again, this time for PfmFile.  In this case we also need to
-// support the sparse variants, since PfmFiles can be incomplete.  However, we
-// don't need to have a different function for each channel.
-
-#define FUNCTION_NAME filter_pfm_xy
-#define IMAGETYPE PfmFile
-#define ASIZE get_x_size
-#define BSIZE get_y_size
-#define GETVAL(a, b, channel) get_channel(a, b, channel)
-#define SETVAL(a, b, channel, v) set_channel(a, b, channel, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
-
-#define FUNCTION_NAME filter_pfm_yx
-#define IMAGETYPE PfmFile
-#define ASIZE get_y_size
-#define BSIZE get_x_size
-#define GETVAL(a, b, channel) get_channel(b, a, channel)
-#define SETVAL(a, b, channel, v) set_channel(b, a, channel, v)
-#include "pnm-image-filter-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
-
-
-#define FUNCTION_NAME filter_pfm_sparse_xy
-#define IMAGETYPE PfmFile
-#define ASIZE get_x_size
-#define BSIZE get_y_size
-#define HASVAL(a, b) has_point(a, b)
-#define GETVAL(a, b, channel) get_channel(a, b, channel)
-#define SETVAL(a, b, channel, v) set_channel(a, b, channel, v)
-#include "pnm-image-filter-sparse-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef HASVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
-
-#define FUNCTION_NAME filter_pfm_sparse_yx
-#define IMAGETYPE PfmFile
-#define ASIZE get_y_size
-#define BSIZE get_x_size
-#define HASVAL(a, b) has_point(b, a)
-#define GETVAL(a, b, channel) get_channel(b, a, channel)
-#define SETVAL(a, b, channel, v) set_channel(b, a, channel, v)
-#include "pnm-image-filter-sparse-core.cxx"
-#undef SETVAL
-#undef GETVAL
-#undef HASVAL
-#undef BSIZE
-#undef ASIZE
-#undef IMAGETYPE
-#undef FUNCTION_NAME
 
+// The PfmFile filter works the same way, reading the channels straight from
+// the table.  A PfmFile may also be sparse, in which case an additional
+// channel holding the coverage of each point (1 or 0) is filtered along with
+// the others, which are premultiplied by it.  This is equivalent to
+// normalizing each pass by the net weight of the points that are present.
+// Points of the result that no source point contributes to are left
+// untouched.
 
 // filter_image pulls everything together, and filters one image into another.
 // Both images can be the same with no ill effects.
 static void
 filter_image(PfmFile &dest, const PfmFile &source,
-             float width, FilterFunction *make_filter) {
-  int num_channels = min(dest.get_num_channels(), source.get_num_channels());
+             float width, FilterFunction *make_filter,
+             ParallelJobRunner &job_runner) {
+  if (!dest.is_valid() || !source.is_valid()) {
+    return;
+  }
 
-  if (source.has_no_data_value()) {
-    // We need to use the sparse variant.
-    if (dest.get_x_size() <= dest.get_y_size()) {
-      for (int ci = 0; ci < num_channels; ++ci) {
-        filter_pfm_sparse_xy(dest, source, width, make_filter, ci);
+  int num_channels = min(dest.get_num_channels(), source.get_num_channels());
+  int source_channels = source.get_num_channels();
+  bool sparse = source.has_no_data_value();
+  int matrix_channels = num_channels + (sparse ? 1 : 0);
+
+  int source_x_size = source.get_x_size();
+  int source_y_size = source.get_y_size();
+  int dest_x_size = dest.get_x_size();
+  int dest_y_size = dest.get_y_size();
+
+  PNMFilterWeights x_weights, y_weights;
+  x_weights.compute(dest_x_size, source_x_size, width, make_filter);
+  y_weights.compute(dest_y_size, source_y_size, width, make_filter);
+
+  size_t row_length = (size_t)dest_x_size * matrix_channels;
+  pvector<float> matrix((size_t)source_y_size * row_length);
+
+  const PN_float32 *source_table = source.get_table().data();
+
+  // First, scale each row of the source image in the X direction.
+  job_runner.run_bands(source_y_size, filter_min_rows_per_job, [&](int begin, int end) {
+    pvector<float> row((size_t)source_x_size * matrix_channels);
+
+    for (int y = begin; y < end; y++) {
+      const PN_float32 *source_row = source_table + (size_t)y * source_x_size * source_channels;
+      const float *input = source_row;
+
+      if (sparse || source_channels != matrix_channels) {
+        // We need to copy the row to extract the channels we need.
+        const PN_float32 *s = source_row;
+        float *p = row.data();
+        for (int x = 0; x < source_x_size; x++) {
+          if (sparse && !source.has_point(x, y)) {
+            for (int c = 0; c < matrix_channels; ++c) {
+              *p++ = 0.0f;
+            }
+          } else {
+            for (int c = 0; c < num_channels; ++c) {
+              *p++ = s[c];
+            }
+            if (sparse) {
+              *p++ = 1.0f;
+            }
+          }
+          s += source_channels;
+        }
+        input = row.data();
       }
 
-    } else {
-      for (int ci = 0; ci < num_channels; ++ci) {
-        filter_pfm_sparse_yx(dest, source, width, make_filter, ci);
+      float *dest_row = matrix.data() + y * row_length;
+      switch (matrix_channels) {
+      case 1:
+        filter_interleaved_row<1>(dest_row, dest_x_size, input, x_weights);
+        break;
+      case 2:
+        filter_interleaved_row<2>(dest_row, dest_x_size, input, x_weights);
+        break;
+      case 3:
+        filter_interleaved_row<3>(dest_row, dest_x_size, input, x_weights);
+        break;
+      case 4:
+        filter_interleaved_row<4>(dest_row, dest_x_size, input, x_weights);
+        break;
+      case 5:
+        filter_interleaved_row<5>(dest_row, dest_x_size, input, x_weights);
+        break;
       }
+      Thread::consider_yield();
     }
-  } else {
-    // We can use the slightly faster fully-specified variant.
-    if (dest.get_x_size() <= dest.get_y_size()) {
-      for (int ci = 0; ci < num_channels; ++ci) {
-        filter_pfm_xy(dest, source, width, make_filter, ci);
-      }
-
-    } else {
-      for (int ci = 0; ci < num_channels; ++ci) {
-        filter_pfm_yx(dest, source, width, make_filter, ci);
+  });
+
+  // Now, scale the result in the Y direction, storing each row as it is
+  // computed.
+  job_runner.run_bands(dest_y_size, filter_min_rows_per_job, [&](int begin, int end) {
+    pvector<float> row(row_length);
+
+    for (int y = begin; y < end; y++) {
+      filter_matrix_rows(row.data(), matrix.data(), row_length,
+                         y_weights._first[y], y_weights.get_weights(y),
+                         y_weights.get_num_weights(y));
+
+      const float *p = row.data();
+      for (int x = 0; x < dest_x_size; x++) {
+        if (!sparse) {
+          for (int c = 0; c < num_channels; ++c) {
+            dest.set_channel(x, y, c, p[c]);
+          }
+        } else if (p[num_channels] != 0.0f) {
+          float coverage = p[num_channels];
+          for (int c = 0; c < num_channels; ++c) {
+            dest.set_channel(x, y, c, p[c] / coverage);
+          }
+        }
+        p += matrix_channels;
       }
+      Thread::consider_yield();
     }
-  }
+  });
 }
 
 /**
@@ -668,7 +649,7 @@ filter_image(PfmFile &dest, const PfmFile &source,
  */
 void PfmFile::
 box_filter_from(float width, const PfmFile &copy) {
-  filter_image(*this, copy, width, &box_filter_impl);
+  filter_image(*this, copy, width, &box_filter_impl, get_job_runner());
 }
 
 /**
@@ -679,7 +660,7 @@ box_filter_from(float width, const PfmFile &copy) {
  */
 void PfmFile::
 gaussian_filter_from(float width, const PfmFile &copy) {
-  filter_image(*this, copy, width, &gaussian_filter_impl);
+  filter_image(*this, copy, width, &gaussian_filter_impl, get_job_runner());
 }
 
 // The following functions are support for quick_box_filter().
@@ -777,36 +758,38 @@ quick_filter_from(const PNMImage &from, int xborder, int yborder) {
   int to_xoff = xborder / 2;
   int to_yoff = yborder / 2;
 
-  float from_x0, from_x1, from_y0, from_y1;
-  int to_x, to_y;
-
   float x_scale = (float)from_xs / (float)to_xs;
   float y_scale = (float)from_ys / (float)to_ys;
 
-  LColorf color;
+  int x_begin = max(0, -to_xoff);
+  int x_end = min(to_xs, get_x_size() - to_xoff);
+  int y_begin = max(0, -to_yoff);
+  int y_end = min(to_ys, get_y_size() - to_yoff);
+  if (y_end <= y_begin) {
+    return;
+  }
 
-  from_y0 = max(0, -to_yoff) * y_scale;
-  for (to_y = max(0, -to_yoff);
-       to_y < min(to_ys, get_y_size()-to_yoff);
-       to_y++) {
-    from_y1 = (to_y+1) * y_scale;
+  // Each row is independent of the others, so the rows may be split up
+  // among several threads.
+  get_filter_job_runner().run_bands(y_end - y_begin, filter_min_rows_per_job, [&](int begin, int end) {
+    for (int to_y = y_begin + begin; to_y < y_begin + end; to_y++) {
+      float from_y0 = to_y * y_scale;
+      float from_y1 = (to_y + 1) * y_scale;
 
-    from_x0 = max(0, -to_xoff) * x_scale;
-    for (to_x = max(0, -to_xoff);
-         to_x < min(to_xs, get_x_size()-to_xoff);
-         to_x++) {
-      from_x1 = (to_x+1) * x_scale;
+      float from_x0 = x_begin * x_scale;
+      for (int to_x = x_begin; to_x < x_end; to_x++) {
+        float from_x1 = (to_x + 1) * x_scale;
 
-      // Now the box from (from_x0, from_y0) - (from_x1, from_y1) but not
-      // including (from_x1, from_y1) maps to the pixel (to_x, to_y).
-      color = box_filter_region(from,
-                                from_x0, from_y0, from_x1, from_y1);
+        // Now the box from (from_x0, from_y0) - (from_x1, from_y1) but not
+        // including (from_x1, from_y1) maps to the pixel (to_x, to_y).
+        LColorf color = box_filter_region(from,
+                                          from_x0, from_y0, from_x1, from_y1);
 
-      set_xel_a(to_xoff + to_x, to_yoff + to_y, color);
+        set_xel_a(to_xoff + to_x, to_yoff + to_y, color);
 
-      from_x0 = from_x1;
+        from_x0 = from_x1;
+      }
+      Thread::consider_yield();
     }
-    from_y0 = from_y1;
-    Thread::consider_yield();
-  }
+  });
 }
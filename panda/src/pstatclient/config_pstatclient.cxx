@@ -12,6 +12,9 @@
  */
 
 #include "config_pstatclient.h"
+#include "pStatCollector.h"
+#include "pStatCollectorForward.h"
+#include "virtualFileSystem.h"
 
 #include "dconfig.h"
 
@@ -110,4 +113,10 @@ init_libpstatclient() {
     return;
   }
   initialized = true;
+
+#ifdef DO_PSTATS
+  VirtualFileSystem::set_lookup_cache_collectors
+    (new PStatCollectorForward(PStatCollector("VFS lookups:Cache hits")),
+     new PStatCollectorForward(PStatCollector("VFS lookups:Cache misses")));
+#endif
 }
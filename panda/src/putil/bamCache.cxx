@@ -25,7 +25,27 @@
 #include "configVariableInt.h"
 #include "configVariableString.h"
 #include "configVariableFilename.h"
+#include "configVariableEnum.h"
 #include "virtualFileSystem.h"
+#include "genericThread.h"
+#include "lz4Stream.h"
+#include "zstdStream.h"
+#include "zStream.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <errno.h>
+#endif  // _WIN32
+
+#if defined(__ANDROID__) && !defined(PHAVE_LOCKF)
+// Needed for flock.
+#include <sys/file.h>
+#endif
 
 using std::istream;
 using std::ostream;
@@ -34,6 +54,179 @@ using std::string;
 
 BamCache *BamCache::_global_ptr = nullptr;
 
+/**
+ * Returns the checksum stored with each journal entry, to detect a damaged
+ * entry.  This is the 32-bit FNV-1a hash.
+ */
+static uint32_t
+journal_checksum(const Datagram &payload) {
+  const unsigned char *data = (const unsigned char *)payload.get_data();
+  uint32_t hash = 0x811c9dc5;
+  for (size_t i = 0; i < payload.get_length(); ++i) {
+    hash = (hash ^ data[i]) * 0x01000193;
+  }
+  return hash;
+}
+
+/**
+ * Holds an exclusive lock on a journal file while it exists, which is honored
+ * by every process sharing the cache.  This serializes the appends, which are
+ * not guaranteed to be atomic on all platforms, and keeps a process from
+ * reading and deleting the journal of a replaced index while another process
+ * is still appending to it.
+ *
+ * The journal is never created here; if it doesn't exist, it must belong to
+ * an index that has already been replaced.  A journal that is not on the
+ * real filesystem, such as on a ramdisk, is not visible to other processes,
+ * so it is only locked by BamCache's own mutex.
+ */
+class JournalLock {
+public:
+  JournalLock(const Filename &journal_pathname);
+  ~JournalLock();
+
+  bool exists() const { return _exists; }
+  bool append(const Datagram &entry);
+
+private:
+  Filename _journal_pathname;
+  bool _exists;
+#ifdef _WIN32
+  HANDLE _handle;
+#else
+  int _fd;
+#endif
+};
+
+/**
+ * Opens the indicated journal file, if it exists, and waits until it can be
+ * locked.
+ */
+JournalLock::
+JournalLock(const Filename &journal_pathname) :
+  _journal_pathname(journal_pathname),
+  _exists(false)
+{
+#ifdef _WIN32
+  _handle = INVALID_HANDLE_VALUE;
+#else
+  _fd = -1;
+#endif
+
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  PT(VirtualFile) vfile = vfs->get_file(journal_pathname);
+  if (vfile == nullptr) {
+    return;
+  }
+
+  SubfileInfo info;
+  if (!vfile->get_system_info(info) || info.get_start() != 0) {
+    // This isn't a file other processes can see.
+    _exists = true;
+    return;
+  }
+
+#ifdef _WIN32
+  // Other processes may still read the journal, but they can't open it for
+  // writing until we are done.
+  std::wstring os_specific = info.get_filename().to_os_specific_w();
+  _handle = CreateFileW(os_specific.c_str(), FILE_APPEND_DATA,
+                        FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  while (_handle == INVALID_HANDLE_VALUE &&
+         GetLastError() == ERROR_SHARING_VIOLATION) {
+    // Another process holds the lock; yield and try again.
+    Sleep(0);
+    _handle = CreateFileW(os_specific.c_str(), FILE_APPEND_DATA,
+                          FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  }
+  _exists = (_handle != INVALID_HANDLE_VALUE);
+
+#else  // _WIN32
+  std::string os_specific = info.get_filename().to_os_specific();
+  _fd = open(os_specific.c_str(), O_WRONLY | O_APPEND);
+  if (_fd < 0) {
+    return;
+  }
+
+#ifdef PHAVE_LOCKF
+  int result = lockf(_fd, F_LOCK, 0);
+#else
+  int result = flock(_fd, LOCK_EX);
+#endif
+  if (result != 0) {
+    util_cat.warning()
+      << "Couldn't lock " << journal_pathname << ": " << strerror(errno) << "\n";
+    close(_fd);
+    _fd = -1;
+    return;
+  }
+  _exists = true;
+#endif  // _WIN32
+}
+
+/**
+ * Releases the lock.
+ */
+JournalLock::
+~JournalLock() {
+#ifdef _WIN32
+  if (_handle != INVALID_HANDLE_VALUE) {
+    CloseHandle(_handle);
+  }
+#else
+  if (_fd >= 0) {
+    close(_fd);
+  }
+#endif
+}
+
+/**
+ * Writes the indicated entry to the end of the journal.  Returns true on
+ * success.
+ */
+bool JournalLock::
+append(const Datagram &entry) {
+  nassertr(_exists, false);
+  const char *data = (const char *)entry.get_data();
+  size_t size = entry.get_length();
+
+#ifdef _WIN32
+  if (_handle != INVALID_HANDLE_VALUE) {
+    DWORD bytes_written;
+    return WriteFile(_handle, data, (DWORD)size, &bytes_written, nullptr) &&
+           bytes_written == size;
+  }
+#else
+  if (_fd >= 0) {
+    while (size > 0) {
+      ssize_t result = write(_fd, data, size);
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      data += result;
+      size -= result;
+    }
+    return true;
+  }
+#endif
+
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  std::ostream *out = vfs->open_append_file(_journal_pathname);
+  if (out == nullptr) {
+    return false;
+  }
+  out->write(data, size);
+  out->flush();
+  bool success = !out->fail();
+  vfs->close_write_file(out);
+  return success;
+}
+
 /**
  *
  */
@@ -42,7 +235,11 @@ BamCache() :
   _active(true),
   _read_only(false),
   _index(new BamCacheIndex),
-  _index_stale_since(0)
+  _index_stale_since(0),
+  _journal_pos(0),
+  _journal_entries(0),
+  _journal_checked(0),
+  _evict_running(false)
 {
   ConfigVariableFilename model_cache_dir
     ("model-cache-dir", Filename(),
@@ -86,6 +283,28 @@ BamCache() :
     ("model-cache-max-kbytes", 10485760,
      PRC_DESC("This is the maximum size of the model cache, in kilobytes."));
 
+  ConfigVariableBool model_cache_journal
+    ("model-cache-journal", true,
+     PRC_DESC("If this is true, each change to the model-cache index is "
+              "appended to a journal file as it is made, instead of the whole "
+              "index being rewritten every model-cache-flush seconds.  This "
+              "keeps stores fast with a large cache, and allows several "
+              "processes to share a cache without contending for the index."));
+
+  ConfigVariableInt model_cache_journal_limit
+    ("model-cache-journal-limit", 1000,
+     PRC_DESC("The number of entries the model-cache journal may hold before "
+              "it is folded back into the index file.  The journal is also "
+              "allowed to grow as large as the index itself, so that the "
+              "cost of rewriting the index is spread over many changes."));
+
+  ConfigVariableEnum<CompressionCodec> model_cache_compression
+    ("model-cache-compression", CC_none,
+     PRC_DESC("The codec with which files in the model cache are compressed. "
+              "Set this to lz4 to reduce the size of the cache at little cost "
+              "in load time, or to zstd or zlib to reduce it further.  Cache files "
+              "are read correctly regardless of this setting."));
+
   _cache_models = model_cache_models;
   _cache_textures = model_cache_textures;
   _cache_compressed_textures = model_cache_compressed_textures;
@@ -93,6 +312,9 @@ BamCache() :
 
   _flush_time = model_cache_flush;
   _max_kbytes = model_cache_max_kbytes;
+  _compression_codec = model_cache_compression;
+  _use_journal = model_cache_journal;
+  _journal_limit = model_cache_journal_limit;
 
   if (!model_cache_dir.empty()) {
     set_root(model_cache_dir);
@@ -105,6 +327,13 @@ BamCache() :
 BamCache::
 ~BamCache() {
   flush_index();
+
+  // Wait for any evicted files to be deleted.  We can't hold the lock while
+  // we do this, since the eviction thread needs it.
+  if (_evict_thread != nullptr) {
+    _evict_thread->join();
+    _evict_thread = nullptr;
+  }
   delete _index;
   _index = nullptr;
 }
@@ -223,29 +452,60 @@ store(BamCacheRecord *record) {
   temp_pathname.set_extension(extension);
   temp_pathname.set_binary();
 
+  // If the cache is to be compressed, the whole file is written through a
+  // compression stream.  do_read_record() recognizes this from the first
+  // byte, which can't begin the bam header.
+  std::ostream *file_stream = nullptr;
+  std::ostream *compress_stream = nullptr;
   DatagramOutputFile dout;
-  if (!dout.open(temp_pathname)) {
+  if (_compression_codec != CC_none) {
+    file_stream = vfs->open_write_file(temp_pathname, false, true);
+    if (file_stream != nullptr) {
+#ifdef HAVE_ZLIB
+      if (_compression_codec == CC_zlib) {
+        compress_stream = new OCompressStream(file_stream, false, 6);
+      } else
+#endif  // HAVE_ZLIB
+#ifdef HAVE_LZ4
+      if (_compression_codec == CC_lz4) {
+        compress_stream = new OLZ4CompressStream(file_stream, false, 1);
+      } else
+#endif  // HAVE_LZ4
+      {
+        // zstd is always compiled in, so it also stands in for a codec that
+        // isn't.
+        compress_stream = new OZstdCompressStream(file_stream, false, 3);
+      }
+    }
+  }
+  if (compress_stream != nullptr ? !dout.open(*compress_stream, temp_pathname)
+                                 : !dout.open(temp_pathname)) {
     util_cat.error()
       << "Could not write cache file: " << temp_pathname << "\n";
+    delete compress_stream;
+    if (file_stream != nullptr) {
+      vfs->close_write_file(file_stream);
+    }
     vfs->delete_file(temp_pathname);
     emergency_read_only();
     return false;
   }
 
+  bool success = false;
   if (!dout.write_header(_bam_header)) {
     util_cat.error()
       << "Unable to write to " << temp_pathname << "\n";
-    vfs->delete_file(temp_pathname);
-    return false;
-  }
-
-  {
+  } else {
     BamWriter writer(&dout);
-    if (!writer.init()) {
+    if (compress_stream != nullptr) {
+      // The aligned data blocks are located by their offset in the file,
+      // which doesn't work through a compression stream.
+      writer.set_file_aligned_data(false);
+    }
+    bool initialized = writer.init();
+    if (!initialized) {
       util_cat.error()
         << "Unable to write Bam header to " << temp_pathname << "\n";
-      vfs->delete_file(temp_pathname);
-      return false;
     }
 
     TypeRegistry *type_registry = TypeRegistry::ptr();
@@ -264,18 +524,19 @@ store(BamCacheRecord *record) {
       writer.set_root_node(record->get_data());
     }
 
-    if (!writer.write_object(record)) {
+    if (!initialized) {
+      // Already reported above.
+
+    } else if (!writer.write_object(record)) {
       util_cat.error()
         << "Unable to write object to " << temp_pathname << "\n";
-      vfs->delete_file(temp_pathname);
-      return false;
-    }
 
-    if (!writer.write_object(record->get_data())) {
+    } else if (!writer.write_object(record->get_data())) {
       util_cat.error()
         << "Unable to write object data to " << temp_pathname << "\n";
-      vfs->delete_file(temp_pathname);
-      return false;
+
+    } else {
+      success = true;
     }
 
     // Now that we are done with the BamWriter, it's important to let it
@@ -286,6 +547,23 @@ store(BamCacheRecord *record) {
   record->_record_size = dout.get_file_pos();
   dout.close();
 
+  if (compress_stream != nullptr) {
+    // The compressor must be flushed before the file is closed.
+    delete compress_stream;
+    vfs->close_write_file(file_stream);
+    if (success) {
+      PT(VirtualFile) vfile = vfs->get_file(temp_pathname);
+      if (vfile != nullptr) {
+        record->_record_size = vfile->get_file_size();
+      }
+    }
+  }
+
+  if (!success) {
+    vfs->delete_file(temp_pathname);
+    return false;
+  }
+
   // Now move the file into place.
   if (!vfs->rename_file(temp_pathname, cache_pathname) && vfs->exists(temp_pathname)) {
     vfs->delete_file(cache_pathname);
@@ -329,6 +607,14 @@ consider_flush_index() {
   }
 #endif
 
+  if (_use_journal && _journal_checked != 0) {
+    // Pick up the changes made by other processes.
+    int elapsed = (int)time(nullptr) - (int)_journal_checked;
+    if (elapsed > _flush_time) {
+      refresh_index();
+    }
+  }
+
   if (_index_stale_since != 0) {
     int elapsed = (int)time(nullptr) - (int)_index_stale_since;
     if (elapsed > _flush_time) {
@@ -352,6 +638,12 @@ flush_index() {
     return;
   }
 
+  if (_use_journal) {
+    // Make sure the new index includes any changes that other processes have
+    // made to the journal.
+    read_journal();
+  }
+
   while (true) {
     if (_read_only) {
       return;
@@ -364,9 +656,18 @@ flush_index() {
       return;
     }
 
+    // Each index file has its own journal, which starts out empty.  It is
+    // created now, before the index is published, since appending to it
+    // requires that it exist on some platforms.
+    VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+    Filename temp_journal_pathname = temp_pathname;
+    temp_journal_pathname.set_extension("log");
+    if (_use_journal) {
+      vfs->write_file(temp_journal_pathname, string(), false);
+    }
+
     // Now atomically write the name of this index file to the index reference
     // file.
-    VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
     Filename index_ref_pathname(_root, Filename("index_name.txt"));
     string old_index = _index_ref_contents;
     string new_index = temp_pathname.get_basename() + "\n";
@@ -375,17 +676,38 @@ flush_index() {
     if (vfs->atomic_compare_and_exchange_contents(index_ref_pathname, orig_index, old_index, new_index)) {
       // We successfully wrote our version of the index, and no other process
       // beat us to it.  Our index is now the official one.  Remove the old
-      // index.
-      vfs->delete_file(_index_pathname);
+      // index, and its journal.
+      time_t stale_since = 0;
+      if (!_index_pathname.empty()) {
+        // Another process may have appended to the old journal just before
+        // the switch; if so, these changes still need to be written out.
+        // Holding the lock ensures that no append is still in progress.  Any
+        // process that appends after this will find the index has changed.
+        Filename journal_pathname = get_journal_pathname();
+        {
+          JournalLock journal(journal_pathname);
+          int num_entries = _journal_entries;
+          read_journal();
+          if (_journal_entries != num_entries) {
+            stale_since = time(nullptr);
+          }
+        }
+        vfs->delete_file(_index_pathname);
+        vfs->delete_file(journal_pathname);
+      }
       _index_pathname = temp_pathname;
       _index_ref_contents = new_index;
-      _index_stale_since = 0;
+      _index_stale_since = stale_since;
+      _journal_pos = 0;
+      _journal_entries = 0;
+      _journal_checked = time(nullptr);
       return;
     }
 
     // Shoot, some other process updated the index while we were trying to
     // update it, and they beat us to it.  We have to merge, and try again.
     vfs->delete_file(temp_pathname);
+    vfs->delete_file(temp_journal_pathname);
     _index_pathname = Filename(_root, Filename(trim(orig_index)));
     _index_ref_contents = orig_index;
     read_index();
@@ -417,6 +739,14 @@ read_index() {
     BamCacheIndex *new_index = do_read_index(_index_pathname);
     if (new_index != nullptr) {
       merge_index(new_index);
+
+      // Now apply the changes that have been made since the index file was
+      // written.
+      _journal_pos = 0;
+      _journal_entries = 0;
+      if (_use_journal) {
+        read_journal();
+      }
       return;
     }
 
@@ -624,7 +954,13 @@ add_to_index(const BamCacheRecord *record) {
   PT(BamCacheRecord) new_record = record->make_copy();
 
   if (_index->add_record(new_record)) {
-    mark_index_stale();
+    Datagram payload;
+    payload.add_uint8(JO_add);
+    new_record->write_datagram(nullptr, payload);
+    payload.add_uint32(new_record->_record_access_time);
+    if (!append_journal(payload)) {
+      mark_index_stale();
+    }
     check_cache_size();
   }
 }
@@ -635,7 +971,12 @@ add_to_index(const BamCacheRecord *record) {
 void BamCache::
 remove_from_index(const Filename &source_pathname) {
   if (_index->remove_record(source_pathname)) {
-    mark_index_stale();
+    Datagram payload;
+    payload.add_uint8(JO_remove);
+    payload.add_string(source_pathname);
+    if (!append_journal(payload)) {
+      mark_index_stale();
+    }
   }
 }
 
@@ -650,26 +991,261 @@ check_cache_size() {
     return;
   }
 
-  if (_index->_cache_size / 1024 > _max_kbytes) {
-    while (_index->_cache_size / 1024 > _max_kbytes) {
-      PT(BamCacheRecord) record = _index->evict_old_file();
-      if (record == nullptr) {
-        // Never mind; the cache is empty.
-        break;
-      }
-      VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
-      Filename cache_pathname(_root, record->get_cache_filename());
-      if (util_cat.is_debug()) {
-        util_cat.debug()
-          << "Deleting " << cache_pathname
-          << " to keep cache size below " << _max_kbytes << "K\n";
-      }
-      vfs->delete_file(cache_pathname);
+  while (_index->_cache_size / 1024 > _max_kbytes) {
+    PT(BamCacheRecord) record = _index->evict_old_file();
+    if (record == nullptr) {
+      // Never mind; the cache is empty.
+      break;
     }
+
+    Datagram payload;
+    payload.add_uint8(JO_remove);
+    payload.add_string(record->get_source_pathname());
+    if (!append_journal(payload)) {
+      mark_index_stale();
+    }
+    evict_file(record);
+  }
+}
+
+/**
+ * Arranges for the cache file of the indicated record, which has just been
+ * removed from the index, to be deleted.  If threading is available, this is
+ * done by a low-priority thread, so that the caller doesn't have to wait for
+ * the filesystem.
+ */
+void BamCache::
+evict_file(BamCacheRecord *record) {
+  record->_cache_pathname = Filename(_root, record->get_cache_filename());
+
+  if (Thread::is_threading_supported()) {
+    _evict_queue.push_back(record);
+    if (_evict_running) {
+      // The thread will get to it.
+      return;
+    }
+
+    if (_evict_thread != nullptr) {
+      // The previous thread has finished with the queue, and is about to
+      // exit, if it hasn't already.
+      _evict_thread->join();
+    }
+    _evict_thread = new GenericThread("bam-cache-evict", "bam-cache-evict",
+                                      &evict_thread_main, this);
+    if (_evict_thread->start(TP_low, true)) {
+      _evict_running = true;
+      return;
+    }
+
+    // Couldn't start the thread; do it ourselves.
+    _evict_thread = nullptr;
+    _evict_queue.pop_back();
+  }
+
+  delete_evicted_file(record);
+}
+
+/**
+ * Deletes the cache file of a record that was evicted from the index, unless
+ * it has since been stored again.  Assumes the lock is held.
+ */
+void BamCache::
+delete_evicted_file(const BamCacheRecord *record) {
+  BamCacheIndex::Records::const_iterator ri =
+    _index->_records.find(record->get_source_pathname());
+  if (ri != _index->_records.end() &&
+      Filename(_root, (*ri).second->get_cache_filename()) == record->_cache_pathname) {
+    return;
+  }
+
+  if (util_cat.is_debug()) {
+    util_cat.debug()
+      << "Deleting " << record->_cache_pathname
+      << " to keep cache size below " << _max_kbytes << "K\n";
+  }
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  vfs->delete_file(record->_cache_pathname);
+}
+
+/**
+ * The main function of the eviction thread.  This deletes the files in the
+ * eviction queue, releasing the lock between files so that it doesn't hold up
+ * other threads that are using the cache.
+ */
+void BamCache::
+evict_thread_main(void *data) {
+  BamCache *self = (BamCache *)data;
+
+  self->_lock.acquire();
+  while (!self->_evict_queue.empty()) {
+    PT(BamCacheRecord) record = self->_evict_queue.back();
+    self->_evict_queue.pop_back();
+    self->delete_evicted_file(record);
+
+    self->_lock.release();
+    Thread::consider_yield();
+    self->_lock.acquire();
+  }
+  self->_evict_running = false;
+  self->_lock.release();
+}
+
+/**
+ * Brings the index up-to-date with the changes made by other processes since
+ * we last looked.  This is normally a matter of reading the new entries in
+ * the journal, unless some other process has written out a new index file.
+ */
+void BamCache::
+refresh_index() {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  Filename index_ref_pathname(_root, Filename("index_name.txt"));
+  string index_ref_contents;
+  if (vfs->atomic_read_contents(index_ref_pathname, index_ref_contents) &&
+      index_ref_contents != _index_ref_contents) {
+    read_index();
+  } else {
+    read_journal();
+  }
+  check_cache_size();
+}
+
+/**
+ * Returns the name of the journal file that accompanies the current index
+ * file.
+ */
+Filename BamCache::
+get_journal_pathname() const {
+  Filename journal_pathname = _index_pathname;
+  journal_pathname.set_extension("log");
+  journal_pathname.set_binary();
+  return journal_pathname;
+}
+
+/**
+ * Applies any entries that have been appended to the journal since it was
+ * last read, by this or any other process.
+ */
+void BamCache::
+read_journal() {
+  _journal_checked = time(nullptr);
+  if (_index_pathname.empty()) {
+    return;
+  }
+
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  istream *in = vfs->open_read_file(get_journal_pathname(), false);
+  if (in == nullptr) {
+    return;
+  }
+
+  vector_uchar data;
+  in->seekg(_journal_pos);
+  if (!in->fail()) {
+    char buffer[4096];
+    in->read(buffer, sizeof(buffer));
+    while (in->gcount() > 0) {
+      data.insert(data.end(), buffer, buffer + in->gcount());
+      in->read(buffer, sizeof(buffer));
+    }
+  }
+  vfs->close_read_file(in);
+
+  // Each entry is prefixed by its size and a checksum.  An entry that is not
+  // yet complete is probably still being written; we will get it next time.
+  Datagram dg(std::move(data));
+  DatagramIterator scan(dg);
+  while (scan.get_remaining_size() >= 8) {
+    size_t size = scan.get_uint32();
+    uint32_t checksum = scan.get_uint32();
+    if (scan.get_remaining_size() < size) {
+      break;
+    }
+
+    Datagram payload((const unsigned char *)dg.get_data() + scan.get_current_index(), size);
+    scan.skip_bytes(size);
+    _journal_pos += 8 + size;
+    ++_journal_entries;
+
+    if (journal_checksum(payload) != checksum) {
+      util_cat.warning()
+        << "Ignoring corrupt entry in " << get_journal_pathname() << "\n";
+      continue;
+    }
+
+    DatagramIterator entry(payload);
+    apply_journal_entry(entry);
+  }
+
+  if (_journal_entries > std::max(_journal_limit, (int)_index->_records.size())) {
+    // The journal has grown large enough that it's time to write out a new
+    // index file.
     mark_index_stale();
   }
 }
 
+/**
+ * Applies a single entry read from the journal to the index.
+ */
+void BamCache::
+apply_journal_entry(DatagramIterator &scan) {
+  switch (scan.get_uint8()) {
+  case JO_add:
+    {
+      PT(BamCacheRecord) record = new BamCacheRecord;
+      record->fillin(scan, nullptr);
+      record->_record_access_time = scan.get_uint32();
+      _index->add_record(record);
+    }
+    break;
+
+  case JO_remove:
+    _index->remove_record(scan.get_string());
+    break;
+
+  default:
+    util_cat.warning()
+      << "Ignoring unknown entry in " << get_journal_pathname() << "\n";
+  }
+}
+
+/**
+ * Appends the indicated change to the journal.  The journal is locked while
+ * the entry is written, so several processes may safely do this at once.
+ * Returns true on success, or false if the change could not be journaled, in
+ * which case the index file itself must be rewritten.
+ */
+bool BamCache::
+append_journal(const Datagram &payload) {
+  if (!_use_journal || _read_only || _index_pathname.empty()) {
+    return false;
+  }
+
+  Datagram entry;
+  entry.add_uint32(payload.get_length());
+  entry.add_uint32(journal_checksum(payload));
+  entry.append_data(payload.get_data(), payload.get_length());
+
+  JournalLock journal(get_journal_pathname());
+  if (!journal.exists()) {
+    // Some other process has already replaced the index, and removed its
+    // journal.
+    return false;
+  }
+
+  // While we hold the lock, make sure that the journal still belongs to the
+  // current index.  If it was replaced in the meantime, the process that
+  // replaced it won't read our entry.
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  Filename index_ref_pathname(_root, Filename("index_name.txt"));
+  string index_ref_contents;
+  if (!vfs->atomic_read_contents(index_ref_pathname, index_ref_contents) ||
+      index_ref_contents != _index_ref_contents) {
+    return false;
+  }
+
+  return journal.append(entry);
+}
+
 /**
  * Reads the index data from the specified filename.  Returns a newly-
  * allocated BamCacheIndex object on success, or NULL on failure.
@@ -866,8 +1442,13 @@ read_record(const Filename &source_pathname,
  */
 PT(BamCacheRecord) BamCache::
 do_read_record(const Filename &cache_pathname, bool read_data) {
-  DatagramInputFile din;
-  if (!din.open(cache_pathname)) {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  PT(VirtualFile) vfile = vfs->get_file(cache_pathname);
+  istream *file_stream = nullptr;
+  if (vfile != nullptr) {
+    file_stream = vfile->open_read_file(false);
+  }
+  if (file_stream == nullptr) {
     if (util_cat.is_debug()) {
       util_cat.debug()
         << "Could not read cache file: " << cache_pathname << "\n";
@@ -875,6 +1456,55 @@ do_read_record(const Filename &cache_pathname, bool read_data) {
     return nullptr;
   }
 
+  // A compressed cache file is recognized by its first byte, which is the
+  // start of the LZ4 or zstd magic number or the zlib header; an uncompressed
+  // file begins with the bam header instead.
+  istream *in = file_stream;
+  int first = file_stream->peek();
+#ifdef HAVE_LZ4
+  if (first == 0x04) {
+    in = new ILZ4DecompressStream(file_stream, false);
+  } else
+#endif  // HAVE_LZ4
+  if (first == 0x28) {
+    in = new IZstdDecompressStream(file_stream, false);
+  }
+#ifdef HAVE_ZLIB
+  else if (first == 0x78) {
+    in = new IDecompressStream(file_stream, false);
+  }
+#endif  // HAVE_ZLIB
+
+  PT(BamCacheRecord) record;
+  {
+    // The filename is only given for an uncompressed file, since it allows
+    // the reader to refer to data blocks by their offset within the file.
+    DatagramInputFile din;
+    if (din.open(*in, (in == file_stream) ? cache_pathname : Filename())) {
+      record = do_read_record(din, cache_pathname, read_data);
+    }
+  }
+  if (in != file_stream) {
+    delete in;
+  }
+
+  if (record != nullptr) {
+    // Also get the total file size.
+    file_stream->clear();
+    record->_record_size = vfile->get_file_size(file_stream);
+  }
+  vfile->close_read_file(file_stream);
+
+  return record;
+}
+
+/**
+ * Reads a record from the indicated already-opened file.  The
+ * _record_size is not filled in.
+ */
+PT(BamCacheRecord) BamCache::
+do_read_record(DatagramInputFile &din, const Filename &cache_pathname,
+               bool read_data) {
   string head;
   if (!din.read_header(head, _bam_header.size())) {
     if (util_cat.is_debug()) {
@@ -897,6 +1527,11 @@ do_read_record(const Filename &cache_pathname, bool read_data) {
     return nullptr;
   }
 
+  // Don't map the cached data.  The cache file may be replaced or cleaned
+  // out while the loaded object is still in use, which would pull the pages
+  // out from under a mapping on POSIX, and fail because of it on Windows.
+  reader.set_map_data(false);
+
   TypedWritable *object = reader.read_object();
   if (object == nullptr) {
     if (util_cat.is_debug()) {
@@ -947,12 +1582,6 @@ do_read_record(const Filename &cache_pathname, bool read_data) {
     }
   }
 
-  // Also get the total file size.
-  PT(VirtualFile) vfile = din.get_vfile();
-  istream &in = din.get_stream();
-  in.clear();
-  record->_record_size = vfile->get_file_size(&in);
-
   // And the last access time is now, duh.
   record->_record_access_time = time(nullptr);
 
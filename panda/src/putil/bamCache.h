@@ -18,14 +18,19 @@
 #include "bamCacheRecord.h"
 #include "pointerTo.h"
 #include "filename.h"
+#include "compressionCodec.h"
 #include "pmap.h"
 #include "pvector.h"
 #include "reMutex.h"
 #include "reMutexHolder.h"
+#include "thread.h"
 
 #include <time.h>
 
 class BamCacheIndex;
+class Datagram;
+class DatagramInputFile;
+class DatagramIterator;
 
 /**
  * This class maintains a cache of Bam and/or Txo objects generated from model
@@ -71,6 +76,9 @@ PUBLISHED:
   INLINE void set_read_only(bool ro);
   INLINE bool get_read_only() const;
 
+  INLINE void set_compression_codec(CompressionCodec codec);
+  INLINE CompressionCodec get_compression_codec() const;
+
   PT(BamCacheRecord) lookup(const Filename &source_filename,
                             const std::string &cache_extension);
   bool store(BamCacheRecord *record);
@@ -96,6 +104,7 @@ PUBLISHED:
   MAKE_PROPERTY(flush_time, get_flush_time, set_flush_time);
   MAKE_PROPERTY(cache_max_kbytes, get_cache_max_kbytes, set_cache_max_kbytes);
   MAKE_PROPERTY(read_only, get_read_only, set_read_only);
+  MAKE_PROPERTY(compression_codec, get_compression_codec, set_compression_codec);
 
 private:
   void read_index();
@@ -109,6 +118,15 @@ private:
   void remove_from_index(const Filename &source_filename);
 
   void check_cache_size();
+  void evict_file(BamCacheRecord *record);
+  void delete_evicted_file(const BamCacheRecord *record);
+  static void evict_thread_main(void *data);
+
+  void refresh_index();
+  Filename get_journal_pathname() const;
+  void read_journal();
+  void apply_journal_entry(DatagramIterator &scan);
+  bool append_journal(const Datagram &payload);
 
   void emergency_read_only();
 
@@ -122,6 +140,9 @@ private:
                                  int pass);
   static PT(BamCacheRecord) do_read_record(const Filename &cache_pathname,
                                            bool read_data);
+  static PT(BamCacheRecord) do_read_record(DatagramInputFile &din,
+                                           const Filename &cache_pathname,
+                                           bool read_data);
 
   static std::string hash_filename(const std::string &filename);
   static void make_global();
@@ -135,6 +156,7 @@ private:
   Filename _root;
   int _flush_time;
   int _max_kbytes;
+  CompressionCodec _compression_codec;
   static BamCache *_global_ptr;
 
   BamCacheIndex *_index;
@@ -143,6 +165,25 @@ private:
   Filename _index_pathname;
   std::string _index_ref_contents;
 
+  // The journal records the changes made to the index since the index file
+  // was last written.  It is appended to by every process sharing the cache.
+  enum JournalOp {
+    JO_add = 1,
+    JO_remove = 2,
+  };
+  bool _use_journal;
+  int _journal_limit;
+  std::streamoff _journal_pos;
+  int _journal_entries;
+  time_t _journal_checked;
+
+  // Cache files that have been evicted from the index, waiting to be deleted
+  // by the eviction thread.
+  typedef pvector<PT(BamCacheRecord) > EvictQueue;
+  EvictQueue _evict_queue;
+  PT(Thread) _evict_thread;
+  bool _evict_running;
+
   ReMutex _lock;
 };
 
@@ -19,6 +19,8 @@
 #include "datagramIterator.h"
 #include "config_putil.h"
 #include "pipelineCyclerBase.h"
+#include "virtualFileSystem.h"
+#include "virtualFileSimple.h"
 
 using std::string;
 
@@ -29,6 +31,7 @@ BamReader *const BamReader::Null = nullptr;
 WritableFactory *const BamReader::NullFactory = nullptr;
 
 BamReader::NewTypes BamReader::_new_types;
+BamReader::DecodeRunnerFunc *BamReader::_decode_runner = nullptr;
 
 const int BamReader::_cur_major = _bam_major_ver;
 const int BamReader::_cur_minor = _bam_minor_ver;
@@ -49,6 +52,11 @@ BamReader(DatagramGenerator *source)
   _pta_id = -1;
   _long_object_id = false;
   _long_pta_id = false;
+  _mapped_start = 0;
+  _mapped_failed = false;
+  _map_data = true;
+  _decode_pending_bytes = 0;
+  _num_decode_threads = std::max((int)bam_decode_threads, 0);
 }
 
 
@@ -57,6 +65,7 @@ BamReader(DatagramGenerator *source)
  */
 BamReader::
 ~BamReader() {
+  run_decode_jobs();
   nassertv(_num_extra_objects == 0);
   nassertv(_nesting_level == 0);
 }
@@ -269,6 +278,10 @@ read_object(TypedWritable *&ptr, ReferenceCount *&ref_ptr) {
     p_read_object();
   }
 
+  // The objects may have left some of their data to be decoded in parallel;
+  // it must be ready before we hand them back.
+  run_decode_jobs();
+
   // Now look up the pointer of the object we read first.  It should be
   // available now.
   if (object_id == 0) {
@@ -323,6 +336,8 @@ read_object(TypedWritable *&ptr, ReferenceCount *&ref_ptr) {
  */
 bool BamReader::
 resolve() {
+  run_decode_jobs();
+
   bool all_completed;
   bool any_completed_this_pass;
 
@@ -685,6 +700,184 @@ read_file_data(SubfileInfo &info) {
   _file_data_records.pop_front();
 }
 
+/**
+ * Returns true if a block of the indicated size, as written by
+ * BamWriter::write_aligned_data(), is available to be read at the current
+ * position.  This may be used to guard against a corrupt size before
+ * allocating a buffer for read_aligned_data().
+ */
+bool BamReader::
+check_aligned_data(const DatagramIterator &scan, size_t size) const {
+  size_t remaining = scan.get_remaining_size();
+  if (_file_minor < 46) {
+    return size <= remaining;
+  }
+  if (remaining < 1) {
+    return false;
+  }
+
+  const unsigned char *flag = (const unsigned char *)scan.get_datagram().get_data()
+                            + scan.get_current_index();
+  if (*flag == 0) {
+    return size <= remaining - 1;
+  }
+  return !_file_data_records.empty() &&
+    (std::streamsize)size <= _file_data_records.front().get_size();
+}
+
+/**
+ * Reads a block of raw data that was written by
+ * BamWriter::write_aligned_data() into the indicated buffer, which must have
+ * room for size bytes.  Returns true on success, false on failure.
+ */
+bool BamReader::
+read_aligned_data(DatagramIterator &scan, void *into, size_t size) {
+  if (!check_aligned_data(scan, size)) {
+    bam_cat.error()
+      << "Data block of " << size << " bytes extends past end of bam stream.\n";
+    return false;
+  }
+
+  if (_file_minor < 46 || scan.get_uint8() == 0) {
+    // The data is stored inline.
+    extract_bytes(scan, into, size);
+    return true;
+  }
+
+  SubfileInfo info;
+  read_file_data(info);
+
+  // The data is at the end of the record, after the padding.
+  const unsigned char *mapped = get_mapped_data(info, size);
+  if (mapped != nullptr) {
+    memcpy(into, mapped, size);
+    return true;
+  }
+
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  std::istream *in = vfs->open_read_file(info.get_filename(), true);
+  if (in == nullptr) {
+    bam_cat.error()
+      << "Unable to reopen " << info.get_filename() << "\n";
+    return false;
+  }
+  in->seekg(info.get_start() + (std::streamoff)(info.get_size() - size));
+  in->read((char *)into, size);
+  bool success = !in->fail() && (size_t)in->gcount() == size;
+  vfs->close_read_file(in);
+
+  if (!success) {
+    bam_cat.error()
+      << "Unable to read " << size << " bytes from " << info << "\n";
+  }
+  return success;
+}
+
+/**
+ * If the block of raw data at the current position was written by
+ * BamWriter::write_aligned_data() as an aligned block, and the file it is in
+ * can be memory-mapped, consumes it and returns a read-only pointer to the
+ * data within the mapping.  The mapping is stored in the indicated pointer;
+ * the caller must keep a reference to it for as long as it uses the data.
+ *
+ * Otherwise, returns NULL without consuming anything, and the caller should
+ * use read_aligned_data() instead.
+ */
+const unsigned char *BamReader::
+map_aligned_data(DatagramIterator &scan, size_t size, PT(MappedFile) &mapping) {
+  if (_file_minor < 46 || size == 0 ||
+      scan.get_remaining_size() < 1 || _file_data_records.empty()) {
+    return nullptr;
+  }
+
+  const unsigned char *flag = (const unsigned char *)scan.get_datagram().get_data()
+                            + scan.get_current_index();
+  if (*flag == 0) {
+    return nullptr;
+  }
+
+  const SubfileInfo &info = _file_data_records.front();
+  if ((std::streamsize)size > info.get_size()) {
+    return nullptr;
+  }
+
+  const unsigned char *mapped = get_mapped_data(info, size);
+  if (mapped == nullptr ||
+      ((uintptr_t)mapped % MEMORY_HOOK_ALIGNMENT) != 0) {
+    return nullptr;
+  }
+
+  scan.skip_bytes(1);
+  _file_data_records.pop_front();
+  mapping = _mapped_file;
+  return mapped;
+}
+
+/**
+ * Consumes size bytes of raw data from the datagram and copies them into the
+ * indicated buffer.  If num_decode_threads is nonzero, the copy may be
+ * deferred until the end of the current read_object() call, so that it can
+ * be performed in parallel with other copies; the caller must therefore not
+ * inspect or free the buffer until then.
+ */
+void BamReader::
+extract_bytes(DatagramIterator &scan, void *into, size_t size) {
+  nassertv(scan.get_remaining_size() >= size);
+
+  if (should_defer_decode(size)) {
+    DecodeJob job;
+    job._datagram = scan.get_datagram();
+    job._offset = scan.get_current_index();
+    job._into = into;
+    job._count = size;
+    job._stdfloats = false;
+    _decode_jobs.push_back(std::move(job));
+    _decode_pending_bytes += size;
+  } else {
+    const unsigned char *source_data =
+      (const unsigned char *)scan.get_datagram().get_data();
+    memcpy(into, source_data + scan.get_current_index(), size);
+  }
+  scan.skip_bytes(size);
+
+  if (_decode_pending_bytes >= 0x2000000) {
+    // Don't let the pending data grow without bound.
+    run_decode_jobs();
+  }
+}
+
+/**
+ * Consumes count values written with Datagram::add_stdfloat() from the
+ * datagram and stores them in the indicated array, converting them to the
+ * native PN_stdfloat type as necessary.  Like extract_bytes(), the decoding
+ * may be deferred until the end of the current read_object() call.
+ */
+void BamReader::
+extract_stdfloats(DatagramIterator &scan, PN_stdfloat *into, size_t count) {
+  size_t width = scan.get_datagram().get_stdfloat_double() ? 8 : 4;
+  nassertv(scan.get_remaining_size() >= count * width);
+
+  if (should_defer_decode(count * width)) {
+    DecodeJob job;
+    job._datagram = scan.get_datagram();
+    job._offset = scan.get_current_index();
+    job._into = into;
+    job._count = count;
+    job._stdfloats = true;
+    _decode_jobs.push_back(std::move(job));
+    _decode_pending_bytes += count * width;
+    scan.skip_bytes(count * width);
+  } else {
+    for (size_t i = 0; i < count; ++i) {
+      into[i] = scan.get_stdfloat();
+    }
+  }
+
+  if (_decode_pending_bytes >= 0x2000000) {
+    run_decode_jobs();
+  }
+}
+
 /**
  * Reads in the indicated CycleData object.  This should be used by classes
  * that store some or all of their data within a CycleData subclass, in
@@ -795,6 +988,119 @@ get_aux_tag(const string &tag) const {
   return (*ati).second;
 }
 
+/**
+ * Performs all of the pending decode jobs queued up by extract_bytes() and
+ * extract_stdfloats(), handing them to the function registered with
+ * set_decode_runner() so that up to num_decode_threads additional threads
+ * may help out, and waits for them to finish.
+ */
+void BamReader::
+run_decode_jobs() {
+  if (_decode_jobs.empty()) {
+    return;
+  }
+
+  int num_jobs = (int)_decode_jobs.size();
+  if (_decode_runner != nullptr && num_jobs > 1) {
+    (*_decode_runner)(num_jobs, _num_decode_threads, &decode_job, this);
+  } else {
+    for (int ji = 0; ji < num_jobs; ++ji) {
+      decode_job(ji, this);
+    }
+  }
+
+  _decode_jobs.clear();
+  _decode_pending_bytes = 0;
+}
+
+/**
+ * Performs the indicated one of the jobs queued up for run_decode_jobs().
+ * This may be called from any thread.
+ */
+void BamReader::
+decode_job(int ji, void *data) {
+  BamReader *self = (BamReader *)data;
+  const DecodeJob &job = self->_decode_jobs[ji];
+  if (job._stdfloats) {
+    DatagramIterator scan(job._datagram, job._offset);
+    PN_stdfloat *into = (PN_stdfloat *)job._into;
+    for (size_t i = 0; i < job._count; ++i) {
+      into[i] = scan.get_stdfloat();
+    }
+  } else {
+    const unsigned char *source_data =
+      (const unsigned char *)job._datagram.get_data();
+    memcpy(job._into, source_data + job._offset, job._count);
+  }
+}
+
+/**
+ * Specifies the function that is used to run the jobs queued up while
+ * decoding objects on several threads.  This is called when the library that
+ * provides the thread pool is initialized; if it is never called, the jobs
+ * are always run on the reading thread.
+ */
+void BamReader::
+set_decode_runner(DecodeRunnerFunc *func) {
+  _decode_runner = func;
+}
+
+/**
+ * Returns a pointer to the last size bytes of the indicated file data record
+ * within a memory mapping of the file, or NULL if the file cannot be mapped.
+ * The mapping is stored in _mapped_file, and is reused for subsequent records
+ * in the same file.
+ */
+const unsigned char *BamReader::
+get_mapped_data(const SubfileInfo &info, size_t size) {
+  if (!bam_mmap_data || !_map_data) {
+    return nullptr;
+  }
+
+  if (info.get_filename() != _mapped_filename) {
+    _mapped_filename = info.get_filename();
+    _mapped_file = nullptr;
+    _mapped_start = 0;
+    _mapped_failed = true;
+
+    // We can only map an uncompressed file on the OS filesystem, or in an
+    // uncompressed multifile.  We don't bother if the record was copied out
+    // to a temporary file, because the source was not a file.
+    VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+    PT(VirtualFile) vfile = vfs->get_file(_mapped_filename);
+    SubfileInfo system_info;
+    if (_source != nullptr && info.get_file() == _source->get_file() &&
+        vfile != nullptr &&
+        vfile->is_of_type(VirtualFileSimple::get_class_type()) &&
+        !DCAST(VirtualFileSimple, vfile)->is_implicit_pz_file() &&
+        _mapped_filename.get_extension() != "pz" &&
+        _mapped_filename.get_extension() != "gz" &&
+        vfile->get_system_info(system_info)) {
+      _mapped_file = MappedFile::open(system_info.get_filename());
+      if (_mapped_file != nullptr) {
+        _mapped_start = system_info.get_start();
+        _mapped_failed = false;
+      }
+    }
+
+    if (_mapped_failed && bam_cat.is_debug()) {
+      bam_cat.debug()
+        << "Unable to map " << _mapped_filename << "; reading data instead.\n";
+    }
+  }
+
+  if (_mapped_failed) {
+    return nullptr;
+  }
+
+  std::streamoff offset = _mapped_start + info.get_start() +
+                          (std::streamoff)(info.get_size() - size);
+  if (offset < 0 || (size_t)offset + size > _mapped_file->get_size()) {
+    return nullptr;
+  }
+  return _mapped_file->get_data() + offset;
+}
+
 /**
  * Should be called by an object reading itself from the Bam file to indicate
  * that this particular object would like to receive the finalize() callback
@@ -25,6 +25,7 @@
 #include "bamReaderParam.h"
 #include "bamEnums.h"
 #include "subfileInfo.h"
+#include "mappedFile.h"
 #include "loaderOptions.h"
 #include "factory.h"
 #include "vector_int.h"
@@ -34,6 +35,8 @@
 #include "dcast.h"
 #include "pipelineCyclerBase.h"
 #include "referenceCount.h"
+#include "pvector.h"
+#include "thread.h"
 
 #include <algorithm>
 
@@ -148,6 +151,12 @@ PUBLISHED:
   INLINE int get_current_major_ver() const;
   INLINE int get_current_minor_ver() const;
 
+  INLINE void set_num_decode_threads(int num_threads);
+  INLINE int get_num_decode_threads() const;
+
+  INLINE void set_map_data(bool map_data);
+  INLINE bool get_map_data() const;
+
   EXTENSION(PyObject *get_file_version() const);
 
 PUBLISHED:
@@ -158,6 +167,9 @@ PUBLISHED:
   MAKE_PROPERTY(file_version, get_file_version);
   MAKE_PROPERTY(file_endian, get_file_endian);
   MAKE_PROPERTY(file_stdfloat_double, get_file_stdfloat_double);
+  MAKE_PROPERTY(num_decode_threads, get_num_decode_threads,
+                                    set_num_decode_threads);
+  MAKE_PROPERTY(map_data, get_map_data, set_map_data);
 
 public:
   // Functions to support classes that read themselves from the Bam.
@@ -167,6 +179,12 @@ public:
   void skip_pointer(DatagramIterator &scan);
 
   void read_file_data(SubfileInfo &info);
+  bool check_aligned_data(const DatagramIterator &scan, size_t size) const;
+  bool read_aligned_data(DatagramIterator &scan, void *into, size_t size);
+  const unsigned char *map_aligned_data(DatagramIterator &scan, size_t size,
+                                        PT(MappedFile) &mapping);
+  void extract_bytes(DatagramIterator &scan, void *into, size_t size);
+  void extract_stdfloats(DatagramIterator &scan, PN_stdfloat *into, size_t count);
 
   void read_cdata(DatagramIterator &scan, PipelineCyclerBase &cycler);
   void read_cdata(DatagramIterator &scan, PipelineCyclerBase &cycler,
@@ -180,6 +198,14 @@ public:
 
   void register_finalize(TypedWritable *whom);
 
+  // The function that runs the decode jobs queued by extract_bytes() and
+  // extract_stdfloats().  It is supplied by a higher-level library that has
+  // access to a thread pool; without one, the jobs are run serially.
+  typedef void DecodeJobFunc(int job, void *data);
+  typedef void DecodeRunnerFunc(int num_jobs, int num_threads,
+                                DecodeJobFunc *func, void *data);
+  static void set_decode_runner(DecodeRunnerFunc *func);
+
   typedef TypedWritable *(*ChangeThisFunc)(TypedWritable *object, BamReader *manager);
   typedef PT(TypedWritableReferenceCount) (*ChangeThisRefFunc)(TypedWritableReferenceCount *object, BamReader *manager);
   void register_change_this(ChangeThisFunc func, TypedWritable *whom);
@@ -218,6 +244,10 @@ private:
   bool resolve_cycler_pointers(PipelineCyclerBase *cycler, const vector_int &pointer_ids,
                                bool require_fully_complete);
   void finalize();
+  const unsigned char *get_mapped_data(const SubfileInfo &info, size_t size);
+  INLINE bool should_defer_decode(size_t size) const;
+  void run_decode_jobs();
+  static void decode_job(int job, void *data);
 
   INLINE bool get_datagram(Datagram &datagram);
 
@@ -321,6 +351,31 @@ private:
   typedef pdeque<SubfileInfo> FileDataRecords;
   FileDataRecords _file_data_records;
 
+  // The mapping of the file that the aligned data blocks are stored in, if
+  // they could be mapped; see map_aligned_data().
+  PT(MappedFile) _mapped_file;
+  Filename _mapped_filename;
+  std::streamoff _mapped_start;
+  bool _mapped_failed;
+  bool _map_data;
+
+  // The payloads handed to extract_bytes() and extract_stdfloats() that have
+  // not yet been decoded; see run_decode_jobs().  Each job keeps a copy of
+  // the datagram it came from, which shares the underlying buffer.
+  class DecodeJob {
+  public:
+    Datagram _datagram;
+    size_t _offset;
+    void *_into;
+    size_t _count;
+    bool _stdfloats;
+  };
+  typedef pvector<DecodeJob> DecodeJobs;
+  DecodeJobs _decode_jobs;
+  size_t _decode_pending_bytes;
+  int _num_decode_threads;
+  static DecodeRunnerFunc *_decode_runner;
+
   // This is used internally to record all of the new types created on-the-fly
   // to satisfy bam requirements.  We keep track of this just so we can
   // suppress warning messages from attempts to create objects of these types.
@@ -96,10 +96,16 @@ BamWriter(DatagramSink *target) :
   } else {
     _file_major = _bam_major_ver;
     _file_minor = _bam_minor_ver;
+
+    // Aligned data requires a newer version than we write by default.
+    if (bam_aligned_data) {
+      _file_minor = std::max(_file_minor, 46);
+    }
   }
   _file_endian = bam_endian;
   _file_stdfloat_double = bam_stdfloat_double;
   _file_texture_mode = bam_texture_mode;
+  _file_aligned_data = bam_aligned_data;
 }
 
 /**
@@ -162,6 +168,14 @@ init() {
   _file_endian = bam_endian;
   _file_texture_mode = bam_texture_mode;
 
+  if (_file_aligned_data && _file_minor < 46) {
+    util_cat.warning()
+      << "Aligned data requires bam version 6.46 or later; writing data "
+         "inline in version " << _file_major << "." << _file_minor
+      << " file instead.\n";
+    _file_aligned_data = false;
+  }
+
   // Write out the current major and minor BAM file version numbers.
   Datagram header;
 
@@ -415,6 +429,69 @@ write_file_data(SubfileInfo &result, const SubfileInfo &source) {
   // order and queued up in the BamReader.
 }
 
+/**
+ * Writes a block of raw data, such as a vertex array or a texture image.  The
+ * caller is responsible for recording the size; the data must be read back
+ * with a matching call to BamReader::read_aligned_data() or
+ * BamReader::map_aligned_data().
+ *
+ * Normally, the data is simply appended to the datagram.  However, if
+ * get_file_aligned_data() is true and the Bam file is being written to a
+ * file on disk, a large block of data is instead written as an auxiliary file
+ * data record (see write_file_data()) that is padded so that the data begins
+ * on an aligned offset within the file.  This allows the BamReader to map the
+ * data directly from the file, rather than copying it out of the datagram.
+ */
+void BamWriter::
+write_aligned_data(Datagram &packet, const void *data, size_t size) {
+  if (_file_minor < 46) {
+    packet.append_data(data, size);
+    return;
+  }
+
+  // Small blocks aren't worth the overhead of a separate record.
+  static const size_t min_size = 256;
+  static const size_t alignment = 64;
+
+  if (!_file_aligned_data || size < min_size || _target->get_file() == nullptr) {
+    packet.add_uint8(0);
+    packet.append_data(data, size);
+    return;
+  }
+
+  packet.add_uint8(1);
+
+  Datagram marker;
+  marker.add_uint8(BOC_file_data);
+  if (!_target->put_datagram(marker)) {
+    util_cat.error()
+      << "Unable to write data to output.\n";
+    return;
+  }
+
+  // Figure out where the data will end up in the file, so that we can pad
+  // the beginning of the datagram to an aligned offset.  The size that
+  // precedes the datagram takes 4 bytes, or 12 for a very large datagram.
+  std::streamoff pos = _target->get_file_pos();
+  if (pos < 0) {
+    pos = 0;
+  }
+  size_t pad = 0;
+  for (int i = 0; i < 2; ++i) {
+    size_t header_size = (size + pad >= (size_t)0xffffffff) ? 12 : 4;
+    pad = (alignment - (size_t)(pos + header_size) % alignment) % alignment;
+  }
+
+  // The reader works out the padding from the size of the datagram.
+  Datagram dg;
+  dg.pad_bytes(pad);
+  dg.append_data(data, size);
+  if (!_target->put_datagram(dg)) {
+    util_cat.error()
+      << "Unable to write aligned data to output.\n";
+  }
+}
+
 /**
  * Writes out the indicated CycleData object.  This should be used by classes
  * that store some or all of their data within a CycleData subclass, in
@@ -84,6 +84,9 @@ PUBLISHED:
   INLINE BamTextureMode get_file_texture_mode() const;
   INLINE void set_file_texture_mode(BamTextureMode file_texture_mode);
 
+  INLINE bool get_file_aligned_data() const;
+  INLINE void set_file_aligned_data(bool file_aligned_data);
+
   INLINE TypedWritable *get_root_node() const;
   INLINE void set_root_node(TypedWritable *root_node);
 
@@ -93,6 +96,8 @@ PUBLISHED:
   MAKE_PROPERTY(file_endian, get_file_endian);
   MAKE_PROPERTY(file_stdfloat_double, get_file_stdfloat_double);
   MAKE_PROPERTY(file_texture_mode, get_file_texture_mode);
+  MAKE_PROPERTY(file_aligned_data, get_file_aligned_data,
+                                   set_file_aligned_data);
   MAKE_PROPERTY(root_node, get_root_node, set_root_node);
 
 public:
@@ -104,6 +109,7 @@ public:
 
   void write_file_data(SubfileInfo &result, const Filename &filename);
   void write_file_data(SubfileInfo &result, const SubfileInfo &source);
+  void write_aligned_data(Datagram &packet, const void *data, size_t size);
 
   void write_cdata(Datagram &packet, const PipelineCyclerBase &cycler);
   void write_cdata(Datagram &packet, const PipelineCyclerBase &cycler,
@@ -127,6 +133,7 @@ private:
   BamEndian _file_endian;
   bool _file_stdfloat_double;
   BamTextureMode _file_texture_mode;
+  bool _file_aligned_data;
 
   // Stores the PandaNode representing the root of the node hierarchy we are
   // currently writing, if any, for the purpose of writing NodePaths.  This is
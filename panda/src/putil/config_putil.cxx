@@ -89,6 +89,36 @@ ConfigVariableEnum<BamEnums::BamTextureMode> bam_texture_mode
  PRC_DESC("Set this to specify how textures should be written into Bam files."
           "See the panda source or documentation for available options."));
 
+ConfigVariableBool bam_aligned_data
+("bam-aligned-data", false,
+ PRC_DESC("Set this true to write the raw vertex data and texture images in "
+          "bam files as separate blocks, aligned within the file, so that "
+          "they can be memory-mapped directly when the file is loaded (see "
+          "bam-mmap-data).  This requires writing bam version 6.46 or later, "
+          "and it only takes effect when writing to a file on disk."));
+
+ConfigVariableBool bam_mmap_data
+("bam-mmap-data", true,
+ PRC_DESC("When this is true, vertex data stored in aligned blocks in a bam "
+          "file (see bam-aligned-data) is memory-mapped from the file rather "
+          "than copied into memory.  The pages are then only read from disk "
+          "when they are first used, and they are shared by all of the "
+          "processes that load the same file.  The data is copied into "
+          "private memory only when it is modified.  Texture images are "
+          "copied straight out of the mapping.  This only works for "
+          "uncompressed bam files on the OS filesystem or in an uncompressed "
+          "multifile; other bam files are read in the usual way."));
+
+ConfigVariableInt bam_decode_threads
+("bam-decode-threads", 0,
+ PRC_DESC("The number of additional threads the BamReader may use to decode "
+          "the bulk data of the objects in a bam file, such as vertex arrays, "
+          "texture images and animation tables.  The objects themselves are "
+          "still read one at a time, but copying and converting their "
+          "payloads is handed off to these threads, and finished before "
+          "read_object() returns.  Set this to 0 to decode everything on "
+          "the reading thread."));
+
 ConfigureFn(config_putil) {
   init_libputil();
 }
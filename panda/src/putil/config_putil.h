@@ -39,6 +39,9 @@ extern EXPCL_PANDA_PUTIL ConfigVariableInt bam_version;
 extern EXPCL_PANDA_PUTIL ConfigVariableEnum<BamEnums::BamEndian> bam_endian;
 extern EXPCL_PANDA_PUTIL ConfigVariableBool bam_stdfloat_double;
 extern EXPCL_PANDA_PUTIL ConfigVariableEnum<BamEnums::BamTextureMode> bam_texture_mode;
+extern EXPCL_PANDA_PUTIL ConfigVariableBool bam_aligned_data;
+extern EXPCL_PANDA_PUTIL ConfigVariableBool bam_mmap_data;
+extern EXPCL_PANDA_PUTIL ConfigVariableInt bam_decode_threads;
 
 BEGIN_PUBLISH
 EXPCL_PANDA_PUTIL ConfigVariableSearchPath &get_model_path();
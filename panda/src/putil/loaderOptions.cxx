@@ -75,6 +75,7 @@ output(std::ostream &out) const {
     write_flag(out, sep, "LF_no_ram_cache", LF_no_ram_cache);
   }
   write_flag(out, sep, "LF_allow_instance", LF_allow_instance);
+  write_flag(out, sep, "LF_streaming", LF_streaming);
   if (sep.empty()) {
     out << "0";
   }
@@ -34,6 +34,7 @@ PUBLISHED:
     LF_no_cache          = 0x0030,  // no_disk + no_ram
     LF_cache_only        = 0x0040,  // fail if not in cache
     LF_allow_instance    = 0x0080,  // returned pointer might be shared
+    LF_streaming         = 0x0100,  // async: textures are loaded afterwards
   };
 
   // Flags for loading texture files.
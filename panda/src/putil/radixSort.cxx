@@ -0,0 +1,88 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file radixSort.cxx
+ * @author jmarsh
+ * @date 2026-10-15
+ */
+
+#include "radixSort.h"
+
+#include <algorithm>
+
+// Below this many entries, a comparison sort is faster.
+static const size_t min_radix_sort_entries = 64;
+
+namespace {
+  class CompareKeys {
+  public:
+    bool operator () (const RadixSortEntry &a, const RadixSortEntry &b) const {
+      return a._key < b._key;
+    }
+  };
+}
+
+/**
+ * Sorts the entries in order of ascending key.  Entries with the same key
+ * remain in the same relative order.
+ *
+ * This is a least-significant-digit radix sort, one byte at a time.  The
+ * histograms of all eight bytes are gathered in a single pass, and bytes that
+ * are the same for all entries are skipped entirely, so that keys that only
+ * use a few of their bits are sorted in correspondingly few passes.
+ */
+void
+radix_sort(RadixSortEntries &entries) {
+  size_t num_entries = entries.size();
+  if (num_entries < min_radix_sort_entries) {
+    std::stable_sort(entries.begin(), entries.end(), CompareKeys());
+    return;
+  }
+
+  size_t counts[8][256];
+  memset(counts, 0, sizeof(counts));
+
+  for (const RadixSortEntry &entry : entries) {
+    uint64_t key = entry._key;
+    for (int d = 0; d < 8; ++d) {
+      ++counts[d][(key >> (d * 8)) & 0xff];
+    }
+  }
+
+  RadixSortEntries temp(num_entries);
+  RadixSortEntry *from = &entries[0];
+  RadixSortEntry *to = &temp[0];
+
+  for (int d = 0; d < 8; ++d) {
+    size_t *count = counts[d];
+    int shift = d * 8;
+
+    // If every entry has the same value for this byte, there's nothing to
+    // do for it.
+    if (count[(from[0]._key >> shift) & 0xff] == num_entries) {
+      continue;
+    }
+
+    size_t offset = 0;
+    for (int b = 0; b < 256; ++b) {
+      size_t c = count[b];
+      count[b] = offset;
+      offset += c;
+    }
+
+    for (size_t i = 0; i < num_entries; ++i) {
+      const RadixSortEntry &entry = from[i];
+      to[count[(entry._key >> shift) & 0xff]++] = entry;
+    }
+    std::swap(from, to);
+  }
+
+  if (from != &entries[0]) {
+    entries.swap(temp);
+  }
+}
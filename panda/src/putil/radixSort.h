@@ -0,0 +1,45 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file radixSort.h
+ * @author jmarsh
+ * @date 2026-10-15
+ */
+
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+
+#include "pandabase.h"
+#include "numeric_types.h"
+#include "pvector.h"
+
+#include <string.h>
+
+/**
+ * One element to be sorted by radix_sort(): a precomputed sort key, and the
+ * index of the item that it was computed for.
+ */
+class RadixSortEntry {
+public:
+  uint64_t _key;
+  uint32_t _index;
+};
+
+typedef pvector<RadixSortEntry> RadixSortEntries;
+
+// Sorts the entries by ascending key.  This is a stable sort, which runs in
+// time linear in the number of entries.
+EXPCL_PANDA_PUTIL void radix_sort(RadixSortEntries &entries);
+
+// These produce keys that sort in the same order as the indicated values.
+INLINE uint64_t radix_sort_key(int value);
+INLINE uint64_t radix_sort_key(double value);
+
+#include "radixSort.I"
+
+#endif
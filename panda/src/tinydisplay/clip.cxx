@@ -1,4 +1,5 @@
 #include "zgl.h"
+#include "tinyTriangleBinner.h"
 #include <limits.h>
 
 /* fill triangle profile */
@@ -72,10 +73,21 @@ void gl_transform_to_viewport(GLContext *c,GLVertex *v)
 }
 
 
+/* rasterizes any triangles that have been queued up in the binner; this
+   must be done before drawing anything else into the frame buffer */
+
+void gl_flush_triangles(GLContext *c)
+{
+  if (c->binner != nullptr) {
+    c->binner->flush();
+  }
+}
+
 /* point */
 
 void gl_draw_point(GLContext *c,GLVertex *p0)
 {
+  gl_flush_triangles(c);
   if (p0->clip_code == 0) {
     ZB_plot(c->zb,&p0->zp);
   }
@@ -124,6 +136,8 @@ void gl_draw_line(GLContext *c,GLVertex *p1,GLVertex *p2)
   PN_stdfloat tmin,tmax;
   GLVertex q1,q2;
   int cc1,cc2;
+
+  gl_flush_triangles(c);
   
   cc1=p1->clip_code;
   cc2=p2->clip_code;
@@ -406,6 +420,11 @@ void gl_draw_triangle_fill(GLContext *c,
   }
 #endif
 
+  if (c->binner != nullptr) {
+    c->binner->add_triangle(c->zb,c->zb_fill_tri,&p0->zp,&p1->zp,&p2->zp);
+    return;
+  }
+
   (*c->zb_fill_tri)(c->zb,&p0->zp,&p1->zp,&p2->zp);
 }
 
@@ -414,6 +433,7 @@ void gl_draw_triangle_fill(GLContext *c,
 void gl_draw_triangle_line(GLContext *c,
                            GLVertex *p0,GLVertex *p1,GLVertex *p2)
 {
+    gl_flush_triangles(c);
     if (c->depth_test) {
         if (p0->edge_flag) ZB_line_z(c->zb,&p0->zp,&p1->zp);
         if (p1->edge_flag) ZB_line_z(c->zb,&p1->zp,&p2->zp);
@@ -431,6 +451,7 @@ void gl_draw_triangle_line(GLContext *c,
 void gl_draw_triangle_point(GLContext *c,
                             GLVertex *p0,GLVertex *p1,GLVertex *p2)
 {
+  gl_flush_triangles(c);
   if (p0->edge_flag) ZB_plot(c->zb,&p0->zp);
   if (p1->edge_flag) ZB_plot(c->zb,&p1->zp);
   if (p2->edge_flag) ZB_plot(c->zb,&p2->zp);
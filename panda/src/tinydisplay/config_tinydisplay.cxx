@@ -55,6 +55,27 @@ ConfigVariableBool td_perspective_textures
             "textures on the tinydisplay software renderer, for a small "
             "performance gain."));
 
+ConfigVariableBool td_vectorize_vertices
+  ("td-vectorize-vertices", true,
+   PRC_DESC("Configure this false to transform and light the vertices one "
+            "at a time on the tinydisplay software renderer, instead of "
+            "four at a time with SSE2 where it is available.  The results "
+            "should be the same either way."));
+
+ConfigVariableInt td_num_threads
+  ("td-num-threads", 0,
+   PRC_DESC("Set this to a number greater than zero to rasterize triangles "
+            "on the tinydisplay software renderer with that many additional "
+            "worker threads.  Triangles are queued up and the frame buffer "
+            "is divided into bands of rows, each of which is rasterized by "
+            "a single thread; the result is identical to that of the "
+            "single-threaded renderer."));
+
+ConfigVariableInt td_max_binned_triangles
+  ("td-max-binned-triangles", 16384,
+   PRC_DESC("The maximum number of triangles that are queued up when "
+            "td-num-threads is in effect before they are rasterized."));
+
 /**
  * Initializes the library.  This must be called at least once before any of
  * the functions or classes in this library can be used.  Normally it will be
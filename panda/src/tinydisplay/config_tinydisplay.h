@@ -29,5 +29,8 @@ extern ConfigVariableInt td_texture_ram;
 extern ConfigVariableBool td_ignore_mipmaps;
 extern ConfigVariableBool td_ignore_clamp;
 extern ConfigVariableBool td_perspective_textures;
+extern ConfigVariableBool td_vectorize_vertices;
+extern ConfigVariableInt td_num_threads;
+extern ConfigVariableInt td_max_binned_triangles;
 
 #endif
@@ -1,4 +1,5 @@
 #include "zgl.h"
+#include "tinyTriangleBinner.h"
 
 GLContext *gl_ctx;
 
@@ -25,6 +26,7 @@ void glInit(GLContext *c, ZBuffer *zbuffer)
   c->light_model_two_side = 0;
   c->normalize_enabled = 0;
   c->normal_scale = 1.0f;
+  c->vectorize_vertices = 1;
 
   /* default materials */
   for(i=0;i<2;i++) {
@@ -64,5 +66,6 @@ void glInit(GLContext *c, ZBuffer *zbuffer)
 
 void glClose(GLContext *c)
 {
+  delete c->binner;
   gl_free(c);
 }
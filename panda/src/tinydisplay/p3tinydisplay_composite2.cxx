@@ -3,6 +3,7 @@
 #include "tinySDLGraphicsPipe.cxx"
 #include "tinySDLGraphicsWindow.cxx"
 #include "tinyTextureContext.cxx"
+#include "tinyTriangleBinner.cxx"
 #include "tinyWinGraphicsPipe.cxx"
 #include "tinyWinGraphicsWindow.cxx"
 #include "tinyXGraphicsPipe.cxx"
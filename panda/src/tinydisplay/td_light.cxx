@@ -133,3 +133,210 @@ void gl_shade_vertex(GLContext *c,GLVertex *v)
   v->color.v[3]=clampf(A*v->color.v[3],0,1);
 }
 
+
+#ifdef TD_VERTEX_SSE2
+
+static inline __m128 dot3_ps(__m128 ax, __m128 ay, __m128 az,
+                             __m128 bx, __m128 by, __m128 bz)
+{
+  __m128 r = _mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by));
+  return _mm_add_ps(r, _mm_mul_ps(az, bz));
+}
+
+static inline __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+{
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 clamp01_ps(__m128 a)
+{
+  return _mm_min_ps(_mm_max_ps(a, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+/* Lights four vertices at once; see gl_shade_vertex().  The operations are
+   performed in the same order, so the results match the scalar version. */
+static void gl_shade_vertex4(GLContext *c,GLVertex *v,GLSpecBuf *specbuf)
+{
+  GLMaterial *m=&c->materials[0];
+  GLLight *l;
+  int twoside = c->light_model_two_side;
+  __m128 zero = _mm_setzero_ps();
+  __m128 sign = _mm_set1_ps(-0.0f);
+
+  __m128 nx = _mm_set_ps(v[3].normal.v[0], v[2].normal.v[0], v[1].normal.v[0], v[0].normal.v[0]);
+  __m128 ny = _mm_set_ps(v[3].normal.v[1], v[2].normal.v[1], v[1].normal.v[1], v[0].normal.v[1]);
+  __m128 nz = _mm_set_ps(v[3].normal.v[2], v[2].normal.v[2], v[1].normal.v[2], v[0].normal.v[2]);
+
+  __m128 R = _mm_set1_ps(m->emission.v[0]+m->ambient.v[0]*c->ambient_light_model.v[0]);
+  __m128 G = _mm_set1_ps(m->emission.v[1]+m->ambient.v[1]*c->ambient_light_model.v[1]);
+  __m128 B = _mm_set1_ps(m->emission.v[2]+m->ambient.v[2]*c->ambient_light_model.v[2]);
+  __m128 A = _mm_set1_ps(clampf(m->diffuse.v[3],0,1));
+
+  for(l=c->first_light;l!=nullptr;l=l->next) {
+    __m128 lR = _mm_set1_ps(l->ambient.v[0] * m->ambient.v[0]);
+    __m128 lG = _mm_set1_ps(l->ambient.v[1] * m->ambient.v[1]);
+    __m128 lB = _mm_set1_ps(l->ambient.v[2] * m->ambient.v[2]);
+    __m128 dx, dy, dz, att;
+
+    if (l->position.v[3] == 0) {
+      dx = _mm_set1_ps(l->position.v[0]);
+      dy = _mm_set1_ps(l->position.v[1]);
+      dz = _mm_set1_ps(l->position.v[2]);
+      att = _mm_set1_ps(1.0f);
+    } else {
+      __m128 ex = _mm_set_ps(v[3].ec.v[0], v[2].ec.v[0], v[1].ec.v[0], v[0].ec.v[0]);
+      __m128 ey = _mm_set_ps(v[3].ec.v[1], v[2].ec.v[1], v[1].ec.v[1], v[0].ec.v[1]);
+      __m128 ez = _mm_set_ps(v[3].ec.v[2], v[2].ec.v[2], v[1].ec.v[2], v[0].ec.v[2]);
+      dx = _mm_sub_ps(_mm_set1_ps(l->position.v[0]), ex);
+      dy = _mm_sub_ps(_mm_set1_ps(l->position.v[1]), ey);
+      dz = _mm_sub_ps(_mm_set1_ps(l->position.v[2]), ez);
+      __m128 dist = _mm_sqrt_ps(dot3_ps(dx, dy, dz, dx, dy, dz));
+
+      /* dist > 1E-3 as a double comparison is dist >= 1E-3f */
+      __m128 far_mask = _mm_cmpge_ps(dist, _mm_set1_ps(1E-3f));
+      __m128 tmp = _mm_div_ps(_mm_set1_ps(1.0f), dist);
+      dx = select_ps(far_mask, _mm_mul_ps(dx, tmp), dx);
+      dy = select_ps(far_mask, _mm_mul_ps(dy, tmp), dy);
+      dz = select_ps(far_mask, _mm_mul_ps(dz, tmp), dz);
+
+      __m128 q = _mm_add_ps(_mm_set1_ps(l->attenuation[1]),
+                            _mm_mul_ps(dist, _mm_set1_ps(l->attenuation[2])));
+      q = _mm_add_ps(_mm_set1_ps(l->attenuation[0]), _mm_mul_ps(dist, q));
+      att = _mm_div_ps(_mm_set1_ps(1.0f), q);
+    }
+
+    __m128 dot = dot3_ps(dx, dy, dz, nx, ny, nz);
+    if (twoside) dot = _mm_andnot_ps(sign, dot);
+    __m128 lit = _mm_cmpgt_ps(dot, zero);
+    __m128 contributes = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+    if (_mm_movemask_ps(lit) != 0) {
+      /* diffuse light */
+      lR = select_ps(lit, _mm_add_ps(lR, _mm_mul_ps(_mm_mul_ps(dot, _mm_set1_ps(l->diffuse.v[0])), _mm_set1_ps(m->diffuse.v[0]))), lR);
+      lG = select_ps(lit, _mm_add_ps(lG, _mm_mul_ps(_mm_mul_ps(dot, _mm_set1_ps(l->diffuse.v[1])), _mm_set1_ps(m->diffuse.v[1]))), lG);
+      lB = select_ps(lit, _mm_add_ps(lB, _mm_mul_ps(_mm_mul_ps(dot, _mm_set1_ps(l->diffuse.v[2])), _mm_set1_ps(m->diffuse.v[2]))), lB);
+
+      /* spot light */
+      if (l->spot_cutoff != 180) {
+        __m128 dot_spot = dot3_ps(dx, dy, dz,
+                                  _mm_set1_ps(l->norm_spot_direction.v[0]),
+                                  _mm_set1_ps(l->norm_spot_direction.v[1]),
+                                  _mm_set1_ps(l->norm_spot_direction.v[2]));
+        dot_spot = _mm_xor_ps(dot_spot, sign);
+        if (twoside) dot_spot = _mm_andnot_ps(sign, dot_spot);
+
+        /* lit vertices outside the cone get no contribution at all */
+        __m128 outside = _mm_and_ps(lit, _mm_cmplt_ps(dot_spot, _mm_set1_ps(l->cos_spot_cutoff)));
+        contributes = _mm_andnot_ps(outside, contributes);
+        lit = _mm_andnot_ps(outside, lit);
+
+        if (l->spot_exponent > 0) {
+          int lit_bits = _mm_movemask_ps(lit);
+          float fs[4], fa[4];
+          _mm_storeu_ps(fs, dot_spot);
+          _mm_storeu_ps(fa, att);
+          for (int i = 0; i < 4; ++i) {
+            if (lit_bits & (1 << i)) {
+              fa[i] = fa[i]*pow(fs[i],l->spot_exponent);
+            }
+          }
+          att = _mm_loadu_ps(fa);
+        }
+      }
+
+      /* specular light */
+      __m128 sx, sy, sz;
+      if (c->local_light_model) {
+        /* note that this mirrors the scalar code, which only uses the x
+           component of the normalized eye vector */
+        float fx[4];
+        for (int i = 0; i < 4; ++i) {
+          V3 vcoord;
+          vcoord.v[0]=v[i].ec.v[0];
+          vcoord.v[1]=v[i].ec.v[1];
+          vcoord.v[2]=v[i].ec.v[2];
+          gl_V3_Norm(&vcoord);
+          fx[i] = vcoord.v[0];
+        }
+        __m128 vx = _mm_loadu_ps(fx);
+        sx = _mm_sub_ps(dx, vx);
+        sy = _mm_sub_ps(dy, vx);
+        sz = _mm_sub_ps(dz, vx);
+      } else {
+        sx = dx;
+        sy = dy;
+        sz = _mm_add_ps(dz, _mm_set1_ps(1.0f));
+      }
+      __m128 dot_spec = dot3_ps(nx, ny, nz, sx, sy, sz);
+      if (twoside) dot_spec = _mm_andnot_ps(sign, dot_spec);
+      int spec_bits = _mm_movemask_ps(_mm_and_ps(lit, _mm_cmpgt_ps(dot_spec, zero)));
+      if (spec_bits != 0) {
+        __m128 tmp = _mm_sqrt_ps(dot3_ps(sx, sy, sz, sx, sy, sz));
+        __m128 len_mask = _mm_cmpge_ps(tmp, _mm_set1_ps(1E-3f));
+        dot_spec = select_ps(len_mask, _mm_div_ps(dot_spec, tmp), dot_spec);
+
+        float fs[4];
+        _mm_storeu_ps(fs, dot_spec);
+        for (int i = 0; i < 4; ++i) {
+          if (spec_bits & (1 << i)) {
+            int idx = (int)(fs[i]*SPECULAR_BUFFER_SIZE);
+            if (idx > SPECULAR_BUFFER_SIZE) idx = SPECULAR_BUFFER_SIZE;
+            fs[i] = specbuf->buf[idx];
+          } else {
+            fs[i] = 0;
+          }
+        }
+        __m128 spec = _mm_loadu_ps(fs);
+        __m128 spec_mask = _mm_castsi128_ps(
+          _mm_set_epi32(-((spec_bits >> 3) & 1), -((spec_bits >> 2) & 1),
+                        -((spec_bits >> 1) & 1), -(spec_bits & 1)));
+        lR = select_ps(spec_mask, _mm_add_ps(lR, _mm_mul_ps(_mm_mul_ps(spec, _mm_set1_ps(l->specular.v[0])), _mm_set1_ps(m->specular.v[0]))), lR);
+        lG = select_ps(spec_mask, _mm_add_ps(lG, _mm_mul_ps(_mm_mul_ps(spec, _mm_set1_ps(l->specular.v[1])), _mm_set1_ps(m->specular.v[1]))), lG);
+        lB = select_ps(spec_mask, _mm_add_ps(lB, _mm_mul_ps(_mm_mul_ps(spec, _mm_set1_ps(l->specular.v[2])), _mm_set1_ps(m->specular.v[2]))), lB);
+      }
+    }
+
+    R = select_ps(contributes, _mm_add_ps(R, _mm_mul_ps(att, lR)), R);
+    G = select_ps(contributes, _mm_add_ps(G, _mm_mul_ps(att, lG)), G);
+    B = select_ps(contributes, _mm_add_ps(B, _mm_mul_ps(att, lB)), B);
+  }
+
+  __m128 cr, cg, cb, ca;
+  cr = _mm_loadu_ps(v[0].color.v);
+  cg = _mm_loadu_ps(v[1].color.v);
+  cb = _mm_loadu_ps(v[2].color.v);
+  ca = _mm_loadu_ps(v[3].color.v);
+  _MM_TRANSPOSE4_PS(cr, cg, cb, ca);
+  cr = clamp01_ps(_mm_mul_ps(R, cr));
+  cg = clamp01_ps(_mm_mul_ps(G, cg));
+  cb = clamp01_ps(_mm_mul_ps(B, cb));
+  ca = clamp01_ps(_mm_mul_ps(A, ca));
+  _MM_TRANSPOSE4_PS(cr, cg, cb, ca);
+  _mm_storeu_ps(v[0].color.v, cr);
+  _mm_storeu_ps(v[1].color.v, cg);
+  _mm_storeu_ps(v[2].color.v, cb);
+  _mm_storeu_ps(v[3].color.v, ca);
+}
+
+#endif  /* TD_VERTEX_SSE2 */
+
+/* Lights an array of vertices that all share c->materials[0].  Where SSE2 is
+   available, four vertices are lit per step. */
+void gl_shade_vertex_array(GLContext *c,GLVertex *v,int num_vertices)
+{
+  int i = 0;
+
+#ifdef TD_VERTEX_SSE2
+  if (num_vertices >= 4 && c->vectorize_vertices) {
+    GLMaterial *m=&c->materials[0];
+    GLSpecBuf *specbuf = specbuf_get_buffer(c, m->shininess_i, m->shininess);
+    for (; i + 4 <= num_vertices; i += 4) {
+      gl_shade_vertex4(c, v + i, specbuf);
+    }
+  }
+#endif
+
+  for (; i < num_vertices; ++i) {
+    gl_shade_vertex(c, v + i);
+  }
+}
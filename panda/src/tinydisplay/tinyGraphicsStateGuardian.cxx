@@ -14,6 +14,7 @@
 #include "tinyGraphicsStateGuardian.h"
 #include "tinyGeomMunger.h"
 #include "tinyTextureContext.h"
+#include "tinyTriangleBinner.h"
 #include "config_tinydisplay.h"
 #include "pStatTimer.h"
 #include "geomVertexReader.h"
@@ -110,6 +111,10 @@ reset() {
   _c = (GLContext *)gl_zalloc(sizeof(GLContext));
   glInit(_c, _current_frame_buffer);
 
+  if (td_num_threads > 0 && Thread::is_true_threads()) {
+    _c->binner = new TinyTriangleBinner(td_num_threads, td_max_binned_triangles);
+  }
+
   _c->draw_triangle_front = gl_draw_triangle_fill;
   _c->draw_triangle_back = gl_draw_triangle_fill;
 
@@ -208,6 +213,8 @@ clear(DrawableRegion *clearable) {
     return;
   }
 
+  gl_flush_triangles(_c);
+
   set_state_and_transform(RenderState::make_empty(), _internal_transform);
 
   bool clear_color = false;
@@ -249,6 +256,9 @@ prepare_display_region(DisplayRegionPipelineReader *dr) {
   nassertv(dr != nullptr);
   GraphicsStateGuardian::prepare_display_region(dr);
 
+  // The aux frame buffer may be reallocated below.
+  gl_flush_triangles(_c);
+
   int xmin, ymin, xsize, ysize;
   dr->get_region_pixels_i(xmin, ymin, xsize, ysize);
 
@@ -396,6 +406,8 @@ begin_scene() {
  */
 void TinyGraphicsStateGuardian::
 end_scene() {
+  gl_flush_triangles(_c);
+
   if (_c->zb == _aux_frame_buffer) {
     // Copy the aux frame buffer into the main scene now, zooming it up to the
     // appropriate size.
@@ -426,6 +438,10 @@ end_scene() {
  */
 void TinyGraphicsStateGuardian::
 end_frame(Thread *current_thread) {
+  // This must be done before textures are evicted by the base class.
+  gl_flush_triangles(_c);
+  add_pixel_counts();
+
   GraphicsStateGuardian::end_frame(current_thread);
 
 #ifndef NDEBUG
@@ -729,19 +745,46 @@ begin_draw_primitives(const GeomPipelineReader *geom_reader,
       _c->current_normal.v[1] = d[1];
       _c->current_normal.v[2] = d[2];
       _c->current_normal.v[3] = 0.0f;
+    }
+
+    // gl_vertex_transform() expects the object-space normal here.
+    v->normal.v[0] = _c->current_normal.v[0];
+    v->normal.v[1] = _c->current_normal.v[1];
+    v->normal.v[2] = _c->current_normal.v[2];
 
-      gl_vertex_transform(_c, v);
-      gl_shade_vertex(_c, v);
+    v->edge_flag = 1;
+  }
 
+  // Now transform and light the vertices in bulk, which lets the zgl code
+  // process several vertices at a time.
+  _c->vectorize_vertices = td_vectorize_vertices;
+  gl_vertex_transform_array(_c, _vertices, num_used_vertices);
+
+  if (lighting_enabled) {
+    if (needs_color && (_color_material_flags & (CMF_ambient | CMF_diffuse)) != 0) {
+      // The material follows the vertex color, so it changes per vertex.
+      for (i = 0; i < num_used_vertices; ++i) {
+        GLVertex *v = &_vertices[i];
+        if (_color_material_flags & CMF_ambient) {
+          _c->materials[0].ambient = v->color;
+          _c->materials[1].ambient = v->color;
+        }
+        if (_color_material_flags & CMF_diffuse) {
+          _c->materials[0].diffuse = v->color;
+          _c->materials[1].diffuse = v->color;
+        }
+        gl_shade_vertex(_c, v);
+      }
     } else {
-      gl_vertex_transform(_c, v);
+      gl_shade_vertex_array(_c, _vertices, num_used_vertices);
     }
+  }
 
+  for (i = 0; i < num_used_vertices; ++i) {
+    GLVertex *v = &_vertices[i];
     if (v->clip_code == 0) {
       gl_transform_to_viewport(_c, v);
     }
-
-    v->edge_flag = 1;
   }
 
   // Set up the appropriate function callback for filling triangles, according
@@ -923,20 +966,6 @@ begin_draw_primitives(const GeomPipelineReader *geom_reader,
 
   _c->zb_fill_tri = fill_tri_funcs[depth_write_state][color_write_state][alpha_test_state][depth_test_state][texfilter_state][shade_model_state][texturing_state];
 
-#ifdef DO_PSTATS
-  pixel_count_white_untextured = 0;
-  pixel_count_flat_untextured = 0;
-  pixel_count_smooth_untextured = 0;
-  pixel_count_white_textured = 0;
-  pixel_count_flat_textured = 0;
-  pixel_count_smooth_textured = 0;
-  pixel_count_white_perspective = 0;
-  pixel_count_flat_perspective = 0;
-  pixel_count_smooth_perspective = 0;
-  pixel_count_smooth_multitex2 = 0;
-  pixel_count_smooth_multitex3 = 0;
-#endif  // DO_PSTATS
-
   return true;
 }
 
@@ -1319,22 +1348,32 @@ draw_points(const GeomPrimitivePipelineReader *reader, bool force) {
  */
 void TinyGraphicsStateGuardian::
 end_draw_primitives() {
+  add_pixel_counts();
 
+  GraphicsStateGuardian::end_draw_primitives();
+}
+
+/**
+ * Adds the pixels counted by the triangle fill functions to the PStats
+ * collectors, and resets the counts.  Triangles that are queued up in the
+ * TinyTriangleBinner are only counted once they have been rasterized.
+ */
+void TinyGraphicsStateGuardian::
+add_pixel_counts() {
 #ifdef DO_PSTATS
-  _pixel_count_white_untextured_pcollector.add_level(pixel_count_white_untextured);
-  _pixel_count_flat_untextured_pcollector.add_level(pixel_count_flat_untextured);
-  _pixel_count_smooth_untextured_pcollector.add_level(pixel_count_smooth_untextured);
-  _pixel_count_white_textured_pcollector.add_level(pixel_count_white_textured);
-  _pixel_count_flat_textured_pcollector.add_level(pixel_count_flat_textured);
-  _pixel_count_smooth_textured_pcollector.add_level(pixel_count_smooth_textured);
-  _pixel_count_white_perspective_pcollector.add_level(pixel_count_white_perspective);
-  _pixel_count_flat_perspective_pcollector.add_level(pixel_count_flat_perspective);
-  _pixel_count_smooth_perspective_pcollector.add_level(pixel_count_smooth_perspective);
-  _pixel_count_smooth_multitex2_pcollector.add_level(pixel_count_smooth_multitex2);
-  _pixel_count_smooth_multitex3_pcollector.add_level(pixel_count_smooth_multitex3);
+  _pixel_count_white_untextured_pcollector.add_level(zb_pixel_counts.white_untextured);
+  _pixel_count_flat_untextured_pcollector.add_level(zb_pixel_counts.flat_untextured);
+  _pixel_count_smooth_untextured_pcollector.add_level(zb_pixel_counts.smooth_untextured);
+  _pixel_count_white_textured_pcollector.add_level(zb_pixel_counts.white_textured);
+  _pixel_count_flat_textured_pcollector.add_level(zb_pixel_counts.flat_textured);
+  _pixel_count_smooth_textured_pcollector.add_level(zb_pixel_counts.smooth_textured);
+  _pixel_count_white_perspective_pcollector.add_level(zb_pixel_counts.white_perspective);
+  _pixel_count_flat_perspective_pcollector.add_level(zb_pixel_counts.flat_perspective);
+  _pixel_count_smooth_perspective_pcollector.add_level(zb_pixel_counts.smooth_perspective);
+  _pixel_count_smooth_multitex2_pcollector.add_level(zb_pixel_counts.smooth_multitex2);
+  _pixel_count_smooth_multitex3_pcollector.add_level(zb_pixel_counts.smooth_multitex3);
+  memset(&zb_pixel_counts, 0, sizeof(zb_pixel_counts));
 #endif  // DO_PSTATS
-
-  GraphicsStateGuardian::end_draw_primitives();
 }
 
 /**
@@ -1348,6 +1387,7 @@ framebuffer_copy_to_texture(Texture *tex, int view, int z,
                             const DisplayRegion *dr,
                             const RenderBuffer &rb) {
   nassertr(tex != nullptr && dr != nullptr, false);
+  gl_flush_triangles(_c);
 
   int xo, yo, w, h;
   dr->get_region_pixels_i(xo, yo, w, h);
@@ -1396,6 +1436,7 @@ framebuffer_copy_to_ram(Texture *tex, int view, int z,
                         const DisplayRegion *dr,
                         const RenderBuffer &rb) {
   nassertr(tex != nullptr && dr != nullptr, false);
+  gl_flush_triangles(_c);
 
   int xo, yo, w, h;
   dr->get_region_pixels_i(xo, yo, w, h);
@@ -1724,6 +1765,11 @@ void TinyGraphicsStateGuardian::
 release_texture(TextureContext *tc) {
   _texturing_state = 0;  // just in case
 
+  // Queued triangles may still be referencing the texture memory.
+  if (_c != nullptr) {
+    gl_flush_triangles(_c);
+  }
+
   TinyTextureContext *gtc = DCAST(TinyTextureContext, tc);
   delete gtc;
 }
@@ -2377,6 +2423,9 @@ apply_texture(TextureContext *tc) {
  */
 bool TinyGraphicsStateGuardian::
 upload_texture(TinyTextureContext *gtc, bool force, bool uses_mipmaps) {
+  // Queued triangles may still be referencing the old texture memory.
+  gl_flush_triangles(_c);
+
   Texture *tex = gtc->get_texture();
 
   if (_effective_incomplete_render && !force) {
@@ -2522,6 +2571,8 @@ upload_texture(TinyTextureContext *gtc, bool force, bool uses_mipmaps) {
  */
 bool TinyGraphicsStateGuardian::
 upload_simple_texture(TinyTextureContext *gtc) {
+  gl_flush_triangles(_c);
+
   PStatTimer timer(_load_texture_pcollector);
   Texture *tex = gtc->get_texture();
   nassertr(tex != nullptr, false);
@@ -129,6 +129,7 @@ private:
   static ZB_texWrapFunc get_tex_wrap_func(SamplerState::WrapMode wrap_mode);
 
   INLINE void clear_light_state();
+  void add_pixel_counts();
 
   // Methods used to generate texture coordinates.
   class TexCoordData {
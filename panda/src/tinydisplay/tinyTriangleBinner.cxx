@@ -0,0 +1,122 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file tinyTriangleBinner.cxx
+ * @author jmarsh
+ * @date 2026-10-15
+ */
+
+#include "tinyTriangleBinner.h"
+#include "pStatTimer.h"
+
+#include <string.h>
+#include <limits.h>
+
+PStatCollector TinyTriangleBinner::_flush_pcollector("Draw:Rasterize");
+
+/**
+ *
+ */
+TinyTriangleBinner::
+TinyTriangleBinner(int num_threads, int max_triangles) :
+  _ysize(0),
+  _max_triangles(std::max(max_triangles, 1)),
+  _job_runner("tinydisplay", num_threads)
+{
+  _triangles.reserve(_max_triangles);
+}
+
+/**
+ * Queues up the indicated triangle for rasterization with the given fill
+ * function, using the current state of the ZBuffer.  The triangle may be
+ * rasterized immediately if the queue is full.
+ */
+void TinyTriangleBinner::
+add_triangle(ZBuffer *zb, ZB_fillTriangleFunc fill_func,
+             const ZBufferPoint *p0, const ZBufferPoint *p1,
+             const ZBufferPoint *p2) {
+  // The ZBuffer state (textures, blending, etc.) only changes between
+  // primitives, so we only need to take a new snapshot when it differs from
+  // the last one.
+  if (_states.empty() || memcmp(&_states.back(), zb, sizeof(ZBuffer)) != 0) {
+    _states.push_back(ZBuffer());
+    memcpy(&_states.back(), zb, sizeof(ZBuffer));
+    _ysize = std::max(_ysize, zb->ysize);
+  }
+
+  _triangles.push_back(Triangle());
+  Triangle &tri = _triangles.back();
+  tri._fill_func = fill_func;
+  tri._state_index = (int)_states.size() - 1;
+  tri._ymin = std::min(p0->y, std::min(p1->y, p2->y));
+  tri._ymax = std::max(p0->y, std::max(p1->y, p2->y));
+  tri._p[0] = *p0;
+  tri._p[1] = *p1;
+  tri._p[2] = *p2;
+
+  if (_triangles.size() >= _max_triangles) {
+    do_flush();
+  }
+}
+
+/**
+ * Does the work of flush().
+ */
+void TinyTriangleBinner::
+do_flush() {
+  PStatTimer timer(_flush_pcollector);
+
+  // Use a few more bands than threads, since the triangles are rarely
+  // spread evenly over the screen.
+  int num_bands = _job_runner.is_parallel() ? (_job_runner.get_num_threads() + 1) * 2 : 1;
+  num_bands = std::max(std::min(num_bands, _ysize), 1);
+  int band_size = (_ysize + num_bands - 1) / num_bands;
+
+  // Each band counts its pixels separately, since the bands are rasterized
+  // at the same time.  The counts are added up afterwards.
+  pvector<ZBPixelCounts> band_counts(num_bands, ZBPixelCounts());
+
+  _job_runner.run(num_bands, [&] (int band, Thread *current_thread) {
+    int band_ymin = band * band_size;
+    int band_ymax = (band + 1 == num_bands) ? INT_MAX : band_ymin + band_size;
+
+    ZBuffer zb;
+    int state_index = -1;
+
+    for (const Triangle &tri : _triangles) {
+      if (tri._ymax < band_ymin || tri._ymin >= band_ymax) {
+        continue;
+      }
+      if (tri._state_index != state_index) {
+        state_index = tri._state_index;
+        memcpy(&zb, &_states[state_index], sizeof(ZBuffer));
+        zb.band_ymin = band_ymin;
+        zb.band_ymax = band_ymax;
+        zb.pixel_counts = &band_counts[band];
+      }
+
+      // The fill functions scribble on the points, so give each band its
+      // own copy.
+      ZBufferPoint p0 = tri._p[0];
+      ZBufferPoint p1 = tri._p[1];
+      ZBufferPoint p2 = tri._p[2];
+      (*tri._fill_func)(&zb, &p0, &p1, &p2);
+    }
+  });
+
+  ZBPixelCounts *pixel_counts = _states.front().pixel_counts;
+  if (pixel_counts != nullptr) {
+    for (const ZBPixelCounts &counts : band_counts) {
+      ZB_addPixelCounts(pixel_counts, &counts);
+    }
+  }
+
+  _triangles.clear();
+  _states.clear();
+  _ysize = 0;
+}
@@ -0,0 +1,72 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file tinyTriangleBinner.h
+ * @author jmarsh
+ * @date 2026-10-15
+ */
+
+#ifndef TINYTRIANGLEBINNER_H
+#define TINYTRIANGLEBINNER_H
+
+#include "pandabase.h"
+#include "parallelJobRunner.h"
+#include "pvector.h"
+#include "zbuffer.h"
+
+/**
+ * Collects post-transform triangles, along with a snapshot of the ZBuffer
+ * state they were issued with, and rasterizes them later in parallel.
+ *
+ * The frame buffer is divided into horizontal bands of rows, and each band
+ * is rasterized by one thread, which visits all of the queued triangles that
+ * touch the band in the order in which they were issued.  Since each pixel
+ * is written by exactly one thread, and the rasterizer steps over the rows
+ * outside its band exactly as it would draw them, the result is identical to
+ * that of rasterizing the triangles immediately.
+ *
+ * The queue must be flushed before anything else reads or writes the frame
+ * buffer, or modifies the memory of a texture that may be referenced by a
+ * queued triangle.
+ */
+class EXPCL_TINYDISPLAY TinyTriangleBinner {
+public:
+  TinyTriangleBinner(int num_threads, int max_triangles);
+
+  void add_triangle(ZBuffer *zb, ZB_fillTriangleFunc fill_func,
+                    const ZBufferPoint *p0, const ZBufferPoint *p1,
+                    const ZBufferPoint *p2);
+  INLINE bool is_empty() const;
+  INLINE void flush();
+
+private:
+  void do_flush();
+
+private:
+  struct Triangle {
+    ZB_fillTriangleFunc _fill_func;
+    int _state_index;
+    int _ymin, _ymax;
+    ZBufferPoint _p[3];
+  };
+  typedef pvector<Triangle> Triangles;
+  typedef pvector<ZBuffer> States;
+
+  Triangles _triangles;
+  States _states;
+  int _ysize;
+  size_t _max_triangles;
+
+  ParallelJobRunner _job_runner;
+
+  static PStatCollector _flush_pcollector;
+};
+
+#include "tinyTriangleBinner.I"
+
+#endif
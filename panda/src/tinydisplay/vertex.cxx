@@ -25,7 +25,7 @@ void gl_eval_viewport(GLContext * c) {
 void 
 gl_vertex_transform(GLContext * c, GLVertex * v) {
   PN_stdfloat *m;
-  V4 *n;
+  V3 n;
 
   if (c->lighting_enabled) {
     /* eye coordinates needed for lighting */
@@ -51,12 +51,13 @@ gl_vertex_transform(GLContext * c, GLVertex * v) {
     v->pc.v[3] = (v->ec.v[0] * m[12] + v->ec.v[1] * m[13] +
                   v->ec.v[2] * m[14] + v->ec.v[3] * m[15]);
 
+    /* v->normal holds the object-space normal on input */
     m = &c->matrix_model_view_inv.m[0][0];
-    n = &c->current_normal;
+    n = v->normal;
 
-    v->normal.v[0] = (n->v[0] * m[0] + n->v[1] * m[1] + n->v[2] * m[2]) * c->normal_scale;
-    v->normal.v[1] = (n->v[0] * m[4] + n->v[1] * m[5] + n->v[2] * m[6]) * c->normal_scale;
-    v->normal.v[2] = (n->v[0] * m[8] + n->v[1] * m[9] + n->v[2] * m[10]) * c->normal_scale;
+    v->normal.v[0] = (n.v[0] * m[0] + n.v[1] * m[1] + n.v[2] * m[2]) * c->normal_scale;
+    v->normal.v[1] = (n.v[0] * m[4] + n.v[1] * m[5] + n.v[2] * m[6]) * c->normal_scale;
+    v->normal.v[2] = (n.v[0] * m[8] + n.v[1] * m[9] + n.v[2] * m[10]) * c->normal_scale;
 
     if (c->normalize_enabled) {
       gl_V3_Norm(&v->normal);
@@ -82,3 +83,165 @@ gl_vertex_transform(GLContext * c, GLVertex * v) {
 
   v->clip_code = gl_clipcode(v->pc.v[0], v->pc.v[1], v->pc.v[2], v->pc.v[3]);
 }
+
+#ifdef TD_VERTEX_SSE2
+
+/* Loads the given V4 member of four consecutive vertices, transposed so that
+   each register holds one component of all four vertices. */
+#define LOAD_V4_SOA(verts, member, x, y, z, w) { \
+  x = _mm_loadu_ps((verts)[0].member.v); \
+  y = _mm_loadu_ps((verts)[1].member.v); \
+  z = _mm_loadu_ps((verts)[2].member.v); \
+  w = _mm_loadu_ps((verts)[3].member.v); \
+  _MM_TRANSPOSE4_PS(x, y, z, w); \
+}
+
+#define STORE_V4_SOA(verts, member, x, y, z, w) { \
+  __m128 _x = x, _y = y, _z = z, _w = w; \
+  _MM_TRANSPOSE4_PS(_x, _y, _z, _w); \
+  _mm_storeu_ps((verts)[0].member.v, _x); \
+  _mm_storeu_ps((verts)[1].member.v, _y); \
+  _mm_storeu_ps((verts)[2].member.v, _z); \
+  _mm_storeu_ps((verts)[3].member.v, _w); \
+}
+
+/* Computes one row of a matrix times a column vector (x, y, z, 1), in the
+   same order of operations as the scalar code. */
+static inline __m128
+mul_row_w1(const PN_stdfloat *r, __m128 x, __m128 y, __m128 z) {
+  __m128 a = _mm_mul_ps(x, _mm_set1_ps(r[0]));
+  a = _mm_add_ps(a, _mm_mul_ps(y, _mm_set1_ps(r[1])));
+  a = _mm_add_ps(a, _mm_mul_ps(z, _mm_set1_ps(r[2])));
+  return _mm_add_ps(a, _mm_set1_ps(r[3]));
+}
+
+static inline __m128
+mul_row(const PN_stdfloat *r, __m128 x, __m128 y, __m128 z, __m128 w) {
+  __m128 a = _mm_mul_ps(x, _mm_set1_ps(r[0]));
+  a = _mm_add_ps(a, _mm_mul_ps(y, _mm_set1_ps(r[1])));
+  a = _mm_add_ps(a, _mm_mul_ps(z, _mm_set1_ps(r[2])));
+  return _mm_add_ps(a, _mm_mul_ps(w, _mm_set1_ps(r[3])));
+}
+
+static inline __m128
+mul_row3(const PN_stdfloat *r, __m128 x, __m128 y, __m128 z) {
+  __m128 a = _mm_mul_ps(x, _mm_set1_ps(r[0]));
+  a = _mm_add_ps(a, _mm_mul_ps(y, _mm_set1_ps(r[1])));
+  return _mm_add_ps(a, _mm_mul_ps(z, _mm_set1_ps(r[2])));
+}
+
+/* Computes the clip codes of four vertices at once, see gl_clipcode(). */
+static inline void
+store_clipcodes(GLVertex *v, __m128 x, __m128 y, __m128 z, __m128 w1) {
+  __m128 w = _mm_mul_ps(w1, _mm_set1_ps(1.0f + CLIP_EPSILON));
+  __m128 nw = _mm_xor_ps(w, _mm_set1_ps(-0.0f));
+
+  int xmin = _mm_movemask_ps(_mm_cmplt_ps(x, nw));
+  int xmax = _mm_movemask_ps(_mm_cmpgt_ps(x, w));
+  int ymin = _mm_movemask_ps(_mm_cmplt_ps(y, nw));
+  int ymax = _mm_movemask_ps(_mm_cmpgt_ps(y, w));
+  int zmin = _mm_movemask_ps(_mm_cmplt_ps(z, nw));
+  int zmax = _mm_movemask_ps(_mm_cmpgt_ps(z, w));
+
+  for (int i = 0; i < 4; ++i) {
+    v[i].clip_code = ((xmin >> i) & 1) |
+      (((xmax >> i) & 1) << 1) |
+      (((ymin >> i) & 1) << 2) |
+      (((ymax >> i) & 1) << 3) |
+      (((zmin >> i) & 1) << 4) |
+      (((zmax >> i) & 1) << 5);
+  }
+}
+
+#endif  /* TD_VERTEX_SSE2 */
+
+/* Same as gl_vertex_transform(), applied to an array of vertices.  Where
+   SSE2 is available, four vertices are transformed per step; the results are
+   identical to those of the scalar path. */
+void
+gl_vertex_transform_array(GLContext *c, GLVertex *v, int num_vertices) {
+  int i = 0;
+
+#ifdef TD_VERTEX_SSE2
+  if (!c->vectorize_vertices) {
+    // Leave all of the vertices to the scalar loop below.
+
+  } else if (c->lighting_enabled) {
+    const PN_stdfloat *mv = &c->matrix_model_view.m[0][0];
+    const PN_stdfloat *p = &c->matrix_projection.m[0][0];
+    const PN_stdfloat *ni = &c->matrix_model_view_inv.m[0][0];
+    __m128 scale = _mm_set1_ps(c->normal_scale);
+    __m128 zero = _mm_setzero_ps();
+
+    for (; i + 4 <= num_vertices; i += 4) {
+      GLVertex *q = v + i;
+      __m128 x, y, z, w;
+      LOAD_V4_SOA(q, coord, x, y, z, w);
+
+      __m128 ex = mul_row_w1(mv + 0, x, y, z);
+      __m128 ey = mul_row_w1(mv + 4, x, y, z);
+      __m128 ez = mul_row_w1(mv + 8, x, y, z);
+      __m128 ew = mul_row_w1(mv + 12, x, y, z);
+      STORE_V4_SOA(q, ec, ex, ey, ez, ew);
+
+      __m128 px = mul_row(p + 0, ex, ey, ez, ew);
+      __m128 py = mul_row(p + 4, ex, ey, ez, ew);
+      __m128 pz = mul_row(p + 8, ex, ey, ez, ew);
+      __m128 pw = mul_row(p + 12, ex, ey, ez, ew);
+      STORE_V4_SOA(q, pc, px, py, pz, pw);
+      store_clipcodes(q, px, py, pz, pw);
+
+      __m128 nx = _mm_set_ps(q[3].normal.v[0], q[2].normal.v[0], q[1].normal.v[0], q[0].normal.v[0]);
+      __m128 ny = _mm_set_ps(q[3].normal.v[1], q[2].normal.v[1], q[1].normal.v[1], q[0].normal.v[1]);
+      __m128 nz = _mm_set_ps(q[3].normal.v[2], q[2].normal.v[2], q[1].normal.v[2], q[0].normal.v[2]);
+
+      __m128 tx = _mm_mul_ps(mul_row3(ni + 0, nx, ny, nz), scale);
+      __m128 ty = _mm_mul_ps(mul_row3(ni + 4, nx, ny, nz), scale);
+      __m128 tz = _mm_mul_ps(mul_row3(ni + 8, nx, ny, nz), scale);
+
+      if (c->normalize_enabled) {
+        __m128 len = _mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty));
+        len = _mm_sqrt_ps(_mm_add_ps(len, _mm_mul_ps(tz, tz)));
+
+        // Leave zero-length normals alone, like gl_V3_Norm() does.
+        __m128 keep = _mm_cmpeq_ps(len, zero);
+        __m128 safe = _mm_or_ps(_mm_and_ps(keep, _mm_set1_ps(1.0f)),
+                                _mm_andnot_ps(keep, len));
+        tx = _mm_div_ps(tx, safe);
+        ty = _mm_div_ps(ty, safe);
+        tz = _mm_div_ps(tz, safe);
+      }
+
+      float fx[4], fy[4], fz[4];
+      _mm_storeu_ps(fx, tx);
+      _mm_storeu_ps(fy, ty);
+      _mm_storeu_ps(fz, tz);
+      for (int j = 0; j < 4; ++j) {
+        q[j].normal.v[0] = fx[j];
+        q[j].normal.v[1] = fy[j];
+        q[j].normal.v[2] = fz[j];
+      }
+    }
+  } else {
+    const PN_stdfloat *m = &c->matrix_model_projection.m[0][0];
+    bool no_w = (c->matrix_model_projection_no_w_transform != 0);
+
+    for (; i + 4 <= num_vertices; i += 4) {
+      GLVertex *q = v + i;
+      __m128 x, y, z, w;
+      LOAD_V4_SOA(q, coord, x, y, z, w);
+
+      __m128 px = mul_row_w1(m + 0, x, y, z);
+      __m128 py = mul_row_w1(m + 4, x, y, z);
+      __m128 pz = mul_row_w1(m + 8, x, y, z);
+      __m128 pw = no_w ? _mm_set1_ps(m[15]) : mul_row_w1(m + 12, x, y, z);
+      STORE_V4_SOA(q, pc, px, py, pz, pw);
+      store_clipcodes(q, px, py, pz, pw);
+    }
+  }
+#endif  /* TD_VERTEX_SSE2 */
+
+  for (; i < num_vertices; ++i) {
+    gl_vertex_transform(c, v + i);
+  }
+}
@@ -7,26 +7,33 @@
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
+#include <limits.h>
 #include "zbuffer.h"
 #include "pnotify.h"
 
 #ifdef DO_PSTATS
-int pixel_count_white_untextured;
-int pixel_count_flat_untextured;
-int pixel_count_smooth_untextured;
-int pixel_count_white_textured;
-int pixel_count_flat_textured;
-int pixel_count_smooth_textured;
-int pixel_count_white_perspective;
-int pixel_count_flat_perspective;
-int pixel_count_smooth_perspective;
-int pixel_count_smooth_multitex2;
-int pixel_count_smooth_multitex3;
+ZBPixelCounts zb_pixel_counts;
 #endif  // DO_PSTATS
 
 using std::max;
 using std::min;
 
+/* adds the pixel counts in src to those in dest */
+void
+ZB_addPixelCounts(ZBPixelCounts *dest, const ZBPixelCounts *src) {
+  dest->white_untextured += src->white_untextured;
+  dest->flat_untextured += src->flat_untextured;
+  dest->smooth_untextured += src->smooth_untextured;
+  dest->white_textured += src->white_textured;
+  dest->flat_textured += src->flat_textured;
+  dest->smooth_textured += src->smooth_textured;
+  dest->white_perspective += src->white_perspective;
+  dest->flat_perspective += src->flat_perspective;
+  dest->smooth_perspective += src->smooth_perspective;
+  dest->smooth_multitex2 += src->smooth_multitex2;
+  dest->smooth_multitex3 += src->smooth_multitex3;
+}
+
 ZBuffer *
 ZB_open(int xsize, int ysize, int mode,
         int nb_colors,
@@ -48,6 +55,11 @@ ZB_open(int xsize, int ysize, int mode,
   zb->ysize = ysize;
   zb->mode = mode;
   zb->linesize = (xsize * PSZB + 3) & ~3;
+  zb->band_ymin = 0;
+  zb->band_ymax = INT_MAX;
+#ifdef DO_PSTATS
+  zb->pixel_counts = &zb_pixel_counts;
+#endif
 
   switch (mode) {
 #ifdef TGL_FEATURE_8_BITS
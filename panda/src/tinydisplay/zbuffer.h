@@ -158,6 +158,21 @@ struct ZTextureDef {
   PIXEL border_color;
 };
 
+/* the number of pixels drawn by each kind of fill function, for PStats */
+struct ZBPixelCounts {
+  int white_untextured;
+  int flat_untextured;
+  int smooth_untextured;
+  int white_textured;
+  int flat_textured;
+  int smooth_textured;
+  int white_perspective;
+  int flat_perspective;
+  int smooth_perspective;
+  int smooth_multitex2;
+  int smooth_multitex3;
+};
+
 struct ZBuffer {
   int xsize,ysize;
   int linesize; /* line size, in bytes */
@@ -174,6 +189,13 @@ struct ZBuffer {
   int reference_alpha;
   int blend_r, blend_g, blend_b, blend_a;
   ZB_storePixelFunc store_pix_func;
+
+  /* the triangle fill functions only touch rows in [band_ymin, band_ymax) */
+  int band_ymin, band_ymax;
+
+  /* the triangle fill functions count their pixels here; each band has its
+     own counts, see TinyTriangleBinner */
+  ZBPixelCounts *pixel_counts;
 };
 
 struct ZBufferPoint {
@@ -193,27 +215,19 @@ struct ZBufferPoint {
 /* zbuffer.c */
 
 #ifdef DO_PSTATS
-extern int pixel_count_white_untextured;
-extern int pixel_count_flat_untextured;
-extern int pixel_count_smooth_untextured;
-extern int pixel_count_white_textured;
-extern int pixel_count_flat_textured;
-extern int pixel_count_smooth_textured;
-extern int pixel_count_white_perspective;
-extern int pixel_count_flat_perspective;
-extern int pixel_count_smooth_perspective;
-extern int pixel_count_smooth_multitex2;
-extern int pixel_count_smooth_multitex3;
-
-#define COUNT_PIXELS(pixel_count, p0, p1, p2) \
-  (pixel_count) += abs((p0)->x * ((p1)->y - (p2)->y) + (p1)->x * ((p2)->y - (p0)->y) + (p2)->x * ((p0)->y - (p1)->y)) / 2
+extern ZBPixelCounts zb_pixel_counts;
+
+#define COUNT_PIXELS(zb, field, p0, p1, p2) \
+  (zb)->pixel_counts->field += abs((p0)->x * ((p1)->y - (p2)->y) + (p1)->x * ((p2)->y - (p0)->y) + (p2)->x * ((p0)->y - (p1)->y)) / 2
 
 #else
 
-#define COUNT_PIXELS(pixel_count, p0, p1, p2)
+#define COUNT_PIXELS(zb, field, p0, p1, p2)
 
 #endif  // DO_PSTATS
 
+void ZB_addPixelCounts(ZBPixelCounts *dest, const ZBPixelCounts *src);
+
 ZBuffer *ZB_open(int xsize,int ysize,int mode,
                  int nb_colors,
                  unsigned char *color_indexes,
@@ -11,6 +11,15 @@
 #include "zmath.h"
 #include "zfeatures.h"
 
+/* The batched vertex transform and lighting routines use SSE2 when it is
+   guaranteed at compile time and PN_stdfloat is single-precision. */
+#if !defined(STDFLOAT_DOUBLE) && \
+  (defined(__SSE2__) || (_M_IX86_FP >= 2) || defined(_M_X64) || defined(_M_AMD64))
+#define TD_VERTEX_SSE2 1
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#endif
+
 /* initially # of allocated GLVertexes (will grow when necessary) */
 #define POLYGON_MAX_VERTEX 16
 
@@ -132,6 +141,7 @@ typedef struct GLTexture {
 } GLTexture;
 
 struct GLContext;
+class TinyTriangleBinner;
 
 typedef void (*gl_draw_triangle_func)(struct GLContext *c,
                                       GLVertex *p0,GLVertex *p1,GLVertex *p2);
@@ -177,9 +187,16 @@ typedef struct GLContext {
   int normalize_enabled;
   PN_stdfloat normal_scale;
 
+  /* if false, the array functions process the vertices one at a time */
+  int vectorize_vertices;
+
   gl_draw_triangle_func draw_triangle_front,draw_triangle_back;
   ZB_fillTriangleFunc zb_fill_tri;
 
+  /* if not null, filled triangles are queued here to be rasterized by
+     multiple threads */
+  TinyTriangleBinner *binner;
+
   /* current vertex state */
   V4 current_color;
   V4 current_normal;
@@ -203,6 +220,7 @@ void glClose(GLContext *c);
 
 /* clip.c */
 void gl_transform_to_viewport(GLContext *c,GLVertex *v);
+void gl_flush_triangles(GLContext *c);
 void gl_draw_triangle(GLContext *c,GLVertex *p0,GLVertex *p1,GLVertex *p2);
 void gl_draw_line(GLContext *c,GLVertex *p0,GLVertex *p1);
 void gl_draw_point(GLContext *c,GLVertex *p0);
@@ -217,10 +235,12 @@ void gl_draw_triangle_fill(GLContext *c,
 /* light.c */
 void gl_enable_disable_light(GLContext *c,int light,int v);
 void gl_shade_vertex(GLContext *c,GLVertex *v);
+void gl_shade_vertex_array(GLContext *c,GLVertex *v,int num_vertices);
 
 /* vertex.c */
 void gl_eval_viewport(GLContext *c);
 void gl_vertex_transform(GLContext * c, GLVertex * v);
+void gl_vertex_transform_array(GLContext *c, GLVertex *v, int num_vertices);
 
 /* image_util.c */
 void gl_convertRGB_to_5R6G5B(unsigned short *pixmap,unsigned char *rgb,
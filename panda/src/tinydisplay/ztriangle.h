@@ -9,7 +9,7 @@
   PIXEL *pp1;
   int part, update_left, update_right;
 
-  int nb_lines, dx1, dy1, tmp, dx2, dy2;
+  int nb_lines, dx1, dy1, tmp, dx2, dy2, line_y;
 
   int error, derror;
   int x1, dxdy_min, dxdy_max;
@@ -53,8 +53,6 @@
 
   EARLY_OUT();
 
-  COUNT_PIXELS(PIXEL_COUNT, p0, p1, p2);
-
   /* we sort the vertex with increasing y */
   if (p1->y < p0->y) {
     t = p0;
@@ -72,6 +70,17 @@
     p2 = t;
   }
 
+  /* skip the triangle if it lies entirely outside the band of rows we have
+     been restricted to; see TinyTriangleBinner */
+  if (p2->y < zb->band_ymin || p0->y >= zb->band_ymax)
+    return;
+
+  /* only the band containing the top vertex counts the pixels, so that
+     the count is the same regardless of the number of bands */
+  if (p0->y >= zb->band_ymin) {
+    COUNT_PIXELS(zb, PIXEL_COUNT, p0, p1, p2);
+  }
+
   /* we compute dXdx and dXdy for all interpolated values */
   
   fdx1 = (PN_stdfloat) (p1->x - p0->x);
@@ -216,6 +225,8 @@
 
   DRAW_INIT();
 
+  line_y = p0->y;
+
   for(part=0;part<2;part++) {
     if (part == 0) {
       if (fz > 0) {
@@ -341,6 +352,9 @@
 
     while (nb_lines>0) {
       nb_lines--;
+      /* lines above the band are stepped over without being drawn, so that
+         the edge interpolation is exactly the same as without banding */
+      if (line_y >= zb->band_ymin)
 #ifndef DRAW_LINE
       /* generic draw line */
       {
@@ -483,6 +497,10 @@
       /* screen coordinates */
       pp1=(PIXEL *)((char *)pp1 + zb->linesize);
       pz1+=zb->xsize;
+
+      /* nothing more to draw once we have left the band */
+      if (++line_y >= zb->band_ymax)
+        return;
     }
   }
 }
@@ -28,7 +28,7 @@ FNAME(white_untextured) (ZBuffer *zb,
     z+=dzdx;                                                            \
   }
 
-#define PIXEL_COUNT pixel_count_white_untextured
+#define PIXEL_COUNT white_untextured
 
 #include "ztriangle.h"
 }
@@ -68,7 +68,7 @@ FNAME(flat_untextured) (ZBuffer *zb,
     z+=dzdx;                                            \
   }
 
-#define PIXEL_COUNT pixel_count_flat_untextured
+#define PIXEL_COUNT flat_untextured
 
 #include "ztriangle.h"
 }
@@ -118,7 +118,7 @@ FNAME(smooth_untextured) (ZBuffer *zb,
     oa1+=dadx;                                                          \
   }
 
-#define PIXEL_COUNT pixel_count_smooth_untextured
+#define PIXEL_COUNT smooth_untextured
 
 #include "ztriangle.h"
 }
@@ -156,7 +156,7 @@ FNAME(white_textured) (ZBuffer *zb,
     t+=dtdx;                                                            \
   }
 
-#define PIXEL_COUNT pixel_count_white_textured
+#define PIXEL_COUNT white_textured
 
 #include "ztriangle.h"
 }
@@ -212,7 +212,7 @@ FNAME(flat_textured) (ZBuffer *zb,
     t+=dtdx;                                                            \
   }
 
-#define PIXEL_COUNT pixel_count_flat_textured
+#define PIXEL_COUNT flat_textured
 
 #include "ztriangle.h"
 }
@@ -278,7 +278,7 @@ FNAME(smooth_textured) (ZBuffer *zb,
     t+=dtdx;                                                            \
   }
 
-#define PIXEL_COUNT pixel_count_smooth_textured
+#define PIXEL_COUNT smooth_textured
 
 #include "ztriangle.h"
 }
@@ -390,7 +390,7 @@ FNAME(white_perspective) (ZBuffer *zb,
     }                                                           \
   }
   
-#define PIXEL_COUNT pixel_count_white_perspective
+#define PIXEL_COUNT white_perspective
 
 #include "ztriangle.h"
 }
@@ -521,7 +521,7 @@ FNAME(flat_perspective) (ZBuffer *zb,
     }                                                           \
   }
 
-#define PIXEL_COUNT pixel_count_flat_perspective
+#define PIXEL_COUNT flat_perspective
 
 #include "ztriangle.h"
 }
@@ -661,7 +661,7 @@ FNAME(smooth_perspective) (ZBuffer *zb,
     }                                                           \
   }
 
-#define PIXEL_COUNT pixel_count_smooth_perspective
+#define PIXEL_COUNT smooth_perspective
 
 #include "ztriangle.h"
 }
@@ -816,7 +816,7 @@ FNAME(smooth_multitex2) (ZBuffer *zb,
     }                                                                   \
   }
 
-#define PIXEL_COUNT pixel_count_smooth_multitex2
+#define PIXEL_COUNT smooth_multitex2
 
 #include "ztriangle.h"
 }
@@ -1001,7 +1001,7 @@ FNAME(smooth_multitex3) (ZBuffer *zb,
     }                                                                   \
   }
 
-#define PIXEL_COUNT pixel_count_smooth_multitex3
+#define PIXEL_COUNT smooth_multitex3
 
 #include "ztriangle.h"
 }
@@ -21,6 +21,8 @@
 #include "config_chan.h"
 #include "pandaNode.h"
 #include "geomNode.h"
+#include "sceneGraphReducer.h"
+#include "lodNode.h"
 #include "renderState.h"
 #include "textureAttrib.h"
 #include "dcast.h"
@@ -82,6 +84,59 @@ EggToBam() :
      "default is nonzero, to remove it.",
      &EggToBam::dispatch_int, nullptr, &_egg_suppress_hidden);
 
+  add_option
+    ("simplify", "ratio", 0,
+     "Reduce the number of triangles of each mesh to approximately the "
+     "indicated fraction of the original number, by collapsing the edges "
+     "whose removal changes the shape of the mesh the least.  Texture "
+     "seams, vertex normals and colors, and skinning weights are preserved.",
+     &EggToBam::dispatch_double, &_has_simplify_ratio, &_simplify_ratio);
+
+  add_option
+    ("simplify-error", "distance", 0,
+     "Used with -simplify, this limits the distance by which the surface "
+     "of a mesh may be moved, in model units.  Fewer triangles may be "
+     "removed as a result.  Without this option, only the ratio given to "
+     "-simplify is taken into account.",
+     &EggToBam::dispatch_double, &_has_simplify_error, &_simplify_error);
+
+  add_option
+    ("lod", "levels", 0,
+     "Replace the model with an LODNode that has up to the indicated number "
+     "of levels, each of which is a copy of the model with a fraction of "
+     "the triangles of the previous level; see -lod-ratio.  The switching "
+     "distances are chosen automatically from the error of each level; see "
+     "-lod-error.  "
+     "The type of LODNode is taken from the default-lod-type Config.prc "
+     "variable.",
+     &EggToBam::dispatch_int, nullptr, &_lod_levels);
+
+  add_option
+    ("lod-error", "pixels", 0,
+     "Used with -lod, this specifies the largest error, in pixels on a "
+     "1080-pixel high screen with a 40-degree vertical field of view, that "
+     "is acceptable before switching to a more detailed level.  The "
+     "default is 1.",
+     &EggToBam::dispatch_double, nullptr, &_lod_pixel_error);
+
+  add_option
+    ("lod-ratio", "fraction", 0,
+     "Used with -lod, this specifies the fraction of the triangles of each "
+     "level that are kept in the next, simpler level.  It must be between "
+     "0 and 1.  The default is 0.5.",
+     &EggToBam::dispatch_double, nullptr, &_lod_ratio);
+
+  add_option
+    ("vcache", "", 0,
+     "Reorder the triangles of each mesh for better use of the vertex cache "
+     "of the graphics hardware, and the vertices for better locality, "
+     "after the egg file has been loaded and flattened.  The triangles are "
+     "also ordered so that the outward-facing parts of each mesh are drawn "
+     "first, to reduce overdraw.  The average cache miss ratio (ACMR) before "
+     "and after is reported.  The assumed size of the vertex cache is taken "
+     "from the vertex-cache-size Config.prc variable.",
+     &EggToBam::dispatch_none, &_optimize_vertex_cache);
+
   add_option
     ("ls", "", 0,
      "Writes a scene graph listing to standard output after the egg "
@@ -210,6 +265,11 @@ EggToBam() :
   _egg_flatten = 0;
   _egg_combine_geoms = 0;
   _egg_suppress_hidden = 1;
+  _simplify_error = -1.0;
+  _lod_levels = 0;
+  _lod_pixel_error = 1.0;
+  _lod_ratio = 0.5;
+  _optimize_vertex_cache = false;
   _tex_txopz = false;
   _ctex_quality = "best";
 }
@@ -310,6 +370,36 @@ run() {
     }
   }
 
+  if (_has_simplify_ratio) {
+    SceneGraphReducer gr;
+    PN_stdfloat max_error = _has_simplify_error ? (PN_stdfloat)_simplify_error : -1;
+    PN_stdfloat error = gr.simplify(root, (PN_stdfloat)_simplify_ratio, max_error);
+    nout << "Simplified with an error of up to " << error << " units.\n";
+  }
+
+  if (_lod_levels > 1) {
+    // Move the model below a new LODNode, with simplified copies of it.
+    PT(PandaNode) source = new PandaNode(root->get_name());
+    source->steal_children(root);
+    PT(LODNode) lod = LODNode::make_simplified_lod
+      (root->get_name(), source, _lod_levels, (PN_stdfloat)_lod_ratio,
+       (PN_stdfloat)_lod_pixel_error);
+    root->add_child(lod);
+
+    for (int i = 0; i < lod->get_num_switches(); ++i) {
+      nout << "LOD level " << i << ": in " << lod->get_in(i)
+           << ", out " << lod->get_out(i) << "\n";
+    }
+  }
+
+  if (_optimize_vertex_cache) {
+    SceneGraphReducer gr;
+    PN_stdfloat orig_acmr = gr.calc_acmr(root);
+    gr.optimize_vertex_cache(root);
+    nout << "Vertex cache miss ratio (ACMR): " << orig_acmr << " before, "
+         << gr.calc_acmr(root) << " after.\n";
+  }
+
   if (_ls) {
     root->ls(nout, 0);
   }
@@ -355,6 +445,11 @@ handle_args(ProgramBase::Args &args) {
     _path_replace->_path_store = PS_absolute;
   }
 
+  if (_lod_ratio <= 0.0 || _lod_ratio >= 1.0) {
+    nout << "-lod-ratio must be between 0 and 1.\n";
+    return false;
+  }
+
   return EggToSomething::handle_args(args);
 }
 
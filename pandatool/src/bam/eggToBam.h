@@ -55,6 +55,14 @@ private:
   bool _has_egg_combine_geoms;
   int _egg_combine_geoms;
   bool _egg_suppress_hidden;
+  bool _has_simplify_ratio;
+  double _simplify_ratio;
+  bool _has_simplify_error;
+  double _simplify_error;
+  int _lod_levels;
+  double _lod_pixel_error;
+  double _lod_ratio;
+  bool _optimize_vertex_cache;
   bool _ls;
   bool _has_compression_quality;
   int _compression_quality;
@@ -0,0 +1,148 @@
+from panda3d.core import Character, CharacterJoint, PartGroup, PartBundle
+from panda3d.core import AnimBundle, AnimGroup, AnimChannelMatrixXfmTable
+from panda3d.core import PTA_float, CPTA_float, LMatrix4
+import pytest
+
+
+JOINT_NAMES = ("root", "child", "leaf")
+
+
+def make_character(flat_update):
+    char = Character("char")
+    bundle = char.get_bundle(0)
+    bundle.flat_update = flat_update
+
+    parent = PartGroup(bundle, "<skeleton>")
+    joints = []
+    for i, name in enumerate(JOINT_NAMES):
+        parent = CharacterJoint(char, bundle, parent, name,
+                                LMatrix4.translate_mat(0, i, 0))
+        joints.append(parent)
+
+    return char, bundle, joints
+
+
+def make_anim(offset):
+    anim = AnimBundle("char", 24, 4)
+    parent = AnimGroup(anim, "<skeleton>")
+    for i, name in enumerate(JOINT_NAMES):
+        parent = AnimChannelMatrixXfmTable(parent, name)
+        parent.set_table('h', CPTA_float(PTA_float([offset + i * 10 + f * 5.0 for f in range(4)])))
+        parent.set_table('y', CPTA_float(PTA_float([1.0 + offset * 0.1])))
+        if i == 1:
+            parent.set_table('i', CPTA_float(PTA_float([1.0, 1.5, 2.0, 2.5])))
+    return anim
+
+
+def net_transforms(joints):
+    result = []
+    for joint in joints:
+        mat = LMatrix4()
+        joint.get_net_transform(mat)
+        result.append(LMatrix4(mat))
+    return result
+
+
+def evaluate(flat_update, blend_type=None, frame_blend=False):
+    char, bundle, joints = make_character(flat_update)
+    if blend_type is not None:
+        bundle.blend_type = blend_type
+    bundle.frame_blend_flag = frame_blend
+
+    anim1 = bundle.bind_anim(make_anim(0))
+    assert anim1 is not None
+
+    results = []
+    if blend_type is None:
+        for frame in range(4):
+            anim1.pose(frame)
+            bundle.force_update()
+            results.append(net_transforms(joints))
+    else:
+        anim2 = bundle.bind_anim(make_anim(45))
+        assert anim2 is not None
+        bundle.anim_blend_flag = True
+        bundle.set_control_effect(anim1, 0.25)
+        bundle.set_control_effect(anim2, 0.75)
+        for frame in (0.0, 1.5, 3.25):
+            anim1.pose(frame)
+            anim2.pose(frame)
+            bundle.force_update()
+            results.append(net_transforms(joints))
+    return results
+
+
+def assert_same(a, b):
+    for frame_a, frame_b in zip(a, b):
+        for mat_a, mat_b in zip(frame_a, frame_b):
+            assert mat_a.almost_equal(mat_b, 1e-4)
+
+
+def test_flat_update_property():
+    char, bundle, joints = make_character(False)
+    assert not bundle.flat_update
+    bundle.flat_update = True
+    assert bundle.flat_update
+
+
+def test_flat_update_single_anim():
+    assert_same(evaluate(True), evaluate(False))
+
+
+@pytest.mark.parametrize("blend_type", [
+    PartBundle.BT_linear,
+    PartBundle.BT_componentwise,
+    PartBundle.BT_componentwise_quat,
+])
+@pytest.mark.parametrize("frame_blend", [False, True])
+def test_flat_update_blend(blend_type, frame_blend):
+    flat = evaluate(True, blend_type, frame_blend)
+    recursive = evaluate(False, blend_type, frame_blend)
+    assert_same(flat, recursive)
+
+
+def test_flat_update_frozen_joint():
+    results = []
+    for flat_update in (True, False):
+        char, bundle, joints = make_character(flat_update)
+        control = bundle.bind_anim(make_anim(0))
+        bundle.freeze_joint("child", (1, 2, 3), (10, 0, 0), (1, 1, 1))
+        control.pose(2)
+        bundle.force_update()
+        results.append([net_transforms(joints)])
+    assert_same(results[0], results[1])
+
+
+def test_flat_update_replaced_table():
+    results = []
+    for flat_update in (True, False):
+        char, bundle, joints = make_character(flat_update)
+        anim = make_anim(0)
+        control = bundle.bind_anim(anim)
+        control.pose(1)
+        bundle.force_update()
+
+        # Replacing a table must be noticed, even though nothing else about
+        # the animation has changed.
+        anim.find_child("child").set_table('h', CPTA_float(PTA_float([90.0, 80.0, 70.0, 60.0])))
+        bundle.force_update()
+        results.append([net_transforms(joints)])
+    assert_same(results[0], results[1])
+
+
+def test_flat_update_same_frame():
+    from panda3d.core import ClockObject
+    clock = ClockObject.get_global_clock()
+
+    results = []
+    for flat_update in (True, False):
+        char, bundle, joints = make_character(flat_update)
+        control = bundle.bind_anim(make_anim(0))
+        frames = []
+        for frame in (2, 2, 3, 3, 1):
+            control.pose(frame)
+            clock.tick()
+            bundle.update()
+            frames.append(net_transforms(joints))
+        results.append(frames)
+    assert_same(results[0], results[1])
@@ -0,0 +1,114 @@
+from panda3d.core import CollisionNode, NodePath, GeomNode
+from panda3d.core import CollisionTraverser, CollisionHandlerQueue
+from panda3d.core import CollisionPolygon, CollisionRay, CollisionSphere
+from panda3d.core import Geom, GeomTriangles, GeomVertexData, GeomVertexFormat
+from panda3d.core import GeomVertexWriter, Point3
+
+
+GRID_SIZE = 16
+
+
+def make_grid_node():
+    # A single CollisionNode holding a flat grid of unit quads.
+    node = CollisionNode("grid")
+    for y in range(GRID_SIZE):
+        for x in range(GRID_SIZE):
+            node.add_solid(CollisionPolygon(
+                Point3(x, y, 0), Point3(x + 1, y, 0),
+                Point3(x + 1, y + 1, 0), Point3(x, y + 1, 0)))
+    return node
+
+
+def make_grid_geom_node():
+    vdata = GeomVertexData("grid", GeomVertexFormat.get_v3(), Geom.UH_static)
+    writer = GeomVertexWriter(vdata, "vertex")
+    tris = GeomTriangles(Geom.UH_static)
+    for y in range(GRID_SIZE):
+        for x in range(GRID_SIZE):
+            i = vdata.get_num_rows()
+            writer.add_data3(x, y, 0)
+            writer.add_data3(x + 1, y, 0)
+            writer.add_data3(x + 1, y + 1, 0)
+            writer.add_data3(x, y + 1, 0)
+            tris.add_vertices(i, i + 1, i + 2)
+            tris.add_vertices(i, i + 2, i + 3)
+    geom = Geom(vdata)
+    geom.add_primitive(tris)
+    node = GeomNode("grid")
+    node.add_geom(geom)
+    return node
+
+
+def collide(into_node, solid_from):
+    root = NodePath("root")
+    np_into = root.attach_new_node(into_node)
+
+    node_from = CollisionNode("from")
+    node_from.add_solid(solid_from)
+    if into_node.is_geom_node():
+        node_from.set_from_collide_mask(GeomNode.get_default_collide_mask())
+    np_from = root.attach_new_node(node_from)
+
+    trav = CollisionTraverser()
+    queue = CollisionHandlerQueue()
+    trav.add_collider(np_from, queue)
+    trav.traverse(root)
+    queue.sort_entries()
+    return queue.get_entries()
+
+
+def test_bvh_ray_into_many_polygons():
+    node = make_grid_node()
+
+    for x, y in ((0.5, 0.5), (3.25, 7.75), (15.5, 15.5)):
+        entries = collide(node, CollisionRay(x, y, 10, 0, 0, -1))
+        assert len(entries) == 1
+
+        index = int(y) * GRID_SIZE + int(x)
+        assert entries[0].get_into() == node.get_solid(index)
+        assert entries[0].get_surface_point(entries[0].get_into_node_path()).almost_equal(Point3(x, y, 0))
+
+    # Outside the grid.
+    assert len(collide(node, CollisionRay(-5, -5, 10, 0, 0, -1))) == 0
+
+
+def test_bvh_sphere_into_many_polygons():
+    node = make_grid_node()
+
+    # A sphere touching the corner shared by four quads.
+    entries = collide(node, CollisionSphere(4, 4, 0.1, 0.25))
+    assert len(entries) == 4
+
+    # A sphere hovering above the grid touches nothing.
+    assert len(collide(node, CollisionSphere(4, 4, 2, 0.25))) == 0
+
+
+def test_bvh_rebuilt_on_modification():
+    node = make_grid_node()
+    ray = CollisionRay(5.5, 5.5, 10, 0, 0, -1)
+    assert len(collide(node, ray)) == 1
+
+    # Move the polygon under the ray far away.
+    index = 5 * GRID_SIZE + 5
+    node.set_solid(index, CollisionPolygon(
+        Point3(100, 100, 0), Point3(101, 100, 0),
+        Point3(101, 101, 0), Point3(100, 101, 0)))
+    assert len(collide(node, ray)) == 0
+
+    # And add a new one that the ray does hit.
+    solid = CollisionPolygon(
+        Point3(5, 5, 1), Point3(6, 5, 1), Point3(6, 6, 1), Point3(5, 6, 1))
+    node.add_solid(solid)
+    entries = collide(node, ray)
+    assert len(entries) == 1
+    assert entries[0].get_into() == solid
+
+
+def test_bvh_ray_into_geom():
+    node = make_grid_geom_node()
+
+    entries = collide(node, CollisionRay(2.75, 9.25, 10, 0, 0, -1))
+    assert len(entries) == 1
+    assert entries[0].get_surface_point(entries[0].get_into_node_path()).almost_equal(Point3(2.75, 9.25, 0))
+
+    assert len(collide(node, CollisionRay(-5, -5, 10, 0, 0, -1))) == 0
@@ -0,0 +1,55 @@
+from panda3d.core import CollisionNode, NodePath
+from panda3d.core import CollisionTraverser, CollisionHandlerQueue
+from panda3d.core import CollisionPolygon, CollisionRay, CollisionSphere
+from panda3d.core import Point3
+
+
+def make_scene():
+    root = NodePath("root")
+
+    floor = CollisionNode("floor")
+    floor.add_solid(CollisionPolygon(
+        Point3(0, 0, 0), Point3(20, 0, 0), Point3(20, 20, 0), Point3(0, 20, 0)))
+    root.attach_new_node(floor)
+
+    ball = CollisionNode("ball")
+    ball.add_solid(CollisionSphere(10, 10, 3, 2))
+    root.attach_new_node(ball)
+
+    return root
+
+
+def traverse(num_threads):
+    root = make_scene()
+    trav = CollisionTraverser()
+    trav.num_threads = num_threads
+    queue = CollisionHandlerQueue()
+
+    # Enough colliders to make several passes, some with several solids.
+    for i in range(40):
+        node = CollisionNode("ray%d" % (i))
+        node.add_solid(CollisionRay(i * 0.5, 10, 10, 0, 0, -1))
+        if i % 3 == 0:
+            node.add_solid(CollisionRay(i * 0.5, 10.5, 10, 0, 0, -1))
+        trav.add_collider(root.attach_new_node(node), queue)
+
+    trav.traverse(root)
+    return [(entry.get_from_node().name, entry.get_into_node().name,
+             tuple(entry.get_surface_point(root)))
+            for entry in queue.entries]
+
+
+def test_traverser_num_threads():
+    trav = CollisionTraverser()
+    trav.num_threads = 2
+    assert trav.num_threads == 2
+    trav.num_threads = 0
+    assert trav.num_threads == 0
+
+
+def test_traverser_parallel_matches_serial():
+    serial = traverse(0)
+    assert len(serial) > 40
+
+    # The entries should be found in the same order, not just the same ones.
+    assert traverse(2) == serial
@@ -0,0 +1,150 @@
+from panda3d import core
+import random
+import pytest
+
+
+# Enough objects to use the radix sort, and few enough to use the comparison
+# sort that it falls back to for small bins.
+NUM_OBJECTS = [200, 20]
+
+
+@pytest.fixture(scope='module')
+def tiny_pipe():
+    pipe = core.GraphicsPipeSelection.get_global_ptr().make_pipe(
+        "TinyOffscreenGraphicsPipe", "p3tinydisplay")
+    if pipe is None or not pipe.is_valid():
+        pytest.skip("tinydisplay is not available")
+    return pipe
+
+
+@pytest.fixture(scope='module')
+def front_to_back_bin():
+    mgr = core.CullBinManager.get_global_ptr()
+    if mgr.find_bin("test_front_to_back") < 0:
+        mgr.add_bin("test_front_to_back", core.CullBinManager.BT_front_to_back, 45)
+    return "test_front_to_back"
+
+
+def add_object(root, index, depth=0.0, bin_name="fixed", draw_order=0):
+    # The depth of the object is taken from the bounds of its geom, which we
+    # set explicitly, so that any value at all may be tested.  The index is
+    # encoded in the x position, which doesn't affect the depth.
+    node = core.CardMaker("card").generate()
+    node.modify_geom(0).set_bounds(core.BoundingSphere((0, depth, 0), 0.1))
+    node.set_bounds(core.OmniBoundingVolume())
+    np = root.attach_new_node(node)
+    np.set_x(index * 0.01)
+    np.set_bin(bin_name, draw_order)
+
+
+def cull_scene(pipe, root):
+    """ Culls the scene with a camera at the origin, and returns the indices
+    of the objects in each bin, in the order in which they will be drawn. """
+
+    engine = core.GraphicsEngine()
+    try:
+        fbprops = core.FrameBufferProperties()
+        fbprops.rgb_color = True
+        fbprops.depth_bits = 16
+
+        buffer = engine.make_output(
+            pipe,
+            'buffer',
+            0,
+            fbprops,
+            core.WindowProperties.size(16, 16),
+            core.GraphicsPipe.BF_refuse_window,
+        )
+        engine.open_windows()
+
+        if buffer is None:
+            pytest.skip("GraphicsPipe cannot make offscreen buffers")
+
+        # Don't cull anything away, whatever its depth.
+        camera = core.Camera("camera", core.PerspectiveLens())
+        camera.set_cull_bounds(core.OmniBoundingVolume())
+        camera_np = root.attach_new_node(camera)
+
+        region = buffer.make_display_region()
+        region.camera = camera_np
+
+        engine.render_frame()
+
+        result = {}
+        for bin_node in region.make_cull_result_graph().children:
+            result[bin_node.name] = [
+                int(round(object_node.get_transform().get_pos()[0] * 100))
+                for object_node in bin_node.children]
+        return result
+    finally:
+        engine.remove_all_windows()
+
+
+@pytest.mark.parametrize("num_objects", NUM_OBJECTS)
+def test_cull_bin_fixed(tiny_pipe, num_objects):
+    rng = random.Random(num_objects)
+    root = core.NodePath("root")
+
+    # Many equal draw orders, including negative ones.
+    draw_orders = [rng.randrange(-10, 10) for i in range(num_objects)]
+    draw_orders[0] = -2 ** 31
+    draw_orders[1] = 2 ** 31 - 1
+    for i, draw_order in enumerate(draw_orders):
+        add_object(root, i, draw_order=draw_order)
+
+    # Python's sort is stable, like the bin's.
+    expected = sorted(range(num_objects), key=lambda i: draw_orders[i])
+    assert cull_scene(tiny_pipe, root)["fixed"] == expected
+
+
+@pytest.mark.parametrize("num_objects", NUM_OBJECTS)
+def test_cull_bin_back_to_front(tiny_pipe, num_objects):
+    rng = random.Random(num_objects)
+    root = core.NodePath("root")
+
+    # Objects behind the camera have a negative depth.  Many of the depths
+    # are repeated, to check that the objects with the same depth stay in the
+    # order in which they were added.
+    depths = [rng.choice((0.0, 1.0, -1.0, 1e30, -1e30))
+              if rng.random() < 0.25 else rng.randrange(-10000, 10000) / 100.0
+              for i in range(num_objects)]
+    for i, depth in enumerate(depths):
+        add_object(root, i, depth=depth, bin_name="transparent")
+
+    expected = sorted(range(num_objects), key=lambda i: -depths[i])
+    assert cull_scene(tiny_pipe, root)["transparent"] == expected
+
+
+@pytest.mark.parametrize("num_objects", NUM_OBJECTS)
+def test_cull_bin_front_to_back(tiny_pipe, front_to_back_bin, num_objects):
+    rng = random.Random(num_objects)
+    root = core.NodePath("root")
+
+    depths = [rng.choice((0.0, 1.0, -1.0))
+              if rng.random() < 0.25 else rng.randrange(-10000, 10000) / 100.0
+              for i in range(num_objects)]
+    for i, depth in enumerate(depths):
+        add_object(root, i, depth=depth, bin_name=front_to_back_bin)
+
+    expected = sorted(range(num_objects), key=lambda i: depths[i])
+    assert cull_scene(tiny_pipe, root)[front_to_back_bin] == expected
+
+
+@pytest.mark.parametrize("num_objects", NUM_OBJECTS)
+def test_cull_bin_nan_depth(tiny_pipe, front_to_back_bin, num_objects):
+    rng = random.Random(num_objects)
+    root = core.NodePath("root")
+
+    nan = float('nan')
+    depths = [nan if i % 7 == 3 else rng.randrange(-10000, 10000) / 100.0
+              for i in range(num_objects)]
+    for i, depth in enumerate(depths):
+        add_object(root, i, depth=depth, bin_name=front_to_back_bin)
+
+    result = cull_scene(tiny_pipe, root)[front_to_back_bin]
+
+    # None of the objects may be lost, and the objects with a NaN depth
+    # must not disturb the order of the others.
+    assert sorted(result) == list(range(num_objects))
+    ordered = [i for i in result if depths[i] == depths[i]]
+    assert ordered == sorted(ordered, key=lambda i: depths[i])
@@ -0,0 +1,90 @@
+from panda3d import core
+import random
+import pytest
+
+
+def make_scene():
+    rng = random.Random(2)
+    root = core.NodePath("root")
+    parent = root.attach_new_node("parent")
+
+    # Enough children to be divided among the worker threads.  Overlapping
+    # blended cards in the unsorted and fixed bins show up any difference in
+    # the order in which they are drawn.
+    maker = core.CardMaker("card")
+    for i in range(200):
+        x = rng.uniform(-1, 1)
+        z = rng.uniform(-1, 1)
+        maker.set_frame(x - 0.3, x + 0.3, z - 0.3, z + 0.3)
+        maker.set_color(rng.random(), rng.random(), rng.random(), rng.uniform(0.3, 0.8))
+        card = parent.attach_new_node(maker.generate())
+        card.set_y(rng.uniform(2, 8))
+        card.set_transparency(core.TransparencyAttrib.M_alpha)
+        card.set_depth_write(False)
+        if i % 3 == 0:
+            card.set_bin("fixed", rng.randrange(10))
+        else:
+            card.set_bin("unsorted", 0)
+
+    return root
+
+
+def render_scene(cull_num_threads):
+    pipe = core.GraphicsPipeSelection.get_global_ptr().make_pipe(
+        "TinyOffscreenGraphicsPipe", "p3tinydisplay")
+    if pipe is None or not pipe.is_valid():
+        pytest.skip("tinydisplay is not available")
+
+    model = core.GraphicsThreadingModel("")
+    model.set_cull_num_threads(cull_num_threads)
+
+    engine = core.GraphicsEngine()
+    engine.set_threading_model(model)
+
+    try:
+        fbprops = core.FrameBufferProperties()
+        fbprops.rgb_color = True
+        fbprops.depth_bits = 16
+
+        buffer = engine.make_output(
+            pipe,
+            'buffer',
+            0,
+            fbprops,
+            core.WindowProperties.size(64, 64),
+            core.GraphicsPipe.BF_refuse_window,
+        )
+        engine.open_windows()
+
+        if buffer is None:
+            pytest.skip("GraphicsPipe cannot make offscreen buffers")
+
+        tex = core.Texture()
+        buffer.add_render_texture(tex, core.GraphicsOutput.RTM_copy_ram)
+        buffer.set_clear_color((0, 0, 0, 1))
+
+        lens = core.OrthographicLens()
+        lens.set_film_size(2, 2)
+        lens.set_near_far(0.5, 10)
+
+        root = make_scene()
+        camera = root.attach_new_node(core.Camera("camera", lens))
+
+        region = buffer.make_display_region()
+        region.camera = camera
+
+        engine.render_frame()
+        engine.render_frame()
+        return tex.get_ram_image_as("RGBA").get_data()
+    finally:
+        engine.remove_all_windows()
+
+
+def test_cull_parallel_matches_serial():
+    if not core.Thread.is_true_threads():
+        pytest.skip("requires true threads")
+
+    serial = render_scene(0)
+    assert len(set(serial)) > 16
+
+    assert render_scene(3) == serial
@@ -0,0 +1,86 @@
+import pytest
+
+from panda3d import core
+
+
+def test_shader_generator_prewarm(gsg, tmpdir):
+    """Test recording generated states and prewarming another generator"""
+    if not hasattr(core.ShaderGenerator, 'prewarm'):
+        pytest.skip("ShaderGenerator requires Cg support")
+
+    state = core.RenderState.make(
+        core.ColorAttrib.make_flat((1, 0, 0, 1)),
+        core.ShaderAttrib.make().set_shader_auto())
+    anim = core.GeomVertexAnimationSpec()
+
+    generator = core.ShaderGenerator(gsg)
+    generator.record_states = True
+    attr = generator.synthesize_shader(state, anim)
+    assert attr is not None
+    assert generator.get_num_recorded_states() == 1
+
+    # Asking again for the same state does not record it twice.
+    assert generator.synthesize_shader(state, anim) == attr
+    assert generator.get_num_recorded_states() == 1
+
+    path = core.Filename.from_os_specific(str(tmpdir.join('states.psk')))
+    assert generator.write_recorded_states(path)
+
+    generator2 = core.ShaderGenerator(gsg)
+    assert generator2.prewarm(path) == 1
+
+    # The state is now already known, so nothing new is made.
+    assert generator2.prewarm(path) == 0
+    attr2 = generator2.synthesize_shader(state, anim)
+    assert attr2 is not None
+    assert attr2.get_shader() is not None
+
+    generator.clear_recorded_states()
+    assert generator.get_num_recorded_states() == 0
+
+
+def test_shader_generator_cache(gsg, tmpdir):
+    """Test that a generated shader is loaded from the model cache"""
+    if not hasattr(core.ShaderGenerator, 'prewarm'):
+        pytest.skip("ShaderGenerator requires Cg support")
+
+    cache = core.BamCache.get_global_ptr()
+    old_root = cache.root
+    old_active = cache.active
+    cache.root = core.Filename.from_os_specific(str(tmpdir))
+    cache.active = True
+
+    try:
+        state = core.RenderState.make(
+            core.ColorAttrib.make_flat((0, 1, 0, 1)),
+            core.ShaderAttrib.make().set_shader_auto())
+        anim = core.GeomVertexAnimationSpec()
+
+        generator = core.ShaderGenerator(gsg)
+        text = generator.synthesize_shader(state, anim).get_shader().get_text()
+        assert text
+
+        # The state isn't written into the source that is cached, since other
+        # states may share it.
+        assert "Generated shader for render state" not in text
+
+        # Find the record in the cache, and mark the source in it, so that we
+        # can tell whether the next generator takes it from there.
+        out = core.StringStream()
+        cache.list_index(out)
+        names = [word for word in out.data.decode().split()
+                 if word.startswith("/$shader-generator/")]
+        assert len(names) == 1
+        record = cache.lookup(core.Filename(names[0]), "sho")
+        assert record is not None
+        assert record.has_data()
+        marked = text + "// Loaded from the cache\n"
+        record.set_data(core.Shader.make(marked, core.Shader.SL_Cg))
+        assert cache.store(record)
+
+        generator2 = core.ShaderGenerator(gsg)
+        attr2 = generator2.synthesize_shader(state, anim)
+        assert attr2.get_shader().get_text() == marked
+    finally:
+        cache.active = old_active
+        cache.root = old_root
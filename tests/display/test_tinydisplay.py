@@ -0,0 +1,179 @@
+from panda3d import core
+import random
+import pytest
+
+
+def make_triangles(num_triangles):
+    rng = random.Random(1)
+
+    vdata = core.GeomVertexData("triangles", core.GeomVertexFormat.get_v3c4(), core.Geom.UH_static)
+    vertex = core.GeomVertexWriter(vdata, "vertex")
+    color = core.GeomVertexWriter(vdata, "color")
+    tris = core.GeomTriangles(core.Geom.UH_static)
+
+    for i in range(num_triangles):
+        for j in range(3):
+            vertex.add_data3(rng.uniform(-1.2, 1.2), rng.uniform(1, 9), rng.uniform(-1.2, 1.2))
+            color.add_data4(rng.random(), rng.random(), rng.random(), rng.uniform(0.3, 1))
+        tris.add_next_vertices(3)
+
+    geom = core.Geom(vdata)
+    geom.add_primitive(tris)
+    node = core.GeomNode("triangles")
+    node.add_geom(geom)
+    return node
+
+
+def make_lit_triangles(num_triangles, seed):
+    rng = random.Random(seed)
+
+    vdata = core.GeomVertexData("lit", core.GeomVertexFormat.get_v3n3(), core.Geom.UH_static)
+    vertex = core.GeomVertexWriter(vdata, "vertex")
+    normal = core.GeomVertexWriter(vdata, "normal")
+    tris = core.GeomTriangles(core.Geom.UH_static)
+
+    for i in range(num_triangles):
+        for j in range(3):
+            vertex.add_data3(rng.uniform(-1.2, 1.2), rng.uniform(2, 9), rng.uniform(-1.2, 1.2))
+            n = core.LVector3(rng.uniform(-1, 1), rng.uniform(-1, 0), rng.uniform(-1, 1))
+            normal.add_data3(n.normalized() if n.length() > 0.01 else core.LVector3(0, -1, 0))
+        tris.add_next_vertices(3)
+
+    geom = core.Geom(vdata)
+    geom.add_primitive(tris)
+    node = core.GeomNode("lit")
+    node.add_geom(geom)
+    return node
+
+
+def render_scene(root, lens, config={}):
+    pipe = core.GraphicsPipeSelection.get_global_ptr().make_pipe(
+        "TinyOffscreenGraphicsPipe", "p3tinydisplay")
+    if pipe is None or not pipe.is_valid():
+        pytest.skip("tinydisplay is not available")
+
+    # Some of these are read when the GSG is created.
+    vars = []
+    for name, value in config.items():
+        var = core.ConfigVariable(name)
+        var.set_string_value(str(value).lower())
+        vars.append(var)
+
+    engine = core.GraphicsEngine()
+    engine.set_threading_model("")
+
+    try:
+        fbprops = core.FrameBufferProperties()
+        fbprops.rgb_color = True
+        fbprops.depth_bits = 16
+
+        buffer = engine.make_output(
+            pipe,
+            'buffer',
+            0,
+            fbprops,
+            core.WindowProperties.size(64, 64),
+            core.GraphicsPipe.BF_refuse_window,
+        )
+        engine.open_windows()
+
+        if buffer is None:
+            pytest.skip("GraphicsPipe cannot make offscreen buffers")
+
+        tex = core.Texture()
+        buffer.add_render_texture(tex, core.GraphicsOutput.RTM_copy_ram)
+        buffer.set_clear_color((0, 0, 0, 1))
+
+        camera = root.attach_new_node(core.Camera("camera", lens))
+
+        region = buffer.make_display_region()
+        region.camera = camera
+
+        engine.render_frame()
+        engine.render_frame()
+        camera.remove_node()
+        return tex.get_ram_image_as("RGBA").get_data()
+    finally:
+        engine.remove_all_windows()
+        for var in vars:
+            var.clear_local_value()
+
+
+def render_triangles(num_threads):
+    lens = core.OrthographicLens()
+    lens.set_film_size(2, 2)
+    lens.set_near_far(0.5, 10)
+
+    root = core.NodePath("root")
+    root.set_transparency(core.TransparencyAttrib.M_alpha)
+    root.attach_new_node(make_triangles(300))
+
+    return render_scene(root, lens, {"td-num-threads": num_threads})
+
+
+def test_tinydisplay_binned_matches_serial():
+    if not core.Thread.is_true_threads():
+        pytest.skip("requires true threads")
+
+    serial = render_triangles(0)
+    assert len(set(serial)) > 16
+
+    assert render_triangles(2) == serial
+
+
+def make_lit_scene():
+    root = core.NodePath("root")
+
+    # Geoms with 3, 6, 9 ... 24 vertices, so that every remainder modulo 4 is
+    # left over for the scalar code, and one large one.
+    for num_triangles in list(range(1, 9)) + [200]:
+        root.attach_new_node(make_lit_triangles(num_triangles, num_triangles))
+
+    # A scale makes the normals need rescaling.
+    scaled = root.attach_new_node(make_lit_triangles(37, 100))
+    scaled.set_scale(1.3)
+
+    # An unlit geom takes the path without lighting.
+    unlit = root.attach_new_node(make_triangles(50))
+    unlit.set_light_off(1)
+
+    material = core.Material()
+    material.set_diffuse((0.8, 0.7, 0.6, 1))
+    material.set_ambient((0.2, 0.3, 0.4, 1))
+    material.set_specular((1, 1, 1, 1))
+    material.set_shininess(20)
+    root.set_material(material)
+
+    dlight = root.attach_new_node(core.DirectionalLight("dlight"))
+    dlight.look_at(1, 2, -3)
+    root.set_light(dlight)
+
+    plight = core.PointLight("plight")
+    plight.set_color((0.6, 0.6, 1, 1))
+    plight.set_attenuation((1, 0.1, 0.01))
+    plight_np = root.attach_new_node(plight)
+    plight_np.set_pos(-1, 1, 2)
+    root.set_light(plight_np)
+
+    alight = root.attach_new_node(core.AmbientLight("alight"))
+    alight.node().set_color((0.1, 0.1, 0.1, 1))
+    root.set_light(alight)
+
+    return root
+
+
+def test_tinydisplay_vectorized_matches_scalar():
+    lens = core.PerspectiveLens()
+    lens.set_fov(60)
+    lens.set_near_far(0.5, 20)
+
+    root = make_lit_scene()
+    scalar = render_scene(root, lens, {"td-vectorize-vertices": False})
+    assert len(set(scalar)) > 16
+
+    vectorized = render_scene(root, lens, {"td-vectorize-vertices": True})
+    assert len(vectorized) == len(scalar)
+
+    # The vectorized code is meant to give identical results, but allow for a
+    # small difference in rounding.
+    assert max(abs(a - b) for a, b in zip(scalar, vectorized)) <= 2
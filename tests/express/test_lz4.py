@@ -0,0 +1,78 @@
+from panda3d import core
+import pytest
+
+
+pytestmark = pytest.mark.skipif(not hasattr(core, 'OLZ4CompressStream'),
+                                reason="requires the LZ4 library")
+
+
+# Written by the lz4 command-line tool with -9, with the content checksum.
+LZ4_FRAME = b'\x04"M\x18d@\xa7\r\x00\x00\x00?abc\x03\x00\x03Pbcabc\x00\x00\x00\x00\xc1\xab\x87='
+
+# The same, with -BX to add a block checksum.
+LZ4_FRAME_BLOCK_CHECKSUM = b'\x04"M\x18t@\xbd\r\x00\x00\x00?abc\x03\x00\x03Pbcabc\xc1\xaf)\xcc\x00\x00\x00\x00\xc1\xab\x87='
+
+
+def compress(data, level):
+    out = core.StringStream()
+    compress = core.OLZ4CompressStream(out, False, level)
+    compress.write(data)
+    compress.close()
+    return out.data
+
+
+def decompress(data):
+    source = core.StringStream(data)
+    decompress = core.ILZ4DecompressStream(source, False)
+    return decompress.read()
+
+
+def test_lz4_decompress_reference():
+    assert decompress(LZ4_FRAME) == b'abc' * 10
+
+
+def test_lz4_decompress_block_checksum():
+    assert decompress(LZ4_FRAME_BLOCK_CHECKSUM) == b'abc' * 10
+
+    # A block with a bad checksum is not returned.
+    corrupt = bytearray(LZ4_FRAME_BLOCK_CHECKSUM)
+    corrupt[24] ^= 1
+    assert decompress(bytes(corrupt)) == b''
+
+
+def test_lz4_round_trip():
+    data = b''.join(b'%d bottles of beer on the wall\n' % i for i in range(5000))
+    data += bytes(range(256)) * 300
+
+    for level in (1, 9):
+        compressed = compress(data, level)
+        assert compressed.startswith(b'\x04"M\x18')
+        assert compressed[4] & 0x04  # has a content checksum
+        assert len(compressed) < len(data)
+        assert decompress(compressed) == data
+
+
+def test_lz4_round_trip_empty():
+    assert decompress(compress(b'', 1)) == b''
+
+
+def test_multifile_lz4(tmp_path):
+    filename = core.Filename.from_os_specific(str(tmp_path / "test.mf"))
+    data = b'The quick brown fox jumps over the lazy dog.\n' * 1000
+
+    m = core.Multifile()
+    assert m.open_write(filename)
+    m.set_compression_codec(core.CC_lz4)
+    source = core.StringStream(data)
+    m.add_subfile("test.txt", source, 6)
+    m.flush()
+    m.close()
+
+    m = core.Multifile()
+    assert m.open_read(filename)
+    assert m.get_num_subfiles() == 1
+    assert m.is_subfile_compressed(0)
+    assert m.get_subfile_compression_codec(0) == core.CC_lz4
+    assert m.get_subfile_internal_length(0) < len(data)
+    assert m.read_subfile(0) == data
+    m.close()
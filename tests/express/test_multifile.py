@@ -1,4 +1,6 @@
-from panda3d.core import Multifile, StringStream, IStreamWrapper
+from panda3d.core import Multifile, StringStream, IStreamWrapper, Filename
+from panda3d.core import CC_zstd
+import struct
 
 
 def test_multifile_read_empty():
@@ -10,3 +12,40 @@ def test_multifile_read_empty():
     assert m.is_read_valid()
     assert m.get_num_subfiles() == 0
     m.close()
+
+
+def read_version(path):
+    with open(path, 'rb') as f:
+        header = f.read(10)
+    assert header[:6] == b'pmf\x00\n\r'
+    return struct.unpack('<hh', header[6:10])
+
+
+def test_multifile_version(tmp_path):
+    path = tmp_path / "test.mf"
+    filename = Filename.from_os_specific(str(path))
+    data = b'The quick brown fox jumps over the lazy dog.\n' * 100
+
+    # Without any LZ4 or zstd subfiles, older readers can still read it.
+    m = Multifile()
+    assert m.open_write(filename)
+    m.add_subfile("plain.txt", StringStream(data), 0)
+    assert m.flush()
+    m.close()
+    assert read_version(path) == (1, 1)
+
+    # Adding one bumps the version, so that older readers refuse the file
+    # rather than decoding it as zlib.
+    m = Multifile()
+    assert m.open_read_write(filename)
+    m.set_compression_codec(CC_zstd)
+    m.add_subfile("zstd.txt", StringStream(data), 6)
+    assert m.flush()
+    m.close()
+    assert read_version(path) == (1, 2)
+
+    m = Multifile()
+    assert m.open_read(filename)
+    assert m.read_subfile(m.find_subfile("plain.txt")) == data
+    assert m.read_subfile(m.find_subfile("zstd.txt")) == data
+    m.close()
@@ -0,0 +1,52 @@
+from panda3d import core
+import pytest
+
+
+@pytest.fixture
+def cache_time():
+    var = core.ConfigVariableDouble("vfs-lookup-cache-time")
+    old_value = var.value
+    yield var
+    var.value = old_value
+
+
+def make_vfs(tmp_path):
+    vfs = core.VirtualFileSystem()
+    assert vfs.mount(core.Filename.from_os_specific(str(tmp_path)), "/disk", 0)
+    assert vfs.mount(core.VirtualFileMountRamdisk(), "/ram", 0)
+    return vfs
+
+
+def test_vfs_lookup_cache_disabled(tmp_path, cache_time):
+    cache_time.value = 0
+    vfs = make_vfs(tmp_path)
+    assert not vfs.exists("/disk/file.txt")
+
+    # A file created behind the VFS's back is noticed right away.
+    (tmp_path / "file.txt").write_bytes(b"data")
+    assert vfs.exists("/disk/file.txt")
+
+
+def test_vfs_lookup_cache(tmp_path, cache_time):
+    cache_time.value = -1
+    vfs = make_vfs(tmp_path)
+
+    (tmp_path / "existing.txt").write_bytes(b"data")
+    assert vfs.exists("/disk/existing.txt")
+    assert not vfs.exists("/disk/file.txt")
+    assert not vfs.exists("/ram/file.txt")
+
+    # The cache doesn't know about a file created behind its back...
+    (tmp_path / "file.txt").write_bytes(b"data")
+    assert not vfs.exists("/disk/file.txt")
+
+    # ...but it does know about files created through the VFS.
+    assert vfs.write_file("/ram/file.txt", b"data", False)
+    assert vfs.exists("/ram/file.txt")
+    assert vfs.exists("/disk/file.txt")
+
+    # Mounting or unmounting also resets the cache.
+    (tmp_path / "other.txt").write_bytes(b"data")
+    assert not vfs.exists("/disk/other.txt")
+    vfs.mount(core.VirtualFileMountRamdisk(), "/ram2", 0)
+    assert vfs.exists("/disk/other.txt")
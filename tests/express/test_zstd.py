@@ -0,0 +1,73 @@
+from panda3d import core
+
+
+# Written by the zstd command-line tool with -19, with the content checksum.
+ZSTD_FRAME = b'(\xb5/\xfd\x04hU\x00\x00 abca\x01\x00\xda\x8e\x08WC\xdd\xc7'
+
+
+def compress(data, level):
+    out = core.StringStream()
+    compress = core.OZstdCompressStream(out, False, level)
+    compress.write(data)
+    compress.close()
+    return out.data
+
+
+def decompress(data):
+    source = core.StringStream(data)
+    decompress = core.IZstdDecompressStream(source, False)
+    return decompress.read()
+
+
+def test_zstd_decompress_reference():
+    assert decompress(ZSTD_FRAME) == b'abc' * 10
+
+
+def test_zstd_decompress_corrupt():
+    # Flipping a bit in the content checksum must be detected.
+    corrupt = ZSTD_FRAME[:-1] + bytes([ZSTD_FRAME[-1] ^ 1])
+    assert decompress(corrupt) != b'abc' * 10
+
+
+def test_zstd_round_trip():
+    data = b''.join(b'%d bottles of beer on the wall\n' % i for i in range(5000))
+    data += bytes(range(256)) * 300
+
+    for level in (1, 3, 19):
+        compressed = compress(data, level)
+        assert compressed.startswith(b'(\xb5/\xfd')
+        assert len(compressed) < len(data)
+        assert decompress(compressed) == data
+
+
+def test_zstd_round_trip_empty():
+    assert decompress(compress(b'', 3)) == b''
+
+
+def test_zstd_compress_string():
+    data = b'The quick brown fox jumps over the lazy dog.\n' * 1000
+    compressed = core.compress_string(data, 3, core.CC_zstd)
+    assert len(compressed) < len(data)
+    assert core.decompress_string(compressed) == data
+
+
+def test_multifile_zstd(tmp_path):
+    filename = core.Filename.from_os_specific(str(tmp_path / "test.mf"))
+    data = b'The quick brown fox jumps over the lazy dog.\n' * 1000
+
+    m = core.Multifile()
+    assert m.open_write(filename)
+    m.set_compression_codec(core.CC_zstd)
+    source = core.StringStream(data)
+    m.add_subfile("test.txt", source, 6)
+    m.flush()
+    m.close()
+
+    m = core.Multifile()
+    assert m.open_read(filename)
+    assert m.get_num_subfiles() == 1
+    assert m.is_subfile_compressed(0)
+    assert m.get_subfile_compression_codec(0) == core.CC_zstd
+    assert m.get_subfile_internal_length(0) < len(data)
+    assert m.read_subfile(0) == data
+    m.close()
@@ -1,4 +1,5 @@
 from panda3d import core
+import math
 
 empty_format = core.GeomVertexFormat.get_empty()
 
@@ -82,3 +83,120 @@ def test_geom_calc_box_bounds():
     assert isinstance(bounds, core.BoundingBox)
     assert bounds.get_min() == (1, 1, 1)
     assert bounds.get_max() == (1, 1, 2)
+
+
+def make_grid_geom(size, seam=None):
+    # Makes a flat size x size grid in the XY plane.  If seam is given, the
+    # vertices on either side of that column get different texture
+    # coordinates, as though there were a UV seam there.
+    vertex_data = core.GeomVertexData("", core.GeomVertexFormat.get_v3t2(), core.GeomEnums.UH_static)
+    vertex = core.GeomVertexWriter(vertex_data, "vertex")
+    texcoord = core.GeomVertexWriter(vertex_data, "texcoord")
+
+    rows = {}
+    for y in range(size + 1):
+        for x in range(size + 1):
+            for side in (0, 1):
+                if seam is None and side == 1:
+                    continue
+                if seam is not None and ((side == 0 and x > seam) or (side == 1 and x < seam)):
+                    continue
+                rows[(x, y, side)] = vertex_data.get_num_rows()
+                vertex.add_data3(x, y, 0)
+                texcoord.add_data2(side, 0)
+
+    prim = core.GeomTriangles(core.GeomEnums.UH_static)
+    for y in range(size):
+        for x in range(size):
+            side = 0 if seam is None or x < seam else 1
+            v0 = rows[(x, y, side)]
+            v1 = rows[(x + 1, y, side)]
+            v2 = rows[(x, y + 1, side)]
+            v3 = rows[(x + 1, y + 1, side)]
+            prim.add_vertices(v0, v1, v2)
+            prim.add_vertices(v2, v1, v3)
+
+    geom = core.Geom(vertex_data)
+    geom.add_primitive(prim)
+    return geom
+
+
+def test_geom_simplify_flat():
+    geom = make_grid_geom(8)
+    assert geom.get_primitive(0).get_num_primitives() == 128
+
+    # A flat grid can be reduced to two triangles without any error.
+    error = geom.simplify_in_place(0.0, 0.001)
+    assert error == 0
+    assert geom.get_primitive(0).get_num_primitives() == 2
+
+    # The corners must be kept.
+    reader = core.GeomVertexReader(geom.get_vertex_data(), "vertex")
+    corners = set()
+    for v in geom.get_primitive(0).get_vertex_list():
+        reader.set_row(v)
+        corners.add(tuple(reader.get_data3()))
+    assert corners == {(0, 0, 0), (8, 0, 0), (0, 8, 0), (8, 8, 0)}
+
+
+def test_geom_simplify_seam():
+    geom = make_grid_geom(8, seam=4)
+    geom.simplify_in_place(0.0, 0.001)
+    prim = geom.get_primitive(0)
+    assert prim.get_num_primitives() == 4
+
+    # No triangle may straddle the seam.
+    reader = core.GeomVertexReader(geom.get_vertex_data(), "texcoord")
+    verts = prim.get_vertex_list()
+    for i in range(0, len(verts), 3):
+        sides = set()
+        for v in verts[i:i + 3]:
+            reader.set_row(v)
+            sides.add(reader.get_data2()[0])
+        assert len(sides) == 1
+
+
+def test_geom_simplify_ratio():
+    vertex_data = core.GeomVertexData("", core.GeomVertexFormat.get_v3(), core.GeomEnums.UH_static)
+    vertex = core.GeomVertexWriter(vertex_data, "vertex")
+    rings, segments = 16, 32
+    vertex.add_data3(0, 0, 1)
+    for r in range(1, rings):
+        theta = math.pi * r / rings
+        for s in range(segments):
+            phi = 2 * math.pi * s / segments
+            vertex.add_data3(math.sin(theta) * math.cos(phi),
+                             math.sin(theta) * math.sin(phi),
+                             math.cos(theta))
+    vertex.add_data3(0, 0, -1)
+
+    def ring(r, s):
+        if r == 0:
+            return 0
+        if r == rings:
+            return vertex_data.get_num_rows() - 1
+        return 1 + (r - 1) * segments + s % segments
+
+    prim = core.GeomTriangles(core.GeomEnums.UH_static)
+    for r in range(rings):
+        for s in range(segments):
+            if r > 0:
+                prim.add_vertices(ring(r, s), ring(r + 1, s), ring(r, s + 1))
+            if r < rings - 1:
+                prim.add_vertices(ring(r, s + 1), ring(r + 1, s), ring(r + 1, s + 1))
+
+    geom = core.Geom(vertex_data)
+    geom.add_primitive(prim)
+    num_tris = prim.get_num_primitives()
+
+    simple = geom.simplify(0.25)
+    simple_tris = simple.get_primitive(0).get_num_primitives()
+    assert simple_tris <= num_tris // 4
+    assert simple_tris > 0
+
+    # The original is untouched.
+    assert geom.get_primitive(0).get_num_primitives() == num_tris
+
+    # Limiting the error leaves more triangles.
+    limited = geom.simplify(0.25, 0.001)
+    assert limited.get_primitive(0).get_num_primitives() > simple_tris
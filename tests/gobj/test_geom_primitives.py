@@ -81,3 +81,54 @@ def test_geom_linestrips_adjacency():
         3, 4, 5, 6,
         4, 5, 6, 6,
     )
+
+
+def make_grid_triangles(size):
+    # Emits the triangles of a size x size grid in a scattered order, so that
+    # there is little vertex reuse between consecutive triangles.
+    prim = core.GeomTriangles(core.GeomEnums.UH_static)
+    quads = [(x, y) for y in range(size) for x in range(size)]
+    quads = quads[0::2] + quads[1::2]
+    for x, y in quads:
+        v0 = y * (size + 1) + x
+        v1 = v0 + 1
+        v2 = v0 + size + 1
+        v3 = v2 + 1
+        prim.add_vertices(v0, v1, v2)
+        prim.add_vertices(v2, v1, v3)
+    return prim
+
+
+def test_geom_triangles_optimize_vertex_cache():
+    prim = make_grid_triangles(16)
+    orig_acmr = prim.calc_acmr()
+    assert orig_acmr > 1.0
+
+    opt = prim.optimize_vertex_cache()
+    assert opt.get_num_primitives() == prim.get_num_primitives()
+    assert opt.calc_acmr() < orig_acmr
+    assert opt.calc_acmr() < 1.0
+
+    # The same triangles must still be present, with their winding intact.
+    def triangles(p):
+        verts = p.get_vertex_list()
+        result = set()
+        for i in range(0, len(verts), 3):
+            tri = tuple(verts[i:i + 3])
+            k = tri.index(min(tri))
+            result.add(tri[k:] + tri[:k])
+        return result
+
+    assert triangles(opt) == triangles(prim)
+
+
+def test_geom_triangles_optimize_vertex_cache_nonindexed():
+    prim = core.GeomTriangles(core.GeomEnums.UH_static)
+    prim.add_next_vertices(6)
+    assert not prim.is_indexed()
+    assert prim.calc_acmr() == 3.0
+
+    # Without vertex reuse, there is nothing to reorder.
+    opt = prim.optimize_vertex_cache()
+    assert not opt.is_indexed()
+    assert tuple(opt.get_vertex_list()) == tuple(range(6))
@@ -1,6 +1,7 @@
-from panda3d.core import Texture, PNMImage, LColor
+from panda3d.core import Texture, PNMImage, LColor, ConfigVariableBool
 from array import array
 import math
+import pytest
 
 
 def image_from_stored_pixel(component_type, format, data):
@@ -134,3 +135,70 @@ def test_texture_clear_half():
     assert col.y == -inf
     assert col.z == -inf
     assert math.isnan(col.w)
+
+
+def make_gradient_texture(x_size, y_size):
+    tex = Texture("gradient")
+    tex.setup_2d_texture(x_size, y_size, Texture.T_unsigned_byte, Texture.F_rgba)
+    data = array('B')
+    for y in range(y_size):
+        for x in range(x_size):
+            data.extend((x * 255 // x_size, y * 255 // y_size, 128, 255 - x * 255 // x_size))
+    tex.set_ram_image(data)
+    return tex
+
+
+@pytest.fixture
+def fast_dxt_encoder():
+    var = ConfigVariableBool("texture-fast-dxt-encoder")
+    var.value = True
+    yield
+    var.clear_local_value()
+
+
+def test_texture_compress_fastest(fast_dxt_encoder):
+    tex = make_gradient_texture(64, 32)
+    orig = bytes(memoryview(tex.get_ram_image()))
+
+    assert tex.compress_ram_image(Texture.CM_dxt5, Texture.QL_fastest)
+    assert tex.ram_image_compression == Texture.CM_dxt5
+    assert len(memoryview(tex.get_ram_image())) == 64 * 32
+
+    assert tex.uncompress_ram_image()
+    result = bytes(memoryview(tex.get_ram_image()))
+    assert len(result) == len(orig)
+    assert max(abs(a - b) for a, b in zip(orig, result)) <= 16
+
+
+def test_texture_compress_fastest_odd_size(fast_dxt_encoder):
+    tex = make_gradient_texture(13, 7)
+    assert tex.compress_ram_image(Texture.CM_dxt1, Texture.QL_fastest)
+    assert len(memoryview(tex.get_ram_image())) == 4 * 2 * 8
+
+    assert tex.uncompress_ram_image()
+    assert len(memoryview(tex.get_ram_image())) == 13 * 7 * 4
+
+
+def test_texture_compress_threads(fast_dxt_encoder):
+    from threading import Thread
+
+    expected = make_gradient_texture(128, 128)
+    assert expected.compress_ram_image(Texture.CM_dxt5, Texture.QL_fastest)
+
+    # The compression job runner is shared, so compressing from several
+    # threads at once must give the same result as compressing from one.
+    textures = [make_gradient_texture(128, 128) for i in range(4)]
+    results = [False] * len(textures)
+
+    def run_thread(i):
+        results[i] = textures[i].compress_ram_image(Texture.CM_dxt5, Texture.QL_fastest)
+
+    threads = [Thread(target=run_thread, args=(i, )) for i in range(len(textures))]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+
+    assert all(results)
+    for tex in textures:
+        assert memoryview(tex.get_ram_image()) == memoryview(expected.get_ram_image())
@@ -0,0 +1,123 @@
+from panda3d import core
+from array import array
+import pytest
+
+
+def make_texture():
+    tex = core.Texture("stream")
+    tex.setup_2d_texture(256, 256, core.Texture.T_unsigned_byte, core.Texture.F_rgba)
+    tex.set_ram_image(array('B', (i % 251 for i in range(256 * 256 * 4))))
+    tex.minfilter = core.SamplerState.FT_linear_mipmap_linear
+    tex.generate_ram_mipmap_images()
+    return tex
+
+
+def write_bam(tex, filename):
+    dout = core.DatagramOutputFile()
+    assert dout.open(filename)
+    assert dout.write_header("pbj\x00\n\r")
+
+    writer = core.BamWriter(dout)
+    writer.set_file_minor_ver(46)
+    writer.file_aligned_data = True
+    assert writer.init()
+
+    root = core.NodePath("root")
+    root.set_texture(tex)
+    assert writer.write_object(root.node())
+    writer.flush()
+    dout.close()
+
+
+def read_texture(filename):
+    bam = core.BamFile()
+    assert bam.open_read(filename)
+    node = bam.read_node()
+    assert bam.resolve()
+    bam.close()
+    return core.NodePath(node).get_texture()
+
+
+@pytest.fixture
+def streamed(tmp_path):
+    orig = make_texture()
+    filename = core.Filename.from_os_specific(str(tmp_path / "stream.bam"))
+    write_bam(orig, filename)
+
+    var = core.ConfigVariableBool("texture-streaming")
+    old_value = var.get_value()
+    var.set_value(True)
+    try:
+        tex = read_texture(filename)
+    finally:
+        var.set_value(old_value)
+
+    return orig, tex
+
+
+def mipmap(tex, n):
+    return bytes(memoryview(tex.get_ram_mipmap_image(n)))
+
+
+def test_texture_streaming_tail(streamed):
+    orig, tex = streamed
+
+    # Levels larger than texture-stream-tail-size are left in the file.
+    assert tex.has_streamed_mipmaps()
+    assert tex.stream_base_level == 2
+    assert not tex.has_ram_mipmap_image(0)
+    assert not tex.has_ram_mipmap_image(1)
+    assert mipmap(tex, 2) == mipmap(orig, 2)
+
+    # But the texture still counts as having a ram image.
+    assert tex.has_ram_image()
+    assert tex.has_all_ram_mipmap_images()
+
+
+def test_texture_streaming_levels(streamed):
+    orig, tex = streamed
+
+    assert tex.stream_mipmap_level()
+    assert tex.stream_base_level == 1
+    assert mipmap(tex, 1) == mipmap(orig, 1)
+
+    assert tex.stream_mipmap_level()
+    assert tex.stream_base_level == 0
+    assert mipmap(tex, 0) == mipmap(orig, 0)
+    assert not tex.stream_mipmap_level()
+
+    # The streamed levels can be evicted again, and streamed back in.
+    assert tex.evict_streamed_mipmaps(2) == 256 * 256 * 4 + 128 * 128 * 4
+    assert tex.stream_base_level == 2
+    assert tex.stream_mipmap_level()
+    assert mipmap(tex, 1) == mipmap(orig, 1)
+
+
+def test_texture_streaming_get_ram_image(streamed):
+    orig, tex = streamed
+
+    # Asking for the full image loads all the levels synchronously.
+    assert bytes(memoryview(tex.get_ram_image())) == mipmap(orig, 0)
+    assert tex.stream_base_level == 0
+    assert mipmap(tex, 1) == mipmap(orig, 1)
+
+
+def test_texture_streaming_modify(streamed):
+    orig, tex = streamed
+
+    # Replacing the image drops the sources in the file.
+    tex.set_ram_image(tex.get_ram_image())
+    assert not tex.has_streamed_mipmaps()
+    assert tex.stream_base_level == 0
+
+
+def test_texture_streaming_request(streamed):
+    orig, tex = streamed
+
+    assert tex.stream_priority == 0
+    assert tex.stream_wanted_level == -1
+
+    # A texture drawn at 100 pixels needs the 128x128 level.
+    tex.request_stream_screen_size(100)
+    assert tex.stream_wanted_level == 1
+    assert tex.stream_priority == 100
@@ -0,0 +1,88 @@
+from panda3d.core import GeomVertexData, GeomVertexFormat, GeomVertexArrayFormat
+from panda3d.core import GeomVertexAnimationSpec, GeomVertexReader, GeomVertexWriter
+from panda3d.core import TransformBlend, TransformBlendTable, UserVertexTransform
+from panda3d.core import InternalName, Geom, SparseArray, Thread
+from panda3d.core import ConfigVariableBool, LMatrix4, Point3, Vec3
+
+
+NUM_ROWS = 64
+
+
+def make_skinned_vdata(blend_type=Geom.NT_uint16):
+    array = GeomVertexArrayFormat()
+    array.add_column(InternalName.get_vertex(), 3, Geom.NT_float32, Geom.C_point)
+    array.add_column(InternalName.get_normal(), 3, Geom.NT_float32, Geom.C_normal)
+
+    blend_array = GeomVertexArrayFormat()
+    blend_array.add_column(InternalName.get_transform_blend(), 1,
+                           blend_type, Geom.C_index)
+
+    format = GeomVertexFormat()
+    format.add_array(array)
+    format.add_array(blend_array)
+    spec = GeomVertexAnimationSpec()
+    spec.set_panda()
+    format.set_animation(spec)
+    format = GeomVertexFormat.register_format(format)
+
+    # A rigid joint, a scaled joint, and a blend of the two.
+    joint1 = UserVertexTransform("joint1")
+    joint1.set_matrix(LMatrix4.translate_mat(1, 2, 3) * LMatrix4.rotate_mat(30, Vec3(0, 0, 1)))
+    joint2 = UserVertexTransform("joint2")
+    joint2.set_matrix(LMatrix4.scale_mat(1, 2, 3) * LMatrix4.translate_mat(-1, 0, 0))
+
+    table = TransformBlendTable()
+    table.add_blend(TransformBlend(joint1, 1.0))
+    table.add_blend(TransformBlend(joint2, 1.0))
+    table.add_blend(TransformBlend(joint1, 0.25, joint2, 0.75))
+    table.set_rows(SparseArray.range(0, NUM_ROWS))
+
+    vdata = GeomVertexData("skinned", format, Geom.UH_static)
+    vdata.set_transform_blend_table(table)
+
+    vertex = GeomVertexWriter(vdata, "vertex")
+    normal = GeomVertexWriter(vdata, "normal")
+    blend = GeomVertexWriter(vdata, "transform_blend")
+    for i in range(NUM_ROWS):
+        vertex.add_data3(i, i * 0.5, -i)
+        normal.add_data3(Vec3(i % 3, 1, 0).normalized())
+        # Vary the run lengths of the blend indices.
+        blend.add_data1i((i // (1 + i % 4)) % 3)
+
+    return vdata
+
+
+def animate(vdata, fast):
+    var = ConfigVariableBool("fast-skinning")
+    orig = var.value
+    var.value = fast
+    try:
+        animated = vdata.animate_vertices(True, Thread.get_current_thread())
+    finally:
+        var.value = orig
+
+    vertex = GeomVertexReader(animated, "vertex")
+    normal = GeomVertexReader(animated, "normal")
+    return [(Point3(vertex.get_data3()), Vec3(normal.get_data3()))
+            for i in range(NUM_ROWS)]
+
+
+def test_animate_vertices_rigid():
+    vdata = make_skinned_vdata()
+    result = animate(vdata, True)
+
+    mat = LMatrix4.translate_mat(1, 2, 3) * LMatrix4.rotate_mat(30, Vec3(0, 0, 1))
+    point, normal = result[0]
+    assert point.almost_equal(mat.xform_point(Point3(0, 0, 0)))
+    assert normal.almost_equal(mat.xform_vec(Vec3(0, 1, 0)))
+
+
+def test_animate_vertices_fast_matches_general():
+    for blend_type in (Geom.NT_uint16, Geom.NT_uint32):
+        # The animated vertices are cached, so each needs its own vdata.
+        fast = animate(make_skinned_vdata(blend_type), True)
+        general = animate(make_skinned_vdata(blend_type), False)
+
+        for (fp, fn), (gp, gn) in zip(fast, general):
+            assert fp.almost_equal(gp, 1e-4)
+            assert fn.almost_equal(gn, 1e-4)
@@ -0,0 +1,47 @@
+from panda3d import core
+import math
+import pytest
+
+
+@pytest.fixture
+def sphere_geom():
+    "Returns a Geom containing a unit UV sphere with normals."
+    rings = 16
+    segments = 32
+
+    vertex_data = core.GeomVertexData("", core.GeomVertexFormat.get_v3n3(), core.GeomEnums.UH_static)
+    vertex = core.GeomVertexWriter(vertex_data, "vertex")
+    normal = core.GeomVertexWriter(vertex_data, "normal")
+
+    def add(x, y, z):
+        vertex.add_data3(x, y, z)
+        normal.add_data3(x, y, z)
+
+    add(0, 0, 1)
+    for r in range(1, rings):
+        theta = math.pi * r / rings
+        for s in range(segments):
+            phi = 2 * math.pi * s / segments
+            add(math.sin(theta) * math.cos(phi),
+                math.sin(theta) * math.sin(phi),
+                math.cos(theta))
+    add(0, 0, -1)
+
+    def ring(r, s):
+        if r == 0:
+            return 0
+        if r == rings:
+            return vertex_data.get_num_rows() - 1
+        return 1 + (r - 1) * segments + s % segments
+
+    prim = core.GeomTriangles(core.GeomEnums.UH_static)
+    for r in range(rings):
+        for s in range(segments):
+            if r > 0:
+                prim.add_vertices(ring(r, s), ring(r + 1, s), ring(r, s + 1))
+            if r < rings - 1:
+                prim.add_vertices(ring(r, s + 1), ring(r + 1, s), ring(r + 1, s + 1))
+
+    geom = core.Geom(vertex_data)
+    geom.add_primitive(prim)
+    return geom
@@ -0,0 +1,185 @@
+from panda3d import core
+from panda3d.core import InstanceList, InstancedNode, NodePath
+import math
+import pytest
+
+
+@pytest.fixture(scope='module')
+def buffer():
+    "Returns an offscreen buffer that the instances are rendered into."
+    pipe = core.GraphicsPipeSelection.get_global_ptr().make_default_pipe()
+    if pipe is None or not pipe.is_valid():
+        pytest.skip("GraphicsPipe is invalid")
+
+    engine = core.GraphicsEngine()
+    engine.set_threading_model("")
+
+    fbprops = core.FrameBufferProperties()
+    fbprops.set_rgb_color(True)
+    fbprops.force_hardware = True
+
+    buffer = engine.make_output(
+        pipe,
+        'buffer',
+        0,
+        fbprops,
+        core.WindowProperties.size(64, 64),
+        core.GraphicsPipe.BF_refuse_window
+    )
+    engine.open_windows()
+
+    if buffer is None:
+        pytest.skip("GraphicsPipe cannot make offscreen buffers")
+
+    yield buffer
+
+    engine.remove_all_windows()
+
+
+def render_instances(buffer, instances):
+    """Renders a small white card at each of the given instances, seen by a
+    camera at the origin looking down the Y axis, and returns the image."""
+
+    scene = NodePath("root")
+    scene.set_depth_test(False)
+
+    camera = scene.attach_new_node(core.Camera("camera"))
+    camera.node().get_lens(0).set_fov(90, 90)
+    camera.node().get_lens(0).set_near_far(1, 100)
+
+    cm = core.CardMaker("card")
+    cm.set_frame(-1, 1, -1, 1)
+    cm.set_color(1, 1, 1, 1)
+
+    node = InstancedNode("instances")
+    node.instances = instances
+    root = scene.attach_new_node(node)
+    root.attach_new_node(cm.generate())
+
+    region = buffer.make_display_region()
+    region.camera = camera
+    region.set_clear_color_active(True)
+    region.set_clear_color((0, 0, 0, 1))
+
+    texture = core.Texture("color")
+    buffer.add_render_texture(texture, core.GraphicsOutput.RTM_copy_ram,
+                              core.GraphicsOutput.RTP_color)
+    buffer.engine.render_frame()
+    buffer.clear_render_textures()
+    buffer.remove_display_region(region)
+
+    image = core.PNMImage()
+    assert texture.store(image)
+    return image
+
+
+def is_lit(image, u, v):
+    # v runs upwards, but the rows of the image run downwards.
+    x = int(u * image.get_x_size())
+    y = int((1 - v) * image.get_y_size())
+    return image.get_bright(x, y) > 0.5
+
+
+def test_instancelist_distance_range():
+    instances = InstanceList()
+    instances.append((1, 2, 3))
+
+    instance = instances[0]
+    assert not instance.has_distance_range()
+    assert instance.min_distance == 0
+    assert math.isinf(instance.max_distance)
+
+    instance.set_distance_range(10, 20)
+    assert instance.has_distance_range()
+    assert instance.min_distance == 10
+    assert instance.max_distance == 20
+
+    instance.clear_distance_range()
+    assert not instance.has_distance_range()
+
+
+def test_instancednode_bam_roundtrip():
+    node = InstancedNode("instances")
+    instances = node.modify_instances()
+    for i in range(100):
+        instances.append((i, 0, 0))
+
+    np = NodePath(node)
+    copy = NodePath.decode_from_bam_stream(np.encode_to_bam_stream())
+    assert copy.node().get_num_instances() == 100
+
+    instances = copy.node().get_instances()
+    assert instances[0].get_pos().almost_equal((0, 0, 0))
+    assert instances[99].get_pos().almost_equal((99, 0, 0))
+
+
+def test_instancednode_cull_frustum(buffer):
+    instances = InstanceList()
+
+    # Two instances in view, at either side of the image.
+    instances.append((-5, 10, 0))
+    instances.append((5, 10, 0))
+
+    # Many more out of view: behind the camera, and far off to the sides.
+    for i in range(50):
+        instances.append((i - 25, -10, 0))
+        instances.append((200 + i, 10, 0))
+
+    image = render_instances(buffer, instances)
+    assert is_lit(image, 0.25, 0.5)
+    assert is_lit(image, 0.75, 0.5)
+    assert not is_lit(image, 0.5, 0.5)
+
+
+def test_instancednode_cull_distance_range(buffer):
+    instances = InstanceList()
+    instances.append((-5, 10, 0))
+    instances.append((5, 10, 0))
+
+    # Both are a little more than 11 units away from the camera.
+    instances[0].set_distance_range(0, 5)
+    instances[1].set_distance_range(5, 20)
+
+    image = render_instances(buffer, instances)
+    assert not is_lit(image, 0.25, 0.5)
+    assert is_lit(image, 0.75, 0.5)
+
+    # Without any distance ranges, both are visible.
+    instances[0].clear_distance_range()
+    instances[1].clear_distance_range()
+    image = render_instances(buffer, instances)
+    assert is_lit(image, 0.25, 0.5)
+    assert is_lit(image, 0.75, 0.5)
+
+
+def test_instancednode_bam_distance_range(tmp_path):
+    node = InstancedNode("instances")
+    instances = node.modify_instances()
+    instances.append((1, 2, 3))
+    instances.append((4, 5, 6))
+    instances[1].set_distance_range(10, 20)
+
+    # The distance ranges were added in bam 6.47.
+    filename = core.Filename.from_os_specific(str(tmp_path / "instances.bam"))
+    dout = core.DatagramOutputFile()
+    assert dout.open(filename)
+    assert dout.write_header("pbj\x00\n\r")
+    writer = core.BamWriter(dout)
+    writer.set_file_minor_ver(47)
+    assert writer.init()
+    assert writer.write_object(node)
+    writer.flush()
+    dout.close()
+
+    bam = core.BamFile()
+    assert bam.open_read(filename)
+    copy = bam.read_node()
+    assert bam.resolve()
+    bam.close()
+
+    instances = copy.instances
+    assert len(instances) == 2
+    assert not instances[0].has_distance_range()
+    assert instances[1].has_distance_range()
+    assert instances[1].min_distance == 10
+    assert instances[1].max_distance == 20
@@ -0,0 +1,73 @@
+from panda3d.core import Loader, LoaderOptions, ModelRoot, NodePath, Filename
+from panda3d.core import CardMaker, PNMImage, TexturePool
+from panda3d.core import AnimBundle, AnimBundleNode
+import pytest
+
+
+@pytest.fixture
+def model_filename(tmp_path):
+    root = NodePath(ModelRoot("root"))
+    for i in range(3):
+        image = PNMImage(16 << i, 16, 3)
+        image.fill(0.25 * i, 0.5, 0.75)
+        tex_filename = Filename.from_os_specific(str(tmp_path / "tex{0}.ppm".format(i)))
+        assert image.write(tex_filename)
+
+        card = root.attach_new_node(CardMaker("card").generate())
+        card.set_texture(TexturePool.load_texture(tex_filename))
+
+    root.attach_new_node(AnimBundleNode("anim", AnimBundle("anim", 24, 10)))
+
+    filename = Filename.from_os_specific(str(tmp_path / "model.bam"))
+    assert root.write_bam_file(filename)
+
+    # Make sure the textures are read from disk again.
+    TexturePool.release_all_textures()
+    yield filename
+    TexturePool.release_all_textures()
+
+
+def test_loader_streaming(model_filename):
+    loader = Loader.get_global_ptr()
+    options = LoaderOptions(LoaderOptions.LF_no_cache | LoaderOptions.LF_streaming)
+
+    request = loader.make_async_request(model_filename, options)
+    loader.load_async(request)
+    model = request.result()
+    assert model is not None
+
+    # Only the texture images are deferred; the geometry and animations are
+    # there as soon as the model is returned.
+    root = NodePath(model)
+    assert root.find_all_matches("**/+GeomNode").get_num_paths() == 3
+    assert not root.find("**/+AnimBundleNode").is_empty()
+
+    # The textures are read by a separate request.
+    stream = request.stream_request
+    assert stream is not None
+    assert stream.num_textures == 3
+    assert stream.result() == model
+    assert stream.num_loaded_textures == 3
+
+    textures = NodePath(model).find_all_textures()
+    assert textures.get_num_textures() == 3
+    for tex in textures:
+        assert tex.has_ram_image()
+
+
+def test_loader_streaming_cancel(model_filename):
+    loader = Loader.get_global_ptr()
+    options = LoaderOptions(LoaderOptions.LF_no_cache | LoaderOptions.LF_streaming)
+
+    request = loader.make_async_request(model_filename, options)
+    request.set_delay(100.0)
+    loader.load_async(request)
+    assert request.cancel()
+    assert request.stream_request is None
+
+
+def test_loader_not_streaming(model_filename):
+    model = Loader.get_global_ptr().load_sync(model_filename, LoaderOptions(LoaderOptions.LF_no_cache))
+    textures = NodePath(model).find_all_textures()
+    assert textures.get_num_textures() == 3
+    assert all(tex.has_ram_image() for tex in textures)
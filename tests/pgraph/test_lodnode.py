@@ -0,0 +1,48 @@
+from panda3d import core
+import pytest
+
+
+def make_sphere(geom):
+    node = core.GeomNode("sphere")
+    node.add_geom(geom)
+    return node
+
+
+def count_tris(node):
+    sga = core.SceneGraphAnalyzer()
+    sga.add_node(node)
+    return sga.get_num_tris()
+
+
+def test_lodnode_make_simplified_lod(sphere_geom):
+    sphere = make_sphere(sphere_geom)
+    num_tris = count_tris(sphere)
+
+    lod = core.LODNode.make_simplified_lod("lod", sphere, 4)
+    assert lod.get_num_children() == lod.get_num_switches()
+    assert 2 <= lod.get_num_switches() <= 4
+
+    # The first level is the full model, shown up close.
+    assert lod.get_out(0) == 0
+    assert count_tris(lod.get_child(0)) == num_tris
+
+    # The levels get simpler, and take over where the previous one ends.
+    for i in range(1, lod.get_num_switches()):
+        assert lod.get_out(i) == lod.get_in(i - 1)
+        assert lod.get_in(i) > lod.get_out(i)
+        assert count_tris(lod.get_child(i)) < count_tris(lod.get_child(i - 1))
+
+    # The source is untouched.
+    assert count_tris(sphere) == num_tris
+
+
+def test_lodnode_make_simplified_lod_pixel_error(sphere_geom):
+    sphere = make_sphere(sphere_geom)
+
+    # Allowing a larger error on screen switches to simpler levels sooner.
+    fine = core.LODNode.make_simplified_lod("lod", sphere, 2, 0.5, 1.0)
+    coarse = core.LODNode.make_simplified_lod("lod", sphere, 2, 0.5, 4.0)
+    assert fine.get_num_switches() == 2
+    assert coarse.get_num_switches() == 2
+    assert coarse.get_in(0) < fine.get_in(0)
+    assert coarse.get_in(0) * 4 == pytest.approx(fine.get_in(0))
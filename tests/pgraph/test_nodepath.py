@@ -240,3 +240,55 @@ def test_nodepath_replace_texture():
     path1.replace_texture(tex1, tex2)
     assert not path1.has_texture()
     assert path2.get_texture() == tex2
+
+
+def test_nodepath_optimize_vertex_cache():
+    from panda3d.core import NodePath, GeomNode, Geom, GeomTriangles
+    from panda3d.core import GeomVertexData, GeomVertexFormat, GeomVertexWriter
+    from panda3d.core import GeomVertexReader
+
+    size = 12
+    vdata = GeomVertexData("grid", GeomVertexFormat.get_v3(), Geom.UH_static)
+    writer = GeomVertexWriter(vdata, "vertex")
+    for y in range(size + 1):
+        for x in range(size + 1):
+            writer.add_data3(x, y, 0)
+
+    # Add the quads in column order, reversed, to start with a poor order.
+    prim = GeomTriangles(Geom.UH_static)
+    for x in reversed(range(size)):
+        for y in range(size):
+            v0 = y * (size + 1) + x
+            prim.add_vertices(v0, v0 + 1, v0 + size + 1)
+            prim.add_vertices(v0 + size + 1, v0 + 1, v0 + size + 2)
+
+    geom = Geom(vdata)
+    geom.add_primitive(prim)
+    node = GeomNode("grid")
+    node.add_geom(geom)
+    path = NodePath(node)
+
+    orig_acmr = path.calc_acmr()
+    assert path.optimize_vertex_cache() == 1
+    assert path.calc_acmr() < orig_acmr
+
+    # The vertices are now numbered in the order they are first used.
+    geom = node.get_geom(0)
+    vdata = geom.get_vertex_data()
+    assert vdata.get_num_rows() == (size + 1) ** 2
+    verts = geom.get_primitive(0).get_vertex_list()
+    seen = []
+    for v in verts:
+        if v not in seen:
+            seen.append(v)
+    assert seen == list(range(len(seen)))
+
+    # And each triangle still refers to the same positions.
+    reader = GeomVertexReader(vdata, "vertex")
+    for i in range(0, len(verts), 3):
+        points = []
+        for v in verts[i:i + 3]:
+            reader.set_row(v)
+            points.append(reader.get_data3())
+        normal = (points[1] - points[0]).cross(points[2] - points[0])
+        assert normal.z > 0
@@ -0,0 +1,240 @@
+from panda3d import core
+
+
+def make_city(num_blocks):
+    # Each block is a few transformed nodes with a single quad at the bottom.
+    root = core.NodePath("city")
+    for i in range(num_blocks):
+        block = root.attach_new_node("block%d" % (i))
+        block.set_pos(i * 10, 0, 0)
+        inner = block.attach_new_node("inner")
+        inner.set_scale(2)
+
+        vdata = core.GeomVertexData("quad", core.GeomVertexFormat.get_v3(), core.Geom.UH_static)
+        writer = core.GeomVertexWriter(vdata, "vertex")
+        writer.add_data3(0, 0, 0)
+        writer.add_data3(1, 0, 0)
+        writer.add_data3(1, 1, 0)
+        writer.add_data3(0, 1, 0)
+        prim = core.GeomTriangles(core.Geom.UH_static)
+        prim.add_vertices(0, 1, 2)
+        prim.add_vertices(0, 2, 3)
+        geom = core.Geom(vdata)
+        geom.add_primitive(prim)
+        node = core.GeomNode("quad%d" % (i))
+        node.add_geom(geom)
+        inner.attach_new_node(node)
+
+    # A node with two parents, which must be flattened serially.
+    shared = core.NodePath("shared")
+    shared.attach_new_node("leaf").set_pos(1, 2, 3)
+    shared.instance_to(root.get_child(0))
+    shared.instance_to(root.get_child(1))
+    return root
+
+
+def get_vertices(root):
+    result = []
+    for path in root.find_all_matches("**/+GeomNode"):
+        for geom in path.node().get_geoms():
+            reader = core.GeomVertexReader(geom.get_vertex_data(), "vertex")
+            while not reader.is_at_end():
+                result.append(tuple(reader.get_data3()))
+    return sorted(result)
+
+
+def flatten(root, num_threads, combine_siblings_bits=0):
+    gr = core.SceneGraphReducer()
+    gr.set_num_threads(num_threads)
+    assert gr.get_num_threads() == num_threads
+    gr.apply_attribs(root.node())
+    num_removed = gr.flatten(root.node(), combine_siblings_bits)
+    gr.collect_vertex_data(root.node())
+
+    # Once finished, the reducer is idle again.
+    assert gr.get_progress_phase() == ""
+    assert gr.get_progress() == 1
+    return num_removed
+
+
+def test_scenegraphreducer_threads():
+    serial = make_city(40)
+    parallel = make_city(40)
+
+    num_serial = flatten(serial, 0)
+    num_parallel = flatten(parallel, 2)
+    assert num_serial > 0
+    assert num_parallel == num_serial
+
+    serial_names = [str(path) for path in serial.find_all_matches("**")]
+    parallel_names = [str(path) for path in parallel.find_all_matches("**")]
+    assert parallel_names == serial_names
+    assert get_vertices(parallel) == get_vertices(serial)
+
+
+def test_scenegraphreducer_threads_combine_siblings():
+    serial = make_city(40)
+    parallel = make_city(40)
+
+    bits = core.SceneGraphReducer.CS_geom_node | core.SceneGraphReducer.CS_recurse
+    assert flatten(parallel, 2, bits) == flatten(serial, 0, bits)
+    assert parallel.node().count_num_descendants() == serial.node().count_num_descendants()
+    assert get_vertices(parallel) == get_vertices(serial)
+
+
+def make_skinned(num_nodes, num_names):
+    array = core.GeomVertexArrayFormat()
+    array.add_column(core.InternalName.get_vertex(), 3, core.Geom.NT_float32, core.Geom.C_point)
+    array.add_column(core.InternalName.get_transform_blend(), 1, core.Geom.NT_uint16, core.Geom.C_index)
+    format = core.GeomVertexFormat()
+    format.add_array(array)
+    spec = core.GeomVertexAnimationSpec()
+    spec.set_panda()
+    format.set_animation(spec)
+    format = core.GeomVertexFormat.register_format(format)
+
+    joints = []
+    for i in range(3):
+        joint = core.UserVertexTransform("joint%d" % (i))
+        joint.set_matrix(core.LMatrix4.translate_mat(i, i * 2, 0))
+        joints.append(joint)
+
+    # Each node has its own table, with the blends in a different order, so
+    # the blend indices have to be remapped when the vertex datas are combined.
+    # Giving the vertex datas different names splits them into several
+    # collections.
+    root = core.NodePath("skinned")
+    for i in range(num_nodes):
+        table = core.TransformBlendTable()
+        for j in range(3):
+            joint = joints[(i + j) % 3]
+            table.add_blend(core.TransformBlend(joint, 1.0))
+        table.add_blend(core.TransformBlend(joints[i % 3], 0.5, joints[(i + 1) % 3], 0.5))
+        table.set_rows(core.SparseArray.range(0, 3))
+
+        vdata = core.GeomVertexData("skin%d" % (i % num_names), format, core.Geom.UH_static)
+        vdata.set_transform_blend_table(table)
+        vertex = core.GeomVertexWriter(vdata, "vertex")
+        blend = core.GeomVertexWriter(vdata, "transform_blend")
+        for j in range(3):
+            vertex.add_data3(i, j, 0)
+            blend.add_data1i((i + j) % table.get_num_blends())
+
+        prim = core.GeomTriangles(core.Geom.UH_static)
+        prim.add_vertices(0, 1, 2)
+        geom = core.Geom(vdata)
+        geom.add_primitive(prim)
+        node = core.GeomNode("skin%d" % (i))
+        node.add_geom(geom)
+        root.attach_new_node(node)
+
+    return root
+
+
+def get_animated_vertices(root):
+    result = []
+    for path in root.find_all_matches("**/+GeomNode"):
+        for geom in path.node().get_geoms():
+            vdata = geom.get_vertex_data().animate_vertices(True, core.Thread.get_current_thread())
+            reader = core.GeomVertexReader(vdata, "vertex")
+            while not reader.is_at_end():
+                result.append(tuple(reader.get_data3()))
+    return sorted(result)
+
+
+def test_scenegraphreducer_threads_blend_table():
+    serial = make_skinned(60, 3)
+    parallel = make_skinned(60, 3)
+    expected = get_animated_vertices(serial)
+
+    flatten(serial, 0)
+    flatten(parallel, 2)
+
+    vdatas = set()
+    for path in parallel.find_all_matches("**/+GeomNode"):
+        for geom in path.node().get_geoms():
+            vdatas.add(geom.get_vertex_data())
+    assert len(vdatas) == 3
+
+    assert get_animated_vertices(serial) == expected
+    assert get_animated_vertices(parallel) == expected
+
+
+def make_mixed_formats(num_nodes):
+    formats = [
+        core.GeomVertexFormat.get_v3(),
+        core.GeomVertexFormat.get_v3n3(),
+        core.GeomVertexFormat.get_v3t2(),
+    ]
+
+    root = core.NodePath("mixed")
+    for i in range(num_nodes):
+        node = core.GeomNode("mixed%d" % (i))
+        for j, format in enumerate(formats):
+            vdata = core.GeomVertexData("mixed", format, core.Geom.UH_static)
+            writer = core.GeomVertexWriter(vdata, "vertex")
+            writer.add_data3(i, j, 0)
+            writer.add_data3(i + 1, j, 0)
+            writer.add_data3(i + 1, j + 1, 0)
+            prim = core.GeomTriangles(core.Geom.UH_static)
+            prim.add_vertices(0, 1, 2)
+            geom = core.Geom(vdata)
+            geom.add_primitive(prim)
+            node.add_geom(geom)
+        root.attach_new_node(node)
+
+    return root
+
+
+def test_scenegraphreducer_make_compatible_format():
+    serial = make_mixed_formats(20)
+    parallel = make_mixed_formats(20)
+    expected = get_vertices(serial)
+
+    for root, num_threads in ((serial, 0), (parallel, 2)):
+        gr = core.SceneGraphReducer()
+        gr.set_num_threads(num_threads)
+        assert gr.make_compatible_format(root.node()) > 0
+        assert gr.get_progress_phase() == ""
+        assert gr.get_progress() == 1
+
+        # Each node's Geoms now share one format.
+        for path in root.find_all_matches("**/+GeomNode"):
+            formats = set(geom.get_vertex_data().get_format() for geom in path.node().get_geoms())
+            assert len(formats) == 1
+
+    assert get_vertices(serial) == expected
+    assert get_vertices(parallel) == expected
+
+
+def test_scenegraphreducer_progress():
+    import threading
+
+    root = make_city(2000)
+    gr = core.SceneGraphReducer()
+    gr.set_num_threads(2)
+
+    samples = []
+    done = threading.Event()
+
+    def poll():
+        while not done.is_set():
+            samples.append((gr.get_progress_phase(), gr.get_progress()))
+
+    thread = threading.Thread(target=poll)
+    thread.start()
+    try:
+        gr.apply_attribs(root.node())
+        gr.flatten(root.node(), 0)
+        gr.collect_vertex_data(root.node())
+    finally:
+        done.set()
+        thread.join()
+
+    assert samples
+    for phase, progress in samples:
+        assert phase in ("", "apply", "flatten", "collect")
+        assert 0 <= progress <= 1
+
+    assert gr.get_progress_phase() == ""
+    assert gr.get_progress() == 1
@@ -0,0 +1,58 @@
+from panda3d.core import TransformState, RenderState, ColorAttrib
+from panda3d.core import Thread
+import pytest
+
+
+def test_transform_state_unique():
+    states = [TransformState.make_pos((i, 0, 0)) for i in range(100)]
+    for i in range(100):
+        assert TransformState.make_pos((i, 0, 0)) == states[i]
+        assert TransformState.make_pos((i, 0, 0)).this == states[i].this
+
+    assert TransformState.get_num_states() >= 100
+    assert TransformState.validate_states()
+
+
+def test_render_state_unique():
+    states = [RenderState.make(ColorAttrib.make_flat((i / 100.0, 0, 0, 1)))
+              for i in range(100)]
+    for i, state in enumerate(states):
+        other = RenderState.make(ColorAttrib.make_flat((i / 100.0, 0, 0, 1)))
+        assert other.this == state.this
+
+    assert RenderState.get_num_states() >= 100
+    assert RenderState.validate_states()
+
+
+def test_state_garbage_collect():
+    num_before = TransformState.get_num_states()
+    states = [TransformState.make_hpr((i, 1, 2)) for i in range(200)]
+    assert TransformState.get_num_states() >= num_before + 200
+    del states
+
+    # Every state must eventually be visited by the collector, in whichever
+    # shard of the cache it lives.
+    for i in range(50):
+        TransformState.garbage_collect()
+    assert TransformState.get_num_states() <= num_before
+    assert TransformState.validate_states()
+
+
+@pytest.mark.skipif(not Thread.is_threading_supported(), reason="requires threading")
+def test_state_cache_threads():
+    import threading
+
+    results = [None] * 4
+
+    def make_states(index):
+        results[index] = [TransformState.make_pos((i, 2, 3))
+                          for i in range(500)]
+
+    threads = [threading.Thread(target=make_states, args=(i,)) for i in range(4)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+
+    for result in results[1:]:
+        assert [s.this for s in result] == [s.this for s in results[0]]
@@ -0,0 +1,138 @@
+from panda3d.core import PfmFile
+from panda3d.core import LPoint3f, LPoint4f, LVecBase3f, LMatrix4f
+
+
+def make_pfm(x_size, y_size, holes=False):
+    pfm = PfmFile()
+    pfm.clear(x_size, y_size, 3)
+    for y in range(y_size):
+        for x in range(x_size):
+            if holes and (x // 7 + y // 5) % 4 == 0:
+                continue
+            pfm.set_point(x, y, ((x + 0.5) / x_size, (y + 0.5) / y_size, (x * y) % 5))
+    if holes:
+        pfm.set_no_data_value(LPoint4f.zero())
+    return pfm
+
+
+def test_pfmfile_resize_constant():
+    src = PfmFile()
+    src.clear(40, 30, 3)
+    src.fill(LPoint3f(0.25, 0.5, 0.75))
+
+    for x_size, y_size in (13, 17), (80, 45):
+        dst = PfmFile(src)
+        dst.resize(x_size, y_size)
+        assert dst.get_point3(0, 0).almost_equal((0.25, 0.5, 0.75))
+        assert dst.get_point3(x_size - 1, y_size - 1).almost_equal((0.25, 0.5, 0.75))
+
+
+def test_pfmfile_resize_sparse():
+    src = make_pfm(60, 40, holes=True)
+    dst = PfmFile(src)
+    dst.resize(90, 70)
+
+    # Filtering doesn't bleed the missing points into the result, and a point
+    # entirely within a hole remains missing.
+    assert not src.has_point(0, 0)
+    assert not dst.has_point(0, 0)
+    for y in range(dst.get_y_size()):
+        for x in range(dst.get_x_size()):
+            if dst.has_point(x, y):
+                assert dst.get_point3(x, y)[0] > 0
+
+
+def test_pfmfile_calc_min_max():
+    pfm = make_pfm(50, 40, holes=True)
+    min_point = LVecBase3f()
+    max_point = LVecBase3f()
+    assert pfm.calc_min_max(min_point, max_point)
+    assert min_point.almost_equal((0.5 / 50, 0.5 / 40, 0))
+    assert max_point.almost_equal((49.5 / 50, 39.5 / 40, 4))
+
+    empty = PfmFile()
+    empty.clear(10, 10, 3)
+    empty.set_no_data_value(LPoint4f.zero())
+    assert not empty.calc_min_max(min_point, max_point)
+
+
+def run_in_threads(func, num_threads=4):
+    # Calls func from several threads at once, and returns the results.
+    from threading import Thread
+
+    results = [None] * num_threads
+
+    def run_thread(i):
+        results[i] = func()
+
+    threads = [Thread(target=run_thread, args=(i, )) for i in range(num_threads)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    return results
+
+
+def test_pfmfile_xform_threads():
+    mat = LMatrix4f.rotate_mat(30, (0, 0, 1)) * LMatrix4f.translate_mat(1, 2, 3)
+
+    def run_xform():
+        pfm = make_pfm(70, 50, holes=True)
+        pfm.xform(mat)
+        return bytes(memoryview(pfm))
+
+    # The job runner is shared, so transforming from several threads at once
+    # must give the same result as transforming from one.
+    expected = run_xform()
+    for result in run_in_threads(run_xform):
+        assert result == expected
+
+
+def test_pfmfile_forward_distort_threads():
+    dist = make_pfm(40, 30, holes=True)
+
+    def run_forward_distort():
+        pfm = make_pfm(60, 45)
+        pfm.forward_distort(dist)
+        return bytes(memoryview(pfm))
+
+    expected = run_forward_distort()
+    for result in run_in_threads(run_forward_distort):
+        assert result == expected
+
+
+def test_pfmfile_calc_min_max_threads():
+    pfm = make_pfm(150, 120, holes=True)
+
+    def run_calc_min_max():
+        min_point = LVecBase3f()
+        max_point = LVecBase3f()
+        assert pfm.calc_min_max(min_point, max_point)
+        return min_point, max_point
+
+    for min_point, max_point in run_in_threads(run_calc_min_max):
+        assert min_point.almost_equal((0.5 / 150, 0.5 / 120, 0))
+        assert max_point.almost_equal((149.5 / 150, 119.5 / 120, 4))
+
+
+def test_pfmfile_num_threads_runtime():
+    from panda3d.core import ConfigVariableInt
+
+    mat = LMatrix4f.rotate_mat(30, (0, 0, 1))
+
+    def run_xform():
+        pfm = make_pfm(70, 50, holes=True)
+        pfm.xform(mat)
+        return bytes(memoryview(pfm))
+
+    # pfm-num-threads may be changed after the job runner has been used.
+    var = ConfigVariableInt("pfm-num-threads")
+    try:
+        var.value = 0
+        expected = run_xform()
+        var.value = 3
+        assert run_xform() == expected
+        var.value = 0
+        assert run_xform() == expected
+    finally:
+        var.clear_local_value()
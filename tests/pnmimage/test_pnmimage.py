@@ -1,5 +1,6 @@
 from panda3d.core import PNMImage, PNMImageHeader
 from random import randint
+import math
 
 
 def test_pixelspec_ctor():
@@ -107,3 +108,147 @@ def test_pnmimage_mult_sub_image():
     assert final_color[0][1] == dst_color[0][1]
     assert final_color[1][0] == dst_color[1][0]
     assert final_color[1][1][0] == dst_color[1][1][0] * src_color[0] and final_color[1][1][1] == dst_color[1][1][1] * src_color[1] and final_color[1][1][2] == dst_color[1][1][2] * src_color[2]
+
+
+def make_filter_image():
+    img = PNMImage(64, 48, 4)
+    for x in range(64):
+        for y in range(48):
+            img.set_xel_val(x, y, randint(0, 255), x * 4, y * 5)
+            img.set_alpha_val(x, y, (x + y) % 256)
+    return img
+
+
+def test_pnmimage_filter_constant():
+    src = PNMImage(40, 30, 4)
+    src.fill(0.25, 0.5, 0.75)
+    src.alpha_fill(0.5)
+
+    for dst in PNMImage(13, 17, 4), PNMImage(80, 45, 4):
+        dst.box_filter_from(1.0, src)
+        assert dst.get_xel_val(0, 0) == src.get_xel_val(0, 0)
+        assert dst.get_xel_val(dst.x_size - 1, dst.y_size - 1) == src.get_xel_val(0, 0)
+        assert dst.get_alpha_val(5, 5) == src.get_alpha_val(0, 0)
+
+        dst.gaussian_filter_from(1.0, src)
+        assert dst.get_xel_val(6, 7) == src.get_xel_val(0, 0)
+        assert dst.get_alpha_val(6, 7) == src.get_alpha_val(0, 0)
+
+
+def test_pnmimage_filter_grayscale():
+    src = make_filter_image()
+    dst = PNMImage(32, 24, 1)
+    dst.box_filter_from(0.5, src)
+
+    # A grayscale destination receives the filtered brightness.
+    assert abs(dst.get_gray(0, 0) - (src.get_bright(0, 0) + src.get_bright(1, 0) +
+                                     src.get_bright(0, 1) + src.get_bright(1, 1)) / 4) < 0.01
+
+
+def reference_filter_row(source, dest_len, width):
+    # This is the box filter that PNMImage used before the channels were
+    # filtered together, one row of one channel at a time.
+    source_len = len(source)
+    scale = dest_len / source_len
+    if scale < 1.0:
+        fscale = 1.0 / scale
+        iscale = 1.0
+        filter_width = width / scale
+    else:
+        fscale = scale
+        iscale = scale
+        filter_width = width
+    actual_width = int(math.ceil((width + 1) * fscale)) + 2
+    kernel = [1.0 if i <= width * fscale else 0.0 for i in range(actual_width)]
+
+    dest = []
+    for dest_x in range(dest_len):
+        center = (dest_x + 0.5) / scale - 0.5
+        left = max(int(math.floor(center - filter_width)), 0)
+        right = min(int(math.ceil(center + filter_width)), source_len - 1)
+        net_weight = 0.0
+        net_value = 0.0
+        for source_x in range(left, right + 1):
+            weight = kernel[int(math.floor(iscale * abs(center - source_x) + 0.5))]
+            net_value += weight * source[source_x]
+            net_weight += weight
+        dest.append(net_value / net_weight if net_weight > 0 else 0.0)
+    return dest
+
+
+def reference_box_filter(src, x_size, y_size, width, get_value):
+    rows = [reference_filter_row([get_value(x, y) for x in range(src.x_size)], x_size, width)
+            for y in range(src.y_size)]
+    columns = [reference_filter_row([row[x] for row in rows], y_size, width)
+               for x in range(x_size)]
+    return columns
+
+
+def test_pnmimage_filter_reference():
+    src = make_filter_image()
+
+    for x_size, y_size in (37, 100), (20, 15), (90, 70):
+        dst = PNMImage(x_size, y_size, 4)
+        dst.box_filter_from(1.0, src)
+
+        expected = [
+            reference_box_filter(src, x_size, y_size, 1.0, src.get_red),
+            reference_box_filter(src, x_size, y_size, 1.0, src.get_green),
+            reference_box_filter(src, x_size, y_size, 1.0, src.get_blue),
+            reference_box_filter(src, x_size, y_size, 1.0, src.get_alpha),
+        ]
+        for x in range(x_size):
+            for y in range(y_size):
+                pixel = dst.get_pixel(x, y)
+                for channel in range(4):
+                    # Allow for a difference of one step in rounding.
+                    value = expected[channel][x][y]
+                    if channel == 3:
+                        value = dst.to_alpha_val(value)
+                    else:
+                        value = dst.to_val(value)
+                    assert abs(pixel[channel] - value) <= 1
+
+    # A grayscale destination is filtered by the source's brightness.
+    dst = PNMImage(20, 15, 1)
+    dst.box_filter_from(1.0, src)
+    expected = reference_box_filter(src, 20, 15, 1.0, src.get_bright)
+    for x in range(20):
+        for y in range(15):
+            assert abs(dst.get_gray_val(x, y) - dst.to_val(expected[x][y])) <= 1
+
+
+def test_pnmimage_filter_threads():
+    from threading import Thread
+
+    src = make_filter_image()
+
+    def run_filters():
+        box = PNMImage(37, 100, 4)
+        box.box_filter_from(1.0, src)
+        gaussian = PNMImage(20, 15, 4)
+        gaussian.gaussian_filter_from(1.0, src)
+        quick = PNMImage(20, 15, 4)
+        quick.quick_filter_from(src)
+        return box, gaussian, quick
+
+    expected = run_filters()
+
+    # The filter job runner is shared, so filtering from several threads at
+    # once must give the same result as filtering from one.
+    results = [None] * 4
+
+    def run_thread(i):
+        results[i] = run_filters()
+
+    threads = [Thread(target=run_thread, args=(i, )) for i in range(len(results))]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+
+    for result in results:
+        for single, multi in zip(expected, result):
+            for x in range(single.x_size):
+                for y in range(single.y_size):
+                    assert single.get_pixel(x, y) == multi.get_pixel(x, y)
@@ -0,0 +1,101 @@
+from panda3d import core
+from array import array
+import pytest
+
+
+def make_scene():
+    # Big enough that the arrays are written as separate aligned blocks.
+    vdata = core.GeomVertexData("test", core.GeomVertexFormat.get_v3c4(),
+                                core.Geom.UH_static)
+    vdata.set_num_rows(1000)
+    vertex = core.GeomVertexWriter(vdata, "vertex")
+    color = core.GeomVertexWriter(vdata, "color")
+    for i in range(1000):
+        vertex.set_data3(i, i * 0.5, -i)
+        color.set_data4(i / 1000.0, 0, 1, 1)
+
+    prim = core.GeomPoints(core.Geom.UH_static)
+    prim.add_next_vertices(1000)
+    geom = core.Geom(vdata)
+    geom.add_primitive(prim)
+
+    node = core.GeomNode("test")
+    node.add_geom(geom)
+    root = core.NodePath(node)
+
+    tex = core.Texture("test")
+    tex.setup_2d_texture(64, 64, core.Texture.T_unsigned_byte, core.Texture.F_rgba)
+    tex.set_ram_image(array('B', (i % 251 for i in range(64 * 64 * 4))))
+    root.set_texture(tex)
+    return root
+
+
+def write_bam(root, filename, aligned):
+    dout = core.DatagramOutputFile()
+    assert dout.open(filename)
+    assert dout.write_header("pbj\x00\n\r")
+
+    writer = core.BamWriter(dout)
+    writer.set_file_minor_ver(46)
+    writer.file_aligned_data = aligned
+    assert writer.init()
+    assert writer.write_object(root.node())
+    writer.flush()
+    dout.close()
+
+
+def read_bam(filename):
+    bam = core.BamFile()
+    assert bam.open_read(filename)
+    node = bam.read_node()
+    assert bam.resolve()
+    bam.close()
+    return core.NodePath(node)
+
+
+def get_arrays(root):
+    vdata = root.node().get_geom(0).get_vertex_data()
+    return [bytes(vdata.get_array(i).get_handle().get_data())
+            for i in range(vdata.get_num_arrays())]
+
+
+@pytest.mark.parametrize("mmap", [True, False])
+@pytest.mark.parametrize("aligned", [True, False])
+def test_bam_aligned_data(tmp_path, aligned, mmap):
+    root = make_scene()
+    filename = core.Filename.from_os_specific(str(tmp_path / "test.bam"))
+    write_bam(root, filename, aligned)
+
+    var = core.ConfigVariableBool("bam-mmap-data")
+    old_value = var.get_value()
+    var.set_value(mmap)
+    try:
+        loaded = read_bam(filename)
+    finally:
+        var.set_value(old_value)
+
+    assert get_arrays(loaded) == get_arrays(root)
+
+    tex = loaded.find_texture("*")
+    assert tex is not None
+    expected = root.find_texture("*").get_ram_image()
+    assert bytes(memoryview(tex.get_ram_image())) == bytes(memoryview(expected))
+
+
+def test_bam_aligned_data_copy_on_write(tmp_path):
+    root = make_scene()
+    filename = core.Filename.from_os_specific(str(tmp_path / "test.bam"))
+    write_bam(root, filename, True)
+
+    loaded = read_bam(filename)
+    vdata = loaded.node().modify_geom(0).modify_vertex_data()
+    writer = core.GeomVertexWriter(vdata, "vertex")
+    writer.set_data3(1, 2, 3)
+
+    reader = core.GeomVertexReader(vdata, "vertex")
+    assert reader.get_data3() == (1, 2, 3)
+    assert reader.get_data3() == (1, 0.5, -1)
+
+    # The file itself is not affected.
+    loaded = read_bam(filename)
+    assert get_arrays(loaded) == get_arrays(root)
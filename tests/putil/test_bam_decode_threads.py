@@ -0,0 +1,85 @@
+from panda3d import core
+from array import array
+import pytest
+
+
+def make_scene():
+    # Several separate vertex datas and textures, each big enough to be
+    # decoded as its own job.
+    root = core.GeomNode("root")
+    formats = [core.GeomVertexFormat.get_v3(), core.GeomVertexFormat.get_v3n3t2(),
+               core.GeomVertexFormat.get_v3c4()]
+    for gi in range(6):
+        num_rows = 200 + gi * 150
+        vdata = core.GeomVertexData("geom%d" % (gi), formats[gi % len(formats)],
+                                    core.Geom.UH_static)
+        vdata.set_num_rows(num_rows)
+        vertex = core.GeomVertexWriter(vdata, "vertex")
+        for i in range(num_rows):
+            vertex.set_data3(i * gi, i * 0.5, -i)
+
+        prim = core.GeomPoints(core.Geom.UH_static)
+        prim.add_next_vertices(num_rows)
+        geom = core.Geom(vdata)
+        geom.add_primitive(prim)
+
+        tex = core.Texture("tex%d" % (gi))
+        size = 16 << (gi % 3)
+        tex.setup_2d_texture(size, size, core.Texture.T_unsigned_byte, core.Texture.F_rgba)
+        tex.set_ram_image(array('B', ((i + gi) % 251 for i in range(size * size * 4))))
+        root.add_geom(geom, core.RenderState.make(core.TextureAttrib.make(tex)))
+    return root
+
+
+def make_anim():
+    anim = core.AnimBundle("test", 24, 1000)
+    group = core.AnimGroup(anim, "<skeleton>")
+    joint = core.AnimChannelMatrixXfmTable(group, "joint")
+    joint.set_table('h', core.CPTA_float(core.PTA_float([i * 0.25 for i in range(1000)])))
+    joint.set_table('x', core.CPTA_float(core.PTA_float([-i for i in range(1000)])))
+    core.AnimChannelScalarTable(group, "morph")
+    return anim
+
+
+def round_trip(node, num_threads):
+    data = core.NodePath(node).encode_to_bam_stream()
+
+    var = core.ConfigVariableInt("bam-decode-threads")
+    old_value = var.get_value()
+    var.set_value(num_threads)
+    try:
+        return core.NodePath.decode_from_bam_stream(data).node()
+    finally:
+        var.set_value(old_value)
+
+
+@pytest.mark.parametrize("num_threads", [0, 1, 4])
+def test_bam_decode_threads_geom(num_threads):
+    node = make_scene()
+    loaded = round_trip(node, num_threads)
+    assert loaded.get_num_geoms() == node.get_num_geoms()
+
+    for gi in range(node.get_num_geoms()):
+        vdata = node.get_geom(gi).get_vertex_data()
+        loaded_vdata = loaded.get_geom(gi).get_vertex_data()
+        assert loaded_vdata.get_num_arrays() == vdata.get_num_arrays()
+        for i in range(vdata.get_num_arrays()):
+            expected = vdata.get_array(i).get_handle().get_data()
+            assert loaded_vdata.get_array(i).get_handle().get_data() == expected
+
+        tex = node.get_geom_state(gi).get_attrib(core.TextureAttrib).get_texture()
+        loaded_tex = loaded.get_geom_state(gi).get_attrib(core.TextureAttrib).get_texture()
+        assert loaded_tex.get_name() == tex.get_name()
+        assert bytes(memoryview(loaded_tex.get_ram_image())) == \
+            bytes(memoryview(tex.get_ram_image()))
+
+
+@pytest.mark.parametrize("num_threads", [0, 4])
+def test_bam_decode_threads_anim(num_threads):
+    anim = make_anim()
+    loaded = round_trip(core.AnimBundleNode("test", anim), num_threads).bundle
+
+    joint = anim.find_child("joint")
+    loaded_joint = loaded.find_child("joint")
+    for letter in "hx":
+        assert list(loaded_joint.get_table(letter)) == list(joint.get_table(letter))
@@ -6,3 +6,121 @@ def test_bamcache_flush_index():
     # consistently, and not intermittently, to avoid a noisy coverage report.
     cache = core.BamCache()
     cache.flush_index()
+
+
+def test_bamcache_journal(tmp_path):
+    root = core.Filename.from_os_specific(str(tmp_path / "cache"))
+    source = tmp_path / "source.egg"
+    source.write_text("dummy")
+    source = core.Filename.from_os_specific(str(source))
+
+    cache = core.BamCache()
+    cache.root = root
+    record = cache.lookup(source, "bam")
+    record.add_dependent_file(source)
+    record.data = core.PandaNode("test")
+    assert cache.store(record)
+
+    # The new record is appended to the journal, instead of the index being
+    # rewritten.
+    journals = list((tmp_path / "cache").glob("index-*.log"))
+    assert len(journals) == 1
+    assert journals[0].stat().st_size > 0
+
+    # Another cache sharing the same directory sees the record.
+    other = core.BamCache()
+    other.root = root
+    out = core.StringStream()
+    other.list_index(out)
+    assert source.get_fullpath() in out.data.decode()
+
+    record = other.lookup(source, "bam")
+    assert record.has_data()
+
+
+def test_bamcache_journal_replaced_index(tmp_path):
+    root = core.Filename.from_os_specific(str(tmp_path / "cache"))
+    sources = []
+    for i in range(3):
+        source = tmp_path / ("source%d.egg" % (i))
+        source.write_text("dummy")
+        sources.append(core.Filename.from_os_specific(str(source)))
+
+    def store(cache, source):
+        record = cache.lookup(source, "bam")
+        record.add_dependent_file(source)
+        record.data = core.PandaNode("test")
+        assert cache.store(record)
+
+    cache = core.BamCache()
+    cache.root = root
+    store(cache, sources[0])
+
+    # Another process, which doesn't use the journal, replaces the index and
+    # removes the old journal.
+    page = core.load_prc_file_data("", "model-cache-journal false")
+    try:
+        other = core.BamCache()
+    finally:
+        core.unload_prc_file(page)
+    other.root = root
+    store(other, sources[1])
+    other.flush_index()
+
+    # The first cache must not append to a journal that nobody reads anymore.
+    store(cache, sources[2])
+    cache.flush_index()
+    for journal in (tmp_path / "cache").glob("index-*.log"):
+        assert journal.with_suffix(".boo").exists()
+
+    check = core.BamCache()
+    check.root = root
+    out = core.StringStream()
+    check.list_index(out)
+    for source in sources:
+        assert source.get_fullpath() in out.data.decode()
+
+
+def test_bamcache_data_not_mapped(tmp_path):
+    root = core.Filename.from_os_specific(str(tmp_path / "cache"))
+    source = tmp_path / "source.egg"
+    source.write_text("dummy")
+    source = core.Filename.from_os_specific(str(source))
+
+    vdata = core.GeomVertexData("test", core.GeomVertexFormat.get_v3(),
+                                core.Geom.UH_static)
+    vdata.set_num_rows(1000)
+    vertex = core.GeomVertexWriter(vdata, "vertex")
+    for i in range(1000):
+        vertex.set_data3(i, i * 0.5, -i)
+    geom = core.Geom(vdata)
+    geom.add_primitive(core.GeomPoints(core.Geom.UH_static))
+    node = core.GeomNode("test")
+    node.add_geom(geom)
+    expected = bytes(vdata.get_array(0).get_handle().get_data())
+
+    page = core.load_prc_file_data("", "bam-aligned-data true")
+    try:
+        cache = core.BamCache()
+        cache.root = root
+        record = cache.lookup(source, "bam")
+        record.add_dependent_file(source)
+        record.data = node
+        assert cache.store(record)
+
+        other = core.BamCache()
+        other.root = root
+        record = other.lookup(source, "bam")
+        assert record.has_data()
+        loaded = record.data
+    finally:
+        core.unload_prc_file(page)
+
+    # The cache file may be rewritten or cleaned out while the data loaded
+    # from it is still in use, so the data must not be mapped from it.
+    for path in (tmp_path / "cache").glob("*.bam"):
+        with open(str(path), "wb"):
+            pass
+
+    array = loaded.get_geom(0).get_vertex_data().get_array(0)
+    assert bytes(array.get_handle().get_data()) == expected